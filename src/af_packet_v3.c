@@ -47,6 +47,7 @@
 #include "rnd_pkt_drop.h"
 #include "output.h"
 #include "pkt_processing.h"
+#include "metrics.h"
 
 /*
  * The thread_storage, stats_tracking, and ring_limits structs are
@@ -110,6 +111,7 @@ struct thread_storage {
     pthread_mutex_t *t_start_m; /* The clean start mutex */
     int force_stall;            /* Force thread to stall (unused but available for debugging) */
     int stall_cnt;              /* Counter for stalled thread detection */
+    struct capture_thread_metrics *metrics; /* Counters for the metrics endpoint, or NULL */
 };
 
 
@@ -164,12 +166,20 @@ void af_packet_stats(int sockfd, struct stats_tracking *statst) {
 
 void process_all_packets_in_block(struct tpacket_block_desc *block_hdr,
                                   struct stats_tracking *statst,
+                                  struct capture_thread_metrics *metrics,
                                   struct pkt_proc *pkt_processor) {
     int num_pkts = block_hdr->hdr.bh1.num_pkts, i;
     unsigned long byte_count = 0;
     struct tpacket3_hdr *pkt_hdr;
     //struct timespec ts;
-    struct packet_info pi;
+
+    /* Packets are handed to the packet processor in batches, so that
+     * it can prefetch flow state for the whole batch before doing the
+     * protocol processing for each packet
+     */
+    struct packet_info pi[pkt_proc::max_batch_size];
+    uint8_t *eth[pkt_proc::max_batch_size];
+    size_t batch_size = 0;
 
     pkt_hdr = (struct tpacket3_hdr *) ((uint8_t *) block_hdr + block_hdr->hdr.bh1.offset_to_first_pkt);
     for (i = 0; i < num_pkts; ++i) {
@@ -182,23 +192,34 @@ void process_all_packets_in_block(struct tpacket_block_desc *block_hdr,
         byte_count += pkt_hdr->tp_snaplen;
 
         /* Grab the times */
-        pi.ts.tv_sec = pkt_hdr->tp_sec;
-        pi.ts.tv_nsec = pkt_hdr->tp_nsec;
+        pi[batch_size].ts.tv_sec = pkt_hdr->tp_sec;
+        pi[batch_size].ts.tv_nsec = pkt_hdr->tp_nsec;
 
-        pi.caplen = pkt_hdr->tp_snaplen;
-        pi.len = pkt_hdr->tp_snaplen;
+        pi[batch_size].caplen = pkt_hdr->tp_snaplen;
+        pi[batch_size].len = pkt_hdr->tp_snaplen;
 
-        uint8_t *eth = (uint8_t *)pkt_hdr + pkt_hdr->tp_mac;
-        pkt_processor->apply(&pi, eth);
+        eth[batch_size] = (uint8_t *)pkt_hdr + pkt_hdr->tp_mac;
+        if (++batch_size == pkt_proc::max_batch_size) {
+            pkt_processor->apply_batch(pi, eth, batch_size);
+            batch_size = 0;
+        }
 
         pkt_hdr = (struct tpacket3_hdr *) ((uint8_t *)pkt_hdr + pkt_hdr->tp_next_offset);
     }
+    if (batch_size > 0) {
+        pkt_processor->apply_batch(pi, eth, batch_size);
+    }
 
     /* Atomic operations
      * https://gcc.gnu.org/onlinedocs/gcc-4.1.0/gcc/Atomic-Builtins.html
      */
     __sync_add_and_fetch(&(statst->received_packets), num_pkts);
     __sync_add_and_fetch(&(statst->received_bytes), byte_count);
+
+    if (metrics != NULL) {
+        capture_thread_metrics::add(metrics->packets, num_pkts);
+        capture_thread_metrics::add(metrics->bytes, byte_count);
+    }
 }
 
 void check_socket_drops(int duration, uint64_t sdps, uint64_t sfps, int *socket_drops, int *zero_drops) {
@@ -308,6 +329,13 @@ void *stats_thread_func(void *statst_arg) {
             statst->socket_drops += per_tsock_stats[thread].socket_drops;
             statst->socket_freezes += per_tsock_stats[thread].socket_freezes;
 
+            struct capture_thread_metrics *metrics = statst->tstor[thread].metrics;
+            if (metrics != NULL) {
+                capture_thread_metrics::add(metrics->socket_packets, per_tsock_stats[thread].socket_packets);
+                capture_thread_metrics::add(metrics->socket_drops, per_tsock_stats[thread].socket_drops);
+                capture_thread_metrics::add(metrics->socket_freezes, per_tsock_stats[thread].socket_freezes);
+            }
+
             /* Track the worst block streak fraction */
             double bstreak_frac = ((double)(statst->tstor[thread].longest_bstreak) / (double)(statst->tstor[thread].ring_params.tp_block_nr));
             if (bstreak_frac > worst_bstreak_frac) {
@@ -599,6 +627,7 @@ int af_packet_rx_ring_fanout_capture(struct thread_storage *thread_stor) {
     struct tpacket_block_desc **block_header = thread_stor->block_header;
     struct stats_tracking *statst = thread_stor->statst;
     struct pkt_proc *pkt_processor = thread_stor->pkt_processor;
+    struct capture_thread_metrics *metrics = thread_stor->metrics;
 
     /* We got the clean start all clear so we can get started but
      * while we were waiting our socket was filling up with packets
@@ -804,7 +833,7 @@ int af_packet_rx_ring_fanout_capture(struct thread_storage *thread_stor) {
             bstreak++; /* We've gotten another block */
 
             /* We found data, process it! */
-            process_all_packets_in_block(block_header[cb], statst, pkt_processor);
+            process_all_packets_in_block(block_header[cb], statst, metrics, pkt_processor);
 
             /* Reset our accounting */
             pstreak = 0; /* Reset the poll streak tracking */
@@ -844,7 +873,8 @@ void *packet_capture_thread_func(void *arg)  {
 enum status bind_and_dispatch(struct mercury_config *cfg,
                               mercury_context mc,
                               struct output_file *out_ctx,
-                              struct cap_stats *cstats) {
+                              struct cap_stats *cstats,
+                              struct capture_metrics *metrics) {
 
      /* sanity check memory fractions */
     if (cfg->buffer_fraction < 0.0 || cfg->buffer_fraction > 1.0 ) {
@@ -959,6 +989,7 @@ enum status bind_and_dispatch(struct mercury_config *cfg,
         tstor[thread].longest_bstreak = 0;
         tstor[thread].force_stall = 0;
         tstor[thread].stall_cnt = 0;
+        tstor[thread].metrics = metrics ? metrics->get(thread) : NULL;
 
         err = pthread_attr_init(&(tstor[thread].thread_attributes));
         if (err) {
@@ -1061,6 +1092,7 @@ enum status bind_and_dispatch(struct mercury_config *cfg,
         free(tstor[thread].block_header);
         munmap(tstor[thread].mapped_buffer, tstor[thread].ring_params.tp_block_size * tstor[thread].ring_params.tp_block_nr);
         close(tstor[thread].sockfd);
+        tstor[thread].pkt_processor->finalize();
         delete tstor[thread].pkt_processor;
     }
     free(tstor);
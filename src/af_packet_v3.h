@@ -13,12 +13,14 @@
 #include "mercury.h"
 #include "output.h"
 
+struct capture_metrics;  /* defined in metrics.h */
 
 
 enum status bind_and_dispatch(struct mercury_config *cfg,
                               mercury_context mc,
                               struct output_file *out_ctx,
-                              struct cap_stats *cstats);
+                              struct cap_stats *cstats,
+                              struct capture_metrics *metrics);
 
 struct thread_stall {
     int used;          /* To mark the end of the array when searching */
@@ -0,0 +1,221 @@
+// batch_bench.cc
+//
+// benchmark for mercury_packet_processor_write_json_batch(): processes
+// the packets in one or more Ethernet capture files with one packet
+// processor that handles each packet with
+// mercury_packet_processor_write_json() and another that handles
+// batches of packets with mercury_packet_processor_write_json_batch(),
+// checks that they write identical JSON records, and reports the time
+// taken per packet by each of them.  The packets are copied into
+// memory before timing starts, --copies times over, so that the
+// packet data does not fit into cache, as it would not in a capture
+// ring; each pass uses fresh timestamps, so that flows are not
+// treated as duplicates of those in a previous pass.
+//
+// usage: batch_bench [--iterations n] [--copies n] [--batch n] [--select protocols] pcap_file...
+//
+// e.g. batch_bench --copies 64 ../test/data/top-https.mcap
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "pcap.h"
+#include "libmerc/libmerc.h"
+#include "libmerc/pkt_proc.h"
+
+// next_timestamp() advances ts by one microsecond
+//
+static void next_timestamp(struct timespec &ts) {
+    ts.tv_nsec += 1000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t iterations = 5;
+    size_t copies = 64;
+    size_t batch_size = 64;
+    std::string select = "all";
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--copies") == 0 && i + 1 < argc) {
+            copies = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_size = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--select") == 0 && i + 1 < argc) {
+            select = argv[++i];
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty() || iterations == 0 || copies == 0 || batch_size == 0) {
+        fprintf(stderr, "usage: %s [--iterations n] [--copies n] [--batch n] [--select protocols] pcap_file...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // read the packets into a single buffer, with each packet
+    // starting on a cache line
+    //
+    std::vector<std::pair<size_t, size_t>> extents;   // offset and length of each packet
+    std::vector<uint8_t> data;
+    try {
+        for (size_t c = 0; c < copies; c++) {
+            for (const char *f : files) {
+                pcap::file_reader pcap{f};
+                while (true) {
+                    std::pair<const uint8_t *, const uint8_t *> pkt = pcap.read_packet();
+                    if (pkt.first == nullptr) {
+                        break;
+                    }
+                    size_t length = pkt.second - pkt.first;
+                    extents.push_back({data.size(), length});
+                    data.insert(data.end(), pkt.first, pkt.second);
+                    data.resize((data.size() + 63) & ~(size_t)63);
+                }
+            }
+        }
+    }
+    catch (std::exception &e) {
+        fprintf(stderr, "error: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    size_t num_packets = extents.size();
+    std::vector<uint8_t *> packets(num_packets);
+    std::vector<size_t> lengths(num_packets);
+    for (size_t i = 0; i < num_packets; i++) {
+        packets[i] = data.data() + extents[i].first;
+        lengths[i] = extents[i].second;
+    }
+
+    libmerc_config config;
+    config.packet_filter_cfg = (char *)select.c_str();
+
+    // each processor has its own context, so that they see the same
+    // flow state
+    //
+    mercury_context single_mc = mercury_init(&config, 0);
+    mercury_context batch_mc = mercury_init(&config, 0);
+    if (single_mc == nullptr || batch_mc == nullptr) {
+        fprintf(stderr, "error: mercury_init() failed\n");
+        return EXIT_FAILURE;
+    }
+    mercury_packet_processor single = mercury_packet_processor_construct(single_mc);
+    mercury_packet_processor batch = mercury_packet_processor_construct(batch_mc);
+    if (single == nullptr || batch == nullptr) {
+        fprintf(stderr, "error: mercury_packet_processor_construct() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    constexpr size_t max_record_size = 65536;
+    std::vector<uint8_t> buffer(max_record_size);
+    std::vector<uint8_t> arena(batch_size * max_record_size);
+    std::vector<struct timespec> ts(num_packets);
+    std::vector<size_t> offsets(batch_size), record_lengths(batch_size);
+
+    // pass() processes all of the packets with the processor, either
+    // one at a time or in batches, and returns the number of records
+    //
+    struct timespec time{1634846862, 105263000};
+    auto pass = [&](mercury_packet_processor mpp, bool batched) {
+        size_t records = 0;
+        for (auto &t : ts) {
+            next_timestamp(time);
+            t = time;
+        }
+        if (!batched) {
+            for (size_t i = 0; i < num_packets; i++) {
+                if (mercury_packet_processor_write_json(mpp, buffer.data(), buffer.size(), packets[i], lengths[i], &ts[i]) != 0) {
+                    records++;
+                }
+            }
+            return records;
+        }
+        for (size_t i = 0; i < num_packets; ) {
+            size_t n = num_packets - i < batch_size ? num_packets - i : batch_size;
+            size_t processed = mercury_packet_processor_write_json_batch(mpp, arena.data(), arena.size(), max_record_size,
+                                                                         &packets[i], &lengths[i], &ts[i], nullptr, n,
+                                                                         offsets.data(), record_lengths.data());
+            if (processed == 0) {
+                break;
+            }
+            for (size_t j = 0; j < processed; j++) {
+                if (record_lengths[j] != 0) {
+                    records++;
+                }
+            }
+            i += processed;
+        }
+        return records;
+    };
+
+    // check that both processors write the same records, using the
+    // first copy of the packets
+    //
+    size_t check_packets = num_packets / copies;
+    size_t records = 0;
+    size_t mismatches = 0;
+    std::vector<struct timespec> batch_ts(batch_size);
+    for (size_t i = 0; i < check_packets; ) {
+        size_t n = check_packets - i < batch_size ? check_packets - i : batch_size;
+        for (size_t j = 0; j < n; j++) {
+            next_timestamp(time);
+            batch_ts[j] = time;
+        }
+        size_t processed = mercury_packet_processor_write_json_batch(batch, arena.data(), arena.size(), max_record_size,
+                                                                     &packets[i], &lengths[i], batch_ts.data(), nullptr, n,
+                                                                     offsets.data(), record_lengths.data());
+        for (size_t j = 0; j < processed; j++) {
+            struct timespec single_ts = batch_ts[j];
+            size_t length = mercury_packet_processor_write_json(single, buffer.data(), buffer.size(), packets[i + j], lengths[i + j], &single_ts);
+            if (length != record_lengths[j] || memcmp(buffer.data(), arena.data() + offsets[j], length) != 0) {
+                mismatches++;
+            }
+            if (length != 0) {
+                records++;
+            }
+        }
+        if (processed == 0) {
+            break;
+        }
+        i += processed;
+    }
+
+    // time each processor in turn
+    //
+    auto ns_per_packet = [&](mercury_packet_processor mpp, bool batched) {
+        time.tv_sec += 3600;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            pass(mpp, batched);
+            time.tv_sec += 3600;
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / (num_packets * iterations);
+    };
+    double single_ns = ns_per_packet(single, false);
+    double batch_ns = ns_per_packet(batch, true);
+
+    fprintf(stdout, "selected protocols:       %s\n", select.c_str());
+    fprintf(stdout, "packets:                  %zu\n", num_packets);
+    fprintf(stdout, "packet data bytes:        %zu\n", data.size());
+    fprintf(stdout, "batch size:               %zu\n", batch_size);
+    fprintf(stdout, "records:                  %zu\n", records);
+    fprintf(stdout, "mismatched records:       %zu\n", mismatches);
+    fprintf(stdout, "single ns per packet:     %.1f\n", single_ns);
+    fprintf(stdout, "batch ns per packet:      %.1f\n", batch_ns);
+
+    mercury_packet_processor_destruct(single);
+    mercury_packet_processor_destruct(batch);
+    mercury_finalize(single_mc);
+    mercury_finalize(batch_mc);
+
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -18,6 +18,10 @@
 #include <limits.h>
 #include <ctype.h>
 #include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <gmp.h>
 #include <gmpxx.h>
@@ -28,6 +32,14 @@
 #include <vector>
 #include <thread>
 #include <utility>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <unordered_set>
 
 #include "pkcs8.hpp"
 #include "libmerc/bigint.hpp"
@@ -57,14 +69,6 @@ struct prodtree {
     struct numlist **level;
 };
 
-struct list_worker_thread {
-    struct numlist *d, *s;      /* For the multiplication worker */
-    struct numlist *X, *R, *nR; /* For the square/mod worker */
-    struct numlist *G, *N;      /* For the divgcd worker */
-    int tnum;
-    int num_threads;
-};
-
 
 size_t intlog2(size_t num) {
 
@@ -218,214 +222,280 @@ void listmul(struct numlist *d, struct numlist *s) {
 }
 
 
-void * listmul_worker(void *lwtarg) {
+/* work_stealing_pool runs parallel loops on a fixed set of threads.
+ * Each thread has its own deque of tasks, and pushes and pops tasks
+ * at its back; a thread whose deque is empty steals from the front
+ * of another thread's deque, where the largest tasks are.  A loop is
+ * split in half recursively, so a thief takes half of what remains
+ * of a loop, and the iterations of a level of the product or
+ * remainder tree are balanced across the threads however uneven
+ * their costs are.  A thread that starts a loop, including a loop
+ * nested inside of a task, runs tasks until the loop is done, so
+ * nested loops do not deadlock.
+ */
+class work_stealing_pool {
+    struct task {
+        const std::function<void(size_t, size_t)> *body;
+        size_t begin;
+        size_t end;
+        size_t grain;
+        std::atomic<size_t> *remaining;
+    };
 
-    struct list_worker_thread *lwt = (struct list_worker_thread *)lwtarg;
+    struct task_deque {
+        std::mutex m;
+        std::deque<task> tasks;
+    };
 
-    for (size_t i = lwt->tnum; i < (lwt->d->len - 1); i += lwt->num_threads) {
-        mpz_mul(lwt->d->num[i], lwt->s->num[i * 2], lwt->s->num[(i * 2) + 1]);
-    }
+    std::vector<task_deque> deques;   /* one per worker, and one for other threads */
+    std::vector<std::thread> workers;
+    std::mutex idle_mutex;
+    std::condition_variable idle;
+    std::atomic<size_t> queued{0};
+    bool stop = false;
 
-    return NULL;
-}
+    static inline thread_local size_t self = SIZE_MAX;
 
+    size_t own_deque() const {
+        return self < workers.size() ? self : workers.size();
+    }
 
-void threaded_listmul(struct numlist *d, struct numlist *s, int num_threads) {
-    assert(d != NULL);
-    assert(d->num != NULL);
-    assert(s != NULL);
-    assert(s->num != NULL);
-    assert(d->len > 0);
-    assert(num_threads > 0);
-
-    pthread_t *thread_ids = (pthread_t *)calloc(sizeof(pthread_t), num_threads);
-    assert(thread_ids != NULL);
-    pthread_attr_t *thread_attrs = (pthread_attr_t *)calloc(sizeof(pthread_attr_t), num_threads);
-    assert(thread_attrs != NULL);
-    struct list_worker_thread *lwts = (struct list_worker_thread *)calloc(sizeof(struct list_worker_thread), num_threads);
-    assert(lwts != NULL);
-
-    int err;
-    for (int t = 0; t < num_threads; t++) {
-        err = pthread_attr_init(&(thread_attrs[t]));
-        if (err) {
-            fprintf(stderr, "%s: error initializing attributes for thread %d\n", strerror(err), t);
-            exit(255);
-        } else {
-            /*fprintf(stderr, "Creating multiplication worker thread %d\n", t);*/
+    void push(size_t d, const task &t) {
+        {
+            std::lock_guard<std::mutex> lock{deques[d].m};
+            deques[d].tasks.push_back(t);
         }
+        queued++;
+        idle.notify_one();
+    }
 
-        lwts[t].d = d;
-        lwts[t].s = s;
-        lwts[t].tnum = t;
-        lwts[t].num_threads = num_threads;
-
-        err = pthread_create(&(thread_ids[t]), &(thread_attrs[t]), listmul_worker, &(lwts[t]));
-        if (err) {
-            fprintf(stderr, "%s: error initializing mulworker thread %d\n", strerror(err), t);
-            exit(255);
+    /* run() splits off the upper halves of t until it is no larger
+     * than its grain, leaving them for this or other threads, and
+     * then runs the rest
+     */
+    void run(size_t d, task t) {
+        while (t.end - t.begin > t.grain) {
+            size_t mid = t.begin + (t.end - t.begin) / 2;
+            push(d, task{t.body, mid, t.end, t.grain, t.remaining});
+            t.end = mid;
         }
+        (*t.body)(t.begin, t.end);
+        *t.remaining -= t.end - t.begin;
     }
 
-
-    /* Either copy or mul the last single / pair */
-    if ((s->len & 1) == 0) {
-        /* even source len so mul */
-        mpz_mul(d->num[d->len - 1], s->num[s->len - 1], s->num[s->len - 2]);
-    } else {
-        /* odd source len so copy */
-        mpz_set(d->num[d->len - 1], s->num[s->len - 1]);
+    bool try_run_one(size_t d) {
+        task t{};
+        bool found = false;
+        for (size_t i = 0; i < deques.size() && !found; i++) {
+            task_deque &victim = deques[(d + i) % deques.size()];
+            std::lock_guard<std::mutex> lock{victim.m};
+            if (!victim.tasks.empty()) {
+                if (i == 0) {
+                    t = victim.tasks.back();
+                    victim.tasks.pop_back();
+                } else {
+                    t = victim.tasks.front();
+                    victim.tasks.pop_front();
+                }
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+        queued--;
+        run(d, t);
+        return true;
     }
 
-    for (int t = 0; t < num_threads; t++) {
-        pthread_join(thread_ids[t], NULL);
-        if (err) {
-            fprintf(stderr, "%s: error joining mulworker thread %d\n", strerror(err), t);
-            exit(255);
+    void worker(size_t i) {
+        self = i;
+        while (true) {
+            if (try_run_one(i)) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock{idle_mutex};
+            if (stop) {
+                return;
+            }
+            idle.wait_for(lock, std::chrono::milliseconds(10), [this]() { return stop || queued > 0; });
         }
     }
 
-    free(thread_ids);
-    free(thread_attrs);
-    free(lwts);
-}
-
+public:
 
-void * listsqmod_worker(void *lwtarg) {
+    work_stealing_pool(size_t num_threads) : deques(num_threads + 1) {
+        for (size_t i = 0; i < num_threads; i++) {
+            workers.emplace_back(&work_stealing_pool::worker, this, i);
+        }
+    }
 
-    struct list_worker_thread *lwt = (struct list_worker_thread *)lwtarg;
+    ~work_stealing_pool() {
+        {
+            std::lock_guard<std::mutex> lock{idle_mutex};
+            stop = true;
+        }
+        idle.notify_all();
+        for (auto &w : workers) {
+            w.join();
+        }
+    }
 
-    mpz_t sq;
-    mpz_init(sq);
-    for (size_t i = lwt->tnum; i < lwt->X->len; i += lwt->num_threads) {
-        mpz_mul(sq, lwt->X->num[i], lwt->X->num[i]);
-        mpz_mod(lwt->nR->num[i], lwt->R->num[i / 2], sq);
+    /* parallel_for() calls body(begin, end) on subranges of [0, n)
+     * of at least grain iterations (except for the last), and
+     * returns when all of them have been processed
+     */
+    void parallel_for(size_t n, size_t grain, const std::function<void(size_t, size_t)> &body) {
+        if (n == 0) {
+            return;
+        }
+        std::atomic<size_t> remaining{n};
+        size_t d = own_deque();
+        run(d, task{&body, 0, n, std::max(grain, (size_t)1), &remaining});
+        while (remaining > 0) {
+            if (!try_run_one(d)) {
+                std::this_thread::yield();
+            }
+        }
     }
-    mpz_clear(sq);
+};
+
 
-    return NULL;
+work_stealing_pool &pool() {
+    static work_stealing_pool p{(size_t)NTHREADS};
+    return p;
 }
 
 
-void threaded_listsqmod(struct numlist *X, struct numlist *R, struct numlist *nR, int num_threads) {
-    assert(X != NULL);
-    assert(X->num != NULL);
-    assert(R != NULL);
-    assert(R->num != NULL);
-    assert(nR != NULL);
-    assert(nR->num != NULL);
-    assert(num_threads > 0);
-
-    pthread_t *thread_ids = (pthread_t *)calloc(sizeof(pthread_t), num_threads);
-    assert(thread_ids != NULL);
-    pthread_attr_t *thread_attrs = (pthread_attr_t *)calloc(sizeof(pthread_attr_t), num_threads);
-    assert(thread_attrs != NULL);
-    struct list_worker_thread *lwts = (struct list_worker_thread *)calloc(sizeof(struct list_worker_thread), num_threads);
-    assert(lwts != NULL);
-
-    int err;
-    for (int t = 0; t < num_threads; t++) {
-        err = pthread_attr_init(&(thread_attrs[t]));
-        if (err) {
-            fprintf(stderr, "%s: error initializing attributes for sqmod thread %d\n", strerror(err), t);
-            exit(255);
-        } else {
-            /*fprintf(stderr, "Creating multiplication worker thread %d\n", t);*/
-        }
+/* Products whose smaller operand has at least this many limbs are
+ * split into pieces that are multiplied in parallel, so that the
+ * few, very large products at the top of the trees keep all of the
+ * threads busy.
+ */
+static const size_t SPLIT_LIMBS = 1 << 14;
 
-        lwts[t].X = X;
-        lwts[t].R = R;
-        lwts[t].nR = nR;
-        lwts[t].tnum = t;
-        lwts[t].num_threads = num_threads;
 
-        err = pthread_create(&(thread_ids[t]), &(thread_attrs[t]), listsqmod_worker, &(lwts[t]));
-        if (err) {
-            fprintf(stderr, "%s: error initializing sqmodworker thread %d\n", strerror(err), t);
-            exit(255);
-        }
+/* parallel_mul() sets r to a * b; r must not be a or b.  If the
+ * operands are large, the larger of them is split into pieces of
+ * limbs, the pieces are multiplied by the other operand in parallel,
+ * and the partial products are added at their offsets.
+ */
+void parallel_mul(mpz_ptr r, mpz_srcptr a, mpz_srcptr b) {
+    assert(r != a && r != b);
+
+    if (mpz_size(a) > mpz_size(b)) {
+        std::swap(a, b);
+    }
+    size_t a_limbs = mpz_size(a);
+    size_t b_limbs = mpz_size(b);
+    size_t pieces = std::min(b_limbs / SPLIT_LIMBS, (size_t)NTHREADS * 2);
+    if (a_limbs < SPLIT_LIMBS || pieces < 2 || NTHREADS < 2) {
+        mpz_mul(r, a, b);
+        return;
+    }
+    size_t piece_limbs = (b_limbs + pieces - 1) / pieces;
+    pieces = (b_limbs + piece_limbs - 1) / piece_limbs;
+
+    /* mpz_mul() squares its operands if their limbs are at the same
+     * address, so when squaring, the first piece of b must not share
+     * its limbs with a */
+    mpz_class a_copy;
+    if (mpz_limbs_read(a) == mpz_limbs_read(b)) {
+        a_copy = mpz_class{a};
+        a = a_copy.get_mpz_t();
     }
 
-    for (int t = 0; t < num_threads; t++) {
-        pthread_join(thread_ids[t], NULL);
-        if (err) {
-            fprintf(stderr, "%s: error joining sqmodworker thread %d\n", strerror(err), t);
-            exit(255);
+    std::vector<mpz_class> partial(pieces);
+    pool().parallel_for(pieces, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            mpz_t piece;
+            size_t offset = i * piece_limbs;
+            mpz_roinit_n(piece, mpz_limbs_read(b) + offset, std::min(piece_limbs, b_limbs - offset));
+            mpz_mul(partial[i].get_mpz_t(), a, piece);
+        }
+    });
+
+    size_t r_limbs = a_limbs + b_limbs;
+    mp_limb_t *rp = mpz_limbs_write(r, r_limbs);
+    memset(rp, 0, r_limbs * sizeof(mp_limb_t));
+    for (size_t i = 0; i < pieces; i++) {
+        size_t offset = i * piece_limbs;
+        size_t p_limbs = mpz_size(partial[i].get_mpz_t());
+        if (p_limbs > 0) {
+            mp_limb_t carry = mpn_add(rp + offset, rp + offset, r_limbs - offset, mpz_limbs_read(partial[i].get_mpz_t()), p_limbs);
+            assert(carry == 0);
+            (void)carry;
         }
     }
+    mpz_limbs_finish(r, r_limbs);
+}
 
-    free(thread_ids);
-    free(thread_attrs);
-    free(lwts);
+
+/* sqmod() sets r to n mod x^2 */
+void sqmod(mpz_ptr r, mpz_srcptr n, mpz_srcptr x) {
+    mpz_class sq;
+    parallel_mul(sq.get_mpz_t(), x, x);
+    mpz_mod(r, n, sq.get_mpz_t());
 }
 
 
-void * listdivgcd_worker(void *lwtarg) {
+/* divgcd() sets g to gcd(r / n, n) */
+void divgcd(mpz_ptr g, mpz_srcptr r, mpz_srcptr n) {
+    mpz_class d;
+    mpz_divexact(d.get_mpz_t(), r, n);
+    mpz_gcd(g, d.get_mpz_t(), n);
+}
 
-    struct list_worker_thread *lwt = (struct list_worker_thread *)lwtarg;
 
-    mpz_t d;
-    mpz_init(d);
-    for (size_t i = lwt->tnum; i < lwt->G->len; i += lwt->num_threads) {
-        mpz_divexact(d, lwt->R->num[i], lwt->N->num[i]);
-        mpz_gcd(lwt->G->num[i], d, lwt->N->num[i]);
-    }
-    mpz_clear(d);
+void threaded_listmul(struct numlist *d, struct numlist *s) {
+    assert(d != NULL);
+    assert(d->num != NULL);
+    assert(s != NULL);
+    assert(s->num != NULL);
+    assert(d->len > 0);
+
+    pool().parallel_for(d->len, 16, [d, s](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (i * 2 + 1 < s->len) {
+                parallel_mul(d->num[i], s->num[i * 2], s->num[(i * 2) + 1]);
+            } else {
+                /* odd source len so copy */
+                mpz_set(d->num[i], s->num[i * 2]);
+            }
+        }
+    });
+}
+
+
+void threaded_listsqmod(struct numlist *X, struct numlist *R, struct numlist *nR) {
+    assert(X != NULL);
+    assert(X->num != NULL);
+    assert(R != NULL);
+    assert(R->num != NULL);
+    assert(nR != NULL);
+    assert(nR->num != NULL);
 
-    return NULL;
+    pool().parallel_for(X->len, 16, [X, R, nR](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            sqmod(nR->num[i], R->num[i / 2], X->num[i]);
+        }
+    });
 }
 
 
-void threaded_listdivgcd(struct numlist *G, struct numlist *R, struct numlist *N, int num_threads) {
+void threaded_listdivgcd(struct numlist *G, struct numlist *R, struct numlist *N) {
     assert(G != NULL);
     assert(G->num != NULL);
     assert(R != NULL);
     assert(R->num != NULL);
     assert(N != NULL);
     assert(N->num != NULL);
-    assert(num_threads > 0);
-
-    pthread_t *thread_ids = (pthread_t *)calloc(sizeof(pthread_t), num_threads);
-    assert(thread_ids != NULL);
-    pthread_attr_t *thread_attrs = (pthread_attr_t *)calloc(sizeof(pthread_attr_t), num_threads);
-    assert(thread_attrs != NULL);
-    struct list_worker_thread *lwts = (struct list_worker_thread *)calloc(sizeof(struct list_worker_thread), num_threads);
-    assert(lwts != NULL);
-
-    int err;
-    for (int t = 0; t < num_threads; t++) {
-        err = pthread_attr_init(&(thread_attrs[t]));
-        if (err) {
-            fprintf(stderr, "%s: error initializing attributes for divgcd thread %d\n", strerror(err), t);
-            exit(255);
-        } else {
-            /*fprintf(stderr, "Creating multiplication worker thread %d\n", t);*/
-        }
-
-        lwts[t].G = G;
-        lwts[t].R = R;
-        lwts[t].N = N;
-        lwts[t].tnum = t;
-        lwts[t].num_threads = num_threads;
-
-        err = pthread_create(&(thread_ids[t]), &(thread_attrs[t]), listdivgcd_worker, &(lwts[t]));
-        if (err) {
-            fprintf(stderr, "%s: error initializing divgcdworker thread %d\n", strerror(err), t);
-            exit(255);
-        }
-    }
 
-    for (int t = 0; t < num_threads; t++) {
-        pthread_join(thread_ids[t], NULL);
-        if (err) {
-            fprintf(stderr, "%s: error joining divgcdworker thread %d\n", strerror(err), t);
-            exit(255);
+    pool().parallel_for(G->len, 16, [G, R, N](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            divgcd(G->num[i], R->num[i], N->num[i]);
         }
-    }
-
-    free(thread_ids);
-    free(thread_attrs);
-    free(lwts);
+    });
 }
 
 
@@ -445,7 +515,7 @@ struct prodtree * producttree(struct numlist *nlist) {
     ptree->level[0] = nlist; /*copynumlist(nlist);*/
     for (size_t l = 1; l < ptree->height; l++) {
         ptree->level[l] = makenumlist((ptree->level[l - 1]->len + 1) / 2);
-        threaded_listmul(ptree->level[l], ptree->level[l - 1], NTHREADS);
+        threaded_listmul(ptree->level[l], ptree->level[l - 1]);
     }
 
     return ptree;
@@ -476,7 +546,7 @@ struct numlist * fast_batchgcd(struct numlist *nlist) {
         struct numlist *Xlist = ptree->level[ptree->height - up];
 
         newRlist = makenumlist(Xlist->len);
-        threaded_listsqmod(Xlist, Rlist, newRlist, NTHREADS);
+        threaded_listsqmod(Xlist, Rlist, newRlist);
 
         if (up != 2) {
             freenumlist(Rlist);
@@ -489,7 +559,7 @@ struct numlist * fast_batchgcd(struct numlist *nlist) {
     }
 
     struct numlist *gcdlist = makenumlist(nlist->len);
-    threaded_listdivgcd(gcdlist, Rlist, nlist, NTHREADS);
+    threaded_listdivgcd(gcdlist, Rlist, nlist);
 
     if (needfree == 1) {
         freenumlist(Rlist);
@@ -500,6 +570,446 @@ struct numlist * fast_batchgcd(struct numlist *nlist) {
 }
 
 
+/* Out-of-core batch GCD
+ *
+ * With --scratch-dir or --tree-dir, each level of the product tree,
+ * and each level of the remainder tree but the last, is written to a
+ * file of integers, which is mapped into memory to compute the next
+ * level.  The levels are computed in chunks of CHUNK_LIMBS limbs, so
+ * the RAM needed is that for a chunk and for the largest few
+ * integers at the top of the trees; the operating system pages the
+ * mapped levels in and out as needed.
+ *
+ * The product tree of a batch of moduli can be kept in a tree
+ * directory, with one subdirectory per batch.  When a new batch is
+ * added, its moduli are checked against each other and against the
+ * product P of the roots of the earlier batches, by starting its
+ * remainder tree with P * root mod root^2 rather than root; the
+ * moduli n of each earlier batch are checked against the new batch
+ * by descending the remainder tree of that batch, starting with
+ * root_new mod root, and computing gcd(root_new mod n, n).  The
+ * product trees of the earlier batches are not recomputed.
+ */
+
+static const size_t CHUNK_LIMBS = 1 << 24;   /* 128 MiB of 64-bit limbs */
+
+
+/* A file of integers has a header, the limbs of the integers, and a
+ * table of the offsets of the integers within those limbs:
+ *
+ *    char     magic[8]           "BGCDMPZ1"
+ *    uint64_t count              number of integers
+ *    uint64_t table              file offset of the offset table
+ *    limb     data[]             integers, least significant limb first
+ *    uint64_t offsets[count+1]   offsets (in limbs) into data
+ */
+static const char MPZ_FILE_MAGIC[8] = { 'B', 'G', 'C', 'D', 'M', 'P', 'Z', '1' };
+
+struct mpz_file_header {
+    char magic[8];
+    uint64_t count;
+    uint64_t table;
+};
+
+
+class mpz_file_writer {
+    FILE *f;
+    std::string path;
+    std::vector<uint64_t> offsets;
+
+public:
+
+    mpz_file_writer(const std::string &filename) : f{fopen(filename.c_str(), "w")}, path{filename}, offsets{0} {
+        if (f == nullptr) {
+            fprintf(stderr, "Aborting due to error opening file %s: %s\n", path.c_str(), strerror(errno));
+            exit(5);
+        }
+        mpz_file_header header{};
+        write(&header, sizeof(header));
+    }
+
+    void write(const void *data, size_t length) {
+        if (length > 0 && fwrite(data, length, 1, f) != 1) {
+            fprintf(stderr, "Aborting due to error writing file %s: %s\n", path.c_str(), strerror(errno));
+            exit(5);
+        }
+    }
+
+    void append(mpz_srcptr x) {
+        assert(mpz_sgn(x) >= 0);
+        write(mpz_limbs_read(x), mpz_size(x) * sizeof(mp_limb_t));
+        offsets.push_back(offsets.back() + mpz_size(x));
+    }
+
+    void close() {
+        mpz_file_header header;
+        memcpy(header.magic, MPZ_FILE_MAGIC, sizeof(header.magic));
+        header.count = offsets.size() - 1;
+        header.table = sizeof(header) + offsets.back() * sizeof(mp_limb_t);
+        write(offsets.data(), offsets.size() * sizeof(uint64_t));
+        if (fseek(f, 0, SEEK_SET) != 0) {
+            fprintf(stderr, "Aborting due to error writing file %s: %s\n", path.c_str(), strerror(errno));
+            exit(5);
+        }
+        write(&header, sizeof(header));
+        if (fclose(f) != 0) {
+            fprintf(stderr, "Aborting due to error writing file %s: %s\n", path.c_str(), strerror(errno));
+            exit(5);
+        }
+        f = nullptr;
+    }
+
+    ~mpz_file_writer() {
+        if (f) {
+            fclose(f);
+        }
+    }
+};
+
+
+/* mpz_file maps a file of integers into memory, and provides
+ * read-only mpz_t views of its integers, without copying them
+ */
+class mpz_file {
+    void *map = MAP_FAILED;
+    size_t map_length = 0;
+    const mp_limb_t *data = nullptr;
+    const uint64_t *offsets = nullptr;
+    size_t count = 0;
+
+public:
+
+    mpz_file(const std::string &filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            fprintf(stderr, "Aborting due to error opening file %s: %s\n", filename.c_str(), strerror(errno));
+            exit(5);
+        }
+        map_length = st.st_size;
+        if (map_length >= sizeof(mpz_file_header)) {
+            map = mmap(nullptr, map_length, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        const mpz_file_header *header = (const mpz_file_header *)map;
+        if (map == MAP_FAILED
+            || memcmp(header->magic, MPZ_FILE_MAGIC, sizeof(header->magic)) != 0
+            || header->table % sizeof(uint64_t) != 0
+            || header->count > (map_length - header->table) / sizeof(uint64_t) - 1) {
+            fprintf(stderr, "Aborting due to invalid file %s\n", filename.c_str());
+            exit(5);
+        }
+        madvise(map, map_length, MADV_SEQUENTIAL);
+        count = header->count;
+        data = (const mp_limb_t *)((const uint8_t *)map + sizeof(mpz_file_header));
+        offsets = (const uint64_t *)((const uint8_t *)map + header->table);
+    }
+
+    ~mpz_file() {
+        if (map != MAP_FAILED) {
+            munmap(map, map_length);
+        }
+    }
+
+    size_t size() const { return count; }
+
+    size_t limbs(size_t i) const { return offsets[i + 1] - offsets[i]; }
+
+    /* get() returns a read-only view of integer i, using tmp */
+    mpz_srcptr get(size_t i, mpz_ptr tmp) const {
+        return mpz_roinit_n(tmp, data + offsets[i], limbs(i));
+    }
+};
+
+
+std::string level_filename(const std::string &dir, size_t level) {
+    return dir + "/level-" + std::to_string(level) + ".mpz";
+}
+
+
+std::string remainder_filename(const std::string &dir, size_t level) {
+    return dir + "/remainder-" + std::to_string(level) + ".mpz";
+}
+
+
+std::string lines_filename(const std::string &dir) {
+    return dir + "/lines";
+}
+
+
+std::string batch_dirname(const std::string &tree_dir, size_t batch) {
+    return tree_dir + "/batch-" + std::to_string(batch);
+}
+
+
+/* for_each_chunk() calls process(begin, end) on consecutive ranges
+ * of [0, n), each of which has a total cost(i) of about CHUNK_LIMBS
+ */
+template <typename C, typename P>
+void for_each_chunk(size_t n, C cost, P process) {
+    size_t begin = 0;
+    size_t limbs = 0;
+    for (size_t i = 0; i < n; i++) {
+        limbs += cost(i);
+        if (limbs >= CHUNK_LIMBS || i + 1 == n) {
+            process(begin, i + 1);
+            begin = i + 1;
+            limbs = 0;
+        }
+    }
+}
+
+
+/* ooc_producttree() computes the product tree of the integers in
+ * level 0 of dir, writing each level to a file, and returns the
+ * height of the tree
+ */
+size_t ooc_producttree(const std::string &dir) {
+    for (size_t l = 0; ; l++) {
+        mpz_file x{level_filename(dir, l)};
+        if (x.size() <= 1) {
+            return l + 1;
+        }
+        size_t n = (x.size() + 1) / 2;
+        mpz_file_writer w{level_filename(dir, l + 1)};
+        auto cost = [&x](size_t i) {
+            return x.limbs(i * 2) + (i * 2 + 1 < x.size() ? x.limbs(i * 2 + 1) : 0);
+        };
+        for_each_chunk(n, cost, [&](size_t begin, size_t end) {
+            std::vector<mpz_class> products(end - begin);
+            pool().parallel_for(end - begin, 16, [&](size_t b, size_t e) {
+                for (size_t j = b; j < e; j++) {
+                    size_t i = begin + j;
+                    mpz_t tmp1, tmp2;
+                    if (i * 2 + 1 < x.size()) {
+                        parallel_mul(products[j].get_mpz_t(), x.get(i * 2, tmp1), x.get(i * 2 + 1, tmp2));
+                    } else {
+                        mpz_set(products[j].get_mpz_t(), x.get(i * 2, tmp1));
+                    }
+                }
+            });
+            for (const auto &p : products) {
+                w.append(p.get_mpz_t());
+            }
+        });
+        w.close();
+        fprintf(stderr, "product tree level " ANSI_YELLOW "%zu" ANSI_END ": %zu integers\n", l + 1, n);
+    }
+}
+
+
+size_t ooc_treeheight(const std::string &dir) {
+    for (size_t l = 0; ; l++) {
+        if (mpz_file{level_filename(dir, l)}.size() <= 1) {
+            return l + 1;
+        }
+    }
+}
+
+
+mpz_class ooc_root(const std::string &dir, size_t height) {
+    mpz_file root{level_filename(dir, height - 1)};
+    mpz_t tmp;
+    return root.size() ? mpz_class{root.get(0, tmp)} : mpz_class{1};
+}
+
+
+/* a modulus n, from a batch of a tree directory, with a nontrivial gcd */
+struct weak_modulus {
+    size_t batch;
+    size_t index;
+    mpz_class n;
+    mpz_class gcd;
+};
+
+
+/* ooc_remaindertree() descends the remainder tree of the product
+ * tree in dir, from the remainder top at its root.  If squared is
+ * true, each remainder is that of its parent modulo the square of
+ * its node, and the gcd of the modulus n at each leaf is
+ * gcd((remainder / n), n); otherwise, the remainders are taken
+ * modulo the nodes themselves, and the gcd is gcd(remainder, n).  The
+ * moduli with gcds other than one are appended to weak.
+ */
+void ooc_remaindertree(const std::string &dir, size_t height, const mpz_class &top, bool squared, size_t batch, std::vector<weak_modulus> &weak) {
+    {
+        mpz_file_writer w{remainder_filename(dir, height - 1)};
+        w.append(top.get_mpz_t());
+        w.close();
+    }
+    std::mutex weak_mutex;
+    for (size_t l = height; l-- > 0; ) {
+        mpz_file x{level_filename(dir, l)};
+        if (l == height - 1 && l > 0) {
+            continue;   // the remainder at the root is top
+        }
+        mpz_file r{remainder_filename(dir, l == height - 1 ? l : l + 1)};
+        size_t parent_shift = l == height - 1 ? 0 : 1;
+        auto cost = [&x](size_t i) { return x.limbs(i) * 3; };
+
+        if (l > 0) {
+            mpz_file_writer w{remainder_filename(dir, l)};
+            for_each_chunk(x.size(), cost, [&](size_t begin, size_t end) {
+                std::vector<mpz_class> remainders(end - begin);
+                pool().parallel_for(end - begin, 16, [&](size_t b, size_t e) {
+                    for (size_t j = b; j < e; j++) {
+                        mpz_t tmp1, tmp2;
+                        mpz_srcptr parent = r.get((begin + j) >> parent_shift, tmp1);
+                        mpz_srcptr node = x.get(begin + j, tmp2);
+                        if (squared) {
+                            sqmod(remainders[j].get_mpz_t(), parent, node);
+                        } else {
+                            mpz_mod(remainders[j].get_mpz_t(), parent, node);
+                        }
+                    }
+                });
+                for (const auto &rem : remainders) {
+                    w.append(rem.get_mpz_t());
+                }
+            });
+            w.close();
+        } else {
+            for_each_chunk(x.size(), cost, [&](size_t begin, size_t end) {
+                pool().parallel_for(end - begin, 16, [&](size_t b, size_t e) {
+                    for (size_t j = b; j < e; j++) {
+                        mpz_t tmp1, tmp2;
+                        mpz_srcptr parent = r.get((begin + j) >> parent_shift, tmp1);
+                        mpz_srcptr n = x.get(begin + j, tmp2);
+                        mpz_class rem, g;
+                        if (squared) {
+                            sqmod(rem.get_mpz_t(), parent, n);
+                            divgcd(g.get_mpz_t(), rem.get_mpz_t(), n);
+                        } else {
+                            mpz_mod(rem.get_mpz_t(), parent, n);
+                            mpz_gcd(g.get_mpz_t(), rem.get_mpz_t(), n);
+                        }
+                        if (g != 1) {
+                            std::lock_guard<std::mutex> lock{weak_mutex};
+                            weak.push_back({batch, begin + j, mpz_class{n}, g});
+                        }
+                    }
+                });
+            });
+        }
+        unlink(remainder_filename(dir, l == height - 1 ? l : l + 1).c_str());
+        fprintf(stderr, "remainder tree level " ANSI_YELLOW "%zu" ANSI_END ": %zu integers\n", l, x.size());
+    }
+}
+
+
+/* ooc_batchgcd() runs batch GCD on the moduli in level 0 of
+ * dir, which is batch number batch in tree_dir if that is not empty,
+ * and returns the moduli that share a factor with another, in this
+ * batch or in an earlier one
+ */
+std::vector<weak_modulus> ooc_batchgcd(const std::string &dir, const std::string &tree_dir, size_t batch) {
+    std::vector<weak_modulus> weak;
+
+    size_t height = ooc_producttree(dir);
+    mpz_class root = ooc_root(dir, height);
+
+    /* The product of the roots of the earlier batches */
+    std::vector<size_t> heights;
+    mpz_class previous = 1;
+    for (size_t j = 0; j < batch; j++) {
+        heights.push_back(ooc_treeheight(batch_dirname(tree_dir, j)));
+        mpz_class product;
+        parallel_mul(product.get_mpz_t(), previous.get_mpz_t(), ooc_root(batch_dirname(tree_dir, j), heights[j]).get_mpz_t());
+        previous.swap(product);
+    }
+
+    mpz_class top = root;
+    if (batch > 0) {
+        mpz_class rem = previous % root;
+        parallel_mul(top.get_mpz_t(), root.get_mpz_t(), rem.get_mpz_t());
+    }
+    ooc_remaindertree(dir, height, top, true, batch, weak);
+    previous = 0;
+
+    for (size_t j = 0; j < batch; j++) {
+        fprintf(stderr, "checking batch " ANSI_YELLOW "%zu" ANSI_END " against the new moduli\n", j);
+        std::string batch_dir = batch_dirname(tree_dir, j);
+        mpz_class batch_top = root % ooc_root(batch_dir, heights[j]);
+        ooc_remaindertree(batch_dir, heights[j], batch_top, false, j, weak);
+    }
+
+    std::sort(weak.begin(), weak.end(), [](const weak_modulus &a, const weak_modulus &b) {
+        return a.batch != b.batch ? a.batch > b.batch : a.index < b.index;
+    });
+    return weak;
+}
+
+
+/* write_lines() and read_line() write and read the original line
+ * numbers of the moduli in a batch
+ */
+void write_lines(const std::string &dir, const std::vector<size_t> &lines) {
+    FILE *f = fopen(lines_filename(dir).c_str(), "w");
+    if (f == nullptr
+        || (lines.size() && fwrite(lines.data(), sizeof(size_t), lines.size(), f) != lines.size())
+        || fclose(f) != 0) {
+        fprintf(stderr, "Aborting due to error writing file %s\n", lines_filename(dir).c_str());
+        exit(5);
+    }
+}
+
+
+size_t read_line(const std::string &dir, size_t index) {
+    size_t line = 0;
+    int fd = open(lines_filename(dir).c_str(), O_RDONLY);
+    if (fd < 0 || pread(fd, &line, sizeof(line), index * sizeof(line)) != sizeof(line)) {
+        fprintf(stderr, "Aborting due to error reading file %s\n", lines_filename(dir).c_str());
+        exit(5);
+    }
+    ::close(fd);
+    return line;
+}
+
+
+/* remove_batch() removes the files of a batch, and its directory */
+void remove_batch(const std::string &dir) {
+    for (size_t l = 0; unlink(level_filename(dir, l).c_str()) == 0; l++) {
+        ;
+    }
+    unlink(lines_filename(dir).c_str());
+    rmdir(dir.c_str());
+}
+
+
+/* mpz_digest is a 128-bit hash of an integer, which is used in place
+ * of the integer itself to find duplicate moduli, so that they need
+ * not be kept in memory
+ */
+struct mpz_digest {
+    uint64_t h[2];
+
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111eb;
+        x ^= x >> 31;
+        return x;
+    }
+
+    mpz_digest(mpz_srcptr x) : h{0x9e3779b97f4a7c15, mpz_size(x)} {
+        const mp_limb_t *limbs = mpz_limbs_read(x);
+        for (size_t i = 0; i < mpz_size(x); i++) {
+            h[0] = mix(h[0] ^ limbs[i]);
+            h[1] = mix(h[1] + limbs[i] + 0x632be59bd9b4e019);
+        }
+    }
+
+    bool operator==(const mpz_digest &rhs) const {
+        return h[0] == rhs.h[0] && h[1] == rhs.h[1];
+    }
+
+    struct hash {
+        size_t operator()(const mpz_digest &d) const { return d.h[0]; }
+    };
+};
+
+
 /* Note that for a small number of moduli needing additional factoring work
  * this quadratic algorithm is very efficient.
  * For large numbers though it becomes effectively impossible to finish.
@@ -969,6 +1479,8 @@ int main (int argc, char *argv[]) {
     class option_processor opt({
         { argument::required,   "--cert-file",        "read certificates from file <arg>" },
         { argument::none,       "--write-keys",       "write out private keys to PEM file" },
+        { argument::required,   "--scratch-dir",      "keep product and remainder trees in files in <arg>" },
+        { argument::required,   "--tree-dir",         "check moduli against earlier batches saved in <arg>" },
         { argument::none,       "--help",             "print this help message and exit" },
     });
 
@@ -984,6 +1496,14 @@ int main (int argc, char *argv[]) {
         "Alternatively, the options below can be used to read a file of PEM-encoded\n"
         "certificates instead of the raw moduli.\n\n"
 
+        "With --scratch-dir, the levels of the product and remainder trees are\n"
+        "written to files in a temporary directory in <dir>, which are mapped into\n"
+        "memory as needed, so that the number of moduli is not limited by RAM.\n"
+        "With --tree-dir, the product tree is kept in a new batch directory in\n"
+        "<dir>, and the moduli are checked against each other and against those\n"
+        "of all of the earlier batches in <dir>, without recomputing their trees.\n"
+        "Lines of earlier batches are reported as <batch>:<line>.\n\n"
+
         "Informational progress messages are written to stderr.\n\n"
 
         "OPTIONS:\n";
@@ -993,12 +1513,44 @@ int main (int argc, char *argv[]) {
     }
     auto [ have_cert_file, cert_file ] = opt.get_value("--cert-file");
     bool write_keys                    = opt.is_set("--write-keys");
+    auto [ have_scratch_dir, scratch_dir ] = opt.get_value("--scratch-dir");
+    auto [ have_tree_dir, tree_dir ]   = opt.get_value("--tree-dir");
     bool help                          = opt.is_set("--help");
     if (help) {
         opt.usage(stderr, argv[0], summary);
         return EXIT_SUCCESS;
     }
 
+    /* In out-of-core mode, the moduli are written to level 0 of the
+     * product tree in work_dir, rather than to nlist */
+    bool out_of_core = have_scratch_dir || have_tree_dir;
+    std::string work_dir;
+    size_t batch = 0;
+    if (have_tree_dir) {
+        if (mkdir(tree_dir.c_str(), 0777) != 0 && errno != EEXIST) {
+            fprintf(stderr, "Aborting due to error creating directory %s: %s\n", tree_dir.c_str(), strerror(errno));
+            exit(5);
+        }
+        while (access(lines_filename(batch_dirname(tree_dir, batch)).c_str(), F_OK) == 0) {
+            batch++;
+        }
+        work_dir = batch_dirname(tree_dir, batch);
+        if (mkdir(work_dir.c_str(), 0777) != 0 && errno != EEXIST) {
+            fprintf(stderr, "Aborting due to error creating directory %s: %s\n", work_dir.c_str(), strerror(errno));
+            exit(5);
+        }
+        fprintf(stderr, "adding batch " ANSI_YELLOW "%zu" ANSI_END " to %s\n", batch, tree_dir.c_str());
+    } else if (have_scratch_dir) {
+        std::string dir_template = scratch_dir + "/batch_gcd.XXXXXX";
+        if (mkdtemp(dir_template.data()) == nullptr) {
+            fprintf(stderr, "Aborting due to error creating directory in %s: %s\n", scratch_dir.c_str(), strerror(errno));
+            exit(5);
+        }
+        work_dir = dir_template;
+    }
+    mpz_file_writer *level0 = out_of_core ? new mpz_file_writer{level_filename(work_dir, 0)} : nullptr;
+    std::unordered_set<mpz_digest, mpz_digest::hash> digests_seen;
+
     /* Get ready to read a list of large integers */
     struct numlist *nlist = makenumlist(0);
     mpz_t mpz_temp;
@@ -1045,7 +1597,7 @@ int main (int argc, char *argv[]) {
     while (linereader->get_mpz(&mpz_temp)) {
         // Ignore this line if it duplicates a previous line.
         mpz_class n(mpz_temp);
-        if (line_first_seen.count(n) == 1) {
+        if (out_of_core ? digests_seen.count(mpz_digest{mpz_temp}) == 1 : line_first_seen.count(n) == 1) {
             // fprintf(stdout,
             //         "Duplicate ignored: line %zu = line %zu = ",
             //         linereader->get_linenum(), line_first_seen[n]);
@@ -1057,8 +1609,13 @@ int main (int argc, char *argv[]) {
             zeros_ignored++;
         } else {
             // Not a duplicate; add to the list for batch GCD
-            line_first_seen[n] = linereader->get_linenum();
-            push_numlist(nlist, mpz_temp);
+            if (out_of_core) {
+                digests_seen.insert(mpz_digest{mpz_temp});
+                level0->append(mpz_temp);
+            } else {
+                line_first_seen[n] = linereader->get_linenum();
+                push_numlist(nlist, mpz_temp);
+            }
             original_linenum.push_back(linereader->get_linenum());
             estimated_limbs += mpz_temp->_mp_size; /* limbs in product */
 
@@ -1087,6 +1644,11 @@ int main (int argc, char *argv[]) {
     // deallocate reader to minimize RAM usage
     //
     delete linereader;
+    if (out_of_core) {
+        level0->close();
+        delete level0;
+        digests_seen.clear();
+    }
 
     /* Abort if the product of all the inputs might exceed GMP's
        largest possible integer.
@@ -1111,7 +1673,7 @@ int main (int argc, char *argv[]) {
     }
 
     // Print all informational messages to stderr
-    fprintf(stderr, "running batch GCD on " ANSI_YELLOW "%zu" ANSI_END " moduli", nlist->len);
+    fprintf(stderr, "running batch GCD on " ANSI_YELLOW "%zu" ANSI_END " moduli", original_linenum.size());
     if (duplicates_ignored > 0) {
         fprintf(stderr, ", ignoring %zu duplicate line%s",
                 duplicates_ignored,
@@ -1125,8 +1687,44 @@ int main (int argc, char *argv[]) {
     fprintf(stderr, ".\n");
     fprintf(stderr, "Parallelization: %d threads\n", NTHREADS);
 
-    // Main computation: Batch GCD (Heninger, 2012)
-    struct numlist *gcdlist = fast_batchgcd(nlist);
+    // Main computation: Batch GCD (Heninger, 2012).  In out-of-core
+    // mode, nlist and gcdlist are set to the moduli whose gcds are
+    // not one, which is all that factor_coprimes() needs.
+    struct numlist *gcdlist = nullptr;
+    std::vector<weak_modulus> weak;
+    if (out_of_core) {
+        weak = ooc_batchgcd(work_dir, have_tree_dir ? tree_dir : "", batch);
+        gcdlist = makenumlist(0);
+        for (auto &w : weak) {
+            push_numlist(nlist, w.n.get_mpz_t());
+            push_numlist(gcdlist, w.gcd.get_mpz_t());
+            w.n = 0;
+            w.gcd = 0;
+        }
+        if (have_tree_dir) {
+            write_lines(work_dir, original_linenum);
+        } else {
+            remove_batch(work_dir);
+        }
+    } else {
+        gcdlist = fast_batchgcd(nlist);
+    }
+
+    // line_label() returns the line number of element i of nlist, or
+    // <batch>:<line> if it is from an earlier batch; current_line()
+    // returns its line number in this batch, or 0
+    auto current_line = [&](size_t i) -> size_t {
+        if (!out_of_core) {
+            return original_linenum[i];
+        }
+        return weak[i].batch == batch ? original_linenum[weak[i].index] : 0;
+    };
+    auto line_label = [&](size_t i) -> std::string {
+        if (current_line(i) != 0) {
+            return std::to_string(current_line(i));
+        }
+        return std::to_string(weak[i].batch) + ":" + std::to_string(read_line(batch_dirname(tree_dir, weak[i].batch), weak[i].index));
+    };
 
     // (Heninger, 2012) With batch GCD, if a modulus shares both of
     // its prime factors with two other distinct moduli, then the GCD
@@ -1139,10 +1737,10 @@ int main (int argc, char *argv[]) {
     // discovered.  Also, for each non-trivial factor, record the set
     // of lines sharing that factor.
     std::vector<size_t> weak_certs;
-    std::map<mpz_class,std::vector<size_t>> factor2lines;
+    std::map<mpz_class,std::vector<std::string>> factor2lines;
     for (size_t i = 0; i < nlist->len; i++) {
         if (mpz_cmp_ui(gcdlist->num[i], 1) != 0) {
-            size_t line = original_linenum[i];
+            std::string line = line_label(i);
 
             // Get the factors
             mpz_class n(nlist->num[i]);
@@ -1150,13 +1748,13 @@ int main (int argc, char *argv[]) {
             if (f1 == 0) {
                 // Record the factor/line relationship (this one is weird)
                 if (factor2lines.count(n) == 0) {
-                    factor2lines[n] = std::vector<size_t>();
+                    factor2lines[n] = std::vector<std::string>();
                 }
                 factor2lines[n].push_back(line);
                 // Output
                 gmp_fprintf(stdout,
-                     "Modulus on line %zu divides another modulus: %Zx\n",
-                     line, n.get_mpz_t());
+                     "Modulus on line %s divides another modulus: %Zx\n",
+                     line.c_str(), n.get_mpz_t());
                 continue;
             }
             mpz_class f2 = n / f1;
@@ -1167,12 +1765,12 @@ int main (int argc, char *argv[]) {
 
             // Record the factors/lines relationship
             if (factor2lines.count(f1) == 0) {
-                factor2lines[f1] = std::vector<size_t>();
+                factor2lines[f1] = std::vector<std::string>();
             }
             factor2lines[f1].push_back(line);
             if (f2 != f1) { // false only if modulus is a perfect square
                 if (factor2lines.count(f2) == 0) {
-                    factor2lines[f2] = std::vector<size_t>();
+                    factor2lines[f2] = std::vector<std::string>();
                 }
                 factor2lines[f2].push_back(line);
             }
@@ -1182,12 +1780,12 @@ int main (int argc, char *argv[]) {
                 // create a PKCS8 RSA Private Key file for the
                 // factored key
                 //
-                std::string rsapriv_filename = base_filename + "-line-" + std::to_string(original_linenum[i]) + ".rsapriv.pem";
+                std::string rsapriv_filename = base_filename + "-line-" + line + ".rsapriv.pem";
                 write_key(n, f1, f2, rsapriv_filename);
             } else {
                 // Output
-                fprintf(stdout, "Vulnerable modulus on line %zu: ",
-                        original_linenum[i]);
+                fprintf(stdout, "Vulnerable modulus on line %s: ",
+                        line.c_str());
                 gmp_fprintf(stdout, "%Zx", n.get_mpz_t());
                 fprintf(stdout, " has factors ");
                 gmp_fprintf(stdout, "%Zx", f1.get_mpz_t());
@@ -1199,7 +1797,9 @@ int main (int argc, char *argv[]) {
             // remember line number so that we can write out the
             // certificates corresponding to the private keys
             //
-            weak_certs.push_back(original_linenum[i]);
+            if (current_line(i) != 0) {
+                weak_certs.push_back(current_line(i));
+            }
         }
     }
 
@@ -1224,7 +1824,7 @@ int main (int argc, char *argv[]) {
         if (lines.size() > 1) {
             fprintf(stdout, first_factor ? "" : ";");
             for (size_t i = 0; i < lines.size(); i++) {
-                fprintf(stdout, "%s%zu", (i==0)?"":",", lines[i]);
+                fprintf(stdout, "%s%s", (i==0)?"":",", lines[i].c_str());
             }
             first_factor = false;
         }
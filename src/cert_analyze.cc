@@ -16,6 +16,16 @@
 #include <string>
 #include <list>
 #include <regex>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "libmerc/x509.h"
 #include "libmerc/base64.h"
@@ -71,6 +81,8 @@ struct der_file_reader : public file_reader {
             }
         }
     }
+    der_file_reader(FILE *f) : stream{f} { }
+
     ssize_t get_cert(uint8_t *outbuf, size_t outbuf_len) {
         if (done) {
             return 0;
@@ -116,6 +128,9 @@ struct json_file_reader : public file_reader {
             }
         }
     }
+
+    json_file_reader(FILE *f) : stream{f} { }
+
     ssize_t get_cert(uint8_t *outbuf, size_t outbuf_len) {
         line_number++;
         size_t len = 0;
@@ -187,6 +202,9 @@ struct base64_file_reader : public file_reader {
             }
         }
     }
+
+    base64_file_reader(FILE *f) : stream{f}, line{NULL} { }
+
     ssize_t get_cert(uint8_t *outbuf, size_t outbuf_len) {
         size_t len = 0;
         line_number++;
@@ -240,6 +258,9 @@ struct pem_file_reader : public file_reader {
             }
         }
     }
+
+    pem_file_reader(FILE *f) : stream{f}, line{NULL}, cert_number{0} { }
+
     ssize_t get_cert(uint8_t *outbuf, size_t outbuf_len) {
         size_t len = 0;
         ssize_t nread = 0;
@@ -377,7 +398,406 @@ struct base64_file_writer {
 }
 
 // std::unordered_map<std::string, std::string> cert_dict;
-//#include <thread>
+
+// class common_key_map finds distinct certificates that have
+// identical subject public keys, and writes each such set of
+// certificates into its own file, in base64 format.  The map is
+// sharded by the hash of the key, so that threads that process
+// certificates with different keys rarely wait for each other;
+// the shard lock is held while a file is written, so the
+// certificates for any one key are written by one thread at a time.
+//
+class common_key_map {
+    struct shard {
+        std::mutex m;
+        std::unordered_map<std::basic_string<uint8_t>, std::basic_string<uint8_t>> keys_to_certs;
+    };
+    std::vector<shard> shards;
+    const char *filename_prefix;
+
+public:
+
+    common_key_map(const char *prefix, size_t num_shards=64) : shards(num_shards), filename_prefix{prefix} { }
+
+    void add(const std::basic_string<uint8_t> &k, const uint8_t *cert_buf, size_t cert_len, FILE *out, bool verbose) {
+        size_t h = std::hash<std::basic_string<uint8_t>>{}(k);
+        shard &s = shards[(h >> 17) % shards.size()];
+        std::lock_guard<std::mutex> lock{s.m};
+
+        auto key_and_cert = s.keys_to_certs.find(k);
+        if (key_and_cert != s.keys_to_certs.end()) {
+            if (verbose) {
+                fprintf(out, "found duplicate for key ");
+                datum tmp{k.c_str(), k.c_str() + k.length()};
+                tmp.fprint_hex(out);
+                fputc('\n', out);
+            }
+
+            // open/create a file to write certs with key k into
+            //
+            std::string key_as_hex = hex_encode(k.c_str(), k.length());
+            std::string filename{filename_prefix};
+            filename += "-" + key_as_hex.substr(32, 48);
+            base64_file_writer b64writer{filename.c_str()};
+
+            // write certs to file
+            if (b64writer.is_empty()) {
+                // write first certificate with key k into file
+                if (b64writer.write_cert(key_and_cert->second.c_str(), key_and_cert->second.length()) < 0) {
+                    fprintf(stderr, "error: could not write original certificate to base64 output file\n");
+                }
+            }
+            if (b64writer.write_cert(cert_buf, cert_len) < 0) {
+                fprintf(stderr, "error: could not write certificate to base64 output file\n");
+            }
+
+        } else {
+            std::basic_string<uint8_t> tmp_cert{cert_buf, cert_len};
+            s.keys_to_certs.insert({k, tmp_cert});
+        }
+
+        // note: b64writer closes its file at the end of
+        // this scope, though the data in the file
+        // probably won't be written out to disk until
+        // immediately
+    }
+};
+
+// class cert_processor parses and writes out a certificate as
+// selected by the command line options.  Its process() member
+// function can be called by several threads at once, each with its
+// own output stream and buffer.
+//
+class cert_processor {
+public:
+    const char *filter = NULL;
+    const char *logfile = NULL;
+    bool prefix = false;
+    bool prefix_as_hex = false;
+    bool trunc_test = false;
+    bool pem_output = false;
+    bool sha1_output = false;
+    bool verbose = false;
+    const std::list<struct x509_cert> &trusted_certs;
+    struct dictionary *kg = NULL;
+    common_key_map *common_keys = NULL;
+    std::regex rgx;
+    std::atomic<unsigned int> log_index{0};
+
+    cert_processor(const std::list<struct x509_cert> &trusted) : trusted_certs{trusted} { }
+
+    void set_filter(const char *f) {
+        filter = f;
+        if (filter && strcmp(filter, "weak") != 0) {
+            rgx = std::regex{filter};
+        }
+    }
+
+    void process(FILE *out, const uint8_t *cert_buf, ssize_t cert_len, char *buffer, size_t buffer_len) {
+
+        // fprintf_raw_as_hex(stderr, cert_buf, cert_len);
+        // fprintf(stderr, "\n");
+
+        if (prefix || prefix_as_hex) {
+            // parse certificate prefix, then print as JSON
+            struct x509_cert_prefix p;
+            p.parse(cert_buf, cert_len);
+            if (prefix) {
+                p.print_as_json(out);
+            }
+            if (prefix_as_hex) {
+                p.print_as_json_hex(out);
+            }
+            // fprintf(stderr, "cert: %u\tprefix length: %zu\n", line_number, p.get_length());
+
+        } else if (sha1_output) {
+
+            fprint_sha1_hash(out, cert_buf, cert_len);
+
+        } else {
+
+            // parse certificate, then print as JSON
+            struct buffer_stream buf(buffer, buffer_len);
+            struct x509_cert c;
+            try {
+                if (trunc_test) {
+
+                    for (ssize_t trunc_len=0; trunc_len <= cert_len; trunc_len++) {
+                        fprintf(out, "{ \"trunc_len\": %zd }\n", trunc_len);
+                        buf = { buffer, buffer_len };
+                        struct x509_cert cc;
+                        cc.parse(cert_buf, trunc_len);
+                        cc.print_as_json(buf, trusted_certs, kg);
+                        buf.write_line(out);
+                    }
+
+                } else if (common_keys) {
+
+                    // detect distinct certificates that have identical keys
+                    c.parse(cert_buf, cert_len);
+                    if (c.is_valid()) {
+                        std::basic_string<uint8_t> k;
+                        c.get_subject_public_key(k);
+                        common_keys->add(k, cert_buf, cert_len, out, verbose);
+                    }
+
+                } else {
+
+                    char *search_start = (char *)cert_buf;
+                    char *search_end = search_start + cert_len;
+                    c.parse(cert_buf, cert_len);
+                    if ((filter == NULL)
+                        || (strcmp(filter, "weak") == 0 && (c.is_not_currently_valid()
+                                                           || c.subject_key_is_weak()
+                                                           || c.signature_is_weak()
+                                                           || c.is_nonconformant()
+                                                           || c.is_self_issued()
+                                                            || !c.is_trusted(trusted_certs)))
+                        || std::regex_search(search_start, search_end, rgx)) {
+
+                        if (pem_output) {
+                            bool success = write_pem(out, cert_buf, cert_len, "CERTIFICATE");
+                            if (!success) {
+                                throw std::runtime_error{"could not write PEM output"};
+                            }
+                        } else {
+                            c.print_as_json(buf, trusted_certs, kg);
+                            buf.write_line(out);
+                        }
+                    }
+
+                }
+            } catch (const char *s) {
+                fprintf(stderr, "caught exception: %s\n", s);
+                if (logfile) {
+                    std::string filename(logfile);
+                    filename.append(std::to_string(log_index++));
+                    filename.append(".der");
+                    der_file_writer der_file(filename.c_str());
+                    if (der_file.write_cert(cert_buf, cert_len) < 0) {
+                        fprintf(stderr, "error: could not write certificate %s to file\n", filename.c_str());
+                    }
+                    //c.print_as_json(buf);
+                }
+            }
+        }
+    }
+};
+
+enum class input_format { base64, pem, json, der };
+
+static struct file_reader *new_file_reader(input_format format, FILE *stream) {
+    switch (format) {
+    case input_format::pem:
+        return new pem_file_reader(stream);
+    case input_format::json:
+        return new json_file_reader(stream);
+    case input_format::der:
+        return new der_file_reader(stream);
+    default:
+        return new base64_file_reader(stream);
+    }
+}
+
+// class mapped_input provides the contents of the input file, or
+// of the standard input, as one read-only block of memory; a file is
+// mapped, and the standard input is read into a buffer
+//
+class mapped_input {
+    void *map = MAP_FAILED;
+    size_t map_length = 0;
+    std::vector<char> buffer;
+
+public:
+
+    mapped_input(const char *infile) {
+        if (infile == NULL) {
+            char tmp[64 * 1024];
+            size_t n;
+            while ((n = fread(tmp, 1, sizeof(tmp), stdin)) > 0) {
+                buffer.insert(buffer.end(), tmp, tmp + n);
+            }
+            return;
+        }
+        int fd = open(infile, O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            fprintf(stderr, "error: could not open file %s (%s)\n", infile, strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        map_length = st.st_size;
+        if (map_length > 0) {
+            map = mmap(NULL, map_length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                fprintf(stderr, "error: could not map file %s (%s)\n", infile, strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+            madvise(map, map_length, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+
+    ~mapped_input() {
+        if (map != MAP_FAILED) {
+            munmap(map, map_length);
+        }
+    }
+
+    const char *begin() const {
+        return map != MAP_FAILED ? (const char *)map : buffer.data();
+    }
+
+    const char *end() const {
+        return map != MAP_FAILED ? (const char *)map + map_length : buffer.data() + buffer.size();
+    }
+};
+
+// next_record() returns the location of the first record that
+// starts at or after p, or end if there is none.  Records are lines,
+// except in PEM format, where they start with an encapsulation
+// boundary line
+//
+static const char *next_record(input_format format, const char *begin, const char *p, const char *end) {
+    if (p <= begin) {
+        return begin;
+    }
+    if (format == input_format::der) {
+        return end;   // the input is a single certificate
+    }
+    while (p < end) {
+        const char *nl = (const char *)memchr(p - 1, '\n', end - (p - 1));
+        if (nl == NULL) {
+            return end;
+        }
+        p = nl + 1;
+        const char pem[] = "-----BEGIN";
+        if (format != input_format::pem || (size_t)(end - p) < sizeof(pem) - 1 || memcmp(p, pem, sizeof(pem) - 1) == 0) {
+            return p;
+        }
+        p++;
+    }
+    return end;
+}
+
+// process_in_parallel() splits the input into chunks at record
+// boundaries, and processes the chunks with num_threads threads, each
+// of which reads the certificates in its chunk with its own reader
+// and writes its output into a memory buffer.  The buffers are
+// written to the standard output in input order, or as soon as they
+// are complete if ordered is false.  As with a single thread, the
+// output ends with the chunk in which a reader reports an error.
+// Key groups, and the first certificate written for each common
+// key, follow the order in which the threads process certificates,
+// which need not be the input order.
+//
+static void process_in_parallel(cert_processor &proc, input_format format, const char *infile, unsigned int num_threads, bool ordered) {
+    mapped_input input{infile};
+
+    std::vector<std::pair<const char *, const char *>> chunks;
+    size_t chunk_size = std::max((size_t)(input.end() - input.begin()) / (num_threads * 16), (size_t)1 << 20);
+    for (const char *p = input.begin(); p < input.end(); ) {
+        const char *q = next_record(format, input.begin(), std::min(p + chunk_size, input.end()), input.end());
+        chunks.push_back({p, q});
+        p = q;
+    }
+
+    struct chunk_output {
+        char *data = NULL;
+        size_t length = 0;
+        bool done = false;
+        bool error = false;
+    };
+    std::vector<chunk_output> outputs(chunks.size());
+    std::deque<size_t> completed;
+    std::mutex m;
+    std::condition_variable cv;
+    size_t next_chunk = 0;
+    size_t num_written = 0;
+    bool stop = false;
+
+    // each thread stays at most max_pending chunks ahead of the
+    // output, which bounds the memory used by the output buffers
+    //
+    const size_t max_pending = num_threads * 4;
+
+    auto worker = [&]() {
+        std::vector<char> buffer(64*8192);
+        std::vector<uint8_t> cert_buf(256 * 1024);
+        while (true) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock{m};
+                cv.wait(lock, [&]() { return stop || next_chunk >= chunks.size() || next_chunk < num_written + max_pending; });
+                if (stop || next_chunk >= chunks.size()) {
+                    return;
+                }
+                i = next_chunk++;
+            }
+            chunk_output &o = outputs[i];
+            FILE *in = fmemopen((void *)chunks[i].first, chunks[i].second - chunks[i].first, "r");
+            FILE *out = open_memstream(&o.data, &o.length);
+            if (in == NULL || out == NULL) {
+                fprintf(stderr, "error: could not open memory stream (%s)\n", strerror(errno));
+                exit(EXIT_FAILURE);
+            }
+            struct file_reader *reader = new_file_reader(format, in);
+            ssize_t cert_len;
+            while ((cert_len = reader->get_cert(cert_buf.data(), cert_buf.size())) > 0) {
+                proc.process(out, cert_buf.data(), cert_len, buffer.data(), buffer.size());
+            }
+            delete reader;
+            fclose(out);
+            if (cert_len < 0) {
+                // the reader's line and certificate numbers are relative to the chunk
+                fprintf(stderr, "error: in the input chunk that starts at byte %zu\n", (size_t)(chunks[i].first - input.begin()));
+            }
+            {
+                std::lock_guard<std::mutex> lock{m};
+                o.error = cert_len < 0;
+                o.done = true;
+                completed.push_back(i);
+            }
+            cv.notify_all();
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back(worker);
+    }
+
+    // write out the chunks, in order if requested
+    //
+    size_t next_in_order = 0;
+    while (num_written < chunks.size() && !stop) {
+        chunk_output *o = NULL;
+        {
+            std::unique_lock<std::mutex> lock{m};
+            if (ordered) {
+                cv.wait(lock, [&]() { return outputs[next_in_order].done; });
+                o = &outputs[next_in_order++];
+            } else {
+                cv.wait(lock, [&]() { return !completed.empty(); });
+                o = &outputs[completed.front()];
+                completed.pop_front();
+            }
+        }
+        fwrite(o->data, 1, o->length, stdout);
+        free(o->data);
+        o->data = NULL;
+        {
+            std::lock_guard<std::mutex> lock{m};
+            num_written++;
+            stop = o->error;
+        }
+        cv.notify_all();
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    for (auto &o : outputs) {
+        free(o.data);
+    }
+}
 
 [[noreturn]] void usage(const char *progname) {
     const char *help_message =
@@ -400,6 +820,8 @@ struct base64_file_writer {
         "   --trunc-test     parse every possible truncation of certificates\n"
         "OTHER\n"
         "   --trust <roots>  trust certificates in <roots>\n"
+        "   --threads <n>    process certificates with <n> threads (0 = one per CPU)\n"
+        "   --unordered      with --threads, write output in completion order\n"
         "   --help           print this message\n";
 
     fprintf(stdout, help_message, progname);
@@ -422,6 +844,8 @@ int main(int argc, char *argv[]) {
     bool pem_output = false;
     bool sha1_output = false;
     bool verbose = false;    // this could be set by a command line option
+    unsigned int num_threads = 1;
+    bool unordered = false;
 
     // parse arguments
     while (1) {
@@ -442,6 +866,8 @@ int main(int argc, char *argv[]) {
              case_common_key,
              case_trunc_test,
              case_trust,
+             case_threads,
+             case_unordered,
              case_help,
         };
         static struct option long_options[] = {
@@ -459,6 +885,8 @@ int main(int argc, char *argv[]) {
              {"common-key",     required_argument, NULL,  case_common_key    },
              {"trunc-test",     no_argument,       NULL,  case_trunc_test    },
              {"trust",          required_argument, NULL,  case_trust         },
+             {"threads",        required_argument, NULL,  case_threads       },
+             {"unordered",      no_argument,       NULL,  case_unordered     },
              {"help",           no_argument,       NULL,  case_help          },
              {0,                0,                 0,     0                  }
         };
@@ -572,6 +1000,23 @@ int main(int argc, char *argv[]) {
             }
             trust = optarg;
             break;
+        case case_threads:
+            if (!optarg) {
+                fprintf(stderr, "error: option 'threads' needs an argument\n");
+                usage(argv[0]);
+            }
+            num_threads = strtoul(optarg, NULL, 10);
+            if (num_threads == 0) {
+                num_threads = std::max(std::thread::hardware_concurrency(), 1u);
+            }
+            break;
+        case case_unordered:
+            if (optarg) {
+                fprintf(stderr, "error: option 'unordered' does not accept an argument\n");
+                usage(argv[0]);
+            }
+            unordered = true;
+            break;
         case case_help:
             if (optarg) {
                 fprintf(stderr, "error: option 'help' does not accept an argument\n");
@@ -600,15 +1045,13 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "warning: filter cannot be applied to certificate prefix\n");
     }
 
-    struct file_reader *reader = NULL;
+    input_format format = input_format::base64;
     if (input_is_pem) {
-        reader = new pem_file_reader(infile);
+        format = input_format::pem;
     } else if (input_is_json) {
-        reader = new json_file_reader(infile);
+        format = input_format::json;
     } else if (input_is_der) {
-        reader = new der_file_reader(infile);
-    } else {
-        reader = new base64_file_reader(infile);
+        format = input_format::der;
     }
 
     static struct dictionary *kg = NULL;
@@ -617,9 +1060,6 @@ int main(int argc, char *argv[]) {
         kg = &key_group_dict;
     }
 
-    // common_keys
-    std::unordered_map<std::basic_string<uint8_t>, std::basic_string<uint8_t>> keys_to_certs{};
-
     std::list<struct x509_cert> trusted_certs;
     uint8_t trusted_cert_buf[256 * 1024];
     uint8_t *cb = trusted_cert_buf;
@@ -632,138 +1072,44 @@ int main(int argc, char *argv[]) {
         // }
     }
 
-    unsigned int log_index = 0;
-    uint8_t cert_buf[256 * 1024];
-    ssize_t cert_len = 1;
-    while ((cert_len = reader->get_cert(cert_buf, sizeof(cert_buf))) > 0) {
-
-        // fprintf_raw_as_hex(stderr, cert_buf, cert_len);
-        // fprintf(stderr, "\n");
-
-        if (prefix || prefix_as_hex) {
-            // parse certificate prefix, then print as JSON
-            struct x509_cert_prefix p;
-            p.parse(cert_buf, cert_len);
-            if (prefix) {
-                p.print_as_json(stdout);
-            }
-            if (prefix_as_hex) {
-                p.print_as_json_hex(stdout);
-            }
-            // fprintf(stderr, "cert: %u\tprefix length: %zu\n", line_number, p.get_length());
-
-        } else if (sha1_output) {
-
-            fprint_sha1_hash(stdout, cert_buf, cert_len);
-
-        } else {
-
-            // parse certificate, then print as JSON
-            char buffer[64*8192];       // note: hardcoded length for now
-            struct buffer_stream buf(buffer, sizeof(buffer));
-            struct x509_cert c;
-            try {
-                if (trunc_test) {
-
-                    for (ssize_t trunc_len=0; trunc_len <= cert_len; trunc_len++) {
-                        fprintf(stdout, "{ \"trunc_len\": %zd }\n", trunc_len);
-                        buf = { buffer, sizeof(buffer) };
-                        struct x509_cert cc;
-                        cc.parse(cert_buf, trunc_len);
-                        cc.print_as_json(buf, trusted_certs, kg);
-                        buf.write_line(stdout);
-                    }
-
-                } else if (common_key) {
-
-                    // detect distinct certificates that have identical keys
-                    c.parse(cert_buf, cert_len);
-                    if (c.is_valid()) {
-                        std::basic_string<uint8_t> k;
-                        c.get_subject_public_key(k);
-
-                        auto key_and_cert = keys_to_certs.find(k);
-                        if (key_and_cert != keys_to_certs.end()) {
-                            if (verbose) {
-                                fprintf(stdout, "found duplicate for key ");
-                                datum tmp{k.c_str(), k.c_str() + k.length()};
-                                tmp.fprint_hex(stdout);
-                                fputc('\n', stdout);
-                            }
-
-                            // open/create a file to write certs with key k into
-                            //
-                            std::string key_as_hex = hex_encode(k.c_str(), k.length());
-                            std::string filename{common_key};
-                            filename += "-" + key_as_hex.substr(32, 48);
-                            base64_file_writer b64writer{filename.c_str()};
-
-                            // write certs to file
-                            if (b64writer.is_empty()) {
-                                // write first certificate with key k into file
-                                if (b64writer.write_cert(key_and_cert->second.c_str(), key_and_cert->second.length()) < 0) {
-                                    fprintf(stderr, "error: could not write original certificate to base64 output file\n");
-                                }
-                            }
-                            if (b64writer.write_cert(cert_buf, cert_len) < 0) {
-                                fprintf(stderr, "error: could not write certificate to base64 output file\n");
-                            }
-
-                        } else {
-                            std::basic_string<uint8_t> tmp_cert{cert_buf, cert_len};
-                            keys_to_certs.insert({k, tmp_cert});
-                        }
-
-                        // note: b64writer closes its file at the end of
-                        // this scope, though the data in the file
-                        // probably won't be written out to disk until
-                        // immediately
-                    }
-
-                } else {
+    // common_keys
+    common_key_map keys_to_certs{common_key};
+
+    cert_processor proc{trusted_certs};
+    proc.set_filter(filter);
+    proc.logfile = logfile;
+    proc.prefix = prefix;
+    proc.prefix_as_hex = prefix_as_hex;
+    proc.trunc_test = trunc_test;
+    proc.pem_output = pem_output;
+    proc.sha1_output = sha1_output;
+    proc.verbose = verbose;
+    proc.kg = kg;
+    if (common_key) {
+        proc.common_keys = &keys_to_certs;
+    }
 
-                    std::regex rgx;
-                    if (filter && strcmp(filter, "weak") != 0) {
-                        rgx = std::regex{filter};
-                    }
-                    char *search_start = (char *)cert_buf;
-                    char *search_end = search_start + cert_len;
-                    c.parse(cert_buf, cert_len);
-                    if ((filter == NULL)
-                        || (strcmp(filter, "weak") == 0 && (c.is_not_currently_valid()
-                                                           || c.subject_key_is_weak()
-                                                           || c.signature_is_weak()
-                                                           || c.is_nonconformant()
-                                                           || c.is_self_issued()
-                                                            || !c.is_trusted(trusted_certs)))
-                        || std::regex_search(search_start, search_end, rgx)) {
+    if (num_threads > 1) {
+        process_in_parallel(proc, format, infile, num_threads, !unordered);
+        exit(EXIT_SUCCESS);
+    }
 
-                        if (pem_output) {
-                            bool success = write_pem(stdout, cert_buf, cert_len, "CERTIFICATE");
-                            if (!success) {
-                                throw std::runtime_error{"could not write PEM output"};
-                            }
-                        } else {
-                            c.print_as_json(buf, trusted_certs, kg);
-                            buf.write_line(stdout);
-                        }
-                    }
+    struct file_reader *reader = NULL;
+    if (input_is_pem) {
+        reader = new pem_file_reader(infile);
+    } else if (input_is_json) {
+        reader = new json_file_reader(infile);
+    } else if (input_is_der) {
+        reader = new der_file_reader(infile);
+    } else {
+        reader = new base64_file_reader(infile);
+    }
 
-                }
-            } catch (const char *s) {
-                fprintf(stderr, "caught exception: %s\n", s);
-                if (logfile) {
-                    std::string filename(logfile);
-                    filename.append(std::to_string(log_index++));
-                    filename.append(".der");
-                    der_file_writer der_file(filename.c_str());
-                    if (der_file.write_cert(cert_buf, cert_len) < 0) {
-                        fprintf(stderr, "error: could not write certificate %s to file\n", filename.c_str());
-                    }
-                    //c.print_as_json(buf);
-                }
-            }
-        }
+    static char buffer[64*8192];       // note: hardcoded length for now
+    static uint8_t cert_buf[256 * 1024];
+    ssize_t cert_len = 1;
+    while ((cert_len = reader->get_cert(cert_buf, sizeof(cert_buf))) > 0) {
+        proc.process(stdout, cert_buf, cert_len, buffer, sizeof(buffer));
     }
 
     delete reader;
@@ -7,11 +7,13 @@
 #define CONTROL_H
 
 #include <unistd.h>
+#include <cinttypes>
 #include <string>
 #include <atomic>
 #include <stdexcept>
 #include "rotator.h"
 #include "output.h"
+#include "signal_handling.h"
 #include "libmerc/libmerc.h"
 
 class controller {
@@ -25,13 +27,16 @@ public:
                bool do_stats) :
         mc{merc_ctx},
         stats_file{stats_filename, ".json.gz"},
+        perf_counters_file{cfg.perf_counters_filename ? cfg.perf_counters_filename : "disabled", ".json"},
         num_secs_between_writes{num_secs},
         count{num_secs},
         controller_thread{},
         shutdown_requested{false},
         has_run_at_least_once{false},
         out_file{file},
-        stats_dump{do_stats}
+        stats_dump{do_stats},
+        perf_counters_dump{cfg.perf_counters_filename != nullptr},
+        resource_reload_count{mercury_get_resource_reload_count(merc_ctx)}
     {
         if (mc == nullptr) {
             throw std::runtime_error("error: null mercury context passed to control thread");
@@ -72,6 +77,7 @@ private:
 
     mercury_context mc;
     rotator stats_file;
+    rotator perf_counters_file;
     size_t num_secs_between_writes;
     size_t count;
     size_t out_count;
@@ -80,26 +86,74 @@ private:
     bool has_run_at_least_once;
     struct output_file* out_file = nullptr;
     bool stats_dump = false;
+    bool perf_counters_dump = false;
+    size_t perf_counters_count = 0;
+    uint64_t resource_reload_count;
 
     void run_tasks() {
         while (shutdown_requested.load() == false) {
             outfile_routine();
+            reload_routine();
 
             if (stats_dump) {
                 if (count == 0) {
-                    count = num_secs_between_writes;
-                    has_run_at_least_once = true;
-                    const char *fname = stats_file.get_next_name();
-                    if (mercury_write_stats_data(mc, fname) == false) {
-                        fprintf(stderr, "error: could not write stats file %s\n", fname);
-                    }
+                    write_stats_now();
                 }
                 --count;
             }
+            if (perf_counters_dump) {
+                if (++perf_counters_count >= num_secs_between_writes) {
+                    write_perf_counters_now(perf_counters_file.get_next_name());
+                }
+            }
             sleep(1);
         }
     }
 
+    // reload_routine() starts a resource reload when one has been
+    // requested through SIGHUP, and writes out the stats before the
+    // reload is started and after it has taken effect, so that each
+    // stats file reflects the resource version that was in use
+    //
+    void reload_routine() {
+        if (sig_reload_flag) {
+            sig_reload_flag = 0;
+            fprintf(stderr, "reloading resources\n");
+            write_stats_now();
+            if (mercury_reload_resources(mc, nullptr) == false) {
+                fprintf(stderr, "error: could not start resource reload\n");
+            }
+        }
+
+        uint64_t current_count = mercury_get_resource_reload_count(mc);
+        if (current_count != resource_reload_count) {
+            resource_reload_count = current_count;
+            const char *version = mercury_get_resource_version(mc);
+            fprintf(stderr, "resources reloaded (count: %" PRIu64 ", resource version: %s)\n",
+                    current_count, version ? version : "unknown");
+            write_stats_now();
+        }
+    }
+
+    void write_stats_now() {
+        if (stats_dump) {
+            count = num_secs_between_writes;
+            has_run_at_least_once = true;
+            const char *fname = stats_file.get_next_name();
+            if (mercury_write_stats_data(mc, fname) == false) {
+                fprintf(stderr, "error: could not write stats file %s\n", fname);
+            }
+        }
+    }
+
+    void write_perf_counters_now(const char *fname) {
+        perf_counters_count = 0;
+        if (mercury_write_perf_counters(mc, fname) == false) {
+            fprintf(stderr, "error: could not write perf counters file %s (is libmerc built with LIBMERC_PERF_COUNTERS?)\n", fname);
+            perf_counters_dump = false;
+        }
+    }
+
     void outfile_routine() {
         if (out_file->rotation_req.load() == true) {
             enum status status = output_file_rotate(out_file);
@@ -135,6 +189,9 @@ private:
                 fprintf(stderr, "error: could not write stats file %s\n", fname);
             }
         }
+        if (perf_counters_dump) {
+            write_perf_counters_now(perf_counters_file.get_next_name());
+        }
     }
 
 };
@@ -1,16 +1,18 @@
 #cython: language_level=3, embedsignature=True
 
+import os
 import json
 import math
 from base64 import b64decode
 
 from libcpp.unordered_map cimport unordered_map
 from libcpp.string cimport string
+from libcpp.vector cimport vector
 from libcpp cimport bool
 from libc.stdio cimport *
 from libc.stdint cimport *
 from libc.string cimport memset
-from posix.time cimport timespec
+from posix.time cimport timespec, clock_gettime, CLOCK_REALTIME
 from cython.operator import dereference
 
 
@@ -117,6 +119,32 @@ cdef extern from "../libmerc/analysis.h":
                                  long double new_port_weight, long double new_ip_weight,
                                  long double new_sni_weight, long double new_ua_weight)
 
+cdef extern from "mercury_batch.hpp" nogil:
+    cdef cppclass packet_batch:
+        void reserve(size_t num_packets)
+        void add(const uint8_t *packet, size_t length, timespec t)
+        void read_pcap(const char *fname) except +
+        size_t size()
+    cdef cppclass analysis_record:
+        bool valid
+        fingerprint_status status
+        fingerprint_type type
+        string fingerprint
+        string server_name
+        bool has_process
+        string process
+        double score
+        bool has_malware
+        bool malware
+        double p_malware
+        string attributes
+    cdef cppclass batch_processor:
+        batch_processor(mercury *mc)
+        string write_json(packet_batch &b, vector[size_t] &record_index, size_t num_threads) except +
+        void analyze(packet_batch &b, vector[analysis_record] &results, size_t num_threads) except +
+
+cdef uint8_t empty_packet[1]
+
 fp_status_dict = {
     0: 'no_info_available',
     1: 'labeled',
@@ -179,6 +207,7 @@ cdef class Mercury:
     cdef dict py_config
     cdef classifier* clf
     cdef bool do_analysis
+    cdef batch_processor* batch
 
     def __init__(self, bool do_analysis=False, bytes resources=b'', bool output_tcp_initial_data=False, bool output_udp_initial_data=False,
                  bytes packet_filter_cfg=b'all', bool metadata_output=True, bool dns_json_output=True, bool certs_json_output=True):
@@ -218,6 +247,8 @@ cdef class Mercury:
             print('error: mercury_packet_processor_construct() failed')
             return 1
 
+        self.batch = new batch_processor(self.mercury_context)
+
         return 0
 
 
@@ -324,6 +355,122 @@ cdef class Mercury:
         return result
 
 
+    cdef int fill_batch(self, packet_batch *b, object packets, object timestamps, list refs) except -1:
+        """
+        Set the packet batch b to refer to the packets in a pcap file (if packets is a path), with the timestamps
+        in that file, or to the buffers in the sequence packets, whose memoryviews are appended to refs to keep
+        them alive, with the corresponding timestamps, or the current time if timestamps is None.
+        """
+        if isinstance(packets, (str, os.PathLike)):
+            b.read_pcap(os.fsencode(packets))
+            return 0
+
+        cdef const unsigned char[::1] view
+        cdef timespec c_ts
+        clock_gettime(CLOCK_REALTIME, &c_ts)
+        b.reserve(len(packets))
+        for i, pkt in enumerate(packets):
+            if timestamps is not None:
+                c_ts.tv_sec  = int(timestamps[i])
+                c_ts.tv_nsec = int(math.modf(timestamps[i])[0]*1e9)
+            view = pkt
+            refs.append(view)
+            if view.shape[0] == 0:
+                b.add(empty_packet, 0, c_ts)
+            else:
+                b.add(&view[0], view.shape[0], c_ts)
+        return 0
+
+
+    def get_mercury_json_batch(self, packets, timestamps=None, unsigned int num_threads=1, bool with_index=False):
+        """
+        Return mercury's JSON representation of a batch of packets. The GIL is released while the packets
+        are processed, and the packets are spread across `num_threads` threads by flow, each of which has
+        its own packet processor; the flow state of those processors is retained between calls, but is
+        separate from that used by :meth:`get_mercury_json`.
+
+        :param packets: a sequence of bytes-like objects, each holding one packet, or the path of a pcap file,
+                        in which case the timestamps in that file are used
+        :type packets: sequence or str
+        :param timestamps: a sequence of timestamps, one per packet (default=None, meaning the time of the call)
+        :type timestamps: sequence of double
+        :param num_threads: number of threads to use (default=1)
+        :type num_threads: unsigned int
+        :param with_index: also return the index of the packet that produced each record (default=`False`)
+        :type with_index: bool
+        :return: newline-delimited JSON records in packet order, or a tuple of those records and a list of packet indices
+        :rtype: bytes or tuple
+        """
+        cdef packet_batch b
+        cdef vector[size_t] record_index
+        cdef string records
+        cdef list refs = []
+        self.fill_batch(&b, packets, timestamps, refs)
+
+        with nogil:
+            records = self.batch.write_json(b, record_index, num_threads)
+
+        if with_index:
+            return records, record_index
+        return records
+
+
+    def analyze_packet_batch(self, packets, timestamps=None, unsigned int num_threads=1):
+        """
+        Given a batch of packets, report the fingerprint and analysis metadata of each, as in
+        :meth:`analyze_packet`. Processing is done with the GIL released, as in :meth:`get_mercury_json_batch`.
+
+        :param packets: a sequence of bytes-like objects, each holding one packet, or the path of a pcap file,
+                        in which case the timestamps in that file are used
+        :type packets: sequence or str
+        :param timestamps: a sequence of timestamps, one per packet (default=None, meaning the time of the call)
+        :type timestamps: sequence of double
+        :param num_threads: number of threads to use (default=1)
+        :type num_threads: unsigned int
+        :return: a dict of columns (lists), with one entry per packet in each column, which is None for a
+                 packet that has no fingerprint; the 'attributes' column holds the (possibly empty) list of
+                 attributes that :meth:`analyze_packet` reports
+        :rtype: dict
+        """
+        cdef packet_batch b
+        cdef vector[analysis_record] results
+        cdef list refs = []
+        self.fill_batch(&b, packets, timestamps, refs)
+
+        with nogil:
+            self.batch.analyze(b, results, num_threads)
+
+        cdef dict columns = {
+            'status':      [],
+            'type':        [],
+            'str_repr':    [],
+            'server_name': [],
+            'process':     [],
+            'score':       [],
+            'malware':     [],
+            'p_malware':   [],
+            'attributes':  [],
+        }
+        cdef analysis_record *r
+        for i in range(results.size()):
+            r = &results[i]
+            if not r.valid:
+                for column in columns.values():
+                    column.append(None)
+                continue
+            columns['status'].append(fp_status_dict[r.status])
+            columns['type'].append(fp_type_dict[r.type])
+            columns['str_repr'].append(r.fingerprint.decode('UTF-8'))
+            columns['server_name'].append(r.server_name.decode('UTF-8') if r.server_name.size() > 0 else None)
+            columns['process'].append(r.process.decode('UTF-8') if r.has_process else None)
+            columns['score'].append(r.score if r.has_process else None)
+            columns['malware'].append(r.malware if r.has_malware else None)
+            columns['p_malware'].append(r.p_malware if r.has_malware else None)
+            columns['attributes'].append(self.parse_attributes(r.attributes.c_str()) if r.attributes.size() > 0 else [])
+
+        return columns
+
+
     cpdef dict perform_analysis(self, str fp_str, str server_name, str dst_ip, int dst_port):
         """
         Directly call into mercury analysis functionality by providing all needed data features.
@@ -442,10 +589,14 @@ cdef class Mercury:
         cdef char tags_buf[8192]
         memset(tags_buf, 0, 8192)
         cdef char* tags_buf_p = tags_buf
+        ar.attr.write_json(tags_buf_p, 8192)
+        return self.parse_attributes(tags_buf_p)
+
+
+    cdef list parse_attributes(self, const char *attributes_json):
         try:
-            ar.attr.write_json(tags_buf_p, 8192)
             ret_ = []
-            for x in json.loads(tags_buf_p.decode())['attributes']:
+            for x in json.loads(attributes_json.decode())['attributes']:
                 ret_.append({'name': x['name'], 'probability_score': x['probability_score']})
             return ret_
         except:
@@ -540,6 +691,8 @@ cdef class Mercury:
 
 
     cpdef int mercury_finalize(self):
+        del self.batch
+        self.batch = NULL
         mercury_packet_processor_destruct(<mercury_packet_processor>self.mpp)
         cdef int retval = mercury_finalize(<mercury_context>self.mercury_context)
         return retval
@@ -0,0 +1,301 @@
+// mercury_batch.hpp
+//
+// multi-threaded batch processing of packets, for use by the cython
+// interface (mercury.pyx); none of the functions in this file require
+// the python GIL
+
+#ifndef MERCURY_BATCH_HPP
+#define MERCURY_BATCH_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include "../libmerc/libmerc.h"
+#include "../libmerc/pkt_proc.h"
+#include "../libmerc/eth.h"
+#include "../libmerc/ip.h"
+#include "../libmerc/tcpip.h"
+#include "../libmerc/udp.h"
+#include "../pcap.h"
+
+/// a set of packets to be processed by a \ref batch_processor; the
+/// packet data is owned by the caller, unless it was read from a
+/// pcap file with \ref packet_batch::read_pcap()
+///
+class packet_batch {
+    std::unique_ptr<pcap::file_reader> pcap;
+
+public:
+    std::vector<uint8_t *> packets;
+    std::vector<size_t> lengths;
+    std::vector<struct timespec> ts;
+
+    void reserve(size_t num_packets) {
+        packets.reserve(num_packets);
+        lengths.reserve(num_packets);
+        ts.reserve(num_packets);
+    }
+
+    void add(const uint8_t *packet, size_t length, struct timespec t) {
+        packets.push_back((uint8_t *)packet);
+        lengths.push_back(length);
+        ts.push_back(t);
+    }
+
+    /// reads all of the packets in the pcap or pcapng file \param
+    /// fname into the batch, with their timestamps from that file,
+    /// and throws an exception if the file cannot be read
+    ///
+    void read_pcap(const char *fname) {
+        pcap = std::make_unique<pcap::file_reader>(fname);
+        while (true) {
+            struct timespec t{0, 0};
+            std::pair<const uint8_t *, const uint8_t *> pkt = pcap->read_packet(&t);
+            if (pkt.first == nullptr || pkt.second == nullptr) {
+                break;
+            }
+            add(pkt.first, pkt.second - pkt.first, t);
+        }
+    }
+
+    size_t size() const { return packets.size(); }
+};
+
+/// the analysis results for a single packet, as reported by
+/// \ref batch_processor::analyze()
+///
+struct analysis_record {
+    bool valid = false;                // true if there is a fingerprint
+    fingerprint_status status = fingerprint_status_no_info_available;
+    fingerprint_type type = fingerprint_type_unknown;
+    std::string fingerprint;
+    std::string server_name;
+    bool has_process = false;
+    std::string process;
+    double score = 0.0;
+    bool has_malware = false;
+    bool malware = false;
+    double p_malware = 0.0;
+    std::string attributes;            // JSON object with an "attributes" array, if any
+};
+
+/// processes batches of packets with a set of packet processors that
+/// share a single mercury context, with one thread per packet
+/// processor.  Packets are assigned to processors by a hash of their
+/// flow key, which is the same for both directions of a flow, so the
+/// packets of each flow are processed in order by the same processor,
+/// and the flow state (e.g. for reassembly) is retained across calls.
+///
+class batch_processor {
+    mercury_context mc;
+    std::vector<mercury_packet_processor> processors;
+
+    static constexpr size_t max_record_size = 65536;
+    static constexpr size_t sub_batch_size = 64;
+    static constexpr size_t attributes_buffer_size = 8192;
+
+    /// returns a hash of the flow key of \param packet, or zero if
+    /// it is not an IP packet
+    ///
+    static size_t flow_hash(const uint8_t *packet, size_t length) {
+        datum pkt{packet, packet + length};
+        if (!eth::get_ip(pkt)) {
+            return 0;
+        }
+        struct key k;
+        ip ip_pkt{pkt, k};
+        uint8_t transport_proto = ip_pkt.transport_protocol();
+        if (transport_proto == ip::protocol::tcp) {
+            tcp_packet tcp_pkt{pkt, &ip_pkt};
+            if (tcp_pkt.is_valid()) {
+                tcp_pkt.set_key(k);
+            }
+        } else if (transport_proto == ip::protocol::udp) {
+            class udp udp_pkt{pkt};
+            udp_pkt.set_key(k);
+        }
+        return std::hash<struct key>{}(k);
+    }
+
+    /// constructs packet processors as needed so that there are at
+    /// least \param num_threads of them, and returns the number that
+    /// will be used, which is at least one
+    ///
+    size_t get_processors(size_t num_threads) {
+        if (num_threads == 0) {
+            num_threads = 1;
+        }
+        while (processors.size() < num_threads) {
+            mercury_packet_processor p = mercury_packet_processor_construct(mc);
+            if (p == nullptr) {
+                throw std::runtime_error("could not construct packet processor");
+            }
+            processors.push_back(p);
+        }
+        return num_threads;
+    }
+
+    /// returns the indices of the packets in \param b, partitioned
+    /// into \param num_threads lists by flow
+    ///
+    static std::vector<std::vector<size_t>> partition(const packet_batch &b, size_t num_threads) {
+        std::vector<std::vector<size_t>> part(num_threads);
+        for (size_t i = 0; i < b.size(); i++) {
+            size_t t = num_threads == 1 ? 0 : flow_hash(b.packets[i], b.lengths[i]) % num_threads;
+            part[t].push_back(i);
+        }
+        return part;
+    }
+
+    /// invokes \param f(t) for each thread number t less than \param
+    /// num_threads, with the last one running in the calling thread
+    ///
+    template <typename F>
+    static void run_threads(size_t num_threads, F f) {
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t + 1 < num_threads; t++) {
+            threads.emplace_back(f, t);
+        }
+        f(num_threads - 1);
+        for (auto &th : threads) {
+            th.join();
+        }
+    }
+
+public:
+
+    explicit batch_processor(mercury_context context) : mc{context} { }
+
+    ~batch_processor() {
+        for (auto &p : processors) {
+            mercury_packet_processor_destruct(p);
+        }
+    }
+
+    /// returns the JSON records for the packets in \param b as a
+    /// string of newline-delimited records, in packet order, and sets
+    /// \param record_index to the index of the packet for each record
+    ///
+    std::string write_json(packet_batch &b, std::vector<size_t> &record_index, size_t num_threads) {
+        num_threads = get_processors(num_threads);
+        std::vector<std::vector<size_t>> part = partition(b, num_threads);
+
+        // each thread writes its records into its own output string,
+        // and notes the location of the record for each packet
+        //
+        struct record_location {
+            size_t thread = 0;
+            size_t offset = 0;
+            size_t length = 0;
+        };
+        std::vector<std::string> output(num_threads);
+        std::vector<record_location> location(b.size());
+
+        run_threads(num_threads, [&](size_t t) {
+            std::vector<uint8_t> arena(4 * max_record_size);
+            uint8_t *packets[sub_batch_size];
+            size_t lengths[sub_batch_size];
+            struct timespec ts[sub_batch_size];
+            size_t offsets[sub_batch_size];
+            size_t record_lengths[sub_batch_size];
+
+            const std::vector<size_t> &idx = part[t];
+            size_t start = 0;
+            while (start < idx.size()) {
+                size_t n = std::min(sub_batch_size, idx.size() - start);
+                for (size_t i = 0; i < n; i++) {
+                    packets[i] = b.packets[idx[start + i]];
+                    lengths[i] = b.lengths[idx[start + i]];
+                    ts[i] = b.ts[idx[start + i]];
+                }
+                size_t num_processed = mercury_packet_processor_write_json_batch(processors[t],
+                                                                                 arena.data(),
+                                                                                 arena.size(),
+                                                                                 max_record_size,
+                                                                                 packets,
+                                                                                 lengths,
+                                                                                 ts,
+                                                                                 nullptr,
+                                                                                 n,
+                                                                                 offsets,
+                                                                                 record_lengths);
+                if (num_processed == 0) {
+                    break;  // error
+                }
+                for (size_t i = 0; i < num_processed; i++) {
+                    location[idx[start + i]] = { t, output[t].size(), record_lengths[i] };
+                    output[t].append((const char *)arena.data() + offsets[i], record_lengths[i]);
+                }
+                start += num_processed;
+            }
+        });
+
+        // merge the per-thread output into packet order
+        //
+        size_t total_length = 0;
+        for (const auto &o : output) {
+            total_length += o.size();
+        }
+        std::string json;
+        json.reserve(total_length);
+        record_index.clear();
+        for (size_t i = 0; i < b.size(); i++) {
+            const record_location &loc = location[i];
+            if (loc.length == 0) {
+                continue;
+            }
+            json.append(output[loc.thread], loc.offset, loc.length);
+            record_index.push_back(i);
+        }
+        return json;
+    }
+
+    /// sets \param results to the analysis results for the packets in
+    /// \param b, with one entry per packet
+    ///
+    void analyze(packet_batch &b, std::vector<analysis_record> &results, size_t num_threads) {
+        num_threads = get_processors(num_threads);
+        std::vector<std::vector<size_t>> part = partition(b, num_threads);
+        results.clear();
+        results.resize(b.size());
+
+        run_threads(num_threads, [&](size_t t) {
+            for (size_t i : part[t]) {
+                struct timespec ts = b.ts[i];
+                const struct analysis_context *ac = mercury_packet_processor_get_analysis_context(processors[t],
+                                                                                                  b.packets[i],
+                                                                                                  b.lengths[i],
+                                                                                                  &ts);
+                if (ac == nullptr) {
+                    continue;
+                }
+                analysis_record &r = results[i];
+                r.valid = true;
+                r.status = analysis_context_get_fingerprint_status(ac);
+                r.type = analysis_context_get_fingerprint_type(ac);
+                r.fingerprint = analysis_context_get_fingerprint_string(ac);
+                const char *server_name = analysis_context_get_server_name(ac);
+                if (server_name != nullptr) {
+                    r.server_name = server_name;
+                }
+                const char *process = nullptr;
+                r.has_process = analysis_context_get_process_info(ac, &process, &r.score);
+                if (r.has_process && process != nullptr) {
+                    r.process = process;
+                }
+                r.has_malware = analysis_context_get_malware_info(ac, &r.malware, &r.p_malware);
+                attribute_result attr = ac->result.attr;
+                if (attr.is_valid()) {
+                    std::array<char, attributes_buffer_size> attr_buf{};
+                    attr.write_json(attr_buf.data(), attr_buf.size() - 1);
+                    r.attributes = attr_buf.data();
+                }
+            }
+        });
+    }
+
+};
+
+#endif // MERCURY_BATCH_HPP
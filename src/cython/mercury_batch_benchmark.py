@@ -0,0 +1,89 @@
+"""
+mercury_batch_benchmark.py compares the packet processing rate of
+Mercury.get_mercury_json(), which processes one packet per call, with
+that of Mercury.get_mercury_json_batch() for various numbers of threads.
+
+usage: python3 mercury_batch_benchmark.py <pcap file> [-r resources] [-t threads] [-n repetitions]
+"""
+
+import os
+import sys
+import time
+import struct
+import argparse
+
+import mercury
+
+
+def read_pcap(pcap_file):
+    """return a list of the packets in a (traditional, not pcapng) pcap file"""
+    packets = []
+    with open(pcap_file, 'rb') as f:
+        header = f.read(24)
+        if len(header) < 24:
+            raise ValueError(f'{pcap_file} is too short to be a pcap file')
+        magic = struct.unpack('<I', header[:4])[0]
+        if magic in (0xa1b2c3d4, 0xa1b23c4d):
+            endian = '<'
+        elif magic in (0xd4c3b2a1, 0x4d3cb2a1):
+            endian = '>'
+        else:
+            raise ValueError(f'{pcap_file} is not a pcap file')
+        while True:
+            record = f.read(16)
+            if len(record) < 16:
+                break
+            _, _, caplen, _ = struct.unpack(endian + 'IIII', record)
+            packets.append(f.read(caplen))
+    return packets
+
+
+def packets_per_second(func, num_packets, repetitions):
+    start = time.perf_counter()
+    for _ in range(repetitions):
+        func()
+    elapsed = time.perf_counter() - start
+    return num_packets * repetitions / elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description='benchmark the per-packet and batch mercury-python APIs')
+    parser.add_argument('pcap', help='pcap file to process')
+    parser.add_argument('-r', '--resources', default=None, help='resource archive, to enable analysis')
+    parser.add_argument('-t', '--threads', default=str(os.cpu_count()),
+                        help='comma-separated list of thread counts for the batch API (default: number of CPUs)')
+    parser.add_argument('-n', '--repetitions', type=int, default=3, help='number of passes over the packets')
+    args = parser.parse_args()
+
+    packets = read_pcap(args.pcap)
+    if len(packets) == 0:
+        print(f'error: no packets in {args.pcap}', file=sys.stderr)
+        return 1
+    print(f'{len(packets)} packets, {args.repetitions} repetitions')
+
+    def new_mercury():
+        if args.resources:
+            return mercury.Mercury(do_analysis=True, resources=args.resources.encode())
+        return mercury.Mercury()
+
+    libmerc = new_mercury()
+    def per_packet():
+        for pkt in packets:
+            libmerc.get_mercury_json(pkt)
+    baseline = packets_per_second(per_packet, len(packets), args.repetitions)
+    print(f'get_mercury_json:                    {baseline:12.0f} packets/s')
+    libmerc.mercury_finalize()
+
+    thread_counts = sorted(set([1] + [int(t) for t in args.threads.split(',')]))
+    for num_threads in thread_counts:
+        libmerc = new_mercury()
+        rate = packets_per_second(lambda: libmerc.get_mercury_json_batch(packets, num_threads=num_threads),
+                                  len(packets), args.repetitions)
+        print(f'get_mercury_json_batch ({num_threads:3d} threads): {rate:12.0f} packets/s ({rate / baseline:.1f}x)')
+        libmerc.mercury_finalize()
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -103,9 +103,10 @@ setup(
                 "-std=c++17",
                 "-Wno-narrowing",
                 "-Wno-deprecated-declarations",
+                "-pthread",
             ]
             + additional_flags,
-            extra_link_args=["-std=c++17", "-lz"] + additional_flags,
+            extra_link_args=["-std=c++17", "-lz", "-pthread"] + additional_flags,
             libraries=["crypto"],
             runtime_library_dirs=["{mercury_dir}/src/".format(mercury_dir=mercury_dir)],
         )
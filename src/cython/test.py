@@ -1,5 +1,8 @@
 import os
 import json
+import time
+import struct
+import tempfile
 import unittest
 from binascii import unhexlify
 
@@ -84,5 +87,46 @@ class TestMercuryPython(unittest.TestCase):
                          f"TLS fingerprint should be {fingerprint_data['fingerprints']['quic']}")
 
 
+    def test_batch(self):
+        packets = [unhexlify(firefox_pkt), unhexlify(quic_pkt), b'', unhexlify(firefox_pkt)]
+        timestamps = [1.0, 2.0, 3.0, 4.0]
+        for num_threads in (1, 2):
+            records, index = TestMercuryPython.libmerc.get_mercury_json_batch(packets, timestamps, num_threads=num_threads,
+                                                                             with_index=True)
+            self.assertEqual(index, [0, 1, 3], 'batch records should come from packets 0, 1, and 3')
+            for record, i in zip(records.splitlines(), index):
+                self.assertEqual(json.loads(record), TestMercuryPython.libmerc.get_mercury_json(packets[i], timestamps[i]),
+                                 f'batch record for packet {i} should match get_mercury_json()')
+
+            columns = TestMercuryPython.libmerc.analyze_packet_batch(packets, num_threads=num_threads)
+            analysis = TestMercuryPython.libmerc.analyze_packet(packets[0])
+            self.assertEqual(columns['process'][0], analysis['analysis']['process'],
+                             f"batch analysis process name should be {analysis['analysis']['process']}")
+            self.assertEqual(columns['str_repr'][0], analysis['fingerprint_info']['str_repr'],
+                             'batch fingerprint should match analyze_packet()')
+            self.assertIsNone(columns['type'][2], 'empty packet should have no fingerprint')
+            self.assertEqual(columns['attributes'][0], analysis['analysis'].get('attributes', []),
+                             'batch attributes should match analyze_packet()')
+
+        # without timestamps, records carry the time of the call
+        #
+        records = TestMercuryPython.libmerc.get_mercury_json_batch(packets[:1])
+        event_start = json.loads(records.splitlines()[0])['event_start']
+        self.assertAlmostEqual(event_start, time.time(), delta=60, msg='batch record without a timestamp should have the current time')
+
+
+    def test_batch_pcap_timestamps(self):
+        with tempfile.TemporaryDirectory() as d:
+            path = os.path.join(d, 'batch.pcap')
+            with open(path, 'wb') as f:
+                f.write(struct.pack('<IHHiIII', 0xa1b2c3d4, 2, 4, 0, 0, 65535, 1))
+                for ts_sec, ts_usec, pkt in ((1600000000, 250000, unhexlify(firefox_pkt)),):
+                    f.write(struct.pack('<IIII', ts_sec, ts_usec, len(pkt), len(pkt)))
+                    f.write(pkt)
+            records = TestMercuryPython.libmerc.get_mercury_json_batch(path)
+            self.assertEqual(json.loads(records.splitlines()[0])['event_start'], 1600000000.25,
+                             'batch record from a pcap file should have the timestamp of its packet')
+
+
 if __name__ == '__main__':
     unittest.main()
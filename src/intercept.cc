@@ -83,6 +83,14 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 
+// for ring_output
+//
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <pthread.h>
+#include <mutex>
+#include "intercept_ring.hpp"
+
 
 // Macros to colorize output
 //
@@ -290,6 +298,10 @@ void print_flow_key(int fd) {
 #include "libmerc/netbios.h"
 #include "libmerc/openvpn.h"
 #include "libmerc/tofsee.hpp"
+#include "libmerc/ldap.hpp"
+#include "libmerc/esp.hpp"
+#include "libmerc/ike.hpp"
+#include "libmerc/mysql.hpp"
 
 #include <unordered_set>
 #include <string>
@@ -373,7 +385,7 @@ public:
     virtual void write_buffer(struct buffer_stream &buf) = 0;
     virtual ~output() {};
 
-    enum type { unknown=0, file, log, daemon };
+    enum type { unknown=0, file, log, daemon, ring };
 
     static enum output::type get_type(const char *type_string) {
         if (type_string == nullptr) {
@@ -389,6 +401,9 @@ public:
         if (s.compare("daemon") == 0) {
             return output::type::daemon;
         }
+        if (s.compare("ring") == 0) {
+            return output::type::ring;
+        }
         return output::type::unknown;
     }
 };
@@ -544,6 +559,159 @@ struct daemon_output : public output {
     }
 };
 
+// struct ring_output writes records into a shared-memory ring (see
+// intercept_ring.hpp) that intercept_server drains, so that writing a
+// record does not need a system call.  The ring is created and handed
+// to intercept_server on the first write, and again in the child
+// process after a fork(); if that fails, records are sent as
+// datagrams, as with daemon_output.  The environment variable
+// intercept_ring_size sets the capacity of the ring in bytes.
+//
+struct ring_output : public daemon_output {
+    intercept_ring ring;
+    void *ring_mapping = MAP_FAILED;
+    size_t ring_mapping_size = 0;
+    int doorbell = -1;
+    bool ring_needed = true;
+    std::mutex ring_mutex;   // serializes writers, since the ring has a single producer
+
+    static constexpr uint64_t default_capacity = 1 << 22;
+
+    // instance points to the ring_output in this process, for use
+    // by the fork handlers
+    //
+    static inline ring_output *instance = nullptr;
+
+    ring_output() {
+        instance = this;
+        static bool registered = false;
+        if (!registered) {
+            pthread_atfork(prepare_fork, parent_after_fork, child_after_fork);
+            registered = true;
+        }
+    }
+
+    ~ring_output() {
+        instance = nullptr;
+        release_ring();
+    }
+
+    void write_buffer(struct buffer_stream &buf) {
+        std::lock_guard<std::mutex> lock{ring_mutex};
+        if (ring_needed) {
+            ring_needed = false;
+            setup_ring();
+        }
+        if (!ring.is_valid()) {
+            daemon_output::write_buffer(buf);
+            return;
+        }
+        if (ring.write(buf.dstr, buf.length())) {
+            eventfd_write(doorbell, 1);
+        }
+    }
+
+private:
+
+    void setup_ring() {
+        release_ring();
+
+        uint64_t capacity = default_capacity;
+        const char *ring_size = getenv("intercept_ring_size");
+        if (ring_size != nullptr) {
+            capacity = strtoull(ring_size, nullptr, 10);
+            if (!intercept_ring::is_valid_capacity(capacity)) {
+                fprintf(stderr, "intercept: warning: intercept_ring_size must be a power of two no smaller than 4096\n");
+                capacity = default_capacity;
+            }
+        }
+        int memfd = memfd_create("intercept_ring", MFD_CLOEXEC);
+        if (memfd == -1) {
+            fprintf(stderr, "intercept: warning: could not create ring (%s), using datagrams\n", strerror(errno));
+            return;
+        }
+        ring_mapping_size = intercept_ring::mapping_size(capacity);
+        if (ftruncate(memfd, ring_mapping_size) == -1
+            || (ring_mapping = mmap(nullptr, ring_mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0)) == MAP_FAILED
+            || (doorbell = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1) {
+            fprintf(stderr, "intercept: warning: could not create ring (%s), using datagrams\n", strerror(errno));
+            close(memfd);
+            release_ring();
+            return;
+        }
+        ring = intercept_ring{ring_mapping, capacity, true};
+
+        // hand the memfd and the doorbell to intercept_server; the
+        // original sendmsg() is used, since the library's own
+        // sendmsg() would intercept this message
+        //
+        intercept_ring_hello hello;
+        memcpy(hello.magic, intercept_ring_hello::magic_value, sizeof(hello.magic));
+        hello.pid = getpid();
+        hello.capacity = capacity;
+        struct iovec iov = { &hello, sizeof(hello) };
+        union {
+            char buf[CMSG_SPACE(2 * sizeof(int))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr msg{};
+        msg.msg_name = &name;
+        msg.msg_namelen = sizeof(name);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+        int fds[2] = { memfd, doorbell };
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+        using sendmsg_func = ssize_t (*)(int, const struct msghdr *, int);
+        static sendmsg_func original_sendmsg = (sendmsg_func)dlsym(RTLD_NEXT, "sendmsg");
+        if (original_sendmsg == nullptr || original_sendmsg(sock, &msg, 0) < 0) {
+            fprintf(stderr, "intercept: warning: could not send ring to intercept_server (%s), using datagrams\n", strerror(errno));
+            release_ring();
+        }
+        close(memfd);
+    }
+
+    void release_ring() {
+        ring = intercept_ring{};
+        if (ring_mapping != MAP_FAILED) {
+            munmap(ring_mapping, ring_mapping_size);
+            ring_mapping = MAP_FAILED;
+        }
+        if (doorbell != -1) {
+            close(doorbell);
+            doorbell = -1;
+        }
+    }
+
+    // the fork handlers hold the mutex across fork(), so that the
+    // child does not inherit it in a locked state, and have the
+    // child create its own ring, since the parent's ring has a
+    // single producer
+    //
+    static void prepare_fork() {
+        if (instance) { instance->ring_mutex.lock(); }
+    }
+
+    static void parent_after_fork() {
+        if (instance) { instance->ring_mutex.unlock(); }
+    }
+
+    static void child_after_fork() {
+        if (instance) {
+            instance->ring_needed = true;
+            instance->ring_mutex.unlock();
+        }
+    }
+
+};
+
 // class intercept controls the behavior of this library; you can
 // define totally new behavior by defining a class that inherits from
 // this one and overrides one or more member functions
@@ -605,6 +773,9 @@ public:
         case output::type::daemon:
             out = new daemon_output;
             break;
+        case output::type::ring:
+            out = new ring_output;
+            break;
         case output::type::file:
         default:
             out = new file_output;   // default to file output
@@ -620,7 +791,7 @@ public:
             output_level = minimal_data;
         }
 
-        if (out_type == output::type::daemon) {
+        if (out_type == output::type::daemon || out_type == output::type::ring) {
             out_fd = ((daemon_output*)out)->get_fd();
         }
 
@@ -805,7 +976,9 @@ public:
             k.src_port = udp_ports.src;
             k.dst_port = udp_ports.dst;
             k.protocol = 17;
-            pkt_proc_ctx->set_udp_protocol(udp_proto, udp_pkt_data, msg_type, true, k);
+            datum empty_udp_header{};
+            udp udp_pkt{empty_udp_header};
+            pkt_proc_ctx->set_udp_protocol(udp_proto, udp_pkt_data, udp_ports, true, k, udp_pkt);
             is_udp = (msg_type != udp_msg_type_unknown) && (std::holds_alternative<std::monostate>(udp_proto) == false) && (std::holds_alternative<unknown_udp_initial_packet>(udp_proto) == false);
         }
         if (!is_tcp && !is_udp) {
@@ -884,7 +1057,9 @@ public:
         k.src_port = udp_ports.src;
         k.dst_port = udp_ports.dst;
         k.protocol = 17;
-        pkt_proc_ctx->set_udp_protocol(udp_proto, udp_pkt_data, msg_type, true, k);
+        datum empty_udp_header{};
+        udp udp_pkt{empty_udp_header};
+        pkt_proc_ctx->set_udp_protocol(udp_proto, udp_pkt_data, udp_ports, true, k, udp_pkt);
         is_udp = (msg_type != udp_msg_type_unknown) && (std::holds_alternative<std::monostate>(udp_proto) == false) && (std::holds_alternative<unknown_udp_initial_packet>(udp_proto) == false);
 
         if (!is_udp) {
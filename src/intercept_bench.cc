@@ -0,0 +1,272 @@
+// intercept_bench.cc
+//
+// benchmark for the intercept.so output transports: runs a local
+// HTTP client and server pair over a loopback TCP connection, with
+// the client and server in separate processes, and measures the
+// round trip time of each request/response exchange without
+// intercept.so, and with intercept.so preloaded and configured to
+// send its output to intercept_server as datagrams
+// (intercept_output_type=daemon) and through a shared-memory ring
+// (intercept_output_type=ring).  Each exchange makes four intercepted
+// calls (two writes and two reads).  The benchmark starts its own
+// intercept_server, which replaces any server that is already
+// listening on /tmp/intercept.socket, and reports the number of
+// records that it wrote for each transport.
+//
+// usage: intercept_bench [--iterations n] [--intercept path] [--server path]
+//
+// e.g. intercept_bench --intercept ./intercept.so --server ./intercept_server
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+static const char request[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "User-Agent: intercept_bench/1.0\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+static const char response[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+
+// read_fully() reads exactly length bytes, unless the connection
+// fails
+//
+static bool read_fully(int fd, char *buffer, size_t length) {
+    while (length > 0) {
+        ssize_t n = read(fd, buffer, length);
+        if (n <= 0) {
+            return false;
+        }
+        buffer += n;
+        length -= n;
+    }
+    return true;
+}
+
+// run_exchanges() runs the HTTP server in a child process and the
+// client in this one, and writes the round trip times to times
+//
+static bool run_exchanges(size_t iterations, std::vector<double> &times) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (listener < 0
+        || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(listener, 1) != 0
+        || getsockname(listener, (struct sockaddr *)&addr, &addr_len) != 0) {
+        fprintf(stderr, "error: could not create listening socket (%s)\n", strerror(errno));
+        return false;
+    }
+
+    pid_t server = fork();
+    if (server == 0) {
+        int fd = accept(listener, nullptr, nullptr);
+        char buffer[sizeof(request) - 1];
+        while (fd >= 0 && read_fully(fd, buffer, sizeof(buffer))) {
+            if (write(fd, response, sizeof(response) - 1) != sizeof(response) - 1) {
+                break;
+            }
+        }
+        _exit(0);
+    }
+    close(listener);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "error: could not connect (%s)\n", strerror(errno));
+        return false;
+    }
+    char buffer[sizeof(response) - 1];
+    times.clear();
+    times.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if (write(fd, request, sizeof(request) - 1) != sizeof(request) - 1
+            || !read_fully(fd, buffer, sizeof(buffer))) {
+            fprintf(stderr, "error: exchange failed\n");
+            return false;
+        }
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    close(fd);
+    waitpid(server, nullptr, 0);
+    return true;
+}
+
+// count_lines() returns the number of lines in the file
+//
+static size_t count_lines(const std::string &file_name) {
+    size_t lines = 0;
+    FILE *f = fopen(file_name.c_str(), "r");
+    if (f != nullptr) {
+        int c;
+        while ((c = fgetc(f)) != EOF) {
+            lines += (c == '\n');
+        }
+        fclose(f);
+    }
+    return lines;
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t iterations = 20000;
+    const char *intercept_lib = "./intercept.so";
+    const char *server_path = "./intercept_server";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--intercept") == 0 && i + 1 < argc) {
+            intercept_lib = argv[++i];
+        } else if (strcmp(argv[i], "--server") == 0 && i + 1 < argc) {
+            server_path = argv[++i];
+        } else {
+            iterations = 0;
+            break;
+        }
+    }
+    if (iterations == 0) {
+        fprintf(stderr, "usage: %s [--iterations n] [--intercept path] [--server path]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // when invoked by the benchmark itself, with or without
+    // intercept.so preloaded, run the exchanges and write the sorted
+    // round trip times to stdout
+    //
+    if (getenv("intercept_bench_child") != nullptr) {
+        std::vector<double> times;
+        if (!run_exchanges(iterations, times)) {
+            return EXIT_FAILURE;
+        }
+        std::sort(times.begin(), times.end());
+        double total = 0.0;
+        for (double t : times) {
+            total += t;
+        }
+        fprintf(stdout, "%f %f %f\n", times[times.size() / 2], times[times.size() * 99 / 100], total / times.size());
+        return 0;
+    }
+
+    char lib_path[PATH_MAX];
+    if (realpath(intercept_lib, lib_path) == nullptr) {
+        fprintf(stderr, "error: could not find %s (%s)\n", intercept_lib, strerror(errno));
+        return EXIT_FAILURE;
+    }
+    char dir_template[] = "/tmp/intercept_bench.XXXXXX";
+    if (mkdtemp(dir_template) == nullptr) {
+        fprintf(stderr, "error: could not create temporary directory (%s)\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    std::string output_file = std::string{dir_template} + "/intercept.json";
+
+    // start intercept_server, and wait until it has created its socket
+    //
+    unlink("/tmp/intercept.socket");
+    pid_t server = fork();
+    if (server == 0) {
+        execl(server_path, server_path, output_file.c_str(), (char *)nullptr);
+        fprintf(stderr, "error: could not run %s (%s)\n", server_path, strerror(errno));
+        _exit(EXIT_FAILURE);
+    }
+    struct stat st;
+    for (int i = 0; i < 100 && stat("/tmp/intercept.socket", &st) != 0; i++) {
+        usleep(20000);
+    }
+
+    struct transport {
+        const char *name;
+        const char *output_type;   // nullptr means no interception
+        double median, p99, mean;
+        size_t records;
+    };
+    std::vector<transport> transports = {
+        { "none",   nullptr,  0, 0, 0, 0 },
+        { "daemon", "daemon", 0, 0, 0, 0 },
+        { "ring",   "ring",   0, 0, 0, 0 },
+    };
+    bool failed = false;
+    for (auto &t : transports) {
+        size_t lines_before = count_lines(output_file);
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) {
+            failed = true;
+            break;
+        }
+        pid_t child = fork();
+        if (child == 0) {
+            dup2(pipe_fds[1], STDOUT_FILENO);
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+            setenv("intercept_bench_child", "1", 1);
+            if (t.output_type != nullptr) {
+                setenv("LD_PRELOAD", lib_path, 1);
+                setenv("intercept_output_type", t.output_type, 1);
+            }
+            execv("/proc/self/exe", argv);
+            _exit(EXIT_FAILURE);
+        }
+        close(pipe_fds[1]);
+        char result[256] = {};
+        ssize_t n = read(pipe_fds[0], result, sizeof(result) - 1);
+        close(pipe_fds[0]);
+        int status;
+        waitpid(child, &status, 0);
+        if (n <= 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0
+            || sscanf(result, "%lf %lf %lf", &t.median, &t.p99, &t.mean) != 3) {
+            fprintf(stderr, "error: benchmark run with transport %s failed\n", t.name);
+            failed = true;
+            break;
+        }
+
+        // give intercept_server time to drain the output, then count
+        // the records that it wrote; it flushes its output whenever
+        // it is idle
+        //
+        usleep(500000);
+        t.records = count_lines(output_file) - lines_before;
+    }
+
+    kill(server, SIGINT);
+    waitpid(server, nullptr, 0);
+    unlink(output_file.c_str());
+    rmdir(dir_template);
+    if (failed) {
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stdout, "exchanges:  %zu (four intercepted calls each)\n", iterations);
+    fprintf(stdout, "%-10s %12s %12s %12s %12s %10s\n", "transport", "median ns", "p99 ns", "mean ns", "overhead ns", "records");
+    for (const auto &t : transports) {
+        fprintf(stdout, "%-10s %12.0f %12.0f %12.0f %12.0f %10zu\n",
+                t.name, t.median, t.p99, t.mean, t.median - transports[0].median, t.records);
+    }
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+// intercept_ring.hpp
+//
+// shared-memory ring buffer transport between intercept.so and
+// intercept_server
+//
+// Copyright (c) 2023 Cisco Systems, Inc.  All rights reserved.  License at
+// https://github.com/cisco/mercury/blob/master/LICENSE
+
+#ifndef INTERCEPT_RING_HPP
+#define INTERCEPT_RING_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <new>
+#include <sys/types.h>
+
+// class intercept_ring is a single-producer, single-consumer ring
+// buffer of variable-length records, which lives in a shared memory
+// mapping (a memfd) that is created by an intercepted process and
+// handed to intercept_server over its Unix socket, along with an
+// eventfd that serves as a doorbell.  The producer writes records
+// without making any system calls, except to ring the doorbell when
+// the consumer has announced that it is about to sleep; when the
+// ring is full, the record is dropped and counted, so that the
+// instrumented application never waits on intercept_server.
+//
+// Each record is a 32-bit length followed by that many bytes, padded
+// to a multiple of eight bytes.  A record never wraps around the end
+// of the buffer; if there is not enough room before the end, the
+// producer writes a padding marker there and continues at the start.
+// The head and tail are byte counts that increase monotonically, and
+// are reduced modulo the (power of two) capacity to find offsets.
+//
+class intercept_ring {
+public:
+
+    // struct header is at the start of the shared mapping; the
+    // fields written by the producer and by the consumer are on
+    // separate cache lines
+    //
+    struct header {
+        uint64_t magic;
+        uint64_t capacity;
+        alignas(64) std::atomic<uint64_t> head;       // written by producer
+        std::atomic<uint64_t> drops;                  // written by producer
+        alignas(64) std::atomic<uint64_t> tail;       // written by consumer
+        std::atomic<uint32_t> consumer_waiting;       // set by consumer, cleared by producer
+    };
+
+    static constexpr uint64_t magic_value = 0x31474e4952435049;   // "IPCRING1"
+
+    static constexpr uint32_t padding_marker = 0xffffffff;
+
+    static constexpr size_t data_offset = (sizeof(header) + 63) & ~(size_t)63;
+
+    // mapping_size() returns the number of bytes in the shared
+    // mapping for a ring with the given capacity
+    //
+    static constexpr size_t mapping_size(uint64_t capacity) { return data_offset + capacity; }
+
+    // is_valid_capacity() returns true if capacity is a power of two
+    // that is large enough to be useful
+    //
+    static constexpr bool is_valid_capacity(uint64_t capacity) {
+        return capacity >= 4096 && (capacity & (capacity - 1)) == 0;
+    }
+
+private:
+    header *hdr = nullptr;
+    uint8_t *data = nullptr;
+    uint64_t capacity = 0;
+
+    static constexpr uint64_t slot_size(uint64_t length) {
+        return (sizeof(uint32_t) + length + 7) & ~(uint64_t)7;
+    }
+
+public:
+
+    intercept_ring() = default;
+
+    // construct a ring in the shared mapping at addr, which must be
+    // mapping_size(capacity) bytes long; if initialize is true, the
+    // header is initialized (by the producer), and otherwise it is
+    // checked (by the consumer), and is_valid() reports the result
+    //
+    intercept_ring(void *addr, uint64_t ring_capacity, bool initialize) {
+        header *h = static_cast<header *>(addr);
+        if (initialize) {
+            new (h) header{};
+            h->magic = magic_value;
+            h->capacity = ring_capacity;
+        } else if (h->magic != magic_value || h->capacity != ring_capacity) {
+            return;
+        }
+        hdr = h;
+        data = static_cast<uint8_t *>(addr) + data_offset;
+        capacity = ring_capacity;
+    }
+
+    bool is_valid() const { return hdr != nullptr; }
+
+    uint64_t drops() const { return hdr->drops.load(std::memory_order_relaxed); }
+
+    // write() copies a record of the given length into the ring, or
+    // counts a drop if there is not enough room for it, and returns
+    // true if the consumer needs to be woken by the doorbell.  It
+    // must not be called by more than one thread at a time.
+    //
+    bool write(const void *record, size_t length) {
+        uint64_t head = hdr->head.load(std::memory_order_relaxed);
+        uint64_t tail = hdr->tail.load(std::memory_order_acquire);
+        uint64_t offset = head & (capacity - 1);
+        uint64_t slot = slot_size(length);
+        uint64_t padding = (offset + slot > capacity) ? capacity - offset : 0;
+        if (length >= padding_marker || (head + padding + slot) - tail > capacity) {
+            hdr->drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (padding) {
+            uint32_t marker = padding_marker;
+            memcpy(data + offset, &marker, sizeof(marker));
+            offset = 0;
+        }
+        uint32_t len = length;
+        memcpy(data + offset, &len, sizeof(len));
+        memcpy(data + offset + sizeof(len), record, length);
+        hdr->head.store(head + padding + slot, std::memory_order_release);
+
+        // the fence orders the store to head before the load of
+        // consumer_waiting, and pairs with the one in
+        // prepare_to_wait(), so that either the consumer sees the new
+        // record or the producer sees that it is waiting
+        //
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return hdr->consumer_waiting.load(std::memory_order_relaxed) != 0
+            && hdr->consumer_waiting.exchange(0) != 0;
+    }
+
+    // read() invokes f(const char *record, size_t length) for up to
+    // max_records records in the ring, in order, and then releases
+    // their space to the producer; it returns the number of records
+    // read, or -1 if the ring has been corrupted
+    //
+    template <typename F>
+    ssize_t read(F f, size_t max_records) {
+        uint64_t head = hdr->head.load(std::memory_order_acquire);
+        uint64_t tail = hdr->tail.load(std::memory_order_relaxed);
+        if (head - tail > capacity) {
+            return -1;
+        }
+        size_t count = 0;
+        while (tail != head && count < max_records) {
+            uint64_t offset = tail & (capacity - 1);
+            uint32_t length;
+            memcpy(&length, data + offset, sizeof(length));
+            if (length == padding_marker) {
+                if (tail + (capacity - offset) > head) {
+                    return -1;
+                }
+                tail += capacity - offset;
+                continue;
+            }
+            if (offset + slot_size(length) > capacity || tail + slot_size(length) > head) {
+                return -1;
+            }
+            f((const char *)data + offset + sizeof(length), length);
+            tail += slot_size(length);
+            count++;
+        }
+        hdr->tail.store(tail, std::memory_order_release);
+        return count;
+    }
+
+    // prepare_to_wait() tells the producer that the consumer is
+    // about to wait on the doorbell, and returns true if the ring is
+    // still empty, in which case it is safe to wait
+    //
+    bool prepare_to_wait() {
+        hdr->consumer_waiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return hdr->head.load(std::memory_order_acquire) == hdr->tail.load(std::memory_order_relaxed);
+    }
+
+};
+
+// struct intercept_ring_hello is the message that an intercepted
+// process sends to intercept_server, along with the memfd holding
+// its ring and the doorbell eventfd, to start using the ring
+//
+struct intercept_ring_hello {
+    char magic[8];      // "ringhelo"
+    uint64_t pid;
+    uint64_t capacity;
+
+    static constexpr const char magic_value[8] = { 'r', 'i', 'n', 'g', 'h', 'e', 'l', 'o' };
+
+    bool is_valid() const { return memcmp(magic, magic_value, sizeof(magic)) == 0; }
+};
+
+#endif // INTERCEPT_RING_HPP
@@ -4,46 +4,130 @@
 // intercept.so shared library; it serializes output from multiple
 // processes, by reading strings from a datagram socket then writing
 // them to a file
+//
+// Processes that use intercept_output_type=ring instead hand the
+// server a shared-memory ring and a doorbell eventfd, through a
+// single message on the same socket (see intercept_ring.hpp); the
+// server drains all of the rings in batches, and reports the number
+// of records that each process dropped because its ring was full
+// when that process exits.
 
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
 #include <cerrno>
+#include <list>
+#include <vector>
+#include <algorithm>
 #include <signal.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include "intercept_ring.hpp"
 
 #define SOCKET_PATH "/tmp/intercept.socket"
 
-FILE *outfile;
-int sock;
+volatile sig_atomic_t shutdown_signal = 0;
 
-[[noreturn]] void handle_shutdown(int i) {
-    const char *signame = "unknown";
-    switch(i) {
-    case SIGINT:
-        signame = "SIGINT";
-        break;
-    case SIGHUP:
-        signame = "SIGHUP";
-        break;
-    default:
-        ;
-    }
-    fprintf(stderr, "caught signal %s, shutting down\n", signame);
-    fflush(outfile);
-    close(sock);
-    unlink(SOCKET_PATH);
-    exit(EXIT_SUCCESS);
+void handle_shutdown(int i) {
+    shutdown_signal = i;
 }
 
+// class ring_producer holds the ring of a process that uses
+// intercept_output_type=ring, along with its doorbell and a pidfd
+// that becomes readable when the process exits
+//
+class ring_producer {
+    pid_t pid;
+    void *mapping = MAP_FAILED;
+    size_t mapping_size = 0;
+    intercept_ring ring;
+    size_t records = 0;
+    bool corrupt = false;
+
+public:
+    int doorbell = -1;
+    int pidfd = -1;
+
+    ring_producer(pid_t producer_pid, uint64_t capacity, int memfd, int doorbell_fd) :
+        pid{producer_pid},
+        doorbell{doorbell_fd}
+    {
+        struct stat st;
+        if (!intercept_ring::is_valid_capacity(capacity)
+            || fstat(memfd, &st) == -1
+            || (uint64_t)st.st_size < intercept_ring::mapping_size(capacity)) {
+            return;
+        }
+        mapping_size = intercept_ring::mapping_size(capacity);
+        mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+        if (mapping == MAP_FAILED) {
+            return;
+        }
+        ring = intercept_ring{mapping, capacity, false};
+        pidfd = syscall(SYS_pidfd_open, pid, 0);  // -1 on kernels without pidfd_open
+    }
+
+    ~ring_producer() {
+        if (mapping != MAP_FAILED) {
+            munmap(mapping, mapping_size);
+        }
+        close(doorbell);
+        if (pidfd != -1) {
+            close(pidfd);
+        }
+    }
+
+    ring_producer(const ring_producer &) = delete;
+
+    ring_producer& operator=(const ring_producer &) = delete;
+
+    bool is_valid() const { return ring.is_valid() && !corrupt; }
+
+    // drain() writes up to max_records records from the ring to
+    // outfile, and returns the number written
+    //
+    size_t drain(FILE *outfile, size_t max_records) {
+        if (!is_valid()) {
+            return 0;
+        }
+        ssize_t count = ring.read([outfile](const char *record, size_t length) {
+                                      fwrite(record, 1, length, outfile);
+                                      fputc('\n', outfile);
+                                  },
+                                  max_records);
+        if (count < 0) {
+            fprintf(stderr, "error: ring of pid %d is corrupt, ignoring it\n", pid);
+            corrupt = true;
+            return 0;
+        }
+        records += count;
+        return count;
+    }
+
+    bool prepare_to_wait() {
+        return !is_valid() || ring.prepare_to_wait();
+    }
+
+    void report(FILE *f) const {
+        fprintf(f, "pid %d: %zu ring records, %lu dropped due to ring overflow\n",
+                pid, records, is_valid() ? (unsigned long)ring.drops() : 0UL);
+    }
+};
+
 int main(int argc, char *argv[]) {
 
-    signal(SIGINT, handle_shutdown);
-    signal(SIGHUP, handle_shutdown);
+    struct sigaction sa{};
+    sa.sa_handler = handle_shutdown;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGHUP, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
 
     // set output file from arguments
     //
@@ -83,19 +167,161 @@ int main(int argc, char *argv[]) {
         return EXIT_FAILURE;
     }
 
-    // process messages
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        fprintf(stderr, "error: %s: could not create epoll instance\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+    struct epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;   // the socket
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &event);
+
+    std::list<ring_producer> producers;
+
+    // remove_producer() drains the ring of a process that has
+    // exited, reports its counts, and discards it
     //
-    while (true) {
-        char buf[20*1024];
+    auto remove_producer = [&](std::list<ring_producer>::iterator p) {
+        while (p->drain(outfile, SIZE_MAX) > 0) { }
+        p->report(stderr);
+        producers.erase(p);
+    };
 
-        // read message from socket, then write to output
+    // process messages and rings
+    //
+    constexpr size_t batch_size = 1024;
+    std::vector<struct epoll_event> events(64);
+    while (shutdown_signal == 0) {
+
+        // drain a batch from each ring, round-robin; when they are
+        // all empty, tell each producer to ring its doorbell, and
+        // wait for events only if the rings are all still empty
         //
-        if (read(sock, buf, sizeof(buf)) < 0) {
-            fprintf(stderr, "error: %s: could not read from socket %s\n", strerror(errno), name.sun_path);
+        size_t drained = 0;
+        for (auto &p : producers) {
+            drained += p.drain(outfile, batch_size);
+        }
+        int timeout = 0;
+        if (drained == 0) {
+            bool all_empty = true;
+            for (auto &p : producers) {
+                all_empty &= p.prepare_to_wait();
+            }
+            if (all_empty) {
+                fflush(outfile);
+                timeout = -1;
+            }
+        }
+
+        int num_events = epoll_wait(epoll_fd, events.data(), events.size(), timeout);
+        if (num_events < 0) {
+            if (errno != EINTR) {
+                fprintf(stderr, "error: %s: epoll_wait() failed\n", strerror(errno));
+            }
+            continue;
         }
-        fprintf(outfile, "%s\n", buf);
+        for (int i = 0; i < num_events; i++) {
+            if (events[i].data.ptr != nullptr) {
+
+                // a doorbell rang, or a producer exited
+                //
+                uintptr_t tag = (uintptr_t)events[i].data.ptr;
+                ring_producer *producer = (ring_producer *)(tag & ~(uintptr_t)1);
+                auto p = std::find_if(producers.begin(), producers.end(), [producer](const ring_producer &x) { return &x == producer; });
+                if (p == producers.end()) {
+                    continue;  // removed while handling an earlier event
+                }
+                if (tag & 1) {
+                    remove_producer(p);
+                } else {
+                    eventfd_t value;
+                    eventfd_read(p->doorbell, &value);
+                }
+                continue;
+            }
+
+            // read messages from socket until there are no more,
+            // along with a ring and doorbell if a process sends them,
+            // then write to output
+            //
+            while (true) {
+                char buf[20*1024];
+                union {
+                    char buf[CMSG_SPACE(2 * sizeof(int))];
+                    struct cmsghdr align;
+                } control;
+                struct iovec iov = { buf, sizeof(buf) - 1 };
+                struct msghdr msg{};
+                msg.msg_iov = &iov;
+                msg.msg_iovlen = 1;
+                msg.msg_control = control.buf;
+                msg.msg_controllen = sizeof(control.buf);
+                ssize_t length = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+                if (length < 0) {
+                    if (errno != EAGAIN && errno != EINTR) {
+                        fprintf(stderr, "error: %s: could not read from socket %s\n", strerror(errno), name.sun_path);
+                    }
+                    break;
+                }
+                struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+                if (cmsg != nullptr && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                    int fds[2] = { -1, -1 };
+                    size_t num_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                    memcpy(fds, CMSG_DATA(cmsg), std::min(num_fds, (size_t)2) * sizeof(int));
+                    const intercept_ring_hello *hello = (const intercept_ring_hello *)buf;
+                    if (num_fds != 2 || (size_t)length != sizeof(*hello) || !hello->is_valid()) {
+                        fprintf(stderr, "error: ignoring invalid ring message\n");
+                        for (size_t j = 0; j < std::min(num_fds, (size_t)2); j++) {
+                            close(fds[j]);
+                        }
+                        continue;
+                    }
+                    ring_producer &p = producers.emplace_back(hello->pid, hello->capacity, fds[0], fds[1]);
+                    close(fds[0]);
+                    if (!p.is_valid()) {
+                        fprintf(stderr, "error: ignoring invalid ring from pid %lu\n", (unsigned long)hello->pid);
+                        producers.pop_back();
+                        continue;
+                    }
+                    event.events = EPOLLIN;
+                    event.data.ptr = &p;
+                    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, p.doorbell, &event);
+                    if (p.pidfd != -1) {
+                        event.data.ptr = (void *)((uintptr_t)&p | 1);
+                        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, p.pidfd, &event);
+                    }
+                    continue;
+                }
+                buf[length] = '\0';
+                fprintf(outfile, "%s\n", buf);
+            }
+        }
+    }
+
+    // shut down, after draining and reporting on all rings
+    //
+    const char *signame = "unknown";
+    switch(shutdown_signal) {
+    case SIGINT:
+        signame = "SIGINT";
+        break;
+    case SIGHUP:
+        signame = "SIGHUP";
+        break;
+    case SIGTERM:
+        signame = "SIGTERM";
+        break;
+    default:
+        ;
+    }
+    fprintf(stderr, "caught signal %s, shutting down\n", signame);
+    while (!producers.empty()) {
+        remove_producer(producers.begin());
     }
-    handle_shutdown(0);
+    fflush(outfile);
+    close(sock);
+    unlink(SOCKET_PATH);
 
     return 0;
 }
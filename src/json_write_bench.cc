@@ -0,0 +1,116 @@
+// json_write_bench.cc
+//
+// per-record benchmark for JSON output: processes the packets in one
+// or more capture files with mercury_packet_processor_write_json(),
+// repeatedly, and reports the time taken per packet and per JSON
+// record, and the number of JSON bytes written per second.  The
+// packets are read into memory before timing starts, so that file
+// I/O is not measured.
+//
+// usage: json_write_bench [--iterations n] [--metadata] pcap_file...
+//
+// e.g. json_write_bench ../test/data/top-https.mcap
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include <string>
+#include "pcap.h"
+#include "libmerc/libmerc.h"
+
+int main(int argc, char *argv[]) {
+
+    size_t iterations = 20;
+    bool metadata = false;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--metadata") == 0) {
+            metadata = true;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        fprintf(stderr, "usage: %s [--iterations n] [--metadata] pcap_file...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::vector<uint8_t>> packets;
+    try {
+        for (const char *f : files) {
+            pcap::file_reader pcap{f};
+            while (true) {
+                std::pair<const uint8_t *, const uint8_t *> pkt = pcap.read_packet();
+                if (pkt.first == nullptr) {
+                    break;
+                }
+                packets.emplace_back(pkt.first, pkt.second);
+            }
+        }
+    }
+    catch (std::exception &e) {
+        fprintf(stderr, "error: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    libmerc_config config;
+    config.metadata_output = metadata;
+    config.dns_json_output = metadata;
+    config.certs_json_output = metadata;
+    mercury_context mc = mercury_init(&config, 0);
+    if (mc == nullptr) {
+        fprintf(stderr, "error: mercury_init() failed\n");
+        return EXIT_FAILURE;
+    }
+    mercury_packet_processor mpp = mercury_packet_processor_construct(mc);
+    if (mpp == nullptr) {
+        fprintf(stderr, "error: mercury_packet_processor_construct() failed\n");
+        return EXIT_FAILURE;
+    }
+
+    // each pass uses fresh timestamps, so that flows are not treated
+    // as duplicates of those in a previous pass
+    //
+    std::vector<char> buffer(65536);
+    size_t records = 0;
+    size_t bytes = 0;
+    struct timespec ts{1634846862, 105263000};
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        for (auto &p : packets) {
+            ts.tv_nsec += 1000;
+            if (ts.tv_nsec >= 1000000000) {
+                ts.tv_sec++;
+                ts.tv_nsec -= 1000000000;
+            }
+            size_t length = mercury_packet_processor_write_json(mpp, buffer.data(), buffer.size(), p.data(), p.size(), &ts);
+            if (length != 0) {
+                records++;
+                bytes += length;
+            }
+        }
+        ts.tv_sec += 3600;
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+
+    size_t num_packets = packets.size() * iterations;
+    fprintf(stdout, "packets:            %zu\n", num_packets);
+    fprintf(stdout, "records:            %zu\n", records);
+    fprintf(stdout, "json bytes:         %zu\n", bytes);
+    fprintf(stdout, "ns per packet:      %.1f\n", ns / num_packets);
+    if (records) {
+        fprintf(stdout, "ns per record:      %.1f\n", ns / records);
+        fprintf(stdout, "bytes per record:   %.1f\n", (double)bytes / records);
+    }
+    fprintf(stdout, "json MB per second: %.1f\n", bytes / ns * 1e3);
+
+    mercury_packet_processor_destruct(mpp);
+    mercury_finalize(mc);
+
+    return 0;
+}
@@ -124,6 +124,19 @@ void flow_key_sprintf_dst_addr(const struct key &key,
     }
 }
 
+uint8_t flow_key_get_dst_addr(const struct key &key,
+                              uint8_t *dst_addr) {
+
+    if (key.ip_vers == 4) {
+        memcpy(dst_addr, &key.addr.ipv4.dst, 4);
+        return 4;
+    } else if (key.ip_vers == 6) {
+        memcpy(dst_addr, &key.addr.ipv6.dst, 16);
+        return 6;
+    }
+    return 0;
+}
+
 uint16_t flow_key_get_dst_port(const struct key &key) {
     return ntoh(key.dst_port);
 }
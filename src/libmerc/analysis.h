@@ -34,6 +34,7 @@
 #include "archive.h"
 #include "watchlist.hpp"
 #include "static_dict.hpp"
+#include "fingerprint_index.hpp"
 
 // TBD - move flow_key_sprintf_src_addr() to the right file
 //
@@ -588,8 +589,13 @@ public:
         return server_name;
     }
 
+    // perform_analysis() checks the destination against the
+    // encrypted dns watchlist using dst_addr, if dst_ip_vers is 4 or
+    // 6, and otherwise using the address string dst_ip
+    //
     struct analysis_result perform_analysis(const char *server_name, const char *dst_ip, uint16_t dst_port,
-                                            const char *user_agent, enum fingerprint_status status) {
+                                            const char *user_agent, enum fingerprint_status status,
+                                            uint8_t dst_ip_vers=0, const uint8_t *dst_addr=nullptr) {
 
         uint32_t asn_int = subnet_data_ptr->get_asn_info(dst_ip);
         std::string domain = get_tld_domain_name(server_name);
@@ -659,7 +665,11 @@ public:
         // check encrypted dns watchlist
         //
         attribute_result::bitset attr_tags = attr[index_max];
-        if (common->doh_watchlist.contains(server_name) || common->doh_watchlist.contains_addr(dst_ip)) {
+        bool on_doh_watchlist = common->doh_watchlist.contains(server_name);
+        if (!on_doh_watchlist) {
+            on_doh_watchlist = dst_ip_vers ? common->doh_watchlist.contains_addr(dst_ip_vers, dst_addr) : common->doh_watchlist.contains_addr(dst_ip);
+        }
+        if (on_doh_watchlist) {
             attr_tags[common->doh_idx] = true;
             attr_prob[common->doh_idx] = 1.0;
         }
@@ -783,6 +793,12 @@ class classifier {
 
     bool disabled = false;   // if the classfier has not been initialised or disabled
 
+    // nearest_index holds the TLS and QUIC fingerprints in fpdb, if
+    // build_nearest_fingerprint_index() has been called, so that the
+    // nearest known fingerprint can be reported for unknown ones
+    //
+    std::unique_ptr<fingerprint_index> nearest_index;
+
 public:
 
     static fingerprint_type get_fingerprint_type(const std::string &s) {
@@ -835,6 +851,23 @@ public:
 
     bool is_disabled() const { return disabled; }
 
+    // build_nearest_fingerprint_index() indexes the TLS and QUIC
+    // fingerprints in the fingerprint database, other than the
+    // randomized ones; the index refers to the keys of fpdb, which is
+    // not modified after the classifier is constructed
+    //
+    void build_nearest_fingerprint_index() {
+        nearest_index = std::make_unique<fingerprint_index>();
+        for (const auto &fpdb_entry : fpdb) {
+            const std::string &fp_string = fpdb_entry.first;
+            if ((fp_string.compare(0, 3, "tls") == 0 || fp_string.compare(0, 4, "quic") == 0)
+                && fp_string.find("randomized") == std::string::npos) {
+                nearest_index->add(fp_string);
+            }
+        }
+        printf_err(log_info, "indexed %zu fingerprints for nearest-fingerprint reporting\n", nearest_index->size());
+    }
+
     static std::pair<fingerprint_type, size_t> get_fingerprint_type_and_version(const std::string &s) {
         fingerprint_type type = fingerprint_type_unknown;
         unsigned int version = 0;
@@ -1399,7 +1432,8 @@ public:
     }
 
     struct analysis_result perform_analysis(const char *fp_str, const char *server_name, const char *dst_ip,
-                                            uint16_t dst_port, const char *user_agent) {
+                                            uint16_t dst_port, const char *user_agent,
+                                            uint8_t dst_ip_vers=0, const uint8_t *dst_addr=nullptr) {
 
         // fp_stats.observe(fp_str, server_name, dst_ip, dst_port); // TBD - decide where this call should go
 
@@ -1428,12 +1462,12 @@ public:
                     return analysis_result(fingerprint_status_randomized);  // TODO: does this actually happen?
                 }
                 fingerprint_data *fp_data = fpdb_entry_randomized->second;
-                return fp_data->perform_analysis(server_name, dst_ip, dst_port, user_agent, fingerprint_status_randomized);
+                return fp_data->perform_analysis(server_name, dst_ip, dst_port, user_agent, fingerprint_status_randomized, dst_ip_vers, dst_addr);
             }
         }
         fingerprint_data *fp_data = fpdb_entry->second;
 
-        return fp_data->perform_analysis(server_name, dst_ip, dst_port, user_agent, fingerprint_status_labeled);
+        return fp_data->perform_analysis(server_name, dst_ip, dst_port, user_agent, fingerprint_status_labeled, dst_ip_vers, dst_addr);
     }
 
     /*
@@ -1499,7 +1533,7 @@ public:
             result = analysis_result(fingerprint_status_unanalyzed);
             return true;  // not configured to analyze fingerprints of this type
         }
-        result = this->perform_analysis(fp.string(), dc.sn_str, dc.dst_ip_str, dc.dst_port, dc.ua_str);
+        result = this->perform_analysis(fp.string(), dc.sn_str, dc.dst_ip_str, dc.dst_port, dc.ua_str, dc.dst_ip_vers, dc.dst_addr);
 
         // check for encrypted_channel
         //
@@ -1510,6 +1544,24 @@ public:
         return true;
     }
 
+    // set_nearest_fingerprint() reports, in result, the known
+    // fingerprint nearest to fp, if there is a nearest-fingerprint
+    // index and result is the analysis of a fingerprint that is not in
+    // the fingerprint database.  The lookup is made through cache,
+    // which belongs to the calling thread; sec is the packet time.
+    //
+    void set_nearest_fingerprint(const fingerprint &fp, analysis_result &result, nearest_fingerprint_cache &cache, time_t sec) const {
+        if (nearest_index == nullptr
+            || fp.is_null()
+            || result.status == fingerprint_status_labeled
+            || result.status == fingerprint_status_unanalyzed) {
+            return;
+        }
+        fingerprint_index::match m = cache.nearest(*nearest_index, fp.string(), sec);
+        result.nearest = m.fingerprint;
+        result.nearest_similarity = m.similarity;
+    }
+
     const char *get_resource_version() {
         return resource_version.c_str();
     }
@@ -16,6 +16,9 @@ void fprintf_json_string_escaped(struct buffer_stream &buf, const char *key, con
 
     buf.snprintf("\"%s\":\"", key);
     while (x < end) {
+        if (buf.write_json_clean_prefix(x, end)) {
+            continue;                      /* x is past a run of printable characters */
+        }
         if (*x < 0x20) {                   /* escape control characters   */
             buf.snprintf("\\u%04x", *x);
         } else if (*x >= 0x80) {           /* escape non-ASCII characters */
@@ -0,0 +1,10 @@
+// oid.cc
+//
+// this file autogenerated by ../oidc at Oct 19 2026 01:34:53
+// you should edit the source file(s) instead of this file
+//
+
+#include "oid.h"
+
+// the OID table is defined in oid.h, so that it is a compile-time
+// constant that needs no initialization at run time
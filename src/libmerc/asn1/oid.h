@@ -0,0 +1,1871 @@
+// oid.h
+//
+// this file autogenerated by ../oidc at Oct 19 2026 01:34:53
+// you should edit the source file(s) instead of this file
+//
+
+#ifndef OID_H
+#define OID_H
+
+#include "../datum.h"
+#include <cstring>
+#include <stdint.h>
+
+class oid {
+public:
+
+enum type : uint32_t {
+	unknown = 0,
+	ETSI_EV_CPS = 1,
+	ETSI_EV_CPS_1_ = 2,
+	user_id = 3,
+	domain_component = 4,
+	ISO = 5,
+	A_Trust_EV_CPS = 6,
+	China = 7,
+	OSCCA = 8,
+	GM_Standard_Committee = 9,
+	Cryptographic_Algorithm = 10,
+	Block_Cipher = 11,
+	SM1_Block_Cipher = 12,
+	SSF33_Block_Cipher = 13,
+	SM4_Block_Cipher = 14,
+	Stream_Cipher = 15,
+	ZUC_Stream_Cipher = 16,
+	Public_Key_Cryptography = 17,
+	SM2_Elliptic_Curve_Cryptography = 18,
+	SM2_1_Digital_Siganture_Algorithm = 19,
+	SM2_2_Key_Exchange_Protocol = 20,
+	SM2_3_Public_Key_Encryption = 21,
+	SM9_Identity_Based_Cryptography = 22,
+	SM9_1_Digital_Signature_Algorithm = 23,
+	SM9_2_Key_Exchange_Protocol = 24,
+	SM9_3_Public_Key_Encryptio = 25,
+	Hash_Algorithm = 26,
+	SM3_Hash_Algorithm = 27,
+	SM3_Hash_Without_Key = 28,
+	SM3_Hash_With_Key = 29,
+	Digest_Signing = 30,
+	SM2_Signing_with_SM3 = 31,
+	RSA_Signing_with_SM3 = 32,
+	Certificate_Authority = 33,
+	Standard_Class = 34,
+	Fundatation_Class = 35,
+	Algorithm_Class = 36,
+	ZUC_Standard = 37,
+	SM4_Standard = 38,
+	SM2_Standard = 39,
+	SM3_Standard = 40,
+	ID_Class = 41,
+	Crypto_ID = 42,
+	Operation_Modes = 43,
+	Security_Mechanism = 44,
+	SM2_Specificate = 45,
+	SM2_Cryptographic_Message_Syntax = 46,
+	Device_Class = 47,
+	Service_Class = 48,
+	Infrastructure = 49,
+	Testing_Class = 50,
+	Random_Testing_Class = 51,
+	Management_Class = 52,
+	SHECA_EV_CPS = 53,
+	SECOM_Trust_Systems_EV_CPS = 54,
+	id_tc26_gost3410_12_256 = 55,
+	id_tc26_gost3410_12_512 = 56,
+	id_tc26_digest_gost3411_12_256 = 57,
+	id_tc26_digest_gost3411_12_512 = 58,
+	id_tc26_signwithdigest_gost3410_12_256 = 59,
+	id_tc26_signwithdigest_gost3410_12_512 = 60,
+	ecdsa_with_SHA256_1_ = 61,
+	id_dsa = 62,
+	id_dsa_with_sha1 = 63,
+	ansi_X9_62 = 64,
+	id_fieldType = 65,
+	prime_field = 66,
+	characteristic_two_field = 67,
+	id_characteristic_two_basis = 68,
+	gnBasis = 69,
+	tpBasis = 70,
+	ppBasis = 71,
+	id_publicKeyType = 72,
+	id_ecPublicKey = 73,
+	ellipticCurve = 74,
+	c_TwoCurve = 75,
+	c2pnb163v1 = 76,
+	c2pnb163v2 = 77,
+	c2pnb163v3 = 78,
+	c2pnb176w1 = 79,
+	c2tnb191v1 = 80,
+	c2tnb191v2 = 81,
+	c2tnb191v3 = 82,
+	c2onb191v4 = 83,
+	c2onb191v5 = 84,
+	c2pnb208w1 = 85,
+	c2tnb239v1 = 86,
+	c2tnb239v2 = 87,
+	c2tnb239v3 = 88,
+	c2onb239v4 = 89,
+	c2onb239v5 = 90,
+	c2pnb272w1 = 91,
+	c2pnb304w1 = 92,
+	c2tnb359v1 = 93,
+	c2pnb368w1 = 94,
+	c2tnb431r1 = 95,
+	primeCurve = 96,
+	prime192v1 = 97,
+	prime192v2 = 98,
+	prime192v3 = 99,
+	prime239v1 = 100,
+	prime239v2 = 101,
+	prime239v3 = 102,
+	prime256v1 = 103,
+	brainpoolP256t1 = 104,
+	brainpoolP320r1 = 105,
+	brainpoolP320t1 = 106,
+	brainpoolP384r1 = 107,
+	brainpoolP384t1 = 108,
+	brainpoolP512r1 = 109,
+	brainpoolP512t1 = 110,
+	sect163r1 = 111,
+	sect239k1 = 112,
+	secp256k1 = 113,
+	sect163r2_1_ = 114,
+	sect283k1_1_ = 115,
+	sect283r1_1_ = 116,
+	sect233k1_1_ = 117,
+	sect233r1_1_ = 118,
+	secp192k1 = 119,
+	secp224k1 = 120,
+	secp224r1_1_ = 121,
+	secp384r1_1_ = 122,
+	secp521r1_1_ = 123,
+	sect409k1_1_ = 124,
+	sect409r1_1_ = 125,
+	sect571k1_1_ = 126,
+	sect571r1_1_ = 127,
+	id_ecSigType = 128,
+	ecdsa_with_SHA1 = 129,
+	ecdsa_with_SHA224 = 130,
+	ecdsa_with_SHA256 = 131,
+	ecdsa_with_SHA384 = 132,
+	ecdsa_with_SHA512 = 133,
+	dhpublicnumber = 134,
+	email_address = 135,
+	rsaEncryption = 136,
+	md2WithRSAEncryption = 137,
+	md5WithRSAEncryption = 138,
+	sha1WithRSAEncryption = 139,
+	id_RSAES_OAEP = 140,
+	id_mgf1 = 141,
+	id_pSpecified = 142,
+	id_RSASSA_PSS = 143,
+	sha256WithRSAEncryption = 144,
+	sha384WithRSAEncryption = 145,
+	sha512WithRSAEncryption = 146,
+	sha224WithRSAEncryption = 147,
+	sha512_224WithRSAEncryption = 148,
+	sha512_256WithRSAEncryption = 149,
+	pkcs_9 = 150,
+	pkcs_9_mo = 151,
+	emailAddress = 152,
+	pkcs_9_at_unstructuredName = 153,
+	pkcs_9_at_contentType = 154,
+	pkcs_9_at_messageDigest = 155,
+	pkcs_9_at_signingTime = 156,
+	pkcs_9_at_counterSignature = 157,
+	pkcs_9_at_challengePassword = 158,
+	pkcs_9_at_unstructuredAddress = 159,
+	pkcs_9_at_extendedCertificateAttributes = 160,
+	pkcs_9_at_signingDescription = 161,
+	pkcs_9_at_extensionRequest = 162,
+	pkcs_9_at_smimeCapabilities = 163,
+	smime = 164,
+	id_aa = 165,
+	id_aa_cmc_unsignedData = 166,
+	pkcs_9_at_friendlyName = 167,
+	pkcs_9_at_localKeyId = 168,
+	certTypes = 169,
+	crlTypes = 170,
+	pkcs_9_oc = 171,
+	pkcs_9_oc_pkcsEntity = 172,
+	pkcs_9_oc_naturalPerson = 173,
+	pkcs_9_at = 174,
+	pkcs_9_at_pkcs15Token = 175,
+	pkcs_9_at_encryptedPrivateKeyInfo = 176,
+	pkcs_9_at_randomNonce = 177,
+	pkcs_9_at_sequenceNumber = 178,
+	pkcs_9_at_pkcs7PDU = 179,
+	pkcs_9_sx = 180,
+	pkcs_9_sx_pkcs9String = 181,
+	pkcs_9_sx_signingTime = 182,
+	pkcs_9_mr = 183,
+	pkcs_9_mr_caseIgnoreMatch = 184,
+	pkcs_9_mr_signingTimeMatch = 185,
+	md2 = 186,
+	md5 = 187,
+	id_md5 = 188,
+	Cisco_ACT2_SUDI = 189,
+	SPC_INDIRECT_DATA_OBJID = 190,
+	SPC_SP_AGENCY_INFO_OBJID = 191,
+	SPC_STATEMENT_TYPE_OBJID = 192,
+	SPC_SP_OPUS_INFO_OBJID = 193,
+	SPC_CERT_EXTENSIONS_OBJID = 194,
+	SPC_PE_IMAGE_DATA_OBJID = 195,
+	SPC_RAW_FILE_DATA_OBJID = 196,
+	SPC_STRUCTURED_STORAGE_DATA_OBJID = 197,
+	SPC_JAVA_CLASS_DATA_OBJID = 198,
+	SPC_INDIVIDUAL_SP_KEY_PURPOSE_OBJID = 199,
+	SPC_COMMERCIAL_SP_KEY_PURPOSE_OBJID = 200,
+	SPC_CAB_DATA_OBJID = 201,
+	SPC_MINIMAL_CRITERIA_OBJID = 202,
+	SPC_FINANCIAL_CRITERIA_OBJID = 203,
+	SPC_LINK_OBJID = 204,
+	SPC_HASH_INFO_OBJID = 205,
+	SPC_SIPINFO_OBJID = 206,
+	szOID_TRUSTED_CODESIGNING_CA_LIST = 207,
+	szOID_TRUSTED_CLIENT_AUTH_CA_LIST = 208,
+	szOID_TRUSTED_SERVER_AUTH_CA_LIST = 209,
+	SPC_TIME_STAMP_REQUEST_OBJID = 210,
+	OID_CTL = 211,
+	szOID_SORTED_CTL = 212,
+	szOID_NEXT_UPDATE_LOCATION = 213,
+	szOID_KP_CTL_USAGE_SIGNING = 214,
+	szOID_KP_TIME_STAMP_SIGNING = 215,
+	szOID_SERVER_GATED_CRYPTO = 216,
+	szOID_SERIALIZED = 217,
+	szOID_EFS_CRYPTO = 218,
+	szOID_EFS_RECOVERY = 219,
+	szOID_WHQL_CRYPTO = 220,
+	szOID_NT5_CRYPTO = 221,
+	szOID_OEM_WHQL_CRYPTO = 222,
+	szOID_EMBEDDED_NT_CRYPTO = 223,
+	OID_ROOT_LIST_SIGNER = 224,
+	szOID_KP_QUALIFIED_SUBORDINATION = 225,
+	szOID_KP_KEY_RECOVERY = 226,
+	szOID_KP_DOCUMENT_SIGNING = 227,
+	szOID_KP_LIFETIME_SIGNING = 228,
+	szOID_KP_MOBILE_DEVICE_SOFTWARE = 229,
+	szOID_YESNO_TRUST_ATTR = 230,
+	szOID_DRM = 231,
+	szOID_DRM_INDIVIDUALIZATION = 232,
+	szOID_LICENSES = 233,
+	szOID_LICENSE_SERVER = 234,
+	szOID_MICROSOFT_RDN_PREFIX = 235,
+	szOID_KEYID_RDN = 236,
+	szOID_REMOVE_CERTIFICATE = 237,
+	szOID_CROSS_CERT_DIST_POINTS = 238,
+	szOID_CMC_ADD_ATTRIBUTES = 239,
+	szOID_CERT_PROP_ID_PREFIX = 240,
+	OID_CERT_PROP_ID_METAEKUS = 241,
+	CERT_FRIENDLY_NAME_PROP_ID = 242,
+	OID_CERT_KEY_IDENTIFIER_PROP_ID = 243,
+	OID_CERT_SUBJECT_NAME_MD5_HASH_PROP_ID = 244,
+	CERT_ROOT_PROGRAM_CERT_POLICIES_PROP_ID = 245,
+	OID_CERT_PROP_ID_PREFIX_98 = 246,
+	OID_CERT_PROP_ID_PREFIX_105 = 247,
+	szOID_ANY_APPLICATION_POLICY = 248,
+	szOID_CATALOG_LIST = 249,
+	szOID_CATALOG_LIST_MEMBER = 250,
+	CAT_NAMEVALUE_OBJID = 251,
+	CAT_MEMBERINFO_OBJID = 252,
+	szOID_RENEWAL_CERTIFICATE = 253,
+	szOID_ENROLLMENT_NAME_VALUE_PAIR = 254,
+	szOID_ENROLLMENT_CSP_PROVIDER = 255,
+	szOID_OS_VERSION = 256,
+	szOID_MICROSOFT_Encryption_Key_Preference = 257,
+	szOID_LOCAL_MACHINE_KEYSET = 258,
+	szOID_PKIX_LICENSE_INFO = 259,
+	szOID_PKIX_MANUFACTURER = 260,
+	szOID_PKIX_MANUFACTURER_MS_SPECIFIC = 261,
+	szOID_PKIX_HYDRA_CERT_VERSION = 262,
+	szOID_PKIX_LICENSED_PRODUCT_INFO = 263,
+	szOID_PKIX_MS_LICENSE_SERVER_INFO = 264,
+	szOID_PKIS_PRODUCT_SPECIFIC_OID = 265,
+	szOID_PKIS_TLSERVER_SPK_OID = 266,
+	szOID_AUTO_ENROLL_CTL_USAGE = 267,
+	szOID_ENROLL_CERTTYPE_EXTENSION = 268,
+	szOID_ENROLLMENT_AGENT = 269,
+	szOID_KP_SMARTCARD_LOGON = 270,
+	szOID_NT_PRINCIPAL_NAME = 271,
+	szOID_CERT_MANIFOLD = 272,
+	szOID_CERTSRV_CA_VERSION = 273,
+	szOID_CERTSRV_PREVIOUS_CERT_HASH = 274,
+	szOID_CRL_VIRTUAL_BASE = 275,
+	szOID_CRL_NEXT_PUBLISH = 276,
+	szOID_KP_CA_EXCHANGE = 277,
+	szOID_KP_KEY_RECOVERY_AGENT = 278,
+	szOID_CERTIFICATE_TEMPLATE = 279,
+	szOID_ENTERPRISE_OID_ROOT = 280,
+	szOID_RDN_DUMMY_SIGNER = 281,
+	szOID_APPLICATION_CERT_POLICIES = 282,
+	szOID_APPLICATION_POLICY_MAPPINGS = 283,
+	szOID_APPLICATION_POLICY_CONSTRAINTS = 284,
+	szOID_ARCHIVED_KEY_ATTR = 285,
+	szOID_CRL_SELF_CDP = 286,
+	szOID_REQUIRE_CERT_CHAIN_POLICY = 287,
+	szOID_ARCHIVED_KEY_CERT_HASH = 288,
+	szOID_ISSUED_CERT_HASH = 289,
+	szOID_DS_EMAIL_REPLICATION = 290,
+	szOID_REQUEST_CLIENT_INFO = 291,
+	szOID_ENCRYPTED_KEY_HASH = 292,
+	szOID_CERTSRV_CROSSCA_VERSION = 293,
+	szOID_NTDS_REPLICATION = 294,
+	szOID_IIS_VIRTUAL_SERVER = 295,
+	szOID_PRODUCT_UPDATE = 296,
+	szOID_PEERNET_CERT_TYPE = 297,
+	szOID_PEERNET_PEERNAME = 298,
+	szOID_PEERNET_CLASSIFIER = 299,
+	szOID_PEERNET_CERT_VERSION = 300,
+	szOID_PEERNET_PNRP = 301,
+	szOID_PEERNET_PNRP_ADDRESS = 302,
+	szOID_PEERNET_PNRP_FLAGS = 303,
+	szOID_PEERNET_PNRP_PAYLOAD = 304,
+	szOID_PEERNET_PNRP_ID = 305,
+	szOID_PEERNET_IDENTITY = 306,
+	szOID_PEERNET_IDENTITY_FLAGS = 307,
+	szOID_PEERNET_GROUPING = 308,
+	szOID_PEERNET_GROUPING_PEERNAME = 309,
+	szOID_PEERNET_GROUPING_FLAGS = 310,
+	szOID_PEERNET_GROUPING_ROLES = 311,
+	szOID_PEERNET_GROUPING_CLASSIFIERS = 312,
+	OID_ROOT_PROGRAM_FLAGS_BITSTRING = 313,
+	jurisdiction_of_incorporation_locality_name = 314,
+	jurisdiction_of_incorporation_state_or_province_name = 315,
+	jurisdiction_of_incorporation_country_name = 316,
+	driveEncryption = 317,
+	szOID_CAPICOM = 318,
+	szOID_CAPICOM_VERSION = 319,
+	szOID_CAPICOM_ATTRIBUTE = 320,
+	szOID_CAPICOM_DOCUMENT_NAME = 321,
+	szOID_CAPICOM_DOCUMENT_DESCRIPTION = 322,
+	szOID_CAPICOM_ENCRYPTED_DATA = 323,
+	szOID_CAPICOM_ENCRYPTED_CONTENT = 324,
+	Network_Solutions__EV_CPS = 325,
+	GlobalSign_EV_CPS = 326,
+	D_TRUST_EV_CPS = 327,
+	Verizon_Business_EV_CPS = 328,
+	Comodo_Group_EV_CPS = 329,
+	T_Systems_EV_CPS = 330,
+	QuoVadis_EV_CPS = 331,
+	id_ce_SignedCertificateTimestampList = 332,
+	id_ad_ocsp_SignedCertificateTimestampList = 333,
+	Firmaprofesional_EV_CPS = 334,
+	GeoTrust_EV_CPS = 335,
+	Izenpe_EV_CPS = 336,
+	Camerfirma_EV_CPS_1_ = 337,
+	Camerfirma_EV_CPS = 338,
+	OpenTrust_DocuSign_France_EV_CPS = 339,
+	StartCom_Certification_Authority_EV_CPS_1_ = 340,
+	StartCom_Certification_Authority_EV_CPS = 341,
+	AffirmTrust_EV_CPS = 342,
+	AffirmTrust_EV_CPS_1_ = 343,
+	AffirmTrust_EV_CPS_2_ = 344,
+	AffirmTrust_EV_CPS_3_ = 345,
+	WoSign_EV_CPS = 346,
+	id_pkix = 347,
+	id_pe = 348,
+	id_pe_authorityInfoAccess = 349,
+	id_pe_biometricInfo = 350,
+	id_pe_qcStatements = 351,
+	id_pe_subjectInfoAccess = 352,
+	id_pe_logotype = 353,
+	id_qt = 354,
+	id_qt_cps = 355,
+	id_qt_unotice = 356,
+	id_kp = 357,
+	id_kp_serverAuth = 358,
+	id_kp_clientAuth = 359,
+	id_kp_codeSigning = 360,
+	id_kp_emailProtection = 361,
+	id_kp_ipsecEndSystem = 362,
+	id_kp_ipsecTunnel = 363,
+	id_kp_ipsecUser = 364,
+	id_kp_timeStamping = 365,
+	id_kp_OCSPSigning = 366,
+	id_kp_cmcCA = 367,
+	id_kp_cmcRA = 368,
+	id_alg_noSignature = 369,
+	id_RSASSA_PSS_SHAKE128 = 370,
+	id_RSASSA_PSS_SHAKE256 = 371,
+	id_ecdsa_with_shake128 = 372,
+	id_ecdsa_with_shake256 = 373,
+	id_cmc = 374,
+	id_cmc_statusInfo = 375,
+	id_cmc_identification = 376,
+	id_cmc_identityProof = 377,
+	id_cmc_dataReturn = 378,
+	id_cmc_transactionId = 379,
+	id_cmc_senderNonce = 380,
+	id_cmc_recipientNonce = 381,
+	id_cmc_addExtensions = 382,
+	id_cmc_encryptedPOP = 383,
+	id_cmc_decryptedPOP = 384,
+	id_cmc_lraPOPWitness = 385,
+	id_cmc_getCert = 386,
+	id_cmc_getCRL = 387,
+	id_cmc_revokeRequest = 388,
+	id_cmc_regInfo = 389,
+	id_cmc_responseInfo = 390,
+	id_cmc_queryPending = 391,
+	id_cmc_popLinkRandom = 392,
+	id_cmc_popLinkWitness = 393,
+	id_cmc_confirmCertAcceptance = 394,
+	id_cmc_statusInfoV2 = 395,
+	id_cmc_trustedAnchors = 396,
+	id_cmc_authData = 397,
+	id_cmc_batchRequests = 398,
+	id_cmc_batchResponses = 399,
+	id_cmc_publishCert = 400,
+	id_cmc_modCertTemplate = 401,
+	id_cmc_controlProcessed = 402,
+	id_cmc_popLinkWitnessV2 = 403,
+	id_cmc_identityProofV2 = 404,
+	id_cmc_raIdentityWitness = 405,
+	id_cmc_changeSubjectName = 406,
+	id_cmc_responseBody = 407,
+	id_on = 408,
+	id_on_SmtpUTF8Mailbox = 409,
+	ietf_at = 410,
+	pkcs_9_at_dateOfBirth = 411,
+	pkcs_9_at_placeOfBirth = 412,
+	pkcs_9_at_gender = 413,
+	pkcs_9_at_countryOfCitizenship = 414,
+	pkcs_9_at_countryOfResidence = 415,
+	id_qcs = 416,
+	id_qcs_pkixQCSyntax_v1 = 417,
+	id_qcs_pkixQCSyntax_v2 = 418,
+	id_cct = 419,
+	id_cct_PKIData = 420,
+	id_cct_PKIResponse = 421,
+	id_logo = 422,
+	id_logo_loyalty = 423,
+	id_logo_background = 424,
+	id_ad = 425,
+	id_ad_ocsp = 426,
+	id_pkix_ocsp_basic = 427,
+	id_pkix_ocsp_nonce = 428,
+	id_pkix_ocsp_crl = 429,
+	id_pkix_ocsp_response = 430,
+	id_pkix_ocsp_nocheck = 431,
+	id_pkix_ocsp_archive_cutoff = 432,
+	id_pkix_ocsp_service_locator = 433,
+	id_pkix_ocsp_pref_sig_algs = 434,
+	id_pkix_ocsp_extended_revoke = 435,
+	id_ad_caIssuers = 436,
+	id_ad_timeStamping = 437,
+	id_ad_caRepository = 438,
+	id_ad_cmc = 439,
+	id_sha_with_rsa_signature = 440,
+	id_sha1 = 441,
+	sha_1WithRSAEncryption = 442,
+	ecStdCurvesAndGeneration = 443,
+	ellipticCurve_1_ = 444,
+	id_edwards_curve_algs = 445,
+	id_X25519 = 446,
+	id_X448 = 447,
+	id_Ed25519 = 448,
+	id_Ed448 = 449,
+	certicom_arc = 450,
+	ellipticCurve_2_ = 451,
+	sect163k1 = 452,
+	sect163r2 = 453,
+	sect283k1 = 454,
+	sect283r1 = 455,
+	sect233k1 = 456,
+	sect233r1 = 457,
+	secp224r1 = 458,
+	secp384r1 = 459,
+	secp521r1 = 460,
+	sect409k1 = 461,
+	sect409r1 = 462,
+	sect571k1 = 463,
+	sect571r1 = 464,
+	id_ecDH = 465,
+	id_ecMQV = 466,
+	Actalis_EV_CPS = 467,
+	holdInstruction = 468,
+	id_holdinstruction_none = 469,
+	id_holdinstruction_callissuer = 470,
+	id_holdinstruction_reject = 471,
+	id_at = 472,
+	common_name = 473,
+	surname = 474,
+	serial_number = 475,
+	country_name = 476,
+	locality_name = 477,
+	state_or_province_name = 478,
+	street = 479,
+	organization_name = 480,
+	organizational_unit_name = 481,
+	title = 482,
+	description = 483,
+	search_guide = 484,
+	business_category = 485,
+	postal_address = 486,
+	postal_code = 487,
+	post_office_box = 488,
+	physical_delivery_office_name = 489,
+	telephone_number = 490,
+	telex_number = 491,
+	teletex_terminal_identifier = 492,
+	facsimile_telephone_number = 493,
+	x121_address = 494,
+	international_isdn_number = 495,
+	registered_address = 496,
+	destination_indicator = 497,
+	preferred_delivery_method = 498,
+	member = 499,
+	owner = 500,
+	role_occupant = 501,
+	see_also = 502,
+	user_password = 503,
+	name = 504,
+	given_name = 505,
+	initials = 506,
+	generation_qualifier = 507,
+	x500_unique_identifier = 508,
+	dn_qualifier = 509,
+	enhanced_search_guide = 510,
+	distinguished_name = 511,
+	unique_member = 512,
+	house_identifier = 513,
+	pseudonym = 514,
+	id_ce = 515,
+	DeprecatedAuthorityKeyIdentifier = 516,
+	DeprecatedSubjectAltName = 517,
+	id_ce_subjectDirectoryAttributes = 518,
+	id_ce_subjectKeyIdentifier = 519,
+	key_usage = 520,
+	id_ce_privateKeyUsagePeriod = 521,
+	subject_alt_name = 522,
+	id_ce_issuerAltName = 523,
+	id_ce_basicConstraints = 524,
+	id_ce_cRLNumber = 525,
+	id_ce_reasonCode = 526,
+	id_ce_instructionCode = 527,
+	id_ce_invalidityDate = 528,
+	id_ce_deltaCRLIndicator = 529,
+	id_ce_issuingDistributionPoint = 530,
+	id_ce_certificateIssuer = 531,
+	id_ce_nameConstraints = 532,
+	id_ce_cRLDistributionPoints = 533,
+	id_ce_certificatePolicies = 534,
+	anyPolicy = 535,
+	id_ce_policyMappings = 536,
+	DeprecatedpolicyConstraints = 537,
+	id_ce_authorityKeyIdentifier = 538,
+	id_ce_policyConstraints = 539,
+	ext_key_usage = 540,
+	anyExtendedKeyUsage = 541,
+	id_ce_freshestCRL = 542,
+	id_ce_inhibitAnyPolicy = 543,
+	DigiNotar_EV_CPS = 544,
+	Logius_PKIoverheid_EV_CPS = 545,
+	Buypass_EV_CPS = 546,
+	Swisscom_EV_CPS = 547,
+	SwissSign_EV_CPS = 548,
+	Kamu_Sertifikasyon_Merkezi_EV_CPS = 549,
+	E_Tugra_EV_CPS = 550,
+	id_keyExchangeAlgorithm = 551,
+	hashAlgs = 552,
+	id_sha256 = 553,
+	id_sha384 = 554,
+	id_sha512 = 555,
+	id_sha224 = 556,
+	id_shake128 = 557,
+	id_shake256 = 558,
+	id_hmacWithSHA3_224 = 559,
+	id_hmacWithSHA3_256 = 560,
+	id_hmacWithSHA3_384 = 561,
+	id_hmacWithSHA3_512 = 562,
+	id_KmacWithSHAKE128 = 563,
+	id_KmacWithSHAKE256 = 564,
+	sigAlgs = 565,
+	id_dsa_with_sha224 = 566,
+	id_dsa_with_sha256 = 567,
+	id_ecdsa_with_sha3_224 = 568,
+	id_ecdsa_with_sha3_256 = 569,
+	id_ecdsa_with_sha3_384 = 570,
+	id_ecdsa_with_sha3_512 = 571,
+	id_rsassa_pkcs1_v1_5_with_sha3_224 = 572,
+	id_rsassa_pkcs1_v1_5_with_sha3_256 = 573,
+	id_rsassa_pkcs1_v1_5_with_sha3_384 = 574,
+	id_rsassa_pkcs1_v1_5_with_sha3_512 = 575,
+	NetscapeCertificateExtension = 576,
+	NetscapeCertType = 577,
+	RevocationURL = 578,
+	CaRevocationURL = 579,
+	SSLServerName = 580,
+	NetscapeCertificateComment = 581,
+	pkcs_9_at_userPKCS12 = 582,
+	Symantec_EV_CPS = 583,
+	Thawte_EV_CPS = 584,
+	Entrust_EV_CPS = 585,
+	Wells_Fargo_EV_CPS = 586,
+	Trustwave_EV_CPS = 587,
+	DigiCert_EV_CPS_1_ = 588,
+	DigiCert_EV_CPS = 589,
+	Go_Daddy_EV_CPS = 590,
+	Starfield_Technologies_EV_CPS = 591,
+};
+
+// each oid_entry refers to the DER encoding of an OID, which is
+// length bytes of oid_bytes starting at offset
+//
+struct oid_entry {
+    uint16_t offset;
+    uint8_t length;
+    enum type value;
+    const char *name;
+};
+
+static constexpr uint8_t oid_bytes[] = {
+	0x2a,
+	0x2b,0x65,
+	0x55,0x04,
+	0x55,0x1d,
+	0x2a,0x81,0x1c,
+	0x2b,0x65,0x6e,
+	0x2b,0x65,0x6f,
+	0x2b,0x65,0x70,
+	0x2b,0x65,0x71,
+	0x2b,0x81,0x04,
+	0x55,0x04,0x03,
+	0x55,0x04,0x04,
+	0x55,0x04,0x05,
+	0x55,0x04,0x06,
+	0x55,0x04,0x07,
+	0x55,0x04,0x08,
+	0x55,0x04,0x09,
+	0x55,0x04,0x0a,
+	0x55,0x04,0x0b,
+	0x55,0x04,0x0c,
+	0x55,0x04,0x0d,
+	0x55,0x04,0x0e,
+	0x55,0x04,0x0f,
+	0x55,0x04,0x10,
+	0x55,0x04,0x11,
+	0x55,0x04,0x12,
+	0x55,0x04,0x13,
+	0x55,0x04,0x14,
+	0x55,0x04,0x15,
+	0x55,0x04,0x16,
+	0x55,0x04,0x17,
+	0x55,0x04,0x18,
+	0x55,0x04,0x19,
+	0x55,0x04,0x1a,
+	0x55,0x04,0x1b,
+	0x55,0x04,0x1c,
+	0x55,0x04,0x1f,
+	0x55,0x04,0x20,
+	0x55,0x04,0x21,
+	0x55,0x04,0x22,
+	0x55,0x04,0x23,
+	0x55,0x04,0x29,
+	0x55,0x04,0x2a,
+	0x55,0x04,0x2b,
+	0x55,0x04,0x2c,
+	0x55,0x04,0x2d,
+	0x55,0x04,0x2e,
+	0x55,0x04,0x2f,
+	0x55,0x04,0x31,
+	0x55,0x04,0x32,
+	0x55,0x04,0x33,
+	0x55,0x04,0x41,
+	0x55,0x1d,0x01,
+	0x55,0x1d,0x07,
+	0x55,0x1d,0x09,
+	0x55,0x1d,0x0e,
+	0x55,0x1d,0x0f,
+	0x55,0x1d,0x10,
+	0x55,0x1d,0x11,
+	0x55,0x1d,0x12,
+	0x55,0x1d,0x13,
+	0x55,0x1d,0x14,
+	0x55,0x1d,0x15,
+	0x55,0x1d,0x17,
+	0x55,0x1d,0x18,
+	0x55,0x1d,0x1b,
+	0x55,0x1d,0x1c,
+	0x55,0x1d,0x1d,
+	0x55,0x1d,0x1e,
+	0x55,0x1d,0x1f,
+	0x55,0x1d,0x20,
+	0x55,0x1d,0x21,
+	0x55,0x1d,0x22,
+	0x55,0x1d,0x23,
+	0x55,0x1d,0x24,
+	0x55,0x1d,0x25,
+	0x55,0x1d,0x2e,
+	0x55,0x1d,0x36,
+	0x2b,0x81,0x04,0x00,
+	0x55,0x1d,0x20,0x00,
+	0x55,0x1d,0x25,0x00,
+	0x2a,0x81,0x1c,0x81,0x45,
+	0x2a,0x81,0x1c,0xcf,0x55,
+	0x2a,0x86,0x48,0xce,0x3d,
+	0x2b,0x0e,0x03,0x02,0x0f,
+	0x2b,0x0e,0x03,0x02,0x1a,
+	0x2b,0x0e,0x03,0x02,0x1d,
+	0x2b,0x81,0x04,0x00,0x01,
+	0x2b,0x81,0x04,0x00,0x0f,
+	0x2b,0x81,0x04,0x00,0x10,
+	0x2b,0x81,0x04,0x00,0x11,
+	0x2b,0x81,0x04,0x00,0x1a,
+	0x2b,0x81,0x04,0x00,0x1b,
+	0x2b,0x81,0x04,0x00,0x21,
+	0x2b,0x81,0x04,0x00,0x22,
+	0x2b,0x81,0x04,0x00,0x23,
+	0x2b,0x81,0x04,0x00,0x24,
+	0x2b,0x81,0x04,0x00,0x25,
+	0x2b,0x81,0x04,0x00,0x26,
+	0x2b,0x81,0x04,0x00,0x27,
+	0x2b,0x81,0x04,0x01,0x0c,
+	0x2b,0x81,0x04,0x01,0x0d,
+	0x04,0x00,0x8f,0x7a,0x01,0x04,
+	0x04,0x00,0x8f,0x7a,0x01,0x05,
+	0x2a,0x28,0x00,0x11,0x01,0x16,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,
+	0x2a,0x86,0x48,0x04,0x03,0x02,
+	0x2a,0x86,0x48,0xce,0x3d,0x01,
+	0x2a,0x86,0x48,0xce,0x3d,0x02,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,
+	0x2a,0x86,0x48,0xce,0x3d,0x04,
+	0x2b,0x06,0x01,0x05,0x05,0x07,
+	0x2b,0x24,0x03,0x03,0x02,0x08,
+	0x2b,0x81,0x1f,0x01,0x11,0x01,
+	0x52,0x86,0x48,0xce,0x38,0x02,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x64,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x66,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x67,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x68,
+	0x2a,0x81,0x1c,0xcf,0x55,0x04,0x03,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x02,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x03,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x04,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x05,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x06,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x05,
+	0x2a,0x86,0x48,0xce,0x38,0x04,0x01,
+	0x2a,0x86,0x48,0xce,0x38,0x04,0x03,
+	0x2a,0x86,0x48,0xce,0x3d,0x01,0x01,
+	0x2a,0x86,0x48,0xce,0x3d,0x01,0x02,
+	0x2a,0x86,0x48,0xce,0x3d,0x02,0x01,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x02,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x03,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x0a,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x0f,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x10,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x11,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x1a,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x1b,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x1f,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x20,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x21,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x22,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x23,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x24,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x25,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x26,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x27,
+	0x2a,0x86,0x48,0xce,0x3d,0x04,0x01,
+	0x2a,0x86,0x48,0xce,0x3e,0x02,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x08,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x09,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x0b,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x0c,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x14,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,
+	0x2b,0x24,0x03,0x03,0x02,0x08,0x01,
+	0x52,0x86,0x48,0xce,0x38,0x02,0x01,
+	0x52,0x86,0x48,0xce,0x38,0x02,0x02,
+	0x52,0x86,0x48,0xce,0x38,0x02,0x03,
+	0x60,0x85,0x74,0x01,0x53,0x15,0x00,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x81,0x48,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x81,0x49,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2c,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2d,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2e,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x83,0x10,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x83,0x11,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x83,0x74,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x83,0x75,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x83,0x78,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x02,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x03,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x04,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x05,0x01,
+	0x2a,0x85,0x03,0x07,0x01,0x01,0x01,0x01,
+	0x2a,0x85,0x03,0x07,0x01,0x01,0x01,0x02,
+	0x2a,0x85,0x03,0x07,0x01,0x01,0x02,0x02,
+	0x2a,0x85,0x03,0x07,0x01,0x01,0x02,0x03,
+	0x2a,0x85,0x03,0x07,0x01,0x01,0x03,0x02,
+	0x2a,0x85,0x03,0x07,0x01,0x01,0x03,0x03,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x02,0x02,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x02,0x05,
+	0x2a,0x86,0x48,0xce,0x3d,0x01,0x02,0x03,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x01,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x02,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x03,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x04,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x05,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x06,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x07,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x08,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x09,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x0a,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x0b,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x0c,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x0d,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x0e,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x0f,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x10,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x11,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x12,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x13,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x00,0x14,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x01,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x02,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x03,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x04,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x05,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x06,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x07,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x08,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x09,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x0a,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x0b,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x0c,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x0d,
+	0x2a,0x86,0x48,0xce,0x3d,0x03,0x01,0x0e,
+	0x2a,0x86,0x48,0xce,0x3d,0x04,0x03,0x01,
+	0x2a,0x86,0x48,0xce,0x3d,0x04,0x03,0x02,
+	0x2a,0x86,0x48,0xce,0x3d,0x04,0x03,0x03,
+	0x2a,0x86,0x48,0xce,0x3d,0x04,0x03,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x58,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x01,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x01,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x01,0x03,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x01,0x0b,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x01,0x0c,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x02,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x02,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x03,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x04,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x05,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x06,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x07,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x08,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x09,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x1b,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x03,0x1c,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x06,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x06,0x1e,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x06,0x1f,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x06,0x20,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x06,0x21,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x03,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x04,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x05,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x06,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x07,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x08,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x09,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x0a,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x0b,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x0f,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x10,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x11,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x12,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x13,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x15,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x16,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x17,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x18,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x19,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x1a,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x1b,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x1c,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x1d,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x1e,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x1f,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x20,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x21,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x22,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x23,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x24,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x07,0x25,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x08,0x09,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x09,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x09,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x09,0x03,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x09,0x04,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x09,0x05,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x0b,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x0b,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x0c,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x0c,0x03,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x14,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x14,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x03,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x05,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x0c,
+	0x60,0x84,0x42,0x01,0x1a,0x01,0x03,0x03,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x42,0x01,
+	0x2a,0x81,0x1c,0x86,0xef,0x3a,0x01,0x01,0x03,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2d,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2d,0x02,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2d,0x03,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2e,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2e,0x02,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x82,0x2e,0x03,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x83,0x11,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x01,0x83,0x11,0x02,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x01,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x01,0x02,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x01,0x03,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x01,0x04,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x02,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x04,0x01,
+	0x2a,0x81,0x1c,0xcf,0x55,0x06,0x01,0x04,0x02,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x01,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x02,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x04,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x05,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x07,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x08,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x09,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x0a,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x0b,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x0c,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x0d,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x0e,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x0f,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x01,0x10,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x00,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x01,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x02,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x03,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x04,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x05,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x06,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x07,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x08,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x09,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x0d,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x0e,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x0f,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x10,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x14,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x15,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x16,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x17,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x18,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x19,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x1a,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x1b,
+	0x2a,0x86,0x48,0xce,0x3d,0x01,0x02,0x03,0x01,
+	0x2a,0x86,0x48,0xce,0x3d,0x01,0x02,0x03,0x02,
+	0x2a,0x86,0x48,0xce,0x3d,0x01,0x02,0x03,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x09,0x15,0x02,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x81,0xb5,0x37,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x07,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0b,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0d,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x10,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x11,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x12,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x12,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x12,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x12,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x12,0x05,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x12,0x06,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x12,0x07,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x12,0x08,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x14,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x14,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x14,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x05,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x06,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x07,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x08,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x09,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x0a,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x0b,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x0c,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x0d,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x0e,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x0f,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x10,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x11,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x13,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x14,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x15,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x15,0x16,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x19,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x1e,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x1f,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x58,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x58,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x58,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x9b,0x51,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0xa0,0x32,0x01,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0xf0,0x22,0x01,0x06,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x01,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x02,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x03,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x04,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x05,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x06,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x07,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x08,
+	0x2b,0x06,0x01,0x05,0x05,0x07,0x30,0x01,0x09,
+	0x60,0x84,0x10,0x01,0x87,0x6b,0x01,0x02,0x07,
+	0x60,0x85,0x74,0x01,0x59,0x01,0x02,0x01,0x01,
+	0x60,0x86,0x18,0x03,0x00,0x04,0x01,0x01,0x04,
+	0x60,0x86,0x48,0x01,0x65,0x02,0x01,0x01,0x16,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x01,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x02,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x03,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x04,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x0b,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x0c,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x0d,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x0e,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x0f,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x10,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x13,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x02,0x14,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x01,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x02,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x09,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x0a,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x0b,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x0c,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x0d,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x0e,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x0f,
+	0x60,0x86,0x48,0x01,0x65,0x03,0x04,0x03,0x10,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x42,0x01,0x01,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x42,0x01,0x03,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x42,0x01,0x04,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x42,0x01,0x0c,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x42,0x01,0x0d,
+	0x60,0x86,0x48,0x01,0x86,0xfd,0x6c,0x02,0x01,
+	0x09,0x92,0x26,0x89,0x93,0xf2,0x2c,0x64,0x01,0x01,
+	0x09,0x92,0x26,0x89,0x93,0xf2,0x2c,0x64,0x01,0x19,
+	0x2a,0x83,0x08,0x8c,0x9b,0x1b,0x64,0x85,0x51,0x01,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x10,0x02,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x18,0x01,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x18,0x02,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x19,0x01,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x19,0x02,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x19,0x03,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x19,0x04,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x19,0x05,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x1a,0x01,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x1a,0x02,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x1b,0x01,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x1b,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x0a,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x0b,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x0c,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x0e,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x0f,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x12,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x13,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x14,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x15,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x16,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x19,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x1a,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x1b,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x1c,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x1d,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x01,0x1e,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x02,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x02,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x02,0x02,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x03,0x02,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x01,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x05,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x06,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x07,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x08,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x09,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x0a,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x0b,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x0c,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x0d,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x0e,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x04,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x05,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x05,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x06,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x06,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x07,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x08,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x09,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0a,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0b,0x09,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0b,0x0b,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0b,0x14,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0b,0x1d,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0b,0x53,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0b,0x62,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0b,0x69,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x0c,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0c,0x01,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0c,0x01,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0c,0x02,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0c,0x02,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0d,0x02,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0d,0x02,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0d,0x02,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x14,0x02,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x14,0x02,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x14,0x02,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x00,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x00,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x00,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x00,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x01,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x01,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x01,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x01,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x02,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x03,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x03,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x03,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x2c,0x03,0x05,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x3c,0x01,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x54,0x01,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x58,0x02,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x58,0x02,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x58,0x03,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x8f,0x09,0x02,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x8f,0x09,0x02,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x8f,0x09,0x02,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x8f,0x09,0x02,0x04,
+	0x2b,0x06,0x01,0x04,0x01,0xb1,0x3e,0x01,0x64,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0xbd,0x47,0x0d,0x18,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0xd6,0x79,0x02,0x04,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0xd6,0x79,0x02,0x04,0x05,
+	0x2b,0x06,0x01,0x04,0x01,0xf3,0x39,0x06,0x01,0x01,
+	0x60,0x86,0x48,0x01,0x86,0xfa,0x6c,0x0a,0x01,0x02,
+	0x60,0x86,0x48,0x01,0x86,0xfb,0x7b,0x83,0x74,0x09,
+	0x2a,0x86,0x48,0x86,0xf7,0x0d,0x01,0x09,0x10,0x02,0x22,
+	0x2b,0x06,0x01,0x04,0x01,0x81,0xb5,0x37,0x01,0x01,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x03,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x0a,0x03,0x04,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x3c,0x02,0x01,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x3c,0x02,0x01,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x82,0x37,0x3c,0x02,0x01,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0xa5,0x34,0x02,0x81,0x4a,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0xe6,0x79,0x0a,0x01,0x03,0x0a,
+	0x60,0x86,0x18,0x01,0x02,0x01,0x01,0x05,0x07,0x01,0x09,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x42,0x03,0x01,0x81,0x58,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x45,0x01,0x07,0x17,0x06,
+	0x60,0x86,0x48,0x01,0x86,0xf8,0x45,0x01,0x07,0x30,0x01,
+	0x60,0x86,0x48,0x01,0x86,0xfd,0x6c,0x01,0x03,0x00,0x02,
+	0x60,0x86,0x48,0x01,0x86,0xfd,0x6d,0x01,0x07,0x17,0x03,
+	0x60,0x86,0x48,0x01,0x86,0xfd,0x6e,0x01,0x07,0x17,0x03,
+	0x2b,0x06,0x01,0x04,0x01,0x86,0x0e,0x01,0x02,0x01,0x08,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0xb2,0x31,0x01,0x02,0x01,0x05,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0xbe,0x58,0x00,0x02,0x64,0x01,0x02,
+	0x60,0x86,0x48,0x01,0x86,0xfd,0x64,0x01,0x01,0x02,0x04,0x01,
+	0x2b,0x06,0x01,0x04,0x01,0x81,0x87,0x2e,0x0a,0x08,0x0c,0x01,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x81,0x87,0x2e,0x0a,0x0e,0x02,0x01,0x02,
+	0x2b,0x06,0x01,0x04,0x01,0x81,0xad,0x5a,0x02,0x05,0x02,0x03,0x01,
+	0x60,0x84,0x10,0x01,0x87,0x69,0x01,0x01,0x01,0x0c,0x06,0x01,0x01,0x01,
+};
+
+// oid_table is sorted by length, then by bytes
+//
+static constexpr oid_entry oid_table[] = {
+	{ 0, 1, ISO, "ISO" },
+	{ 1, 2, id_edwards_curve_algs, "id-edwards-curve-algs" },
+	{ 3, 2, id_at, "id-at" },
+	{ 5, 2, id_ce, "id-ce" },
+	{ 7, 3, China, "China" },
+	{ 10, 3, id_X25519, "id-X25519" },
+	{ 13, 3, id_X448, "id-X448" },
+	{ 16, 3, id_Ed25519, "id-Ed25519" },
+	{ 19, 3, id_Ed448, "id-Ed448" },
+	{ 22, 3, certicom_arc, "certicom-arc" },
+	{ 25, 3, common_name, "common_name" },
+	{ 28, 3, surname, "surname" },
+	{ 31, 3, serial_number, "serial_number" },
+	{ 34, 3, country_name, "country_name" },
+	{ 37, 3, locality_name, "locality_name" },
+	{ 40, 3, state_or_province_name, "state_or_province_name" },
+	{ 43, 3, street, "street" },
+	{ 46, 3, organization_name, "organization_name" },
+	{ 49, 3, organizational_unit_name, "organizational_unit_name" },
+	{ 52, 3, title, "title" },
+	{ 55, 3, description, "description" },
+	{ 58, 3, search_guide, "search_guide" },
+	{ 61, 3, business_category, "business_category" },
+	{ 64, 3, postal_address, "postal_address" },
+	{ 67, 3, postal_code, "postal_code" },
+	{ 70, 3, post_office_box, "post_office_box" },
+	{ 73, 3, physical_delivery_office_name, "physical_delivery_office_name" },
+	{ 76, 3, telephone_number, "telephone_number" },
+	{ 79, 3, telex_number, "telex_number" },
+	{ 82, 3, teletex_terminal_identifier, "teletex_terminal_identifier" },
+	{ 85, 3, facsimile_telephone_number, "facsimile_telephone_number" },
+	{ 88, 3, x121_address, "x121_address" },
+	{ 91, 3, international_isdn_number, "international_isdn_number" },
+	{ 94, 3, registered_address, "registered_address" },
+	{ 97, 3, destination_indicator, "destination_indicator" },
+	{ 100, 3, preferred_delivery_method, "preferred_delivery_method" },
+	{ 103, 3, member, "member" },
+	{ 106, 3, owner, "owner" },
+	{ 109, 3, role_occupant, "role_occupant" },
+	{ 112, 3, see_also, "see_also" },
+	{ 115, 3, user_password, "user_password" },
+	{ 118, 3, name, "name" },
+	{ 121, 3, given_name, "given_name" },
+	{ 124, 3, initials, "initials" },
+	{ 127, 3, generation_qualifier, "generation_qualifier" },
+	{ 130, 3, x500_unique_identifier, "x500_unique_identifier" },
+	{ 133, 3, dn_qualifier, "dn_qualifier" },
+	{ 136, 3, enhanced_search_guide, "enhanced_search_guide" },
+	{ 139, 3, distinguished_name, "distinguished_name" },
+	{ 142, 3, unique_member, "unique_member" },
+	{ 145, 3, house_identifier, "house_identifier" },
+	{ 148, 3, pseudonym, "pseudonym" },
+	{ 151, 3, DeprecatedAuthorityKeyIdentifier, "DeprecatedAuthorityKeyIdentifier" },
+	{ 154, 3, DeprecatedSubjectAltName, "DeprecatedSubjectAltName" },
+	{ 157, 3, id_ce_subjectDirectoryAttributes, "id-ce-subjectDirectoryAttributes" },
+	{ 160, 3, id_ce_subjectKeyIdentifier, "id-ce-subjectKeyIdentifier" },
+	{ 163, 3, key_usage, "key_usage" },
+	{ 166, 3, id_ce_privateKeyUsagePeriod, "id-ce-privateKeyUsagePeriod" },
+	{ 169, 3, subject_alt_name, "subject_alt_name" },
+	{ 172, 3, id_ce_issuerAltName, "id-ce-issuerAltName" },
+	{ 175, 3, id_ce_basicConstraints, "id-ce-basicConstraints" },
+	{ 178, 3, id_ce_cRLNumber, "id-ce-cRLNumber" },
+	{ 181, 3, id_ce_reasonCode, "id-ce-reasonCode" },
+	{ 184, 3, id_ce_instructionCode, "id-ce-instructionCode" },
+	{ 187, 3, id_ce_invalidityDate, "id-ce-invalidityDate" },
+	{ 190, 3, id_ce_deltaCRLIndicator, "id-ce-deltaCRLIndicator" },
+	{ 193, 3, id_ce_issuingDistributionPoint, "id-ce-issuingDistributionPoint" },
+	{ 196, 3, id_ce_certificateIssuer, "id-ce-certificateIssuer" },
+	{ 199, 3, id_ce_nameConstraints, "id-ce-nameConstraints" },
+	{ 202, 3, id_ce_cRLDistributionPoints, "id-ce-cRLDistributionPoints" },
+	{ 205, 3, id_ce_certificatePolicies, "id-ce-certificatePolicies" },
+	{ 208, 3, id_ce_policyMappings, "id-ce-policyMappings" },
+	{ 211, 3, DeprecatedpolicyConstraints, "DeprecatedpolicyConstraints" },
+	{ 214, 3, id_ce_authorityKeyIdentifier, "id-ce-authorityKeyIdentifier" },
+	{ 217, 3, id_ce_policyConstraints, "id-ce-policyConstraints" },
+	{ 220, 3, ext_key_usage, "ext_key_usage" },
+	{ 223, 3, id_ce_freshestCRL, "id-ce-freshestCRL" },
+	{ 226, 3, id_ce_inhibitAnyPolicy, "id-ce-inhibitAnyPolicy" },
+	{ 229, 4, ellipticCurve_2_, "ellipticCurve[2]" },
+	{ 233, 4, anyPolicy, "anyPolicy" },
+	{ 237, 4, anyExtendedKeyUsage, "anyExtendedKeyUsage" },
+	{ 241, 5, OSCCA, "OSCCA" },
+	{ 246, 5, GM_Standard_Committee, "GM_Standard_Committee" },
+	{ 251, 5, ansi_X9_62, "ansi-X9-62" },
+	{ 256, 5, id_sha_with_rsa_signature, "id-sha-with-rsa-signature" },
+	{ 261, 5, id_sha1, "id-sha1" },
+	{ 266, 5, sha_1WithRSAEncryption, "sha-1WithRSAEncryption" },
+	{ 271, 5, sect163k1, "sect163k1" },
+	{ 276, 5, sect163r2, "sect163r2" },
+	{ 281, 5, sect283k1, "sect283k1" },
+	{ 286, 5, sect283r1, "sect283r1" },
+	{ 291, 5, sect233k1, "sect233k1" },
+	{ 296, 5, sect233r1, "sect233r1" },
+	{ 301, 5, secp224r1, "secp224r1" },
+	{ 306, 5, secp384r1, "secp384r1" },
+	{ 311, 5, secp521r1, "secp521r1" },
+	{ 316, 5, sect409k1, "sect409k1" },
+	{ 321, 5, sect409r1, "sect409r1" },
+	{ 326, 5, sect571k1, "sect571k1" },
+	{ 331, 5, sect571r1, "sect571r1" },
+	{ 336, 5, id_ecDH, "id-ecDH" },
+	{ 341, 5, id_ecMQV, "id-ecMQV" },
+	{ 346, 6, ETSI_EV_CPS, "ETSI_EV_CPS" },
+	{ 352, 6, ETSI_EV_CPS_1_, "ETSI_EV_CPS[1]" },
+	{ 358, 6, A_Trust_EV_CPS, "A-Trust_EV_CPS" },
+	{ 364, 6, Cryptographic_Algorithm, "Cryptographic_Algorithm" },
+	{ 370, 6, Standard_Class, "Standard_Class" },
+	{ 376, 6, ecdsa_with_SHA256_1_, "ecdsa-with-SHA256[1]" },
+	{ 382, 6, id_fieldType, "id-fieldType" },
+	{ 388, 6, id_publicKeyType, "id-publicKeyType" },
+	{ 394, 6, ellipticCurve, "ellipticCurve" },
+	{ 400, 6, id_ecSigType, "id-ecSigType" },
+	{ 406, 6, id_pkix, "id-pkix" },
+	{ 412, 6, ecStdCurvesAndGeneration, "ecStdCurvesAndGeneration" },
+	{ 418, 6, Actalis_EV_CPS, "Actalis_EV_CPS" },
+	{ 424, 6, holdInstruction, "holdInstruction" },
+	{ 430, 7, Block_Cipher, "Block_Cipher" },
+	{ 437, 7, SM1_Block_Cipher, "SM1_Block_Cipher" },
+	{ 444, 7, SSF33_Block_Cipher, "SSF33_Block_Cipher" },
+	{ 451, 7, SM4_Block_Cipher, "SM4_Block_Cipher" },
+	{ 458, 7, Certificate_Authority, "Certificate_Authority" },
+	{ 465, 7, Fundatation_Class, "Fundatation_Class" },
+	{ 472, 7, Device_Class, "Device_Class" },
+	{ 479, 7, Service_Class, "Service_Class" },
+	{ 486, 7, Infrastructure, "Infrastructure" },
+	{ 493, 7, Testing_Class, "Testing_Class" },
+	{ 500, 7, Management_Class, "Management_Class" },
+	{ 507, 7, id_md5, "id-md5" },
+	{ 514, 7, id_dsa, "id-dsa" },
+	{ 521, 7, id_dsa_with_sha1, "id-dsa-with-sha1" },
+	{ 528, 7, prime_field, "prime-field" },
+	{ 535, 7, characteristic_two_field, "characteristic-two-field" },
+	{ 542, 7, id_ecPublicKey, "id-ecPublicKey" },
+	{ 549, 7, c_TwoCurve, "c-TwoCurve" },
+	{ 556, 7, primeCurve, "primeCurve" },
+	{ 563, 7, sect163r1, "sect163r1" },
+	{ 570, 7, sect239k1, "sect239k1" },
+	{ 577, 7, secp256k1, "secp256k1" },
+	{ 584, 7, sect163r2_1_, "sect163r2[1]" },
+	{ 591, 7, sect283k1_1_, "sect283k1[1]" },
+	{ 598, 7, sect283r1_1_, "sect283r1[1]" },
+	{ 605, 7, sect233k1_1_, "sect233k1[1]" },
+	{ 612, 7, sect233r1_1_, "sect233r1[1]" },
+	{ 619, 7, secp192k1, "secp192k1" },
+	{ 626, 7, secp224k1, "secp224k1" },
+	{ 633, 7, secp224r1_1_, "secp224r1[1]" },
+	{ 640, 7, secp384r1_1_, "secp384r1[1]" },
+	{ 647, 7, secp521r1_1_, "secp521r1[1]" },
+	{ 654, 7, sect409k1_1_, "sect409k1[1]" },
+	{ 661, 7, sect409r1_1_, "sect409r1[1]" },
+	{ 668, 7, sect571k1_1_, "sect571k1[1]" },
+	{ 675, 7, sect571r1_1_, "sect571r1[1]" },
+	{ 682, 7, ecdsa_with_SHA1, "ecdsa-with-SHA1" },
+	{ 689, 7, dhpublicnumber, "dhpublicnumber" },
+	{ 696, 7, id_pe, "id-pe" },
+	{ 703, 7, id_qt, "id-qt" },
+	{ 710, 7, id_kp, "id-kp" },
+	{ 717, 7, id_cmc, "id-cmc" },
+	{ 724, 7, id_on, "id-on" },
+	{ 731, 7, ietf_at, "ietf-at" },
+	{ 738, 7, id_qcs, "id-qcs" },
+	{ 745, 7, id_cct, "id-cct" },
+	{ 752, 7, id_logo, "id-logo" },
+	{ 759, 7, id_ad, "id-ad" },
+	{ 766, 7, ellipticCurve_1_, "ellipticCurve[1]" },
+	{ 773, 7, id_holdinstruction_none, "id-holdinstruction-none" },
+	{ 780, 7, id_holdinstruction_callissuer, "id-holdinstruction-callissuer" },
+	{ 787, 7, id_holdinstruction_reject, "id-holdinstruction-reject" },
+	{ 794, 7, Swisscom_EV_CPS, "Swisscom_EV_CPS" },
+	{ 801, 8, Stream_Cipher, "Stream_Cipher" },
+	{ 809, 8, ZUC_Stream_Cipher, "ZUC_Stream_Cipher" },
+	{ 817, 8, Public_Key_Cryptography, "Public_Key_Cryptography" },
+	{ 825, 8, SM2_Elliptic_Curve_Cryptography, "SM2_Elliptic_Curve_Cryptography" },
+	{ 833, 8, SM9_Identity_Based_Cryptography, "SM9_Identity-Based_Cryptography" },
+	{ 841, 8, Hash_Algorithm, "Hash_Algorithm" },
+	{ 849, 8, SM3_Hash_Algorithm, "SM3_Hash_Algorithm" },
+	{ 857, 8, Digest_Signing, "Digest_Signing" },
+	{ 865, 8, SM2_Signing_with_SM3, "SM2_Signing_with_SM3" },
+	{ 873, 8, RSA_Signing_with_SM3, "RSA_Signing_with_SM3" },
+	{ 881, 8, Algorithm_Class, "Algorithm_Class" },
+	{ 889, 8, ID_Class, "ID_Class" },
+	{ 897, 8, Operation_Modes, "Operation_Modes" },
+	{ 905, 8, Security_Mechanism, "Security_Mechanism" },
+	{ 913, 8, Random_Testing_Class, "Random_Testing_Class" },
+	{ 921, 8, id_tc26_gost3410_12_256, "id-tc26-gost3410-12-256" },
+	{ 929, 8, id_tc26_gost3410_12_512, "id-tc26-gost3410-12-512" },
+	{ 937, 8, id_tc26_digest_gost3411_12_256, "id-tc26-digest-gost3411-12-256" },
+	{ 945, 8, id_tc26_digest_gost3411_12_512, "id-tc26-digest-gost3411-12-512" },
+	{ 953, 8, id_tc26_signwithdigest_gost3410_12_256, "id-tc26-signwithdigest-gost3410-12-256" },
+	{ 961, 8, id_tc26_signwithdigest_gost3410_12_512, "id-tc26-signwithdigest-gost3410-12-512" },
+	{ 969, 8, email_address, "email_address" },
+	{ 977, 8, pkcs_9, "pkcs-9" },
+	{ 985, 8, md2, "md2" },
+	{ 993, 8, md5, "md5" },
+	{ 1001, 8, id_characteristic_two_basis, "id-characteristic-two-basis" },
+	{ 1009, 8, c2pnb163v1, "c2pnb163v1" },
+	{ 1017, 8, c2pnb163v2, "c2pnb163v2" },
+	{ 1025, 8, c2pnb163v3, "c2pnb163v3" },
+	{ 1033, 8, c2pnb176w1, "c2pnb176w1" },
+	{ 1041, 8, c2tnb191v1, "c2tnb191v1" },
+	{ 1049, 8, c2tnb191v2, "c2tnb191v2" },
+	{ 1057, 8, c2tnb191v3, "c2tnb191v3" },
+	{ 1065, 8, c2onb191v4, "c2onb191v4" },
+	{ 1073, 8, c2onb191v5, "c2onb191v5" },
+	{ 1081, 8, c2pnb208w1, "c2pnb208w1" },
+	{ 1089, 8, c2tnb239v1, "c2tnb239v1" },
+	{ 1097, 8, c2tnb239v2, "c2tnb239v2" },
+	{ 1105, 8, c2tnb239v3, "c2tnb239v3" },
+	{ 1113, 8, c2onb239v4, "c2onb239v4" },
+	{ 1121, 8, c2onb239v5, "c2onb239v5" },
+	{ 1129, 8, c2pnb272w1, "c2pnb272w1" },
+	{ 1137, 8, c2pnb304w1, "c2pnb304w1" },
+	{ 1145, 8, c2tnb359v1, "c2tnb359v1" },
+	{ 1153, 8, c2pnb368w1, "c2pnb368w1" },
+	{ 1161, 8, c2tnb431r1, "c2tnb431r1" },
+	{ 1169, 8, prime192v1, "prime192v1" },
+	{ 1177, 8, prime192v2, "prime192v2" },
+	{ 1185, 8, prime192v3, "prime192v3" },
+	{ 1193, 8, prime239v1, "prime239v1" },
+	{ 1201, 8, prime239v2, "prime239v2" },
+	{ 1209, 8, prime239v3, "prime239v3" },
+	{ 1217, 8, prime256v1, "prime256v1" },
+	{ 1225, 8, brainpoolP256t1, "brainpoolP256t1" },
+	{ 1233, 8, brainpoolP320r1, "brainpoolP320r1" },
+	{ 1241, 8, brainpoolP320t1, "brainpoolP320t1" },
+	{ 1249, 8, brainpoolP384r1, "brainpoolP384r1" },
+	{ 1257, 8, brainpoolP384t1, "brainpoolP384t1" },
+	{ 1265, 8, brainpoolP512r1, "brainpoolP512r1" },
+	{ 1273, 8, brainpoolP512t1, "brainpoolP512t1" },
+	{ 1281, 8, ecdsa_with_SHA224, "ecdsa-with-SHA224" },
+	{ 1289, 8, ecdsa_with_SHA256, "ecdsa-with-SHA256" },
+	{ 1297, 8, ecdsa_with_SHA384, "ecdsa-with-SHA384" },
+	{ 1305, 8, ecdsa_with_SHA512, "ecdsa-with-SHA512" },
+	{ 1313, 8, szOID_CAPICOM, "szOID_CAPICOM" },
+	{ 1321, 8, id_pe_authorityInfoAccess, "id-pe-authorityInfoAccess" },
+	{ 1329, 8, id_pe_biometricInfo, "id-pe-biometricInfo" },
+	{ 1337, 8, id_pe_qcStatements, "id-pe-qcStatements" },
+	{ 1345, 8, id_pe_subjectInfoAccess, "id-pe-subjectInfoAccess" },
+	{ 1353, 8, id_pe_logotype, "id-pe-logotype" },
+	{ 1361, 8, id_qt_cps, "id-qt-cps" },
+	{ 1369, 8, id_qt_unotice, "id-qt-unotice" },
+	{ 1377, 8, id_kp_serverAuth, "id-kp-serverAuth" },
+	{ 1385, 8, id_kp_clientAuth, "id-kp-clientAuth" },
+	{ 1393, 8, id_kp_codeSigning, "id-kp-codeSigning" },
+	{ 1401, 8, id_kp_emailProtection, "id-kp-emailProtection" },
+	{ 1409, 8, id_kp_ipsecEndSystem, "id-kp-ipsecEndSystem" },
+	{ 1417, 8, id_kp_ipsecTunnel, "id-kp-ipsecTunnel" },
+	{ 1425, 8, id_kp_ipsecUser, "id-kp-ipsecUser" },
+	{ 1433, 8, id_kp_timeStamping, "id-kp-timeStamping" },
+	{ 1441, 8, id_kp_OCSPSigning, "id-kp-OCSPSigning" },
+	{ 1449, 8, id_kp_cmcCA, "id-kp-cmcCA" },
+	{ 1457, 8, id_kp_cmcRA, "id-kp-cmcRA" },
+	{ 1465, 8, id_alg_noSignature, "id-alg-noSignature" },
+	{ 1473, 8, id_RSASSA_PSS_SHAKE128, "id-RSASSA-PSS-SHAKE128" },
+	{ 1481, 8, id_RSASSA_PSS_SHAKE256, "id-RSASSA-PSS-SHAKE256" },
+	{ 1489, 8, id_ecdsa_with_shake128, "id-ecdsa-with-shake128" },
+	{ 1497, 8, id_ecdsa_with_shake256, "id-ecdsa-with-shake256" },
+	{ 1505, 8, id_cmc_statusInfo, "id-cmc-statusInfo" },
+	{ 1513, 8, id_cmc_identification, "id-cmc-identification" },
+	{ 1521, 8, id_cmc_identityProof, "id-cmc-identityProof" },
+	{ 1529, 8, id_cmc_dataReturn, "id-cmc-dataReturn" },
+	{ 1537, 8, id_cmc_transactionId, "id-cmc-transactionId" },
+	{ 1545, 8, id_cmc_senderNonce, "id-cmc-senderNonce" },
+	{ 1553, 8, id_cmc_recipientNonce, "id-cmc-recipientNonce" },
+	{ 1561, 8, id_cmc_addExtensions, "id-cmc-addExtensions" },
+	{ 1569, 8, id_cmc_encryptedPOP, "id-cmc-encryptedPOP" },
+	{ 1577, 8, id_cmc_decryptedPOP, "id-cmc-decryptedPOP" },
+	{ 1585, 8, id_cmc_lraPOPWitness, "id-cmc-lraPOPWitness" },
+	{ 1593, 8, id_cmc_getCert, "id-cmc-getCert" },
+	{ 1601, 8, id_cmc_getCRL, "id-cmc-getCRL" },
+	{ 1609, 8, id_cmc_revokeRequest, "id-cmc-revokeRequest" },
+	{ 1617, 8, id_cmc_regInfo, "id-cmc-regInfo" },
+	{ 1625, 8, id_cmc_responseInfo, "id-cmc-responseInfo" },
+	{ 1633, 8, id_cmc_queryPending, "id-cmc-queryPending" },
+	{ 1641, 8, id_cmc_popLinkRandom, "id-cmc-popLinkRandom" },
+	{ 1649, 8, id_cmc_popLinkWitness, "id-cmc-popLinkWitness" },
+	{ 1657, 8, id_cmc_confirmCertAcceptance, "id-cmc-confirmCertAcceptance" },
+	{ 1665, 8, id_cmc_statusInfoV2, "id-cmc-statusInfoV2" },
+	{ 1673, 8, id_cmc_trustedAnchors, "id-cmc-trustedAnchors" },
+	{ 1681, 8, id_cmc_authData, "id-cmc-authData" },
+	{ 1689, 8, id_cmc_batchRequests, "id-cmc-batchRequests" },
+	{ 1697, 8, id_cmc_batchResponses, "id-cmc-batchResponses" },
+	{ 1705, 8, id_cmc_publishCert, "id-cmc-publishCert" },
+	{ 1713, 8, id_cmc_modCertTemplate, "id-cmc-modCertTemplate" },
+	{ 1721, 8, id_cmc_controlProcessed, "id-cmc-controlProcessed" },
+	{ 1729, 8, id_cmc_popLinkWitnessV2, "id-cmc-popLinkWitnessV2" },
+	{ 1737, 8, id_cmc_identityProofV2, "id-cmc-identityProofV2" },
+	{ 1745, 8, id_cmc_raIdentityWitness, "id-cmc-raIdentityWitness" },
+	{ 1753, 8, id_cmc_changeSubjectName, "id-cmc-changeSubjectName" },
+	{ 1761, 8, id_cmc_responseBody, "id-cmc-responseBody" },
+	{ 1769, 8, id_on_SmtpUTF8Mailbox, "id-on-SmtpUTF8Mailbox" },
+	{ 1777, 8, pkcs_9_at_dateOfBirth, "pkcs-9-at-dateOfBirth" },
+	{ 1785, 8, pkcs_9_at_placeOfBirth, "pkcs-9-at-placeOfBirth" },
+	{ 1793, 8, pkcs_9_at_gender, "pkcs-9-at-gender" },
+	{ 1801, 8, pkcs_9_at_countryOfCitizenship, "pkcs-9-at-countryOfCitizenship" },
+	{ 1809, 8, pkcs_9_at_countryOfResidence, "pkcs-9-at-countryOfResidence" },
+	{ 1817, 8, id_qcs_pkixQCSyntax_v1, "id-qcs-pkixQCSyntax-v1" },
+	{ 1825, 8, id_qcs_pkixQCSyntax_v2, "id-qcs-pkixQCSyntax-v2" },
+	{ 1833, 8, id_cct_PKIData, "id-cct-PKIData" },
+	{ 1841, 8, id_cct_PKIResponse, "id-cct-PKIResponse" },
+	{ 1849, 8, id_logo_loyalty, "id-logo-loyalty" },
+	{ 1857, 8, id_logo_background, "id-logo-background" },
+	{ 1865, 8, id_ad_ocsp, "id-ad-ocsp" },
+	{ 1873, 8, id_ad_caIssuers, "id-ad-caIssuers" },
+	{ 1881, 8, id_ad_timeStamping, "id-ad-timeStamping" },
+	{ 1889, 8, id_ad_caRepository, "id-ad-caRepository" },
+	{ 1897, 8, id_ad_cmc, "id-ad-cmc" },
+	{ 1905, 8, Buypass_EV_CPS, "Buypass_EV_CPS" },
+	{ 1913, 8, hashAlgs, "hashAlgs" },
+	{ 1921, 8, sigAlgs, "sigAlgs" },
+	{ 1929, 8, NetscapeCertificateExtension, "NetscapeCertificateExtension" },
+	{ 1937, 9, SHECA_EV_CPS, "SHECA_EV_CPS" },
+	{ 1946, 9, SM2_1_Digital_Siganture_Algorithm, "SM2-1_Digital_Siganture_Algorithm" },
+	{ 1955, 9, SM2_2_Key_Exchange_Protocol, "SM2-2_Key_Exchange_Protocol" },
+	{ 1964, 9, SM2_3_Public_Key_Encryption, "SM2-3_Public_Key_Encryption" },
+	{ 1973, 9, SM9_1_Digital_Signature_Algorithm, "SM9-1_Digital_Signature_Algorithm" },
+	{ 1982, 9, SM9_2_Key_Exchange_Protocol, "SM9-2_Key_Exchange_Protocol" },
+	{ 1991, 9, SM9_3_Public_Key_Encryptio, "SM9-3_Public_Key_Encryptio" },
+	{ 2000, 9, SM3_Hash_Without_Key, "SM3_Hash_Without_Key" },
+	{ 2009, 9, SM3_Hash_With_Key, "SM3_Hash_With_Key" },
+	{ 2018, 9, ZUC_Standard, "ZUC_Standard" },
+	{ 2027, 9, SM4_Standard, "SM4_Standard" },
+	{ 2036, 9, SM2_Standard, "SM2_Standard" },
+	{ 2045, 9, SM3_Standard, "SM3_Standard" },
+	{ 2054, 9, Crypto_ID, "Crypto_ID" },
+	{ 2063, 9, SM2_Specificate, "SM2_Specificate" },
+	{ 2072, 9, SM2_Cryptographic_Message_Syntax, "SM2_Cryptographic_Message_Syntax" },
+	{ 2081, 9, rsaEncryption, "rsaEncryption" },
+	{ 2090, 9, md2WithRSAEncryption, "md2WithRSAEncryption" },
+	{ 2099, 9, md5WithRSAEncryption, "md5WithRSAEncryption" },
+	{ 2108, 9, sha1WithRSAEncryption, "sha1WithRSAEncryption" },
+	{ 2117, 9, id_RSAES_OAEP, "id-RSAES-OAEP" },
+	{ 2126, 9, id_mgf1, "id-mgf1" },
+	{ 2135, 9, id_pSpecified, "id-pSpecified" },
+	{ 2144, 9, id_RSASSA_PSS, "id-RSASSA-PSS" },
+	{ 2153, 9, sha256WithRSAEncryption, "sha256WithRSAEncryption" },
+	{ 2162, 9, sha384WithRSAEncryption, "sha384WithRSAEncryption" },
+	{ 2171, 9, sha512WithRSAEncryption, "sha512WithRSAEncryption" },
+	{ 2180, 9, sha224WithRSAEncryption, "sha224WithRSAEncryption" },
+	{ 2189, 9, sha512_224WithRSAEncryption, "sha512-224WithRSAEncryption" },
+	{ 2198, 9, sha512_256WithRSAEncryption, "sha512-256WithRSAEncryption" },
+	{ 2207, 9, pkcs_9_mo, "pkcs-9-mo" },
+	{ 2216, 9, emailAddress, "emailAddress" },
+	{ 2225, 9, pkcs_9_at_unstructuredName, "pkcs-9-at-unstructuredName" },
+	{ 2234, 9, pkcs_9_at_contentType, "pkcs-9-at-contentType" },
+	{ 2243, 9, pkcs_9_at_messageDigest, "pkcs-9-at-messageDigest" },
+	{ 2252, 9, pkcs_9_at_signingTime, "pkcs-9-at-signingTime" },
+	{ 2261, 9, pkcs_9_at_counterSignature, "pkcs-9-at-counterSignature" },
+	{ 2270, 9, pkcs_9_at_challengePassword, "pkcs-9-at-challengePassword" },
+	{ 2279, 9, pkcs_9_at_unstructuredAddress, "pkcs-9-at-unstructuredAddress" },
+	{ 2288, 9, pkcs_9_at_extendedCertificateAttributes, "pkcs-9-at-extendedCertificateAttributes" },
+	{ 2297, 9, pkcs_9_at_signingDescription, "pkcs-9-at-signingDescription" },
+	{ 2306, 9, pkcs_9_at_extensionRequest, "pkcs-9-at-extensionRequest" },
+	{ 2315, 9, pkcs_9_at_smimeCapabilities, "pkcs-9-at-smimeCapabilities" },
+	{ 2324, 9, smime, "smime" },
+	{ 2333, 9, pkcs_9_at_friendlyName, "pkcs-9-at-friendlyName" },
+	{ 2342, 9, pkcs_9_at_localKeyId, "pkcs-9-at-localKeyId" },
+	{ 2351, 9, certTypes, "certTypes" },
+	{ 2360, 9, crlTypes, "crlTypes" },
+	{ 2369, 9, pkcs_9_oc, "pkcs-9-oc" },
+	{ 2378, 9, pkcs_9_at, "pkcs-9-at" },
+	{ 2387, 9, pkcs_9_sx, "pkcs-9-sx" },
+	{ 2396, 9, pkcs_9_mr, "pkcs-9-mr" },
+	{ 2405, 9, gnBasis, "gnBasis" },
+	{ 2414, 9, tpBasis, "tpBasis" },
+	{ 2423, 9, ppBasis, "ppBasis" },
+	{ 2432, 9, Cisco_ACT2_SUDI, "Cisco_ACT2_SUDI" },
+	{ 2441, 9, StartCom_Certification_Authority_EV_CPS, "StartCom_Certification_Authority_EV_CPS" },
+	{ 2450, 9, OID_CTL, "OID_CTL" },
+	{ 2459, 9, szOID_NEXT_UPDATE_LOCATION, "szOID_NEXT_UPDATE_LOCATION" },
+	{ 2468, 9, szOID_MICROSOFT_RDN_PREFIX, "szOID_MICROSOFT_RDN_PREFIX" },
+	{ 2477, 9, szOID_CERT_PROP_ID_PREFIX, "szOID_CERT_PROP_ID_PREFIX" },
+	{ 2486, 9, szOID_RENEWAL_CERTIFICATE, "szOID_RENEWAL_CERTIFICATE" },
+	{ 2495, 9, szOID_MICROSOFT_Encryption_Key_Preference, "szOID_MICROSOFT_Encryption_Key_Preference" },
+	{ 2504, 9, szOID_LOCAL_MACHINE_KEYSET, "szOID_LOCAL_MACHINE_KEYSET" },
+	{ 2513, 9, szOID_PKIX_LICENSE_INFO, "szOID_PKIX_LICENSE_INFO" },
+	{ 2522, 9, szOID_PKIX_MANUFACTURER, "szOID_PKIX_MANUFACTURER" },
+	{ 2531, 9, szOID_PKIX_MANUFACTURER_MS_SPECIFIC, "szOID_PKIX_MANUFACTURER_MS_SPECIFIC" },
+	{ 2540, 9, szOID_PKIX_HYDRA_CERT_VERSION, "szOID_PKIX_HYDRA_CERT_VERSION" },
+	{ 2549, 9, szOID_PKIX_LICENSED_PRODUCT_INFO, "szOID_PKIX_LICENSED_PRODUCT_INFO" },
+	{ 2558, 9, szOID_PKIX_MS_LICENSE_SERVER_INFO, "szOID_PKIX_MS_LICENSE_SERVER_INFO" },
+	{ 2567, 9, szOID_PKIS_PRODUCT_SPECIFIC_OID, "szOID_PKIS_PRODUCT_SPECIFIC_OID" },
+	{ 2576, 9, szOID_PKIS_TLSERVER_SPK_OID, "szOID_PKIS_TLSERVER_SPK_OID" },
+	{ 2585, 9, szOID_AUTO_ENROLL_CTL_USAGE, "szOID_AUTO_ENROLL_CTL_USAGE" },
+	{ 2594, 9, szOID_ENROLL_CERTTYPE_EXTENSION, "szOID_ENROLL_CERTTYPE_EXTENSION" },
+	{ 2603, 9, szOID_CERT_MANIFOLD, "szOID_CERT_MANIFOLD" },
+	{ 2612, 9, szOID_CERTSRV_CA_VERSION, "szOID_CERTSRV_CA_VERSION" },
+	{ 2621, 9, szOID_CERTSRV_PREVIOUS_CERT_HASH, "szOID_CERTSRV_PREVIOUS_CERT_HASH" },
+	{ 2630, 9, szOID_CRL_VIRTUAL_BASE, "szOID_CRL_VIRTUAL_BASE" },
+	{ 2639, 9, szOID_CRL_NEXT_PUBLISH, "szOID_CRL_NEXT_PUBLISH" },
+	{ 2648, 9, szOID_KP_CA_EXCHANGE, "szOID_KP_CA_EXCHANGE" },
+	{ 2657, 9, szOID_KP_KEY_RECOVERY_AGENT, "szOID_KP_KEY_RECOVERY_AGENT" },
+	{ 2666, 9, szOID_CERTIFICATE_TEMPLATE, "szOID_CERTIFICATE_TEMPLATE" },
+	{ 2675, 9, szOID_ENTERPRISE_OID_ROOT, "szOID_ENTERPRISE_OID_ROOT" },
+	{ 2684, 9, szOID_RDN_DUMMY_SIGNER, "szOID_RDN_DUMMY_SIGNER" },
+	{ 2693, 9, szOID_APPLICATION_CERT_POLICIES, "szOID_APPLICATION_CERT_POLICIES" },
+	{ 2702, 9, szOID_APPLICATION_POLICY_MAPPINGS, "szOID_APPLICATION_POLICY_MAPPINGS" },
+	{ 2711, 9, szOID_APPLICATION_POLICY_CONSTRAINTS, "szOID_APPLICATION_POLICY_CONSTRAINTS" },
+	{ 2720, 9, szOID_ARCHIVED_KEY_ATTR, "szOID_ARCHIVED_KEY_ATTR" },
+	{ 2729, 9, szOID_CRL_SELF_CDP, "szOID_CRL_SELF_CDP" },
+	{ 2738, 9, szOID_REQUIRE_CERT_CHAIN_POLICY, "szOID_REQUIRE_CERT_CHAIN_POLICY" },
+	{ 2747, 9, szOID_ARCHIVED_KEY_CERT_HASH, "szOID_ARCHIVED_KEY_CERT_HASH" },
+	{ 2756, 9, szOID_ISSUED_CERT_HASH, "szOID_ISSUED_CERT_HASH" },
+	{ 2765, 9, szOID_DS_EMAIL_REPLICATION, "szOID_DS_EMAIL_REPLICATION" },
+	{ 2774, 9, szOID_REQUEST_CLIENT_INFO, "szOID_REQUEST_CLIENT_INFO" },
+	{ 2783, 9, szOID_ENCRYPTED_KEY_HASH, "szOID_ENCRYPTED_KEY_HASH" },
+	{ 2792, 9, szOID_CERTSRV_CROSSCA_VERSION, "szOID_CERTSRV_CROSSCA_VERSION" },
+	{ 2801, 9, szOID_NTDS_REPLICATION, "szOID_NTDS_REPLICATION" },
+	{ 2810, 9, szOID_IIS_VIRTUAL_SERVER, "szOID_IIS_VIRTUAL_SERVER" },
+	{ 2819, 9, szOID_PRODUCT_UPDATE, "szOID_PRODUCT_UPDATE" },
+	{ 2828, 9, szOID_PEERNET_PNRP, "szOID_PEERNET_PNRP" },
+	{ 2837, 9, szOID_PEERNET_IDENTITY, "szOID_PEERNET_IDENTITY" },
+	{ 2846, 9, szOID_PEERNET_GROUPING, "szOID_PEERNET_GROUPING" },
+	{ 2855, 9, szOID_CAPICOM_VERSION, "szOID_CAPICOM_VERSION" },
+	{ 2864, 9, szOID_CAPICOM_ATTRIBUTE, "szOID_CAPICOM_ATTRIBUTE" },
+	{ 2873, 9, szOID_CAPICOM_ENCRYPTED_DATA, "szOID_CAPICOM_ENCRYPTED_DATA" },
+	{ 2882, 9, WoSign_EV_CPS, "WoSign_EV_CPS" },
+	{ 2891, 9, GlobalSign_EV_CPS, "GlobalSign_EV_CPS" },
+	{ 2900, 9, GeoTrust_EV_CPS, "GeoTrust_EV_CPS" },
+	{ 2909, 9, id_pkix_ocsp_basic, "id-pkix-ocsp-basic" },
+	{ 2918, 9, id_pkix_ocsp_nonce, "id-pkix-ocsp-nonce" },
+	{ 2927, 9, id_pkix_ocsp_crl, "id-pkix-ocsp-crl" },
+	{ 2936, 9, id_pkix_ocsp_response, "id-pkix-ocsp-response" },
+	{ 2945, 9, id_pkix_ocsp_nocheck, "id-pkix-ocsp-nocheck" },
+	{ 2954, 9, id_pkix_ocsp_archive_cutoff, "id-pkix-ocsp-archive-cutoff" },
+	{ 2963, 9, id_pkix_ocsp_service_locator, "id-pkix-ocsp-service-locator" },
+	{ 2972, 9, id_pkix_ocsp_pref_sig_algs, "id-pkix-ocsp-pref-sig-algs" },
+	{ 2981, 9, id_pkix_ocsp_extended_revoke, "id-pkix-ocsp-extended-revoke" },
+	{ 2990, 9, Logius_PKIoverheid_EV_CPS, "Logius_PKIoverheid_EV_CPS" },
+	{ 2999, 9, SwissSign_EV_CPS, "SwissSign_EV_CPS" },
+	{ 3008, 9, E_Tugra_EV_CPS, "E-Tugra_EV_CPS" },
+	{ 3017, 9, id_keyExchangeAlgorithm, "id-keyExchangeAlgorithm" },
+	{ 3026, 9, id_sha256, "id-sha256" },
+	{ 3035, 9, id_sha384, "id-sha384" },
+	{ 3044, 9, id_sha512, "id-sha512" },
+	{ 3053, 9, id_sha224, "id-sha224" },
+	{ 3062, 9, id_shake128, "id-shake128" },
+	{ 3071, 9, id_shake256, "id-shake256" },
+	{ 3080, 9, id_hmacWithSHA3_224, "id-hmacWithSHA3-224" },
+	{ 3089, 9, id_hmacWithSHA3_256, "id-hmacWithSHA3-256" },
+	{ 3098, 9, id_hmacWithSHA3_384, "id-hmacWithSHA3-384" },
+	{ 3107, 9, id_hmacWithSHA3_512, "id-hmacWithSHA3-512" },
+	{ 3116, 9, id_KmacWithSHAKE128, "id-KmacWithSHAKE128" },
+	{ 3125, 9, id_KmacWithSHAKE256, "id-KmacWithSHAKE256" },
+	{ 3134, 9, id_dsa_with_sha224, "id-dsa-with-sha224" },
+	{ 3143, 9, id_dsa_with_sha256, "id-dsa-with-sha256" },
+	{ 3152, 9, id_ecdsa_with_sha3_224, "id-ecdsa-with-sha3-224" },
+	{ 3161, 9, id_ecdsa_with_sha3_256, "id-ecdsa-with-sha3-256" },
+	{ 3170, 9, id_ecdsa_with_sha3_384, "id-ecdsa-with-sha3-384" },
+	{ 3179, 9, id_ecdsa_with_sha3_512, "id-ecdsa-with-sha3-512" },
+	{ 3188, 9, id_rsassa_pkcs1_v1_5_with_sha3_224, "id-rsassa-pkcs1-v1_5-with-sha3-224" },
+	{ 3197, 9, id_rsassa_pkcs1_v1_5_with_sha3_256, "id-rsassa-pkcs1-v1_5-with-sha3-256" },
+	{ 3206, 9, id_rsassa_pkcs1_v1_5_with_sha3_384, "id-rsassa-pkcs1-v1_5-with-sha3-384" },
+	{ 3215, 9, id_rsassa_pkcs1_v1_5_with_sha3_512, "id-rsassa-pkcs1-v1_5-with-sha3-512" },
+	{ 3224, 9, NetscapeCertType, "NetscapeCertType" },
+	{ 3233, 9, RevocationURL, "RevocationURL" },
+	{ 3242, 9, CaRevocationURL, "CaRevocationURL" },
+	{ 3251, 9, SSLServerName, "SSLServerName" },
+	{ 3260, 9, NetscapeCertificateComment, "NetscapeCertificateComment" },
+	{ 3269, 9, DigiCert_EV_CPS, "DigiCert_EV_CPS" },
+	{ 3278, 10, user_id, "user_id" },
+	{ 3288, 10, domain_component, "domain_component" },
+	{ 3298, 10, SECOM_Trust_Systems_EV_CPS, "SECOM_Trust_Systems_EV_CPS" },
+	{ 3308, 10, id_aa, "id-aa" },
+	{ 3318, 10, pkcs_9_oc_pkcsEntity, "pkcs-9-oc-pkcsEntity" },
+	{ 3328, 10, pkcs_9_oc_naturalPerson, "pkcs-9-oc-naturalPerson" },
+	{ 3338, 10, pkcs_9_at_pkcs15Token, "pkcs-9-at-pkcs15Token" },
+	{ 3348, 10, pkcs_9_at_encryptedPrivateKeyInfo, "pkcs-9-at-encryptedPrivateKeyInfo" },
+	{ 3358, 10, pkcs_9_at_randomNonce, "pkcs-9-at-randomNonce" },
+	{ 3368, 10, pkcs_9_at_sequenceNumber, "pkcs-9-at-sequenceNumber" },
+	{ 3378, 10, pkcs_9_at_pkcs7PDU, "pkcs-9-at-pkcs7PDU" },
+	{ 3388, 10, pkcs_9_sx_pkcs9String, "pkcs-9-sx-pkcs9String" },
+	{ 3398, 10, pkcs_9_sx_signingTime, "pkcs-9-sx-signingTime" },
+	{ 3408, 10, pkcs_9_mr_caseIgnoreMatch, "pkcs-9-mr-caseIgnoreMatch" },
+	{ 3418, 10, pkcs_9_mr_signingTimeMatch, "pkcs-9-mr-signingTimeMatch" },
+	{ 3428, 10, SPC_INDIRECT_DATA_OBJID, "SPC_INDIRECT_DATA_OBJID" },
+	{ 3438, 10, SPC_SP_AGENCY_INFO_OBJID, "SPC_SP_AGENCY_INFO_OBJID" },
+	{ 3448, 10, SPC_STATEMENT_TYPE_OBJID, "SPC_STATEMENT_TYPE_OBJID" },
+	{ 3458, 10, SPC_SP_OPUS_INFO_OBJID, "SPC_SP_OPUS_INFO_OBJID" },
+	{ 3468, 10, SPC_CERT_EXTENSIONS_OBJID, "SPC_CERT_EXTENSIONS_OBJID" },
+	{ 3478, 10, SPC_PE_IMAGE_DATA_OBJID, "SPC_PE_IMAGE_DATA_OBJID" },
+	{ 3488, 10, SPC_RAW_FILE_DATA_OBJID, "SPC_RAW_FILE_DATA_OBJID" },
+	{ 3498, 10, SPC_STRUCTURED_STORAGE_DATA_OBJID, "SPC_STRUCTURED_STORAGE_DATA_OBJID" },
+	{ 3508, 10, SPC_JAVA_CLASS_DATA_OBJID, "SPC_JAVA_CLASS_DATA_OBJID" },
+	{ 3518, 10, SPC_INDIVIDUAL_SP_KEY_PURPOSE_OBJID, "SPC_INDIVIDUAL_SP_KEY_PURPOSE_OBJID" },
+	{ 3528, 10, SPC_COMMERCIAL_SP_KEY_PURPOSE_OBJID, "SPC_COMMERCIAL_SP_KEY_PURPOSE_OBJID" },
+	{ 3538, 10, SPC_CAB_DATA_OBJID, "SPC_CAB_DATA_OBJID" },
+	{ 3548, 10, SPC_MINIMAL_CRITERIA_OBJID, "SPC_MINIMAL_CRITERIA_OBJID" },
+	{ 3558, 10, SPC_FINANCIAL_CRITERIA_OBJID, "SPC_FINANCIAL_CRITERIA_OBJID" },
+	{ 3568, 10, SPC_LINK_OBJID, "SPC_LINK_OBJID" },
+	{ 3578, 10, SPC_HASH_INFO_OBJID, "SPC_HASH_INFO_OBJID" },
+	{ 3588, 10, SPC_SIPINFO_OBJID, "SPC_SIPINFO_OBJID" },
+	{ 3598, 10, szOID_TRUSTED_CODESIGNING_CA_LIST, "szOID_TRUSTED_CODESIGNING_CA_LIST" },
+	{ 3608, 10, szOID_TRUSTED_CLIENT_AUTH_CA_LIST, "szOID_TRUSTED_CLIENT_AUTH_CA_LIST" },
+	{ 3618, 10, szOID_TRUSTED_SERVER_AUTH_CA_LIST, "szOID_TRUSTED_SERVER_AUTH_CA_LIST" },
+	{ 3628, 10, SPC_TIME_STAMP_REQUEST_OBJID, "SPC_TIME_STAMP_REQUEST_OBJID" },
+	{ 3638, 10, szOID_SORTED_CTL, "szOID_SORTED_CTL" },
+	{ 3648, 10, szOID_KP_CTL_USAGE_SIGNING, "szOID_KP_CTL_USAGE_SIGNING" },
+	{ 3658, 10, szOID_KP_TIME_STAMP_SIGNING, "szOID_KP_TIME_STAMP_SIGNING" },
+	{ 3668, 10, szOID_SERVER_GATED_CRYPTO, "szOID_SERVER_GATED_CRYPTO" },
+	{ 3678, 10, szOID_EFS_CRYPTO, "szOID_EFS_CRYPTO" },
+	{ 3688, 10, szOID_WHQL_CRYPTO, "szOID_WHQL_CRYPTO" },
+	{ 3698, 10, szOID_NT5_CRYPTO, "szOID_NT5_CRYPTO" },
+	{ 3708, 10, szOID_OEM_WHQL_CRYPTO, "szOID_OEM_WHQL_CRYPTO" },
+	{ 3718, 10, szOID_EMBEDDED_NT_CRYPTO, "szOID_EMBEDDED_NT_CRYPTO" },
+	{ 3728, 10, OID_ROOT_LIST_SIGNER, "OID_ROOT_LIST_SIGNER" },
+	{ 3738, 10, szOID_KP_QUALIFIED_SUBORDINATION, "szOID_KP_QUALIFIED_SUBORDINATION" },
+	{ 3748, 10, szOID_KP_KEY_RECOVERY, "szOID_KP_KEY_RECOVERY" },
+	{ 3758, 10, szOID_KP_DOCUMENT_SIGNING, "szOID_KP_DOCUMENT_SIGNING" },
+	{ 3768, 10, szOID_KP_LIFETIME_SIGNING, "szOID_KP_LIFETIME_SIGNING" },
+	{ 3778, 10, szOID_KP_MOBILE_DEVICE_SOFTWARE, "szOID_KP_MOBILE_DEVICE_SOFTWARE" },
+	{ 3788, 10, szOID_YESNO_TRUST_ATTR, "szOID_YESNO_TRUST_ATTR" },
+	{ 3798, 10, szOID_DRM, "szOID_DRM" },
+	{ 3808, 10, szOID_DRM_INDIVIDUALIZATION, "szOID_DRM_INDIVIDUALIZATION" },
+	{ 3818, 10, szOID_LICENSES, "szOID_LICENSES" },
+	{ 3828, 10, szOID_LICENSE_SERVER, "szOID_LICENSE_SERVER" },
+	{ 3838, 10, szOID_KEYID_RDN, "szOID_KEYID_RDN" },
+	{ 3848, 10, szOID_REMOVE_CERTIFICATE, "szOID_REMOVE_CERTIFICATE" },
+	{ 3858, 10, szOID_CROSS_CERT_DIST_POINTS, "szOID_CROSS_CERT_DIST_POINTS" },
+	{ 3868, 10, szOID_CMC_ADD_ATTRIBUTES, "szOID_CMC_ADD_ATTRIBUTES" },
+	{ 3878, 10, OID_CERT_PROP_ID_METAEKUS, "OID_CERT_PROP_ID_METAEKUS" },
+	{ 3888, 10, CERT_FRIENDLY_NAME_PROP_ID, "CERT_FRIENDLY_NAME_PROP_ID" },
+	{ 3898, 10, OID_CERT_KEY_IDENTIFIER_PROP_ID, "OID_CERT_KEY_IDENTIFIER_PROP_ID" },
+	{ 3908, 10, OID_CERT_SUBJECT_NAME_MD5_HASH_PROP_ID, "OID_CERT_SUBJECT_NAME_MD5_HASH_PROP_ID" },
+	{ 3918, 10, CERT_ROOT_PROGRAM_CERT_POLICIES_PROP_ID, "CERT_ROOT_PROGRAM_CERT_POLICIES_PROP_ID" },
+	{ 3928, 10, OID_CERT_PROP_ID_PREFIX_98, "OID_CERT_PROP_ID_PREFIX_98" },
+	{ 3938, 10, OID_CERT_PROP_ID_PREFIX_105, "OID_CERT_PROP_ID_PREFIX_105" },
+	{ 3948, 10, szOID_ANY_APPLICATION_POLICY, "szOID_ANY_APPLICATION_POLICY" },
+	{ 3958, 10, szOID_CATALOG_LIST, "szOID_CATALOG_LIST" },
+	{ 3968, 10, szOID_CATALOG_LIST_MEMBER, "szOID_CATALOG_LIST_MEMBER" },
+	{ 3978, 10, CAT_NAMEVALUE_OBJID, "CAT_NAMEVALUE_OBJID" },
+	{ 3988, 10, CAT_MEMBERINFO_OBJID, "CAT_MEMBERINFO_OBJID" },
+	{ 3998, 10, szOID_ENROLLMENT_NAME_VALUE_PAIR, "szOID_ENROLLMENT_NAME_VALUE_PAIR" },
+	{ 4008, 10, szOID_ENROLLMENT_CSP_PROVIDER, "szOID_ENROLLMENT_CSP_PROVIDER" },
+	{ 4018, 10, szOID_OS_VERSION, "szOID_OS_VERSION" },
+	{ 4028, 10, szOID_ENROLLMENT_AGENT, "szOID_ENROLLMENT_AGENT" },
+	{ 4038, 10, szOID_KP_SMARTCARD_LOGON, "szOID_KP_SMARTCARD_LOGON" },
+	{ 4048, 10, szOID_NT_PRINCIPAL_NAME, "szOID_NT_PRINCIPAL_NAME" },
+	{ 4058, 10, szOID_PEERNET_CERT_TYPE, "szOID_PEERNET_CERT_TYPE" },
+	{ 4068, 10, szOID_PEERNET_PEERNAME, "szOID_PEERNET_PEERNAME" },
+	{ 4078, 10, szOID_PEERNET_CLASSIFIER, "szOID_PEERNET_CLASSIFIER" },
+	{ 4088, 10, szOID_PEERNET_CERT_VERSION, "szOID_PEERNET_CERT_VERSION" },
+	{ 4098, 10, szOID_PEERNET_PNRP_ADDRESS, "szOID_PEERNET_PNRP_ADDRESS" },
+	{ 4108, 10, szOID_PEERNET_PNRP_FLAGS, "szOID_PEERNET_PNRP_FLAGS" },
+	{ 4118, 10, szOID_PEERNET_PNRP_PAYLOAD, "szOID_PEERNET_PNRP_PAYLOAD" },
+	{ 4128, 10, szOID_PEERNET_PNRP_ID, "szOID_PEERNET_PNRP_ID" },
+	{ 4138, 10, szOID_PEERNET_IDENTITY_FLAGS, "szOID_PEERNET_IDENTITY_FLAGS" },
+	{ 4148, 10, szOID_PEERNET_GROUPING_PEERNAME, "szOID_PEERNET_GROUPING_PEERNAME" },
+	{ 4158, 10, szOID_PEERNET_GROUPING_FLAGS, "szOID_PEERNET_GROUPING_FLAGS" },
+	{ 4168, 10, szOID_PEERNET_GROUPING_ROLES, "szOID_PEERNET_GROUPING_ROLES" },
+	{ 4178, 10, szOID_PEERNET_GROUPING_CLASSIFIERS, "szOID_PEERNET_GROUPING_CLASSIFIERS" },
+	{ 4188, 10, OID_ROOT_PROGRAM_FLAGS_BITSTRING, "OID_ROOT_PROGRAM_FLAGS_BITSTRING" },
+	{ 4198, 10, driveEncryption, "driveEncryption" },
+	{ 4208, 10, szOID_CAPICOM_DOCUMENT_NAME, "szOID_CAPICOM_DOCUMENT_NAME" },
+	{ 4218, 10, szOID_CAPICOM_DOCUMENT_DESCRIPTION, "szOID_CAPICOM_DOCUMENT_DESCRIPTION" },
+	{ 4228, 10, szOID_CAPICOM_ENCRYPTED_CONTENT, "szOID_CAPICOM_ENCRYPTED_CONTENT" },
+	{ 4238, 10, AffirmTrust_EV_CPS, "AffirmTrust_EV_CPS" },
+	{ 4248, 10, AffirmTrust_EV_CPS_1_, "AffirmTrust_EV_CPS[1]" },
+	{ 4258, 10, AffirmTrust_EV_CPS_2_, "AffirmTrust_EV_CPS[2]" },
+	{ 4268, 10, AffirmTrust_EV_CPS_3_, "AffirmTrust_EV_CPS[3]" },
+	{ 4278, 10, Verizon_Business_EV_CPS, "Verizon_Business_EV_CPS" },
+	{ 4288, 10, T_Systems_EV_CPS, "T-Systems_EV_CPS" },
+	{ 4298, 10, id_ce_SignedCertificateTimestampList, "id-ce-SignedCertificateTimestampList" },
+	{ 4308, 10, id_ad_ocsp_SignedCertificateTimestampList, "id-ad-ocsp-SignedCertificateTimestampList" },
+	{ 4318, 10, Izenpe_EV_CPS, "Izenpe_EV_CPS" },
+	{ 4328, 10, Entrust_EV_CPS, "Entrust_EV_CPS" },
+	{ 4338, 10, Wells_Fargo_EV_CPS, "Wells_Fargo_EV_CPS" },
+	{ 4348, 11, id_aa_cmc_unsignedData, "id-aa-cmc-unsignedData" },
+	{ 4359, 11, StartCom_Certification_Authority_EV_CPS_1_, "StartCom_Certification_Authority_EV_CPS[1]" },
+	{ 4370, 11, szOID_SERIALIZED, "szOID_SERIALIZED" },
+	{ 4381, 11, szOID_EFS_RECOVERY, "szOID_EFS_RECOVERY" },
+	{ 4392, 11, jurisdiction_of_incorporation_locality_name, "jurisdiction_of_incorporation_locality_name" },
+	{ 4403, 11, jurisdiction_of_incorporation_state_or_province_name, "jurisdiction_of_incorporation_state_or_province_name" },
+	{ 4414, 11, jurisdiction_of_incorporation_country_name, "jurisdiction_of_incorporation_country_name" },
+	{ 4425, 11, D_TRUST_EV_CPS, "D-TRUST_EV_CPS" },
+	{ 4436, 11, Firmaprofesional_EV_CPS, "Firmaprofesional_EV_CPS" },
+	{ 4447, 11, Kamu_Sertifikasyon_Merkezi_EV_CPS, "Kamu_Sertifikasyon_Merkezi_EV_CPS" },
+	{ 4458, 11, pkcs_9_at_userPKCS12, "pkcs-9-at-userPKCS12" },
+	{ 4469, 11, Symantec_EV_CPS, "Symantec_EV_CPS" },
+	{ 4480, 11, Thawte_EV_CPS, "Thawte_EV_CPS" },
+	{ 4491, 11, DigiCert_EV_CPS_1_, "DigiCert_EV_CPS[1]" },
+	{ 4502, 11, Go_Daddy_EV_CPS, "Go_Daddy_EV_CPS" },
+	{ 4513, 11, Starfield_Technologies_EV_CPS, "Starfield_Technologies_EV_CPS" },
+	{ 4524, 12, Network_Solutions__EV_CPS, "Network_Solutions__EV_CPS" },
+	{ 4536, 12, Comodo_Group_EV_CPS, "Comodo_Group_EV_CPS" },
+	{ 4548, 12, QuoVadis_EV_CPS, "QuoVadis_EV_CPS" },
+	{ 4560, 12, Trustwave_EV_CPS, "Trustwave_EV_CPS" },
+	{ 4572, 13, Camerfirma_EV_CPS_1_, "Camerfirma_EV_CPS[1]" },
+	{ 4585, 13, Camerfirma_EV_CPS, "Camerfirma_EV_CPS" },
+	{ 4598, 13, OpenTrust_DocuSign_France_EV_CPS, "OpenTrust_DocuSign_France_EV_CPS" },
+	{ 4611, 14, DigiNotar_EV_CPS, "DigiNotar_EV_CPS" },
+};
+
+static constexpr size_t max_oid_length = 14;
+
+// the entries in oid_table with length n are those with indices
+// from oid_index[n] up to (but not including) oid_index[n+1]
+//
+static constexpr uint16_t oid_index[max_oid_length + 2] = { 0, 0, 1, 4, 78, 81, 102, 116, 169, 311, 460, 567, 583, 587, 590, 591 };
+
+static constexpr char oid_empty_string[] = { '\0' };
+
+// find_oid() returns the entry in oid_table for the OID whose DER
+// encoding is in its argument, or nullptr if that OID is unknown
+//
+static const oid_entry *find_oid(const struct datum *p) {
+    if (p->data == nullptr || p->data_end <= p->data || p->length() > (ssize_t)max_oid_length) {
+        return nullptr;
+    }
+    size_t length = p->length();
+    size_t lo = oid_index[length];
+    size_t hi = oid_index[length + 1];
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = ::memcmp(oid_bytes + oid_table[mid].offset, p->data, length);
+        if (cmp == 0) {
+            return &oid_table[mid];
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return nullptr;
+}
+
+// datum_get_oid_string() returns a null-terminated printable string
+// associated with the OID represented by its argument, or NULL if the
+// OID is unknown
+//
+static const char *get_string(const struct datum *p) {
+    const oid_entry *e = find_oid(p);
+    if (e == nullptr) {
+        return oid_empty_string;
+    }
+    return e->name;
+}
+
+// datum_get_oid_enum() returns an enumeration associated with the OID
+// represented by its argument; if there is no known OID that matches
+// the argument, then oid::unknown is returned
+//
+static enum type get_enum(const struct datum *p) {
+    const oid_entry *e = find_oid(p);
+    if (e == nullptr) {
+        return type::unknown;
+    }
+    return e->value;
+}
+};
+
+#endif // #ifndef OID.h
@@ -628,6 +628,17 @@ public:
     std::ofstream &get_ofstream() { return outfile; }
 };
 
+// enum_name(name) returns the enumeration name for the OID name,
+// which is the name with each character that cannot appear in a C++
+// identifier replaced by an underscore
+//
+std::string enum_name(std::string name) {
+    std::replace(name.begin(), name.end(), '-', '_');
+    std::replace(name.begin(), name.end(), '[', '_');
+    std::replace(name.begin(), name.end(), ']', '_');
+    return name;
+}
+
 void oid_set::dump_oid_enum_dict_sorted(char *progname) {
     using namespace std;
 
@@ -644,22 +655,38 @@ void oid_set::dump_oid_enum_dict_sorted(char *progname) {
     vector<pair<string, vector<uint32_t>>> ordered_dict(oid_dict.begin(), oid_dict.end());
     sort(ordered_dict.begin(), ordered_dict.end(), pair_cmp());
 
-    cc << "#include \"../bytestring.h\"\n";
-    cc << "#include <unordered_map>\n";
-    cc << "#include <string>\n\n";
-    cc << "std::unordered_map<std::basic_string<uint8_t>, std::string> &oid::get_oid_dict() {\n";
-    cc << "\tstatic std::unordered_map<std::basic_string<uint8_t>, std::string> oid_dict = {\n";
-    for (pair <string, vector<uint32_t>> x : ordered_dict) {
-        cc << "\t\t{ " << oid_to_hex_array(x.second) << ", \"" <<  x.first << "\" },\n";
+    // the lookup table holds the DER encoding of each OID along with
+    // its name and enumeration, sorted by the length of the encoding
+    // and then by its bytes, so that get_string() and get_enum() can
+    // find an OID with a binary search over the entries with the same
+    // length, without allocating memory; if two names have the same
+    // OID, the first one in ordered_dict is used
+    //
+    struct table_entry {
+        vector<uint8_t> der;
+        string name;
+    };
+    vector<table_entry> table;
+    set<vector<uint8_t>> seen;
+    for (const auto &x : ordered_dict) {
+        vector<uint8_t> der = oid_to_raw_string(x.second);
+        if (seen.insert(der).second) {
+            table.push_back({ der, x.first });
+        }
     }
-    cc << "\t};\n";
-    cc << "\treturn oid_dict;\n";
-    cc << "}\n\n";
+    stable_sort(table.begin(), table.end(), [](const table_entry &a, const table_entry &b) {
+        if (a.der.size() != b.der.size()) {
+            return a.der.size() < b.der.size();
+        }
+        return a.der < b.der;
+    });
+    size_t max_length = table.empty() ? 0 : table.back().der.size();
+
+    cc << "// the OID table is defined in oid.h, so that it is a compile-time\n";
+    cc << "// constant that needs no initialization at run time\n";
 
     h << "#include \"../datum.h\"\n";
-    h << "#include \"../bytestring.h\"\n";  // TODO: eliminate parent directory reference
-    h << "#include <unordered_map>\n";
-    h << "#include <string>\n";
+    h << "#include <cstring>\n";
     h << "#include <stdint.h>\n";
     h << "\n";
     h << "class oid {\n";
@@ -668,41 +695,90 @@ void oid_set::dump_oid_enum_dict_sorted(char *progname) {
     unsigned int oid_num = 0;
     h << "\t" << "unknown" << " = " <<  oid_num++ << ",\n";
     for (pair <string, vector<uint32_t>> x : ordered_dict) {
-        std::string tmp_string(x.first);
-        std::replace(tmp_string.begin(), tmp_string.end(), '-', '_');
-        std::replace(tmp_string.begin(), tmp_string.end(), '[', '_');
-        std::replace(tmp_string.begin(), tmp_string.end(), ']', '_');
-        h << "\t" << tmp_string << " = " <<  oid_num << ",\n";
-
-        //const auto &syn = synonym.find(x.first);
-        //if (syn != synonym.end()) {
-        //    std::cerr << syn->second << " is a synonym for " << x.first << std::endl;
-        //    std::string tmp_string2(syn->second);
-        //    std::replace(tmp_string2.begin(), tmp_string2.end(), '-', '_');
-        //    std::replace(tmp_string2.begin(), tmp_string2.end(), '[', '_');
-        //    std::replace(tmp_string2.begin(), tmp_string2.end(), ']', '_');
-        //    h << "\t" << tmp_string2 << " = " <<  oid_num << ",\n";
-        //}
-
+        h << "\t" << enum_name(x.first) << " = " <<  oid_num << ",\n";
         oid_num++;
     }
     h << "};\n\n";
-    h << "static std::unordered_map<std::basic_string<uint8_t>, std::string> &get_oid_dict();\n\n";
-    h << "static std::unordered_map<std::basic_string<uint8_t>, uint32_t> &get_oid_to_enum();\n";
-    h << "\n";
+
+    h << "// each oid_entry refers to the DER encoding of an OID, which is\n"
+         "// length bytes of oid_bytes starting at offset\n"
+         "//\n"
+         "struct oid_entry {\n"
+         "    uint16_t offset;\n"
+         "    uint8_t length;\n"
+         "    enum type value;\n"
+         "    const char *name;\n"
+         "};\n\n";
+
+    h << "static constexpr uint8_t oid_bytes[] = {\n";
+    for (const auto &e : table) {
+        h << "\t";
+        for (const auto &b : e.der) {
+            h << "0x" << raw_to_hex(b).first << raw_to_hex(b).second << ",";
+        }
+        h << "\n";
+    }
+    h << "};\n\n";
+
+    h << "// oid_table is sorted by length, then by bytes\n//\n";
+    h << "static constexpr oid_entry oid_table[] = {\n";
+    size_t offset = 0;
+    for (const auto &e : table) {
+        h << "\t{ " << offset << ", " << e.der.size() << ", " << enum_name(e.name) << ", \"" << e.name << "\" },\n";
+        offset += e.der.size();
+    }
+    h << "};\n\n";
+
+    h << "static constexpr size_t max_oid_length = " << max_length << ";\n\n";
+    h << "// the entries in oid_table with length n are those with indices\n"
+         "// from oid_index[n] up to (but not including) oid_index[n+1]\n"
+         "//\n";
+    h << "static constexpr uint16_t oid_index[max_oid_length + 2] = {";
+    size_t i = 0;
+    for (size_t n = 0; n <= max_length + 1; n++) {
+        while (i < table.size() && table[i].der.size() < n) {
+            i++;
+        }
+        h << (n ? ", " : " ") << i;
+    }
+    h << " };\n\n";
+
     h << "static constexpr char oid_empty_string[] = { '\\0' };\n\n";
+    h << "// find_oid() returns the entry in oid_table for the OID whose DER\n"
+         "// encoding is in its argument, or nullptr if that OID is unknown\n"
+         "//\n"
+         "static const oid_entry *find_oid(const struct datum *p) {\n"
+         "    if (p->data == nullptr || p->data_end <= p->data || p->length() > (ssize_t)max_oid_length) {\n"
+         "        return nullptr;\n"
+         "    }\n"
+         "    size_t length = p->length();\n"
+         "    size_t lo = oid_index[length];\n"
+         "    size_t hi = oid_index[length + 1];\n"
+         "    while (lo < hi) {\n"
+         "        size_t mid = (lo + hi) / 2;\n"
+         "        int cmp = ::memcmp(oid_bytes + oid_table[mid].offset, p->data, length);\n"
+         "        if (cmp == 0) {\n"
+         "            return &oid_table[mid];\n"
+         "        }\n"
+         "        if (cmp < 0) {\n"
+         "            lo = mid + 1;\n"
+         "        } else {\n"
+         "            hi = mid;\n"
+         "        }\n"
+         "    }\n"
+         "    return nullptr;\n"
+         "}\n"
+         "\n";
     h << "// datum_get_oid_string() returns a null-terminated printable string\n"
          "// associated with the OID represented by its argument, or NULL if the\n"
         "// OID is unknown\n"
         "//\n"
         "static const char *get_string(const struct datum *p) {\n"
-        "    std::basic_string<uint8_t> s = p->get_bytestring();\n"
-        "    static std::unordered_map<std::basic_string<uint8_t>, std::string> &oid_dict = get_oid_dict();\n"
-        "    auto pair = oid_dict.find(s);\n"
-        "    if (pair == oid_dict.end()) {\n"
+        "    const oid_entry *e = find_oid(p);\n"
+        "    if (e == nullptr) {\n"
         "        return oid_empty_string;\n"
         "    }\n"
-        "    return pair->second.c_str();\n"
+        "    return e->name;\n"
         "}\n"
         "\n"
         "// datum_get_oid_enum() returns an enumeration associated with the OID\n"
@@ -710,29 +786,13 @@ void oid_set::dump_oid_enum_dict_sorted(char *progname) {
         "// the argument, then oid::unknown is returned\n"
         "//\n"
         "static enum type get_enum(const struct datum *p) {\n"
-        "    std::basic_string<uint8_t> s = p->get_bytestring();\n"
-        "    static std::unordered_map<std::basic_string<uint8_t>, uint32_t> &oid_to_enum = get_oid_to_enum();\n"
-        "    auto pair = oid_to_enum.find(s);\n"
-        "    if (pair == oid_to_enum.end()) {\n"
+        "    const oid_entry *e = find_oid(p);\n"
+        "    if (e == nullptr) {\n"
         "        return type::unknown;\n"
         "    }\n"
-        "    return static_cast<type>(pair->second);\n"
+        "    return e->value;\n"
         "}\n";
     h << "};\n"; // end of class oid
-
-    cc << "\n";
-    cc << "std::unordered_map<std::basic_string<uint8_t>, uint32_t> &oid::get_oid_to_enum() {\n";
-    cc << "\tstatic std::unordered_map<std::basic_string<uint8_t>, uint32_t> oid_to_enum = {\n";
-    for (pair <string, vector<uint32_t>> x : ordered_dict) {
-        std::string tmp_string(x.first);
-        std::replace(tmp_string.begin(), tmp_string.end(), '-', '_');
-        std::replace(tmp_string.begin(), tmp_string.end(), '[', '_');
-        std::replace(tmp_string.begin(), tmp_string.end(), ']', '_');
-        cc << "\t\t{ " << oid_to_hex_array(x.second) << ", " <<  "oid::type::" << tmp_string << " },\n";
-    }
-    cc << "\t};\n";
-    cc << "\treturn oid_to_enum;\n";
-    cc << "}\n";
 }
 
 int main(int argc, char *argv[]) {
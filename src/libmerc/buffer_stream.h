@@ -14,6 +14,7 @@
 #include <time.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "text_encoding.hpp"
 
 #ifdef DONT_USE_STDERR
 #include "libmerc.h"
@@ -180,8 +181,23 @@ static char hex_table[] = {'0', '1', '2', '3',
                            '8', '9', 'a', 'b',
                            'c', 'd', 'e', 'f'};
 
-static inline int append_raw_as_hex(char *dstr, int *doff, int dlen, int *trunc,
-                                    const uint8_t *data, unsigned int len) {
+/* append_has_room
+ * returns true if length more bytes can be appended at *doff, in a
+ * way that leaves room for a null, by any sequence of the append_...()
+ * functions; when it does, a fast path that writes all of them directly
+ * is equivalent to that sequence
+ */
+static inline bool append_has_room(int doff, int dlen, size_t length) {
+    return doff < dlen && length < (size_t)(dlen - 1 - doff);
+}
+
+/* append_raw_as_hex_bytewise
+ * appends the hex encoding of data a byte at a time, checking for
+ * truncation after each block; append_raw_as_hex() uses it when the
+ * encoding might not fit in the buffer
+ */
+static inline int append_raw_as_hex_bytewise(char *dstr, int *doff, int dlen, int *trunc,
+                                             const uint8_t *data, unsigned int len) {
 
     if (*trunc == 1) {
         return 0;
@@ -212,6 +228,23 @@ static inline int append_raw_as_hex(char *dstr, int *doff, int dlen, int *trunc,
     return r;
 }
 
+static inline int append_raw_as_hex(char *dstr, int *doff, int dlen, int *trunc,
+                                    const uint8_t *data, unsigned int len) {
+
+    if (*trunc == 1 || len == 0) {
+        return 0;
+    }
+
+    size_t length = text_encoding::hex_length(len);
+    if (!append_has_room(*doff, dlen, length)) {
+        return append_raw_as_hex_bytewise(dstr, doff, dlen, trunc, data, len);
+    }
+    text_encoding::hex(dstr + *doff, data, len);
+    *doff += length;
+
+    return length;
+}
+
 
 static inline int append_json_hex_string(char *dstr, int *doff, int dlen, int *trunc,
                                          const char *key, const uint8_t *data, unsigned int len) {
@@ -251,56 +284,397 @@ static inline int append_json_hex_string(char *dstr, int *doff, int dlen, int *t
 }
 
 
-static inline int append_timestamp(char *dstr, int *doff, int dlen, int *trunc,
-                                   const struct timespec *ts) {
+/* append_string
+ * appends the length characters of sstr, which must not contain a
+ * null; the result is the same as that of append_strncpy(), including
+ * when the output is truncated, but when the string fits, it is
+ * written with a single check of the space available
+ */
+static inline int append_string(char *dstr, int *doff, int dlen, int *trunc,
+                                const char *sstr, size_t length) {
 
     if (*trunc == 1) {
         return 0;
     }
+    if (!append_has_room(*doff, dlen, length)) {
+        return append_strncpy(dstr, doff, dlen, trunc, sstr);
+    }
+    memcpy(dstr + *doff, sstr, length);
+    *doff += length;
 
-    int r = 0;
-    char outs[10 + 1 + 6]; /* 10 sec digits, 1 decimal, 6 usec */
+    return length;
+}
+
+/* append_json_key
+ * appends a quotation mark, key, and suffix, which is normally "\":"
+ * or "\":\""; the result is the same as that of append_putc() and two
+ * calls to append_strncpy(), including when the output is truncated.
+ * When key is a string literal, both lengths are known at compile time.
+ */
+static inline int append_json_key(char *dstr, int *doff, int dlen, int *trunc,
+                                  const char *key, size_t key_length,
+                                  const char *suffix, size_t suffix_length) {
+
+    if (*trunc == 1) {
+        return 0;
+    }
+    if (!append_has_room(*doff, dlen, 1 + key_length + suffix_length)) {
+        int r = append_putc(dstr, doff, dlen, trunc, '"');
+        r += append_strncpy(dstr, doff, dlen, trunc, key);
+        r += append_strncpy(dstr, doff, dlen, trunc, suffix);
+        return r;
+    }
+    char *out = dstr + *doff;
+    out[0] = '"';
+    memcpy(out + 1, key, key_length);
+    memcpy(out + 1 + key_length, suffix, suffix_length);
+    *doff += 1 + key_length + suffix_length;
 
-    /* First we convert the seconds to a string which requires
-     * that we identify and skip leading zeros */
-    int i = 0; /* outs index */
-    int leadin = 1; /* We're still getting leading zeros */
+    return 1 + key_length + suffix_length;
+}
 
+/*
+ * number and address formatting
+ *
+ * The format_...() functions write the text representation of a value
+ * into a buffer that is large enough for any value of its type, and
+ * return the number of characters written; they may also write
+ * scratch bytes past that number, within the maximum length.
+ * append_formatted() appends the output of one of them with a single
+ * check of the space available, writing directly into the buffer when
+ * it has room for the maximum length, and otherwise formatting into a
+ * local buffer and appending that with append_memcpy().
+ */
+
+template <size_t max_length, typename F>
+static inline int append_formatted(char *dstr, int *doff, int dlen, int *trunc, F format) {
+
+    if (*trunc == 1) {
+        return 0;
+    }
+    if (append_has_room(*doff, dlen, max_length)) {
+        size_t length = format(dstr + *doff);
+        *doff += length;
+        return length;
+    }
+    char outs[max_length];
+    size_t length = format(outs);
+
+    return append_memcpy(dstr, doff, dlen, trunc, outs, length);
+}
+
+static constexpr char decimal_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* decimal_length
+ * returns the number of decimal digits in u, estimating it from the
+ * number of bits in u and then correcting the estimate with a table
+ */
+static inline unsigned int decimal_length(uint64_t u) {
+    static constexpr uint64_t thresholds[20] = {
+        0, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000,
+        1000000000, 10000000000, 100000000000, 1000000000000,
+        10000000000000, 100000000000000, 1000000000000000,
+        10000000000000000, 100000000000000000, 1000000000000000000,
+        10000000000000000000u
+    };
+    unsigned int t = ((64 - __builtin_clzll(u | 1)) * 1233) >> 12;  /* approximately log10(2^bits) */
+    return t + 1 - (u < thresholds[t]);
+}
+
+static constexpr size_t max_uint64_length = 20;
+
+static inline size_t format_uint64(char *out, uint64_t u) {
+    unsigned int length = decimal_length(u);
+    char *p = out + length;
+    while (u >= 100) {
+        unsigned int i = (u % 100) * 2;
+        u /= 100;
+        p -= 2;
+        memcpy(p, decimal_digit_pairs + i, 2);
+    }
+    if (u >= 10) {
+        memcpy(p - 2, decimal_digit_pairs + u * 2, 2);
+    } else {
+        p[-1] = '0' + u;
+    }
+    return length;
+}
+
+static constexpr size_t max_int64_length = 20;
+
+static inline size_t format_int64(char *out, int64_t i) {
+    if (i < 0) {
+        out[0] = '-';
+        return 1 + format_uint64(out + 1, 0 - (uint64_t)i);
+    }
+    return format_uint64(out, i);
+}
+
+/* format_fixed_width
+ * writes the width least significant decimal digits of u, with
+ * leading zeros; width must be even, or u must be less than 10^width
+ */
+static inline size_t format_fixed_width(char *out, uint32_t u, unsigned int width) {
+    char *p = out + width;
+    while (p - out >= 2) {
+        p -= 2;
+        memcpy(p, decimal_digit_pairs + (u % 100) * 2, 2);
+        u /= 100;
+    }
+    if (p > out) {
+        *out = '0' + u % 10;
+    }
+    return width;
+}
+
+/* format_float
+ * writes d in the same format as printf("%f", d), that is, rounded to
+ * six decimal places, when that can be done exactly with integer
+ * arithmetic; otherwise, it returns 0, and the caller must use printf
+ */
+static constexpr size_t max_float_length = 1 + 16 + 1 + 6;
+
+static inline size_t format_float(char *out, double d) {
+    double scaled = d * 1e6;
+    double magnitude = scaled < 0 ? -scaled : scaled;
+    if (!(magnitude < 0x1p50)) {    /* also true for NaN */
+        return 0;
+    }
+
+    /*
+     * d * 1e6 is correctly rounded, so it is within magnitude * 2^-52
+     * of the exact product; if that is not close to halfway between
+     * two integers, it rounds to the same integer as the exact
+     * product, which is what printf() does
+     */
+    uint64_t integer = (uint64_t)magnitude;
+    double fraction = magnitude - (double)integer;
+    double halfway_distance = fraction - 0.5;
+    if (halfway_distance < 0) {
+        halfway_distance = -halfway_distance;
+    }
+    if (halfway_distance <= magnitude * 0x1p-52) {
+        return 0;
+    }
+    if (fraction > 0.5) {
+        integer++;
+    }
+
+    char *p = out;
+    if (__builtin_signbit(d)) {
+        *p++ = '-';
+    }
+    p += format_uint64(p, integer / 1000000);
+    *p++ = '.';
+    p += format_fixed_width(p, integer % 1000000, 6);
+    return p - out;
+}
+
+/* format_timestamp
+ * writes the seconds and microseconds of ts in the form
+ * seconds.microseconds, e.g. "1634846862.105263"
+ */
+static constexpr size_t max_timestamp_length = max_uint64_length + 1 + 6;
+
+static inline size_t format_timestamp(char *out, const struct timespec *ts) {
+    size_t length = format_uint64(out, (uint64_t)ts->tv_sec);
+    out[length++] = '.';
+    length += format_fixed_width(out + length, (uint64_t)ts->tv_nsec / 1000 % 1000000, 6);
+    return length;
+}
+
+/* format_timestamp_as_string
+ * writes ts as an ISO8601 / RFC3339 compliant UTC timestamp with
+ * nanosecond resolution, e.g. "2021-10-21T20:07:42.105263000Z",
+ * converting days to a calendar date with the civil_from_days()
+ * algorithm of Howard Hinnant; it returns 0 if ts is outside of the
+ * range that it handles (the years 1970 through 9999), in which case
+ * the caller must use strftime()
+ */
+static constexpr size_t timestamp_as_string_length = 30;
+
+static inline size_t format_timestamp_as_string(char *out, const struct timespec *ts) {
+    if (ts->tv_sec < 0 || ts->tv_sec >= 253402300800 || ts->tv_nsec < 0 || ts->tv_nsec >= 1000000000) {
+        return 0;
+    }
     uint64_t secs = ts->tv_sec;
-    for (int p = 1000000000; p >= 10; p /= 10) {
-        int d = secs / p;
-        secs %= p;
+    uint32_t days = secs / 86400;
+    uint32_t secs_of_day = secs % 86400;
+
+    uint32_t z = days + 719468;                /* days since 0000-03-01 */
+    uint32_t era = z / 146097;
+    uint32_t doe = z - era * 146097;           /* day of era [0, 146096] */
+    uint32_t yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+    uint32_t doy = doe - (365*yoe + yoe/4 - yoe/100);
+    uint32_t mp = (5*doy + 2) / 153;           /* month, starting in March */
+    uint32_t day = doy - (153*mp + 2)/5 + 1;
+    uint32_t month = mp < 10 ? mp + 3 : mp - 9;
+    uint32_t year = yoe + era * 400 + (month <= 2);
+
+    format_fixed_width(out, year, 4);
+    out[4] = '-';
+    format_fixed_width(out + 5, month, 2);
+    out[7] = '-';
+    format_fixed_width(out + 8, day, 2);
+    out[10] = 'T';
+    format_fixed_width(out + 11, secs_of_day / 3600, 2);
+    out[13] = ':';
+    format_fixed_width(out + 14, secs_of_day / 60 % 60, 2);
+    out[16] = ':';
+    format_fixed_width(out + 17, secs_of_day % 60, 2);
+    out[19] = '.';
+    format_fixed_width(out + 20, ts->tv_nsec, 9);
+    out[29] = 'Z';
+    return timestamp_as_string_length;
+}
 
-        if ((d == 0) && (leadin == 1)) {
-            continue;
+/* decimal_uint8_table
+ * holds the decimal digits of each uint8_t value, followed by the
+ * number of digits in the last byte
+ */
+struct decimal_uint8_table {
+    char entry[256][4];
+
+    constexpr decimal_uint8_table() : entry{} {
+        for (int i = 0; i < 256; i++) {
+            int n = 0;
+            if (i >= 100) {
+                entry[i][n++] = '0' + i / 100;
+            }
+            if (i >= 10) {
+                entry[i][n++] = '0' + (i / 10) % 10;
+            }
+            entry[i][n++] = '0' + i % 10;
+            entry[i][3] = n;
         }
+    }
+};
+
+static constexpr decimal_uint8_table decimal_uint8{};
+
+static constexpr size_t max_ipv4_addr_length = 4 * 3 + 3 + 1;  /* includes a scratch byte */
 
-        leadin = 0;
-        outs[i] = '0' + d;
-        i++;
+static inline size_t format_ipv4_addr(char *out, const uint8_t *v4) {
+    char *p = out;
+    for (int i = 0; i < 4; i++) {
+        const char *e = decimal_uint8.entry[v4[i]];
+        memcpy(p, e, 4);
+        p += e[3];
+        *p++ = '.';
     }
-    /* Store the final digit which can be 0 */
-    outs[i] = '0' + secs;
-    i++;
+    return p - out - 1;
+}
 
-    /* Now store the decimal point */
-    outs[i] = '.';
-    i++;
+/* ipv6_zero_run_table
+ * maps a bitmask that identifies the zero-valued fields of an IPv6
+ * address to the location and length of the run of zero fields that
+ * is compressed to "::" following RFC 5952 Section 4.2: the longest
+ * run, or the leftmost of the longest runs, provided that it contains
+ * at least two fields
+ */
+struct ipv6_zero_run_table {
+    struct zero_run {
+        uint8_t start;
+        uint8_t length;
+    } entry[256];
+
+    constexpr ipv6_zero_run_table() : entry{} {
+        for (unsigned int mask = 0; mask < 256; mask++) {
+            unsigned int best_start = 0, best_length = 0;
+            unsigned int i = 0;
+            while (i < 8) {
+                if (mask & (1 << i)) {
+                    unsigned int start = i;
+                    while (i < 8 && (mask & (1 << i))) {
+                        i++;
+                    }
+                    if (i - start > best_length) {
+                        best_start = start;
+                        best_length = i - start;
+                    }
+                } else {
+                    i++;
+                }
+            }
+            if (best_length < 2) {
+                best_start = best_length = 0;
+            }
+            entry[mask].start = best_start;
+            entry[mask].length = best_length;
+        }
+    }
+};
 
-    /* And finally we write the decimal digits which should have leading zeros */
-    uint64_t usecs = ts->tv_nsec / 1000;
-    for (int p = 100000; p >= 1; p /= 10) {
-        int d = usecs / p;
-        usecs %= p;
+static constexpr ipv6_zero_run_table ipv6_zero_runs{};
 
-        outs[i] = '0' + d;
-        i++;
+/* format_ipv6_group
+ * writes a field of an IPv6 address in the fewest hex characters
+ * possible
+ */
+static inline char *format_ipv6_group(char *p, uint16_t g) {
+    if (g >= 0x1000) {
+        *p++ = hex_table[g >> 12];
     }
+    if (g >= 0x100) {
+        *p++ = hex_table[(g >> 8) & 0x0f];
+    }
+    if (g >= 0x10) {
+        *p++ = hex_table[(g >> 4) & 0x0f];
+    }
+    *p++ = hex_table[g & 0x0f];
+    return p;
+}
 
-    r += append_memcpy(dstr, doff, dlen, trunc,
-                       outs, i);
+static constexpr size_t max_ipv6_addr_length = (4 * 8) + (1 * 7);  /* 8 groups of 4 hex chars; 7 colons */
 
-    return r;
+static inline size_t format_ipv6_addr(char *out, const uint8_t *v6) {
+    uint16_t group[8];
+    unsigned int zero_mask = 0;
+    for (int i = 0; i < 8; i++) {
+        group[i] = (v6[2*i] << 8) | v6[2*i + 1];
+        zero_mask |= (group[i] == 0) << i;
+    }
+    const auto &run = ipv6_zero_runs.entry[zero_mask];
+
+    char *p = out;
+    unsigned int i = 0;
+    if (run.length != 0) {
+        for ( ; i < run.start; i++) {
+            p = format_ipv6_group(p, group[i]);
+            *p++ = ':';
+        }
+        if (i == 0) {
+            *p++ = ':';
+        }
+        *p++ = ':';
+        i += run.length;
+        if (i == 8) {
+            return p - out;
+        }
+    }
+    for ( ; i < 7; i++) {
+        p = format_ipv6_group(p, group[i]);
+        *p++ = ':';
+    }
+    p = format_ipv6_group(p, group[7]);
+    return p - out;
+}
+
+static inline int append_timestamp(char *dstr, int *doff, int dlen, int *trunc,
+                                   const struct timespec *ts) {
+
+    return append_formatted<max_timestamp_length>(dstr, doff, dlen, trunc,
+                                                  [ts](char *out) { return format_timestamp(out, ts); });
 }
 
 
@@ -311,93 +685,77 @@ static inline int append_timestamp_as_string(char *dstr, int *doff, int dlen, in
         return 0;
     }
 
-    // construct ISO8601 / RFC3339 compliant UTC timestamp
-    struct tm tm;
+    char str_buf[31];
+    int str_len = format_timestamp_as_string(str_buf, ts);
+    if (str_len == 0) {
+
+        // construct ISO8601 / RFC3339 compliant UTC timestamp
+        struct tm tm;
 #ifdef _WIN32
-    gmtime_s(&tm, &ts->tv_sec);
+        gmtime_s(&tm, &ts->tv_sec);
 #else
-    gmtime_r(&ts->tv_sec, &tm);
+        gmtime_r(&ts->tv_sec, &tm);
 #endif
-    char time_buf[31];
-    strftime(time_buf, sizeof(time_buf), "%Y-%m-%dT%H:%M:%S.", &tm);
-    char str_buf[31];
-    int str_len = snprintf(str_buf, sizeof(str_buf), "%s%09luZ", time_buf, ts->tv_nsec);
+        char time_buf[31];
+        strftime(time_buf, sizeof(time_buf), "%Y-%m-%dT%H:%M:%S.", &tm);
+        str_len = snprintf(str_buf, sizeof(str_buf), "%s%09luZ", time_buf, ts->tv_nsec);
+    }
 
     return append_memcpy(dstr, doff, dlen, trunc,
                          str_buf, str_len);
 }
 
 
-
 static inline int append_uint8(char *dstr, int *doff, int dlen, int *trunc,
                                uint8_t n) {
 
-    if (*trunc == 1) {
-        return 0;
-    }
+    return append_formatted<4>(dstr, doff, dlen, trunc,
+                               [n](char *out) {
+                                   memcpy(out, decimal_uint8.entry[n], 4);
+                                   return (size_t)decimal_uint8.entry[n][3];
+                               });
+}
 
-    int r = 0;
-    char outs[3]; /* 3 digits */
 
-    int i = 0; /* outs index */
-    int leadin = 1; /* We're still getting leading zeros */
+static inline int append_uint16(char *dstr, int *doff, int dlen, int *trunc,
+                                uint16_t n) {
 
-    for (int p = 100; p >= 10; p /= 10) {
-        int d = n / p;
-        n %= p;
+    return append_formatted<5>(dstr, doff, dlen, trunc,
+                               [n](char *out) { return format_uint64(out, n); });
+}
 
-        if ((d == 0) && (leadin == 1)) {
-            continue;
-        }
+static inline int append_uint64(char *dstr, int *doff, int dlen, int *trunc,
+                                uint64_t n) {
 
-        leadin = 0;
-        outs[i] = '0' + d;
-        i++;
-    }
-    /* Store the final digit which can be 0 */
-    outs[i] = '0' + n;
-    i++;
+    return append_formatted<max_uint64_length>(dstr, doff, dlen, trunc,
+                                                [n](char *out) { return format_uint64(out, n); });
+}
 
-    r += append_memcpy(dstr, doff, dlen, trunc,
-                       outs, i);
+static inline int append_int64(char *dstr, int *doff, int dlen, int *trunc,
+                               int64_t n) {
 
-    return r;
+    return append_formatted<max_int64_length>(dstr, doff, dlen, trunc,
+                                              [n](char *out) { return format_int64(out, n); });
 }
 
-
-static inline int append_uint16(char *dstr, int *doff, int dlen, int *trunc,
-                                uint16_t n) {
+/* append_float
+ * appends d in the format of printf("%f", d), falling back to
+ * append_snprintf() when format_float() cannot produce it
+ */
+static inline int append_float(char *dstr, int *doff, int dlen, int *trunc,
+                               double d) {
 
     if (*trunc == 1) {
         return 0;
     }
-
-    int r = 0;
-    char outs[5]; /* 5 digits */
-
-    int i = 0; /* outs index */
-    int leadin = 1; /* We're still getting leading zeros */
-
-    for (int p = 10000; p >= 10; p /= 10) {
-        int d = n / p;
-        n %= p;
-
-        if ((d == 0) && (leadin == 1)) {
-            continue;
+    if (append_has_room(*doff, dlen, max_float_length)) {
+        size_t length = format_float(dstr + *doff, d);
+        if (length != 0) {
+            *doff += length;
+            return length;
         }
-
-        leadin = 0;
-        outs[i] = '0' + d;
-        i++;
     }
-    /* Store the final digit which can be 0 */
-    outs[i] = '0' + n;
-    i++;
-
-    r += append_memcpy(dstr, doff, dlen, trunc,
-                       outs, i);
-
-    return r;
+    return append_snprintf(dstr, doff, dlen, trunc, "%f", d);
 }
 
 static inline int append_uint8_hex(char *dstr, int *doff, int dlen, int *trunc,
@@ -532,122 +890,8 @@ static inline int append_uint64_hex(char *dstr, int *doff, int dlen, int *trunc,
 static inline int append_ipv6_addr(char *dstr, int *doff, int dlen, int *trunc,
                                     const uint8_t *v6) {
 
-    if (*trunc == 1) {
-        return 0;
-    }
-
-    int r = 0;
-    char outbuf[(4 * 8) + (1 * 7)]; /* 8 groups of 4 hex chars; 7 colons */
-    char *outs = outbuf;
-
-    // find the longest run of consecutive zero fields; if there are
-    // two zero-runs of equal length, find the leftmost
-    //
-    uint16_t *u = (uint16_t *)v6;  // array of eight uint16_t
-    uint16_t *u_end = u + 8;
-    uint16_t *run = nullptr;
-    unsigned int run_len = 0;
-    uint16_t *longest_run = nullptr;
-    unsigned int longest_run_len = 0;
-    while (u < u_end) {
-        if (*u == 0) {
-            if (run_len == 0) {  // starting new run
-                run = u;
-            }
-            run_len++;
-        } else {
-            if (run_len != 0) {  // ending run
-                if (longest_run_len < run_len) {
-                    longest_run_len = run_len;
-                    longest_run = run;
-                    run_len = 0;
-                }
-            }
-        }
-        u++;
-    }
-    if (longest_run_len < run_len) {
-        longest_run_len = run_len;
-        longest_run = run;
-    }
-    if (longest_run_len == 1) { // dont compress length=1 runs
-        longest_run_len = 0;
-        longest_run = u;
-    }
-
-    // print out the fields before and after the longest run, with a
-    // pair of colons in the middle; if there is no run, then just
-    // print out all fields with colons between them
-    //
-    u = (uint16_t *)v6;         // rewind to start of address
-    while (u < longest_run) {
-
-        // write out *u in the fewest hex characters possible
-        //
-        uint8_t *v = (uint8_t *)u++;
-        int num_out_chars = 1;
-        if (v[0] & 0xf0) {
-            num_out_chars = 4;
-        } else if (v[0] & 0x0f) {
-            num_out_chars = 3;
-        } else if (v[1] & 0xf0) {
-            num_out_chars = 2;
-        }
-        switch (num_out_chars) {
-        case 4:
-            *outs++ = hex_table[(v[0] & 0xf0) >> 4];      [[fallthrough]];
-        case 3:
-            *outs++ = hex_table[v[0] & 0x0f];             [[fallthrough]];
-        case 2:
-            *outs++ = hex_table[(v[1] & 0xf0) >> 4];      [[fallthrough]];
-        case 1:
-        default:
-            *outs++ = hex_table[v[1] & 0x0f];
-        }
-        if (u != longest_run) {
-            *outs++ = ':';
-        }
-    }
-    u += longest_run_len;
-    if (longest_run_len != 0) {
-        *outs++ = ':';
-        *outs++ = ':';
-    }
-    if (u < u_end) {
-        while (u < u_end) {
-
-            // write out *u in the fewest hex characters possible
-            //
-            uint8_t *v = (uint8_t *)u++;
-            int num_out_chars = 1;
-            if (v[0] & 0xf0) {
-                num_out_chars = 4;
-            } else if (v[0] & 0x0f) {
-                num_out_chars = 3;
-            } else if (v[1] & 0xf0) {
-                num_out_chars = 2;
-            }
-            switch (num_out_chars) {
-            case 4:
-                *outs++ = hex_table[(v[0] & 0xf0) >> 4];      [[fallthrough]];
-            case 3:
-                *outs++ = hex_table[v[0] & 0x0f];             [[fallthrough]];
-            case 2:
-                *outs++ = hex_table[(v[1] & 0xf0) >> 4];      [[fallthrough]];
-            case 1:
-            default:
-                *outs++ = hex_table[v[1] & 0x0f];
-            }
-            if (u != u_end) {
-                *outs++ = ':';
-            }
-        }
-    }
-
-    r += append_memcpy(dstr, doff, dlen, trunc,
-                       outbuf, outs - outbuf);
-
-    return r;
+    return append_formatted<max_ipv6_addr_length>(dstr, doff, dlen, trunc,
+                                                  [v6](char *out) { return format_ipv6_addr(out, v6); });
 }
 
 /* Print Mac address in format
@@ -746,44 +990,23 @@ static inline int append_ipv6_addr_uncompressed(char *dstr, int *doff, int dlen,
 static inline int append_ipv4_addr(char *dstr, int *doff, int dlen, int *trunc,
                                    const uint8_t *v4) {
 
-    if (*trunc == 1) {
-        return 0;
-    }
-
-    int r = 0;
-
-    r += append_uint8(dstr, doff, dlen, trunc,
-                      v4[0]);
-    r += append_putc(dstr, doff, dlen, trunc,
-                     '.');
-    r += append_uint8(dstr, doff, dlen, trunc,
-                      v4[1]);
-    r += append_putc(dstr, doff, dlen, trunc,
-                     '.');
-    r += append_uint8(dstr, doff, dlen, trunc,
-                      v4[2]);
-    r += append_putc(dstr, doff, dlen, trunc,
-                     '.');
-    r += append_uint8(dstr, doff, dlen, trunc,
-                      v4[3]);
-
-    return r;
+    return append_formatted<max_ipv4_addr_length>(dstr, doff, dlen, trunc,
+                                                  [v4](char *out) { return format_ipv4_addr(out, v4); });
 }
 
 
-static inline int append_json_string_escaped(char *dstr, int *doff, int dlen, int *trunc,
-                                             const char *key, const uint8_t *data, unsigned int len) {
-
-    if (*trunc == 1) {
-        return 0;
-    }
+/* append_json_escaped_bytewise
+ * appends data with control characters and non-ASCII bytes escaped
+ * as \u00XX, and with quotation marks and reverse solidi escaped with
+ * a reverse solidus, a byte at a time, checking for truncation after
+ * each one; append_json_escaped() uses it when the escaped data might
+ * not fit in the buffer
+ */
+static inline int append_json_escaped_bytewise(char *dstr, int *doff, int dlen, int *trunc,
+                                               const uint8_t *data, unsigned int len) {
 
     int r = 0;
 
-    r += append_putc(dstr, doff, dlen, trunc, '"');
-    r += append_strncpy(dstr, doff, dlen, trunc, key);
-    r += append_strncpy(dstr, doff, dlen, trunc, "\":\"");
-
     for (unsigned int i = 0; (i < len) && (*trunc == 0); i++) {
         if ((data[i] < 0x20) || /* escape control characters   */
             (data[i] > 0x7f)) { /* escape non-ASCII characters */
@@ -803,6 +1026,72 @@ static inline int append_json_string_escaped(char *dstr, int *doff, int dlen, in
         }
     }
 
+    return r;
+}
+
+static inline int append_json_escaped(char *dstr, int *doff, int dlen, int *trunc,
+                                      const uint8_t *data, unsigned int len) {
+
+    if (*trunc == 1) {
+        return 0;
+    }
+
+    // each byte that is not clean takes up to six bytes when escaped;
+    // if all of them are clean, the data is copied as is
+    //
+    size_t clean = text_encoding::json_clean_prefix_length(data, len);
+    if (!append_has_room(*doff, dlen, clean + 6 * (len - clean))) {
+        return append_json_escaped_bytewise(dstr, doff, dlen, trunc, data, len);
+    }
+
+    char *out = dstr + *doff;
+    const uint8_t *x = data + clean;
+    const uint8_t *end = data + len;
+    memcpy(out, data, clean);
+    out += clean;
+    while (x < end) {
+        uint8_t c = *x++;
+        if ((c < 0x20) || /* escape control characters   */
+            (c > 0x7f)) { /* escape non-ASCII characters */
+            out[0] = '\\';
+            out[1] = 'u';
+            out[2] = '0';
+            out[3] = '0';
+            out[4] = hex_table[(c & 0xf0) >> 4];
+            out[5] = hex_table[c & 0x0f];
+            out += 6;
+        } else {
+            if (c == '"' || c == '\\') { /* escape special characters   */
+                *out++ = '\\';
+            }
+            *out++ = c;
+        }
+        if (x < end && text_encoding::is_json_clean(*x)) {
+            size_t n = text_encoding::json_clean_prefix_length(x, end - x);
+            memcpy(out, x, n);
+            out += n;
+            x += n;
+        }
+    }
+    int r = out - (dstr + *doff);
+    *doff += r;
+
+    return r;
+}
+
+static inline int append_json_string_escaped(char *dstr, int *doff, int dlen, int *trunc,
+                                             const char *key, const uint8_t *data, unsigned int len) {
+
+    if (*trunc == 1) {
+        return 0;
+    }
+
+    int r = 0;
+
+    r += append_putc(dstr, doff, dlen, trunc, '"');
+    r += append_strncpy(dstr, doff, dlen, trunc, key);
+    r += append_strncpy(dstr, doff, dlen, trunc, "\":\"");
+    r += append_json_escaped(dstr, doff, dlen, trunc, data, len);
     r += append_putc(dstr, doff, dlen, trunc,
                      '"');
 
@@ -819,26 +1108,7 @@ static inline int append_json_string_no_key(char *dstr, int *doff, int dlen, int
     int r = 0;
 
     r += append_putc(dstr, doff, dlen, trunc, '"');
-
-    for (unsigned int i = 0; (i < len) && (*trunc == 0); i++) {
-        if ((data[i] < 0x20) || /* escape control characters   */
-            (data[i] > 0x7f)) { /* escape non-ASCII characters */
-            r += append_strncpy(dstr, doff, dlen, trunc,
-                                "\\u00");
-            r += append_putc(dstr, doff, dlen, trunc,
-                             hex_table[(data[i] & 0xf0) >> 4]);
-            r += append_putc(dstr, doff, dlen, trunc,
-                             hex_table[data[i] & 0x0f]);
-        } else {
-            if (data[i] == '"' || data[i] == '\\') { /* escape special characters   */
-                r += append_putc(dstr, doff, dlen, trunc,
-                                 '\\');
-            }
-            r += append_putc(dstr, doff, dlen, trunc,
-                             data[i]);
-        }
-    }
-
+    r += append_json_escaped(dstr, doff, dlen, trunc, data, len);
     r += append_putc(dstr, doff, dlen, trunc,
                      '"');
 
@@ -846,15 +1116,7 @@ static inline int append_json_string_no_key(char *dstr, int *doff, int dlen, int
 }
 
 static inline unsigned int string_is_nonascii(const uint8_t *data, size_t len) {
-    const unsigned char *x = data;
-    const unsigned char *end = data + len;
-
-    uint8_t sum = 0;
-    while (x < end) {
-        sum |= *x;
-        x++;
-    }
-    return sum & 0x80; /* return 0 if no high bits are set */
+    return text_encoding::is_ascii(data, len) ? 0 : 0x80; /* return 0 if no high bits are set */
 }
 
 static inline bool string_starts_with_0x(const uint8_t *data, size_t len) {
@@ -880,9 +1142,14 @@ static inline int append_json_string(char *dstr, int *doff, int dlen, int *trunc
 }
 
 
-static inline int append_raw_as_base64(char *dstr, int *doff, int dlen, int *trunc,
-                                       const unsigned char *data,
-                                       size_t input_length) {
+/* append_raw_as_base64_bytewise
+ * appends the quoted base64 encoding of data, checking for truncation
+ * after each block; append_raw_as_base64() uses it when the encoding
+ * might not fit in the buffer
+ */
+static inline int append_raw_as_base64_bytewise(char *dstr, int *doff, int dlen, int *trunc,
+                                                const unsigned char *data,
+                                                size_t input_length) {
 
     static constexpr char encoding_table[] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
                                               'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
@@ -980,6 +1247,27 @@ static inline int append_raw_as_base64(char *dstr, int *doff, int dlen, int *tru
     return r;
 }
 
+static inline int append_raw_as_base64(char *dstr, int *doff, int dlen, int *trunc,
+                                       const unsigned char *data,
+                                       size_t input_length) {
+
+    if (*trunc == 1) {
+        return 0;
+    }
+
+    size_t length = text_encoding::base64_length(input_length) + 2;  /* includes quotes */
+    if (!append_has_room(*doff, dlen, length)) {
+        return append_raw_as_base64_bytewise(dstr, doff, dlen, trunc, data, input_length);
+    }
+    char *out = dstr + *doff;
+    out[0] = '"';
+    text_encoding::base64(out + 1, data, input_length);
+    out[length - 1] = '"';
+    *doff += length;
+
+    return length;
+}
+
 
 /*
  * struct buffer_stream
@@ -1045,11 +1333,20 @@ struct buffer_stream {
     }
 
     void strncpy(const char *sstr) {
-        append_strncpy(dstr, &doff, dlen, &trunc, sstr);
+        append_string(dstr, &doff, dlen, &trunc, sstr, strlen(sstr));
     }
 
     void puts(const char *sstr) {
-        append_strncpy(dstr, &doff, dlen, &trunc, sstr);
+        append_string(dstr, &doff, dlen, &trunc, sstr, strlen(sstr));
+    }
+
+    // write_key(k, suffix) writes a quotation mark, the key k, and the
+    // suffix, which is "\":" before a value other than a string, and
+    // "\":\"" before a string; when they are string literals and the
+    // call is inlined, their lengths are computed at compile time
+    //
+    void write_key(const char *k, const char *suffix="\":") {
+        append_json_key(dstr, &doff, dlen, &trunc, k, strlen(k), suffix, strlen(suffix));
     }
 
     void write_char(char schr) {
@@ -1068,6 +1365,31 @@ struct buffer_stream {
         append_json_string_no_key(dstr, &doff, dlen, &trunc, data, len);
     }
 
+    // write_json_clean_prefix(x, end) writes the bytes at the start of
+    // [x, end) that are written into a JSON string as is (see
+    // text_encoding::is_json_clean()), up to the space available, and
+    // advances x past them; it returns the number of bytes consumed,
+    // which is zero if *x needs to be escaped or the buffer is nearly
+    // full, in which case the caller writes out the byte at *x itself.
+    // If the buffer is truncated, the bytes are consumed but not
+    // written, as they would be if they were written one at a time.
+    //
+    size_t write_json_clean_prefix(const uint8_t *&x, const uint8_t *end) {
+        if (x >= end || !text_encoding::is_json_clean(*x)) {
+            return 0;
+        }
+        size_t n = text_encoding::json_clean_prefix_length(x, end - x);
+        if (trunc == 0) {
+            if (!append_has_room(doff, dlen, n)) {
+                n = (doff < dlen - 1) ? dlen - 2 - doff : 0;
+            }
+            ::memcpy(dstr + doff, x, n);
+            doff += n;
+        }
+        x += n;
+        return n;
+    }
+
     void json_hex_string(const uint8_t *data, unsigned int len) {
         append_json_hex_string(dstr, &doff, dlen, &trunc, data, len);
     }
@@ -1103,6 +1425,18 @@ struct buffer_stream {
         append_uint16(dstr, &doff, dlen, &trunc, n);
     }
 
+    void write_uint64(uint64_t n) {
+        append_uint64(dstr, &doff, dlen, &trunc, n);
+    }
+
+    void write_int64(int64_t n) {
+        append_int64(dstr, &doff, dlen, &trunc, n);
+    }
+
+    void write_float(double d) {
+        append_float(dstr, &doff, dlen, &trunc, d);
+    }
+
     void write_hex_uint(uint8_t n) {
         append_uint8_hex(dstr, &doff, dlen, &trunc, n);
     }
@@ -13,6 +13,8 @@
 #ifndef CRYPTO_ENGINE_H
 #define CRYPTO_ENGINE_H
 
+#include <cstring>
+#include <stdexcept>
 #include <openssl/aes.h>
 #include <openssl/hmac.h>
 #include <openssl/evp.h>
@@ -24,6 +26,27 @@ class crypto_engine {
 
     EVP_CIPHER_CTX *gcm_ctx = nullptr;
     EVP_CIPHER_CTX *ecb_ctx = nullptr;
+#ifdef SSLNEW
+    HMAC_CTX *hmac_ctx = nullptr;   // reused by hmac_sha256() and kdf_tls13()
+#endif
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    // with OpenSSL 3, each initialization with an algorithm obtained
+    // from EVP_sha256() and the like fetches its implementation from
+    // a provider; fetching them once, here, avoids that cost
+    //
+    EVP_MD *sha256 = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    EVP_CIPHER *aes_128_gcm = EVP_CIPHER_fetch(nullptr, "AES-128-GCM", nullptr);
+    EVP_CIPHER *aes_128_ecb = EVP_CIPHER_fetch(nullptr, "AES-128-ECB", nullptr);
+
+    const EVP_MD *md_sha256() const { return sha256 ? sha256 : EVP_sha256(); }
+    const EVP_CIPHER *cipher_aes_128_gcm() const { return aes_128_gcm ? aes_128_gcm : EVP_aes_128_gcm(); }
+    const EVP_CIPHER *cipher_aes_128_ecb() const { return aes_128_ecb ? aes_128_ecb : EVP_aes_128_ecb(); }
+#else
+    const EVP_MD *md_sha256() const { return EVP_sha256(); }
+    const EVP_CIPHER *cipher_aes_128_gcm() const { return EVP_aes_128_gcm(); }
+    const EVP_CIPHER *cipher_aes_128_ecb() const { return EVP_aes_128_ecb(); }
+#endif
 
     static constexpr size_t max_label_len = 2048;
 
@@ -32,10 +55,18 @@ public:
     crypto_engine()
                     : gcm_ctx{EVP_CIPHER_CTX_new()}
                     , ecb_ctx{EVP_CIPHER_CTX_new()}
+#ifdef SSLNEW
+                    , hmac_ctx{HMAC_CTX_new()}
+#endif
     {
         if (gcm_ctx == nullptr or ecb_ctx == nullptr) {
             throw std::runtime_error("could not create EVP_CIPHER_CTX");
         }
+#ifdef SSLNEW
+        if (hmac_ctx == nullptr) {
+            throw std::runtime_error("could not create HMAC_CTX");
+        }
+#endif
     }
 
     ~crypto_engine() {
@@ -45,8 +76,21 @@ public:
         if (ecb_ctx){
             EVP_CIPHER_CTX_free(ecb_ctx);
         }
+#ifdef SSLNEW
+        if (hmac_ctx) {
+            HMAC_CTX_free(hmac_ctx);
+        }
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        EVP_MD_free(sha256);
+        EVP_CIPHER_free(aes_128_gcm);
+        EVP_CIPHER_free(aes_128_ecb);
+#endif
     }
 
+    crypto_engine(const crypto_engine &) = delete;
+    crypto_engine &operator=(const crypto_engine &) = delete;
+
     void ecb_encrypt(unsigned char *key,
                     uint8_t *ciphertext,
                     const unsigned char *plaintext,
@@ -55,7 +99,7 @@ public:
         int len;
         int ciphertext_len;
 
-        if(!EVP_EncryptInit_ex(ecb_ctx, EVP_aes_128_ecb(), NULL, key, NULL)) {
+        if(!EVP_EncryptInit_ex(ecb_ctx, cipher_aes_128_ecb(), NULL, key, NULL)) {
             throw std::runtime_error("could not initialize EVP_CIPHER_CTX");
         }
 
@@ -102,7 +146,7 @@ public:
 
         // initialize cipher & context with key and iv
         //
-        if(!EVP_DecryptInit_ex(gcm_ctx, EVP_aes_128_gcm(), NULL, NULL, NULL)) {
+        if(!EVP_DecryptInit_ex(gcm_ctx, cipher_aes_128_gcm(), NULL, NULL, NULL)) {
             throw std::runtime_error("could not initialize EVP_CIPHER_CTX");
         }
         if(!EVP_DecryptInit_ex(gcm_ctx, NULL, NULL, key, iv)) {
@@ -139,28 +183,51 @@ public:
     }
 
 #ifdef SSLNEW
-    void kdf_tls13(uint8_t *secret, unsigned int secret_length, const uint8_t *label, const unsigned int label_len,
+    // hmac_sha256() computes HMAC-SHA256(key, data), which is HKDF-Extract
+    // with the key as the salt and the data as the input keying material
+    // (RFC 5869, Section 2.2)
+    //
+    bool hmac_sha256(const uint8_t *key, size_t key_len, const uint8_t *data, size_t data_len,
+                     uint8_t *out, unsigned int *out_len) {
+        return HMAC_Init_ex(hmac_ctx, key, key_len, md_sha256(), NULL)
+            && HMAC_Update(hmac_ctx, data, data_len)
+            && HMAC_Final(hmac_ctx, out, out_len);
+    }
+
+    // kdf_tls13() computes HKDF-Expand-Label(secret, label, "", length)
+    // (RFC 8446, Section 7.1) into out_, and sets *out_len to length.
+    // It returns true on success, and false otherwise, in which case
+    // *out_len is set to zero and the contents of out_ are undefined.
+    //
+    bool kdf_tls13(uint8_t *secret, unsigned int secret_length, const uint8_t *label, const unsigned int label_len,
                    uint8_t length, uint8_t *out_, unsigned int *out_len) {
 
-        uint8_t new_label[max_label_len] = {0};
+        *out_len = 0;
+
+        // HkdfLabel (RFC 8446, Section 7.1) with an empty context; only
+        // the bytes that are used are initialized
+        //
+        if (label_len > max_label_len - 4) {
+            return false;
+        }
+        uint8_t new_label[max_label_len];
+        new_label[0] = 0;
         new_label[1] = length;
         new_label[2] = label_len;
-        for (size_t i = 0; i < label_len; i++) {
-            new_label[3+i] = label[i];
-        }
+        memcpy(new_label + 3, label, label_len);
+        new_label[3 + label_len] = 0;
         size_t new_label_len = 4 + label_len;
-        *out_len = length;
 
-        HMAC_CTX *hmac;
+        HMAC_CTX *hmac = hmac_ctx;
         int md_sz;
-        unsigned char buf[2048];
+        unsigned char buf[EVP_MAX_MD_SIZE];
         size_t done_len = 0, dig_len, n;
 
-        const EVP_MD *evp_md = EVP_sha256();
+        const EVP_MD *evp_md = md_sha256();
 
         md_sz = EVP_MD_size(evp_md);
         if (md_sz <= 0) {
-            return;
+            return false;
         }
         dig_len = (size_t)md_sz;
 
@@ -169,13 +236,12 @@ public:
             n++;
         }
 
-        if (n > 255 || out_ == NULL || ((hmac = HMAC_CTX_new()) == NULL)) {
-            return;
+        if (n > 255 || out_ == NULL) {
+            return false;
         }
 
         if (!HMAC_Init_ex(hmac, secret, secret_length, evp_md, NULL)) {
-            HMAC_CTX_free(hmac);
-            return;
+            return false;
         }
 
         for (size_t i = 1; i <= n; i++) {
@@ -183,26 +249,21 @@ public:
             const unsigned char ind = i;
             if (i > 1) {
                 if (!HMAC_Init_ex(hmac, NULL, 0, NULL, NULL)) {
-                    HMAC_CTX_free(hmac);
-                    return;
+                    return false;
                 }
                 if (!HMAC_Update(hmac, buf, dig_len)) {
-                    HMAC_CTX_free(hmac);
-                    return;
+                    return false;
                 }
             }
 
             if (!HMAC_Update(hmac, new_label, new_label_len)) {
-                HMAC_CTX_free(hmac);
-                return;
+                return false;
             }
             if (!HMAC_Update(hmac, &ind, 1)) {
-                HMAC_CTX_free(hmac);
-                return;
+                return false;
             }
             if (!HMAC_Final(hmac, buf, NULL)) {
-                HMAC_CTX_free(hmac);
-                return;
+                return false;
             }
 
             copy_len = (done_len + dig_len > length) ? (length-done_len) : dig_len;
@@ -210,13 +271,23 @@ public:
 
             done_len += copy_len;
         }
-
-        HMAC_CTX_free(hmac);
+        *out_len = length;
+        return true;
     }
 #else
-    void kdf_tls13(uint8_t *secret, unsigned int secret_length, const uint8_t *label, const unsigned int label_len,
+    bool hmac_sha256(const uint8_t *key, size_t key_len, const uint8_t *data, size_t data_len,
+                     uint8_t *out, unsigned int *out_len) {
+        return HMAC(md_sha256(), key, key_len, data, data_len, out, out_len) != nullptr;
+    }
+
+    bool kdf_tls13(uint8_t *secret, unsigned int secret_length, const uint8_t *label, const unsigned int label_len,
                    uint8_t length, uint8_t *out_, unsigned int *out_len) {
 
+        *out_len = 0;
+
+        if (label_len > max_label_len - 4) {
+            return false;
+        }
         uint8_t new_label[max_label_len] = {0};
         new_label[1] = length;
         new_label[2] = label_len;
@@ -224,19 +295,16 @@ public:
             new_label[3+i] = label[i];
         }
         size_t new_label_len = 4 + label_len;
-        *out_len = length;
 
-        HMAC_CTX hmac;
-	    HMAC_CTX_init(&hmac);
         int md_sz;
-        unsigned char buf[2048];
+        unsigned char buf[EVP_MAX_MD_SIZE];
         size_t done_len = 0, dig_len, n;
 
-        const EVP_MD *evp_md = EVP_sha256();
+        const EVP_MD *evp_md = md_sha256();
 
         md_sz = EVP_MD_size(evp_md);
         if (md_sz <= 0) {
-            return;
+            return false;
         }
         dig_len = (size_t)md_sz;
 
@@ -246,12 +314,15 @@ public:
         }
 
         if (n > 255 || out_ == NULL) {
-            return;
+            return false;
         }
 
+        HMAC_CTX hmac;
+        HMAC_CTX_init(&hmac);
+
         if (!HMAC_Init(&hmac, secret, secret_length, evp_md)) {
             HMAC_CTX_cleanup(&hmac);
-            return;
+            return false;
         }
 
         for (size_t i = 1; i <= n; i++) {
@@ -260,25 +331,25 @@ public:
             if (i > 1) {
                 if (!HMAC_Init(&hmac, NULL, 0, NULL)) {
                     HMAC_CTX_cleanup(&hmac);
-                    return;
+                    return false;
                 }
                 if (!HMAC_Update(&hmac, buf, dig_len)) {
                     HMAC_CTX_cleanup(&hmac);
-                    return;
+                    return false;
                 }
             }
 
             if (!HMAC_Update(&hmac, new_label, new_label_len)) {
                 HMAC_CTX_cleanup(&hmac);
-                return;
+                return false;
             }
             if (!HMAC_Update(&hmac, &ind, 1)) {
                 HMAC_CTX_cleanup(&hmac);
-                return;
+                return false;
             }
             if (!HMAC_Final(&hmac, buf, NULL)) {
                 HMAC_CTX_cleanup(&hmac);
-                return;
+                return false;
             }
 
             copy_len = (done_len + dig_len > length) ? (length-done_len) : dig_len;
@@ -288,6 +359,8 @@ public:
         }
 
         HMAC_CTX_cleanup(&hmac);
+        *out_len = length;
+        return true;
     }
 #endif
 
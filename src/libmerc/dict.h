@@ -15,6 +15,7 @@
 #include <unordered_map>
 #include <vector>
 #include <algorithm>
+#include <mutex>
 
 #include "bytestring.h"
 
@@ -114,15 +115,20 @@ public:
 
 };
 
+// struct dictionary assigns a number to each distinct string; get()
+// can be called from several threads at once
+//
 struct dictionary {
     std::unordered_map<std::basic_string<uint8_t>, uint32_t> dict;
     unsigned int count;
+    std::mutex m;
 
     dictionary() : dict{}, count{0} {}
 
     // std::basic_string<uint8_t> s = p->get_bytestring();
     unsigned int get(std::basic_string<uint8_t> &value) {
 
+        std::lock_guard<std::mutex> lock{m};
         auto x = dict.find(value);
         if (x == dict.end()) {
             dict.insert({value, count++});
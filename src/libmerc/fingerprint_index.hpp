@@ -0,0 +1,444 @@
+/*
+ * fingerprint_index.hpp
+ *
+ * approximate nearest-neighbor search over fingerprint strings, using
+ * MinHash signatures, locality sensitive hashing, and bit-parallel
+ * edit distance
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#ifndef FINGERPRINT_INDEX_HPP
+#define FINGERPRINT_INDEX_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <string>
+
+// fingerprint_tokens() splits a fingerprint string such as
+// "tls/1/(0303)(c02bc02f)((0000)(0017))" into a sequence of 32-bit
+// tokens, one for each innermost parenthesized element, with the
+// elements of the top-level lists (such as the cipher suites) split
+// further into four-hex-digit units.  Each token is a hash of the
+// element and of the position of the list that holds it, so that the
+// same bytes in different fields are different tokens.  The text
+// before the first parenthesis (the type and format) is not
+// tokenized; its hash is returned in prefix_hash.
+//
+inline void fingerprint_tokens(std::string_view fp, std::vector<uint32_t> &tokens, uint64_t &prefix_hash) {
+    auto fnv1a = [](uint64_t h, const char *c, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            h = (h ^ (uint8_t)c[i]) * 0x100000001b3;
+        }
+        return h;
+    };
+    auto token = [](uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccd;
+        h ^= h >> 33;
+        return (uint32_t)h;
+    };
+
+    tokens.clear();
+    size_t start = fp.find('(');
+    if (start == std::string_view::npos) {
+        start = fp.length();
+    }
+    prefix_hash = fnv1a(0xcbf29ce484222325, fp.data(), start);
+
+    size_t depth = 0;
+    size_t list_index = 0;          // index of the current top-level element
+    const char *leaf = nullptr;     // start of the current innermost element
+    for (size_t i = start; i < fp.length(); i++) {
+        char c = fp[i];
+        if (c == '(') {
+            depth++;
+            leaf = &fp[i + 1];
+        } else if (c == ')') {
+            if (leaf != nullptr) {
+                size_t len = &fp[i] - leaf;
+                uint64_t h = 0xcbf29ce484222325 ^ (list_index * 0x9e3779b97f4a7c15);
+                if (depth == 1 && len > 4 && len % 4 == 0) {
+                    for (size_t j = 0; j < len; j += 4) {
+                        tokens.push_back(token(fnv1a(h, leaf + j, 4)));
+                    }
+                } else {
+                    tokens.push_back(token(fnv1a(h, leaf, len)));
+                }
+                leaf = nullptr;
+            }
+            if (depth > 0 && --depth == 0) {
+                list_index++;
+            }
+        }
+    }
+}
+
+// class token_edit_distance computes the edit (Levenshtein) distance
+// between a pattern sequence of tokens and any number of text
+// sequences, with Myers' bit-parallel algorithm, in the block-based
+// form that handles patterns longer than a machine word.  Each text
+// token is processed in O(m/64) word operations, after a binary
+// search for it among the distinct tokens of the pattern, so a
+// comparison of sequences of lengths m and n takes O(n(m/64 + log m))
+// time instead of the O(mn) of dynamic programming.  Patterns longer
+// than max_length tokens are truncated.
+//
+class token_edit_distance {
+public:
+    static constexpr size_t max_words = 8;
+    static constexpr size_t max_length = max_words * 64;
+
+private:
+    std::vector<uint32_t> symbols;  // distinct pattern tokens, sorted
+    std::vector<uint64_t> peq;      // bit j of peq[s * words + w] is set if pattern[w * 64 + j] == symbols[s]
+    size_t m = 0;
+    size_t words = 0;
+    uint64_t last_bit = 0;          // bit of the last word that corresponds to the last pattern token
+
+    const uint64_t *match_vector(uint32_t t) const {
+        auto it = std::lower_bound(symbols.begin(), symbols.end(), t);
+        if (it == symbols.end() || *it != t) {
+            return nullptr;
+        }
+        return &peq[(it - symbols.begin()) * words];
+    }
+
+public:
+
+    token_edit_distance() = default;
+
+    explicit token_edit_distance(const std::vector<uint32_t> &pattern) { set_pattern(pattern); }
+
+    void set_pattern(const std::vector<uint32_t> &pattern) {
+        m = std::min(pattern.size(), max_length);
+        words = (m + 63) / 64;
+        last_bit = m ? (uint64_t)1 << ((m - 1) % 64) : 0;
+        symbols.assign(pattern.begin(), pattern.begin() + m);
+        std::sort(symbols.begin(), symbols.end());
+        symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+        peq.assign(symbols.size() * words, 0);
+        for (size_t i = 0; i < m; i++) {
+            size_t s = std::lower_bound(symbols.begin(), symbols.end(), pattern[i]) - symbols.begin();
+            peq[s * words + i / 64] |= (uint64_t)1 << (i % 64);
+        }
+    }
+
+    size_t pattern_length() const { return m; }
+
+    size_t distance(const std::vector<uint32_t> &text) const {
+        if (m == 0) {
+            return text.size();
+        }
+        std::array<uint64_t, max_words> pv;
+        std::array<uint64_t, max_words> mv;
+        pv.fill(~(uint64_t)0);
+        mv.fill(0);
+        size_t score = m;
+        for (uint32_t t : text) {
+            const uint64_t *eq_vector = match_vector(t);
+            int hin = 1;                          // the top row of the table increases by one in each column
+            for (size_t w = 0; w < words; w++) {
+                uint64_t eq = eq_vector ? eq_vector[w] : 0;
+                uint64_t xv = eq | mv[w];
+                if (hin < 0) {
+                    eq |= 1;
+                }
+                uint64_t xh = (((eq & pv[w]) + pv[w]) ^ pv[w]) | eq;
+                uint64_t ph = mv[w] | ~(xh | pv[w]);
+                uint64_t mh = pv[w] & xh;
+                uint64_t high = (w + 1 == words) ? last_bit : (uint64_t)1 << 63;
+                int hout = (ph & high) ? 1 : ((mh & high) ? -1 : 0);
+                ph <<= 1;
+                mh <<= 1;
+                if (hin < 0) {
+                    mh |= 1;
+                } else if (hin > 0) {
+                    ph |= 1;
+                }
+                pv[w] = mh | ~(xv | ph);
+                mv[w] = ph & xv;
+                hin = hout;
+            }
+            score += hin;
+        }
+        return score;
+    }
+
+};
+
+// class fingerprint_index finds the known fingerprint that is most
+// similar to a fingerprint that is not in the fingerprint database.
+// Each fingerprint is tokenized by fingerprint_tokens(), and the set
+// of its tokens is summarized by a MinHash signature of num_hashes
+// 32-bit values; the signatures are split into num_bands bands of
+// rows_per_band values, and each band is hashed into a table, so
+// that fingerprints whose token sets have a high Jaccard similarity
+// are likely to share a bucket in at least one band.  A query looks
+// up its own bands, keeps the max_candidates fingerprints that share
+// the most buckets with it (among the first max_bucket_scan in each
+// bucket, which bounds the work done for a crowded bucket), and ranks
+// them by the edit distance between their token sequences, computed
+// by token_edit_distance.  Only fingerprints with the same type and
+// format (e.g. "tls/1/") are compared.  The similarity reported is
+// one minus the edit distance divided by the length of the longer
+// sequence.  A query takes roughly 10 to 50 microseconds, depending
+// on the number of fingerprints indexed; nearest_fingerprint_cache
+// avoids repeating it for the same fingerprint.
+//
+// The index holds views of the fingerprint strings passed to add(),
+// which must outlive it.  After it is built, nearest() may be called
+// concurrently from any number of threads.
+//
+class fingerprint_index {
+public:
+    static constexpr size_t num_hashes = 32;
+    static constexpr size_t rows_per_band = 4;
+    static constexpr size_t num_bands = num_hashes / rows_per_band;
+    static constexpr size_t max_candidates = 16;
+    static constexpr size_t max_bucket_scan = 32;
+
+    struct match {
+        std::string_view fingerprint;   // empty if no similar fingerprint was found
+        double similarity = 0.0;        // in [0,1]
+    };
+
+private:
+    uint64_t id_ = next_id();      // distinguishes this index from any other, including later ones at the same address
+    std::vector<std::string_view> fingerprints;
+    std::vector<std::vector<uint32_t>> sequences;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> buckets;   // band key -> fingerprint indices
+
+    using signature = std::array<uint32_t, num_hashes>;
+
+    // the i-th MinHash function is a * x + b (mod 2^32), with the
+    // odd multipliers and offsets taken from the splitmix64 sequence
+    //
+    struct hash_coefficients {
+        std::array<uint32_t, num_hashes> a;
+        std::array<uint32_t, num_hashes> b;
+
+        hash_coefficients() {
+            uint64_t x = 0;
+            for (size_t i = 0; i < num_hashes; i++) {
+                a[i] = (uint32_t)next(x) | 1;
+                b[i] = (uint32_t)next(x);
+            }
+        }
+
+        static uint64_t next(uint64_t &x) {
+            uint64_t z = (x += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            return z ^ (z >> 31);
+        }
+    };
+
+    static uint64_t next_id() {
+        static std::atomic<uint64_t> count{0};
+        return ++count;
+    }
+
+    static const hash_coefficients &coefficients() {
+        static const hash_coefficients c;
+        return c;
+    }
+
+    static signature minhash(const std::vector<uint32_t> &tokens) {
+        const hash_coefficients &c = coefficients();
+        signature sig;
+        sig.fill(UINT32_MAX);
+        for (uint32_t t : tokens) {
+            for (size_t i = 0; i < num_hashes; i++) {
+                sig[i] = std::min(sig[i], c.a[i] * t + c.b[i]);
+            }
+        }
+        return sig;
+    }
+
+    static uint64_t band_key(const signature &sig, size_t band, uint64_t prefix_hash) {
+        uint64_t h = prefix_hash ^ (band * 0x9e3779b97f4a7c15);
+        for (size_t r = 0; r < rows_per_band; r++) {
+            h = (h ^ sig[band * rows_per_band + r]) * 0x100000001b3;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+
+public:
+
+    // add() adds the fingerprint string fp to the index
+    //
+    void add(std::string_view fp) {
+        std::vector<uint32_t> tokens;
+        uint64_t prefix_hash;
+        fingerprint_tokens(fp, tokens, prefix_hash);
+        if (tokens.empty()) {
+            return;
+        }
+        uint32_t id = fingerprints.size();
+        signature sig = minhash(tokens);
+        for (size_t band = 0; band < num_bands; band++) {
+            buckets[band_key(sig, band, prefix_hash)].push_back(id);
+        }
+        fingerprints.push_back(fp);
+        sequences.push_back(std::move(tokens));
+    }
+
+    size_t size() const { return fingerprints.size(); }
+
+    uint64_t id() const { return id_; }
+
+    // nearest() returns the indexed fingerprint that is most similar
+    // to fp, and its similarity, or an empty match if no indexed
+    // fingerprint shares a band with fp
+    //
+    match nearest(std::string_view fp) const {
+        std::vector<uint32_t> tokens;
+        uint64_t prefix_hash;
+        fingerprint_tokens(fp, tokens, prefix_hash);
+        if (tokens.empty() || fingerprints.empty()) {
+            return {};
+        }
+        signature sig = minhash(tokens);
+
+        // count the bands that each candidate shares with fp, looking
+        // at no more than max_bucket_scan fingerprints in each bucket
+        //
+        std::vector<uint32_t> ids;
+        ids.reserve(num_bands * max_bucket_scan);
+        for (size_t band = 0; band < num_bands; band++) {
+            auto bucket = buckets.find(band_key(sig, band, prefix_hash));
+            if (bucket == buckets.end()) {
+                continue;
+            }
+            size_t n = std::min(bucket->second.size(), max_bucket_scan);
+            ids.insert(ids.end(), bucket->second.begin(), bucket->second.begin() + n);
+        }
+        if (ids.empty()) {
+            return {};
+        }
+        std::sort(ids.begin(), ids.end());
+        std::vector<std::pair<uint32_t, uint32_t>> candidates;  // (shared bands, id)
+        for (size_t i = 0; i < ids.size(); ) {
+            size_t j = i + 1;
+            while (j < ids.size() && ids[j] == ids[i]) {
+                j++;
+            }
+            candidates.push_back({ (uint32_t)(j - i), ids[i] });
+            i = j;
+        }
+        size_t num_candidates = std::min(candidates.size(), max_candidates);
+        std::partial_sort(candidates.begin(), candidates.begin() + num_candidates, candidates.end(),
+                          [](const auto &x, const auto &y) { return x.first > y.first; });
+        candidates.resize(num_candidates);
+
+        // rank the candidates by edit distance, skipping those whose
+        // difference in length from fp, which is a lower bound on the
+        // distance, exceeds the best distance so far
+        //
+        token_edit_distance ed{tokens};
+        match best;
+        size_t best_distance = SIZE_MAX;
+        for (const auto &c : candidates) {
+            const std::vector<uint32_t> &seq = sequences[c.second];
+            size_t length_difference = std::max(ed.pattern_length(), seq.size()) - std::min(ed.pattern_length(), seq.size());
+            if (length_difference > best_distance) {
+                continue;
+            }
+            size_t d = ed.distance(seq);
+            size_t longest = std::max(ed.pattern_length(), seq.size());
+            if (d < best_distance || (d == best_distance && fingerprints[c.second] < best.fingerprint)) {
+                best_distance = d;
+                best.fingerprint = fingerprints[c.second];
+                best.similarity = longest ? 1.0 - (double)std::min(d, longest) / longest : 1.0;
+            }
+        }
+        return best;
+    }
+
+};
+
+// class nearest_fingerprint_cache memoizes the results of
+// fingerprint_index::nearest() for a single thread, which may look up
+// the same unknown fingerprint many times.  It is a direct-mapped
+// table of num_slots entries indexed by a hash of the fingerprint
+// string; an entry is used only if its fingerprint string and index
+// match those of the lookup, so a collision, or a new index after
+// the resources are reloaded, just costs another call to nearest().
+// Fingerprints longer than max_fingerprint_length are not cached, so
+// the table holds at most num_slots * max_fingerprint_length bytes of
+// fingerprint strings.
+//
+// To bound the time spent on the packet path, at most
+// max_lookups_per_second uncached lookups are made in each second of
+// packet time; after that, lookups that miss the cache return an
+// empty match, and are counted as skipped.
+//
+class nearest_fingerprint_cache {
+public:
+    static constexpr size_t num_slots = 1024;
+    static constexpr size_t max_fingerprint_length = 1024;
+    static constexpr size_t max_lookups_per_second = 1000;
+
+    struct counts {
+        uint64_t hits = 0;
+        uint64_t lookups = 0;      // calls to fingerprint_index::nearest()
+        uint64_t skipped = 0;      // misses not looked up, due to the limit
+    };
+
+private:
+    struct slot {
+        uint64_t index_id = 0;
+        std::string fingerprint;
+        fingerprint_index::match m;
+    };
+    std::vector<slot> slots;
+    time_t second = 0;
+    size_t lookups_this_second = 0;
+    struct counts count;
+
+public:
+
+    nearest_fingerprint_cache() : slots(num_slots) { }
+
+    // nearest() returns index.nearest(fp), from the cache if possible;
+    // sec is the time of the packet that holds fp
+    //
+    fingerprint_index::match nearest(const fingerprint_index &index, std::string_view fp, time_t sec) {
+        slot &s = slots[std::hash<std::string_view>{}(fp) % num_slots];
+        if (s.index_id == index.id() && s.fingerprint == fp) {
+            count.hits++;
+            return s.m;
+        }
+        if (sec != second) {
+            second = sec;
+            lookups_this_second = 0;
+        }
+        if (lookups_this_second >= max_lookups_per_second) {
+            count.skipped++;
+            return {};
+        }
+        lookups_this_second++;
+        count.lookups++;
+        fingerprint_index::match m = index.nearest(fp);
+        if (fp.length() <= max_fingerprint_length) {
+            s.index_id = index.id();
+            s.fingerprint = fp;
+            s.m = m;
+        }
+        return m;
+    }
+
+    const struct counts &get_counts() const { return count; }
+
+};
+
+#endif // FINGERPRINT_INDEX_HPP
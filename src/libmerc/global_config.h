@@ -131,6 +131,11 @@ public:
     std::string crypto_assess_policy;
     bool reassembly = false;              /* reassemble protocol segments      */
     bool stats_blocking = false;          /* stats mode: lossless but blocking */
+    size_t stats_memory = 0;              /* approximate stats memory budget   */
+    size_t suppress_repeats = 0;          /* repeated record cache entries     */
+    unsigned int suppress_timeout = 0;    /* repeated record timeout (seconds) */
+    bool perf_counters = false;           /* count cycles per processing stage */
+    bool nearest_fingerprint = false;     /* report nearest known fingerprint  */
     fingerprint_format fp_format;    // default fingerprint format
 
     global_config() : libmerc_config(), reassembly{false} {};
@@ -275,6 +280,11 @@ static void setup_extended_fields(global_config* lc, const std::string& config)
         {"tcp-reassembly", "", "", SETTER_FUNCTION(&lc){ lc->reassembly = true; }},
         {"reassembly", "", "", SETTER_FUNCTION(&lc){ lc->reassembly = true; }},
         {"stats-blocking", "", "", SETTER_FUNCTION(&lc){ lc->stats_blocking = true; }},
+        {"stats-memory", "", "", SETTER_FUNCTION(&lc){ lc->stats_memory = std::stoull(s); }},
+        {"suppress-repeats", "", "", SETTER_FUNCTION(&lc){ lc->suppress_repeats = std::stoull(s); }},
+        {"suppress-timeout", "", "", SETTER_FUNCTION(&lc){ lc->suppress_timeout = std::stoul(s); }},
+        {"perf-counters", "", "", SETTER_FUNCTION(&lc){ lc->perf_counters = true; }},
+        {"nearest-fingerprint", "", "", SETTER_FUNCTION(&lc){ lc->nearest_fingerprint = true; }},
         {"raw-features", "", "", SETTER_FUNCTION(&lc){ lc->set_raw_features(s); }},
         {"crypto-assess", "", "", SETTER_FUNCTION(&lc){ lc->set_crypto_assess(s); }},
     };
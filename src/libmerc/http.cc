@@ -44,6 +44,7 @@ void http_request::parse(struct datum &p) {
 
     headers.set_header_body(p);
     headers.set_delimiter(delim);
+    headers.index_headers(header_table());
     return;
 }
 
@@ -278,6 +279,9 @@ void http_response::parse(struct datum &p) {
 
     headers.set_header_body(p);
     headers.set_delimiter(delim);
+    if (is_not_empty()) {
+        headers.index_headers(header_table());
+    }
 
     return;
 }
@@ -304,7 +308,7 @@ void http_response::write_json(struct json_object &record, bool metadata) {
 
 }
 
-void http_request::fingerprint(struct buffer_stream &b) {
+perfect_hash<http_header_info> &http_request::header_table() {
     static std::vector<perfect_hash_entry<bool>> fp_data_request = {
         { "accept", true },
         { "accept-encoding", true },
@@ -324,8 +328,6 @@ void http_request::fingerprint(struct buffer_stream &b) {
         { "x-flash-version", false },
         { "x-p2p-peerdist", false }
     };
-    static perfect_hash<bool> fp_ph{fp_data_request};
-
     static std::vector<perfect_hash_entry<uint8_t>> header_data_request = {
         { "user-agent", req_hdrs.index("user-agent") },
         { "host", req_hdrs.index("host")},
@@ -336,8 +338,12 @@ void http_request::fingerprint(struct buffer_stream &b) {
         { "authorization", req_hdrs.index("authorization")}
     };
 
-    static perfect_hash<uint8_t> ph{header_data_request};
+    static std::vector<perfect_hash_entry<http_header_info>> header_info_request = http_header_info::combine(fp_data_request, header_data_request);
+    static perfect_hash<http_header_info> ph{header_info_request};
+    return ph;
+}
 
+void http_request::fingerprint(struct buffer_stream &b) {
     if (is_not_empty() == false) {
         return;
     }
@@ -349,11 +355,11 @@ void http_request::fingerprint(struct buffer_stream &b) {
     b.write_char(')');
 
     b.write_char('(');
-    headers.fingerprint(b, fp_ph, ph);
+    headers.fingerprint(b, header_table());
     b.write_char(')');
 }
 
-void http_response::fingerprint(struct buffer_stream &buf) {
+perfect_hash<http_header_info> &http_response::header_table() {
     static std::vector<perfect_hash_entry<bool>> fp_data_response = {
         { "access-control-allow-credentials", true },
         { "access-control-allow-headers", true },
@@ -405,16 +411,18 @@ void http_response::fingerprint(struct buffer_stream &buf) {
         { "x-timer", false },
         { "x-trace-context", false }
     };
-    static perfect_hash<bool> fp_ph{fp_data_response};
-
     static std::vector<perfect_hash_entry<uint8_t>> header_data_response = {
         { "content-type", resp_hdrs.index("content-type")},
         { "content-length", resp_hdrs.index("content-length")},
         { "server", resp_hdrs.index("server")},
         { "via", resp_hdrs.index("via")}
     };
-    static perfect_hash<uint8_t> ph{header_data_response};
+    static std::vector<perfect_hash_entry<http_header_info>> header_info_response = http_header_info::combine(fp_data_response, header_data_response);
+    static perfect_hash<http_header_info> ph{header_info_response};
+    return ph;
+}
 
+void http_response::fingerprint(struct buffer_stream &buf) {
     if (is_not_empty() == false) {
         return;
     }
@@ -429,7 +437,7 @@ void http_response::fingerprint(struct buffer_stream &buf) {
     buf.write_char(')');
 
     buf.write_char('(');
-    headers.fingerprint(buf, fp_ph, ph);
+    headers.fingerprint(buf, header_table());
     buf.write_char(')');
 }
 
@@ -17,6 +17,7 @@
 #include "analysis.h"
 #include "fingerprint.h"
 #include "perfect_hash.h"
+#include "text_encoding.hpp"
 
 struct http_headers : public datum {
     bool complete;
@@ -90,7 +91,9 @@ public:
 class field_value : public datum {
 public:
     field_value (struct datum& d) {
-        datum::parse_up_to_delimiters(d, '\r', '\n');
+        data = d.data;
+        d.data += text_encoding::line_break_offset(d.data, d.length());
+        data_end = d.data;
     }
 };
 
@@ -169,26 +172,6 @@ struct httpheader {
         valid = d.is_not_null();
     }
 
-    void fingerprint(struct buffer_stream &buf, perfect_hash<bool> &fp_data) const {
-        if (!is_valid()) {
-            return;
-        }
-
-        bool include_name = false;
-        const bool include_value = *(fp_data.lookup(name.data, name.length(), include_name));
-        if (include_name) {
-            if (include_value) {
-                buf.write_char('(');
-                buf.raw_as_hex(hdr_body.data, hdr_body.length());         // write {name, value}
-                buf.write_char(')');
-            } else {
-                buf.write_char('(');
-                buf.raw_as_hex(name.data, name.length()); // write {name}
-                buf.write_char(')');
-            }
-        }
-    }
-
     bool is_valid () const {
         return valid;
     }
@@ -206,6 +189,44 @@ struct httpheader {
     }
 };
 
+// http_header_info describes how a header is processed, based on its
+// name: whether its name, or its name and value, are included in the
+// fingerprint, and the index at which its value is kept for
+// get_header(), if it is one of the headers that are reported
+//
+struct http_header_info {
+    bool include_name;
+    bool include_value;
+    uint8_t index;
+
+    static constexpr uint8_t not_reported = 0xff;
+
+    // combine() returns the entries of a perfect hash table that
+    // merges a table of the headers in a fingerprint with a table of
+    // the headers that are reported, so that a single lookup of each
+    // header name serves both purposes
+    //
+    static std::vector<perfect_hash_entry<http_header_info>> combine(const std::vector<perfect_hash_entry<bool>> &fp_data,
+                                                                     const std::vector<perfect_hash_entry<uint8_t>> &reported) {
+        std::vector<perfect_hash_entry<http_header_info>> entries;
+        for (const auto &e : fp_data) {
+            entries.push_back({ e._key, e._key_len, { true, e._value, not_reported } });
+        }
+        for (const auto &e : reported) {
+            auto match = std::find_if(entries.begin(), entries.end(),
+                                      [&e](const perfect_hash_entry<http_header_info> &x) {
+                                          return x._key_len == e._key_len && strcmp(x._key, e._key) == 0;
+                                      });
+            if (match != entries.end()) {
+                match->_value.index = e._value;
+            } else {
+                entries.push_back({ e._key, e._key_len, { false, false, e._value } });
+            }
+        }
+        return entries;
+    }
+};
+
 template <size_t N>
 class new_http_headers {
     datum header_body;
@@ -213,6 +234,58 @@ class new_http_headers {
     std::array<datum, N> headers;
     static constexpr size_t max_body_length = 512;  // limit on number of bytes reported
 
+    // the headers are parsed once, by index_headers(), which records
+    // the location of the first max_indexed_headers headers, along
+    // with the result of looking up their names; any further headers
+    // are parsed again from unindexed when they are needed
+    //
+    struct header_location {
+        const uint8_t *name;
+        const uint8_t *name_end;
+        const uint8_t *value;
+        const uint8_t *value_end;
+        const uint8_t *delim;
+        const uint8_t *delim_end;
+        http_header_info info;
+    };
+    static constexpr size_t max_indexed_headers = 32;
+    std::array<header_location, max_indexed_headers> index;
+    size_t num_indexed = 0;
+    datum unindexed;
+    datum after_headers;
+
+    // lookup() returns the http_header_info for the header h
+    //
+    static http_header_info lookup(const httpheader &h, perfect_hash<http_header_info> &ph) {
+        bool found = false;
+        const http_header_info *info = ph.lookup(h.name.data, h.name.length(), found);
+        if (found) {
+            return *info;
+        }
+        return { false, false, http_header_info::not_reported };
+    }
+
+    static void write_fingerprint(struct buffer_stream &b, const uint8_t *name, const uint8_t *name_end, const uint8_t *value_end, http_header_info info) {
+        if (info.include_name) {
+            b.write_char('(');
+            if (info.include_value) {
+                b.raw_as_hex(name, value_end - name);          // write {name, value}
+            } else {
+                b.raw_as_hex(name, name_end - name);           // write {name}
+            }
+            b.write_char(')');
+        }
+    }
+
+    static void write_header_json(json_array &a, const uint8_t *name, const uint8_t *name_end, const uint8_t *value,
+                           const uint8_t *value_end, const uint8_t *delim, const uint8_t *delim_end) {
+        json_object hdr{a};
+        hdr.print_key_json_string("name", datum{name, name_end});
+        hdr.print_key_json_string("value", datum{value, value_end});
+        hdr.print_key_json_string("delimiter", datum{delim, delim_end});
+        hdr.close();
+    }
+
 public:
 
     new_http_headers() :
@@ -236,12 +309,88 @@ public:
         delim = _delim;
     }
 
+    /*
+     * index_headers() parses the HTTP headers, in a single pass, and
+     * looks up each header name in the perfect hash table `ph`,
+     * which determines whether the header or header-value pair is
+     * part of the fingerprint, and whether the header value needs to
+     * be stored in the headers array and, if so, provides the index
+     * at which the value is stored.  It must be called after
+     * set_header_body() and set_delimiter(), and before any of the
+     * other functions that process the headers.
+     */
+    void index_headers(perfect_hash<http_header_info> &ph) {
+        datum tmp = header_body;
+        while(1) {
+            delimiter d(tmp, delim);
+            if (d.is_valid()) {
+                break;
+            }
+            const uint8_t *header_start = tmp.data;
+            httpheader h = get_next_header(tmp);
+            if (!h.is_valid()) {
+                break;
+            }
+            http_header_info info = lookup(h, ph);
+            if (info.index != http_header_info::not_reported) {
+                /* Incase of duplicate http headers, index of the first http header
+                 * is stored.
+                 */
+                if (headers[info.index].is_null()) {
+                    headers[info.index] = h.value;
+                }
+            }
+            if (num_indexed < max_indexed_headers) {
+                const datum delimiter = h.delim.get_delimiter();
+                index[num_indexed++] = {
+                    h.name.data, h.name.data_end, h.value.data, h.value.data_end, delimiter.data, delimiter.data_end, info
+                };
+            } else if (unindexed.is_null()) {
+                unindexed = { header_start, header_body.data_end };
+            }
+        }
+        after_headers = tmp;
+    }
+
     void write_json(struct json_object &record) {
+        if (num_indexed == 0) {
+            // there is no header before the first delimiter, so the
+            // headers are parsed from the start of header_body
+            //
+            write_json_unindexed(record, header_body);
+            return;
+        }
+        json_array hdrs{record, "headers"};
+        for (size_t i = 0; i < num_indexed; i++) {
+            const header_location &x = index[i];
+            write_header_json(hdrs, x.name, x.name_end, x.value, x.value_end, x.delim, x.delim_end);
+        }
+        datum tmp = unindexed;
+        while(tmp.is_not_null()) {
+            delimiter d(tmp, delim);
+            if (d.is_valid()) {
+                break;
+            }
+            httpheader h = get_next_header(tmp);
+            if (!h.is_valid()) {
+                break;
+            }
+            h.write_json(hdrs);
+        }
+        hdrs.close();
+        if (after_headers.is_readable()) {
+            datum body = after_headers;
+            body.trim_to_length(max_body_length);
+            record.print_key_hex("body", body);
+        }
+    }
+
+    void write_json_unindexed(struct json_object &record, datum header_body) {
         httpheader h = get_next_header(header_body);
         if (h.is_valid()) {
             json_array hdrs{record, "headers"};
             h.write_json(hdrs);
-            while(1) { 
+            while(1) {
                 delimiter d(header_body, delim);
                 if (d.is_valid()) {
                     break;
@@ -262,46 +411,27 @@ public:
     }
 
     /*
-     * HTTP headers are parsed during fingerprinting. When there
-     * are headers of interest, their values are stored in the
-     * headers array.
-     * The headers of interest are defined in the perfect hash table `ph`,
-     * which stores the header name and the corresponding index.
-     * If the parsed header is present in the hash table `ph`, the index
-     * is retrieved and used to store the header value in the
-     * headers array.
-     *
-     * Input Arguments:
-     * b       - buffer stream to write the fingerprint.
-     * fp_data - perfect hash table used to determine if the header or
-     *           header-value pair should be part of the fingerprint.
-     * ph      - perfect hash table used to determine if the header value
-     *           needs to be stored and, if so, provides the index at
-     *           which the value is stored.
+     * fingerprint() writes the headers that are part of the
+     * fingerprint into the buffer stream b, using the results of the
+     * lookups made by index_headers(), and the perfect hash table
+     * `ph` for any headers that were not indexed.
      */
-    void fingerprint(struct buffer_stream &b, perfect_hash<bool> &fp_data,
-                     perfect_hash<uint8_t> &ph) {
-        datum tmp = header_body;
-        while(1) {
+    void fingerprint(struct buffer_stream &b, perfect_hash<http_header_info> &ph) const {
+        for (size_t i = 0; i < num_indexed; i++) {
+            const header_location &x = index[i];
+            write_fingerprint(b, x.name, x.name_end, x.value_end, x.info);
+        }
+        datum tmp = unindexed;
+        while(tmp.is_not_null()) {
             delimiter d(tmp, delim);
             if (d.is_valid()) {
                 break;
             }
-            httpheader h = get_next_header(tmp);
+            httpheader h{tmp, delim};
             if (!h.is_valid()) {
                 break;
             }
-            h.fingerprint(b, fp_data);
-            bool is_header_found = false;
-            uint8_t header_idx = *ph.lookup(h.name.data, h.name.length(), is_header_found);
-            if (is_header_found) {
-                /* Incase of duplicate http headers, index of the first http header
-                 * is stored.
-                 */
-                if (headers[header_idx].is_null()) {
-                    headers[header_idx] = h.value;
-                }
-            }
+            write_fingerprint(b, h.name.data, h.name.data_end, h.value.data_end, lookup(h, ph));
         }
     }
 };
@@ -346,6 +476,8 @@ struct http_request : public base_protocol {
 
     void compute_fingerprint(class fingerprint &fp);
 
+    static perfect_hash<http_header_info> &header_table();
+
     bool do_analysis(const struct key &k_, struct analysis_context &analysis_, classifier *c);
 
     // weight 14 bitmask that matches all HTTP methods
@@ -409,6 +541,8 @@ struct http_response : public base_protocol {
 
     void compute_fingerprint(class fingerprint &fp);
 
+    static perfect_hash<http_header_info> &header_table();
+
     struct datum get_header(const char *header_name);
 
     static constexpr mask_and_value<8> matcher{
@@ -0,0 +1,625 @@
+/*
+ * ip_defrag.hpp
+ *
+ * bounded reassembly of fragmented IPv4 and IPv6 datagrams
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#ifndef IP_DEFRAG_HPP
+#define IP_DEFRAG_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include "datum.h"
+
+// ip_defragmenter reassembles fragmented IPv4 and IPv6 datagrams, so
+// that the transport and application protocols that they carry can
+// be parsed.  Each packet processor has its own defragmenter, which
+// is applied to each IP packet before its transport protocol is
+// parsed.
+//
+// The memory used by a defragmenter is allocated when it sees its
+// first fragment, and does not grow after that:
+//
+//   * fragment data is stored in fixed-size slabs, which are taken
+//     from a free list, so the number of slabs is a hard budget for
+//     all of the datagrams being reassembled,
+//
+//   * datagrams are kept in a fixed-size, set-associative table; when
+//     a set is full, its oldest datagram is evicted,
+//
+//   * a datagram can have at most max_fragments fragments, and its
+//     reassembled length is limited to that of an IP datagram, and
+//
+//   * datagrams that are not complete within timeout seconds of their
+//     first fragment are discarded.
+//
+// A fragment that overlaps another fragment of the same datagram
+// causes the datagram to be discarded, along with any of its
+// fragments that arrive later (RFC 5722), unless it is an exact
+// duplicate, in which case it is ignored.  For IPv4, the first_wins
+// policy can be selected instead, which keeps the data of the
+// fragments received first and adds only the new data of an
+// overlapping fragment.
+//
+// Each fragment and datagram that is dropped is counted by reason,
+// so that fragment floods can be seen in the processor metrics.
+//
+class ip_defragmenter {
+public:
+
+    enum class overlap_policy : uint8_t {
+        discard,       // discard the datagram (RFC 5722)
+        first_wins,    // keep the data received first (IPv4 only)
+    };
+
+    enum result : uint8_t {
+        not_fragment,  // packet should be processed as is
+        held,          // fragment stored, datagram not yet complete
+        dropped,       // fragment dropped
+        reassembled,   // packet now holds the reassembled datagram
+    };
+
+    enum counter : uint8_t {
+        fragments,           // fragments seen
+        datagrams,           // datagrams reassembled
+        duplicate,           // exact duplicate fragments ignored
+        overlap,             // fragments that overlap a fragment already received
+        discarded,           // fragments of datagrams that were discarded earlier
+        expired,             // datagrams that were not complete before the timeout
+        evicted,             // datagrams evicted to make room in the table
+        no_memory,           // datagrams discarded because all slabs were in use
+        too_many_fragments,  // datagrams discarded with more than max_fragments
+        too_long,            // datagrams discarded that would exceed max_length
+        malformed,           // fragments with invalid lengths or offsets
+        num_counters
+    };
+
+    // the names of the counters, as used in metrics
+    //
+    static constexpr const char *counter_name[num_counters] = {
+        "fragments",
+        "datagrams",
+        "duplicate",
+        "overlap",
+        "discarded",
+        "expired",
+        "evicted",
+        "no_memory",
+        "too_many_fragments",
+        "too_long",
+        "malformed",
+    };
+
+    using counts = std::array<uint64_t, num_counters>;
+
+    static constexpr size_t slab_size = 1024;
+    static constexpr size_t default_slabs = 1024;              // 1 MiB of fragment data
+    static constexpr size_t default_datagrams = 128;
+    static constexpr size_t ways = 4;                           // datagrams per set
+    static constexpr size_t max_fragments = 64;                 // per datagram
+    static constexpr size_t max_length = 65535;                 // IPv4 total length, IPv6 payload length
+    static constexpr size_t max_header_length = 256;            // IPv4 header, or IPv6 unfragmentable part
+    static constexpr size_t ipv6_header_length = 40;
+    static constexpr size_t max_slabs_per_datagram = (max_length + slab_size - 1) / slab_size;
+    static constexpr unsigned int timeout = 5;                  // seconds
+
+    // the constructor does not allocate memory; the memory needed for
+    // num_slabs slabs and num_datagrams datagrams is allocated when the
+    // first fragment is seen
+    //
+    explicit ip_defragmenter(size_t num_slabs=default_slabs,
+                             size_t num_datagrams=default_datagrams,
+                             overlap_policy ipv4_policy=overlap_policy::discard) :
+        slab_count{std::min(num_slabs, (size_t)no_slab)},
+        set_count{std::max(num_datagrams / ways, (size_t)1)},
+        ipv4_policy{ipv4_policy} { }
+
+    // apply() processes the IP packet pkt, with timestamp sec.  If pkt
+    // is a fragment, it is stored, and if that completes its datagram,
+    // pkt is set to the reassembled datagram, which remains valid
+    // until the next call to apply()
+    //
+    result apply(datum &pkt, unsigned int sec) {
+        fragment f;
+        switch (parse(pkt, f)) {
+        case parse_result::not_fragment:
+            return not_fragment;
+        case parse_result::malformed:
+            count[fragments]++;
+            count[malformed]++;
+            return dropped;
+        case parse_result::fragment:
+            break;
+        }
+        count[fragments]++;
+
+        allocate();
+        reap(sec);
+        datagram &d = find_or_insert(f, sec);
+        if (d.state == datagram::discarded) {
+            count[discarded]++;
+            return dropped;
+        }
+        return add(d, f, pkt, sec);
+    }
+
+    const counts &get_counts() const { return count; }
+
+    // returns the number of datagrams that are being reassembled
+    //
+    size_t size() const {
+        return std::count_if(table.begin(), table.end(), [](const datagram &d) { return d.state == datagram::active; });
+    }
+
+    size_t slabs_in_use() const { return slab_memory.empty() ? 0 : slab_count - free_slabs.size(); }
+
+    // returns the number of bytes allocated by this defragmenter,
+    // which is fixed once the first fragment has been seen
+    //
+    size_t allocated_bytes() const {
+        return slab_memory.capacity() + free_slabs.capacity() * sizeof(uint16_t)
+            + table.capacity() * sizeof(datagram) + output.capacity();
+    }
+
+private:
+
+    static constexpr uint16_t no_slab = 0xffff;
+
+    struct range {
+        uint32_t start;
+        uint32_t end;
+    };
+
+    struct datagram {
+        enum : uint8_t { empty, active, discarded } state = empty;
+        uint8_t ip_vers = 0;
+        uint8_t protocol = 0;         // IPv4 protocol, part of the key
+        uint8_t next_header = 0;      // IPv6 next header, from the first fragment
+        uint32_t id = 0;
+        uint8_t src[16] = {};
+        uint8_t dst[16] = {};
+        unsigned int sec = 0;         // timestamp of the first fragment
+        uint32_t length = 0;          // payload length, or zero if the last fragment has not been seen
+        uint32_t received = 0;        // payload bytes received
+        uint16_t header_length = 0;   // zero if the first fragment has not been seen
+        uint16_t next_header_offset = 0;
+        uint8_t num_fragments = 0;
+        std::array<range, max_fragments> fragments;   // sorted by start, disjoint
+        std::array<uint16_t, max_slabs_per_datagram> slab;
+        std::array<uint8_t, max_header_length> header;
+
+        bool is_expired(unsigned int current_time) const {
+            return (current_time - sec) >= timeout;
+        }
+    };
+
+    // a fragment, as parsed from a packet
+    //
+    struct fragment {
+        uint8_t ip_vers;
+        uint8_t protocol;
+        uint8_t next_header;
+        uint32_t id;
+        const uint8_t *src;
+        const uint8_t *dst;
+        uint32_t offset;
+        bool more;
+        datum header;                 // IPv4 header, or IPv6 unfragmentable part
+        size_t next_header_offset;    // IPv6 only
+        datum data;
+
+        size_t addr_length() const { return ip_vers == 4 ? 4 : 16; }
+    };
+
+    enum class parse_result : uint8_t { not_fragment, fragment, malformed };
+
+    size_t slab_count;
+    size_t set_count;
+    overlap_policy ipv4_policy;
+    std::vector<datagram> table;
+    std::vector<uint8_t> slab_memory;
+    std::vector<uint16_t> free_slabs;
+    std::vector<uint8_t> output;
+    size_t hand = 0;
+    counts count{};
+
+    static uint16_t read_u16(const uint8_t *p) { return (uint16_t)p[0] << 8 | p[1]; }
+
+    static uint32_t read_u32(const uint8_t *p) { return (uint32_t)read_u16(p) << 16 | read_u16(p + 2); }
+
+    static void write_u16(uint8_t *p, uint16_t x) {
+        p[0] = x >> 8;
+        p[1] = x;
+    }
+
+    static parse_result parse(const datum &pkt, fragment &f) {
+        const uint8_t *p = pkt.data;
+        size_t length = pkt.length();
+        if (length < 1) {
+            return parse_result::not_fragment;
+        }
+        switch (p[0] >> 4) {
+        case 4:
+            return parse_ipv4(p, length, f);
+        case 6:
+            return parse_ipv6(p, length, f);
+        default:
+            return parse_result::not_fragment;
+        }
+    }
+
+    static parse_result parse_ipv4(const uint8_t *p, size_t length, fragment &f) {
+        if (length < 20) {
+            return parse_result::not_fragment;
+        }
+        uint16_t flgoff = read_u16(p + 6);
+        f.more = flgoff & 0x2000;
+        f.offset = (flgoff & 0x1fff) * 8;
+        if (!f.more && f.offset == 0) {
+            return parse_result::not_fragment;
+        }
+        size_t header_length = (p[0] & 0x0f) * 4;
+        size_t total_length = read_u16(p + 2);
+        if (header_length < 20 || total_length <= header_length || total_length > length) {
+            return parse_result::malformed;
+        }
+        f.ip_vers = 4;
+        f.protocol = p[9];
+        f.next_header = p[9];
+        f.id = read_u16(p + 4);
+        f.src = p + 12;
+        f.dst = p + 16;
+        f.header = datum{p, p + header_length};
+        f.next_header_offset = 9;
+        f.data = datum{p + header_length, p + total_length};
+        return parse_result::fragment;
+    }
+
+    static parse_result parse_ipv6(const uint8_t *p, size_t length, fragment &f) {
+        if (length < ipv6_header_length) {
+            return parse_result::not_fragment;
+        }
+        size_t end = ipv6_header_length + read_u16(p + 4);
+        bool truncated = end > length;
+        size_t limit = truncated ? length : end;
+
+        // skip the extension headers in the unfragmentable part
+        //
+        size_t next_header_offset = 6;
+        size_t offset = ipv6_header_length;
+        uint8_t next_header = p[6];
+        while (next_header == 0 || next_header == 43 || next_header == 60) {  // hop-by-hop, routing, destination options
+            if (offset + 2 > limit) {
+                return parse_result::not_fragment;
+            }
+            next_header_offset = offset;
+            next_header = p[offset];
+            offset += (p[offset + 1] + 1) * 8;
+        }
+        if (next_header != 44) {
+            return parse_result::not_fragment;
+        }
+        if (offset + 8 > limit) {
+            return parse_result::malformed;
+        }
+        uint16_t offset_flags = read_u16(p + offset + 2);
+        f.more = offset_flags & 0x0001;
+        f.offset = offset_flags & 0xfff8;
+        if (!f.more && f.offset == 0) {
+            return parse_result::not_fragment;  // atomic fragment (RFC 6946)
+        }
+        if (truncated || offset > max_header_length || offset + 8 == end) {
+            return parse_result::malformed;
+        }
+        f.ip_vers = 6;
+        f.protocol = 0;
+        f.next_header = p[offset];
+        f.id = read_u32(p + offset + 4);
+        f.src = p + 8;
+        f.dst = p + 24;
+        f.header = datum{p, p + offset};
+        f.next_header_offset = next_header_offset;
+        f.data = datum{p + offset + 8, p + end};
+        return parse_result::fragment;
+    }
+
+    void allocate() {
+        if (!table.empty()) {
+            return;
+        }
+        table.resize(set_count * ways);
+        slab_memory.resize(slab_count * slab_size);
+        free_slabs.reserve(slab_count);
+        for (size_t i = slab_count; i > 0; i--) {
+            free_slabs.push_back(i - 1);
+        }
+        output.resize(max_length + ipv6_header_length);
+    }
+
+    bool matches(const datagram &d, const fragment &f) const {
+        return d.ip_vers == f.ip_vers
+            && d.id == f.id
+            && d.protocol == f.protocol
+            && memcmp(d.src, f.src, f.addr_length()) == 0
+            && memcmp(d.dst, f.dst, f.addr_length()) == 0;
+    }
+
+    size_t set_of(const fragment &f) const {
+        uint32_t h = 2166136261u ^ f.id ^ f.protocol;   // FNV-1a
+        for (size_t i = 0; i < f.addr_length(); i++) {
+            h = (h ^ f.src[i]) * 16777619u;
+            h = (h ^ f.dst[i]) * 16777619u;
+        }
+        return h % set_count;
+    }
+
+    // release() returns the slabs of a datagram to the free list
+    //
+    void release(datagram &d) {
+        for (uint16_t &s : d.slab) {
+            if (s != no_slab) {
+                free_slabs.push_back(s);
+                s = no_slab;
+            }
+        }
+    }
+
+    void remove(datagram &d) {
+        release(d);
+        d.state = datagram::empty;
+    }
+
+    // discard() drops the data of a datagram, but keeps it in the
+    // table until it expires, so that its later fragments are dropped
+    //
+    result discard(datagram &d, counter reason) {
+        release(d);
+        d.state = datagram::discarded;
+        count[reason]++;
+        return dropped;
+    }
+
+    void expire(datagram &d) {
+        if (d.state == datagram::active) {
+            count[expired]++;
+        }
+        remove(d);
+    }
+
+    // reap() advances the clock hand by one datagram, and removes that
+    // datagram if it has expired
+    //
+    void reap(unsigned int sec) {
+        datagram &d = table[hand];
+        if (d.state != datagram::empty && d.is_expired(sec)) {
+            expire(d);
+        }
+        hand = (hand + 1) % table.size();
+    }
+
+    // reclaim() removes all of the expired datagrams, to free up slabs
+    //
+    void reclaim(unsigned int sec) {
+        for (datagram &d : table) {
+            if (d.state != datagram::empty && d.is_expired(sec)) {
+                expire(d);
+            }
+        }
+    }
+
+    datagram &find_or_insert(const fragment &f, unsigned int sec) {
+        datagram *set = &table[set_of(f) * ways];
+        datagram *slot = nullptr;
+        for (size_t i = 0; i < ways; i++) {
+            datagram &d = set[i];
+            if (d.state == datagram::empty) {
+                if (slot == nullptr || slot->state != datagram::empty) {
+                    slot = &d;
+                }
+                continue;
+            }
+            if (d.is_expired(sec)) {
+                expire(d);
+                slot = &d;
+                continue;
+            }
+            if (matches(d, f)) {
+                return d;
+            }
+        }
+        if (slot == nullptr) {
+            slot = set;
+            for (size_t i = 1; i < ways; i++) {
+                if (sec - set[i].sec > sec - slot->sec) {  // older
+                    slot = &set[i];
+                }
+            }
+            if (slot->state == datagram::active) {
+                count[evicted]++;
+            }
+            remove(*slot);
+        }
+        datagram &d = *slot;
+        d.state = datagram::active;
+        d.ip_vers = f.ip_vers;
+        d.protocol = f.protocol;
+        d.id = f.id;
+        memcpy(d.src, f.src, f.addr_length());
+        memcpy(d.dst, f.dst, f.addr_length());
+        d.sec = sec;
+        d.length = 0;
+        d.received = 0;
+        d.header_length = 0;
+        d.num_fragments = 0;
+        d.slab.fill(no_slab);
+        return d;
+    }
+
+    // store() copies data into the slabs of a datagram, at offset
+    // within its payload, and returns false if there are not enough
+    // free slabs
+    //
+    bool store(datagram &d, uint32_t offset, const uint8_t *data, size_t length, unsigned int sec) {
+        while (length > 0) {
+            size_t i = offset / slab_size;
+            size_t slab_offset = offset % slab_size;
+            size_t n = std::min(length, slab_size - slab_offset);
+            if (d.slab[i] == no_slab) {
+                if (free_slabs.empty()) {
+                    reclaim(sec);
+                    if (free_slabs.empty()) {
+                        return false;
+                    }
+                }
+                d.slab[i] = free_slabs.back();
+                free_slabs.pop_back();
+            }
+            memcpy(slab_memory.data() + d.slab[i] * slab_size + slab_offset, data, n);
+            offset += n;
+            data += n;
+            length -= n;
+        }
+        return true;
+    }
+
+    // insert() stores the data of f in [start, end), which must not
+    // overlap any fragment of d
+    //
+    bool insert(datagram &d, const fragment &f, uint32_t start, uint32_t end, unsigned int sec) {
+        if (d.num_fragments == max_fragments) {
+            discard(d, too_many_fragments);
+            return false;
+        }
+        if (!store(d, start, f.data.data + (start - f.offset), end - start, sec)) {
+            discard(d, no_memory);
+            return false;
+        }
+        range *it = std::lower_bound(d.fragments.begin(), d.fragments.begin() + d.num_fragments, start,
+                                     [](const range &r, uint32_t s) { return r.start < s; });
+        std::copy_backward(it, d.fragments.begin() + d.num_fragments, d.fragments.begin() + d.num_fragments + 1);
+        *it = {start, end};
+        d.num_fragments++;
+        d.received += end - start;
+        return true;
+    }
+
+    result add(datagram &d, const fragment &f, datum &pkt, unsigned int sec) {
+        uint32_t start = f.offset;
+        uint32_t end = start + f.data.length();
+        size_t header_length = f.header.length() - (f.ip_vers == 6 ? ipv6_header_length : 0);
+        if (header_length + end > max_length) {
+            return discard(d, too_long);
+        }
+        if (f.more && (end - start) % 8 != 0) {
+            count[malformed]++;
+            return dropped;
+        }
+        uint32_t last_end = d.num_fragments ? d.fragments[d.num_fragments - 1].end : 0;
+        if (!f.more) {
+            if ((d.length != 0 && d.length != end) || last_end > end) {
+                return discard(d, malformed);
+            }
+            d.length = end;
+        } else if (d.length != 0 && end > d.length) {
+            return discard(d, malformed);
+        }
+
+        // check for overlapping fragments
+        //
+        range *first = std::lower_bound(d.fragments.begin(), d.fragments.begin() + d.num_fragments, start,
+                                        [](const range &r, uint32_t s) { return r.end <= s; });
+        range *last = first;
+        while (last != d.fragments.begin() + d.num_fragments && last->start < end) {
+            last++;
+        }
+        if (first != last) {
+            if (first + 1 == last && first->start == start && first->end == end) {
+                count[duplicate]++;
+                return dropped;
+            }
+            if (f.ip_vers == 6 || ipv4_policy == overlap_policy::discard) {
+                return discard(d, overlap);
+            }
+            count[overlap]++;
+
+            // first_wins: store only the parts of f that fill gaps
+            // between the fragments that it overlaps
+            //
+            std::array<range, max_fragments> gaps;
+            size_t num_gaps = 0;
+            uint32_t cursor = start;
+            for (range *r = first; r != last; r++) {
+                if (r->start > cursor) {
+                    gaps[num_gaps++] = {cursor, r->start};
+                }
+                cursor = std::max(cursor, r->end);
+            }
+            if (cursor < end) {
+                gaps[num_gaps++] = {cursor, end};
+            }
+            for (size_t i = 0; i < num_gaps; i++) {
+                if (!insert(d, f, gaps[i].start, gaps[i].end, sec)) {
+                    return dropped;
+                }
+            }
+        } else if (!insert(d, f, start, end, sec)) {
+            return dropped;
+        }
+
+        if (start == 0 && d.header_length == 0) {
+            d.header_length = f.header.length();
+            memcpy(d.header.data(), f.header.data, d.header_length);
+            d.next_header = f.next_header;
+            d.next_header_offset = f.next_header_offset;
+        }
+
+        if (d.length == 0 || d.received != d.length) {
+            return held;
+        }
+        write_datagram(d, pkt);
+        remove(d);
+        count[datagrams]++;
+        return reassembled;
+    }
+
+    // write_datagram() writes the header and payload of the complete
+    // datagram d into the output buffer, and sets pkt to it.  The
+    // header is that of the first fragment, with the length and
+    // fragmentation fields updated
+    //
+    void write_datagram(const datagram &d, datum &pkt) {
+        uint8_t *o = output.data();
+        memcpy(o, d.header.data(), d.header_length);
+        size_t total_length = d.header_length + d.length;
+        if (d.ip_vers == 4) {
+            write_u16(o + 2, total_length);
+            write_u16(o + 6, read_u16(o + 6) & 0x4000);  // keep the don't fragment flag
+            write_u16(o + 10, 0);
+            uint32_t sum = 0;
+            for (size_t i = 0; i < d.header_length; i += 2) {
+                sum += read_u16(o + i);
+            }
+            while (sum >> 16) {
+                sum = (sum & 0xffff) + (sum >> 16);
+            }
+            write_u16(o + 10, ~sum);
+        } else {
+            write_u16(o + 4, total_length - ipv6_header_length);
+            o[d.next_header_offset] = d.next_header;
+        }
+        for (size_t offset = 0; offset < d.length; offset += slab_size) {
+            size_t n = std::min(slab_size, (size_t)d.length - offset);
+            memcpy(o + d.header_length + offset, slab_memory.data() + d.slab[offset / slab_size] * slab_size, n);
+        }
+        pkt = datum{o, o + total_length};
+    }
+
+};
+
+#endif // IP_DEFRAG_HPP
@@ -30,15 +30,11 @@ struct json_object {
         b->write_char('{');
     }
     explicit json_object(struct buffer_stream *buf, const char *name) : b{buf} {
-        b->write_char('\"');
-        b->puts(name);
-        b->puts("\":{");
+        b->write_key(name, "\":{");
     }
     json_object(struct json_object &object, const char *name) : b{object.b} {
         write_comma(object.comma);
-        b->write_char('\"');
-        b->puts(name);
-        b->puts("\":{");
+        b->write_key(name, "\":{");
     }
     json_object(struct json_object &object) : b{object.b} {
         write_comma(object.comma);
@@ -64,17 +60,13 @@ struct json_object {
     }
     void print_key_string(const char *k, const char *v) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":\"");
+        b->write_key(k, "\":\"");
         b->puts(v);
         b->write_char('\"');
     }
     void print_key_bool(const char *k, bool x) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":");
+        b->write_key(k);
         if (x) {
             b->puts("true");
         } else {
@@ -83,53 +75,48 @@ struct json_object {
     }
     void print_key_null(const char *k) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":null");
+        b->write_key(k, "\":null");
     }
     void print_key_uint8(const char *k, uint8_t u) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->write_char('\"');
-        b->write_char(':');
+        b->write_key(k);
         b->write_uint8(u);
     }
     void print_key_uint8_hex(const char *k, uint8_t u) {
         write_comma(comma);
-        b->snprintf("\"%s\":\"", k);
+        b->write_key(k, "\":\"");
         b->write_hex_uint(u);
         b->write_char('\"');
     }
     void print_key_uint16(const char *k, uint16_t u) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->write_char('\"');
-        b->write_char(':');
+        b->write_key(k);
         b->write_uint16(u);
     }
     void print_key_uint16_hex(const char *k, uint16_t u) {
         write_comma(comma);
-        b->snprintf("\"%s\":\"", k);
+        b->write_key(k, "\":\"");
         b->write_hex_uint(u);
         b->write_char('\"');
     }
     void print_key_uint(const char *k, unsigned long int u) { // note: JSON can't represent a uint64_t over 2^53
         write_comma(comma);
-        b->snprintf("\"%s\":%lu", k, u);
+        b->write_key(k);
+        b->write_uint64(u);
     }
     void print_key_int(const char *k, long int i) {
         write_comma(comma);
-        b->snprintf("\"%s\":%ld", k, i);
+        b->write_key(k);
+        b->write_int64(i);
     }
     void print_key_float(const char *k, double d) {
         write_comma(comma);
-        b->snprintf("\"%s\":%f", k, d);
+        b->write_key(k);
+        b->write_float(d);
     }
     void print_key_uint64_hex(const char *k, uint64_t  u) {
         write_comma(comma);
-        b->snprintf("\"%s\":\"", k);
+        b->write_key(k, "\":\"");
         b->write_hex_uint(u);
         b->write_char('\"');
     }
@@ -137,23 +124,21 @@ struct json_object {
     void print_key_uint_hex(const char *k, U u) {
         // U must be an unsigned integer type, or an encoded<> type
         write_comma(comma);
-        b->snprintf("\"%s\":\"", k);
+        b->write_key(k, "\":\"");
         b->write_hex_uint(u);
         b->write_char('\"');
     }
     template <typename uint>
     void print_key_unknown_code(const char *k, uint u) {
         write_comma(comma);
-        b->snprintf("\"%s\":\"UNKNOWN (", k);
+        b->write_key(k, "\":\"UNKNOWN (");
         b->write_hex_uint(u);
         b->write_char(')');
         b->write_char('\"');
     }
     void print_key_hex(const char *k, const struct datum &value) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":\"");
+        b->write_key(k, "\":\"");
         if (value.data && value.data_end && value.data_end > value.data) {
             b->raw_as_hex(value.data, value.data_end - value.data);
         }
@@ -161,17 +146,13 @@ struct json_object {
     }
     void print_key_hex(const char *k, const uint8_t *v, size_t length) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":\"");
+        b->write_key(k, "\":\"");
         b->raw_as_hex(v, length);
         b->write_char('\"');
     }
     void print_key_base64(const char *k, const struct datum &value) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":");
+        b->write_key(k);
         if (value.data && value.data_end) {
             b->raw_as_base64(value.data, value.data_end - value.data);
         } else {
@@ -181,50 +162,38 @@ struct json_object {
     }
     void print_key_timestamp(const char *k, struct timespec *ts) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":");
+        b->write_key(k);
         b->write_timestamp(ts);
     }
     void print_key_timestamp_as_string(const char *k, struct timespec *ts) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":\"");
+        b->write_key(k, "\":\"");
         b->write_timestamp_as_string(ts);
         b->write_char('\"');
     }
     template <typename T> void print_key_value(const char *k, T &w) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":\"");
+        b->write_key(k, "\":\"");
         w.fingerprint(*b);
         b->write_char('\"');
      }
     void print_key_ipv4_addr(const char *k, const uint8_t *a) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":");
+        b->write_key(k);
         b->write_char('\"');
         b->write_ipv4_addr(a);
         b->write_char('\"');
     }
     void print_key_ipv6_addr(const char *k, const uint8_t *a) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":");
+        b->write_key(k);
         b->write_char('\"');
         b->write_ipv6_addr(a);
         b->write_char('\"');
     }
     void print_key_datum(const char *k, const struct datum &d) {
         write_comma(comma);
-        b->write_char('\"');
-        b->puts(k);
-        b->puts("\":{");
+        b->write_key(k, "\":{");
         b->snprintf("\"data\":\"%p\",", d.data);
         b->snprintf("\"data_end\":\"%p\"", d.data_end);
         b->write_char('}');
@@ -250,9 +219,7 @@ struct json_array {
     }
     json_array(struct json_object &object, const char *name) : b{object.b} {
         write_comma(object.comma);
-        b->write_char('\"');
-        b->puts(name);
-        b->puts("\":[");
+        b->write_key(name, "\":[");
     }
     void close() {
         b->write_char(']');
@@ -277,15 +244,15 @@ struct json_array {
     }
     void print_uint(unsigned long int u) {
         write_comma(comma);
-        b->snprintf("%lu", u);
+        b->write_uint64(u);
     }
     void print_int(long int i) {
         write_comma(comma);
-        b->snprintf("%ld", i);
+        b->write_int64(i);
     }
     void print_float(double d) {
         write_comma(comma);
-        b->snprintf("%f", d);
+        b->write_float(d);
     }
     void print_string(const char *s) {
         write_comma(comma);
@@ -63,8 +63,11 @@ uint32_t mercury_get_version_number() {
 }
 
 const char *mercury_get_resource_version(struct mercury *mc) {
-    if (mc && mc->c) {
-        return mc->c->get_resource_version();
+    if (mc) {
+        classifier *c = mc->c.load(std::memory_order_acquire);
+        if (c) {
+            return c->get_resource_version();
+        }
     }
     return nullptr;
 }
@@ -305,8 +308,9 @@ bool mercury_write_stats_data(mercury_context mc, const char *stats_data_file_pa
         printf_err(log_err, "could not open file '%s' for writing mercury stats data\n", stats_data_file_path);
         return false;
     }
+    std::string resource_version = mc->get_resource_version();  // copy, in case of a concurrent reload
     mc->aggregator->gzprint(stats_data_file,
-                           mercury_get_resource_version(mc),
+                           resource_version.c_str(),
                            git_commit_id,
                            git_count,
                            init_time);
@@ -461,3 +465,149 @@ size_t get_stats_aggregator_num_entries(mercury_context mc)
 
     return mc->aggregator->get_num_entries();
 }
+
+//
+// start of libmerc version 7 API
+//
+
+bool mercury_reload_resources(mercury_context mc, const char *resource_file) {
+    if (mc == NULL) {
+        return false;
+    }
+    try {
+        return mc->reload_classifier(resource_file);
+    }
+    catch (std::exception &e) {
+        printf_err(log_err, "%s\n", e.what());
+    }
+    return false;
+}
+
+size_t mercury_packet_processor_write_json_batch(mercury_packet_processor processor,
+                                                 void *arena,
+                                                 size_t arena_size,
+                                                 size_t max_record_size,
+                                                 uint8_t **packets,
+                                                 const size_t *lengths,
+                                                 struct timespec *ts,
+                                                 const uint16_t *linktypes,
+                                                 size_t num_packets,
+                                                 size_t *offsets,
+                                                 size_t *record_lengths)
+{
+    if (processor == NULL || arena == NULL || packets == NULL || lengths == NULL || ts == NULL || offsets == NULL || record_lengths == NULL) {
+        return 0;
+    }
+    try {
+        return processor->write_json_batch(arena, arena_size, max_record_size,
+                                           packets, lengths, ts, linktypes, num_packets,
+                                           offsets, record_lengths);
+    }
+    catch (std::exception &e) {
+        printf_err(log_err, "%s\n", e.what());
+    }
+    return 0;
+}
+
+uint64_t mercury_get_resource_reload_count(mercury_context mc) {
+    if (mc == NULL) {
+        return 0;
+    }
+    return mc->classifier_epoch.load();
+}
+
+bool mercury_write_perf_counters(mercury_context mc, const char *perf_counters_file_path) {
+
+    if (mc == NULL || perf_counters_file_path == NULL || !perf_counters::compiled_in || mc->global_vars.perf_counters == false) {
+        return false;
+    }
+    try {
+        perf_counters_snapshot counts = mc->perf.get_snapshot();
+
+        std::vector<char> output(65536);
+        struct buffer_stream buf{output.data(), (int)output.size()};
+        struct json_object record{&buf};
+        counts.write_json(record, protocol_type_name, std::variant_size_v<protocol>);
+        record.close();
+        if (buf.trunc) {
+            printf_err(log_err, "perf counters truncated\n");
+            return false;
+        }
+        buf.strncpy("\n");
+
+        FILE *perf_counters_file = fopen(perf_counters_file_path, "w");
+        if (perf_counters_file == nullptr) {
+            printf_err(log_err, "could not open file '%s' for writing perf counters\n", perf_counters_file_path);
+            return false;
+        }
+        fwrite(output.data(), 1, buf.length(), perf_counters_file);
+        fclose(perf_counters_file);
+        return true;
+    }
+    catch (std::exception &e) {
+        printf_err(log_err, "%s\n", e.what());
+    }
+    return false;
+}
+
+size_t mercury_packet_processor_write_suppressed_json(mercury_packet_processor processor, void *buffer, size_t buffer_size, const struct timespec *ts) {
+    if (processor == NULL || buffer == NULL) {
+        return 0;
+    }
+    try {
+        return processor->write_suppressed_json(buffer, buffer_size, ts);
+    }
+    catch (std::exception &e) {
+        printf_err(log_err, "%s\n", e.what());
+    }
+    return 0;
+}
+
+bool mercury_packet_processor_set_verbosity(mercury_packet_processor processor, enum record_verbosity verbosity) {
+    if (processor == NULL) {
+        return false;
+    }
+    switch (verbosity) {
+    case record_verbosity_full:
+    case record_verbosity_reduced:
+    case record_verbosity_summary:
+        processor->verbosity = verbosity;
+        return true;
+    default:
+        ;
+    }
+    return false;
+}
+
+size_t mercury_get_metrics(mercury_context mc, char *buffer, size_t buffer_size) {
+
+    if (mc == NULL || buffer == NULL) {
+        return 0;
+    }
+    try {
+        struct buffer_stream buf{buffer, (int)std::min(buffer_size, (size_t)INT_MAX)};
+        processor_counters_snapshot counts = mc->counters.get_snapshot();
+        counts.write_prometheus(buf, protocol_type_name, std::variant_size_v<protocol>);
+
+        buf.puts("# HELP libmerc_resource_reloads_total Number of completed resource reloads.\n"
+                 "# TYPE libmerc_resource_reloads_total counter\n");
+        buf.snprintf("libmerc_resource_reloads_total %" PRIu64 "\n", mc->classifier_epoch.load());
+
+        if (mc->aggregator != nullptr) {
+            buf.puts("# HELP libmerc_stats_entries Number of entries in the stats aggregator.\n"
+                     "# TYPE libmerc_stats_entries gauge\n");
+            buf.snprintf("libmerc_stats_entries %zu\n", mc->aggregator->get_num_entries());
+            buf.puts("# HELP libmerc_stats_queue_drops_total Number of stats events dropped because an event queue was full.\n"
+                     "# TYPE libmerc_stats_queue_drops_total counter\n");
+            buf.snprintf("libmerc_stats_queue_drops_total %" PRIu64 "\n", mc->aggregator->get_queue_drops());
+        }
+        if (buf.trunc) {
+            return 0;
+        }
+        return buf.length();
+    }
+    catch (std::exception &e) {
+        printf_err(log_err, "%s\n", e.what());
+    }
+    return 0;
+}
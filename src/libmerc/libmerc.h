@@ -774,4 +774,227 @@ extern "C" LIBMERC_DLL_EXPORTED
 #endif
 const struct attribute_context *mercury_packet_processor_get_attributes(mercury_packet_processor processor);
 
+//
+// start of libmerc version 7 API
+//
+
+/**
+ * mercury_reload_resources() starts loading a resource archive in a
+ * background thread, and returns immediately.  Once the archive has
+ * been loaded, the new classifier replaces the current one; each
+ * packet processor switches over to it before processing its next
+ * packet, and the old classifier is freed after every packet
+ * processor has either switched over or become idle (that is, is not
+ * processing a packet), and a grace period of one second has
+ * elapsed.  The analysis results of the last packet processed with
+ * the old classifier remain valid during that grace period.  A reload
+ * is never held up by a packet processor that is not being used.
+ * Packet processing continues while
+ * the archive is loaded, and flow, reassembly, and stats state is
+ * retained.  If the archive cannot be loaded, or its fingerprint
+ * formats do not match those of the current resources, then an
+ * error is reported and the current resources remain in use.
+ *
+ * @param mc (input) is the mercury context whose resources will be
+ * reloaded.
+ *
+ * @param resource_file (input) is the path of the resource archive
+ * to be loaded, or NULL to reload the archive with which mc was
+ * initialized.
+ *
+ * @return true if the reload was started, and false if libmerc is
+ * not configured for analysis, or if a reload is already in progress.
+ *
+ * @warning a pointer returned by mercury_get_resource_version() is
+ * not valid after a reload has completed.
+ */
+#ifdef __cplusplus
+extern "C" LIBMERC_DLL_EXPORTED
+#endif
+bool mercury_reload_resources(mercury_context mc, const char *resource_file);
+
+/**
+ * mercury_get_resource_reload_count() returns the number of times
+ * that the resources of a mercury context have been replaced by
+ * mercury_reload_resources().  A change in that number indicates that
+ * mercury_get_resource_version() may return a different value.
+ *
+ * @param mc (input) is the mercury context.
+ *
+ * @return the number of completed resource reloads, or 0 if mc is NULL.
+ */
+#ifdef __cplusplus
+extern "C" LIBMERC_DLL_EXPORTED
+#endif
+uint64_t mercury_get_resource_reload_count(mercury_context mc);
+
+/**
+ * mercury_packet_processor_write_json_batch() processes a batch of
+ * packets, and writes the JSON record for each packet (if there is
+ * one) into an output arena.  It is equivalent to invoking
+ * mercury_packet_processor_write_json_linktype() on each packet in
+ * turn, with a buffer of max_record_size bytes, but it prefetches
+ * the headers and initial payload of each packet a few packets ahead
+ * of processing it, which reduces cache stalls for bursts of packets
+ * whose data is not in cache, such as those in a capture ring.
+ *
+ * Processing stops before a packet if fewer than max_record_size
+ * bytes of the arena remain, so the caller should invoke this
+ * function again, with the remaining packets, if the return value is
+ * less than num_packets.
+ *
+ * @param processor (input) is a packet processor context to be used
+ * @param arena (output) is the buffer into which records are written
+ * @param arena_size (input) is the length of the arena in bytes
+ * @param max_record_size (input) is the maximum length of a record
+ * @param packets (input) is an array of num_packets packet pointers
+ * @param lengths (input) is an array of num_packets packet lengths
+ * @param ts (input) is an array of num_packets timestamps
+ * @param linktypes (input) is an array of num_packets linktypes, or
+ * NULL if all of the packets are ethernet frames
+ * @param num_packets (input) is the number of packets in the batch
+ * @param offsets (output) is an array into which the offset of the
+ * record for each processed packet is written
+ * @param record_lengths (output) is an array into which the length of
+ * the record for each processed packet is written; a length of zero
+ * indicates that no record was written for that packet
+ *
+ * @return the number of packets processed.
+ */
+#ifdef __cplusplus
+extern "C" LIBMERC_DLL_EXPORTED
+#endif
+size_t mercury_packet_processor_write_json_batch(mercury_packet_processor processor,
+                                                 void *arena,
+                                                 size_t arena_size,
+                                                 size_t max_record_size,
+                                                 uint8_t **packets,
+                                                 const size_t *lengths,
+                                                 struct timespec *ts,
+                                                 const uint16_t *linktypes,
+                                                 size_t num_packets,
+                                                 size_t *offsets,
+                                                 size_t *record_lengths);
+
+/**
+ * mercury_write_perf_counters() writes the per-stage and per-protocol
+ * cycle counts of all of the packet processors of a mercury context
+ * into a JSON file.  The counts are only available when libmerc has
+ * been compiled with LIBMERC_PERF_COUNTERS defined, and the
+ * "perf-counters" option has been set in the packet_filter_cfg
+ * string of the libmerc_config used to initialize the context.
+ *
+ * The counts include those of packet processors that have been
+ * destructed, and are cumulative; they are not reset when they are
+ * written.
+ *
+ * @param mc (input) is the mercury context.
+ *
+ * @param perf_counters_file_path (input) is the path of the file to
+ * be written.
+ *
+ * @return true if the file was written, and false otherwise.
+ */
+#ifdef __cplusplus
+extern "C" LIBMERC_DLL_EXPORTED
+#endif
+bool mercury_write_perf_counters(mercury_context mc, const char *perf_counters_file_path);
+
+/**
+ * mercury_get_metrics() writes the operational metrics of a mercury
+ * context into a buffer, in the Prometheus text exposition format.
+ * The metrics include the number of records written for each
+ * protocol, the number of analysis results with each fingerprint
+ * status, the number of flows in the reassembly tables, and the
+ * number of stats entries and stats event drops.
+ *
+ * The metrics are gathered from counters that are updated by each
+ * packet processor without locking, so this function can be called
+ * at any time from any thread.
+ *
+ * @param mc (input) is the mercury context.
+ *
+ * @param buffer (output) is the buffer into which the metrics are
+ * written.
+ *
+ * @param buffer_size (input) is the length of buffer in bytes.
+ *
+ * @return the number of bytes written into buffer, or 0 if mc or
+ * buffer is NULL, or if the metrics did not fit into the buffer.
+ */
+#ifdef __cplusplus
+extern "C" LIBMERC_DLL_EXPORTED
+#endif
+size_t mercury_get_metrics(mercury_context mc, char *buffer, size_t buffer_size);
+
+/**
+ * mercury_packet_processor_write_suppressed_json() writes the summary
+ * records of the repeated records that a packet processor has
+ * suppressed, when the "suppress-repeats" option has been set in the
+ * packet_filter_cfg string of the libmerc_config.  Summaries are
+ * normally written by mercury_packet_processor_write_json() and its
+ * variants, after the record for a packet, when the cache entry for a
+ * suppressed record expires or is evicted.  When no packets are
+ * arriving, this function should be called periodically with the
+ * current time, so that the summaries of entries that have expired
+ * are written without waiting for the next packet; it should also be
+ * called with a NULL time before the packet processor is destructed,
+ * which writes the summaries of all of the entries in the cache, so
+ * that no counts are lost.  Each summary is a line of JSON that holds
+ * the first suppressed record, with a "repeats" object.
+ *
+ * @param processor (input) is a packet processor context.
+ *
+ * @param buffer (output) is the buffer into which the summaries are
+ * written.
+ *
+ * @param buffer_size (input) is the length of buffer in bytes.
+ *
+ * @param ts (input) is the current time, or NULL to write the
+ * summaries of all of the entries in the cache.
+ *
+ * @return the number of bytes written into buffer; the caller should
+ * call this function again until it returns 0.
+ */
+#ifdef __cplusplus
+extern "C" LIBMERC_DLL_EXPORTED
+#endif
+size_t mercury_packet_processor_write_suppressed_json(mercury_packet_processor processor, void *buffer, size_t buffer_size, const struct timespec *ts);
+
+/**
+ * enum record_verbosity identifies the amount of information that a
+ * packet processor writes into each JSON record; the lower levels
+ * are used to shed load when records are produced faster than they
+ * can be written, so that each record is kept, in a shorter form,
+ * rather than dropped.
+ */
+enum record_verbosity {
+    record_verbosity_full    = 0,  /**< fingerprints, metadata, and analysis         */
+    record_verbosity_reduced = 1,  /**< fingerprints, flow key, and time             */
+    record_verbosity_summary = 2,  /**< protocol, fingerprint hash, flow key, and time */
+};
+
+/**
+ * mercury_packet_processor_set_verbosity() sets the amount of
+ * information that a packet processor writes into the JSON records
+ * for the packets that it processes from then on.  At the reduced
+ * level, each record holds only its fingerprints (if any), the flow
+ * key, and event_start, and a "verbosity" key with the value
+ * "reduced".  At the summary level, each record holds the protocol
+ * type, a 64-bit hash of its fingerprint (if any), the flow key, and
+ * event_start, and a "verbosity" key with the value "summary".  The
+ * verbosity of a packet processor is initially record_verbosity_full.
+ *
+ * @param processor (input) is a packet processor context.
+ *
+ * @param verbosity (input) is the verbosity level.
+ *
+ * @return true if the verbosity was set, and false if processor is
+ * NULL or verbosity is not a valid level.
+ */
+#ifdef __cplusplus
+extern "C" LIBMERC_DLL_EXPORTED
+#endif
+bool mercury_packet_processor_set_verbosity(mercury_packet_processor processor, enum record_verbosity verbosity);
+
 #endif /* LIBMERC_H */
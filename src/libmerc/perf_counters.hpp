@@ -0,0 +1,249 @@
+// perf_counters.hpp
+//
+// per-thread counters and cycle histograms for the stages of packet
+// processing
+//
+// The counters are only compiled in when LIBMERC_PERF_COUNTERS is
+// defined (e.g. 'make OPTFLAGS=-DLIBMERC_PERF_COUNTERS'); otherwise,
+// all of the member functions of perf_counters are empty, and the
+// compiler removes the instrumentation entirely.  When they are
+// compiled in, they are enabled at run time with the "perf-counters"
+// configuration option; when disabled, each instrumentation point
+// costs a single well-predicted branch.
+
+#ifndef PERF_COUNTERS_HPP
+#define PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <algorithm>
+#include "tsc_clock.hpp"
+#include "json_object.h"
+
+/// the stages of packet processing whose cycles are counted
+///
+enum perf_stage : uint8_t {
+    perf_stage_l2_l3_parse       = 0,
+    perf_stage_protocol_identify = 1,
+    perf_stage_reassembly        = 2,
+    perf_stage_fingerprint       = 3,
+    perf_stage_analysis          = 4,
+    perf_stage_json_write        = 5,
+    num_perf_stages              = 6
+};
+
+static constexpr const char *perf_stage_name[num_perf_stages] = {
+    "l2_l3_parse",
+    "protocol_identify",
+    "reassembly",
+    "fingerprint",
+    "analysis",
+    "json_write",
+};
+
+/// counts observations of cycle counts in buckets whose bounds are
+/// powers of two, along with their total.  Bucket `i` counts the
+/// values in the range [2^i, 2^(i+1)), except that bucket zero also
+/// counts zero, and the last bucket counts all larger values.
+///
+/// A histogram is updated by a single thread, and may be read by
+/// another thread at the same time, so its counters are atomic, but
+/// they are updated with relaxed loads and stores rather than
+/// read-modify-write operations.
+///
+class cycle_histogram {
+public:
+    static constexpr size_t num_buckets = 32;
+
+    /// a copy of the counts in one or more histograms
+    ///
+    struct snapshot {
+        uint64_t count = 0;
+        uint64_t total = 0;
+        std::array<uint64_t, num_buckets> buckets{};
+
+        void write_json(json_object &o, const char *name) const {
+            if (count == 0) {
+                return;
+            }
+            json_object h{o, name};
+            h.print_key_uint("count", count);
+            h.print_key_uint("total_cycles", total);
+            h.print_key_float("mean_cycles", (double)total / count);
+            size_t last = num_buckets;
+            while (last > 0 && buckets[last - 1] == 0) {
+                last--;
+            }
+            json_array a{h, "log2_histogram"};
+            for (size_t i = 0; i < last; i++) {
+                a.print_uint(buckets[i]);
+            }
+            a.close();
+            h.close();
+        }
+    };
+
+    void observe(uint64_t cycles) {
+        increment(count, 1);
+        increment(total, cycles);
+        size_t b = cycles ? 63 - __builtin_clzll(cycles) : 0;
+        increment(buckets[std::min(b, num_buckets - 1)], 1);
+    }
+
+    void add_to(snapshot &s) const {
+        s.count += count.load(std::memory_order_relaxed);
+        s.total += total.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < num_buckets; i++) {
+            s.buckets[i] += buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total{0};
+    std::array<std::atomic<uint64_t>, num_buckets> buckets{};
+
+    static void increment(std::atomic<uint64_t> &a, uint64_t x) {
+        a.store(a.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+    }
+};
+
+/// a copy of the counts in one or more \ref perf_counters objects,
+/// which can be written out as JSON
+///
+struct perf_counters_snapshot {
+    static constexpr size_t max_protocol_types = 64;
+
+    size_t num_processors = 0;
+    std::array<cycle_histogram::snapshot, num_perf_stages> stages{};
+    std::array<cycle_histogram::snapshot, max_protocol_types> protocols{};
+
+    /// writes the counts as a JSON object; \param protocol_names is
+    /// an array of \param num_protocol_types names, one for each
+    /// protocol type index
+    ///
+    void write_json(json_object &o, const char * const *protocol_names, size_t num_protocol_types) const {
+        o.print_key_uint("processors", num_processors);
+        o.print_key_uint("ticks_per_second", tsc_clock::get_ticks_per_sec());
+        json_object s{o, "stages"};
+        for (size_t i = 0; i < num_perf_stages; i++) {
+            stages[i].write_json(s, perf_stage_name[i]);
+        }
+        s.close();
+        json_object p{o, "protocols"};
+        for (size_t i = 0; i < std::min(num_protocol_types, max_protocol_types); i++) {
+            protocols[i].write_json(p, protocol_names[i]);
+        }
+        p.close();
+    }
+};
+
+/// per-thread counters and cycle histograms for packet processing.
+/// Each packet is processed inside a \ref perf_packet_scope; within
+/// that scope, lap() attributes the cycles elapsed since the previous
+/// lap to a stage, and set_protocol() identifies the type of the
+/// packet.  When the scope ends, the cycles of each stage, and the
+/// total cycles for the packet's protocol type, are observed in
+/// histograms.
+///
+class perf_counters {
+public:
+
+#ifdef LIBMERC_PERF_COUNTERS
+
+    static constexpr bool compiled_in = true;
+
+    void set_enabled(bool value) { enabled = value; }
+
+    bool begin_packet() {
+        if (enabled && packet_start == 0) {
+            packet_start = last = tsc_clock::read_timestamp_counter();
+            return true;
+        }
+        return false;
+    }
+
+    void lap(perf_stage s) {
+        if (enabled) {
+            uint64_t now = tsc_clock::read_timestamp_counter();
+            stage_cycles[s] += now - last;
+            last = now;
+        }
+    }
+
+    void set_protocol(size_t index) {
+        if (enabled) {
+            protocol_index = std::min(index, perf_counters_snapshot::max_protocol_types - 1);
+        }
+    }
+
+    void end_packet() {
+        uint64_t now = tsc_clock::read_timestamp_counter();
+        for (size_t i = 0; i < num_perf_stages; i++) {
+            if (stage_cycles[i]) {
+                stages[i].observe(stage_cycles[i]);
+                stage_cycles[i] = 0;
+            }
+        }
+        protocols[protocol_index].observe(now - packet_start);
+        packet_start = 0;
+        protocol_index = 0;
+    }
+
+    void add_to(perf_counters_snapshot &s) const {
+        for (size_t i = 0; i < num_perf_stages; i++) {
+            stages[i].add_to(s.stages[i]);
+        }
+        for (size_t i = 0; i < perf_counters_snapshot::max_protocol_types; i++) {
+            protocols[i].add_to(s.protocols[i]);
+        }
+    }
+
+private:
+    bool enabled = false;
+    uint64_t packet_start = 0;
+    uint64_t last = 0;
+    size_t protocol_index = 0;
+    std::array<uint64_t, num_perf_stages> stage_cycles{};
+    std::array<cycle_histogram, num_perf_stages> stages;
+    std::array<cycle_histogram, perf_counters_snapshot::max_protocol_types> protocols;
+
+#else
+
+    static constexpr bool compiled_in = false;
+
+    void set_enabled(bool) { }
+    bool begin_packet() { return false; }
+    void lap(perf_stage) { }
+    void set_protocol(size_t) { }
+    void end_packet() { }
+    void add_to(perf_counters_snapshot &) const { }
+
+#endif // LIBMERC_PERF_COUNTERS
+
+};
+
+/// begins the accounting for a packet in a \ref perf_counters
+/// object, and ends it when the scope is exited.  Scopes can be
+/// nested (e.g. for encapsulated packets), in which case only the
+/// outermost one has any effect.
+///
+class perf_packet_scope {
+    perf_counters &counters;
+    bool owner;
+
+public:
+    explicit perf_packet_scope(perf_counters &pc) : counters{pc}, owner{pc.begin_packet()} { }
+
+    ~perf_packet_scope() {
+        if (owner) {
+            counters.end_packet();
+        }
+    }
+
+    perf_packet_scope(const perf_packet_scope &) = delete;
+    perf_packet_scope &operator=(const perf_packet_scope &) = delete;
+};
+
+#endif // PERF_COUNTERS_HPP
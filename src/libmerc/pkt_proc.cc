@@ -233,14 +233,30 @@ struct do_observation {
 
 };
 
+// emplace_protocol<protocols, T>(x, args...) sets the protocol x to
+// a T constructed from args, if T is in the protocol set protocols,
+// and to std::monostate otherwise, in which case no parsing code is
+// generated for T
+//
+template <typename protocols, typename T, typename... Args>
+static inline void emplace_protocol(protocol &x, Args&&... args) {
+    if constexpr (protocols::template contains<T>) {
+        x.emplace<T>(std::forward<Args>(args)...);
+    } else {
+        x.emplace<std::monostate>();
+    }
+}
+
 // set_tcp_protocol() sets the protocol variant record to the data
 // structure resulting from the parsing of the TCP data field, which
 // will be one of the TCP protocols in that variant.  The default
 // value of std::monostate indicates that the protocol matcher did not
 // recognize, or could not parse, the packet.  The class
 // unknown_initial_packet represents the TCP data field of an
-// unrecognized packet that is the first data packet in a flow.
+// unrecognized packet that is the first data packet in a flow.  Types
+// that are not in the protocol set protocols are not parsed.
 //
+template <typename protocols>
 void stateful_pkt_proc::set_tcp_protocol(protocol &x,
                       struct datum &pkt,
                       bool is_new,
@@ -256,13 +272,13 @@ void stateful_pkt_proc::set_tcp_protocol(protocol &x,
 
     switch(msg_type) {
     case tcp_msg_type_http_request:
-        x.emplace<http_request>(pkt);
+        emplace_protocol<protocols, http_request>(x, pkt);
         break;
     case tcp_msg_type_http_response:
-        x.emplace<http_response>(pkt);
+        emplace_protocol<protocols, http_response>(x, pkt);
         break;
     case tcp_msg_type_tls_client_hello:
-        {
+        if constexpr (protocols::template contains<tls_client_hello>) {
             struct tls_record rec{pkt};
             struct tls_handshake handshake{rec.fragment};
             if (tcp_pkt && handshake.additional_bytes_needed) {
@@ -270,86 +286,86 @@ void stateful_pkt_proc::set_tcp_protocol(protocol &x,
                 //  set pkt type as tls CH, so that initial segments can be fingerprinted as best effort for reassembly failed cases
             }
             x.emplace<tls_client_hello>(handshake.body);
-            break;
         }
+        break;
     case tcp_msg_type_tls_server_hello:
-        x.emplace<tls_server_hello_and_certificate>(pkt, tcp_pkt);
+        emplace_protocol<protocols, tls_server_hello_and_certificate>(x, pkt, tcp_pkt);
         break;
     case tcp_msg_type_tls_certificate:
-        x.emplace<tls_certificate>(pkt, tcp_pkt);
+        emplace_protocol<protocols, tls_certificate>(x, pkt, tcp_pkt);
         break;
     case tcp_msg_type_ssh:
-        x.emplace<ssh_init_packet>(pkt);
+        emplace_protocol<protocols, ssh_init_packet>(x, pkt);
         break;
     case tcp_msg_type_ssh_kex:
-        {
+        if constexpr (protocols::template contains<ssh_kex_init>) {
             struct ssh_binary_packet ssh_pkt{pkt};
             if (tcp_pkt && ssh_pkt.additional_bytes_needed) {
                 tcp_pkt->reassembly_needed(ssh_pkt.additional_bytes_needed);
                 return;
             }
             x.emplace<ssh_kex_init>(ssh_pkt.payload);
-            break;
         }
+        break;
     case tcp_msg_type_smtp_client:
-        x.emplace<smtp_client>(pkt);
+        emplace_protocol<protocols, smtp_client>(x, pkt);
         break;
     case tcp_msg_type_smtp_server:
-        x.emplace<smtp_server>(pkt);
+        emplace_protocol<protocols, smtp_server>(x, pkt);
         break;
     case tcp_msg_type_dns:
-    {
-        /* Trim the 2 byte length field in case of
-         * dns over tcp.
-         */
-        uint16_t len = 0;
-        pkt.read_uint16(&len);
-        pkt.trim_to_length(len);
-        x.emplace<dns_packet>(pkt);
+        if constexpr (protocols::template contains<dns_packet>) {
+            /* Trim the 2 byte length field in case of
+             * dns over tcp.
+             */
+            uint16_t len = 0;
+            pkt.read_uint16(&len);
+            pkt.trim_to_length(len);
+            x.emplace<dns_packet>(pkt);
+        }
         break;
-    }
     case tcp_msg_type_smb1:
-        x.emplace<smb1_packet>(pkt);
+        emplace_protocol<protocols, smb1_packet>(x, pkt);
         break;
     case tcp_msg_type_smb2:
-        x.emplace<smb2_packet>(pkt);
+        emplace_protocol<protocols, smb2_packet>(x, pkt);
         break;
     case tcp_msg_type_iec:
-        x.emplace<iec60870_5_104>(pkt);
+        emplace_protocol<protocols, iec60870_5_104>(x, pkt);
         break;
     case tcp_msg_type_dnp3:
-        x.emplace<dnp3>(pkt);
+        emplace_protocol<protocols, dnp3>(x, pkt);
         break;
     case tcp_msg_type_nbss:
-        x.emplace<nbss_packet>(pkt);
+        emplace_protocol<protocols, nbss_packet>(x, pkt);
         break;
     case tcp_msg_type_openvpn:
-        x.emplace<openvpn_tcp>(pkt);
+        emplace_protocol<protocols, openvpn_tcp>(x, pkt);
         break;
     case tcp_msg_type_bittorrent:
-        x.emplace<bittorrent_handshake>(pkt);
+        emplace_protocol<protocols, bittorrent_handshake>(x, pkt);
         break;
     case tcp_msg_type_mysql_server:
-        x.emplace<mysql_server_greet>(pkt);
+        emplace_protocol<protocols, mysql_server_greet>(x, pkt);
         break;
     case tcp_msg_type_tofsee_initial_message:
-        x.emplace<tofsee_initial_message>(pkt);
+        emplace_protocol<protocols, tofsee_initial_message>(x, pkt);
         break;
     case tcp_msg_type_socks4:
-        x.emplace<socks4_req>(pkt);
+        emplace_protocol<protocols, socks4_req>(x, pkt);
         break;
     case tcp_msg_type_socks5_hello:
-        x.emplace<socks5_hello>(pkt);
+        emplace_protocol<protocols, socks5_hello>(x, pkt);
         break;
     case tcp_msg_type_socks5_req_resp:
-        x.emplace<socks5_req_resp>(pkt);
+        emplace_protocol<protocols, socks5_req_resp>(x, pkt);
         break;
     case tcp_msg_type_ldap:
-        x.emplace<ldap::message>(pkt);
+        emplace_protocol<protocols, ldap::message>(x, pkt);
         break;
     default:
         if (is_new && global_vars.output_tcp_initial_data) {
-            x.emplace<unknown_initial_packet>(pkt);
+            emplace_protocol<protocols, unknown_initial_packet>(x, pkt);
         } else {
             x.emplace<std::monostate>();
         }
@@ -363,8 +379,10 @@ void stateful_pkt_proc::set_tcp_protocol(protocol &x,
 // of std::monostate indicates that the protocol matcher did not
 // recognize, or could not parse, the packet.  The class
 // unknown_udp_initial_packet represents the UDP data field of an
-// unrecognized packet that is the first data packet in a flow.
+// unrecognized packet that is the first data packet in a flow.  Types
+// that are not in the protocol set protocols are not parsed.
 //
+template <typename protocols>
 void stateful_pkt_proc::set_udp_protocol(protocol &x,
                       struct datum &pkt,
                       udp::ports ports,
@@ -402,8 +420,8 @@ void stateful_pkt_proc::set_udp_protocol(protocol &x,
             if (!selector.mdns()) {
                 return;
             }
-            x.emplace<mdns_packet>(pkt);
-        } else {
+            emplace_protocol<protocols, mdns_packet>(x, pkt);
+        } else if constexpr (protocols::template contains<dns_packet>) {
             dns_packet packet{pkt};
             if ((packet.netbios() and !selector.nbns()) or
                 (!packet.netbios() and !selector.dns())) {
@@ -413,17 +431,19 @@ void stateful_pkt_proc::set_udp_protocol(protocol &x,
         }
         break;
     case udp_msg_type_dhcp:
-        x.emplace<dhcp_discover>(pkt);
+        emplace_protocol<protocols, dhcp_discover>(x, pkt);
         break;
     case udp_msg_type_quic:
-        x.emplace<quic_init>(pkt, quic_crypto);
-        more_bytes = std::get<quic_init>(x).additional_bytes_needed();
-        if (more_bytes) {
-            udp_pkt.reassembly_needed(more_bytes);
+        if constexpr (protocols::template contains<quic_init>) {
+            x.emplace<quic_init>(pkt, quic_crypto);
+            more_bytes = std::get<quic_init>(x).additional_bytes_needed();
+            if (more_bytes) {
+                udp_pkt.reassembly_needed(more_bytes);
+            }
         }
         break;
     case udp_msg_type_dtls_client_hello:
-        {
+        if constexpr (protocols::template contains<dtls_client_hello>) {
             struct dtls_record dtls_rec{pkt};
             struct dtls_handshake handshake{dtls_rec.fragment};
             if (handshake.msg_type == handshake_type::client_hello) {
@@ -432,7 +452,7 @@ void stateful_pkt_proc::set_udp_protocol(protocol &x,
         }
         break;
     case udp_msg_type_dtls_server_hello:
-        {
+        if constexpr (protocols::template contains<dtls_server_hello>) {
             struct dtls_record dtls_rec{pkt};
             struct dtls_handshake handshake{dtls_rec.fragment};
             if (handshake.msg_type == handshake_type::server_hello) {
@@ -441,29 +461,29 @@ void stateful_pkt_proc::set_udp_protocol(protocol &x,
         }
         break;
     case udp_msg_type_wireguard:
-        x.emplace<wireguard_handshake_init>(pkt);
+        emplace_protocol<protocols, wireguard_handshake_init>(x, pkt);
         break;
     case udp_msg_type_esp:
-        x.emplace<esp>(pkt);
+        emplace_protocol<protocols, esp>(x, pkt);
         break;
     case udp_msg_type_ssdp:
-        x.emplace<ssdp>(pkt);
+        emplace_protocol<protocols, ssdp>(x, pkt);
         break;
     case udp_msg_type_stun:
-        x.emplace<stun::message>(pkt);
+        emplace_protocol<protocols, stun::message>(x, pkt);
         break;
     case udp_msg_type_nbds:
-        x.emplace<nbds_packet>(pkt);
+        emplace_protocol<protocols, nbds_packet>(x, pkt);
         break;
     case udp_msg_type_dht:
-        x.emplace<bittorrent_dht>(pkt);
+        emplace_protocol<protocols, bittorrent_dht>(x, pkt);
         break;
     case udp_msg_type_lsd:
-        x.emplace<bittorrent_lsd>(pkt);
+        emplace_protocol<protocols, bittorrent_lsd>(x, pkt);
         break;
     default:
         if (is_new) {
-            x.emplace<unknown_udp_initial_packet>(pkt);
+            emplace_protocol<protocols, unknown_udp_initial_packet>(x, pkt);
         } else {
             x.emplace<std::monostate>();
         }
@@ -472,6 +492,7 @@ void stateful_pkt_proc::set_udp_protocol(protocol &x,
 }
 
 // returns boolean whether to fingerprrint/analyze current tcp pkt
+template <typename protocols>
 bool stateful_pkt_proc::process_tcp_data (protocol &x,
                           struct datum &pkt,
                           struct tcp_packet &tcp_pkt,
@@ -485,7 +506,7 @@ bool stateful_pkt_proc::process_tcp_data (protocol &x,
         if (global_vars.output_tcp_initial_data) {
             is_new = tcp_flow_table.is_first_data_packet(k, ts->tv_sec, ntoh(tcp_pkt.header->seq));
         }
-        set_tcp_protocol(x, pkt, is_new, &tcp_pkt);
+        set_tcp_protocol<protocols>(x, pkt, is_new, &tcp_pkt);
         return true;
     }
 
@@ -504,7 +525,7 @@ bool stateful_pkt_proc::process_tcp_data (protocol &x,
     // treat any tcp pkt that needs reassembly as initial pkt
 
     // check if more tcp data is required
-    set_tcp_protocol(x,pkt,is_new,&tcp_pkt);
+    set_tcp_protocol<protocols>(x,pkt,is_new,&tcp_pkt);
         if (!tcp_pkt.additional_bytes_needed && !(std::holds_alternative<std::monostate>(x))) {
         // no need for reassembly
         // complete initial msg
@@ -522,6 +543,7 @@ bool stateful_pkt_proc::process_tcp_data (protocol &x,
     // check if in reassembly table to continue
     // init otherwise
     //
+    perf.lap(perf_stage_protocol_identify);
     reassembly_state r_state = reassembler->check_flow(k,ts->tv_sec);
 
     if ((r_state == reassembly_state::reassembly_none) && tcp_pkt.additional_bytes_needed){
@@ -547,12 +569,13 @@ bool stateful_pkt_proc::process_tcp_data (protocol &x,
 
     // after processing this pkt, check for states again
     reassembly_map_iterator it = reassembler->get_current_flow();
+    perf.lap(perf_stage_reassembly);
     if (reassembler->is_ready(it)) {
         // reassmbly done
         // process reassembled data
         //
         struct datum reassembled_data = reassembler->get_reassembled_data(it);
-        set_tcp_protocol(x, reassembled_data, true, &tcp_pkt);
+        set_tcp_protocol<protocols>(x, reassembled_data, true, &tcp_pkt);
 
         // mark flow as completed
         reassembler->set_completed(it);
@@ -563,6 +586,7 @@ bool stateful_pkt_proc::process_tcp_data (protocol &x,
 }
 
 // returns boolean whether to fingerprrint/analyze current udp pkt
+template <typename protocols>
 bool stateful_pkt_proc::process_udp_data (protocol &x,
                           struct datum &pkt,
                           udp &udp_pkt,
@@ -572,7 +596,8 @@ bool stateful_pkt_proc::process_udp_data (protocol &x,
 
     // no reassembly for ESP or IKE
     //
-    if (std::holds_alternative<esp>(x) or std::holds_alternative<ike::packet>(x)) {
+    if ((protocols::template contains<esp> and std::holds_alternative<esp>(x))
+        or (protocols::template contains<ike::packet> and std::holds_alternative<ike::packet>(x))) {
         return true;
     }
 
@@ -582,7 +607,7 @@ bool stateful_pkt_proc::process_udp_data (protocol &x,
         if (global_vars.output_udp_initial_data && pkt.is_not_empty()) {
             is_new = ip_flow_table.flow_is_new(k, ts->tv_sec);
         }
-        set_udp_protocol(x, pkt, udp_pkt.get_ports(), is_new, k, udp_pkt);
+        set_udp_protocol<protocols>(x, pkt, udp_pkt.get_ports(), is_new, k, udp_pkt);
         return true;
     }
 
@@ -597,9 +622,9 @@ bool stateful_pkt_proc::process_udp_data (protocol &x,
     // A QUIC pkt/ UDP pkt can be checked if it is involved in reassembly if either the CH initial part is seen with additional bytes needed,
     // or a QUIC pkt with crypto frames and the flow exists in reassembly table
 
-    set_udp_protocol(x, pkt, udp_pkt.get_ports(), is_new, k, udp_pkt);
+    set_udp_protocol<protocols>(x, pkt, udp_pkt.get_ports(), is_new, k, udp_pkt);
     //if ( (!udp_pkt.additional_bytes_needed() && (std::holds_alternative<quic_init>(x)))  || (!(std::holds_alternative<quic_init>(x))) ) {
-    if (!(std::holds_alternative<quic_init>(x))) {
+    if (!protocols::template contains<quic_init> or !(std::holds_alternative<quic_init>(x))) {
         // no need for reassembly
         return true;
     }
@@ -631,6 +656,7 @@ bool stateful_pkt_proc::process_udp_data (protocol &x,
         return true;
     }
 
+    perf.lap(perf_stage_protocol_identify);
     reassembly_state r_state = reassembler->check_flow(k,ts->tv_sec, cid);
 
     if ((r_state == reassembly_state::reassembly_none) && !udp_pkt.additional_bytes_needed()) {
@@ -664,12 +690,13 @@ bool stateful_pkt_proc::process_udp_data (protocol &x,
 
     // after processing this pkt, check for states again
     reassembly_map_iterator it = reassembler->get_current_flow();
+    perf.lap(perf_stage_reassembly);
     if (reassembler->is_ready(it)) {
         // reassmbly done
         // process reassembled data
         //
         struct datum reassembled_data = reassembler->get_reassembled_data(it);
-        //set_tcp_protocol(x, reassembled_data, true, &tcp_pkt);
+        //set_tcp_protocol<protocols>(x, reassembled_data, true, &tcp_pkt);
         // update quic crpto buffer and reparse client hello
         std::get<quic_init>(x).reparse_crypto_buf(reassembled_data);
 
@@ -681,16 +708,28 @@ bool stateful_pkt_proc::process_udp_data (protocol &x,
     return false;
 }
 
-size_t stateful_pkt_proc::ip_write_json(void *buffer,
-                                        size_t buffer_size,
-                                        const uint8_t *ip_packet,
-                                        size_t length,
-                                        struct timespec *ts,
-                                        struct tcp_reassembler *reassembler) {
+template <typename protocols>
+size_t stateful_pkt_proc::ip_write_json_selected(void *buffer,
+                                                 size_t buffer_size,
+                                                 const uint8_t *ip_packet,
+                                                 size_t length,
+                                                 struct timespec *ts,
+                                                 struct tcp_reassembler *reassembler) {
+
+    packet_scope classifier_scope{*this};   // safe point: no references into the classifier are held
+    perf_packet_scope perf_scope{perf};
+
+    if (ts->tv_sec == 0) {
+        tsc_clock time_now;
+        ts->tv_sec = time_now.time_in_seconds();
+    }
 
     struct buffer_stream buf{(char *)buffer, buffer_size};
     struct key k;
     struct datum pkt{ip_packet, ip_packet+length};
+    if (!defragment(pkt, ts->tv_sec)) {
+        return 0;  // fragment held for reassembly, or dropped
+    }
     ip ip_pkt{pkt, k};
     uint8_t transport_proto = ip_pkt.transport_protocol();
     bool truncated_tcp = false;
@@ -713,26 +752,22 @@ size_t stateful_pkt_proc::ip_write_json(void *buffer,
             ;
         }
     }
-
-    if (ts->tv_sec == 0) {
-        tsc_clock time_now;
-        ts->tv_sec = time_now.time_in_seconds();
-    }
+    perf.lap(perf_stage_l2_l3_parse);
 
     // process transport/application protocols
     //
     protocol x;
-    if (selector.icmp() && (transport_proto == ip::protocol::icmp || transport_proto == ip::protocol::ipv6_icmp)) {
-        x.emplace<icmp_packet>(pkt);
+    if (protocols::template contains<icmp_packet> && selector.icmp() && (transport_proto == ip::protocol::icmp || transport_proto == ip::protocol::ipv6_icmp)) {
+        emplace_protocol<protocols, icmp_packet>(x, pkt);
 
-    } else if (selector.ospf() && transport_proto == ip::protocol::ospfigp) {
-        x.emplace<ospf>(pkt);
+    } else if (protocols::template contains<ospf> && selector.ospf() && transport_proto == ip::protocol::ospfigp) {
+        emplace_protocol<protocols, ospf>(x, pkt);
 
-    } else if (selector.ipsec() && transport_proto == ip::protocol::esp) {
-        x.emplace<esp>(pkt);
+    } else if (protocols::template contains<esp> && selector.ipsec() && transport_proto == ip::protocol::esp) {
+        emplace_protocol<protocols, esp>(x, pkt);
 
-    } else if (selector.sctp() && transport_proto == ip::protocol::sctp) {
-        x.emplace<sctp_init>(pkt);
+    } else if (protocols::template contains<sctp_init> && selector.sctp() && transport_proto == ip::protocol::sctp) {
+        emplace_protocol<protocols, sctp_init>(x, pkt);
 
     } else if (transport_proto == ip::protocol::tcp) {
         tcp_packet tcp_pkt{pkt, &ip_pkt};
@@ -745,8 +780,8 @@ size_t stateful_pkt_proc::ip_write_json(void *buffer,
             if (global_vars.output_tcp_initial_data) {
                 tcp_flow_table.syn_packet(k, ts->tv_sec, ntoh(tcp_pkt.header->seq));
             }
-            if (selector.tcp_syn()) {
-                x = tcp_pkt; // process tcp syn
+            if (protocols::template contains<tcp_packet> && selector.tcp_syn()) {
+                emplace_protocol<protocols, tcp_packet>(x, tcp_pkt); // process tcp syn
             }
             // note: we could check for non-empty data field
 
@@ -754,8 +789,8 @@ size_t stateful_pkt_proc::ip_write_json(void *buffer,
             if (global_vars.output_tcp_initial_data) {
                 tcp_flow_table.syn_packet(k, ts->tv_sec, ntoh(tcp_pkt.header->seq));
             }
-            if (selector.tcp_syn() and selector.tcp_syn_ack()) {
-                x = tcp_pkt;  // process tcp syn/ack
+            if (protocols::template contains<tcp_packet> and selector.tcp_syn() and selector.tcp_syn_ack()) {
+                emplace_protocol<protocols, tcp_packet>(x, tcp_pkt);  // process tcp syn/ack
             }
             // note: we could check for non-empty data field
 
@@ -764,7 +799,7 @@ size_t stateful_pkt_proc::ip_write_json(void *buffer,
         }
         else {
             //bool write_pkt = false;
-            if (!process_tcp_data(x, pkt, tcp_pkt, k, ts, reassembler)) {
+            if (!process_tcp_data<protocols>(x, pkt, tcp_pkt, k, ts, reassembler)) {
                 return 0;
             }
             else if (tcp_pkt.additional_bytes_needed) {
@@ -808,31 +843,34 @@ size_t stateful_pkt_proc::ip_write_json(void *buffer,
             default:
                 break;
             }
-        } else if (selector.ipsec() and ports.either_matches(ike::default_port)) {
-                x.emplace<ike::packet>(pkt);
-        } else if (selector.ipsec() and ports.either_matches_any(esp::default_port)) {   // esp or ike over udp
+        } else if (protocols::template contains<ike::packet> and selector.ipsec() and ports.either_matches(ike::default_port)) {
+                emplace_protocol<protocols, ike::packet>(x, pkt);
+        } else if (protocols::template contains<esp> and selector.ipsec() and ports.either_matches_any(esp::default_port)) {   // esp or ike over udp
             if (lookahead<ike::non_esp_marker> non_esp{pkt}) {
-                x.emplace<ike::packet>(pkt);
+                emplace_protocol<protocols, ike::packet>(x, pkt);
             } else {
-                x.emplace<esp>(pkt);
+                emplace_protocol<protocols, esp>(x, pkt);
             }
         }
 
-        if (!process_udp_data(x, pkt, udp_pkt, k, ts, reassembler)) {
+        if (!process_udp_data<protocols>(x, pkt, udp_pkt, k, ts, reassembler)) {
             return 0;
         }
         else if (udp_pkt.additional_bytes_needed()) {
             truncated_quic = true;
         }
     }
+    perf.lap(perf_stage_protocol_identify);
+    perf.set_protocol(x.index());
 
     // process transport/application protocol
     //
-    if (std::visit(is_not_empty{}, x)) {
-        std::visit(compute_fingerprint{analysis.fp, global_vars.fp_format}, x);
+    if (protocols::visit(is_not_empty{}, x)) {
+        protocols::visit(compute_fingerprint{analysis.fp, global_vars.fp_format}, x);
+        perf.lap(perf_stage_fingerprint);
         bool output_analysis = false;
         if (global_vars.do_analysis && analysis.fp.get_type() != fingerprint_type_unknown) {
-            output_analysis = std::visit(do_analysis{k, analysis, c}, x);
+            output_analysis = protocols::visit(do_analysis{k, analysis, c}, x);
 
             // note: we only perform observations when analysis is
             // configured, because we rely on do_analysis to set the
@@ -840,52 +878,95 @@ size_t stateful_pkt_proc::ip_write_json(void *buffer,
             // analysis_.destination
             //
             if (mq) {
-                std::visit(do_observation{k, analysis, mq}, x);
+                protocols::visit(do_observation{k, analysis, mq}, x);
+            }
+            if (output_analysis) {
+                if (nearest_cache) {
+                    c->set_nearest_fingerprint(analysis.fp, analysis.result, *nearest_cache, ts->tv_sec);
+                }
+                counters.analysis_result(analysis.result.status);
             }
         }
+        perf.lap(perf_stage_analysis);
 
         // if (malware_prob_threshold > -1.0 && (!output_analysis || analysis.result.malware_prob < malware_prob_threshold)) { return 0; } // TODO - expose hidden command
 
         struct json_object record{&buf};
-        if (analysis.fp.get_type() != fingerprint_type_unknown) {
-            analysis.fp.write(record);
-        }
-        std::visit(write_metadata{record, global_vars.metadata_output, global_vars.certs_json_output, global_vars.dns_json_output}, x);
+        if (verbosity != record_verbosity_full) {
+            write_reduced_json(record, x.index(), k, ts);   // shedding load
+            counters.record(x.index());
+        } else {
+            if (analysis.fp.get_type() != fingerprint_type_unknown) {
+                analysis.fp.write(record);
+            }
+            protocols::visit(write_metadata{record, global_vars.metadata_output, global_vars.certs_json_output, global_vars.dns_json_output}, x);
 
-        if (output_analysis) {
-            analysis.result.write_json(record, "analysis");
-        }
-        if (crypto_policy) { std::visit(do_crypto_assessment{crypto_policy, record}, x); }
+            if (output_analysis) {
+                analysis.result.write_json(record, "analysis");
+            }
+            if (crypto_policy) { protocols::visit(do_crypto_assessment{crypto_policy, record}, x); }
 
-        // write indication of truncation or reassembly
-        //
-        if ((!reassembler && (truncated_tcp || truncated_quic))
-                || (!global_vars.reassembly && (truncated_tcp || truncated_quic)) ) {
-            struct json_object flags{record, "reassembly_properties"};
-            flags.print_key_bool("truncated", true);
-            flags.close();
-        }
-        else if (reassembler && reassembler->is_done(reassembler->curr_flow)) {
-            reassembler->write_json(record);
-        }
+            // write indication of truncation or reassembly
+            //
+            if ((!reassembler && (truncated_tcp || truncated_quic))
+                    || (!global_vars.reassembly && (truncated_tcp || truncated_quic)) ) {
+                struct json_object flags{record, "reassembly_properties"};
+                flags.print_key_bool("truncated", true);
+                flags.close();
+            }
+            else if (reassembler && reassembler->is_done(reassembler->curr_flow)) {
+                reassembler->write_json(record);
+            }
 
-        if (global_vars.metadata_output) {
-            ip_pkt.write_json(record);      // write out ip{version,ttl,id}
-        }
+            size_t content_end = buf.length();  // record content compared by the suppressor
 
-        write_flow_key(record, k);
-        record.print_key_timestamp("event_start", ts);
-        record.close();
+            if (global_vars.metadata_output) {
+                ip_pkt.write_json(record);      // write out ip{version,ttl,id}
+            }
+
+            write_flow_key(record, k);
+            record.print_key_timestamp("event_start", ts);
+            record.close();
+            counters.record(x.index());
+
+            if (suppressor && buf.trunc == 0) {
+                const char *fp_str = analysis.fp.get_type() != fingerprint_type_unknown ? analysis.fp.string() : "";
+                datum sn = protocols::visit(get_server_name{}, x);
+                if (suppressor->observe(k,
+                                        x.index(),
+                                        fp_str,
+                                        std::string_view{(const char *)sn.data, (size_t)sn.length()},
+                                        std::string_view{buf.dstr + 1, content_end - 1},
+                                        *ts)) {
+                    buf.doff = 0;               // repeat of an earlier record
+                }
+            }
+        }
+        perf.lap(perf_stage_json_write);
     }
 
     // reassembly clean and reset
     //
     if (reassembler) {
         reassembler->clean_curr_flow();
+        counters.set_reassembly_flows(reassembler->table.size());
     }
 
-    // if buffer has JSON data, add newline and return buffer length
+    // if buffer has JSON data, add newline and return buffer length,
+    // after appending the summaries of any suppressed records that
+    // are due
     //
+    if (suppressor) {
+        if (buf.trunc != 0) {
+            return 0;
+        }
+        if (buf.length() != 0) {
+            buf.strncpy("\n");
+        }
+        suppressor->write_summaries(buf);
+        counters.set_suppression(suppressor->get_counts());
+        return buf.length();
+    }
     if (buf.length() != 0 && buf.trunc == 0) {
         buf.strncpy("\n");
         return buf.length();
@@ -893,6 +974,70 @@ size_t stateful_pkt_proc::ip_write_json(void *buffer,
     return 0;
 }
 
+// write_reduced_json() writes the content of a record at a verbosity
+// below record_verbosity_full: the fingerprint (reduced), or the
+// protocol type and the 64-bit FNV-1a hash of the fingerprint string
+// (summary), followed by the flow key and event time; the hash is
+// stable across platforms, so summaries from different sensors can
+// be joined on it
+//
+void stateful_pkt_proc::write_reduced_json(struct json_object &record, size_t protocol_index, const struct key &k, struct timespec *ts) {
+    bool has_fingerprint = analysis.fp.get_type() != fingerprint_type_unknown;
+    if (verbosity == record_verbosity_reduced) {
+        if (has_fingerprint) {
+            analysis.fp.write(record);
+        }
+        record.print_key_string("verbosity", "reduced");
+    } else {
+        record.print_key_string("type", protocol_type_name[protocol_index]);
+        if (has_fingerprint) {
+            uint64_t hash = 0xcbf29ce484222325;
+            for (const char *c = analysis.fp.string(); *c != '\0'; c++) {
+                hash = (hash ^ (uint8_t)*c) * 0x100000001b3;
+            }
+            record.print_key_uint64_hex("fingerprint_hash", hash);
+        }
+        record.print_key_string("verbosity", "summary");
+    }
+    write_flow_key(record, k);
+    record.print_key_timestamp("event_start", ts);
+    record.close();
+}
+
+size_t stateful_pkt_proc::write_suppressed_json(void *buffer, size_t buffer_size, const struct timespec *ts) {
+    if (suppressor == nullptr) {
+        return 0;
+    }
+    if (ts) {
+        suppressor->expire(*ts);
+    } else {
+        suppressor->retire_all();
+    }
+    struct buffer_stream buf{(char *)buffer, buffer_size};
+    suppressor->write_summaries(buf);
+    counters.set_suppression(suppressor->get_counts());
+    return buf.length();
+}
+
+// select_processor() chooses the ip_write_json() implementation, as
+// described in pkt_proc.h; the generic implementation handles all
+// protocols, and tls_http_quic_protocols handles the most common
+// deployment
+//
+const char *stateful_pkt_proc::select_processor(bool generic) {
+    if (!generic && tls_http_quic_protocols::covers(global_vars.protocols)) {
+        ip_write_json_fn = &stateful_pkt_proc::ip_write_json_selected<tls_http_quic_protocols>;
+        return tls_http_quic_protocols::name;
+    }
+    ip_write_json_fn = &stateful_pkt_proc::ip_write_json_selected<all_protocols>;
+    return "generic";
+}
+
+template size_t stateful_pkt_proc::ip_write_json_selected<all_protocols>(void *, size_t, const uint8_t *, size_t, struct timespec *, struct tcp_reassembler *);
+template size_t stateful_pkt_proc::ip_write_json_selected<tls_http_quic_protocols>(void *, size_t, const uint8_t *, size_t, struct timespec *, struct tcp_reassembler *);
+template void stateful_pkt_proc::set_tcp_protocol<all_protocols>(protocol &, struct datum &, bool, struct tcp_packet *);
+template void stateful_pkt_proc::set_udp_protocol<all_protocols>(protocol &, struct datum &, udp::ports, bool, const struct key &, udp &);
+
 using link_layer_protocol = std::variant<std::monostate, arp_packet, cdp, lldp>;
 
 size_t stateful_pkt_proc::write_json(void *buffer,
@@ -902,6 +1047,7 @@ size_t stateful_pkt_proc::write_json(void *buffer,
                                      struct timespec *ts,
                                      struct tcp_reassembler *reassembler) {
 
+    perf_packet_scope perf_scope{perf};
     struct datum pkt{packet, packet+length};
     eth ethernet_frame{pkt};
     uint16_t ethertype = ethernet_frame.get_ethertype();
@@ -934,6 +1080,7 @@ size_t stateful_pkt_proc::write_json(void *buffer,
     default:
         ;  // unsupported ethertype
     }
+    perf.lap(perf_stage_l2_l3_parse);
 
     // write out link layer protocol metadata, if there is any
     //
@@ -943,6 +1090,7 @@ size_t stateful_pkt_proc::write_json(void *buffer,
         std::visit(write_metadata{record, false, false, false}, x);
         record.print_key_timestamp("event_start", ts);
         record.close();
+        perf.lap(perf_stage_json_write);
         if (buf.length() != 0 && buf.trunc == 0) {
             buf.strncpy("\n");
             return buf.length();
@@ -960,6 +1108,7 @@ size_t stateful_pkt_proc::write_json(void *buffer,
                                      struct tcp_reassembler *reassembler,
                                      uint16_t linktype) {
 
+    perf_packet_scope perf_scope{perf};
     struct datum pkt{packet, packet+length};
 
     switch (linktype)
@@ -988,6 +1137,54 @@ size_t stateful_pkt_proc::write_json(void *buffer,
                          reassembler);
 }
 
+// write_json_batch() processes a batch of packets, and writes the
+// JSON record for each packet into the arena.  Each record is given
+// max_record_size bytes, and processing stops before a packet if
+// fewer than that many bytes of the arena remain; the number of
+// packets processed is returned.
+//
+size_t stateful_pkt_proc::write_json_batch(void *arena,
+                                           size_t arena_size,
+                                           size_t max_record_size,
+                                           uint8_t **packets,
+                                           const size_t *lengths,
+                                           struct timespec *ts,
+                                           const uint16_t *linktypes,
+                                           size_t num_packets,
+                                           size_t *offsets,
+                                           size_t *record_lengths) {
+
+    // arena_output writes consecutive records into the arena
+    //
+    struct arena_output {
+        uint8_t *arena;
+        size_t arena_size;
+        size_t max_record_size;
+        size_t *offsets;
+        size_t *record_lengths;
+        size_t used = 0;
+
+        uint8_t *begin_record(size_t, size_t *size) {
+            if (is_full()) {
+                return nullptr;
+            }
+            *size = max_record_size;
+            return arena + used;
+        }
+        bool is_full() const {
+            return max_record_size == 0 || arena_size - used < max_record_size;
+        }
+        void end_record(size_t i, size_t length) {
+            offsets[i] = used;
+            record_lengths[i] = length;
+            used += length;
+        }
+    };
+    arena_output out{(uint8_t *)arena, arena_size, max_record_size, offsets, record_lengths};
+
+    return write_json_batch(out, packets, lengths, ts, linktypes, num_packets);
+}
+
 // the function enumerate_protocol_types() prints out the types in
 // the protocol variant
 //
@@ -1005,8 +1202,18 @@ bool stateful_pkt_proc::analyze_ip_packet(const uint8_t *packet,
                                               struct timespec *ts,
                                           struct tcp_reassembler *reassembler) {
 
+    packet_scope classifier_scope{*this};   // safe point: no references into the classifier are held
+    perf_packet_scope perf_scope{perf};
+
+    if (ts->tv_sec == 0) {
+        tsc_clock time_now;
+        ts->tv_sec = time_now.time_in_seconds();
+    }
 
     struct datum pkt{packet, packet+length};
+    if (!defragment(pkt, ts->tv_sec)) {
+        return false;  // fragment held for reassembly, or dropped
+    }
     struct key k;
     ip ip_pkt{pkt, k};
     protocol x;
@@ -1016,11 +1223,7 @@ bool stateful_pkt_proc::analyze_ip_packet(const uint8_t *packet,
     }
     bool truncated_tcp = false;
     bool truncated_udp = false;
-
-    if (ts->tv_sec == 0) {
-        tsc_clock time_now;
-        ts->tv_sec = time_now.time_in_seconds();
-    }
+    perf.lap(perf_stage_l2_l3_parse);
 
     if (transport_proto == ip::protocol::tcp) {
         tcp_packet tcp_pkt{pkt, &ip_pkt};
@@ -1092,16 +1295,23 @@ bool stateful_pkt_proc::analyze_ip_packet(const uint8_t *packet,
         }
     }
 
+    perf.lap(perf_stage_protocol_identify);
+    perf.set_protocol(x.index());
+
     // process protocol data element
     //
     if (std::visit(is_not_empty{}, x)) {
         std::visit(compute_fingerprint{analysis.fp, global_vars.fp_format}, x);
+        perf.lap(perf_stage_fingerprint);
         if (global_vars.do_analysis && analysis.fp.get_type() != fingerprint_type_unknown) {
 
             // re-initialize the structure that holds analysis results
             //
             analysis.result.reinit();
             bool output_analysis = std::visit(do_analysis{k, analysis, c}, x);
+            if (output_analysis && nearest_cache) {
+                c->set_nearest_fingerprint(analysis.fp, analysis.result, *nearest_cache, ts->tv_sec);
+            }
 
             // note: we only perform observations when analysis is
             // configured, because we rely on do_analysis to set the
@@ -1110,18 +1320,23 @@ bool stateful_pkt_proc::analyze_ip_packet(const uint8_t *packet,
             if (mq) {
                 std::visit(do_observation{k, analysis, mq}, x);
             }
+            perf.lap(perf_stage_analysis);
 
             if (reassembler) {
                 if (reassembler->is_done(reassembler->curr_flow)) {
                     analysis.flow_state_pkts_needed = false;
                 }
                 reassembler->clean_curr_flow();
+                counters.set_reassembly_flows(reassembler->table.size());
             }
 
             // if fingerprint truncated, set fp status to unlabeled
             if (truncated_tcp or truncated_udp) {
                 analysis.result.status = fingerprint_status::fingerprint_status_unlabled;
             }
+            if (output_analysis) {
+                counters.analysis_result(analysis.result.status);
+            }
 
             return output_analysis;
         }
@@ -1132,6 +1347,7 @@ bool stateful_pkt_proc::analyze_ip_packet(const uint8_t *packet,
             analysis.flow_state_pkts_needed = false;
         }
         reassembler->clean_curr_flow();
+        counters.set_reassembly_flows(reassembler->table.size());
     }
 
     return false;  // indicate no analysis results were returned
@@ -13,6 +13,13 @@
 #include <sys/time.h>
 #include <stdexcept>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <algorithm>
 #include "tcp.h"
 #include "flow_key.h"
 #include "analysis.h"
@@ -25,6 +32,10 @@
 #include "crypto_assess.h"
 #include "pkt_proc_util.h"
 #include "reassembly.hpp"
+#include "ip_defrag.hpp"
+#include "record_suppressor.hpp"
+#include "perf_counters.hpp"
+#include "processor_counters.hpp"
 
 /**
  * enum linktype is a 16-bit enumeration that identifies a protocol
@@ -42,45 +53,86 @@ enum linktype : uint16_t {
 };
 
 
+/**
+ * struct classifier_reader holds the state that a packet processor
+ * shares with the reload thread of struct mercury: the last
+ * classifier epoch that the processor has acknowledged, and whether
+ * or not it is currently processing a packet
+ *
+ */
+struct classifier_reader {
+    std::atomic<uint64_t> epoch_ack{0};
+    std::atomic<bool> active{false};
+
+    /// returns `true` if this reader holds no references into any
+    /// classifier older than \param epoch
+    ///
+    bool acknowledged(uint64_t epoch) const {
+        return !active.load() || epoch_ack.load(std::memory_order_acquire) >= epoch;
+    }
+};
+
 /**
  * struct mercury holds state that is used by one or more
  * mercury_packet_processor
  *
+ * The classifier pointer \ref c can be replaced while packets are
+ * being processed, by calling reload_classifier(); that function
+ * loads a new classifier in a background thread, then publishes it
+ * with an atomic pointer swap and increments classifier_epoch.  Each
+ * stateful_pkt_proc checks that epoch at the start of each packet,
+ * and acknowledges it after it has switched over to the new
+ * classifier.  A processor that is not inside of a packet holds no
+ * references into the classifier, and is treated as having
+ * acknowledged the swap, so that an idle processor does not hold
+ * up a reload.  The old classifier is deleted after every registered
+ * processor has acknowledged the swap, and a grace period has
+ * elapsed, in the style of read-copy-update (RCU); analysis results
+ * from the last packet that a processor handled remain valid for
+ * that grace period.
+ *
  */
 struct mercury {
     struct global_config global_vars;
     std::unique_ptr<data_aggregator> aggregator{nullptr};
-    classifier *c;
+    std::atomic<classifier *> c;
     class traffic_selector selector;
 
+    std::atomic<uint64_t> classifier_epoch{0};   // number of classifier swaps
+
     mercury(const struct libmerc_config *vars, int verbosity) :
                 global_vars{*vars},
                 aggregator{ global_vars.do_stats
-                            ? (std::make_unique<data_aggregator>(global_vars.max_stats_entries, global_vars.stats_blocking))
+                            ? (std::make_unique<data_aggregator>(global_vars.max_stats_entries, global_vars.stats_blocking, global_vars.stats_memory))
                             : nullptr },
                 c{nullptr},
-                selector{global_vars.protocols} {
+                selector{global_vars.protocols},
+                verbosity{verbosity} {
         if (global_vars.do_analysis) {
-            c = analysis_init_from_archive(verbosity, global_vars.get_resource_file(),
-                                           vars->enc_key, vars->key_type,
-                                           global_vars.fp_proc_threshold,
-                                           global_vars.proc_dst_threshold,
-                                           global_vars.report_os);
-            if (c == nullptr) {
+            classifier *tmp = analysis_init_from_archive(verbosity, global_vars.get_resource_file(),
+                                                         vars->enc_key, vars->key_type,
+                                                         global_vars.fp_proc_threshold,
+                                                         global_vars.proc_dst_threshold,
+                                                         global_vars.report_os);
+            if (tmp == nullptr) {
                 throw std::runtime_error("error: analysis_init_from_archive() failed"); // failure
             }
+            if (global_vars.nearest_fingerprint) {
+                tmp->build_nearest_fingerprint_index();
+            }
+            c.store(tmp);
 
             // set fingerprint formats to match those in the resource file
             //
-            size_t format = c->get_tls_fingerprint_format();
+            size_t format = tmp->get_tls_fingerprint_format();
             global_vars.fp_format.set_tls_fingerprint_format(format);
             printf_err(log_info, "setting tls fingerprint format to match resource file (format: %zu)\n", format);
 
-            format = c->get_quic_fingerprint_format();
+            format = tmp->get_quic_fingerprint_format();
             global_vars.fp_format.set_quic_fingerprint_format(format);
             printf_err(log_info, "setting quic fingerprint format to match resource file (format: %zu)\n", format);
 
-            if (c->is_disabled()) {
+            if (tmp->is_disabled()) {
                 printf_err(log_debug, "classifier could not be initialized, disabling all protocols\n");
                 selector.disable_all();
             }
@@ -88,7 +140,152 @@ struct mercury {
     }
 
     ~mercury() {
-        analysis_finalize(c);
+        shutdown_requested.store(true);
+        if (reload_thread.joinable()) {
+            reload_thread.join();
+        }
+        analysis_finalize(c.load());
+    }
+
+    /// starts loading the resource archive \param resource_file (or
+    /// the current one, if that parameter is `nullptr`) in a
+    /// background thread, and returns `true` if the load was started;
+    /// `false` is returned if analysis is not configured, or if a
+    /// reload is already in progress
+    ///
+    bool reload_classifier(const char *resource_file) {
+        if (!global_vars.do_analysis) {
+            return false;
+        }
+        if (reload_in_progress.exchange(true)) {
+            printf_err(log_warning, "resource reload already in progress\n");
+            return false;
+        }
+        if (reload_thread.joinable()) {
+            reload_thread.join();     // previous reload has completed
+        }
+        std::string file{ resource_file ? resource_file : global_vars.get_resource_file() };
+        reload_thread = std::thread{ [this, file](){ reload(file); } };
+        return true;
+    }
+
+    /// registers the classifier_reader of a packet processor, so
+    /// that the reload thread can wait for it
+    ///
+    void register_processor(const classifier_reader *reader) {
+        std::lock_guard<std::mutex> lock{processor_mutex};
+        processor_readers.push_back(reader);
+    }
+
+    void unregister_processor(const classifier_reader *reader) {
+        std::lock_guard<std::mutex> lock{processor_mutex};
+        processor_readers.erase(std::remove(processor_readers.begin(), processor_readers.end(), reader), processor_readers.end());
+    }
+
+    // the perf_counters and processor_counters of the packet
+    // processors, which are summed over all of the processors that
+    // have been constructed with this context
+    //
+    counters_registry<perf_counters, perf_counters_snapshot> perf;
+    counters_registry<processor_counters, processor_counters_snapshot> counters;
+
+    /// returns a copy of the resource version of the current
+    /// classifier, which is safe to use while a reload is taking place
+    ///
+    std::string get_resource_version() {
+        std::lock_guard<std::mutex> lock{retire_mutex};
+        classifier *tmp = c.load(std::memory_order_acquire);
+        return tmp ? tmp->get_resource_version() : "";
+    }
+
+private:
+    int verbosity;
+    std::thread reload_thread;
+    std::atomic<bool> reload_in_progress{false};
+    std::atomic<bool> shutdown_requested{false};
+    std::mutex processor_mutex;
+    std::vector<const classifier_reader *> processor_readers;
+    std::mutex retire_mutex;
+
+    static constexpr std::chrono::milliseconds ack_poll_interval{10};
+    static constexpr std::chrono::milliseconds grace_period{1000};
+
+    bool all_processors_acknowledged(uint64_t epoch) {
+        std::lock_guard<std::mutex> lock{processor_mutex};
+        for (const auto *reader : processor_readers) {
+            if (!reader->acknowledged(epoch)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void reload(const std::string &resource_file) {
+        classifier *tmp = nullptr;
+        try {
+            tmp = analysis_init_from_archive(verbosity, resource_file.c_str(),
+                                             global_vars.enc_key, global_vars.key_type,
+                                             global_vars.fp_proc_threshold,
+                                             global_vars.proc_dst_threshold,
+                                             global_vars.report_os);
+        }
+        catch (std::exception &e) {
+            printf_err(log_err, "%s\n", e.what());
+        }
+
+        // the new classifier must be usable by processors that were
+        // configured with the current one, so the fingerprint
+        // formats must not change
+        //
+        if (tmp == nullptr || tmp->is_disabled()) {
+            printf_err(log_err, "could not load resource file %s; keeping current resources\n", resource_file.c_str());
+            analysis_finalize(tmp);
+            reload_in_progress.store(false);
+            return;
+        }
+        if (tmp->get_tls_fingerprint_format() != global_vars.fp_format.tls_fingerprint_format
+            || tmp->get_quic_fingerprint_format() != global_vars.fp_format.quic_fingerprint_format) {
+            printf_err(log_err, "fingerprint format in resource file %s does not match current resources; keeping current resources\n", resource_file.c_str());
+            analysis_finalize(tmp);
+            reload_in_progress.store(false);
+            return;
+        }
+
+        if (global_vars.nearest_fingerprint) {
+            tmp->build_nearest_fingerprint_index();
+        }
+
+        // publish the new classifier, then advance the epoch, so that
+        // a processor that observes the new epoch also observes the
+        // new classifier
+        //
+        // the epoch update is sequentially consistent with the
+        // reads of classifier_reader::active, so that a processor
+        // that is about to start a packet either is seen as active,
+        // or sees the new epoch
+        //
+        classifier *old = c.exchange(tmp, std::memory_order_acq_rel);
+        uint64_t epoch = classifier_epoch.fetch_add(1) + 1;
+        printf_err(log_info, "loaded resource file %s (resource version: %s)\n", resource_file.c_str(), tmp->get_resource_version());
+
+        // wait for each processor to pass a safe point or to be idle,
+        // then wait for the grace period to cover readers outside of
+        // the processors
+        //
+        while (!all_processors_acknowledged(epoch)) {
+            if (shutdown_requested.load()) {
+                break;          // processors are no longer running
+            }
+            std::this_thread::sleep_for(ack_poll_interval);
+        }
+        for (auto t = std::chrono::milliseconds{0}; t < grace_period && !shutdown_requested.load(); t += ack_poll_interval) {
+            std::this_thread::sleep_for(ack_poll_interval);
+        }
+        {
+            std::lock_guard<std::mutex> lock{retire_mutex};
+            analysis_finalize(old);
+        }
+        reload_in_progress.store(false);
     }
 };
 
@@ -96,6 +293,7 @@ struct stateful_pkt_proc {
     struct flow_table ip_flow_table;
     struct flow_table_tcp tcp_flow_table;
     struct tcp_initial_message_filter tcp_init_msg_filter;
+    ip_defragmenter ip_defrag;
     struct analysis_context analysis;
     class message_queue *mq;
     mercury_context m;
@@ -106,11 +304,24 @@ struct stateful_pkt_proc {
     quic_crypto_engine quic_crypto;
     struct tcp_reassembler *reassembler_ptr = nullptr;
     const crypto_policy::assessor *crypto_policy = nullptr;
+    record_suppressor *suppressor = nullptr;
+    nearest_fingerprint_cache *nearest_cache = nullptr;   // for --nearest-fingerprint
+    enum record_verbosity verbosity = record_verbosity_full;   // set by mercury_packet_processor_set_verbosity()
+    classifier_reader reader;   // classifier epoch acknowledgement, shared with m
+    perf_counters perf;
+    processor_counters counters;
+
+    // the implementation of ip_write_json(), which is chosen by
+    // select_processor() when the processor is constructed
+    //
+    using ip_write_json_function = size_t (stateful_pkt_proc::*)(void *, size_t, const uint8_t *, size_t, struct timespec *, struct tcp_reassembler *);
+    ip_write_json_function ip_write_json_fn = &stateful_pkt_proc::ip_write_json_selected<all_protocols>;
 
     explicit stateful_pkt_proc(mercury_context mc, size_t prealloc_size=0) :
         ip_flow_table{prealloc_size},
         tcp_flow_table{prealloc_size},
         tcp_init_msg_filter{},
+        ip_defrag{},
         analysis{},
         mq{nullptr},
         m{mc},
@@ -119,7 +330,9 @@ struct stateful_pkt_proc {
         global_vars{mc->global_vars},
         selector{mc->selector},
         quic_crypto{},
-        reassembler_ptr{(global_vars.reassembly) ? (new tcp_reassembler) : nullptr}
+        reassembler_ptr{(global_vars.reassembly) ? (new tcp_reassembler) : nullptr},
+        suppressor{global_vars.suppress_repeats ? new record_suppressor{global_vars.suppress_repeats, global_vars.suppress_timeout} : nullptr},
+        nearest_cache{global_vars.nearest_fingerprint ? new nearest_fingerprint_cache : nullptr}
     {
 
         if (global_vars.crypto_assess_policy.length() > 0) {
@@ -132,10 +345,9 @@ struct stateful_pkt_proc {
 
         // set config and classifier to (refer to) context m
         //
-        if (m->c == nullptr && m->global_vars.do_analysis) {
+        if (m->c.load() == nullptr && m->global_vars.do_analysis) {
             throw std::runtime_error("error: classifier pointer is null");
         }
-        this->c = m->c;
         this->global_vars = m->global_vars;
 
         // setting protocol based configuration option to output the raw features
@@ -152,6 +364,20 @@ struct stateful_pkt_proc {
             }
         }
 
+        // the epoch is read, and the processor is registered, before
+        // the classifier pointer is read, so that a concurrent reload
+        // cannot free the classifier that this processor ends up with
+        //
+        reader.epoch_ack.store(m->classifier_epoch.load(std::memory_order_acquire), std::memory_order_release);
+        m->register_processor(&reader);
+        this->c = m->c.load(std::memory_order_acquire);
+
+        perf.set_enabled(global_vars.perf_counters);
+        m->perf.add(&perf);
+        m->counters.add(&counters);
+
+        select_processor();
+
 //#ifndef USE_TCP_REASSEMBLY
 // #pragma message "omitting tcp reassembly; 'make clean' and recompile with OPTFLAGS=-DUSE_TCP_REASSEMBLY to use that option"
 //        reassembler_ptr = nullptr;
@@ -162,11 +388,67 @@ struct stateful_pkt_proc {
     }
 
     ~stateful_pkt_proc() {
+        m->unregister_processor(&reader);
+        counters.set_reassembly_flows(0);
+        m->perf.remove(&perf);
+        m->counters.remove(&counters);
         delete crypto_policy;
         delete reassembler_ptr;
+        delete suppressor;
+        delete nearest_cache;
         // we could call ag->remote_procuder(mq), but for now we do not
     }
 
+    // update_classifier() switches over to a classifier published by
+    // mercury::reload_classifier(), if there is one, and acknowledges
+    // the swap; it must only be called between packets, when no
+    // references into the classifier are held
+    //
+    void update_classifier() {
+        uint64_t epoch = m->classifier_epoch.load();
+        if (epoch != reader.epoch_ack.load(std::memory_order_relaxed)) {
+            c = m->c.load(std::memory_order_acquire);
+            reader.epoch_ack.store(epoch, std::memory_order_release);
+        }
+    }
+
+    // class packet_scope marks its processor as active for its
+    // lifetime, and switches to the current classifier on entry, so
+    // that the reload thread waits only for processors that are in
+    // the middle of a packet
+    //
+    class packet_scope {
+        stateful_pkt_proc &proc;
+    public:
+        explicit packet_scope(stateful_pkt_proc &p) : proc{p} {
+            proc.reader.active.store(true);
+            proc.update_classifier();
+        }
+        ~packet_scope() {
+            proc.reader.active.store(false, std::memory_order_release);
+        }
+        packet_scope(const packet_scope &) = delete;
+        packet_scope &operator=(const packet_scope &) = delete;
+    };
+
+    // defragment() applies the IP defragmenter to pkt, when reassembly
+    // is configured, and returns true if pkt should be processed; pkt
+    // is set to the reassembled datagram when its last fragment
+    // arrives, and false is returned for fragments that are held or
+    // dropped
+    //
+    bool defragment(datum &pkt, unsigned int sec) {
+        if (!global_vars.reassembly) {
+            return true;
+        }
+        ip_defragmenter::result r = ip_defrag.apply(pkt, sec);
+        if (r == ip_defragmenter::not_fragment) {
+            return true;
+        }
+        counters.set_ip_fragments(ip_defrag.get_counts());
+        return r == ip_defragmenter::reassembled;
+    }
+
     // TODO: the count_all() functions should probably be removed
     //
     void finalize() {
@@ -176,6 +458,17 @@ struct stateful_pkt_proc {
         tcp_flow_table.count_all();
     }
 
+    // write_suppressed_json() retires the records held by the record
+    // suppressor, if there is one, that have expired at the time ts,
+    // or all of them if ts is nullptr, and writes as many of the
+    // summary records that are due as fit into buffer, one per line;
+    // it returns the number of bytes written, and should be called
+    // until it returns zero
+    //
+    size_t write_suppressed_json(void *buffer, size_t buffer_size, const struct timespec *ts);
+
+    void write_reduced_json(struct json_object &record, size_t protocol_index, const struct key &k, struct timespec *ts);
+
     size_t write_json(void *buffer,
                       size_t buffer_size,
                       uint8_t *packet,
@@ -200,6 +493,87 @@ struct stateful_pkt_proc {
                       struct tcp_reassembler *reassembler,
                       uint16_t linktype);
 
+    size_t write_json_batch(void *arena,
+                            size_t arena_size,
+                            size_t max_record_size,
+                            uint8_t **packets,
+                            const size_t *lengths,
+                            struct timespec *ts,
+                            const uint16_t *linktypes,
+                            size_t num_packets,
+                            size_t *offsets,
+                            size_t *record_lengths);
+
+    // write_json_batch(out, ...) processes a batch of packets in a
+    // single pass, and writes the JSON record for each packet into a
+    // buffer obtained from out, which must provide the member
+    // functions
+    //
+    //    uint8_t *begin_record(size_t i, size_t *size) returns the
+    //    buffer for the record of packet i and sets size to its
+    //    length, or returns nullptr if packet i should be skipped,
+    //
+    //    bool is_full() returns true if no more records can be
+    //    written, in which case processing stops, and
+    //
+    //    void end_record(size_t i, size_t length) accepts the record
+    //    of packet i, whose length is zero if none was written.
+    //
+    // The first bytes of the packet that is batch_prefetch_distance
+    // packets ahead are prefetched before each packet is processed;
+    // their addresses are known without dereferencing anything, and
+    // the headers and initial payload of a packet in a capture ring
+    // are unlikely to be in cache.  The number of packets processed
+    // is returned.
+    //
+    template <typename output>
+    size_t write_json_batch(output &out,
+                            uint8_t **packets,
+                            const size_t *lengths,
+                            struct timespec *ts,
+                            const uint16_t *linktypes,
+                            size_t num_packets) {
+        size_t i = 0;
+        for ( ; i < num_packets; i++) {
+            if (i + batch_prefetch_distance < num_packets) {
+                prefetch_packet(packets[i + batch_prefetch_distance], lengths[i + batch_prefetch_distance]);
+            }
+            size_t size = 0;
+            uint8_t *buffer = out.begin_record(i, &size);
+            if (buffer == nullptr) {
+                if (out.is_full()) {
+                    break;
+                }
+                continue;
+            }
+            size_t record_length = 0;
+            try {
+                record_length = write_json(buffer,
+                                           size,
+                                           packets[i],
+                                           lengths[i],
+                                           &ts[i],
+                                           reassembler_ptr,
+                                           linktypes ? linktypes[i] : (uint16_t)LINKTYPE_ETHERNET);
+            }
+            catch (std::exception &e) {
+                printf_err(log_err, "%s\n", e.what());
+            }
+            out.end_record(i, record_length);
+        }
+        return i;
+    }
+
+    static constexpr size_t batch_prefetch_distance = 4;
+    static constexpr size_t batch_prefetch_bytes = 192;   // link, network, and transport headers, and the start of the payload
+
+    static void prefetch_packet(const uint8_t *packet, size_t length) {
+        size_t n = length < batch_prefetch_bytes ? length : batch_prefetch_bytes;
+        for (size_t offset = 0; offset < n; offset += 64) {
+            __builtin_prefetch(packet + offset);
+        }
+    }
+
     void tcp_data_write_json(struct buffer_stream &buf,
                              struct datum &pkt,
                              const struct key &k,
@@ -212,7 +586,29 @@ struct stateful_pkt_proc {
                          const uint8_t *ip_packet,
                          size_t length,
                          struct timespec *ts,
-                         struct tcp_reassembler *reassembler);
+                         struct tcp_reassembler *reassembler) {
+        return (this->*ip_write_json_fn)(buffer, buffer_size, ip_packet, length, ts, reassembler);
+    }
+
+    // ip_write_json_selected<protocols>() is ip_write_json() for a
+    // processor that handles only the types in the protocol set
+    // protocols; the processing of other types is compiled out
+    //
+    template <typename protocols>
+    size_t ip_write_json_selected(void *buffer,
+                                  size_t buffer_size,
+                                  const uint8_t *ip_packet,
+                                  size_t length,
+                                  struct timespec *ts,
+                                  struct tcp_reassembler *reassembler);
+
+    // select_processor() sets ip_write_json() to a specialized
+    // implementation whose protocol set covers the selected
+    // protocols, if there is one and generic is false, and to the
+    // generic implementation otherwise, and returns the name of the
+    // implementation
+    //
+    const char *select_processor(bool generic=false);
 
     bool analyze_packet(const uint8_t *eth_packet,
                             size_t length,
@@ -247,6 +643,7 @@ struct stateful_pkt_proc {
                                       struct timespec *ts,
                                       struct tcp_reassembler *reassembler);
 
+    template <typename protocols=all_protocols>
     bool process_tcp_data (protocol &x,
                           struct datum &pkt,
                           struct tcp_packet &tcp_pkt,
@@ -254,6 +651,7 @@ struct stateful_pkt_proc {
                           struct timespec *ts,
                           struct tcp_reassembler *reassembler);
 
+    template <typename protocols=all_protocols>
     bool process_udp_data (protocol &x,
                           struct datum &pkt,
                           udp &udp_pkt,
@@ -261,11 +659,13 @@ struct stateful_pkt_proc {
                           struct timespec *ts,
                           struct tcp_reassembler *reassembler);
 
+    template <typename protocols=all_protocols>
     void set_tcp_protocol(protocol &x,
                           struct datum &pkt,
                           bool is_new,
                           struct tcp_packet *tcp_pkt);
 
+    template <typename protocols=all_protocols>
     void set_udp_protocol(protocol &x,
                           struct datum &pkt,
                           udp::ports ports,
@@ -14,6 +14,11 @@
 #ifndef PKT_PROC_UTIL_HPP
 #define PKT_PROC_UTIL_HPP
 
+#include <map>
+#include <string>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
 #include "protocol.h"
 #include "dns.h"
 #include "mdns.h"
@@ -115,6 +120,147 @@ using protocol = std::variant<std::monostate,
                               ike::packet
                               >;
 
+// protocol_type_name[] holds a name for each of the types in the
+// protocol variant, in the same order, for use in reporting
+//
+static constexpr const char *protocol_type_name[] = {
+    "none",
+    "http_request",
+    "http_response",
+    "tls_client_hello",
+    "tls_server_hello_and_certificate",
+    "tls_certificate",
+    "ssh_init_packet",
+    "ssh_kex_init",
+    "smtp_client",
+    "smtp_server",
+    "iec60870_5_104",
+    "dnp3",
+    "nbss_packet",
+    "bittorrent_handshake",
+    "tofsee_initial_message",
+    "ldap_message",
+    "unknown_initial_packet",
+    "quic_init",
+    "wireguard_handshake_init",
+    "dns_packet",
+    "mdns_packet",
+    "dtls_client_hello",
+    "dtls_server_hello",
+    "dhcp_discover",
+    "ssdp",
+    "stun_message",
+    "nbds_packet",
+    "bittorrent_dht",
+    "bittorrent_lsd",
+    "unknown_udp_initial_packet",
+    "icmp_packet",
+    "ospf",
+    "sctp_init",
+    "tcp_packet",
+    "smb1_packet",
+    "smb2_packet",
+    "openvpn_tcp",
+    "mysql_server_greet",
+    "socks5_req_resp",
+    "socks5_hello",
+    "socks4_req",
+    "esp",
+    "ike_packet",
+};
+static_assert(sizeof(protocol_type_name) / sizeof(protocol_type_name[0]) == std::variant_size_v<protocol>,
+              "protocol_type_name[] must have one entry for each type in the protocol variant");
+
+// a protocol set is a compile-time set of the types in the protocol
+// variant, which is used to instantiate packet processing functions
+// that handle only those types.  The member variable template
+// contains<T> is true if T is in the set, and the member function
+// visit(v, x) applies the function object v to the protocol variant
+// x, like std::visit(v, x).
+//
+// all_protocols contains every type, and visits through std::visit.
+//
+struct all_protocols {
+    template <typename T>
+    static constexpr bool contains = true;
+
+    template <typename V, typename P>
+    static decltype(auto) visit(V &&v, P &x) {
+        return std::visit(std::forward<V>(v), x);
+    }
+};
+
+// protocol_set<Ts...> contains the types Ts, and visit() checks for
+// each of them in turn, so that the visitor can be inlined; it falls
+// back on std::visit() if x holds any other type
+//
+template <typename... Ts>
+struct protocol_set {
+    template <typename T>
+    static constexpr bool contains = (std::is_same_v<T, Ts> || ...);
+
+    template <typename V, typename P>
+    static decltype(auto) visit(V &&v, P &x) {
+        return visit_in_order<V, P, Ts...>(v, x);
+    }
+
+private:
+
+    template <typename V, typename P, typename T, typename... Rest>
+    static decltype(auto) visit_in_order(V &v, P &x) {
+        if (T *p = std::get_if<T>(&x)) {
+            return v(*p);
+        }
+        if constexpr (sizeof...(Rest) > 0) {
+            return visit_in_order<V, P, Rest...>(v, x);
+        } else {
+            return std::visit(v, x);
+        }
+    }
+};
+
+// tls_http_quic_protocols is the set of protocols that can be
+// reported when only TLS, HTTP, and/or QUIC are selected, ordered
+// from most to least common; covers() returns true if the protocols
+// selected by a global_config::protocols map are all in that set
+//
+struct tls_http_quic_protocols : public protocol_set<tls_client_hello,
+                                                     quic_init,
+                                                     http_request,
+                                                     tls_server_hello_and_certificate,
+                                                     http_response,
+                                                     tls_certificate,
+                                                     unknown_initial_packet,
+                                                     unknown_udp_initial_packet,
+                                                     std::monostate> {
+
+    static constexpr const char *name = "tls_http_quic";
+
+    static bool covers(const std::map<std::string, bool> &selected) {
+        static constexpr const char *names[] = {
+            "tls",
+            "tls.client_hello",
+            "tls.server_hello",
+            "tls.server_certificate",
+            "http",
+            "http.request",
+            "http.response",
+            "quic",
+        };
+        auto none = selected.find("none");
+        if (none != selected.end() && none->second) {
+            return true;
+        }
+        for (const auto &s : selected) {
+            if (s.second && std::find_if(std::begin(names), std::end(names),
+                                         [&](const char *n) { return s.first == n; }) == std::end(names)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
 // class unknown_initial_packet represents the initial data field of a
 // tcp or udp packet from an unknown protocol
 //
@@ -302,4 +448,21 @@ struct do_analysis {
 
 };
 
+// get_server_name returns the server name of a message (the TLS or
+// QUIC server_name, or the HTTP host header), or a null datum if it
+// has none
+//
+struct get_server_name {
+
+    template <typename T>
+    datum operator()(T &) { return {nullptr, nullptr}; }
+
+    datum operator()(tls_client_hello &msg) { return msg.get_server_name(); }
+
+    datum operator()(quic_init &msg) { return msg.get_server_name(); }
+
+    datum operator()(http_request &msg) { return msg.get_header("host"); }
+
+};
+
 #endif  /* PKT_PROC_UTIL_HPP */
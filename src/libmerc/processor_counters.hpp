@@ -0,0 +1,210 @@
+// processor_counters.hpp
+//
+// counters for the records written and suppressed, the analysis
+// results reported, and the IP fragments handled by a packet
+// processor, which are read by other threads to report operational
+// metrics
+
+#ifndef PROCESSOR_COUNTERS_HPP
+#define PROCESSOR_COUNTERS_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include "libmerc.h"
+#include "buffer_stream.h"
+#include "ip_defrag.hpp"
+#include "record_suppressor.hpp"
+
+/// the names of the fingerprint_status values, as used in metrics;
+/// labeled and unlabeled results are hits in the classifier's
+/// fingerprint database and prevalence cache, respectively, and
+/// randomized results are misses
+///
+static constexpr const char *fingerprint_status_metric_name[] = {
+    "no_info_available",
+    "labeled",
+    "randomized",
+    "unlabeled",
+    "unanalyzed",
+};
+
+/// a copy of the counts in one or more \ref processor_counters
+/// objects, which can be written out in the Prometheus text
+/// exposition format
+///
+struct processor_counters_snapshot {
+    static constexpr size_t max_protocol_types = 64;
+    static constexpr size_t num_fingerprint_statuses = sizeof(fingerprint_status_metric_name) / sizeof(fingerprint_status_metric_name[0]);
+
+    size_t num_processors = 0;
+    uint64_t reassembly_flows = 0;
+    std::array<uint64_t, max_protocol_types> records{};
+    std::array<uint64_t, num_fingerprint_statuses> analysis_results{};
+    ip_defragmenter::counts ip_fragments{};
+    record_suppressor::counts suppression{};
+
+    /// writes the counts as Prometheus metrics; \param protocol_names
+    /// is an array of \param num_protocol_types names, one for each
+    /// protocol type index
+    ///
+    void write_prometheus(buffer_stream &buf, const char * const *protocol_names, size_t num_protocol_types) const {
+        buf.puts("# HELP libmerc_packet_processors Number of packet processors.\n"
+                 "# TYPE libmerc_packet_processors gauge\n");
+        buf.snprintf("libmerc_packet_processors %zu\n", num_processors);
+
+        buf.puts("# HELP libmerc_reassembly_flows Number of flows in the reassembly tables.\n"
+                 "# TYPE libmerc_reassembly_flows gauge\n");
+        buf.snprintf("libmerc_reassembly_flows %" PRIu64 "\n", reassembly_flows);
+
+        buf.puts("# HELP libmerc_records_total Number of records written, by protocol.\n"
+                 "# TYPE libmerc_records_total counter\n");
+        for (size_t i = 0; i < std::min(num_protocol_types, max_protocol_types); i++) {
+            if (records[i]) {
+                buf.snprintf("libmerc_records_total{protocol=\"%s\"} %" PRIu64 "\n", protocol_names[i], records[i]);
+            }
+        }
+
+        buf.puts("# HELP libmerc_analysis_results_total Number of fingerprint analysis results, by fingerprint status.\n"
+                 "# TYPE libmerc_analysis_results_total counter\n");
+        for (size_t i = 0; i < num_fingerprint_statuses; i++) {
+            buf.snprintf("libmerc_analysis_results_total{status=\"%s\"} %" PRIu64 "\n", fingerprint_status_metric_name[i], analysis_results[i]);
+        }
+
+        buf.puts("# HELP libmerc_ip_fragments_total Number of IP fragments seen by the defragmenters.\n"
+                 "# TYPE libmerc_ip_fragments_total counter\n");
+        buf.snprintf("libmerc_ip_fragments_total %" PRIu64 "\n", ip_fragments[ip_defragmenter::fragments]);
+
+        buf.puts("# HELP libmerc_ip_datagrams_reassembled_total Number of fragmented IP datagrams reassembled.\n"
+                 "# TYPE libmerc_ip_datagrams_reassembled_total counter\n");
+        buf.snprintf("libmerc_ip_datagrams_reassembled_total %" PRIu64 "\n", ip_fragments[ip_defragmenter::datagrams]);
+
+        buf.puts("# HELP libmerc_ip_fragment_drops_total Number of IP fragments and datagrams dropped by the defragmenters, by reason.\n"
+                 "# TYPE libmerc_ip_fragment_drops_total counter\n");
+        for (size_t i = ip_defragmenter::datagrams + 1; i < ip_defragmenter::num_counters; i++) {
+            buf.snprintf("libmerc_ip_fragment_drops_total{reason=\"%s\"} %" PRIu64 "\n", ip_defragmenter::counter_name[i], ip_fragments[i]);
+        }
+
+        buf.puts("# HELP libmerc_records_suppressed_total Number of repeated records suppressed.\n"
+                 "# TYPE libmerc_records_suppressed_total counter\n");
+        buf.snprintf("libmerc_records_suppressed_total %" PRIu64 "\n", suppression.suppressed);
+
+        buf.puts("# HELP libmerc_suppression_summaries_total Number of summaries of suppressed records written.\n"
+                 "# TYPE libmerc_suppression_summaries_total counter\n");
+        buf.snprintf("libmerc_suppression_summaries_total %" PRIu64 "\n", suppression.summaries);
+
+        buf.puts("# HELP libmerc_suppression_summaries_dropped_total Number of summaries of suppressed records discarded because they could not be written.\n"
+                 "# TYPE libmerc_suppression_summaries_dropped_total counter\n");
+        buf.snprintf("libmerc_suppression_summaries_dropped_total %" PRIu64 "\n", suppression.dropped);
+    }
+};
+
+/// counters for a single packet processor.  The counters are updated
+/// only by the thread that owns the packet processor, and may be read
+/// by another thread at the same time, so they are atomic, but they
+/// are updated with relaxed loads and stores rather than
+/// read-modify-write operations.
+///
+class processor_counters {
+    std::atomic<uint64_t> reassembly_flows{0};
+    std::array<std::atomic<uint64_t>, processor_counters_snapshot::max_protocol_types> records{};
+    std::array<std::atomic<uint64_t>, processor_counters_snapshot::num_fingerprint_statuses> analysis_results{};
+    std::array<std::atomic<uint64_t>, ip_defragmenter::num_counters> ip_fragments{};
+    std::atomic<uint64_t> suppressed{0};
+    std::atomic<uint64_t> suppression_summaries{0};
+    std::atomic<uint64_t> suppression_dropped{0};
+
+    static void increment(std::atomic<uint64_t> &a) {
+        a.store(a.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+public:
+
+    void record(size_t protocol_index) {
+        increment(records[std::min(protocol_index, processor_counters_snapshot::max_protocol_types - 1)]);
+    }
+
+    void analysis_result(enum fingerprint_status status) {
+        if ((size_t)status < processor_counters_snapshot::num_fingerprint_statuses) {
+            increment(analysis_results[status]);
+        }
+    }
+
+    void set_reassembly_flows(size_t n) {
+        reassembly_flows.store(n, std::memory_order_relaxed);
+    }
+
+    void set_ip_fragments(const ip_defragmenter::counts &c) {
+        for (size_t i = 0; i < c.size(); i++) {
+            ip_fragments[i].store(c[i], std::memory_order_relaxed);
+        }
+    }
+
+    void set_suppression(const record_suppressor::counts &c) {
+        suppressed.store(c.suppressed, std::memory_order_relaxed);
+        suppression_summaries.store(c.summaries, std::memory_order_relaxed);
+        suppression_dropped.store(c.dropped, std::memory_order_relaxed);
+    }
+
+    void add_to(processor_counters_snapshot &s) const {
+        s.reassembly_flows += reassembly_flows.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < s.records.size(); i++) {
+            s.records[i] += records[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < s.analysis_results.size(); i++) {
+            s.analysis_results[i] += analysis_results[i].load(std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < s.ip_fragments.size(); i++) {
+            s.ip_fragments[i] += ip_fragments[i].load(std::memory_order_relaxed);
+        }
+        s.suppression.suppressed += suppressed.load(std::memory_order_relaxed);
+        s.suppression.summaries += suppression_summaries.load(std::memory_order_relaxed);
+        s.suppression.dropped += suppression_dropped.load(std::memory_order_relaxed);
+    }
+};
+
+/// the counters of type T of a set of packet processors, which can be
+/// summed into a snapshot of type S.  The counts of counters that are
+/// removed from the registry are retained in the snapshots, so that
+/// they do not decrease when a packet processor is destructed.
+///
+template <typename T, typename S>
+class counters_registry {
+    std::mutex m;
+    std::vector<const T *> counters;
+    S retired;
+
+public:
+
+    void add(const T *c) {
+        std::lock_guard<std::mutex> lock{m};
+        counters.push_back(c);
+    }
+
+    void remove(const T *c) {
+        std::lock_guard<std::mutex> lock{m};
+        auto it = std::find(counters.begin(), counters.end(), c);
+        if (it != counters.end()) {
+            c->add_to(retired);
+            counters.erase(it);
+        }
+    }
+
+    /// returns the sum of all of the counters, with num_processors
+    /// set to the number of counters currently in the registry
+    ///
+    S get_snapshot() {
+        std::lock_guard<std::mutex> lock{m};
+        S s{retired};
+        for (const T *c : counters) {
+            c->add_to(s);
+        }
+        s.num_processors = counters.size();
+        return s;
+    }
+};
+
+#endif // PROCESSOR_COUNTERS_HPP
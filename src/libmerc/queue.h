@@ -108,6 +108,13 @@ public:
     ssize_t capacity() const {
         return EVENT_BUF_SIZE - 1;
     }
+
+    // returns the number of messages dropped because the queue was full
+    //
+    long unsigned int drops() {
+        std::unique_lock<std::mutex> m_lock(m);
+        return err_count;
+    }
 };
 
 
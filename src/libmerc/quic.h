@@ -13,10 +13,14 @@
 #ifndef QUIC_H
 #define QUIC_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <string>
 #include <tuple>
 #include <unordered_map>
 #include <variant>
+#include <vector>
 #include <openssl/aes.h>
 #include <openssl/hmac.h>
 #include <openssl/evp.h>
@@ -665,6 +669,125 @@ struct quic_initial_packet {
 
 };
 
+// class learned_version_table is a bounded, lock-free hash table that
+// holds what has been learned about QUIC versions that are not in the
+// built-in table of quic_parameters: either the initial parameters
+// that were found by trying every salt, or the fact that every salt
+// failed.  The latter (negative) entries limit the work done for
+// packets with garbage or unsupported versions; after a failure, the
+// next \ref failure_retry_interval packets with that version are not
+// decrypted, and then a single one is tried again.
+//
+// The table is shared by all packet processors.  Each slot holds a
+// version and its entry in a single atomic word, and entries are
+// never removed, though negative entries can be replaced with other
+// entries when the table is full.  If threads race to update an
+// entry, one of the updates is lost, which only means that a version
+// is learned, or a retry is made, a little later.
+//
+class learned_version_table {
+public:
+
+    static constexpr size_t num_slots = 64;
+    static constexpr uint16_t failure_retry_interval = 64;
+
+    enum class status {
+        unknown,   // no entry for this version
+        learned,   // value holds the learned parameters
+        failed,    // every salt failed recently; do not try again yet
+        retry,     // every salt failed, but it is time to try again
+    };
+
+    struct result {
+        enum status status;
+        uint32_t value;
+    };
+
+    result lookup(uint32_t version) {
+        for (size_t i = 0; i < num_slots; i++) {
+            std::atomic<uint64_t> &slot = slots[(hash(version) + i) % num_slots];
+            uint64_t e = slot.load(std::memory_order_acquire);
+            if (e == 0) {
+                break;
+            }
+            if (entry_version(e) != version) {
+                continue;
+            }
+            if (e & learned_flag) {
+                return { status::learned, (uint32_t)(e & value_mask) };
+            }
+            uint64_t remaining = e & value_mask;
+            if (remaining == 0) {
+                // only the thread that resets the interval retries
+                //
+                if (slot.compare_exchange_strong(e, failed_entry(version), std::memory_order_relaxed)) {
+                    return { status::retry, 0 };
+                }
+                return { status::failed, 0 };
+            }
+            slot.compare_exchange_strong(e, e - 1, std::memory_order_relaxed);
+            return { status::failed, 0 };
+        }
+        return { status::unknown, 0 };
+    }
+
+    void learn(uint32_t version, uint32_t value) {
+        insert(version, make_entry(version) | learned_flag | (value & value_mask));
+    }
+
+    void fail(uint32_t version) {
+        insert(version, failed_entry(version));
+    }
+
+private:
+
+    static constexpr uint64_t occupied_flag = 1ul << 31;
+    static constexpr uint64_t learned_flag  = 1ul << 30;
+    static constexpr uint64_t value_mask    = 0x00ffffff;
+
+    std::array<std::atomic<uint64_t>, num_slots> slots{};
+
+    static size_t hash(uint32_t version) {
+        return (version * 0x9e3779b97f4a7c15ul) >> 58;
+    }
+    static_assert(num_slots == 64, "hash() assumes 64 slots");
+
+    static uint32_t entry_version(uint64_t e) { return e >> 32; }
+
+    static uint64_t make_entry(uint32_t version) { return ((uint64_t)version << 32) | occupied_flag; }
+
+    static uint64_t failed_entry(uint32_t version) { return make_entry(version) | failure_retry_interval; }
+
+    void insert(uint32_t version, uint64_t new_entry) {
+        std::atomic<uint64_t> *victim = nullptr;
+        uint64_t victim_entry = 0;
+        for (size_t i = 0; i < num_slots; i++) {
+            std::atomic<uint64_t> &slot = slots[(hash(version) + i) % num_slots];
+            uint64_t e = 0;
+            if (slot.compare_exchange_strong(e, new_entry, std::memory_order_release, std::memory_order_acquire)) {
+                return;  // slot was empty
+            }
+            if (entry_version(e) == version) {
+                if ((new_entry & learned_flag) || !(e & learned_flag)) {
+                    slot.store(new_entry, std::memory_order_release);
+                }
+                return;
+            }
+            if (victim == nullptr && !(e & learned_flag)) {
+                victim = &slot;
+                victim_entry = e;
+            }
+        }
+
+        // the table is full, so replace a negative entry, if there is one
+        //
+        if (victim) {
+            victim->compare_exchange_strong(victim_entry, new_entry, std::memory_order_release, std::memory_order_relaxed);
+        }
+    }
+
+};
+
 class quic_parameters {
 public:
 
@@ -693,6 +816,19 @@ public:
         V2         = 1,
     };
 
+    using initial_params = std::tuple<salt_enum, init_pkt_mask_enum, hkdf_label_enum>;
+
+    // encode() and decode() convert initial_params to and from the
+    // value stored in a learned_version_table
+    //
+    static uint32_t encode(const initial_params &p) {
+        return (static_cast<uint32_t>(std::get<0>(p)) << 16) | (static_cast<uint32_t>(std::get<1>(p)) << 8) | static_cast<uint32_t>(std::get<2>(p));
+    }
+
+    static initial_params decode(uint32_t value) {
+        return { static_cast<salt_enum>((value >> 16) & 0xff), static_cast<init_pkt_mask_enum>((value >> 8) & 0xff), static_cast<hkdf_label_enum>(value & 0xff) };
+    }
+
     // class salt holds a salt value and the printable name associated
     // with it
     //
@@ -791,10 +927,17 @@ private:
 
     std::unordered_map<uint32_t, const std::tuple<salt_enum, init_pkt_mask_enum, hkdf_label_enum> > quic_initial_params;
 
+    // the distinct initial parameters in quic_initial_params, which
+    // are tried in turn for versions that are not in that table
+    //
+    std::vector<initial_params> candidate_params;
+
 public:
 
     static constexpr size_t MAX_QUIC_VERSIONS{30};  // limit memory usage
 
+    learned_version_table learned_versions;
+
     quic_parameters() {
 
         quic_initial_params.reserve(MAX_QUIC_VERSIONS);
@@ -823,13 +966,12 @@ public:
             {1889161412, {salt_enum::D1_D7_V2, init_pkt_mask_enum::V2, hkdf_label_enum::V2}},        // draft1_draft7-v2
             {1798521807, {salt_enum::V2, init_pkt_mask_enum::V2, hkdf_label_enum::V2}},              // version-2
         };
-    }
 
-    void add_param_mapping(uint32_t version, const std::tuple<quic_parameters::salt_enum, quic_parameters::init_pkt_mask_enum, quic_parameters::hkdf_label_enum> param) {
-        if (quic_initial_params.size() > MAX_QUIC_VERSIONS) {
-            return;
+        for (const auto &p : quic_initial_params) {
+            candidate_params.push_back(p.second);
         }
-        quic_initial_params.emplace(version, param);
+        std::sort(candidate_params.begin(), candidate_params.end());
+        candidate_params.erase(std::unique(candidate_params.begin(), candidate_params.end()), candidate_params.end());
     }
 
     const quic_parameters::salt *get_initial_salt(salt_enum salt_num) {
@@ -853,7 +995,7 @@ public:
         }
     }
 
-    const std::unordered_map<uint32_t, const std::tuple<salt_enum, init_pkt_mask_enum, hkdf_label_enum> > &get_params_map() {return quic_initial_params;}
+    const std::vector<initial_params> &get_candidate_params() const { return candidate_params; }
 
     static quic_parameters &create() {
         static quic_parameters quic_params;
@@ -861,10 +1003,78 @@ public:
     }
 };
 
+// class quic_initial_key_cache holds the most recently derived initial
+// keys, so that the HMAC and HKDF computations are not repeated for
+// retransmissions, or for coalesced or split Initial packets, that
+// carry the same destination connection ID.  It is not thread safe;
+// each quic_crypto_engine has its own.
+//
+class quic_initial_key_cache {
+public:
+
+    struct keys {
+        uint8_t key[16];
+        uint8_t iv[12];
+        uint8_t hp[16];
+    };
+
+    static constexpr size_t num_entries = 16;
+    static constexpr size_t max_dcid_length = 20;
+
+    // find() returns the keys for the parameters identified by
+    // params_id and the connection ID dcid, if they are in the cache,
+    // and nullptr otherwise
+    //
+    const keys *find(uint32_t params_id, const datum &dcid) const {
+        size_t length = dcid.length();
+        for (const entry &e : entries) {
+            if (e.dcid_length == length && e.params_id == params_id && e.valid && (length == 0 || memcmp(e.dcid, dcid.data, length) == 0)) {
+                return &e.k;
+            }
+        }
+        return nullptr;
+    }
+
+    // insert() stores the keys k for params_id and dcid, replacing the
+    // oldest entry, unless dcid is too long to be cached.  Only keys
+    // that were successfully derived should be inserted.
+    //
+    void insert(uint32_t params_id, const datum &dcid, const keys &k) {
+        size_t length = dcid.length();
+        if (length > max_dcid_length) {
+            return;
+        }
+        entry &e = entries[next];
+        next = (next + 1) % num_entries;
+        e.valid = true;
+        e.params_id = params_id;
+        e.dcid_length = length;
+        if (length) {
+            memcpy(e.dcid, dcid.data, length);
+        }
+        e.k = k;
+    }
+
+private:
+
+    struct entry {
+        bool valid = false;
+        uint32_t params_id = 0;
+        size_t dcid_length = 0;
+        uint8_t dcid[max_dcid_length];
+        keys k;
+    };
+
+    std::array<entry, num_entries> entries;
+    size_t next = 0;
+};
+
 class quic_crypto_engine {
 
     crypto_engine core_crypto;
 
+    quic_initial_key_cache key_cache;
+
     size_t salt_length = 20;
 
     uint8_t quic_key[EVP_MAX_MD_SIZE] = {0};
@@ -893,7 +1103,21 @@ public:
         data_buffer<1024> aad;
         uint32_t version = ntoh(*((uint32_t*)quic_pkt.version.data));
         static quic_parameters &quic_params = quic_parameters::create();  // initialize on first use
-        const std::tuple<quic_parameters::salt_enum, quic_parameters::init_pkt_mask_enum, quic_parameters::hkdf_label_enum> *params = quic_params.get_initial_params(version);
+        const quic_parameters::initial_params *params = quic_params.get_initial_params(version);
+
+        // a version that is not in the built-in table may have been
+        // learned, or may have failed with every salt recently
+        //
+        quic_parameters::initial_params learned_params;
+        if (params == nullptr) {
+            learned_version_table::result learned = quic_params.learned_versions.lookup(version);
+            if (learned.status == learned_version_table::status::learned) {
+                learned_params = quic_parameters::decode(learned.value);
+                params = &learned_params;
+            } else if (learned.status == learned_version_table::status::failed) {
+                return {nullptr, nullptr};
+            }
+        }
 
         if (params) {
             const quic_parameters::salt *initial_salt = quic_params.get_initial_salt(std::get<0>(*params));
@@ -907,58 +1131,34 @@ public:
                 }
             }
 
-            const uint8_t *client_in_label = (quic_params.get_kdf(std::get<2>(*params))->get_client_label());
-            const uint8_t *quic_key_label  = (quic_params.get_kdf(std::get<2>(*params))->get_key_label());
-            const uint8_t *quic_iv_label   = (quic_params.get_kdf(std::get<2>(*params))->get_iv_label());
-            const uint8_t *quic_hp_label   = (quic_params.get_kdf(std::get<2>(*params))->get_hp_label());
-            const unsigned int client_in_label_size = (quic_params.get_kdf(std::get<2>(*params))->get_client_label_size());
-            const unsigned int quic_key_label_size  = (quic_params.get_kdf(std::get<2>(*params))->get_key_label_size());
-            const unsigned int quic_iv_label_size   = (quic_params.get_kdf(std::get<2>(*params))->get_iv_label_size());
-            const unsigned int quic_hp_label_size   = (quic_params.get_kdf(std::get<2>(*params))->get_hp_label_size());
-
-            if (initial_salt) {
-                salt_str = initial_salt->get_name();
-                if (process_initial_packet(aad, quic_pkt, initial_salt->data(), client_in_label, quic_key_label, quic_iv_label, quic_hp_label,
-                                            client_in_label_size, quic_key_label_size, quic_iv_label_size, quic_hp_label_size) == false) {
-                    return {nullptr, nullptr};
-                }
-                decrypt__(aad.buffer, aad.readable_length(),
-                      quic_pkt.payload.data, quic_pkt.payload.length());
-                return {plaintext, plaintext+plaintext_len};
+            salt_str = initial_salt->get_name();
+            if (process_initial_packet(aad, quic_pkt, *params) == false) {
+                return {nullptr, nullptr};
             }
-            return {nullptr, nullptr}; 
+            decrypt__(aad.buffer, aad.readable_length(),
+                      quic_pkt.payload.data, quic_pkt.payload.length());
+            return {plaintext, plaintext+plaintext_len};
         }
-        else {
-            // try every salt to decrypt, most likely a version negotiation pkt
-            for (auto params : quic_params.get_params_map()) {
-                const std::tuple<quic_parameters::salt_enum, quic_parameters::init_pkt_mask_enum, quic_parameters::hkdf_label_enum> param = params.second; 
-                const quic_parameters::salt *initial_salt = quic_params.get_initial_salt(std::get<0>(param));
-                const uint8_t *client_in_label = (quic_params.get_kdf(std::get<2>(param))->get_client_label());
-                const uint8_t *quic_key_label  = (quic_params.get_kdf(std::get<2>(param))->get_key_label());
-                const uint8_t *quic_iv_label   = (quic_params.get_kdf(std::get<2>(param))->get_iv_label());
-                const uint8_t *quic_hp_label   = (quic_params.get_kdf(std::get<2>(param))->get_hp_label());
-                const unsigned int client_in_label_size = (quic_params.get_kdf(std::get<2>(param))->get_client_label_size());
-                const unsigned int quic_key_label_size  = (quic_params.get_kdf(std::get<2>(param))->get_key_label_size());
-                const unsigned int quic_iv_label_size   = (quic_params.get_kdf(std::get<2>(param))->get_iv_label_size());
-                const unsigned int quic_hp_label_size   = (quic_params.get_kdf(std::get<2>(param))->get_hp_label_size());
-                if (process_initial_packet(aad, quic_pkt, initial_salt->data(), client_in_label, quic_key_label, quic_iv_label, quic_hp_label,
-                                        client_in_label_size, quic_key_label_size, quic_iv_label_size, quic_hp_label_size) == false) {
-                    reset_buffers();
-                    continue;
-                }
-                decrypt__(aad.buffer, aad.readable_length(),
-                  quic_pkt.payload.data, quic_pkt.payload.length());
-
-                if (plaintext_len) {
-                    //salt_str = quic_params.salts[i].get_name();
-                    salt_str = initial_salt->get_name();
-                    quic_params.add_param_mapping(version, param);
-                    return {plaintext, plaintext+plaintext_len};
-                }
+
+        // try every salt to decrypt, most likely a version negotiation pkt
+        //
+        for (const quic_parameters::initial_params &param : quic_params.get_candidate_params()) {
+            if (process_initial_packet(aad, quic_pkt, param) == false) {
+                reset_buffers();
                 aad.reset();
+                continue;
             }
-            return {nullptr, nullptr};
+            decrypt__(aad.buffer, aad.readable_length(),
+                      quic_pkt.payload.data, quic_pkt.payload.length());
+
+            if (plaintext_len) {
+                salt_str = quic_params.get_initial_salt(std::get<0>(param))->get_name();
+                quic_params.learned_versions.learn(version, quic_parameters::encode(param));
+                return {plaintext, plaintext+plaintext_len};
+            }
+            aad.reset();
         }
+        quic_params.learned_versions.fail(version);
         return {nullptr, nullptr};
     }
 
@@ -966,28 +1166,71 @@ public:
         record.print_key_string("salt_string", salt_str);
     }
 
+    // get_initial_keys() sets k to the client initial keys for the
+    // parameters param and the connection ID dcid, in the same way as
+    // for an Initial packet, and returns true on success
+    //
+    bool get_initial_keys(const quic_parameters::initial_params &param, const datum &dcid, quic_initial_key_cache::keys &k) {
+        if (!set_initial_keys(param, dcid)) {
+            return false;
+        }
+        memcpy(k.key, quic_key, sizeof(k.key));
+        memcpy(k.iv, quic_iv, sizeof(k.iv));
+        memcpy(k.hp, quic_hp, sizeof(k.hp));
+        return true;
+    }
+
+    const quic_initial_key_cache &get_key_cache() const { return key_cache; }
+
 private:
 
-    //bool process_initial_packet(data_buffer<1024> &aad, const quic_initial_packet &quic_pkt, const uint8_t* salt) {
-    bool process_initial_packet(data_buffer<1024> &aad, const quic_initial_packet &quic_pkt, const uint8_t* salt,
-                            const uint8_t *client_in_label, const uint8_t *quic_key_label, const uint8_t *quic_iv_label, const uint8_t *quic_hp_label,
-                            const unsigned int client_in_label_size, const unsigned int quic_key_label_size, const unsigned int quic_iv_label_size, const unsigned int quic_hp_label_size) {
+    // set_initial_keys() sets quic_key, quic_iv, and quic_hp to the
+    // client initial keys for the parameters param and the connection
+    // ID dcid (RFC 9001, Section 5.2), from key_cache if possible.  It
+    // returns true on success, and false if the keys could not be
+    // derived, in which case nothing is cached.
+    //
+    bool set_initial_keys(const quic_parameters::initial_params &param, const datum &dcid) {
+        static quic_parameters &quic_params = quic_parameters::create();  // initialize on first use
+
+        uint32_t params_id = quic_parameters::encode(param);
+        const quic_initial_key_cache::keys *k = key_cache.find(params_id, dcid);
+        quic_initial_key_cache::keys new_keys;
+        if (k == nullptr) {
+            const quic_parameters::kdf_label *labels = quic_params.get_kdf(std::get<2>(param));
+            const uint8_t *salt = quic_params.get_initial_salt(std::get<0>(param))->data();
+
+            uint8_t initial_secret[EVP_MAX_MD_SIZE];
+            unsigned int initial_secret_len = 0;
+            uint8_t c_initial_secret[EVP_MAX_MD_SIZE] = {0};
+            unsigned int c_initial_secret_len = 0;
+            unsigned int len = 0;
+            if (!core_crypto.hmac_sha256(salt, salt_length, dcid.data, dcid.length(), initial_secret, &initial_secret_len)
+                || !core_crypto.kdf_tls13(initial_secret, initial_secret_len, labels->get_client_label(), labels->get_client_label_size()-1, 32, c_initial_secret, &c_initial_secret_len)
+                || !core_crypto.kdf_tls13(c_initial_secret, c_initial_secret_len, labels->get_key_label(), labels->get_key_label_size()-1, sizeof(new_keys.key), new_keys.key, &len)
+                || !core_crypto.kdf_tls13(c_initial_secret, c_initial_secret_len, labels->get_iv_label(), labels->get_iv_label_size()-1, sizeof(new_keys.iv), new_keys.iv, &len)
+                || !core_crypto.kdf_tls13(c_initial_secret, c_initial_secret_len, labels->get_hp_label(), labels->get_hp_label_size()-1, sizeof(new_keys.hp), new_keys.hp, &len)) {
+                return false;
+            }
+            key_cache.insert(params_id, dcid, new_keys);
+            k = &new_keys;
+        }
+        memcpy(quic_key, k->key, sizeof(k->key));
+        quic_key_len = sizeof(k->key);
+        memcpy(quic_iv, k->iv, sizeof(k->iv));
+        quic_iv_len = sizeof(k->iv);
+        memcpy(quic_hp, k->hp, sizeof(k->hp));
+        quic_hp_len = sizeof(k->hp);
+        return true;
+    }
+
+    bool process_initial_packet(data_buffer<1024> &aad, const quic_initial_packet &quic_pkt, const quic_parameters::initial_params &param) {
         if (!quic_pkt.is_not_empty()) {
             return false;
         }
-        const uint8_t *dcid = quic_pkt.dcid.data;
-        size_t dcid_len = quic_pkt.dcid.length();
-
-        uint8_t initial_secret[EVP_MAX_MD_SIZE];
-        unsigned int initial_secret_len = 0;
-        HMAC(EVP_sha256(), salt, salt_length, dcid, dcid_len, initial_secret, &initial_secret_len);
-
-        uint8_t c_initial_secret[EVP_MAX_MD_SIZE] = {0};
-        unsigned int c_initial_secret_len = 0;
-        core_crypto.kdf_tls13(initial_secret, initial_secret_len, client_in_label, client_in_label_size-1, 32, c_initial_secret, &c_initial_secret_len);
-        core_crypto.kdf_tls13(c_initial_secret, c_initial_secret_len, quic_key_label, quic_key_label_size-1, 16, quic_key, &quic_key_len);
-        core_crypto.kdf_tls13(c_initial_secret, c_initial_secret_len, quic_iv_label, quic_iv_label_size-1, 12, quic_iv, &quic_iv_len);
-        core_crypto.kdf_tls13(c_initial_secret, c_initial_secret_len, quic_hp_label, quic_hp_label_size-1, 16, quic_hp, &quic_hp_len);
+        if (!set_initial_keys(param, quic_pkt.dcid)) {
+            return false;
+        }
 
         // remove header protection (RFC9001, Section 5.4.1)
         //
@@ -1414,6 +1657,14 @@ public:
         }
     }
 
+    datum get_server_name() const {
+        struct datum sn{NULL, NULL};
+        struct datum user_agent {NULL, NULL};
+        datum alpn;
+        hello.extensions.set_meta_data(sn, user_agent, alpn);
+        return sn;
+    }
+
     bool do_analysis(const struct key &k_, struct analysis_context &analysis_, classifier *c_) {
         struct datum sn{NULL, NULL};
         struct datum user_agent {NULL, NULL};
@@ -1596,6 +1847,17 @@ public:
         }
     }
 
+    datum get_server_name() const {
+        if (pre_decrypted) {
+            return decry_pkt.get_server_name();
+        }
+        struct datum sn{NULL, NULL};
+        struct datum user_agent {NULL, NULL};
+        datum alpn;
+        hello.extensions.set_meta_data(sn, user_agent, alpn);
+        return sn;
+    }
+
     bool do_analysis(const struct key &k_, struct analysis_context &analysis_, classifier *c_) {
         if(pre_decrypted) {
             return decry_pkt.do_analysis(k_, analysis_, c_);
@@ -0,0 +1,235 @@
+/*
+ * record_suppressor.hpp
+ *
+ * bounded suppression of repeated, identical JSON records
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#ifndef RECORD_SUPPRESSOR_HPP
+#define RECORD_SUPPRESSOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+#include "json_object.h"
+#include "tcp.h"         // for std::hash<struct key>
+
+void write_flow_key(struct json_object &o, const struct key &k);   // defined in pkt_proc.cc
+
+// record_suppressor suppresses the JSON records that repeat an
+// earlier record, such as those written when the same client sends
+// the same TLS, QUIC, or HTTP message to the same server many times.
+// Two records are repeats if they have the same source address,
+// destination address and port, transport protocol, and protocol
+// type, and the same fingerprint and server name (the TLS or QUIC
+// server_name, or the HTTP host).  The rest of their content, such as
+// the metadata written with --metadata, may differ.  Records without
+// a fingerprint, such as DNS responses, are repeats only if the rest
+// of their content (but not the source port, timestamp, or IP header
+// metadata) is identical.
+//
+// The first record of each kind is written as usual, and an entry for
+// it is kept in a cache; later repeats of it are counted, but not
+// written.  An entry is retired when it has been in the cache for
+// timeout seconds, or when it is the oldest entry and the cache is
+// full; when an entry with repeats is retired, a summary record is
+// written after the next record (or in place of it, if that record is
+// suppressed).  A summary holds the content and flow key of the first
+// record, with a "repeats" object that holds the number of suppressed
+// repeats and the event_start times of the first record and of the
+// last repeat.  After an entry is retired, the next repeat is written
+// in full, and starts a new entry.  Entries are expired as records
+// are observed, and by expire(), which should be called when no
+// packets are arriving, so that summaries are not held back
+// indefinitely.  If summaries cannot be written as quickly as
+// entries are retired, at most max_entries of them are held; any
+// more are dropped, and counted as such.
+//
+// Each packet processor has its own suppressor, so the cache needs
+// no locking, but a repeat is only suppressed if it is processed by
+// the same thread as the first record.  The memory used is bounded by
+// 2 * max_entries entries, each of which holds at most
+// 2 * max_content_length bytes; larger records are never suppressed.
+//
+class record_suppressor {
+public:
+
+    static constexpr size_t max_content_length = 4096;
+    static constexpr unsigned int default_timeout = 300;  // seconds
+
+    struct counts {
+        uint64_t suppressed = 0;   // records not written
+        uint64_t summaries = 0;    // summary records written
+        uint64_t dropped = 0;      // summary records discarded
+    };
+
+private:
+
+    struct entry {
+        struct key flow;           // flow key of the first record
+        size_t protocol;           // protocol type index
+        std::string identity;      // fingerprint, or content if there is none
+        std::string server_name;
+        std::string content;       // content of the first record, without the opening brace
+        size_t hash;
+        struct timespec first;
+        struct timespec last;
+        uint64_t repeats;
+    };
+
+    std::list<entry> entries;      // in order of first record
+    std::list<entry> retired;      // entries with repeats, awaiting their summaries
+    std::unordered_map<size_t, std::list<entry>::iterator> index;
+    size_t max_entries;
+    unsigned int timeout;
+    struct counts count;
+
+    static constexpr size_t max_expirations_per_record = 4;
+
+    static struct key without_src_port(const struct key &k) {
+        struct key tmp{k};
+        tmp.src_port = 0;
+        return tmp;
+    }
+
+    void retire(std::list<entry>::iterator it) {
+        index.erase(it->hash);
+        if (it->repeats == 0) {
+            entries.erase(it);
+            return;
+        }
+        retired.splice(retired.end(), entries, it);
+        if (retired.size() > max_entries) {
+            retired.pop_front();    // bounds memory if summaries cannot be written
+            count.dropped++;
+        }
+    }
+
+    void expire(time_t sec, size_t max_expirations) {
+        for (size_t i = 0; i < max_expirations && !entries.empty(); i++) {
+            if (sec - entries.front().first.tv_sec < (time_t)timeout) {
+                break;
+            }
+            retire(entries.begin());
+        }
+    }
+
+    static void write_summary(struct buffer_stream &buf, entry &e) {
+        struct json_object record{&buf};
+        buf.memcpy(e.content.data(), e.content.length());
+        record.comma = !e.content.empty();
+        struct json_object repeats{record, "repeats"};
+        repeats.print_key_uint("count", e.repeats);
+        repeats.print_key_timestamp("first_event_start", &e.first);
+        repeats.print_key_timestamp("last_event_start", &e.last);
+        repeats.close();
+        write_flow_key(record, e.flow);
+        record.print_key_timestamp("event_start", &e.last);
+        record.close();
+        buf.write_char('\n');
+    }
+
+public:
+
+    record_suppressor(size_t max_entries_, unsigned int timeout_) :
+        max_entries{max_entries_ ? max_entries_ : 1},
+        timeout{timeout_ ? timeout_ : default_timeout} {
+        index.reserve(max_entries);
+    }
+
+    // observe() processes a record with flow key k, protocol type
+    // index protocol, fingerprint string fingerprint (empty if there
+    // is none), and server name server_name, whose content (without
+    // the opening brace, flow key, event_start, or IP header metadata)
+    // is content, and returns true if the record should be suppressed
+    //
+    bool observe(const struct key &k,
+                 size_t protocol,
+                 std::string_view fingerprint,
+                 std::string_view server_name,
+                 std::string_view content,
+                 const struct timespec &ts) {
+        expire(ts.tv_sec, max_expirations_per_record);
+        std::string_view identity = fingerprint.empty() ? content : fingerprint;
+        if (content.length() > max_content_length
+            || identity.length() + server_name.length() > max_content_length) {
+            return false;
+        }
+        struct key flow = without_src_port(k);
+        size_t hash = std::hash<struct key>{}(flow)
+            ^ (std::hash<std::string_view>{}(identity) * 0x9e3779b97f4a7c15)
+            ^ (std::hash<std::string_view>{}(server_name) * 0xc2b2ae3d27d4eb4f)
+            ^ (protocol * 0x165667b19e3779f9);
+        auto it = index.find(hash);
+        if (it != index.end()) {
+            entry &e = *it->second;
+            if (without_src_port(e.flow) == flow
+                && e.protocol == protocol
+                && e.identity == identity
+                && e.server_name == server_name) {
+                e.repeats++;
+                e.last = ts;
+                count.suppressed++;
+                return true;
+            }
+            return false;   // hash collision; the record is written, but not cached
+        }
+        if (entries.size() >= max_entries) {
+            retire(entries.begin());
+        }
+        entries.push_back({ k, protocol, std::string{identity}, std::string{server_name}, std::string{content}, hash, ts, ts, 0 });
+        index.emplace(hash, std::prev(entries.end()));
+        return false;
+    }
+
+    // write_summaries() writes summary records for retired entries
+    // into buf, as many as fit, each as a line of JSON; a summary that
+    // does not fit into an empty buffer is discarded
+    //
+    void write_summaries(struct buffer_stream &buf) {
+        while (!retired.empty() && buf.trunc == 0) {
+            int offset = buf.doff;
+            write_summary(buf, retired.front());
+            if (buf.trunc) {
+                buf.doff = offset;
+                buf.trunc = 0;
+                if (offset != 0) {
+                    break;
+                }
+                count.dropped++;
+            } else {
+                count.summaries++;
+            }
+            retired.pop_front();
+        }
+    }
+
+    // expire() retires all of the entries that have been in the cache
+    // for timeout seconds at the time ts, so that write_summaries()
+    // writes their summaries even if no more records are observed
+    //
+    void expire(const struct timespec &ts) {
+        expire(ts.tv_sec, SIZE_MAX);
+    }
+
+    // retire_all() retires all of the entries in the cache, so that
+    // write_summaries() writes the summaries of all of the records
+    // that have been suppressed
+    //
+    void retire_all() {
+        while (!entries.empty()) {
+            retire(entries.begin());
+        }
+    }
+
+    bool has_summaries() const { return !retired.empty(); }
+
+    const struct counts &get_counts() const { return count; }
+
+};
+
+#endif // RECORD_SUPPRESSOR_HPP
@@ -9,6 +9,7 @@
 #define RESULT_H
 
 #include <stdbool.h>
+#include <string_view>
 // #include <bits/stdc++.h>  // TODO: ???
 #include "libmerc.h"
 #include "json_object.h"
@@ -20,6 +21,9 @@ uint16_t flow_key_get_dst_port(const struct key &key);
 void flow_key_sprintf_dst_addr(const struct key &key,
                                char *dst_addr_str);
 
+uint8_t flow_key_get_dst_addr(const struct key &key,
+                              uint8_t *dst_addr);
+
 
 #define max_proc_len 256
 
@@ -159,6 +163,12 @@ struct analysis_result {
     // does not require classification to succeed
     attribute_result attr;
 
+    // the nearest known fingerprint and its similarity, for
+    // fingerprints that are not in the fingerprint database, if the
+    // classifier has a nearest-fingerprint index
+    std::string_view nearest{};
+    double nearest_similarity = 0.0;
+
 public:
     analysis_result() : status{fingerprint_status_no_info_available}, max_proc{'\0'}, max_score{0.0}, max_mal{false}, malware_prob{-1.0}, classify_malware{false},
                         os_info{NULL}, os_info_len{0}, attr{} { }
@@ -219,6 +229,12 @@ public:
         } else {
             analysis.print_key_string("status", "unknown");
         }
+        if (!nearest.empty()) {
+            struct json_object nearest_json{analysis, "nearest"};
+            nearest_json.print_key_json_string("fingerprint", (const uint8_t *)nearest.data(), nearest.length());
+            nearest_json.print_key_float("similarity", nearest_similarity);
+            nearest_json.close();
+        }
         analysis.close();
     }
 
@@ -231,6 +247,7 @@ public:
         max_proc[0] = '\0';
         os_info = NULL;
         classify_malware = false;
+        nearest = {};
     }
 
     bool get_process_info(const char **probable_process,     // output
@@ -282,18 +299,21 @@ public:
 
 struct destination_context {
     char dst_ip_str[MAX_DST_ADDR_LEN];
+    uint8_t dst_addr[16];       // dst_ip_str in network byte order
+    uint8_t dst_ip_vers;        // 4 or 6, or 0 if dst_addr is not set
     char sn_str[MAX_SNI_LEN];
     char ua_str[MAX_USER_AGENT_LEN];
     uint8_t alpn_array[MAX_ALPN_STR_LEN];
     size_t alpn_length;
     uint16_t dst_port;
 
-    destination_context() : dst_port{0} {}
+    destination_context() : dst_ip_vers{0}, dst_port{0} {}
 
     void init(struct datum domain, struct datum user_agent, datum alpn, const struct key &key) {
         user_agent.strncpy(ua_str, MAX_USER_AGENT_LEN);
         domain.strncpy(sn_str, MAX_SNI_LEN);
         flow_key_sprintf_dst_addr(key, dst_ip_str);
+        dst_ip_vers = flow_key_get_dst_addr(key, dst_addr);
         dst_port = ntoh(flow_key_get_dst_port(key));  // note: byte order conversion needed
 
         alpn.write_to_buffer(alpn_array, sizeof(alpn_array));
@@ -309,6 +329,7 @@ struct destination_context {
         user_agent_built.strncpy(ua_str, MAX_USER_AGENT_LEN);
         domain.strncpy(sn_str, MAX_SNI_LEN);
         flow_key_sprintf_dst_addr(key, dst_ip_str);
+        dst_ip_vers = flow_key_get_dst_addr(key, dst_addr);
         dst_port = ntoh(flow_key_get_dst_port(key));  // note: byte order conversion needed
 
         alpn.write_to_buffer(alpn_array, sizeof(alpn_array));
@@ -18,9 +18,12 @@
 #include <atomic>
 #include <zlib.h>
 #include <functional>
+#include <memory>
+#include <cinttypes>
 
 #include "dict.h"
 #include "queue.h"
+#include "stats_sketch.hpp"
 
 // class event_processor_gz coverts a sequence of sorted event
 // strings into an alternative JSON representation
@@ -174,9 +177,235 @@ struct hash_tuple {
     }
 };
 
+// class approximate_stats_aggregator gathers statistics about the
+// same (source, fingerprint, user agent, destination) events as
+// stats_aggregator, but within a fixed memory budget, rather than by
+// storing their full cross product.  For each fingerprint, it keeps
+// a space-saving summary of the most frequent user agents, each with
+// a space-saving summary of its most frequent destinations, and a
+// HyperLogLog estimate of the number of distinct source addresses.
+// The fingerprints themselves form a space-saving summary whose size
+// is set by the memory budget: when the budget is exhausted, the
+// fingerprints with the smallest counts are evicted, so that heavy
+// hitters are retained no matter how many rare events arrive.
+//
+// All counts are overestimates, and every (fingerprint, user agent,
+// destination) whose true count exceeds the smallest count at its
+// level of the summary is reported.  The memory that is accounted
+// for includes the strings, the counters, and the hash table nodes,
+// but not allocator overhead.
+//
+class approximate_stats_aggregator {
+public:
+    static constexpr size_t user_agents_per_fingerprint = 4;
+    static constexpr size_t destinations_per_user_agent = 16;
+    static constexpr unsigned int source_estimator_precision = 10;  // 1 KiB, ~3% error
+    static constexpr size_t min_memory_limit = 64 * 1024;
+
+private:
+    struct no_value { };
+
+    struct user_agent_value {
+        space_saving<no_value> destinations{destinations_per_user_agent};
+        size_t bytes = 0;   // total length of destination strings
+    };
+
+    struct fingerprint_entry {
+        uint64_t count = 0;
+        uint64_t error = 0;
+        hyperloglog<source_estimator_precision> sources;
+        space_saving<user_agent_value> user_agents{user_agents_per_fingerprint};
+        size_t bytes = 0;   // memory accounted to this fingerprint
+    };
+
+    using fingerprint_table = std::unordered_map<std::string, fingerprint_entry>;
+
+    static constexpr size_t fingerprint_cost =
+        sizeof(fingerprint_table::value_type) + 2 * sizeof(void *)   // hash table node and bucket
+        + user_agents_per_fingerprint * sizeof(space_saving<user_agent_value>::counter);
+
+    static constexpr size_t user_agent_cost =
+        destinations_per_user_agent * sizeof(space_saving<no_value>::counter);
+
+    fingerprint_table fingerprints;
+    size_t memory_limit;
+    size_t memory_used = 0;
+    uint64_t floor = 0;             // largest count of an evicted fingerprint
+    uint64_t fingerprint_evictions = 0;
+    uint64_t drops = 0;
+
+    // preallocated temporary variables for evicted counters
+    std::string evicted_key;
+    user_agent_value evicted_user_agent;
+    no_value evicted_destination;
+
+    // evict() removes the fingerprints with the smallest counts,
+    // other than keep, until there are at least needed bytes free
+    // below a low-water mark, so that evictions happen in batches
+    //
+    void evict(size_t needed, fingerprint_table::const_iterator keep) {
+        size_t target = memory_limit - memory_limit / 16;
+        target = (needed < target) ? target - needed : 0;
+        std::vector<fingerprint_table::const_iterator> v;
+        v.reserve(fingerprints.size());
+        for (auto it = fingerprints.cbegin(); it != fingerprints.cend(); ++it) {
+            if (it != keep) {
+                v.push_back(it);
+            }
+        }
+        std::sort(v.begin(), v.end(), [](const auto &l, const auto &r) {
+            return l->second.count < r->second.count;
+        });
+        for (const auto &it : v) {
+            if (memory_used <= target) {
+                break;
+            }
+            floor = std::max(floor, it->second.count);
+            memory_used -= it->second.bytes;
+            fingerprints.erase(it);
+            ++fingerprint_evictions;
+        }
+    }
+
+public:
+
+    approximate_stats_aggregator(size_t limit) : memory_limit{std::max(limit, min_memory_limit)} { }
+
+    void observe(const event_msg &event) {
+        const std::string &src_ip = std::get<0>(event);
+        const std::string &fp = std::get<1>(event);
+        const std::string &ua = std::get<2>(event);
+        const std::string &dst = std::get<3>(event);
+
+        auto it = fingerprints.find(fp);
+        if (it == fingerprints.end()) {
+            size_t cost = fingerprint_cost + fp.size();
+            if (memory_used + cost > memory_limit) {
+                evict(cost, fingerprints.cend());
+                if (memory_used + cost > memory_limit) {
+                    ++drops;
+                    return;
+                }
+            }
+            it = fingerprints.emplace(fp, fingerprint_entry{}).first;
+            it->second.count = it->second.error = floor;
+            it->second.user_agents.set_floor(floor);
+            it->second.bytes = cost;
+            memory_used += cost;
+        }
+        fingerprint_entry &entry = it->second;
+        size_t old_bytes = entry.bytes;
+        entry.count++;
+        entry.sources.add(sketch_hash(src_ip));
+
+        bool replaced;
+        auto &u = entry.user_agents.observe(ua, sketch_hash(ua), replaced, evicted_key, evicted_user_agent);
+        if (replaced) {
+            entry.bytes = entry.bytes + ua.size() - evicted_key.size() - evicted_user_agent.bytes;
+        } else if (u.count - u.error == 1) {
+            entry.bytes += ua.size() + user_agent_cost;
+        }
+        if (u.count - u.error == 1) {
+            u.value.destinations.set_floor(u.error);  // keep destination counts as overestimates
+        }
+
+        auto &d = u.value.destinations.observe(dst, sketch_hash(dst), replaced, evicted_key, evicted_destination);
+        if (replaced) {
+            u.value.bytes = u.value.bytes + dst.size() - evicted_key.size();
+            entry.bytes = entry.bytes + dst.size() - evicted_key.size();
+        } else if (d.count - d.error == 1) {
+            u.value.bytes += dst.size();
+            entry.bytes += dst.size();
+        }
+
+        memory_used = memory_used + entry.bytes - old_bytes;
+        if (memory_used > memory_limit) {
+            evict(0, it);
+        }
+    }
+
+    bool is_empty() const { return fingerprints.size() == 0; }
+
+    size_t get_num_entries() const { return fingerprints.size(); }
+
+    // gzprint() writes one JSON line per fingerprint, in the same
+    // schema as stats_aggregator, with "approximate":true, a src_ip
+    // of "*" because sources are not tracked individually, and the
+    // fingerprint's total count and estimated number of distinct
+    // sources; it then clears all of the summaries
+    //
+    void gzprint(gzFile f, const char *version,
+                 const char *resource_version,
+                 const char *git_commit_id,
+                 uint32_t git_count,
+                 const char *init_time,
+                 std::atomic<bool> &interrupt) {
+
+        if (fingerprints.size() == 0) {
+            return;  // nothing to report
+        }
+        if (drops || fingerprint_evictions) {
+            printf_err(log_info, "approximate stats: %" PRIu64 " fingerprints evicted, %" PRIu64 " events dropped\n",
+                       fingerprint_evictions, drops);
+        }
+
+        std::vector<fingerprint_table::const_iterator> v;
+        v.reserve(fingerprints.size());
+        for (auto it = fingerprints.cbegin(); it != fingerprints.cend(); ++it) {
+            v.push_back(it);
+        }
+        std::sort(v.begin(), v.end(), [](const auto &l, const auto &r) {
+            return l->second.count > r->second.count || (l->second.count == r->second.count && l->first < r->first);
+        });
+
+        for (const auto &it : v) {
+            if (interrupt.load() == true) {
+                clear();
+                throw std::runtime_error("error: stats dump interrupted");
+            }
+            const fingerprint_entry &entry = it->second;
+            bool ok = gzprintf(f, "{\"src_ip\":\"*\", \"approximate\":true, \"libmerc_init_time\" : \"%s\",\"libmerc_version\": \"%s\","
+                                  " \"resource_version\" : \"%s\", \"build_number\" : \"%u\", \"git_commit_id\": \"%s\", \"fingerprints\":[{\"str_repr\":\"",
+                                  init_time, version, resource_version, git_count, git_commit_id) > 0;
+            ok &= gzputs(f, it->first.c_str()) >= 0;
+            ok &= gzprintf(f, "\", \"count\":%" PRIu64 ", \"src_ip_count\":%.0f, \"sessions\": [",
+                              entry.count, entry.sources.estimate()) > 0;
+            bool first_session = true;
+            for (const auto *u : entry.user_agents.sorted()) {
+                char user_agent[MAX_USER_AGENT_LEN + 15]{"\0"};
+                if (u->key[0] != '\0') {
+                    snprintf(user_agent, MAX_USER_AGENT_LEN - 1, "\"user_agent\":\"%s\", ", u->key.c_str());
+                }
+                ok &= gzprintf(f, "%s{%s\"dest_info\":[", first_session ? "" : ",", user_agent) > 0;
+                first_session = false;
+                bool first_dst = true;
+                for (const auto *d : u->value.destinations.sorted()) {
+                    ok &= gzprintf(f, "%s{\"dst\":\"%s\",\"count\":%" PRIu64 "}", first_dst ? "" : ",", d->key.c_str(), d->count) > 0;
+                    first_dst = false;
+                }
+                ok &= gzprintf(f, "]}") > 0;
+            }
+            ok &= gzprintf(f, "]}]}\n") > 0;
+            if (!ok) {
+                throw std::runtime_error("error in gzprintf");
+            }
+        }
+        clear();
+    }
+
+    void clear() {
+        fingerprints.clear();
+        memory_used = 0;
+        floor = 0;
+        fingerprint_evictions = 0;
+        drops = 0;
+    }
+};
+
 // class stats_aggregator manages all of the data needed to gather and
 // report aggregate statistics about (fingerprint and destination)
-// events
+// events; if it is given a memory limit, it delegates to an
+// approximate_stats_aggregator instead of counting exactly
 //
 class stats_aggregator {
     std::unordered_map<event_msg, uint64_t, hash_tuple> event_table;
@@ -184,15 +413,27 @@ class stats_aggregator {
     std::string observation;  // used as preallocated temporary variable
     size_t num_entries;
     size_t max_entries;
+    std::unique_ptr<approximate_stats_aggregator> approx;
 
 public:
 
-    stats_aggregator(size_t size_limit) : event_table{}, encoder{}, observation{}, num_entries{0}, max_entries{size_limit} { }
+    stats_aggregator(size_t size_limit, size_t memory_limit=0) :
+        event_table{},
+        encoder{},
+        observation{},
+        num_entries{0},
+        max_entries{size_limit},
+        approx{memory_limit ? std::make_unique<approximate_stats_aggregator>(memory_limit) : nullptr} { }
 
     ~stats_aggregator() {  }
 
     void observe_event_string(event_msg &obs) {
 
+        if (approx) {
+            approx->observe(obs);
+            return;
+        }
+
         encoder.compress_event_string(obs);
 
         const auto entry = event_table.find(obs);
@@ -207,7 +448,7 @@ public:
         }
     }
 
-    bool is_empty() const { return event_table.size() == 0; }
+    bool is_empty() const { return approx ? approx->is_empty() : event_table.size() == 0; }
 
     void gzprint(gzFile f, const char *version,
                  const char *resource_version,
@@ -216,6 +457,11 @@ public:
                  const char *init_time,
                  std::atomic<bool> &interrupt ) {
 
+        if (approx) {
+            approx->gzprint(f, version, resource_version, git_commit_id, git_count, init_time, interrupt);
+            return;
+        }
+
         if (event_table.size() == 0) {
             return;  // nothing to report
         }
@@ -230,6 +476,18 @@ public:
         std::vector<std::pair<event_msg, uint64_t>> v(event_table.begin(), event_table.end());
         event_table.clear();
         num_entries = 0;
+
+        // decode the entries before sorting them, so that the records
+        // are written in order of source address, then fingerprint,
+        // user agent, and destination; stats files from different
+        // sensors or intervals can then be merged as streams
+        //
+        for (auto &entry : v) {
+            if (interrupt.load() == true) {
+                throw std::runtime_error("error: stats dump interrupted");
+            }
+            encoder.get_inverse(entry.first);
+        }
         std::sort(v.begin(), v.end(), [&interrupt](auto &l, auto &r){
             if (interrupt.load() == true) {
                 throw std::runtime_error("error: stats dump interrupted");
@@ -245,7 +503,6 @@ public:
                 ep.process_final();
                 throw std::runtime_error("error: stats dump interrupted");
             }
-            encoder.get_inverse(entry.first);
             ep.process_update(entry.first, entry.second, version, resource_version, git_commit_id, git_count, init_time);
         }
         ep.process_final();
@@ -259,7 +516,7 @@ public:
 
     size_t get_num_entries() const
     {
-        return num_entries;
+        return approx ? approx->get_num_entries() : num_entries;
     }
 };
 
@@ -345,7 +602,11 @@ class data_aggregator {
 
 public:
 
-    data_aggregator(size_t size_limit=0, bool blocking=false) : q{}, ag1{size_limit}, ag2{size_limit}, ag{&ag1}, shutdown_requested{false}, blocking{blocking}, consumer_sleep{1} {
+    // if memory_limit is nonzero, approximate statistics are
+    // gathered within that many bytes, which are split between the
+    // two stats_aggregators, and size_limit is ignored
+    //
+    data_aggregator(size_t size_limit=0, bool blocking=false, size_t memory_limit=0) : q{}, ag1{size_limit, memory_limit / 2}, ag2{size_limit, memory_limit / 2}, ag{&ag1}, shutdown_requested{false}, blocking{blocking}, consumer_sleep{1} {
         mercury_get_version_string(version, MAX_VERSION_STRING);
         start_processing();
         //fprintf(stderr, "note: constructing data_aggregator %p\n", (void *)this);
@@ -432,6 +693,19 @@ public:
         std::lock_guard m_guard{m};
         return ag->get_num_entries();
     }
+
+    // returns the number of events dropped because an event queue
+    // was full
+    //
+    uint64_t get_queue_drops()
+    {
+        std::lock_guard m_guard{m};
+        uint64_t drops = 0;
+        for (auto & qr : q) {
+            drops += qr->drops();
+        }
+        return drops;
+    }
 };
 
 #endif // STATS_H
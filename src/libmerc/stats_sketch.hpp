@@ -0,0 +1,196 @@
+/*
+ * stats_sketch.hpp
+ *
+ * fixed-size summaries for approximate statistics: space-saving
+ * heavy-hitter counters and HyperLogLog distinct-count estimators
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#ifndef STATS_SKETCH_HPP
+#define STATS_SKETCH_HPP
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+// sketch_hash() returns a 64-bit hash of a string whose bits are all
+// well mixed, as HyperLogLog requires; std::hash is not guaranteed to
+// be, so its output is passed through the splitmix64 finalizer
+//
+inline uint64_t sketch_hash(const std::string &s) {
+    uint64_t x = std::hash<std::string>{}(s);
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    x ^= x >> 31;
+    return x;
+}
+
+// class hyperloglog estimates the number of distinct values that
+// have been added to it, using 2^precision one-byte registers, with
+// a relative standard error of about 1.04 / sqrt(2^precision).  Small
+// cardinalities are estimated by linear counting, which is nearly
+// exact when there are many empty registers.
+//
+template <unsigned int precision>
+class hyperloglog {
+    static_assert(precision >= 4 && precision <= 16, "hyperloglog precision out of range");
+
+    static constexpr size_t num_registers = (size_t)1 << precision;
+
+    std::array<uint8_t, num_registers> registers{};
+
+public:
+
+    void add(uint64_t hash) {
+        size_t index = hash >> (64 - precision);
+        uint64_t w = (hash << precision) | ((uint64_t)1 << (precision - 1));  // bound rank
+        uint8_t rank = __builtin_clzll(w) + 1;
+        if (rank > registers[index]) {
+            registers[index] = rank;
+        }
+    }
+
+    double estimate() const {
+        constexpr double m = num_registers;
+        const double alpha = 0.7213 / (1.0 + 1.079 / m);
+        double sum = 0.0;
+        size_t zeros = 0;
+        for (uint8_t r : registers) {
+            sum += std::ldexp(1.0, -r);
+            zeros += (r == 0);
+        }
+        double e = alpha * m * m / sum;
+        if (e <= 2.5 * m && zeros != 0) {
+            e = m * std::log(m / zeros);
+        }
+        return e;
+    }
+
+    void clear() { registers.fill(0); }
+
+};
+
+// class space_saving tracks the (at most) max_counters most frequent
+// keys in a stream, using the space-saving algorithm of Metwally,
+// Agrawal, and El Abbadi.  When a key that is not being tracked
+// arrives and all of the counters are in use, the counter with the
+// smallest count is reassigned to it, and the new key inherits that
+// count as its error.  Each count is an overestimate of the true
+// count by at most its error, and every key whose true count exceeds
+// the smallest count is tracked.
+//
+// Each counter carries a value of type T, which is reset when the
+// counter is reassigned; it can hold a nested summary.  A floor can
+// be set for a summary that starts partway through the stream of its
+// parent, so that the counts of its keys remain overestimates.
+//
+// The number of counters is expected to be small, so lookups and
+// replacements use linear search, with a hash to avoid string
+// comparisons.
+//
+template <typename T>
+class space_saving {
+public:
+
+    struct counter {
+        std::string key;
+        uint64_t hash;
+        uint64_t count;
+        uint64_t error;
+        T value;
+    };
+
+private:
+    std::vector<counter> counters;
+    size_t max_counters;
+    uint64_t floor = 0;
+
+public:
+
+    explicit space_saving(size_t k) : max_counters{k} {
+        counters.reserve(k);
+    }
+
+    // observe() counts one occurrence of key, and returns its
+    // counter.  If a counter was reassigned from another key to this
+    // one, replaced is set to true, and the caller can account for
+    // the memory of the old key and value, which are in evicted_key
+    // and evicted_value.
+    //
+    counter &observe(const std::string &key,
+                     uint64_t hash,
+                     bool &replaced,
+                     std::string &evicted_key,
+                     T &evicted_value) {
+        replaced = false;
+        for (auto &c : counters) {
+            if (c.hash == hash && c.key == key) {
+                c.count++;
+                return c;
+            }
+        }
+        if (counters.size() < max_counters) {
+            counters.push_back({ key, hash, floor + 1, floor, T{} });
+            return counters.back();
+        }
+        counter *min = &counters[0];
+        for (auto &c : counters) {
+            if (c.count < min->count) {
+                min = &c;
+            }
+        }
+        replaced = true;
+        evicted_key.swap(min->key);
+        evicted_value = std::move(min->value);
+        min->key = key;
+        min->hash = hash;
+        min->error = min->count;
+        min->count++;
+        min->value = T{};
+        return *min;
+    }
+
+    void set_floor(uint64_t f) { floor = f; }
+
+    void clear() {
+        counters.clear();
+        floor = 0;
+    }
+
+    size_t size() const { return counters.size(); }
+
+    size_t capacity() const { return max_counters; }
+
+    // sorted() returns pointers to the counters in order of
+    // decreasing count
+    //
+    std::vector<const counter *> sorted() const {
+        std::vector<const counter *> v;
+        v.reserve(counters.size());
+        for (const auto &c : counters) {
+            v.push_back(&c);
+        }
+        std::sort(v.begin(), v.end(), [](const counter *l, const counter *r) {
+            return l->count > r->count || (l->count == r->count && l->key < r->key);
+        });
+        return v;
+    }
+
+    template <typename F>
+    void for_each(F f) const {
+        for (const auto &c : counters) {
+            f(c);
+        }
+    }
+
+};
+
+#endif // STATS_SKETCH_HPP
@@ -11,6 +11,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <unordered_map>
+#include <vector>
 #include "datum.h"
 #include "json_object.h"
 #include "util_obj.h"
@@ -97,7 +98,6 @@ namespace std {
     };
 }
 
-
 #define BYTE_BINARY_FORMAT "%c%c%c%c%c%c%c%c"
 #define UINT8_BINARY(x)                         \
     (x & 0x80 ? '1' : '0'),                     \
@@ -164,10 +164,47 @@ void fprintf_tcp_hdr_info(FILE *f, const struct key *k, const struct tcp_header
 #define ACCEPT_PACKET 100
 #define DROP_PACKET     0
 
+// struct tcp_initial_message_filter
+//
+// goal: accept the packets in the initial message of each direction
+// of each TCP flow, and drop the others.
+//
+// approach: keep a tcp_state for each flow in a fixed-size, open
+// addressing hash table that is allocated on first use.  Entries
+// expire after timeout seconds without a packet, as measured by the
+// packet timestamps; a clock hand sweeps the table, removing expired
+// entries as it goes, and when the table is full, it evicts the
+// first entry that has not been referenced since the hand last
+// passed it (the CLOCK approximation of LRU).  The memory used by
+// the table is therefore bounded by max_entries, no matter how many
+// flows are seen.
+//
 struct tcp_initial_message_filter {
-    std::unordered_map<struct key, struct tcp_state> tcp_flow_table;
+    static constexpr size_t default_max_entries = 20000;
+    static constexpr unsigned int timeout = 60;  // seconds before flow timeout
 
-    tcp_initial_message_filter(void) : tcp_flow_table{} {}
+    struct entry {
+        struct key k;
+        struct tcp_state state;
+        unsigned int sec;   // timestamp of the last packet in the flow
+        bool referenced;    // set on lookup, cleared by the clock hand
+
+        bool is_empty() const { return k.is_zero(); }
+
+        bool is_expired(unsigned int current_time) const {
+            return (current_time - sec) >= timeout;
+        }
+    };
+
+    tcp_initial_message_filter(size_t entries=default_max_entries) :
+        table{},
+        mask{0},
+        max_entries{entries ? entries : 1},
+        count{0},
+        hand{0},
+        inserts{0},
+        expirations{0},
+        evictions{0} { }
 
     // A TCP message is defined as the set of TCP/IP packets for which
     // the ACK flag is set, the Ack value is constant, and the Seq is
@@ -184,7 +221,7 @@ struct tcp_initial_message_filter {
     // p.ack = s.ack       talking           listening               *
     // p.ack < s.ack          *                  *                   *
 
-    size_t apply(struct key &k, const struct tcp_header *tcp, size_t length) {
+    size_t apply(struct key &k, unsigned int sec, const struct tcp_header *tcp, size_t length) {
 
         size_t retval = DROP_PACKET;
 
@@ -192,8 +229,18 @@ struct tcp_initial_message_filter {
         k.dst_port = tcp->dst_port;
         size_t data_length = length - tcp_offrsv_get_header_length(tcp->offrsv);
 
-        auto it = tcp_flow_table.find(k);
-        if (it == tcp_flow_table.end()) {
+        if (table.empty()) {
+            allocate();
+        }
+        reap(sec);  // passive: try to clean expired entries
+
+        size_t i = find(k);
+        if (!table[i].is_empty() && table[i].is_expired(sec)) {
+            erase(i);
+            ++expirations;
+            i = find(k);
+        }
+        if (table[i].is_empty()) {
 
             uint32_t tmp_seq = tcp->seq;
             if (TCP_IS_SYN(tcp->flags)) {
@@ -206,14 +253,22 @@ struct tcp_initial_message_filter {
                                        tcp->ack, // .init_ack
                                        listening // .disposition
             };
-            tcp_flow_table[k] = state;
+            if (count >= max_entries) {
+                evict(sec);      // aggressive: remove an entry
+                i = find(k);     // erase() may have moved the empty slot
+            }
+            table[i] = { k, state, sec, false };
+            ++count;
+            ++inserts;
             retval = ACCEPT_PACKET;
 
             fprintf_tcp_hdr_info(stderr, &k, tcp, &state, length, retval);
 
         } else {
 
-            struct tcp_state state = it->second;
+            struct tcp_state &state = table[i].state;
+            table[i].sec = sec;
+            table[i].referenced = true;
 
             // initialize acknowledgement number, if it has not yet been set
             if (state.ack == 0) {
@@ -243,18 +298,140 @@ struct tcp_initial_message_filter {
             if (ntoh(tcp->ack) > ntoh(state.ack)) {
                 state.ack = tcp->ack;
             }
-            tcp_flow_table[k] = state;
 
             fprintf_tcp_hdr_info(stderr, &k, tcp, &state, length, retval);
 
             if (TCP_IS_FIN(tcp->flags) || TCP_IS_RST(tcp->flags)) {
-                tcp_flow_table.erase(it);
+                erase(i);
             }
         }
 
         return retval;
     }
 
+    // returns the tcp_state of the flow with key k, or nullptr if
+    // there is no such flow in the table
+    //
+    const struct tcp_state *get_state(const struct key &k) const {
+        if (table.empty()) {
+            return nullptr;
+        }
+        const entry &e = table[find(k)];
+        return e.is_empty() ? nullptr : &e.state;
+    }
+
+    size_t size() const { return count; }
+
+    size_t capacity() const { return max_entries; }
+
+    // number of slots in the table, which is fixed once the table
+    // has been allocated
+    //
+    size_t slots() const { return table.size(); }
+
+    uint64_t get_inserts() const { return inserts; }
+
+    uint64_t get_expirations() const { return expirations; }
+
+    uint64_t get_evictions() const { return evictions; }
+
+private:
+    std::vector<entry> table;
+    size_t mask;
+    size_t max_entries;
+    size_t count;
+    size_t hand;          // clock hand, used for reaping and eviction
+    uint64_t inserts;     // entries added to the table
+    uint64_t expirations; // entries removed because they timed out
+    uint64_t evictions;   // entries removed because the table was full
+
+    // the table has at least twice as many slots as entries, so that
+    // linear probe sequences stay short
+    //
+    void allocate() {
+        size_t slots = 2;
+        while (slots < 2 * max_entries) {
+            slots *= 2;
+        }
+        table.assign(slots, entry{});
+        mask = slots - 1;
+    }
+
+    size_t home(const struct key &k) const {
+        size_t h = std::hash<struct key>{}(k);
+        return (h ^ (h >> 32)) & mask;
+    }
+
+    // returns the index of the slot that holds k, or of the empty slot
+    // at which k would be inserted
+    //
+    size_t find(const struct key &k) const {
+        size_t i = home(k);
+        while (!table[i].is_empty() && !(table[i].k == k)) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    // removes the entry in slot i, and moves later entries in its
+    // probe sequence back, so that no tombstones are needed
+    //
+    void erase(size_t i) {
+        size_t j = i;
+        while (true) {
+            j = (j + 1) & mask;
+            if (table[j].is_empty()) {
+                break;
+            }
+            size_t h = home(table[j].k);
+            if (((j - h) & mask) >= ((j - i) & mask)) {
+                table[i] = table[j];
+                i = j;
+            }
+        }
+        table[i].k.zeroize();
+        --count;
+    }
+
+    // advances the clock hand over two slots, and removes the entries
+    // in them that have expired
+    //
+    void reap(unsigned int sec) {
+        for (int n = 0; n < 2; n++) {
+            hand = (hand + 1) & mask;
+            entry &e = table[hand];
+            if (!e.is_empty() && e.is_expired(sec)) {
+                erase(hand);
+                ++expirations;
+            }
+        }
+    }
+
+    // advances the clock hand until an entry has been removed; expired
+    // entries are removed first, then unreferenced ones, and the
+    // reference bits of the entries passed over are cleared
+    //
+    void evict(unsigned int sec) {
+        while (true) {
+            hand = (hand + 1) & mask;
+            entry &e = table[hand];
+            if (e.is_empty()) {
+                continue;
+            }
+            if (e.is_expired(sec)) {
+                erase(hand);
+                ++expirations;
+                return;
+            }
+            if (!e.referenced) {
+                erase(hand);
+                ++evictions;
+                return;
+            }
+            e.referenced = false;
+        }
+    }
+
 };
 
 /* Comment reassembly pruning logic
@@ -0,0 +1,587 @@
+// text_encoding.hpp
+//
+// kernels that encode bytes as hexadecimal or base64 text, that find
+// the bytes of a string that must be escaped in JSON output, and that
+// find the end of a line of text
+//
+// Each kernel has a scalar implementation, and vectorized
+// implementations for x86-64 (SSE2, SSSE3, AVX2) and AArch64 (NEON)
+// processors.  On x86-64, the AVX2 and SSSE3 implementations are
+// compiled for those instruction sets with function attributes, and
+// are selected at run time when the processor supports them, so that
+// the default build flags (which do not include -march) get the
+// benefit of them.  On AArch64, NEON is always available.
+//
+// The kernels write into a buffer that the caller has checked is
+// large enough; the functions in buffer_stream.h that use them
+// perform that check once per call.
+
+#ifndef TEXT_ENCODING_HPP
+#define TEXT_ENCODING_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define TEXT_ENCODING_X86_64
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TEXT_ENCODING_NEON
+#endif
+
+namespace text_encoding {
+
+    /// the instruction sets for which the kernels are implemented
+    ///
+    enum class isa : uint8_t {
+        scalar = 0,
+        sse2   = 1,
+        ssse3  = 2,
+        avx2   = 3,
+        neon   = 4,
+    };
+
+    static inline const char *isa_name(isa i) {
+        switch (i) {
+        case isa::sse2:  return "sse2";
+        case isa::ssse3: return "ssse3";
+        case isa::avx2:  return "avx2";
+        case isa::neon:  return "neon";
+        default:
+            ;
+        }
+        return "scalar";
+    }
+
+    /// returns true if the kernels for the instruction set \param i
+    /// are compiled in and can run on this processor
+    ///
+    static inline bool is_supported(isa i) {
+        switch (i) {
+        case isa::scalar:
+            return true;
+#ifdef TEXT_ENCODING_X86_64
+        case isa::sse2:
+            return true;
+        case isa::ssse3:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("ssse3");
+        case isa::avx2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+#ifdef TEXT_ENCODING_NEON
+        case isa::neon:
+            return true;
+#endif
+        default:
+            ;
+        }
+        return false;
+    }
+
+    /// returns the best instruction set supported by this processor,
+    /// which is determined once and then cached
+    ///
+    static inline isa best_isa() {
+        static const isa best = []() {
+            for (isa i : { isa::avx2, isa::ssse3, isa::sse2, isa::neon }) {
+                if (is_supported(i)) {
+                    return i;
+                }
+            }
+            return isa::scalar;
+        }();
+        return best;
+    }
+
+    static constexpr char hex_digits[] = "0123456789abcdef";
+
+    static constexpr char base64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    /// returns the number of characters in the hexadecimal encoding
+    /// of \param n bytes
+    ///
+    static constexpr size_t hex_length(size_t n) { return 2 * n; }
+
+    /// returns the number of characters in the (padded) base64
+    /// encoding of \param n bytes
+    ///
+    static constexpr size_t base64_length(size_t n) { return 4 * ((n + 2) / 3); }
+
+    /// returns true if the byte \param c is written into a JSON
+    /// string as is, that is, it is printable ASCII other than the
+    /// quotation mark and reverse solidus.  Every JSON escaping
+    /// function in libmerc writes these bytes unchanged; they differ
+    /// only in how they handle the other bytes.
+    ///
+    static inline bool is_json_clean(uint8_t c) {
+        return c >= 0x20 && c < 0x7f && c != '"' && c != '\\';
+    }
+
+    // scalar implementations
+    //
+    static inline void hex_scalar(char *out, const uint8_t *in, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            out[2*i]     = hex_digits[in[i] >> 4];
+            out[2*i + 1] = hex_digits[in[i] & 0x0f];
+        }
+    }
+
+    static inline void base64_scalar(char *out, const uint8_t *in, size_t n) {
+        size_t i = 0;
+        for ( ; i + 3 <= n; i += 3) {
+            uint32_t trip = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+            out[0] = base64_digits[(trip >> 18) & 0x3f];
+            out[1] = base64_digits[(trip >> 12) & 0x3f];
+            out[2] = base64_digits[(trip >> 6) & 0x3f];
+            out[3] = base64_digits[trip & 0x3f];
+            out += 4;
+        }
+        if (n - i == 1) {
+            uint32_t trip = in[i] << 16;
+            out[0] = base64_digits[(trip >> 18) & 0x3f];
+            out[1] = base64_digits[(trip >> 12) & 0x3f];
+            out[2] = '=';
+            out[3] = '=';
+        } else if (n - i == 2) {
+            uint32_t trip = (in[i] << 16) | (in[i + 1] << 8);
+            out[0] = base64_digits[(trip >> 18) & 0x3f];
+            out[1] = base64_digits[(trip >> 12) & 0x3f];
+            out[2] = base64_digits[(trip >> 6) & 0x3f];
+            out[3] = '=';
+        }
+    }
+
+    static inline size_t json_clean_prefix_length_scalar(const uint8_t *in, size_t n) {
+        size_t i = 0;
+        while (i < n && is_json_clean(in[i])) {
+            i++;
+        }
+        return i;
+    }
+
+    static inline bool is_ascii_scalar(const uint8_t *in, size_t n) {
+        uint8_t sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum |= in[i];
+        }
+        return (sum & 0x80) == 0;
+    }
+
+    static inline size_t line_break_offset_scalar(const uint8_t *in, size_t n) {
+        size_t i = 0;
+        while (i < n && in[i] != '\r' && in[i] != '\n') {
+            i++;
+        }
+        return i;
+    }
+
+#ifdef TEXT_ENCODING_X86_64
+
+    // SSE2 is part of the x86-64 baseline, so these implementations
+    // need no function attributes
+    //
+    static inline void hex_sse2(char *out, const uint8_t *in, size_t n) {
+        const __m128i low_nibble = _mm_set1_epi8(0x0f);
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i zero_char = _mm_set1_epi8('0');
+        const __m128i alpha_offset = _mm_set1_epi8('a' - '0' - 10);
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(x, 4), low_nibble);
+            __m128i lo = _mm_and_si128(x, low_nibble);
+            __m128i a = _mm_unpacklo_epi8(hi, lo);
+            __m128i b = _mm_unpackhi_epi8(hi, lo);
+            a = _mm_add_epi8(_mm_add_epi8(a, zero_char), _mm_and_si128(_mm_cmpgt_epi8(a, nine), alpha_offset));
+            b = _mm_add_epi8(_mm_add_epi8(b, zero_char), _mm_and_si128(_mm_cmpgt_epi8(b, nine), alpha_offset));
+            _mm_storeu_si128((__m128i *)(out + 2*i), a);
+            _mm_storeu_si128((__m128i *)(out + 2*i + 16), b);
+        }
+        hex_scalar(out + 2*i, in + i, n - i);
+    }
+
+    static inline size_t json_clean_prefix_length_sse2(const uint8_t *in, size_t n) {
+        const __m128i space_minus_one = _mm_set1_epi8(0x1f);
+        const __m128i del = _mm_set1_epi8(0x7f);
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i reverse_solidus = _mm_set1_epi8('\\');
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+            // the signed comparisons also reject bytes above 0x7f
+            __m128i printable = _mm_and_si128(_mm_cmpgt_epi8(x, space_minus_one), _mm_cmplt_epi8(x, del));
+            __m128i special = _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, reverse_solidus));
+            unsigned int escape = _mm_movemask_epi8(_mm_andnot_si128(special, printable)) ^ 0xffff;
+            if (escape) {
+                return i + __builtin_ctz(escape);
+            }
+        }
+        return i + json_clean_prefix_length_scalar(in + i, n - i);
+    }
+
+    static inline bool is_ascii_sse2(const uint8_t *in, size_t n) {
+        __m128i sum = _mm_setzero_si128();
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16) {
+            sum = _mm_or_si128(sum, _mm_loadu_si128((const __m128i *)(in + i)));
+        }
+        return _mm_movemask_epi8(sum) == 0 && is_ascii_scalar(in + i, n - i);
+    }
+
+    static inline size_t line_break_offset_sse2(const uint8_t *in, size_t n) {
+        const __m128i cr = _mm_set1_epi8('\r');
+        const __m128i lf = _mm_set1_epi8('\n');
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+            unsigned int found = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, cr), _mm_cmpeq_epi8(x, lf)));
+            if (found) {
+                return i + __builtin_ctz(found);
+            }
+        }
+        return i + line_break_offset_scalar(in + i, n - i);
+    }
+
+    // base64 encoding with pshufb, following Muła and Lemire,
+    // "Faster Base64 Encoding and Decoding Using AVX2 Instructions"
+    // (ACM TOMS, 2018).  Each 32-bit lane of the input holds one
+    // group of three bytes, which are split into four 6-bit indices
+    // and then translated into ASCII.
+    //
+    __attribute__((target("ssse3")))
+    static inline __m128i base64_encode_block_ssse3(__m128i in) {
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+        __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+        __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+        __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+        __m128i indices = _mm_or_si128(t1, t3);
+
+        __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+        const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                              '/' - 63, 'A', 0, 0);
+        result = _mm_shuffle_epi8(offsets, result);
+        return _mm_add_epi8(result, indices);
+    }
+
+    __attribute__((target("ssse3")))
+    static inline void base64_ssse3(char *out, const uint8_t *in, size_t n) {
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 12) {  // 16 bytes are read, 12 are encoded
+            __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+            _mm_storeu_si128((__m128i *)out, base64_encode_block_ssse3(x));
+            out += 16;
+        }
+        base64_scalar(out, in + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    static inline void hex_avx2(char *out, const uint8_t *in, size_t n) {
+        const __m256i low_nibble = _mm256_set1_epi8(0x0f);
+        const __m256i digits = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                                '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                                                '0', '1', '2', '3', '4', '5', '6', '7',
+                                                '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+        size_t i = 0;
+        for ( ; i + 32 <= n; i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+            __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibble));
+            __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(x, low_nibble));
+            // the unpack instructions work within 128-bit lanes, so
+            // the lanes are put back in order when they are stored
+            __m256i a = _mm256_unpacklo_epi8(hi, lo);
+            __m256i b = _mm256_unpackhi_epi8(hi, lo);
+            _mm256_storeu_si256((__m256i *)(out + 2*i), _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i *)(out + 2*i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+        }
+        hex_sse2(out + 2*i, in + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    static inline void base64_avx2(char *out, const uint8_t *in, size_t n) {
+        const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                 '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                 '/' - 63, 'A', 0, 0,
+                                                 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                 '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                 '/' - 63, 'A', 0, 0);
+        size_t i = 0;
+        for ( ; i + 28 <= n; i += 24) {  // 28 bytes are read, 24 are encoded
+            __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(in + i))),
+                                                _mm_loadu_si128((const __m128i *)(in + i + 12)), 1);
+            x = _mm256_shuffle_epi8(x, shuffle);
+            __m256i t0 = _mm256_and_si256(x, _mm256_set1_epi32(0x0fc0fc00));
+            __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+            __m256i t2 = _mm256_and_si256(x, _mm256_set1_epi32(0x003f03f0));
+            __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+            __m256i indices = _mm256_or_si256(t1, t3);
+
+            __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+            __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+            result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+            result = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, result), indices);
+            _mm256_storeu_si256((__m256i *)out, result);
+            out += 32;
+        }
+        base64_ssse3(out, in + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    static inline size_t json_clean_prefix_length_avx2(const uint8_t *in, size_t n) {
+        const __m256i space_minus_one = _mm256_set1_epi8(0x1f);
+        const __m256i del = _mm256_set1_epi8(0x7f);
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i reverse_solidus = _mm256_set1_epi8('\\');
+        size_t i = 0;
+        for ( ; i + 32 <= n; i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+            __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(x, space_minus_one), _mm256_cmpgt_epi8(del, x));
+            __m256i special = _mm256_or_si256(_mm256_cmpeq_epi8(x, quote), _mm256_cmpeq_epi8(x, reverse_solidus));
+            uint32_t escape = ~(uint32_t)_mm256_movemask_epi8(_mm256_andnot_si256(special, printable));
+            if (escape) {
+                return i + __builtin_ctz(escape);
+            }
+        }
+        return i + json_clean_prefix_length_sse2(in + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    static inline bool is_ascii_avx2(const uint8_t *in, size_t n) {
+        __m256i sum = _mm256_setzero_si256();
+        size_t i = 0;
+        for ( ; i + 32 <= n; i += 32) {
+            sum = _mm256_or_si256(sum, _mm256_loadu_si256((const __m256i *)(in + i)));
+        }
+        return _mm256_movemask_epi8(sum) == 0 && is_ascii_sse2(in + i, n - i);
+    }
+
+    __attribute__((target("avx2")))
+    static inline size_t line_break_offset_avx2(const uint8_t *in, size_t n) {
+        const __m256i cr = _mm256_set1_epi8('\r');
+        const __m256i lf = _mm256_set1_epi8('\n');
+        size_t i = 0;
+        for ( ; i + 32 <= n; i += 32) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(in + i));
+            uint32_t found = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(x, cr), _mm256_cmpeq_epi8(x, lf)));
+            if (found) {
+                return i + __builtin_ctz(found);
+            }
+        }
+        return i + line_break_offset_sse2(in + i, n - i);
+    }
+
+#endif // TEXT_ENCODING_X86_64
+
+#ifdef TEXT_ENCODING_NEON
+
+    static inline void hex_neon(char *out, const uint8_t *in, size_t n) {
+        const uint8x16_t digits = vld1q_u8((const uint8_t *)hex_digits);
+        const uint8x16_t low_nibble = vdupq_n_u8(0x0f);
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16) {
+            uint8x16_t x = vld1q_u8(in + i);
+            uint8x16x2_t result;
+            result.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(x, 4));
+            result.val[1] = vqtbl1q_u8(digits, vandq_u8(x, low_nibble));
+            vst2q_u8((uint8_t *)out + 2*i, result);   // interleaves the high and low digits
+        }
+        hex_scalar(out + 2*i, in + i, n - i);
+    }
+
+    static inline void base64_neon(char *out, const uint8_t *in, size_t n) {
+        uint8x16x4_t digits;
+        digits.val[0] = vld1q_u8((const uint8_t *)base64_digits);
+        digits.val[1] = vld1q_u8((const uint8_t *)base64_digits + 16);
+        digits.val[2] = vld1q_u8((const uint8_t *)base64_digits + 32);
+        digits.val[3] = vld1q_u8((const uint8_t *)base64_digits + 48);
+        const uint8x16_t six_bits = vdupq_n_u8(0x3f);
+        size_t i = 0;
+        for ( ; i + 48 <= n; i += 48) {
+            uint8x16x3_t x = vld3q_u8(in + i);   // de-interleaves the groups of three bytes
+            uint8x16x4_t result;
+            result.val[0] = vqtbl4q_u8(digits, vshrq_n_u8(x.val[0], 2));
+            result.val[1] = vqtbl4q_u8(digits, vandq_u8(vorrq_u8(vshlq_n_u8(x.val[0], 4), vshrq_n_u8(x.val[1], 4)), six_bits));
+            result.val[2] = vqtbl4q_u8(digits, vandq_u8(vorrq_u8(vshlq_n_u8(x.val[1], 2), vshrq_n_u8(x.val[2], 6)), six_bits));
+            result.val[3] = vqtbl4q_u8(digits, vandq_u8(x.val[2], six_bits));
+            vst4q_u8((uint8_t *)out, result);
+            out += 64;
+        }
+        base64_scalar(out, in + i, n - i);
+    }
+
+    static inline size_t json_clean_prefix_length_neon(const uint8_t *in, size_t n) {
+        const uint8x16_t space = vdupq_n_u8(0x20);
+        const uint8x16_t del = vdupq_n_u8(0x7f);
+        const uint8x16_t quote = vdupq_n_u8('"');
+        const uint8x16_t reverse_solidus = vdupq_n_u8('\\');
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16) {
+            uint8x16_t x = vld1q_u8(in + i);
+            uint8x16_t escape = vorrq_u8(vorrq_u8(vcltq_u8(x, space), vcgeq_u8(x, del)),
+                                         vorrq_u8(vceqq_u8(x, quote), vceqq_u8(x, reverse_solidus)));
+            if (vmaxvq_u8(escape)) {
+                break;
+            }
+        }
+        return i + json_clean_prefix_length_scalar(in + i, n - i);
+    }
+
+    static inline bool is_ascii_neon(const uint8_t *in, size_t n) {
+        uint8x16_t sum = vdupq_n_u8(0);
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16) {
+            sum = vorrq_u8(sum, vld1q_u8(in + i));
+        }
+        return vmaxvq_u8(sum) < 0x80 && is_ascii_scalar(in + i, n - i);
+    }
+
+    static inline size_t line_break_offset_neon(const uint8_t *in, size_t n) {
+        const uint8x16_t cr = vdupq_n_u8('\r');
+        const uint8x16_t lf = vdupq_n_u8('\n');
+        size_t i = 0;
+        for ( ; i + 16 <= n; i += 16) {
+            uint8x16_t x = vld1q_u8(in + i);
+            if (vmaxvq_u8(vorrq_u8(vceqq_u8(x, cr), vceqq_u8(x, lf)))) {
+                break;
+            }
+        }
+        return i + line_break_offset_scalar(in + i, n - i);
+    }
+
+#endif // TEXT_ENCODING_NEON
+
+    /// writes the hexadecimal encoding of the \param n bytes at \param
+    /// in into the hex_length(n) bytes at \param out, using the
+    /// kernel for the instruction set \param i, which must be
+    /// supported
+    ///
+    static inline void hex(char *out, const uint8_t *in, size_t n, isa i=best_isa()) {
+        switch (i) {
+#ifdef TEXT_ENCODING_X86_64
+        case isa::avx2:
+            hex_avx2(out, in, n);
+            return;
+        case isa::ssse3:
+        case isa::sse2:
+            hex_sse2(out, in, n);
+            return;
+#endif
+#ifdef TEXT_ENCODING_NEON
+        case isa::neon:
+            hex_neon(out, in, n);
+            return;
+#endif
+        default:
+            hex_scalar(out, in, n);
+        }
+    }
+
+    /// writes the base64 encoding of the \param n bytes at \param in,
+    /// including any padding, into the base64_length(n) bytes at
+    /// \param out, using the kernel for the instruction set \param i,
+    /// which must be supported
+    ///
+    static inline void base64(char *out, const uint8_t *in, size_t n, isa i=best_isa()) {
+        switch (i) {
+#ifdef TEXT_ENCODING_X86_64
+        case isa::avx2:
+            base64_avx2(out, in, n);
+            return;
+        case isa::ssse3:
+            base64_ssse3(out, in, n);
+            return;
+#endif
+#ifdef TEXT_ENCODING_NEON
+        case isa::neon:
+            base64_neon(out, in, n);
+            return;
+#endif
+        default:
+            base64_scalar(out, in, n);
+        }
+    }
+
+    /// returns the number of bytes at the start of the \param n bytes
+    /// at \param in for which is_json_clean() is true, using the
+    /// kernel for the instruction set \param i, which must be
+    /// supported
+    ///
+    static inline size_t json_clean_prefix_length(const uint8_t *in, size_t n, isa i=best_isa()) {
+        switch (i) {
+#ifdef TEXT_ENCODING_X86_64
+        case isa::avx2:
+            return json_clean_prefix_length_avx2(in, n);
+        case isa::ssse3:
+        case isa::sse2:
+            return json_clean_prefix_length_sse2(in, n);
+#endif
+#ifdef TEXT_ENCODING_NEON
+        case isa::neon:
+            return json_clean_prefix_length_neon(in, n);
+#endif
+        default:
+            ;
+        }
+        return json_clean_prefix_length_scalar(in, n);
+    }
+
+    /// returns true if none of the \param n bytes at \param in has its
+    /// high bit set, using the kernel for the instruction set \param
+    /// i, which must be supported
+    ///
+    static inline bool is_ascii(const uint8_t *in, size_t n, isa i=best_isa()) {
+        switch (i) {
+#ifdef TEXT_ENCODING_X86_64
+        case isa::avx2:
+            return is_ascii_avx2(in, n);
+        case isa::ssse3:
+        case isa::sse2:
+            return is_ascii_sse2(in, n);
+#endif
+#ifdef TEXT_ENCODING_NEON
+        case isa::neon:
+            return is_ascii_neon(in, n);
+#endif
+        default:
+            ;
+        }
+        return is_ascii_scalar(in, n);
+    }
+
+    /// returns the number of bytes at the start of the \param n bytes
+    /// at \param in that precede the first carriage return or line
+    /// feed, or \param n if there is none, using the kernel for the
+    /// instruction set \param i, which must be supported
+    ///
+    static inline size_t line_break_offset(const uint8_t *in, size_t n, isa i=best_isa()) {
+        switch (i) {
+#ifdef TEXT_ENCODING_X86_64
+        case isa::avx2:
+            return line_break_offset_avx2(in, n);
+        case isa::ssse3:
+        case isa::sse2:
+            return line_break_offset_sse2(in, n);
+#endif
+#ifdef TEXT_ENCODING_NEON
+        case isa::neon:
+            return line_break_offset_neon(in, n);
+#endif
+        default:
+            ;
+        }
+        return line_break_offset_scalar(in, n);
+    }
+
+} // namespace text_encoding
+
+#endif // TEXT_ENCODING_HPP
@@ -642,13 +642,106 @@ void tls_extensions::fingerprint(struct buffer_stream &b, enum tls_role role) co
 
 }
 
+// tls_extension_order holds the offset and encoded type of each of
+// the extensions in a tls_extensions vector, in the order in which
+// they appear in a fingerprint: by encoded type, then by length, then
+// by value, with ties kept in the order in which they appear on the
+// wire.  GREASE extensions are never ordered by length or value; as
+// with the comparators that this class replaced, all of them compare
+// as equal, so that they stay in wire order.  Up to inline_capacity extensions are kept in an inline array
+// and inserted into place as they are added, so that the fingerprint
+// of a typical client hello is built without any heap allocation;
+// larger extension vectors spill over into a std::vector, which is
+// sorted once by sort().
+//
+class tls_extension_order {
+public:
+    struct entry {
+        uint16_t encoded_type;
+        bool grease;
+        uint32_t offset;
+    };
+
+    static constexpr size_t inline_capacity = 64;
+
+    explicit tls_extension_order(const datum &extensions) : data{extensions.data}, data_end{extensions.data_end} { }
+
+    void add(const tls_extension &x, uint16_t encoded_type) {
+        entry e{encoded_type, x.is_grease(), (uint32_t)(x.type_ptr - data)};
+        if (num_entries < inline_capacity) {
+            size_t i = num_entries++;
+            while (i > 0 && less(e, entries[i-1])) {
+                entries[i] = entries[i-1];
+                i--;
+            }
+            entries[i] = e;
+            return;
+        }
+        if (overflow.empty()) {
+            overflow.assign(entries.begin(), entries.end());
+        }
+        overflow.push_back(e);
+    }
+
+    void sort() {
+        if (!overflow.empty()) {
+            std::stable_sort(overflow.begin(), overflow.end(), [this](const entry &a, const entry &b) { return less(a, b); });
+        }
+    }
+
+    // fingerprint_format1() writes out the extensions in order, each
+    // with its encoded type
+    //
+    void fingerprint_format1(struct buffer_stream &b, enum tls_role role) const {
+        const entry *e = overflow.empty() ? entries.data() : overflow.data();
+        const entry *end = overflow.empty() ? e + num_entries : e + overflow.size();
+        for ( ; e < end; e++) {
+            datum d{data + e->offset, data_end};
+            tls_extension x{d};
+            x.encoded_type = e->encoded_type;
+            x.fingerprint_format1(b, role);
+        }
+    }
+
+private:
+    const uint8_t *data;
+    const uint8_t *data_end;
+    std::array<entry, inline_capacity> entries;
+    size_t num_entries = 0;
+    std::vector<entry> overflow;
+
+    // value() returns the value of the extension that starts at
+    // offset, which has already been parsed by a tls_extension
+    //
+    datum value(const entry &e) const {
+        const uint8_t *length_ptr = data + e.offset + L_ExtensionType;
+        size_t length = (length_ptr[0] << 8) | length_ptr[1];
+        return { length_ptr + L_ExtensionLength, length_ptr + L_ExtensionLength + length };
+    }
+
+    bool less(const entry &a, const entry &b) const {
+        if (a.encoded_type != b.encoded_type) {
+            return a.encoded_type < b.encoded_type;
+        }
+        if (a.grease && b.grease) {
+            return false;
+        }
+        datum x = value(a);
+        datum y = value(b);
+        if (x.length() != y.length()) {
+            return x.length() < y.length();
+        }
+        return x.cmp(y) < 0;
+    }
+};
+
 void tls_extensions::fingerprint_quic_tls(struct buffer_stream &b, enum tls_role role) const {
 
     struct datum ext_parser{this->data, this->data_end};
+    tls_extension_order order{*this};
 
-    std::vector<tls_extension> tls_ext_vec;
-
-    // push all extensions for sorting
+    // sort extensions based on degreased type, then length, then
+    // value
     //
     while (ext_parser.length() > 0) {
 
@@ -656,46 +749,26 @@ void tls_extensions::fingerprint_quic_tls(struct buffer_stream &b, enum tls_role
         if (x.value.data == NULL) {
             break;
         }
-
-        tls_ext_vec.push_back(x);
+        order.add(x, x.encoded_type);
     }
-
-    //sort extensions based on type and memcmp in case of same type
-    std::sort(tls_ext_vec.begin(),tls_ext_vec.end(),
-              [](const tls_extension &a, const tls_extension &b) {
-                  if (a.is_grease()) {
-                      if (b.is_grease()) {
-                          return false;
-                      }
-                      return 0x0a0a < b.type;
-                      } else if (b.is_grease()) {
-                          return a.type < 0x0a0a;
-                      }
-                  if (a.type != b.type) {
-                      return a.type < b.type;
-                  }
-                  if (a.length != b.length) {
-                      return a.length < b.length;
-                  }
-                  return a.value.cmp(b.value) < 0;
-              }
-              );
+    order.sort();
 
     b.write_char('[');
-    for (auto &x : tls_ext_vec) {
-        x.fingerprint_format1(b, role);
-    }
+    order.fingerprint_format1(b, role);
     b.write_char(']');
 }
 
 void tls_extensions::fingerprint_format2(struct buffer_stream &b, enum tls_role role) const {
 
     struct datum ext_parser{this->data, this->data_end};
-    std::array<std::array<tls_extension, tls_extensions::max_repeat_extensions>, tls_extensions_assign::include_list_len> extensions_list;
+    tls_extension_order order{*this};
 
-    int32_t index = -1;
-    
-    // Store the sorted index of all extensions
+    // the first max_repeat_extensions extensions of each encoded
+    // type are included in the fingerprint, and the others are
+    // ignored; the indices in the include list are in the same order
+    // as the encoded types, so sorting by encoded type sorts by index
+    //
+    uint8_t count[tls_extensions_assign::include_list_len] = { 0 };
 
     while (ext_parser.length() > 0) {
 
@@ -704,7 +777,7 @@ void tls_extensions::fingerprint_format2(struct buffer_stream &b, enum tls_role
             break;
         }
 
-        index = tls_extensions_assign::get_index(x.type);
+        int32_t index = tls_extensions_assign::get_index(x.type);
 
         if (index == -1) {
             if (x.is_private_extension()) {
@@ -719,43 +792,16 @@ void tls_extensions::fingerprint_format2(struct buffer_stream &b, enum tls_role
             index = tls_extensions_assign::get_index(x.encoded_type);
         }
 
-        if (index >= 0) {
-            int cnt = extensions_list[index][0].cnt;
-            
-            if (cnt < tls_extensions::max_repeat_extensions) {
-                extensions_list[index][cnt] = x;
-                extensions_list[index][0].cnt++;
-            }
+        if (index >= 0 && count[index] < tls_extensions::max_repeat_extensions) {
+            count[index]++;
+            order.add(x, x.encoded_type);
         }
     }
+    order.sort();
 
     b.write_char('[');
-    for (int extn = 0; extn < tls_extensions_assign::include_list_len; extn++) {
-        uint8_t extn_cnt = extensions_list[extn][0].cnt;
-        if (extn_cnt > 1) {
-            std::sort(extensions_list[extn].begin(), extensions_list[extn].begin() + extensions_list[extn][0].cnt,
-              [](const tls_extension &a, const tls_extension &b) {
-                if (a.is_grease()) {
-                    if (b.is_grease()) {
-                        return false;
-                    }
-                    return 0x0a0a < b.type;
-                } else if (b.is_grease()) {
-                    return a.type < 0x0a0a;
-                }
-                if (a.length != b.length) {
-                    return a.length < b.length;
-                }
-                return a.value.cmp(b.value) < 0;
-            }
-            );
-        }
-        for (int count = 0; count < extn_cnt; count++) {
-            tls_extension &x = extensions_list[extn][count];
-            x.fingerprint_format1(b, role);
-        }
-    }
-   b.write_char(']'); 
+    order.fingerprint_format1(b, role);
+    b.write_char(']');
 }
 
 void tls_extensions::write_raw_features(writeable &buf) const {
@@ -1007,6 +1053,17 @@ bool tls_client_hello::do_analysis(const struct key &k_, struct analysis_context
     return c_->analyze_fingerprint_and_destination_context(analysis_.fp, analysis_.destination, analysis_.result);
 }
 
+// get_server_name() returns the value of the server_name extension,
+// or a null datum if there is no such extension
+//
+datum tls_client_hello::get_server_name() const {
+    datum sn{nullptr, nullptr};
+    datum ua{nullptr, nullptr};
+    datum alpn{nullptr, nullptr};
+    extensions.set_meta_data(sn, ua, alpn);
+    return sn;
+}
+
 void tls_server_hello::parse(struct datum &p) {
     mercury_debug("%s: processing packet with %td bytes\n", __func__, p.data_end - p.data);
 
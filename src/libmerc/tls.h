@@ -421,6 +421,8 @@ struct tls_client_hello : public base_protocol {
 
     bool do_analysis(const struct key &k_, struct analysis_context &analysis_, classifier *c);
 
+    datum get_server_name() const;
+
     static constexpr mask_and_value<8> matcher{
         { 0xff, 0xff, 0xfc, 0x00, 0x00, 0xff, 0x00, 0x00 },
         { 0x16, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00 }
@@ -715,7 +717,7 @@ static uint16_t degrease_uint16(uint16_t x) {
     return x;
 }
 
-static void raw_as_hex_degrease(struct buffer_stream &buf, const void *data, size_t len) {
+[[maybe_unused]] static void raw_as_hex_degrease(struct buffer_stream &buf, const void *data, size_t len) {
     if (len % 2) {
         len--;   // force len to be a multiple of two
     }
@@ -22,6 +22,8 @@
 #include <netdb.h>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <cerrno>
 
 #include "verbosity.hpp"
 #include "http.h"
@@ -302,13 +304,36 @@ public:
                                             const std::string &http_host_field,
                                             const std::string &user_agent,
                                             bool doh) {
-        std::set<std::string> src_links;
-
         // send HTTP request
         //
         if (doh) {
             path += doh_path(http_host_field);
         }
+        std::string request = http_request_string(path, hostname, http_host_field, user_agent, doh);
+        if (tls_connection::write(request.data(), request.size()) < 0) {
+            if (verbosity >= verbosity_level::warnings) {
+                fprintf(stderr, "warning: could not send http request\n");
+            }
+            return {}; // return empty set
+        }
+
+        // get HTTP response
+        //
+        char http_buffer[1024*256] = {};
+        int read_len = sizeof(http_buffer);
+        tls_connection::read(http_buffer, &read_len);
+
+        return write_http_json(stdout, request, http_buffer, read_len);
+    }
+
+    // http_request_string() returns the HTTP request that
+    // send_http_request() sends for the given path and host fields
+    //
+    static std::string http_request_string(const std::string &path,
+                                           const std::string &hostname,
+                                           const std::string &http_host_field,
+                                           const std::string &user_agent,
+                                           bool doh) {
         std::string line = "GET " + path + " HTTP/1.1";
         std::string request = line + "\r\n";
         request += "User-Agent: " + user_agent;
@@ -319,12 +344,19 @@ public:
             request += "Host: " + http_host_field + "\r\n";
         }
         request += "\r\n";
-        if (tls_connection::write(request.data(), request.size()) < 0) {
-            if (verbosity >= verbosity_level::warnings) {
-                fprintf(stderr, "warning: could not send http request\n");
-            }
-            return src_links; // return empty set
-        }
+        return request;
+    }
+
+    // write_http_json() writes the HTTP request and the response (the
+    // read_len bytes in http_buffer) as JSON lines to the FILE f, and
+    // returns the set of src= links found in the response body, along
+    // with the redirect location, if there is one
+    //
+    static std::set<std::string> write_http_json(FILE *f,
+                                                 const std::string &request,
+                                                 const char *http_buffer,
+                                                 int read_len) {
+        std::set<std::string> src_links;
 
         // parse HTTP request for JSON output
         //
@@ -339,13 +371,7 @@ public:
         struct json_object http_record{&output_buffer_stream};
         req.write_json(http_record, true);
         http_record.close();
-        output_buffer_stream.write_line(stdout);
-
-        // get HTTP response
-        //
-        char http_buffer[1024*256] = {};
-        int read_len = sizeof(http_buffer);
-        tls_connection::read(http_buffer, &read_len);
+        output_buffer_stream.write_line(f);
 
         // parse and process http_response message
         if (read_len > 0) {
@@ -364,7 +390,7 @@ public:
                 struct json_object response_record{&output_buffer_stream};
                 response.write_json(response_record, true);
                 response_record.close();
-                output_buffer_stream.write_line(stdout);
+                output_buffer_stream.write_line(f);
 
                 std::basic_string<uint8_t> loc = { 'l', 'o', 'c', 'a', 't', 'i', 'o', 'n', ':', ' ' };
                 struct datum location = response.get_header((const char *)loc.data());
@@ -385,7 +411,7 @@ public:
                         // output response as JSON object
                         //
                         std::string dns_response = dns_get_json_string((const char *)http.data, http.length());
-                        fprintf(stdout, "{\"dns\":%s}\n", dns_response.c_str());
+                        fprintf(f, "{\"dns\":%s}\n", dns_response.c_str());
 
                     }
                 }
@@ -393,7 +419,7 @@ public:
                 bool print_response_body = false; // TODO: reconnect to tls_scanner
                 if (print_response_body) { // || response.status_code.compare("301", 3) == 0 || response.status_code.compare("302", 3) == 0 ) {
                     // print out redirect data
-                    fprintf(stdout, "body: %.*s\n", (int)http.length(), http.data);
+                    fprintf(f, "body: %.*s\n", (int)http.length(), http.data);
                 }
 
             }
@@ -560,4 +586,220 @@ public:
 
 };
 
+// class nonblocking_tls_connection is a TLS over TCP connection to a
+// remote server whose connect, handshake, and (optional) HTTP
+// request/response exchange never block, so that a single thread can
+// keep many of them in progress at once.  It is driven by an event
+// loop, which waits until the socket returned by get_socket() is
+// readable or writable (as indicated by wants_write()) and then calls
+// advance(), until the state is done or failed; the caller is
+// responsible for enforcing any timeout.  The SSL_CTX is owned by the
+// caller and may be shared by any number of connections.  This class
+// is not copyable.
+//
+class nonblocking_tls_connection {
+public:
+
+    enum class state {
+        connecting,
+        handshaking,
+        writing,
+        reading,
+        done,
+        failed
+    };
+
+private:
+    int sockfd = -1;
+    SSL *ssl = nullptr;
+    state st = state::failed;
+    bool want_write = true;
+    std::string request;
+    size_t bytes_written = 0;
+    std::string response;
+    size_t max_response_length;
+    std::string reason;
+
+public:
+
+    // construct a connection to the server at addr, which sends the
+    // TLS server name unless server_name is nullptr, and then sends
+    // request and reads up to max_response_len bytes of response
+    // unless request is empty
+    //
+    nonblocking_tls_connection(SSL_CTX *ctx,
+                               const sockaddr_in &addr,
+                               const char *server_name,
+                               std::string http_request,
+                               size_t max_response_len) :
+        request{std::move(http_request)},
+        max_response_length{max_response_len}
+    {
+        sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (sockfd == -1) {
+            fail(strerror(errno));
+            return;
+        }
+        ssl = SSL_new(ctx);
+        if (ssl == nullptr) {
+            fail("could not create \"SSL\"");
+            return;
+        }
+
+        // don't perform certificate validation, so that we can obtain
+        // self-issued certificates
+        //
+        SSL_set_verify(ssl, SSL_VERIFY_NONE, NULL);
+        if (server_name != nullptr && SSL_set_tlsext_host_name(ssl, server_name) != 1) {
+            fail("could not set server name");
+            return;
+        }
+        if (SSL_set_fd(ssl, sockfd) != 1) {
+            fail("could not set SSL fd");
+            return;
+        }
+        SSL_set_connect_state(ssl);
+
+        if (connect(sockfd, (const struct sockaddr *)&addr, sizeof(addr)) == 0) {
+            st = state::handshaking;
+        } else if (errno == EINPROGRESS) {
+            st = state::connecting;
+        } else {
+            fail(strerror(errno));
+        }
+    }
+
+    ~nonblocking_tls_connection() {
+        if (ssl != nullptr) {
+            SSL_free(ssl);
+        }
+        if (sockfd != -1) {
+            close(sockfd);
+        }
+    }
+
+    nonblocking_tls_connection(const nonblocking_tls_connection &) = delete;
+
+    nonblocking_tls_connection& operator=(const nonblocking_tls_connection &) = delete;
+
+    int get_socket() const { return sockfd; }
+
+    state get_state() const { return st; }
+
+    bool wants_write() const { return want_write; }
+
+    SSL *get_tls() { return ssl; }
+
+    const std::string &get_request() const { return request; }
+
+    const std::string &get_response() const { return response; }
+
+    // failure_reason() returns a description of the error that put
+    // the connection into the failed state
+    //
+    const std::string &failure_reason() const { return reason; }
+
+    // advance() performs as much of the connection as it can without
+    // blocking, and returns the resulting state
+    //
+    state advance() {
+
+        // the thread's error queue is shared by all of the
+        // connections, so it must be cleared before each operation
+        // for SSL_get_error() to be reliable
+        //
+        ERR_clear_error();
+
+        switch (st) {
+        case state::connecting:
+            {
+                int err = 0;
+                socklen_t err_len = sizeof(err);
+                if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &err, &err_len) == -1) {
+                    return fail(strerror(errno));
+                }
+                if (err != 0) {
+                    return fail(strerror(err));
+                }
+                st = state::handshaking;
+            }
+            [[fallthrough]];
+        case state::handshaking:
+            {
+                int retval = SSL_connect(ssl);
+                if (retval != 1) {
+                    return wait_or_fail(retval, "TLS handshake failed");
+                }
+                if (request.empty()) {
+                    return st = state::done;
+                }
+                st = state::writing;
+            }
+            [[fallthrough]];
+        case state::writing:
+            while (bytes_written < request.size()) {
+                int retval = SSL_write(ssl, request.data() + bytes_written, request.size() - bytes_written);
+                if (retval <= 0) {
+                    return wait_or_fail(retval, "could not send http request");
+                }
+                bytes_written += retval;
+            }
+            st = state::reading;
+            [[fallthrough]];
+        case state::reading:
+            while (response.size() < max_response_length) {
+                char buffer[1024*16];
+                size_t length = std::min(sizeof(buffer), max_response_length - response.size());
+                int retval = SSL_read(ssl, buffer, length);
+                if (retval > 0) {
+                    response.append(buffer, retval);
+                    continue;
+                }
+                int ssl_error = SSL_get_error(ssl, retval);
+                if (ssl_error == SSL_ERROR_WANT_READ || ssl_error == SSL_ERROR_WANT_WRITE) {
+                    want_write = (ssl_error == SSL_ERROR_WANT_WRITE);
+                    return st;
+                }
+                break;  // the response ends at close_notify, EOF, or error
+            }
+            return st = state::done;
+        case state::done:
+        case state::failed:
+            break;
+        }
+        return st;
+    }
+
+private:
+
+    state fail(const char *msg) {
+        reason = msg;
+        unsigned long err = ERR_get_error();
+        if (err != 0) {
+            reason += ": ";
+            reason += ERR_error_string(err, nullptr);
+        }
+        return st = state::failed;
+    }
+
+    // wait_or_fail() handles the return value of an SSL_connect(),
+    // SSL_write(), or SSL_read() call that did not succeed, by noting
+    // the I/O that it is waiting for, or by failing with the message
+    // msg
+    //
+    state wait_or_fail(int retval, const char *msg) {
+        int ssl_error = SSL_get_error(ssl, retval);
+        if (ssl_error == SSL_ERROR_WANT_READ) {
+            want_write = false;
+            return st;
+        }
+        if (ssl_error == SSL_ERROR_WANT_WRITE) {
+            want_write = true;
+            return st;
+        }
+        return fail(msg);
+    }
+
+};
+
 #endif // TLS_CONNECTION_HPP
@@ -324,6 +324,9 @@ inline bool utf8_string::write(buffer_stream &b, const uint8_t *data, unsigned i
 
         } else {    // *x < 0x80; ASCII
 
+            if (b.write_json_clean_prefix(x, end)) {
+                continue;                        // x is past a run of printable characters
+            }
             if (*x < 0x20 || *x == 0x7f) {       // escape control characters
                 write_codepoint(b, *x);
 
@@ -8,7 +8,11 @@
 #include <cstdio>
 #include <string>
 #include <vector>
-#include <unordered_set>
+#include <array>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cstring>
 #include <variant>
 #include <iostream>
 #include <fstream>
@@ -235,6 +239,18 @@ public:
                 }
             }
         }
+
+        // there must be eight pieces, or fewer than eight with a
+        // double colon, and each piece has at most four digits
+        //
+        if (pieces.size() > 8 || (double_colon_index == -1 && pieces.size() != 8) || (double_colon_index != -1 && pieces.size() == 8)) {
+            return;
+        }
+        for (const auto &p : pieces) {
+            if (p.length() > 4) {
+                return;
+            }
+        }
         valid = true;
     }
 
@@ -519,28 +535,370 @@ static inline host_identifier host_identifier_constructor(datum d) {
     return std::monostate{};
 }
 
+// watchlist_hash(x) returns a hash of the 64-bit value x in which
+// every bit of x affects every bit of the result (the finalizer of
+// MurmurHash3), so that the low bits can index a hash table
+//
+static inline uint64_t watchlist_hash(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccd;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53;
+    x ^= x >> 33;
+    return x;
+}
+
+// class flat_hash_table<T> is an open addressing hash table with
+// linear probing, which holds its elements of type T in a single
+// array, so that a watchlist with millions of entries needs a few
+// words per entry rather than a heap allocation per entry.  T must be
+// trivially copyable, and provide the member functions hash(), which
+// returns a well mixed 64-bit value, and empty(), which returns true
+// for a value-initialized T and false for any element of the table.
+// Elements cannot be removed.
+//
+template <typename T>
+class flat_hash_table {
+    std::vector<T> slots;   // size is zero or a power of two
+    size_t count = 0;
+
+    void place(const T &x) {
+        size_t mask = slots.size() - 1;
+        for (size_t i = x.hash() & mask; ; i = (i + 1) & mask) {
+            if (slots[i].empty()) {
+                slots[i] = x;
+                return;
+            }
+        }
+    }
+
+public:
+
+    // find(h, match) returns a pointer to an element with hash h for
+    // which match(element) returns true, or nullptr if there is none
+    //
+    template <typename Match>
+    const T *find(uint64_t h, Match match) const {
+        if (count == 0) {
+            return nullptr;
+        }
+        size_t mask = slots.size() - 1;
+        for (size_t i = h & mask; !slots[i].empty(); i = (i + 1) & mask) {
+            if (slots[i].hash() == h && match(slots[i])) {
+                return &slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // insert(x) adds the element x, which the caller must have
+    // checked is not already in the table; the table is kept at most
+    // half full, so that unsuccessful searches are short
+    //
+    void insert(const T &x) {
+        if ((count + 1) * 2 > slots.size()) {
+            std::vector<T> old(std::max(slots.size() * 2, (size_t)16));
+            old.swap(slots);
+            for (const T &y : old) {
+                if (!y.empty()) {
+                    place(y);
+                }
+            }
+        }
+        place(x);
+        count++;
+    }
+
+    size_t size() const { return count; }
+
+    template <typename F>
+    void for_each(F f) const {
+        for (const T &x : slots) {
+            if (!x.empty()) {
+                f(x);
+            }
+        }
+    }
+};
+
+// class dns_name_set is a set of DNS names that determines whether a
+// name, or any of its parent domains, is in the set, in a single pass
+// over that name, from its last byte to its first.  Names are
+// compared without regard to case.
+//
+// Each name is stored once, in lower case, in a single character
+// array, and indexed by a hash of its bytes taken in reverse order.
+// While a name is read backwards, the hash computed so far at each
+// dot is that of the parent domain to the right of the dot, so each
+// parent domain costs one table probe, and no copy of the name is
+// made.
+//
+class dns_name_set {
+    struct entry {
+        uint64_t hash_value;
+        uint32_t offset;    // location of name in names
+        uint32_t length;    // length of name, which is zero in an empty slot
+
+        uint64_t hash() const { return hash_value; }
+        bool empty() const { return length == 0; }
+    };
+    flat_hash_table<entry> table;
+    std::vector<char> names;
+
+    // bit n-1 of label_counts is set if the set contains a name with
+    // n labels, or with at least 64 labels if n is 64, so that the
+    // parent domains that cannot be in the set, such as top level
+    // domains in most watchlists, are not looked up
+    //
+    uint64_t label_counts = 0;
+
+    static uint64_t label_count_bit(size_t n) {
+        return (uint64_t)1 << (std::min(n, (size_t)64) - 1);
+    }
+
+    static constexpr size_t max_name_length = 255;
+
+    static uint8_t lowercase(uint8_t c) {
+        return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+
+    // the hash of a name is the 64-bit FNV-1a hash of its lowercase
+    // bytes in reverse order, passed through watchlist_hash()
+    //
+    static constexpr uint64_t hash_init = 0xcbf29ce484222325;
+
+    static uint64_t hash_step(uint64_t h, uint8_t c) {
+        return (h ^ lowercase(c)) * 0x100000001b3;
+    }
+
+    const entry *find(uint64_t h, const uint8_t *name, size_t length) const {
+        return table.find(watchlist_hash(h), [&](const entry &e) {
+            if (e.length != length) {
+                return false;
+            }
+            const char *n = &names[e.offset];
+            for (size_t i = 0; i < length; i++) {
+                if (n[i] != (char)lowercase(name[i])) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+public:
+
+    // insert(name) adds name to this set, and returns true if it was
+    // added, or false if it was already present, empty, or too long
+    //
+    bool insert(datum name) {
+        size_t length = name.length();
+        if (name.is_null() || length == 0 || length > max_name_length || names.size() + length > UINT32_MAX) {
+            return false;
+        }
+        uint64_t h = hash_init;
+        size_t labels = 1;
+        for (const uint8_t *c = name.data_end; c-- > name.data; ) {
+            h = hash_step(h, *c);
+            labels += (*c == '.');
+        }
+        if (find(h, name.data, length) != nullptr) {
+            return false;
+        }
+        table.insert({ watchlist_hash(h), (uint32_t)names.size(), (uint32_t)length });
+        label_counts |= label_count_bit(labels);
+        for (const uint8_t *c = name.data; c < name.data_end; c++) {
+            names.push_back(lowercase(*c));
+        }
+        return true;
+    }
+
+    // contains(name) returns true if name, or any of its parent
+    // domains, is in this set, and false otherwise
+    //
+    bool contains(datum name) const {
+        if (table.size() == 0 || name.is_null()) {
+            return false;
+        }
+        uint64_t h = hash_init;
+        size_t labels = 1;
+        for (const uint8_t *c = name.data_end; c-- > name.data; ) {
+            if (*c == '.') {
+                if ((label_counts & label_count_bit(labels)) && c + 1 < name.data_end && find(h, c + 1, name.data_end - (c + 1)) != nullptr) {
+                    return true;
+                }
+                labels++;
+            }
+            h = hash_step(h, *c);
+        }
+        return (label_counts & label_count_bit(labels)) && name.is_not_empty() && find(h, name.data, name.length()) != nullptr;
+    }
+
+    size_t size() const { return table.size(); }
+
+    // for_each(f) calls f(std::string) for each name in this set
+    //
+    template <typename F>
+    void for_each(F f) const {
+        table.for_each([&](const entry &e) { f(std::string{&names[e.offset], e.length}); });
+    }
+};
+
+// class ip_prefix_set<W> is a set of address prefixes, such as
+// 192.0.2.0/24, for addresses of W 32-bit words (one for IPv4 and
+// four for IPv6), which determines whether an address is covered by
+// any of its prefixes.  A single address is a prefix of the full
+// length.  There is a hash table entry for each prefix, keyed by the
+// prefix and its length, and a lookup makes one probe for each
+// distinct prefix length in the set, of which there are few in
+// practice.
+//
+template <size_t W>
+class ip_prefix_set {
+public:
+
+    // an address is held as W words in host byte order, the most
+    // significant first
+    //
+    using address = std::array<uint32_t, W>;
+
+    static constexpr unsigned int max_length = 32 * W;
+
+private:
+
+    struct entry {
+        address prefix;
+        uint32_t length_plus_one;   // zero in an empty slot
+
+        uint64_t hash() const { return hash_of(prefix, length_plus_one); }
+        bool empty() const { return length_plus_one == 0; }
+    };
+    flat_hash_table<entry> table;
+    std::vector<uint8_t> lengths;   // distinct prefix lengths, longest first
+
+    static uint64_t hash_of(const address &a, uint32_t length_plus_one) {
+        uint64_t h = length_plus_one;
+        for (const auto &w : a) {
+            h = watchlist_hash((h << 32) ^ w);
+        }
+        return h;
+    }
+
+    static address mask(const address &a, unsigned int length) {
+        address m;
+        for (size_t i = 0; i < W; i++) {
+            unsigned int bits = length > 32 * i ? length - 32 * i : 0;
+            if (bits == 0) {
+                m[i] = 0;
+            } else if (bits >= 32) {
+                m[i] = a[i];
+            } else {
+                m[i] = a[i] & (0xffffffff << (32 - bits));
+            }
+        }
+        return m;
+    }
+
+    bool contains(const address &prefix, uint32_t length_plus_one) const {
+        return table.find(hash_of(prefix, length_plus_one), [&](const entry &e) {
+            return e.length_plus_one == length_plus_one && e.prefix == prefix;
+        }) != nullptr;
+    }
+
+public:
+
+    // insert(a, length) adds the prefix of a with the given length,
+    // ignoring any bits of a beyond that length, and returns false if
+    // length is too large, and true otherwise
+    //
+    bool insert(const address &a, unsigned int length=max_length) {
+        if (length > max_length) {
+            return false;
+        }
+        address prefix = mask(a, length);
+        if (contains(prefix, length + 1)) {
+            return true;
+        }
+        table.insert({ prefix, length + 1 });
+        if (std::find(lengths.begin(), lengths.end(), length) == lengths.end()) {
+            lengths.push_back(length);
+            std::sort(lengths.begin(), lengths.end(), std::greater<uint8_t>{});
+        }
+        return true;
+    }
+
+    // contains(a) returns true if the address a is covered by a
+    // prefix in this set, and false otherwise
+    //
+    bool contains(const address &a) const {
+        for (const auto &length : lengths) {
+            if (contains(mask(a, length), length + 1)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() const { return table.size(); }
+
+    // for_each(f) calls f(prefix, length) for each prefix in this set
+    //
+    template <typename F>
+    void for_each(F f) const {
+        table.for_each([&](const entry &e) { f(e.prefix, e.length_plus_one - 1); });
+    }
+};
+
 // class watchlist implements a watchlist of host identifiers,
-// including IPv4 and IPv6 addresses and DNS names
+// including IPv4 and IPv6 addresses and address prefixes, and DNS
+// names, each of which also matches its subdomains
 //
 class watchlist {
-    std::unordered_set<uint32_t> ipv4_addrs;
-    std::unordered_set<ipv6_array_t> ipv6_addrs;
-    std::unordered_set<std::string> dns_names;
-
-    //    std::unordered_set<host_identifier> hosts;
+    ip_prefix_set<1> ipv4_addrs;
+    ip_prefix_set<4> ipv6_addrs;
+    dns_name_set dns_names;
+
+    static ip_prefix_set<4>::address ipv6_words(const uint8_t *a) {
+        ip_prefix_set<4>::address w;
+        for (size_t i = 0; i < 4; i++) {
+            w[i] = (uint32_t)a[4*i] << 24 | (uint32_t)a[4*i+1] << 16 | (uint32_t)a[4*i+2] << 8 | a[4*i+3];
+        }
+        return w;
+    }
 
-    // TODO: for performance, try using perfect_hash in place of
-    // unordered_map
+    // parse_prefix_length(d, max_length, length) sets length to the
+    // decimal number in d, which must be no greater than max_length,
+    // or to max_length if d is null, and returns false if d is not
+    // null and does not hold a valid prefix length
     //
-    // TODO: for performance, replace std:string with const char *,
-    // using a dynamically allocated buffer holding null-terminated
-    // strings
+    static bool parse_prefix_length(datum d, unsigned int max_length, unsigned int &length) {
+        if (d.is_null()) {
+            length = max_length;
+            return true;
+        }
+        if (d.length() < 1 || d.length() > 3) {
+            return false;
+        }
+        unsigned int tmp = 0;
+        for (const uint8_t *c = d.data; c < d.data_end; c++) {
+            if (*c < '0' || *c > '9') {
+                return false;
+            }
+            tmp = 10 * tmp + (*c - '0');
+        }
+        if (tmp > max_length) {
+            return false;
+        }
+        length = tmp;
+        return true;
+    }
 
 public:
 
     // watchlist(input) constructs a watchlist by parsing the input
     // text input_stream, each line of which must contain an IPv4
-    // address, an IPv6 address, a DNS name, a comment starting with
+    // address, an IPv6 address, either of which may be followed by a
+    // slash and a prefix length, a DNS name, a comment starting with
     // the character '#', or be blank (zero length)
     //
     watchlist(std::istream &input) {
@@ -551,25 +909,31 @@ public:
             if (process_line(d) == false) {
                 throw std::runtime_error{"could not read watchlist file"};
             }
-            // d = get_datum(line);
-            // host_identifier hid = host_identifier_constructor(d);
-            // hosts.insert(hid);
         }
     }
 
     watchlist() { }
 
     // contains(x) returns true if this watchlist contains x, and
-    // false otherwise.
+    // false otherwise.  An address is contained in a watchlist that
+    // contains a prefix that covers it, and a DNS name is contained
+    // in a watchlist that contains that name or any of its parent
+    // domains.
     //
     bool contains(uint32_t addr) const {
-        return ipv4_addrs.find(addr) != ipv4_addrs.end();
+        return ipv4_addrs.contains({ addr });
     }
-    bool contains(std::string &name) const {
-        return dns_names.find(name) != dns_names.end();
+    bool contains(const std::string &name) const {
+        return dns_names.contains(get_datum(name));
+    }
+    bool contains(const char *name) const {
+        return name != nullptr && dns_names.contains(get_datum(name));
+    }
+    bool contains(datum name) const {
+        return dns_names.contains(name);
     }
     bool contains(ipv6_array_t addr) const {
-        return ipv6_addrs.find(addr) != ipv6_addrs.end();
+        return ipv6_addrs.contains(ipv6_words(addr.data()));
     }
     bool contains(host_identifier hid) const {
         return std::visit(*this, hid);
@@ -583,19 +947,33 @@ public:
         if (lookahead<ipv4_address_string> ipv4{d}) {
             return contains(ipv4.value.get_value());
         } else if (lookahead<ipv6_address_string> ipv6{d}) {
-            return contains(ipv6.value.get_value_array());
+            return ipv6.value.is_valid() && contains(ipv6.value.get_value_array());
+        }
+        return false;
+    }
+
+    // contains_addr(ip_vers, addr) returns true if this watchlist
+    // contains the IP address addr, which is in network byte order
+    // and is four bytes long if ip_vers is 4, or sixteen bytes long
+    // if ip_vers is 6, and false otherwise
+    //
+    bool contains_addr(uint8_t ip_vers, const uint8_t *addr) const {
+        if (ip_vers == 4) {
+            return ipv4_addrs.contains({ (uint32_t)addr[0] << 24 | (uint32_t)addr[1] << 16 | (uint32_t)addr[2] << 8 | addr[3] });
+        } else if (ip_vers == 6) {
+            return ipv6_addrs.contains(ipv6_words(addr));
         }
         return false;
     }
 
     bool operator()(ipv4_t addr) const {
-        return ipv4_addrs.find(addr) != ipv4_addrs.end();
+        return contains(addr);
     }
-    bool operator()(dns_name_t &name) const {
-        return dns_names.find(name) != dns_names.end();
+    bool operator()(const dns_name_t &name) const {
+        return contains(name);
     }
     bool operator()(ipv6_array_t addr) const {
-        return ipv6_addrs.find(addr) != ipv6_addrs.end();
+        return contains(addr);
     }
     bool operator()(std::monostate) const {
         return false;
@@ -615,47 +993,130 @@ public:
         if (d.is_null()) {
             return false;
         }
+        while (d.is_not_empty() && (d.data_end[-1] == ' ' || d.data_end[-1] == '\t' || d.data_end[-1] == '\r')) {
+            d.data_end--;      // ignore trailing whitespace
+        }
         if (!d.is_not_empty()) {
             return true;
         }
         if (*d.data == '#') {
             return true;      // comment line
         }
-        if (lookahead<ipv4_address_string> ipv4{d}) {
-            // fprintf(stdout, "ipv4_address_string:\t");  ipv4.value.print();
-            ipv4_addrs.insert(ipv4.value.get_value());
-            d = ipv4.advance();
 
-        } else if (lookahead<dns_string> dns{d}) {
-            // fprintf(stdout, "dns_string:\t");  dns.value.print();
-            dns_names.insert(dns.value.get_string());
-            d = dns.advance();
+        // an address may be followed by a slash and a prefix length
+        //
+        datum addr = d;
+        datum prefix_length{nullptr, nullptr};
+        const uint8_t *slash = (const uint8_t *)memchr(d.data, '/', d.length());
+        if (slash != nullptr) {
+            addr.data_end = slash;
+            prefix_length = { slash + 1, d.data_end };
+        }
+        unsigned int length = 0;
 
-        } else if (lookahead<ipv6_address_string> ipv6{d}) {
-            // fprintf(stdout, "ipv6_address_string:\t");  ipv6.value.print();
-            ipv6_addrs.insert(ipv6.value.get_value_array());
-            d = ipv6.advance();
+        if (lookahead<ipv4_address_string> ipv4{addr}) {
+            if (!ipv4.advance().is_not_empty() && parse_prefix_length(prefix_length, 32, length)) {
+                return ipv4_addrs.insert({ ipv4.value.get_value() }, length);
+            }
 
-        } else {
-            if (verbose) { printf_err(log_warning, "warning: invalid line in watchlist::process_line\n"); }
-            return false;
+        } else if (lookahead<dns_string> dns{addr}) {
+            if (slash == nullptr && dns.value.is_valid()) {
+                dns_names.insert(get_datum(dns.value.get_string()));
+                return true;
+            }
+
+        } else if (lookahead<ipv6_address_string> ipv6{addr}) {
+            if (ipv6.value.is_valid() && parse_prefix_length(prefix_length, 128, length)) {
+                return ipv6_addrs.insert(ipv6_words(ipv6.value.get_value_array().data()), length);
+            }
         }
-        return true;
+        if (verbose) { printf_err(log_warning, "warning: invalid line in watchlist::process_line\n"); }
+        return false;
     }
 
     void print() const {
-        for (const auto & dns : dns_names) {
+        dns_names.for_each([](const std::string &dns) {
             fprintf(stdout, "%s\n", dns.c_str());
+        });
+        ipv4_addrs.for_each([](const ip_prefix_set<1>::address &a, unsigned int length) {
+            ipv4_print(stdout, a[0]);
+            fprintf(stdout, "/%u\n", length);
+        });
+        ipv6_addrs.for_each([](const ip_prefix_set<4>::address &a, unsigned int length) {
+            for (size_t i = 0; i < 4; i++) {
+                fprintf(stdout, "%s%04x:%04x", i ? ":" : "", a[i] >> 16, a[i] & 0xffff);
+            }
+            fprintf(stdout, "/%u\n", length);
+        });
+    }
+
+    // unit_test() returns true if a watchlist built from a set of
+    // example lines contains exactly the expected names and
+    // addresses, and false otherwise
+    //
+    static bool unit_test() {
+        const char *lines[] = {
+            "# example watchlist",
+            "",
+            "dns.example.com",
+            "Example.NET\r",
+            "192.0.2.1",
+            "198.51.100.0/24",
+            "2001:db8::1",
+            "2001:db8:1::/48",
+        };
+        watchlist w;
+        for (const auto &line : lines) {
+            std::string s{line};
+            if (w.process_line(s) == false) {
+                return false;
+            }
         }
-        for (const auto & ipv4 : ipv4_addrs) {
-            fprintf(stdout, "%u\n", ipv4);
+        std::string invalid_lines[] = { "192.0.2.0/33", "2001:db8::/129", "example.com/8", "1:2:3:4:5:6:7:8:9", "192.0.2.1 x" };
+        for (auto &line : invalid_lines) {
+            if (w.process_line(line) == true) {
+                return false;
+            }
         }
-        for (const auto & ipv6 : ipv6_addrs) {
-            fprintf(stdout,
-                    "%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x:%02x%02x\n",
-                    ipv6[0], ipv6[1], ipv6[2], ipv6[3], ipv6[4], ipv6[5], ipv6[6], ipv6[7],
-                    ipv6[8], ipv6[9], ipv6[10], ipv6[11], ipv6[12], ipv6[13], ipv6[14], ipv6[15]);
+
+        std::vector<std::pair<const char *, bool>> names{
+            { "dns.example.com", true },
+            { "a.b.dns.example.com", true },
+            { "DNS.Example.Com", true },
+            { "example.com", false },
+            { "xdns.example.com", false },
+            { "example.net", true },
+            { "www.example.net", true },
+            { "example.network", false },
+            { "net", false },
+            { "", false },
+        };
+        for (const auto &n : names) {
+            if (w.contains(n.first) != n.second) {
+                return false;
+            }
+        }
+        std::vector<std::pair<const char *, bool>> addrs{
+            { "192.0.2.1", true },
+            { "192.0.2.2", false },
+            { "198.51.100.0", true },
+            { "198.51.100.255", true },
+            { "198.51.101.0", false },
+            { "2001:db8::1", true },
+            { "2001:db8::2", false },
+            { "2001:db8:1:ffff::1", true },
+            { "2001:db8:2::1", false },
+        };
+        for (const auto &a : addrs) {
+            if (w.contains_addr(a.first) != a.second) {
+                return false;
+            }
         }
+        const uint8_t v4[4] = { 198, 51, 100, 7 };
+        const uint8_t other_v4[4] = { 198, 51, 101, 7 };
+        const uint8_t v6[16] = { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01, 0x00, 0x02, 0, 0, 0, 0, 0, 0, 0, 1 };
+        const uint8_t other_v6[16] = { 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+        return w.contains_addr(4, v4) && !w.contains_addr(4, other_v4) && w.contains_addr(6, v6) && !w.contains_addr(6, other_v6);
     }
 
 };
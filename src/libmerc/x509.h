@@ -1808,8 +1808,9 @@ struct x509_cert {
     bool is_not_currently_valid() const {
         char time_str[16];
         time_t t = time(NULL);
-        struct tm *tt = localtime(&t);
-        size_t retval = strftime(time_str, sizeof(time_str), "%y%m%d%H%M%SZ", tt);
+        struct tm tt;
+        localtime_r(&t, &tt);
+        size_t retval = strftime(time_str, sizeof(time_str), "%y%m%d%H%M%SZ", &tt);
         if (retval == 0) {
             return true;  // error: can't get current time
         }
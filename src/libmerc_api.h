@@ -81,6 +81,13 @@ struct libmerc_api {
     decltype(mercury_write_stats_data)                               *write_stats_data = nullptr;
     decltype(register_printf_err_callback)                           *register_printf_err = nullptr;
     decltype(mercury_packet_processor_get_attributes)                        *get_attributes = nullptr;
+    decltype(mercury_reload_resources)                               *reload_resources = nullptr;
+    decltype(mercury_get_resource_reload_count)                      *get_resource_reload_count = nullptr;
+    decltype(mercury_packet_processor_write_json_batch)              *write_json_batch = nullptr;
+    decltype(mercury_write_perf_counters)                            *write_perf_counters = nullptr;
+    decltype(mercury_get_metrics)                                    *get_metrics = nullptr;
+    decltype(mercury_packet_processor_write_suppressed_json)         *write_suppressed_json = nullptr;
+    decltype(mercury_packet_processor_set_verbosity)                 *set_verbosity = nullptr;
 
     dll_type dl_handle = nullptr;
 
@@ -181,6 +188,30 @@ struct libmerc_api {
             libmerc_version = 6;
         }
 
+        // libmerc v7 API
+        //
+        reload_resources =              (decltype(reload_resources))              dlsym(dl_handle, "mercury_reload_resources");
+        get_resource_reload_count =     (decltype(get_resource_reload_count))     dlsym(dl_handle, "mercury_get_resource_reload_count");
+        write_json_batch =              (decltype(write_json_batch))              dlsym(dl_handle, "mercury_packet_processor_write_json_batch");
+        write_perf_counters =           (decltype(write_perf_counters))           dlsym(dl_handle, "mercury_write_perf_counters");
+        get_metrics =                   (decltype(get_metrics))                   dlsym(dl_handle, "mercury_get_metrics");
+        write_suppressed_json =         (decltype(write_suppressed_json))         dlsym(dl_handle, "mercury_packet_processor_write_suppressed_json");
+        set_verbosity =                 (decltype(set_verbosity))                 dlsym(dl_handle, "mercury_packet_processor_set_verbosity");
+
+        // verify all v7 function symbols were found
+        //
+        if (reload_resources          == nullptr ||
+            get_resource_reload_count == nullptr ||
+            write_json_batch          == nullptr ||
+            write_perf_counters       == nullptr ||
+            get_metrics               == nullptr ||
+            write_suppressed_json     == nullptr ||
+            set_verbosity             == nullptr) {
+            fprintf(stderr, "note: could not initialize one or more libmerc v7 function pointers\n");
+        } else {
+            libmerc_version = 7;
+        }
+
         fprintf(stderr, "libmerc api version %u found\n", libmerc_version);
         fprintf(stderr, "mercury_bind() succeeded with handle %p\n", dl_handle);
 
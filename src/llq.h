@@ -10,6 +10,7 @@
 
 #include <unistd.h>
 #include <stdint.h>
+#include <time.h>
 
 #define LLQ_MAX_MSG_SIZE (1 << 20)   /* At least this many bytes must be free */
 
@@ -22,6 +23,26 @@ struct llq_msg {
 };
 
 
+/* Load shedding levels: with load shedding, a writer shortens its
+ * records as its queue fills, so that records are kept in a shorter
+ * form rather than dropped; see ll_queue::target_level()
+ */
+enum llq_level {
+    llq_level_full    = 0,   /* full records                           */
+    llq_level_reduced = 1,   /* fingerprint, flow key, and time        */
+    llq_level_summary = 2,   /* protocol, fingerprint hash, flow, time */
+    llq_level_drop    = 3,   /* no room in the queue; records dropped  */
+};
+
+#define LLQ_NUM_LEVELS 4
+
+static inline uint64_t llq_monotonic_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
 /* a lockless ringbuffer */
 struct ll_queue {
     int qnum;             /* This is the queue number and is only needed for debugging */
@@ -32,6 +53,11 @@ struct ll_queue {
     int need_read;        /* Special case: writer wraped around and ran into reader */
     uint64_t drops;       /* Output drop counter */
     uint64_t drops_trunc; /* Drops due to truncation counter */
+    uint64_t drops_total;       /* Drops accounted for by the reader */
+    uint64_t drops_trunc_total; /* Truncations accounted for by the reader */
+    int level;                  /* Load shedding level (enum llq_level) */
+    uint64_t level_start;       /* Time the current level was entered (ns) */
+    uint64_t level_ns[LLQ_NUM_LEVELS]; /* Time spent at each level before level_start (ns) */
 
 
     /* This lockless ringbuffer supports a thread writing separately
@@ -218,6 +244,81 @@ struct ll_queue {
     void drop_trunc() {
         __sync_add_and_fetch(&(drops_trunc), 1);
     }
+
+
+    /* bytes_used() returns the number of bytes of the ringbuffer
+     * that hold messages that have not yet been read; it may be
+     * called by the writer or by any other thread
+     */
+    uint64_t bytes_used() const {
+        uint64_t cur_ridx = __atomic_load_n(&ridx, __ATOMIC_RELAXED);
+        uint64_t cur_widx = __atomic_load_n(&widx, __ATOMIC_RELAXED);
+        if (cur_widx == cur_ridx) {
+            return __atomic_load_n(&need_read, __ATOMIC_RELAXED) ? llq_len : 0;
+        } else if (cur_widx > cur_ridx) {
+            return cur_widx - cur_ridx;
+        }
+        return llq_len - (cur_ridx - cur_widx);
+    }
+
+
+    /* target_level() returns the load shedding level for the current
+     * occupancy of the queue: reduced once it is half full, and
+     * summary once it is three quarters full.  A level is only left
+     * when the occupancy falls an eighth of the queue below the
+     * threshold at which it was entered, so that the writer does not
+     * switch back and forth on every message.  The drop level is set
+     * by the writer when init_msg() fails, and left on the next
+     * message that fits.  Only the writer may call this function.
+     */
+    int target_level() const {
+        uint64_t used = bytes_used();
+        int new_level = occupancy_level(used);
+        if (new_level < level) {
+            new_level = occupancy_level(used + llq_len / 8);
+        }
+        return new_level;
+    }
+
+    int occupancy_level(uint64_t used) const {
+        if (used >= llq_len / 4 * 3) {
+            return llq_level_summary;
+        }
+        if (used >= llq_len / 2) {
+            return llq_level_reduced;
+        }
+        return llq_level_full;
+    }
+
+
+    /* set_level() sets the load shedding level, and accounts for the
+     * time spent at the previous level; only the writer may call this
+     * function, but any thread may read the level and times
+     */
+    void set_level(int new_level) {
+        if (new_level == level) {
+            return;
+        }
+        uint64_t now = llq_monotonic_ns();
+        __atomic_store_n(&level_ns[level], level_ns[level] + (now - level_start), __ATOMIC_RELAXED);
+        __atomic_store_n(&level_start, now, __ATOMIC_RELAXED);
+        __atomic_store_n(&level, new_level, __ATOMIC_RELAXED);
+    }
+
+
+    /* level_time() returns the number of nanoseconds spent at level l
+     * up until the time now
+     */
+    uint64_t level_time(int l, uint64_t now) const {
+        uint64_t t = __atomic_load_n(&level_ns[l], __ATOMIC_RELAXED);
+        if (__atomic_load_n(&level, __ATOMIC_RELAXED) == l) {
+            uint64_t start = __atomic_load_n(&level_start, __ATOMIC_RELAXED);
+            if (now > start) {
+                t += now - start;
+            }
+        }
+        return t;
+    }
 };
 
 
@@ -25,6 +25,7 @@
 #include "output.h"
 #include "rnd_pkt_drop.h"
 #include "control.h"
+#include "metrics.h"
 
 char mercury_help[] =
     "%s [INPUT] [OUTPUT] [OPTIONS]:\n"
@@ -49,6 +50,13 @@ char mercury_help[] =
     "   --stats=f                             # write stats to file f\n"
     "   --stats-time=T                        # write stats every T seconds\n"
     "   --stats-limit=L                       # limit stats to L entries\n"
+    "   --stats-memory=M                      # approximate stats in M bytes\n"
+    "   --suppress-repeats=N                  # summarize repeated records, N per thread\n"
+    "   --suppress-timeout=T                  # summarize repeats every T seconds\n"
+    "   --load-shedding                       # shorten records before dropping them\n"
+    "   --nearest-fingerprint                 # report nearest known fingerprint (~10-50 us/lookup)\n"
+    "   --perf-counters=f                     # write per-stage cycle counts to file f\n"
+    "   --metrics=p                           # serve metrics on localhost port p\n"
     "   [-s or --select] filter               # select traffic by filter (see --help)\n"
     "   --nonselected-tcp-data                # tcp data for nonselected traffic\n"
     "   --nonselected-udp-data                # udp data for nonselected traffic\n"
@@ -166,6 +174,11 @@ char mercury_extended_help[] =
     "   object in the JSON records.   This option only works with the option\n"
     "   [-f or --fingerprint].\n"
     "\n"
+    "   When analysis is enabled, sending SIGHUP to mercury reloads the resource\n"
+    "   file in the background; packet processing continues with the previous\n"
+    "   resources until the new ones have been loaded, and flow and stats state\n"
+    "   is retained.\n"
+    "\n"
     "   \"--format=f\" reports fingerprints with formats(s) f, where f is either a\n"
     "   fingerprint protocol and format like \"tls/1\", or is a comma separated\n"
     "   list of below fingerprint protocol and format strings.\n"
@@ -175,6 +188,59 @@ char mercury_extended_help[] =
     "       quic\n"
     "       quic/1\n"
     "\n"
+    "   \"--perf-counters=f\" writes the number of CPU cycles spent in each stage\n"
+    "   of packet processing, and on each protocol, to JSON files with base name f,\n"
+    "   every stats-time seconds.  This option requires a libmerc built with\n"
+    "   \"make OPTFLAGS=-DLIBMERC_PERF_COUNTERS\".\n"
+    "\n"
+    "   \"--stats-memory=M\" gathers approximate stats within a fixed memory\n"
+    "   budget of M bytes, instead of counting every (source, fingerprint, user\n"
+    "   agent, destination) combination exactly.  For each fingerprint, the most\n"
+    "   frequent user agents and destinations are reported, with counts that may\n"
+    "   be overestimates, along with an estimate of the number of distinct\n"
+    "   sources; the records in the stats file have \"approximate\":true.\n"
+    "\n"
+    "   \"--suppress-repeats=N\" writes only the first of a set of records that\n"
+    "   have the same source and destination address, destination port,\n"
+    "   protocol, fingerprint, and server name, such as those from a client\n"
+    "   that repeatedly sends the same TLS client hello to the same server;\n"
+    "   other metadata may differ.  Each thread keeps up to N such records;\n"
+    "   when one has been kept for T seconds (\"--suppress-timeout=T\", by\n"
+    "   default 300), or is evicted to make room for another, a copy of it is\n"
+    "   written with a \"repeats\" object that holds the number of repeats that\n"
+    "   were suppressed and the times of the first record and the last repeat.\n"
+    "   Records without a fingerprint are repeats only if they are identical\n"
+    "   apart from their source port and time.\n"
+    "\n"
+    "   \"--load-shedding\" shortens the JSON records written by each thread as\n"
+    "   its output queue fills, instead of dropping records when the queue is\n"
+    "   full.  When the queue is half full, records hold only the fingerprint,\n"
+    "   flow key, and time, and \"verbosity\":\"reduced\"; when it is three quarters\n"
+    "   full, records hold only the protocol, a hash of the fingerprint, the flow\n"
+    "   key, and time, and \"verbosity\":\"summary\".  Full records are written\n"
+    "   again once the queue has drained.  The time each queue spends at each\n"
+    "   level is reported on exit, and by --metrics.  \"--output-delay=U\" makes\n"
+    "   the output thread wait U microseconds after writing each record, to test\n"
+    "   the behavior of mercury with a slow output device.\n"
+    "\n"
+    "   \"--nearest-fingerprint\" reports, in the analysis of each TLS or QUIC\n"
+    "   fingerprint that is not in the resource file, the most similar known\n"
+    "   fingerprint and its similarity, from 0 to 1, as a \"nearest\" object.  The\n"
+    "   similarity is one minus the edit distance between the fingerprints,\n"
+    "   counted in cipher suites, extensions, and other elements, over the length\n"
+    "   of the longer one; candidates are found with an approximate (MinHash)\n"
+    "   index, so a similar fingerprint is occasionally missed.  This option\n"
+    "   requires --analysis.  A lookup is done on the packet path, and takes\n"
+    "   roughly 10 to 50 microseconds, depending on the size of the resource\n"
+    "   file; each thread caches the results for 1024 fingerprints, so that a\n"
+    "   repeated fingerprint costs well under a microsecond, and makes at most\n"
+    "   1000 uncached lookups per second of packet time, beyond which no\n"
+    "   \"nearest\" object is reported.\n"
+    "\n"
+    "   \"--metrics=p\" serves capture, output queue, and analysis metrics in the\n"
+    "   Prometheus text format at http://localhost:p/metrics, for example with\n"
+    "   \"curl http://localhost:p/metrics\".\n"
+    "\n"
     "   \"[-l or --limit] l\" rotates output files so that each file has at most\n"
     "   l records or packets; filenames include a sequence number, date and time.\n"
     "\n"
@@ -251,6 +317,10 @@ int main(int argc, char *argv[]) {
     bool select_set = false;
     bool raw_features_set = false;
     bool crypto_assess_set = false;
+    bool stats_memory_set = false;
+    bool suppress_repeats_set = false;
+    bool suppress_timeout_set = false;
+    bool nearest_fingerprint_set = false;
     bool using_config_file = false;
 
     //extern double malware_prob_threshold;  // TODO - expose hidden command
@@ -258,7 +328,7 @@ int main(int argc, char *argv[]) {
     std::string additional_args;
 
     while(1) {
-        enum opt { config=1, version=2, license=3, dns_json=4, certs_json=5, metadata=6, resources=7, tcp_init_data=8, udp_init_data=9, write_stats=10, stats_limit=11, stats_time=12, output_time=13, reassembly=14, format=15, raw_features=16, crypto_assess=17, };
+        enum opt { config=1, version=2, license=3, dns_json=4, certs_json=5, metadata=6, resources=7, tcp_init_data=8, udp_init_data=9, write_stats=10, stats_limit=11, stats_time=12, output_time=13, reassembly=14, format=15, raw_features=16, crypto_assess=17, perf_counters=18, metrics=19, stats_memory=20, suppress_repeats=21, suppress_timeout=22, load_shedding=23, output_delay=24, nearest_fingerprint=25, };
         int opt_idx = 0;
         static struct option long_opts[] = {
             { "config",      required_argument, NULL, config  },
@@ -273,6 +343,14 @@ int main(int argc, char *argv[]) {
             { "nonselected-udp-data", no_argument, NULL, udp_init_data },
             { "stats-limit", required_argument, NULL, stats_limit },
             { "stats-time",  required_argument, NULL, stats_time },
+            { "stats-memory", required_argument, NULL, stats_memory },
+            { "suppress-repeats", required_argument, NULL, suppress_repeats },
+            { "suppress-timeout", required_argument, NULL, suppress_timeout },
+            { "load-shedding", no_argument,     NULL, load_shedding },
+            { "output-delay", required_argument, NULL, output_delay },
+            { "nearest-fingerprint", no_argument, NULL, nearest_fingerprint },
+            { "perf-counters", required_argument, NULL, perf_counters },
+            { "metrics",     required_argument, NULL, metrics },
             { "output-time", required_argument, NULL, output_time },
             { "reassembly",  no_argument,    NULL, reassembly },
             { "crypto-assess", optional_argument, NULL, crypto_assess },
@@ -543,6 +621,25 @@ int main(int argc, char *argv[]) {
                 usage(argv[0], "option stats-time requires a numeric argument", extended_help_off);
             }
             break;
+        case perf_counters:
+            if (option_is_valid(optarg)) {
+                cfg.perf_counters_filename = optarg;
+                additional_args.append("perf-counters;");
+            } else {
+                usage(argv[0], "option perf-counters requires filename argument", extended_help_off);
+            }
+            break;
+        case metrics:
+            if (option_is_valid(optarg)) {
+                errno = 0;
+                cfg.metrics_port = strtol(optarg, NULL, 10);
+                if (errno || cfg.metrics_port <= 0 || cfg.metrics_port > 65535) {
+                    usage(argv[0], "option metrics requires a port number argument", extended_help_off);
+                }
+            } else {
+                usage(argv[0], "option metrics requires a port number argument", extended_help_off);
+            }
+            break;
         case stats_limit:
             if (option_is_valid(optarg)) {
                 errno = 0;
@@ -554,6 +651,71 @@ int main(int argc, char *argv[]) {
                 usage(argv[0], "option stats-limit requires a numeric argument", extended_help_off);
             }
             break;
+        case stats_memory:
+            if (option_is_valid(optarg)) {
+                errno = 0;
+                unsigned long long bytes = strtoull(optarg, NULL, 10);
+                if (errno || bytes == 0) {
+                    usage(argv[0], "option stats-memory requires a positive numeric argument", extended_help_off);
+                }
+                additional_args.append("stats-memory=").append(std::to_string(bytes)).append(";");
+                stats_memory_set = true;
+            } else {
+                usage(argv[0], "option stats-memory requires a numeric argument", extended_help_off);
+            }
+            break;
+        case suppress_repeats:
+            if (option_is_valid(optarg)) {
+                errno = 0;
+                unsigned long long entries = strtoull(optarg, NULL, 10);
+                if (errno || entries == 0) {
+                    usage(argv[0], "option suppress-repeats requires a positive numeric argument", extended_help_off);
+                }
+                additional_args.append("suppress-repeats=").append(std::to_string(entries)).append(";");
+                suppress_repeats_set = true;
+            } else {
+                usage(argv[0], "option suppress-repeats requires a numeric argument", extended_help_off);
+            }
+            break;
+        case suppress_timeout:
+            if (option_is_valid(optarg)) {
+                errno = 0;
+                unsigned long seconds = strtoul(optarg, NULL, 10);
+                if (errno || seconds == 0) {
+                    usage(argv[0], "option suppress-timeout requires a positive numeric argument", extended_help_off);
+                }
+                additional_args.append("suppress-timeout=").append(std::to_string(seconds)).append(";");
+                suppress_timeout_set = true;
+            } else {
+                usage(argv[0], "option suppress-timeout requires a numeric argument", extended_help_off);
+            }
+            break;
+        case load_shedding:
+            if (optarg) {
+                usage(argv[0], "option load-shedding does not use an argument", extended_help_off);
+            } else {
+                cfg.load_shedding = true;
+            }
+            break;
+        case nearest_fingerprint:
+            if (optarg) {
+                usage(argv[0], "option nearest-fingerprint does not use an argument", extended_help_off);
+            } else {
+                additional_args.append("nearest-fingerprint;");
+                nearest_fingerprint_set = true;
+            }
+            break;
+        case output_delay:
+            if (option_is_valid(optarg)) {
+                errno = 0;
+                cfg.output_delay = strtoul(optarg, NULL, 10);
+                if (errno) {
+                    usage(argv[0], "option output-delay requires a numeric argument", extended_help_off);
+                }
+            } else {
+                usage(argv[0], "option output-delay requires a numeric argument", extended_help_off);
+            }
+            break;
         case output_time:
             if (option_is_valid(optarg)) {
                 errno = 0;
@@ -640,6 +802,24 @@ int main(int argc, char *argv[]) {
     if (libmerc_cfg.max_stats_entries && cfg.stats_filename == NULL) {
         usage(argv[0], "stats-limit set, but no stats file specified", extended_help_off);
     }
+    if (stats_memory_set && cfg.stats_filename == NULL) {
+        usage(argv[0], "stats-memory set, but no stats file specified", extended_help_off);
+    }
+    if (stats_memory_set && libmerc_cfg.max_stats_entries) {
+        usage(argv[0], "stats-limit and stats-memory are mutually exclusive", extended_help_off);
+    }
+    if (suppress_timeout_set && !suppress_repeats_set) {
+        usage(argv[0], "suppress-timeout set, but suppress-repeats not set", extended_help_off);
+    }
+    if (suppress_repeats_set && cfg.write_filename != NULL) {
+        usage(argv[0], "suppress-repeats cannot be used with --write", extended_help_off);
+    }
+    if (cfg.load_shedding && cfg.write_filename != NULL) {
+        usage(argv[0], "load-shedding cannot be used with --write", extended_help_off);
+    }
+    if (nearest_fingerprint_set && !libmerc_cfg.do_analysis) {
+        usage(argv[0], "nearest-fingerprint option requires --analysis", extended_help_off);
+    }
     if (cfg.stats_filename != NULL && !libmerc_cfg.do_analysis) {
         usage(argv[0], "stats option requires --analysis", extended_help_off);
     }
@@ -730,12 +910,28 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "error: unable to initialize output thread\n");
         return EXIT_FAILURE;
     }
+
+    std::unique_ptr<capture_metrics> cap_metrics;
+    std::unique_ptr<metrics_server> metrics_srv;
+    if (cfg.metrics_port) {
+        if (cfg.capture_interface) {
+            cap_metrics = std::make_unique<capture_metrics>(cfg.num_threads);
+        }
+        try {
+            metrics_srv = std::make_unique<metrics_server>(mc, cfg.metrics_port, &out_file, cap_metrics.get());
+        }
+        catch (std::exception &e) {
+            fprintf(stderr, "error: %s\n", e.what());
+            return EXIT_FAILURE;
+        }
+    }
+
     if (cfg.capture_interface) {
 
         if (cfg.verbosity) {
             fprintf(stderr, "initializing interface %s\n", cfg.capture_interface);
         }
-        if (bind_and_dispatch(&cfg, mc, &out_file, &cstats) != status_ok) {
+        if (bind_and_dispatch(&cfg, mc, &out_file, &cstats, cap_metrics.get()) != status_ok) {
             fprintf(stderr, "error: bind and dispatch failed\n");
             return EXIT_FAILURE;
         }
@@ -749,6 +945,7 @@ int main(int argc, char *argv[]) {
     if (cfg.verbosity) {
         fprintf(stderr, "stopping output thread and flushing queued output to disk.\n");
     }
+    metrics_srv.reset();  // stop serving metrics before the output queues are freed
     output_thread_finalize(&out_file);
 
 
@@ -46,6 +46,7 @@ struct mercury_config {
     char *write_filename;           /* base name of pcap file to write, if any        */
     char *fingerprint_filename;     /* base name of fingerprint file to write, if any */
     char *stats_filename;           /* base name of stats file to write, if any       */
+    char *perf_counters_filename;   /* base name of perf counters file, if any        */
     char *capture_interface;        /* base name of interface to capture from, if any */
     char *working_dir;              /* working directory                              */
     int flags;                      /* flags for open()                               */
@@ -62,7 +63,10 @@ struct mercury_config {
     int adaptive;                   /* adaptively accept/skip packets for PCAP output */
     bool output_block;              /* use blocking output                            */
     size_t stats_rotation_duration; /* number of seconds between stats file rotation  */
-    uint64_t out_rotation_duration; /* number of seconds between json file rotation  */}
+    uint64_t out_rotation_duration; /* number of seconds between json file rotation  */
+    int metrics_port;               /* local TCP port of metrics endpoint, or 0       */
+    bool load_shedding;             /* shorten JSON records as output queues fill     */
+    unsigned int output_delay;      /* microseconds to wait after each output record  */}
 ;
 
 
@@ -75,7 +79,7 @@ struct cap_stats {
 };
 
 
-#define mercury_config_init() { NULL, NULL, NULL, NULL, NULL, NULL, O_EXCL, (char *)"w", 0, 0.1, 0.8, 1, 0, NULL, 1, 0, 0, 0, false, 300, 0 }
+#define mercury_config_init() { NULL, NULL, NULL, NULL, NULL, NULL, NULL, O_EXCL, (char *)"w", 0, 0.1, 0.8, 1, 0, NULL, 1, 0, 0, 0, false, 300, 0, 0, false, 0 }
 
 
 #endif /* MERCURY_H */
@@ -0,0 +1,272 @@
+// metrics.h
+//
+// local HTTP endpoint that serves capture, output queue, and libmerc
+// metrics in the Prometheus text exposition format
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "output.h"
+#include "libmerc/libmerc.h"
+
+// struct capture_thread_metrics holds the counters for a single
+// capture thread.  Each counter has a single writer (the packet
+// worker or the af_packet stats thread), which updates it with a
+// relaxed load and store, so that workers never lock or contend; the
+// metrics server sums them when it is scraped.
+//
+struct capture_thread_metrics {
+    std::atomic<uint64_t> packets{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> socket_packets{0};
+    std::atomic<uint64_t> socket_drops{0};
+    std::atomic<uint64_t> socket_freezes{0};
+
+    static void add(std::atomic<uint64_t> &counter, uint64_t x) {
+        counter.store(counter.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+    }
+};
+
+// class capture_metrics holds a capture_thread_metrics for each
+// capture thread
+//
+class capture_metrics {
+    std::unique_ptr<capture_thread_metrics[]> threads;
+    size_t num_threads;
+
+public:
+
+    explicit capture_metrics(size_t n) : threads{new capture_thread_metrics[n]}, num_threads{n} { }
+
+    capture_thread_metrics *get(size_t thread) {
+        return thread < num_threads ? &threads[thread] : nullptr;
+    }
+
+    size_t size() const { return num_threads; }
+
+    const capture_thread_metrics &operator[](size_t thread) const { return threads[thread]; }
+};
+
+// class metrics_server accepts HTTP connections on a TCP port of the
+// loopback interface, and responds to each GET request for /metrics
+// with the current metrics, e.g. 'curl http://localhost:<port>/metrics'
+//
+class metrics_server {
+public:
+
+    metrics_server(mercury_context merc_ctx,
+                   uint16_t port,
+                   const struct output_file *out,
+                   const capture_metrics *capture) :
+        mc{merc_ctx},
+        out_file{out},
+        capture{capture},
+        sockfd{-1},
+        server_thread{},
+        shutdown_requested{false}
+    {
+        sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        if (sockfd < 0) {
+            throw std::runtime_error(std::string{"could not create metrics socket: "} + strerror(errno));
+        }
+        int reuse = 1;
+        setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(sockfd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(sockfd, 8) != 0) {
+            std::string err{strerror(errno)};
+            close(sockfd);
+            throw std::runtime_error("could not listen for metrics on port " + std::to_string(port) + ": " + err);
+        }
+        server_thread = std::thread( [this](){ run(); } );  // lambda just calls member function
+    }
+
+    ~metrics_server() {
+        shutdown_requested.store(true);
+        if (server_thread.joinable()) {
+            server_thread.join();
+        }
+        close(sockfd);
+    }
+
+    // get_metrics() returns the current metrics
+    //
+    std::string get_metrics() const {
+        std::string s;
+        write_capture_metrics(s);
+        write_output_metrics(s);
+
+        std::vector<char> buffer(65536);
+        size_t len = mercury_get_metrics(mc, buffer.data(), buffer.size());
+        s.append(buffer.data(), len);
+        return s;
+    }
+
+private:
+    mercury_context mc;
+    const struct output_file *out_file;
+    const capture_metrics *capture;
+    int sockfd;
+    std::thread server_thread;
+    std::atomic<bool> shutdown_requested;
+
+    static constexpr int poll_timeout_ms = 250;
+    static constexpr size_t max_request_size = 4096;
+
+    __attribute__((format(printf, 2, 3)))
+    static void appendf(std::string &s, const char *fmt, ...) {
+        char line[256];
+        va_list args;
+        va_start(args, fmt);
+        int len = vsnprintf(line, sizeof(line), fmt, args);
+        va_end(args);
+        if (len > 0) {
+            s.append(line, std::min((size_t)len, sizeof(line) - 1));
+        }
+    }
+
+    static void write_header(std::string &s, const char *name, const char *type, const char *help) {
+        appendf(s, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+
+    void write_capture_metrics(std::string &s) const {
+        if (capture == nullptr) {
+            return;
+        }
+        struct capture_counter {
+            const char *name;
+            const char *help;
+            const std::atomic<uint64_t> capture_thread_metrics::*counter;
+        } counters[] = {
+            { "mercury_capture_packets_total", "Number of packets processed by a capture thread.", &capture_thread_metrics::packets },
+            { "mercury_capture_bytes_total",   "Number of bytes processed by a capture thread.", &capture_thread_metrics::bytes },
+            { "mercury_socket_packets_total",  "Number of packets received by the socket of a capture thread.", &capture_thread_metrics::socket_packets },
+            { "mercury_socket_drops_total",    "Number of packets dropped by the socket of a capture thread.", &capture_thread_metrics::socket_drops },
+            { "mercury_socket_freezes_total",  "Number of queue freezes of the socket of a capture thread.", &capture_thread_metrics::socket_freezes },
+        };
+        for (const auto &c : counters) {
+            write_header(s, c.name, "counter", c.help);
+            for (size_t t = 0; t < capture->size(); t++) {
+                appendf(s, "%s{thread=\"%zu\"} %" PRIu64 "\n", c.name, t, ((*capture)[t].*(c.counter)).load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    void write_output_metrics(std::string &s) const {
+        if (out_file == nullptr) {
+            return;
+        }
+        const struct thread_queues &qs = out_file->qs;
+
+        write_header(s, "mercury_output_queue_fill_ratio", "gauge", "Fraction of an output queue that is in use.");
+        for (int q = 0; q < qs.qnum; q++) {
+            const struct ll_queue &llq = qs.queue[q];
+            appendf(s, "mercury_output_queue_fill_ratio{queue=\"%d\"} %f\n", q, (double)llq.bytes_used() / (double)llq.llq_len);
+        }
+
+        write_header(s, "mercury_output_queue_shedding_level", "gauge", "Load shedding level of an output queue (0=full, 1=reduced, 2=summary, 3=drop).");
+        for (int q = 0; q < qs.qnum; q++) {
+            appendf(s, "mercury_output_queue_shedding_level{queue=\"%d\"} %d\n", q, __atomic_load_n(&qs.queue[q].level, __ATOMIC_RELAXED));
+        }
+
+        static const char *level_name[LLQ_NUM_LEVELS] = { "full", "reduced", "summary", "drop" };
+        uint64_t now = llq_monotonic_ns();
+        write_header(s, "mercury_output_queue_shedding_seconds_total", "counter", "Time that an output queue has spent at each load shedding level.");
+        for (int q = 0; q < qs.qnum; q++) {
+            for (int l = 0; l < LLQ_NUM_LEVELS; l++) {
+                appendf(s, "mercury_output_queue_shedding_seconds_total{queue=\"%d\",level=\"%s\"} %f\n", q, level_name[l], qs.queue[q].level_time(l, now) / 1e9);
+            }
+        }
+
+        write_header(s, "mercury_output_queue_drops_total", "counter", "Number of records dropped because an output queue was full.");
+        for (int q = 0; q < qs.qnum; q++) {
+            appendf(s, "mercury_output_queue_drops_total{queue=\"%d\"} %" PRIu64 "\n", q, __atomic_load_n(&qs.queue[q].drops_total, __ATOMIC_RELAXED));
+        }
+
+        write_header(s, "mercury_output_queue_truncations_total", "counter", "Number of records dropped because they were truncated.");
+        for (int q = 0; q < qs.qnum; q++) {
+            appendf(s, "mercury_output_queue_truncations_total{queue=\"%d\"} %" PRIu64 "\n", q, __atomic_load_n(&qs.queue[q].drops_trunc_total, __ATOMIC_RELAXED));
+        }
+    }
+
+    void run() {
+        while (shutdown_requested.load() == false) {
+            struct pollfd pfd = { sockfd, POLLIN, 0 };
+            if (poll(&pfd, 1, poll_timeout_ms) <= 0) {
+                continue;
+            }
+            int connfd = accept(sockfd, nullptr, nullptr);
+            if (connfd < 0) {
+                continue;
+            }
+            handle_request(connfd);
+            close(connfd);
+        }
+    }
+
+    void handle_request(int connfd) const {
+        struct timeval timeout = { 1, 0 };
+        setsockopt(connfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        // read the request line and headers; the body, if any, is ignored
+        //
+        std::string request;
+        char buf[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < max_request_size) {
+            ssize_t n = recv(connfd, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                break;
+            }
+            request.append(buf, n);
+        }
+
+        std::string status{"200 OK"};
+        std::string body;
+        if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0) {
+            body = get_metrics();
+        } else if (request.compare(0, 4, "GET ") == 0) {
+            status = "404 Not Found";
+            body = "not found\n";
+        } else {
+            status = "405 Method Not Allowed";
+            body = "method not allowed\n";
+        }
+
+        std::string response{"HTTP/1.0 " + status + "\r\n"
+                             "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                             "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                             "Connection: close\r\n"
+                             "\r\n"};
+        response.append(body);
+
+        size_t sent = 0;
+        while (sent < response.size()) {
+            ssize_t n = send(connfd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                break;
+            }
+            sent += n;
+        }
+    }
+
+};
+
+#endif // METRICS_H
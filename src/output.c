@@ -60,6 +60,10 @@ void thread_queues_init(struct thread_queues *tqs, int n, float frac) {
         tqs->queue[i].widx = 0;
         tqs->queue[i].drops = 0;
         tqs->queue[i].drops_trunc = 0;
+        tqs->queue[i].drops_total = 0;
+        tqs->queue[i].drops_trunc_total = 0;
+        tqs->queue[i].level = llq_level_full;
+        tqs->queue[i].level_start = llq_monotonic_ns();
 
         tqs->queue[i].rbuf = (uint8_t *)calloc(tqs->queue[i].llq_len, sizeof(uint8_t));
 
@@ -406,6 +410,10 @@ void *output_thread_func(void *arg) {
                     fwrite(msg->buf, msg->len, 1, out_ctx->file_pri);
 
                     out_ctx->qs.queue[q].complete_read();
+
+                    if (out_ctx->output_delay) {
+                        usleep(out_ctx->output_delay);  /* simulate a slow output device (--output-delay) */
+                    }
                 }
             }
 
@@ -437,6 +445,7 @@ void *output_thread_func(void *arg) {
 
                 /* Subtract all the drops we just counted */
                 __sync_sub_and_fetch(&(out_ctx->qs.queue[q].drops), drops);
+                __atomic_store_n(&(out_ctx->qs.queue[q].drops_total), out_ctx->qs.queue[q].drops_total + drops, __ATOMIC_RELAXED);
 
             }
 
@@ -446,6 +455,7 @@ void *output_thread_func(void *arg) {
 
                 /* Subtract all the drops we just counted */
                 __sync_sub_and_fetch(&(out_ctx->qs.queue[q].drops_trunc), drops_trunc);
+                __atomic_store_n(&(out_ctx->qs.queue[q].drops_trunc_total), out_ctx->qs.queue[q].drops_trunc_total + drops_trunc, __ATOMIC_RELAXED);
 
             }
         }
@@ -470,6 +480,19 @@ void *output_thread_func(void *arg) {
     out_ctx->output_drops = total_drops;
     out_ctx->output_drops_trunc = total_drops_trunc;
 
+    /* Report the time that each queue spent shedding load, if any */
+    uint64_t now = llq_monotonic_ns();
+    for (int q = 0; q < out_ctx->qs.qnum; q++) {
+        const struct ll_queue &llq = out_ctx->qs.queue[q];
+        uint64_t reduced = llq.level_time(llq_level_reduced, now);
+        uint64_t summary = llq.level_time(llq_level_summary, now);
+        uint64_t dropping = llq.level_time(llq_level_drop, now);
+        if (reduced + summary + dropping > 0) {
+            fprintf(stderr, "[OUTPUT] Output queue %d shed load for %.3f s (%.3f s reduced, %.3f s summary, %.3f s dropping)\n",
+                    q, (reduced + summary + dropping) / 1e9, reduced / 1e9, summary / 1e9, dropping / 1e9);
+        }
+    }
+
     if (out_ctx->type != file_type_stdout) {
         close_outfiles(out_ctx);
     }
@@ -497,6 +520,7 @@ int output_thread_init(struct output_file &out_ctx, const struct mercury_config
         return -1;
     }
     out_ctx.t_output_p = 0;
+    out_ctx.output_delay = cfg.output_delay;
 
     //fprintf(stderr, "DEBUG: fingerprint filename: %s\n", cfg.fingerprint_filename);
     //fprintf(stderr, "DEBUG: max records: %ld\n", out_ctx.out_jf.max_records);
@@ -44,6 +44,7 @@ struct output_file {
     int sig_stop_output = 0;
     uint64_t output_drops = 0;
     uint64_t output_drops_trunc = 0;
+    unsigned int output_delay = 0;  /* microseconds to wait after each record */
     int from_network = 0;
 };
 
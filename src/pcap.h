@@ -9,6 +9,7 @@
 
 #include <locale.h>
 
+#include <time.h>
 #include <unistd.h>
 #include <variant>
 #include <cassert>
@@ -288,6 +289,10 @@ namespace pcap {
         }
 
         datum get_packet() const { return packet_data; }
+
+        struct timespec get_timestamp() const {
+            return { (time_t)timestamp_sec.value(), (long)timestamp_usec.value() * 1000 };
+        }
     };
 
 
@@ -302,7 +307,10 @@ namespace pcap {
 
         virtual const char *get_linktype() const = 0;
 
-        virtual std::pair<const uint8_t *, const uint8_t *> read_packet() = 0;
+        // read_packet() returns the next packet in the file, and sets
+        // ts to its timestamp, if ts is not nullptr
+        //
+        virtual std::pair<const uint8_t *, const uint8_t *> read_packet(struct timespec *ts=nullptr) = 0;
 
     };
 
@@ -365,10 +373,13 @@ namespace pcap {
             return linktype_name((enum LINKTYPE)linktype);
         }
 
-        std::pair<const uint8_t *, const uint8_t *> read_packet() {
+        std::pair<const uint8_t *, const uint8_t *> read_packet(struct timespec *ts=nullptr) {
 
             while (file.is_not_empty()) {
                 packet_record record{file, swap_byte_order};
+                if (ts) {
+                    *ts = record.get_timestamp();
+                }
                 return record.get_packet();
             }
             return { nullptr, nullptr }; // no more packets in file
@@ -1019,6 +1030,15 @@ namespace pcap::ng {
             return packet;
         }
 
+        // get_timestamp() returns the timestamp of the packet,
+        // assuming the default resolution of microseconds (that is,
+        // an interface without an if_tsresol option)
+        //
+        struct timespec get_timestamp() const {
+            uint64_t t = ((uint64_t)timestamp_hi.value() << 32) | timestamp_lo.value();
+            return { (time_t)(t / 1000000), (long)(t % 1000000) * 1000 };
+        }
+
         void write(writeable &buf) const {
             encoded<uint32_t> block_total_length = fixed_length + packet.length() + pad_len(packet.length());
             buf << block_header{enhanced_packet, block_total_length}
@@ -1372,7 +1392,7 @@ namespace pcap::ng {
             return linktype_name((enum LINKTYPE)linktype);
         }
 
-        std::pair<const uint8_t *, const uint8_t *> read_packet() {
+        std::pair<const uint8_t *, const uint8_t *> read_packet(struct timespec *ts=nullptr) {
 
             while (file.is_not_empty()) {
                 block_header block{file, swap_byte_order};
@@ -1383,6 +1403,9 @@ namespace pcap::ng {
                 }
                 if (block.type() == enhanced_packet) {
                     enhanced_packet_block epb{file, block.block_length(), swap_byte_order};
+                    if (ts) {
+                        *ts = epb.get_timestamp();
+                    }
                     datum tmp = epb.get_packet();
                     return { tmp.data, tmp.data_end };
 
@@ -1395,6 +1418,9 @@ namespace pcap::ng {
 
                 } else if (block.type() == simple_packet) {
                     simple_packet_block spb{file, block.block_length(), swap_byte_order};
+                    if (ts) {
+                        *ts = { 0, 0 };   // simple packet blocks have no timestamp
+                    }
                     datum tmp = spb.get_packet();
                     return { tmp.data, tmp.data_end };
 
@@ -1505,9 +1531,10 @@ namespace pcap {
         };
 
         struct read_packet_visitor{
+            struct timespec *ts;
             template <typename T>
             std::pair<const uint8_t *, const uint8_t *> operator()(T &r) {
-                return r.read_packet();
+                return r.read_packet(ts);
             }
             std::pair<const uint8_t *, const uint8_t *> operator()(std::monostate &) { return { nullptr, nullptr }; }
         };
@@ -1546,8 +1573,8 @@ namespace pcap {
             return std::visit(get_linktype_visitor{}, rdr);
         }
 
-        std::pair<const uint8_t *, const uint8_t *> read_packet() {
-            return std::visit(read_packet_visitor{}, rdr);
+        std::pair<const uint8_t *, const uint8_t *> read_packet(struct timespec *ts=nullptr) {
+            return std::visit(read_packet_visitor{ts}, rdr);
         }
 
         std::pair<uint16_t, uint16_t> get_version() {
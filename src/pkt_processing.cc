@@ -43,7 +43,7 @@ struct pkt_proc *pkt_proc_new_from_config(struct mercury_config *cfg,
              * write fingerprints into output file
              */
 
-            return new pkt_proc_json_writer_llq(mc, llq, cfg->output_block);
+            return new pkt_proc_json_writer_llq(mc, llq, cfg->output_block, cfg->load_shedding);
 
         }
 
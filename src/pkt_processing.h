@@ -38,6 +38,21 @@ struct packet_info {
 
 struct pkt_proc {
     virtual void apply(struct packet_info *pi, uint8_t *eth) = 0;
+
+    /*
+     * apply_batch() processes the num_pkts packets in the arrays pi
+     * and eth; packet processors that can take advantage of batching
+     * override this function, which otherwise applies apply() to
+     * each packet in turn
+     */
+    virtual void apply_batch(struct packet_info *pi, uint8_t **eth, size_t num_pkts) {
+        for (size_t i = 0; i < num_pkts; i++) {
+            apply(&pi[i], eth[i]);
+        }
+    }
+
+    static constexpr size_t max_batch_size = 64;
+
     virtual void flush() = 0;
     virtual void finalize() = 0;
     virtual ~pkt_proc() {};
@@ -170,7 +185,10 @@ struct pkt_proc_filter_pcap_writer : public pkt_proc {
 struct pkt_proc_json_writer_llq : public pkt_proc {
     struct ll_queue *llq;
     bool block;
+    bool shed_load;                // shorten records as the queue fills (--load-shedding)
     mercury_packet_processor processor;
+    struct timespec last_ts{};     // time of the last packet processed
+    time_t last_flush = 0;         // time of the last call to flush()
 
     /*
      * pkt_proc_json_writer(outfile_name, mode, max_records)
@@ -180,10 +198,12 @@ struct pkt_proc_json_writer_llq : public pkt_proc {
      * file is opened by this invocation, with that mode.  If
      * max_records is nonzero, then it defines the maximum number of
      * records (lines) per file; after that limit is reached, file
-     * rotation will take place.
+     * rotation will take place.  If load_shedding is true, then the
+     * verbosity of the records is reduced as the queue fills.
      */
-    explicit pkt_proc_json_writer_llq(mercury_context mc, struct ll_queue *llq_ptr, bool blocking) :
+    explicit pkt_proc_json_writer_llq(mercury_context mc, struct ll_queue *llq_ptr, bool blocking, bool load_shedding=false) :
         block{blocking},
+        shed_load{load_shedding},
         processor{NULL}
     {
         llq = llq_ptr;
@@ -193,22 +213,139 @@ struct pkt_proc_json_writer_llq : public pkt_proc {
         }
     }
 
+    /*
+     * adjust_verbosity() sets the load shedding level of the queue
+     * from its occupancy, and the verbosity of the packet processor
+     * to match that level
+     */
+    void adjust_verbosity() {
+        int level = llq->target_level();
+        if (level != llq->level) {
+            llq->set_level(level);
+            mercury_packet_processor_set_verbosity(processor, (enum record_verbosity)level);
+        }
+    }
+
     void apply(struct packet_info *pi, uint8_t *eth) override {
+        if (shed_load) {
+            adjust_verbosity();
+        }
         struct llq_msg *msg = llq->init_msg(block, pi->ts.tv_sec, pi->ts.tv_nsec);
         if (msg) {
             size_t write_len = mercury_packet_processor_write_json_linktype(processor, msg->buf, LLQ_MAX_MSG_SIZE, eth, pi->len, &(msg->ts), pi->linktype);
             if (write_len > 0) {
                 llq->send(write_len);
             }
+        } else if (shed_load) {
+            llq->set_level(llq_level_drop);
+        }
+        last_ts = pi->ts;
+    }
+
+    /*
+     * struct llq_output is the output of a batch of packets for
+     * stateful_pkt_proc::write_json_batch(); each record is written
+     * directly into its own message on the output queue
+     */
+    struct llq_output {
+        pkt_proc_json_writer_llq &writer;
+        struct packet_info *pi;
+
+        uint8_t *begin_record(size_t i, size_t *size) {
+            struct llq_msg *msg = writer.llq->init_msg(writer.block, pi[i].ts.tv_sec, pi[i].ts.tv_nsec);
+            if (msg == nullptr) {
+                if (writer.shed_load) {
+                    writer.llq->set_level(llq_level_drop);
+                }
+                return nullptr;
+            }
+            *size = LLQ_MAX_MSG_SIZE;
+            return msg->buf;
+        }
+        bool is_full() const { return false; }
+        void end_record(size_t, size_t length) {
+            if (length > 0) {
+                writer.llq->send(length);
+            }
+        }
+    };
+
+    /*
+     * apply_batch() processes a batch of packets with a single pass
+     * that prefetches packet data ahead of processing, writing each
+     * JSON record into the output queue
+     */
+    void apply_batch(struct packet_info *pi, uint8_t **eth, size_t num_pkts) override {
+        size_t lengths[max_batch_size];
+        struct timespec ts[max_batch_size];
+        uint16_t linktypes[max_batch_size];
+
+        while (num_pkts > 0) {
+            size_t batch_size = num_pkts < max_batch_size ? num_pkts : max_batch_size;
+            for (size_t i = 0; i < batch_size; i++) {
+                lengths[i] = pi[i].len;
+                ts[i] = pi[i].ts;
+                linktypes[i] = pi[i].linktype;
+            }
+            if (shed_load) {
+                adjust_verbosity();
+            }
+            llq_output out{*this, pi};
+            processor->write_json_batch(out, eth, lengths, ts, linktypes, batch_size);
+            last_ts = pi[batch_size - 1].ts;
+            pi += batch_size;
+            eth += batch_size;
+            num_pkts -= batch_size;
         }
     }
 
+    /*
+     * finalize() writes the summaries of any records that are being
+     * suppressed as repeats (--suppress-repeats), then destructs the
+     * packet processor
+     */
     void finalize() override {
+        while (true) {
+            struct llq_msg *msg = llq->init_msg(block, last_ts.tv_sec, last_ts.tv_nsec);
+            if (msg == nullptr) {
+                break;
+            }
+            size_t write_len = mercury_packet_processor_write_suppressed_json(processor, msg->buf, LLQ_MAX_MSG_SIZE, nullptr);
+            if (write_len == 0) {
+                break;
+            }
+            llq->send(write_len);
+        }
+        if (shed_load) {
+            llq->set_level(llq_level_full);   // stop accounting time to the shedding levels
+        }
         mercury_packet_processor_destruct(processor);
     }
 
+    /*
+     * flush() is called when the capture is idle; it writes the
+     * summaries of any suppressed records (--suppress-repeats) whose
+     * cache entries have expired, which would otherwise wait for the
+     * next packet; since entries expire after whole seconds, it does
+     * so at most once per second
+     */
     void flush() override {
-
+        struct timespec now;
+        if (clock_gettime(CLOCK_REALTIME, &now) != 0 || now.tv_sec == last_flush) {
+            return;
+        }
+        last_flush = now.tv_sec;
+        while (true) {
+            struct llq_msg *msg = llq->init_msg(block, now.tv_sec, now.tv_nsec);
+            if (msg == nullptr) {
+                break;
+            }
+            size_t write_len = mercury_packet_processor_write_suppressed_json(processor, msg->buf, LLQ_MAX_MSG_SIZE, &now);
+            if (write_len == 0) {
+                break;
+            }
+            llq->send(write_len);
+        }
     }
 
 };
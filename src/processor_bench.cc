@@ -0,0 +1,154 @@
+// processor_bench.cc
+//
+// benchmark for the specialized packet processors: processes the
+// packets in one or more Ethernet capture files with two packet
+// processors, one that uses the specialized ip_write_json() selected
+// for the protocols (if there is one) and one that uses the generic
+// implementation, checks that they write identical JSON records, and
+// reports the time taken per packet by each of them.  The packets are
+// read into memory before timing starts, and each pass uses fresh
+// timestamps, so that flows are not treated as duplicates of those in
+// a previous pass.
+//
+// usage: processor_bench [--iterations n] [--select protocols] [--resources file] pcap_file...
+//
+// e.g. processor_bench --select tls,http,quic ../test/data/top-https.mcap
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "pcap.h"
+#include "libmerc/libmerc.h"
+#include "libmerc/pkt_proc.h"
+
+// next_timestamp() advances ts by one microsecond
+//
+static void next_timestamp(struct timespec &ts) {
+    ts.tv_nsec += 1000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t iterations = 20;
+    std::string select = "tls,http,quic";
+    const char *resources = nullptr;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--select") == 0 && i + 1 < argc) {
+            select = argv[++i];
+        } else if (strcmp(argv[i], "--resources") == 0 && i + 1 < argc) {
+            resources = argv[++i];
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty() || iterations == 0) {
+        fprintf(stderr, "usage: %s [--iterations n] [--select protocols] [--resources file] pcap_file...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::vector<uint8_t>> packets;
+    try {
+        for (const char *f : files) {
+            pcap::file_reader pcap{f};
+            while (true) {
+                std::pair<const uint8_t *, const uint8_t *> pkt = pcap.read_packet();
+                if (pkt.first == nullptr) {
+                    break;
+                }
+                packets.emplace_back(pkt.first, pkt.second);
+            }
+        }
+    }
+    catch (std::exception &e) {
+        fprintf(stderr, "error: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    libmerc_config config;
+    config.packet_filter_cfg = (char *)select.c_str();
+    if (resources) {
+        config.do_analysis = true;
+        config.resources = (char *)resources;
+    }
+
+    // each processor has its own context, so that the state that the
+    // classifier learns from one processor's packets does not affect
+    // the results of the other
+    //
+    mercury_context mc = mercury_init(&config, 0);
+    mercury_context generic_mc = mercury_init(&config, 0);
+    if (mc == nullptr || generic_mc == nullptr) {
+        fprintf(stderr, "error: mercury_init() failed\n");
+        return EXIT_FAILURE;
+    }
+    mercury_packet_processor specialized = mercury_packet_processor_construct(mc);
+    mercury_packet_processor generic = mercury_packet_processor_construct(generic_mc);
+    if (specialized == nullptr || generic == nullptr) {
+        fprintf(stderr, "error: mercury_packet_processor_construct() failed\n");
+        return EXIT_FAILURE;
+    }
+    const char *name = specialized->select_processor();
+    generic->select_processor(true);
+
+    // check that both processors write the same records
+    //
+    std::vector<char> buffer(65536), generic_buffer(65536);
+    size_t records = 0;
+    size_t mismatches = 0;
+    struct timespec ts{1634846862, 105263000};
+    for (auto &p : packets) {
+        next_timestamp(ts);
+        struct timespec generic_ts{ts};
+        size_t length = mercury_packet_processor_write_json(specialized, buffer.data(), buffer.size(), p.data(), p.size(), &ts);
+        size_t generic_length = mercury_packet_processor_write_json(generic, generic_buffer.data(), generic_buffer.size(), p.data(), p.size(), &generic_ts);
+        if (length != generic_length || memcmp(buffer.data(), generic_buffer.data(), length) != 0) {
+            mismatches++;
+        }
+        if (length != 0) {
+            records++;
+        }
+    }
+
+    // time each processor in turn
+    //
+    auto ns_per_packet = [&](mercury_packet_processor mpp) {
+        ts.tv_sec += 3600;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            for (auto &p : packets) {
+                next_timestamp(ts);
+                mercury_packet_processor_write_json(mpp, buffer.data(), buffer.size(), p.data(), p.size(), &ts);
+            }
+            ts.tv_sec += 3600;
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count() / (packets.size() * iterations);
+    };
+    double generic_ns = ns_per_packet(generic);
+    double specialized_ns = ns_per_packet(specialized);
+
+    fprintf(stdout, "selected protocols:       %s\n", select.c_str());
+    fprintf(stdout, "specialized processor:    %s\n", name);
+    fprintf(stdout, "packets:                  %zu\n", packets.size());
+    fprintf(stdout, "records:                  %zu\n", records);
+    fprintf(stdout, "mismatched records:       %zu\n", mismatches);
+    fprintf(stdout, "generic ns per packet:    %.1f\n", generic_ns);
+    fprintf(stdout, "specialized ns per packet: %.1f\n", specialized_ns);
+
+    mercury_packet_processor_destruct(specialized);
+    mercury_packet_processor_destruct(generic);
+    mercury_finalize(mc);
+    mercury_finalize(generic_mc);
+
+    return mismatches ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,146 @@
+// quic_initial_bench.cc
+//
+// benchmark for the decryption of QUIC Initial packets: replays the
+// QUIC long header packets in one or more Ethernet capture files
+// through quic_crypto_engine::decrypt(), and reports the time taken
+// per packet, for the packets as captured, and for the same packets
+// with their versions replaced by unknown values, as in a flood of
+// garbage to UDP port 443.  The packets are read into memory before
+// timing starts, and each pass uses a new quic_crypto_engine, so that
+// the per-engine key cache only helps within a pass.
+//
+// usage: quic_initial_bench [--iterations n] pcap_file...
+//
+// e.g. quic_initial_bench ../unit_tests/pcaps/quic-crypto-packets.pcap
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "pcap.h"
+#include "libmerc/quic.h"
+
+// udp_payload() returns the UDP payload of an Ethernet frame that
+// carries IPv4 or IPv6, possibly with VLAN tags, or an empty datum
+//
+static datum udp_payload(datum frame) {
+    frame.skip(12);
+    uint16_t ethertype = 0;
+    frame.read_uint16(&ethertype);
+    while (ethertype == 0x8100 || ethertype == 0x88a8) {
+        frame.skip(2);
+        frame.read_uint16(&ethertype);
+    }
+    uint8_t protocol = 0;
+    if (ethertype == 0x0800) {
+        uint8_t version_ihl = 0;
+        frame.lookahead_uint8(&version_ihl);
+        frame.skip(9);
+        frame.read_uint8(&protocol);
+        frame.skip((version_ihl & 0x0f) * 4 - 10);
+    } else if (ethertype == 0x86dd) {
+        frame.skip(6);
+        frame.read_uint8(&protocol);
+        frame.skip(33);
+    } else {
+        return {nullptr, nullptr};
+    }
+    if (protocol != 17) {
+        return {nullptr, nullptr};
+    }
+    frame.skip(8);
+    if (!frame.is_not_empty()) {
+        return {nullptr, nullptr};
+    }
+    return frame;
+}
+
+// ns_per_packet() returns the mean time taken to decrypt each of the
+// packets, over the given number of passes, and sets decrypted to
+// the number of packets that were decrypted in the last pass
+//
+static double ns_per_packet(const std::vector<std::vector<uint8_t>> &packets, size_t iterations, size_t &decrypted) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        auto engine = std::make_unique<quic_crypto_engine>();
+        decrypted = 0;
+        for (const auto &p : packets) {
+            datum d{p.data(), p.data() + p.size()};
+            quic_initial_packet pkt{d};
+            if (pkt.is_not_empty() && engine->decrypt(pkt).is_not_empty()) {
+                decrypted++;
+            }
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return ns / (packets.size() * iterations);
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t iterations = 10;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoul(argv[++i], nullptr, 10);
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty() || iterations == 0) {
+        fprintf(stderr, "usage: %s [--iterations n] pcap_file...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // collect the UDP payloads that start with a QUIC long header
+    //
+    std::vector<std::vector<uint8_t>> packets;
+    try {
+        for (const char *f : files) {
+            pcap::file_reader pcap{f};
+            while (true) {
+                std::pair<const uint8_t *, const uint8_t *> pkt = pcap.read_packet();
+                if (pkt.first == nullptr) {
+                    break;
+                }
+                datum payload = udp_payload({pkt.first, pkt.second});
+                if (payload.length() > 5 && (payload.data[0] & 0xc0) == 0xc0) {
+                    packets.emplace_back(payload.data, payload.data_end);
+                }
+            }
+        }
+    }
+    catch (std::exception &e) {
+        fprintf(stderr, "error: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    if (packets.empty()) {
+        fprintf(stderr, "error: no QUIC long header packets found\n");
+        return EXIT_FAILURE;
+    }
+
+    // the same packets, with sixteen different unknown versions
+    //
+    std::vector<std::vector<uint8_t>> unknown_versions{packets};
+    for (size_t i = 0; i < unknown_versions.size(); i++) {
+        uint8_t *version = unknown_versions[i].data() + 1;
+        version[0] = 0x5a;
+        version[1] = 0x5a;
+        version[2] = 0x5a;
+        version[3] = 0x50 + (i % 16);
+    }
+
+    size_t decrypted = 0;
+    double ns = ns_per_packet(packets, iterations, decrypted);
+    fprintf(stdout, "long header packets:          %zu\n", packets.size());
+    fprintf(stdout, "decrypted per pass:           %zu\n", decrypted);
+    fprintf(stdout, "ns per packet:                %.1f\n", ns);
+
+    ns = ns_per_packet(unknown_versions, iterations, decrypted);
+    fprintf(stdout, "ns per unknown-version packet: %.1f\n", ns);
+
+    return 0;
+}
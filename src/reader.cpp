@@ -23,6 +23,10 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "error: ipv4_address_string::unit_test() failed\n");
         return EXIT_FAILURE;
     }
+    if (watchlist::unit_test() == false) {
+        fprintf(stderr, "error: watchlist::unit_test() failed\n");
+        return EXIT_FAILURE;
+    }
 
     std::ifstream doh_file{"doh.txt"};
     watchlist doh{doh_file};
@@ -20,6 +20,7 @@
 #include "af_packet_v3.h"
 
 volatile sig_atomic_t sig_close_flag = 0; /* Watched by the threads while processing packets */
+volatile sig_atomic_t sig_reload_flag = 0; /* Watched by the control thread */
 
 /*
  * sig_close() causes a graceful shutdown of the program after recieving
@@ -42,6 +43,18 @@ void sig_close (int signal_arg) {
     errno = saved_errno; /* restore */
 }
 
+/*
+ * sig_reload() requests that the resource file be reloaded, without
+ * interrupting packet processing; the reload itself is performed by
+ * the control thread
+ */
+void sig_reload (int signal_arg) {
+
+    (void)signal_arg; /* "use" argument */
+
+    sig_reload_flag = 1; /* tell the control thread to reload resources */
+}
+
 
 __attribute__((noreturn)) void sig_backtrace (int signal_arg) {
 
@@ -139,6 +152,15 @@ enum status setup_signal_handler() {
         return status_err;
     }
 
+    /* kill -HUP causes resource file to be reloaded */
+    memset(&sa, 0, sizeof(sa));
+
+    sa.sa_handler = sig_reload;
+
+    if (sigaction(SIGHUP, &sa, &old_sa) != 0) {
+        perror("Unable to register sig_reload() for SIGHUP");
+        return status_err;
+    }
 
     /* kill -USR1 causes (thread) to print backtrace */
     memset(&sa, 0, sizeof(sa));
@@ -14,10 +14,13 @@
 #include "mercury.h"
 
 extern volatile sig_atomic_t sig_close_flag; /* Watched by the threads while processing packets */
+extern volatile sig_atomic_t sig_reload_flag; /* Watched by the control thread */
 extern struct thread_stall *global_thread_stall;
 
 void sig_close (int signal_arg);
 
+void sig_reload (int signal_arg);
+
 void sig_backtrace (int signal_arg);
 void sig_init_backtrace();
 
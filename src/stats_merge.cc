@@ -0,0 +1,566 @@
+/*
+ * stats_merge.cc
+ *
+ * merge the compressed JSON stats files written by mercury --stats
+ * (or libmerc's mercury_write_stats_data()) on multiple sensors, or
+ * over multiple intervals, into a single stats file in the same
+ * format
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc.  All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <queue>
+#include <memory>
+#include <zlib.h>
+
+#include "libmerc/archive.h"
+#include "libmerc/json_object.h"
+#include "libmerc/rapidjson/document.h"
+
+// A stats file has one JSON record per line; each record holds the
+// fingerprints, user agents, and destinations observed for one source
+// address (or, for approximate stats, for one fingerprint, with the
+// source address "*").  stats_merge reads each of its inputs as a
+// stream of records ordered by source address, and merges them with
+// a k-way heap, so that only one record per input is held in memory.
+// The counts for each (source, fingerprint, user agent, destination)
+// are summed, and the merged records are written in order of source
+// address, so that the output can itself be merged.
+//
+// Files written by older versions of libmerc are not ordered by
+// source address; each such input is first sorted into temporary
+// runs, each of which fits within the memory limit, and those runs
+// are then merged along with the other inputs.
+
+// class stats_record holds one record of a stats file, or the merger
+// of several records for the same source address
+//
+class stats_record {
+public:
+    struct fingerprint {
+        uint64_t count = 0;         // approximate stats only
+        double src_ip_count = 0.0;  // approximate stats only
+        std::map<std::string, std::map<std::string, uint64_t>> sessions;  // user agent -> dst -> count
+    };
+
+    std::string src_ip;
+    bool approximate = false;
+    std::string init_time;
+    std::string version;
+    std::string resource_version;
+    std::string build_number;
+    std::string git_commit_id;
+    std::map<std::string, fingerprint> fingerprints;
+
+private:
+    size_t bytes = 0;   // approximate amount of memory used
+
+    static std::string get_string(const rapidjson::Value &v, const char *key) {
+        if (v.HasMember(key) && v[key].IsString()) {
+            return { v[key].GetString(), v[key].GetStringLength() };
+        }
+        return "";
+    }
+
+    static uint64_t get_uint(const rapidjson::Value &v, const char *key) {
+        if (v.HasMember(key) && v[key].IsUint64()) {
+            return v[key].GetUint64();
+        }
+        return 0;
+    }
+
+    static constexpr size_t map_node_overhead = 64;
+
+public:
+
+    bool empty() const { return fingerprints.empty(); }
+
+    size_t memory() const { return bytes; }
+
+    // parse() reads a record from a line of JSON, and returns false
+    // if it is not a valid stats record
+    //
+    bool parse(const std::string &line) {
+        rapidjson::Document d;
+        d.Parse(line.c_str(), line.length());
+        if (d.HasParseError() || !d.IsObject() || !d.HasMember("src_ip") || !d["src_ip"].IsString()
+            || !d.HasMember("fingerprints") || !d["fingerprints"].IsArray()) {
+            return false;
+        }
+        clear();
+        src_ip = get_string(d, "src_ip");
+        approximate = d.HasMember("approximate") && d["approximate"].IsBool() && d["approximate"].GetBool();
+        init_time = get_string(d, "libmerc_init_time");
+        version = get_string(d, "libmerc_version");
+        resource_version = get_string(d, "resource_version");
+        build_number = get_string(d, "build_number");
+        git_commit_id = get_string(d, "git_commit_id");
+        bytes = sizeof(*this) + line.length();
+        for (const auto &f : d["fingerprints"].GetArray()) {
+            if (!f.IsObject() || !f.HasMember("sessions") || !f["sessions"].IsArray()) {
+                return false;
+            }
+            fingerprint &fp = fingerprints[get_string(f, "str_repr")];
+            fp.count += get_uint(f, "count");
+            if (f.HasMember("src_ip_count") && f["src_ip_count"].IsNumber()) {
+                fp.src_ip_count += f["src_ip_count"].GetDouble();
+            }
+            for (const auto &s : f["sessions"].GetArray()) {
+                if (!s.IsObject() || !s.HasMember("dest_info") || !s["dest_info"].IsArray()) {
+                    return false;
+                }
+                auto &dsts = fp.sessions[get_string(s, "user_agent")];
+                for (const auto &dst : s["dest_info"].GetArray()) {
+                    if (!dst.IsObject()) {
+                        return false;
+                    }
+                    dsts[get_string(dst, "dst")] += get_uint(dst, "count");
+                    bytes += map_node_overhead;
+                }
+            }
+        }
+        return true;
+    }
+
+    // merge() adds the counts in r to this record, which takes its
+    // metadata from the first record merged into it
+    //
+    void merge(stats_record &r) {
+        if (empty()) {
+            std::swap(*this, r);
+            return;
+        }
+        approximate |= r.approximate;
+        for (auto &[str_repr, f] : r.fingerprints) {
+            auto [it, inserted] = fingerprints.try_emplace(str_repr);
+            if (inserted) {
+                it->second = std::move(f);
+                continue;
+            }
+            fingerprint &fp = it->second;
+            fp.count += f.count;
+            fp.src_ip_count += f.src_ip_count;  // an upper bound, as sources may be shared
+            for (auto &[user_agent, dsts] : f.sessions) {
+                auto &merged_dsts = fp.sessions[user_agent];
+                for (const auto &[dst, count] : dsts) {
+                    merged_dsts[dst] += count;
+                }
+            }
+        }
+        bytes += r.bytes;
+        r.clear();
+    }
+
+    void clear() {
+        src_ip.clear();
+        approximate = false;
+        fingerprints.clear();
+        bytes = 0;
+    }
+
+    // write() writes this record to f, as a single line of JSON, or,
+    // for approximate stats, as one line per fingerprint, as libmerc
+    // does
+    //
+    bool write(gzFile f, std::vector<char> &buffer) const {
+        if (!approximate) {
+            return write_line(f, buffer, fingerprints.begin(), fingerprints.end());
+        }
+        for (auto it = fingerprints.begin(); it != fingerprints.end(); ++it) {
+            if (!write_line(f, buffer, it, std::next(it))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+
+    static void print_key_string(json_object &o, const char *key, const std::string &s) {
+        o.print_key_json_string(key, (const uint8_t *)s.data(), s.length());
+    }
+
+    bool write_line(gzFile f,
+                    std::vector<char> &buffer,
+                    std::map<std::string, fingerprint>::const_iterator begin,
+                    std::map<std::string, fingerprint>::const_iterator end) const {
+
+        // size the buffer so that the record cannot be truncated, even
+        // if every character needs to be escaped
+        //
+        size_t length = 1024 + 8 * (src_ip.length() + init_time.length() + version.length() + resource_version.length()
+                                    + build_number.length() + git_commit_id.length());
+        for (auto it = begin; it != end; ++it) {
+            length += 128 + 8 * it->first.length();
+            for (const auto &[user_agent, dsts] : it->second.sessions) {
+                length += 64 + 8 * user_agent.length();
+                for (const auto &dst : dsts) {
+                    length += 64 + 8 * dst.first.length();
+                }
+            }
+        }
+        if (buffer.size() < length) {
+            buffer.resize(length);
+        }
+
+        buffer_stream buf{buffer.data(), (int)buffer.size()};
+        json_object record{&buf};
+        print_key_string(record, "src_ip", src_ip);
+        if (approximate) {
+            record.print_key_bool("approximate", true);
+        }
+        print_key_string(record, "libmerc_init_time", init_time);
+        print_key_string(record, "libmerc_version", version);
+        print_key_string(record, "resource_version", resource_version);
+        print_key_string(record, "build_number", build_number);
+        print_key_string(record, "git_commit_id", git_commit_id);
+        json_array fps{record, "fingerprints"};
+        for (auto it = begin; it != end; ++it) {
+            json_object fp{fps};
+            print_key_string(fp, "str_repr", it->first);
+            if (approximate) {
+                fp.print_key_uint("count", it->second.count);
+                fp.print_key_uint("src_ip_count", (unsigned long)(it->second.src_ip_count + 0.5));
+            }
+            json_array sessions{fp, "sessions"};
+            for (const auto &[user_agent, dsts] : it->second.sessions) {
+                json_object session{sessions};
+                if (!user_agent.empty()) {
+                    print_key_string(session, "user_agent", user_agent);
+                }
+                json_array dest_info{session, "dest_info"};
+                for (const auto &[dst, count] : dsts) {
+                    json_object d{dest_info};
+                    print_key_string(d, "dst", dst);
+                    d.print_key_uint("count", count);
+                    d.close();
+                }
+                dest_info.close();
+                session.close();
+            }
+            sessions.close();
+            fp.close();
+        }
+        fps.close();
+        record.close();
+        buf.write_char('\n');
+        if (buf.trunc) {
+            fprintf(stderr, "error: stats record for %s is too long\n", src_ip.c_str());
+            return false;
+        }
+        return gzwrite(f, buf.dstr, buf.length()) == (int)buf.length();
+    }
+};
+
+// class stats_reader reads the records of a stats file in order
+//
+class stats_reader {
+    std::string file_name;
+    gz_file gz;
+    std::string line;
+    size_t line_number = 0;
+    std::string previous_src_ip;
+
+public:
+    stats_record record;
+
+    explicit stats_reader(const std::string &name) : file_name{name}, gz{name.c_str(), nullptr} { }
+
+    // next() reads the next record, and returns false at the end of
+    // the file; invalid records are skipped with a warning
+    //
+    bool next() {
+        while (gz.getline(line, SSIZE_MAX) > 0) {
+            ++line_number;
+            if (record.parse(line)) {
+                return true;
+            }
+            fprintf(stderr, "warning: skipping invalid stats record at %s:%zu\n", file_name.c_str(), line_number);
+        }
+        record.clear();
+        return false;
+    }
+
+    // next_in_order() is like next(), but also returns false if the
+    // record is out of order
+    //
+    bool next_in_order(bool &out_of_order) {
+        out_of_order = false;
+        if (!next()) {
+            return false;
+        }
+        if (line_number > 1 && record.src_ip < previous_src_ip) {
+            out_of_order = true;
+            return false;
+        }
+        previous_src_ip = record.src_ip;
+        return true;
+    }
+
+    const std::string &name() const { return file_name; }
+};
+
+// is_sorted() returns true if the source addresses of the records in
+// a stats file are in nondecreasing order; it does not parse the
+// records, just the src_ip field at the start of each line
+//
+static bool is_sorted(const std::string &file_name) {
+    gz_file gz{file_name.c_str(), nullptr};
+    std::string line;
+    std::string previous;
+    static const char key[] = "\"src_ip\":\"";
+    while (gz.getline(line, SSIZE_MAX) > 0) {
+        size_t start = line.find(key);
+        if (start == std::string::npos) {
+            continue;    // invalid record, which will be skipped
+        }
+        start += sizeof(key) - 1;
+        size_t end = line.find('"', start);
+        if (end == std::string::npos) {
+            continue;
+        }
+        std::string src_ip = line.substr(start, end - start);
+        if (src_ip < previous) {
+            return false;
+        }
+        previous.swap(src_ip);
+    }
+    return true;
+}
+
+// class temporary_files creates temporary stats files, and removes
+// them when it is destroyed
+//
+class temporary_files {
+    std::vector<std::string> names;
+
+public:
+    ~temporary_files() {
+        for (const auto &n : names) {
+            unlink(n.c_str());
+        }
+    }
+
+    gzFile create(std::string &name) {
+        const char *tmpdir = getenv("TMPDIR");
+        std::string tmpl = std::string{tmpdir ? tmpdir : "/tmp"} + "/stats_merge.XXXXXX";
+        int fd = mkstemp(tmpl.data());
+        if (fd < 0) {
+            return nullptr;
+        }
+        names.push_back(tmpl);
+        name = tmpl;
+        return gzdopen(fd, "w1");   // fast compression, as runs are read only once
+    }
+};
+
+// sort_into_runs() reads a stats file whose records are not in order,
+// merges records with the same source address, and writes them in
+// order to temporary files, each holding at most memory_limit bytes
+// worth of records; it returns the names of those files
+//
+static bool sort_into_runs(const std::string &file_name,
+                           size_t memory_limit,
+                           temporary_files &tmp,
+                           std::vector<std::string> &runs) {
+
+    stats_reader reader{file_name};
+    std::map<std::string, stats_record> records;
+    size_t memory = 0;
+    std::vector<char> buffer;
+
+    auto write_run = [&]() {
+        std::string run_name;
+        gzFile f = tmp.create(run_name);
+        if (f == nullptr) {
+            fprintf(stderr, "error: could not create temporary file (%s)\n", strerror(errno));
+            return false;
+        }
+        bool ok = true;
+        for (const auto &r : records) {
+            ok &= r.second.write(f, buffer);
+        }
+        ok &= (gzclose(f) == Z_OK);
+        if (!ok) {
+            fprintf(stderr, "error: could not write temporary file %s\n", run_name.c_str());
+            return false;
+        }
+        runs.push_back(run_name);
+        records.clear();
+        memory = 0;
+        return true;
+    };
+
+    while (reader.next()) {
+        memory += reader.record.memory();
+        records[reader.record.src_ip].merge(reader.record);
+        if (memory > memory_limit && !write_run()) {
+            return false;
+        }
+    }
+    if (!records.empty() && !write_run()) {
+        return false;
+    }
+    return true;
+}
+
+// merge() merges the records in the inputs, which must each be in
+// order, and writes them to output
+//
+static bool merge(const std::vector<std::string> &inputs, gzFile output) {
+
+    std::vector<std::unique_ptr<stats_reader>> readers;
+    for (const auto &name : inputs) {
+        readers.push_back(std::make_unique<stats_reader>(name));
+    }
+
+    // the heap holds the index of each reader that has a record,
+    // ordered by the source address of that record, then by index,
+    // so that records are merged in the order of the inputs
+    //
+    auto greater = [&readers](size_t l, size_t r) {
+        int cmp = readers[l]->record.src_ip.compare(readers[r]->record.src_ip);
+        return cmp > 0 || (cmp == 0 && l > r);
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap{greater};
+
+    auto advance = [&](size_t i) {
+        bool out_of_order;
+        if (readers[i]->next_in_order(out_of_order)) {
+            heap.push(i);
+        } else if (out_of_order) {
+            fprintf(stderr, "error: records in %s are out of order\n", readers[i]->name().c_str());
+            return false;
+        }
+        return true;
+    };
+
+    for (size_t i = 0; i < readers.size(); i++) {
+        if (!advance(i)) {
+            return false;
+        }
+    }
+
+    stats_record merged;
+    std::vector<char> buffer;
+    while (!heap.empty()) {
+        size_t i = heap.top();
+        heap.pop();
+        if (!merged.empty() && merged.src_ip != readers[i]->record.src_ip) {
+            if (!merged.write(output, buffer)) {
+                return false;
+            }
+            merged.clear();
+        }
+        merged.merge(readers[i]->record);
+        if (!advance(i)) {
+            return false;
+        }
+    }
+    if (!merged.empty() && !merged.write(output, buffer)) {
+        return false;
+    }
+    return true;
+}
+
+static void usage(const char *progname) {
+    fprintf(stderr,
+            "usage: %s [--output file] [--memory bytes] stats_file [stats_file ...]\n"
+            "\n"
+            "merges stats files (.json.gz) written by mercury --stats, summing the\n"
+            "counts for each source, fingerprint, user agent, and destination, and\n"
+            "writes the result as a stats file in the same format, ordered by source\n"
+            "address\n"
+            "\n"
+            "OPTIONS\n"
+            "   --output file     write merged stats to file (default: standard output)\n"
+            "   --memory bytes    memory limit for sorting unordered inputs (default: 256000000)\n"
+            "   --help            print this message\n",
+            progname);
+}
+
+int main(int argc, char *argv[]) {
+
+    const char *output_file = nullptr;
+    size_t memory_limit = 256000000;
+
+    static struct option long_opts[] = {
+        { "output", required_argument, nullptr, 'o' },
+        { "memory", required_argument, nullptr, 'm' },
+        { "help",   no_argument,       nullptr, 'h' },
+        { nullptr,  0,                 nullptr, 0   }
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "o:m:h", long_opts, nullptr)) != -1) {
+        switch (c) {
+        case 'o':
+            output_file = optarg;
+            break;
+        case 'm':
+            errno = 0;
+            memory_limit = strtoull(optarg, nullptr, 10);
+            if (errno || memory_limit == 0) {
+                fprintf(stderr, "error: invalid memory limit %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'h':
+            usage(argv[0]);
+            return EXIT_SUCCESS;
+        default:
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind == argc) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        // sort any unordered inputs into temporary runs
+        //
+        temporary_files tmp;
+        std::vector<std::string> inputs;
+        for (int i = optind; i < argc; i++) {
+            if (access(argv[i], R_OK) != 0) {
+                fprintf(stderr, "error: could not read %s (%s)\n", argv[i], strerror(errno));
+                return EXIT_FAILURE;
+            }
+            if (is_sorted(argv[i])) {
+                inputs.push_back(argv[i]);
+            } else {
+                fprintf(stderr, "note: %s is not ordered by source address, sorting it\n", argv[i]);
+                if (!sort_into_runs(argv[i], memory_limit, tmp, inputs)) {
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+
+        gzFile output = output_file ? gzopen(output_file, "w") : gzdopen(dup(STDOUT_FILENO), "w");
+        if (output == nullptr) {
+            fprintf(stderr, "error: could not open output %s\n", output_file ? output_file : "(stdout)");
+            return EXIT_FAILURE;
+        }
+        bool ok = merge(inputs, output);
+        if (gzclose(output) != Z_OK) {
+            fprintf(stderr, "error: could not write output %s\n", output_file ? output_file : "(stdout)");
+            ok = false;
+        }
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    catch (std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -2,15 +2,19 @@
  * string.cc
  *
  * run string algorithms (edit distance, longest common subsequence,
- * longest common substring, matching substrings)
+ * longest common substring, matching substrings), and find the
+ * nearest known fingerprint to each input string
  */
 
 #include <stdio.h>
 #include <algorithm>      // for std::sort()
 #include <numeric>        // for std::iota()
 #include <cassert>
+#include <chrono>
+#include <fstream>
 #include "stringalgs.h"
 #include "options.h"
+#include "libmerc/fingerprint_index.hpp"
 
 // create_sorted_index(v) returns a vector of indices that sort the
 // input vector v into ascending order
@@ -43,6 +47,7 @@ int main(int argc, char *argv[]) {
         { argument::none,       "--matching",      "method: compute matching substrings" },
         { argument::none,       "--hamming",       "method: compute hamming distance" },
         { argument::none,       "--find-mask",     "method: find common mask and value" },
+        { argument::required,   "--nearest",       "method: find nearest fingerprint in file <arg>" },
         { argument::none,       "--average",       "report average distance to all other strings" },
         { argument::none,       "--normalize",     "normalize distance to [0,1]" },
         { argument::none,       "--help",          "prints out help message" }
@@ -62,11 +67,12 @@ int main(int argc, char *argv[]) {
     bool match_str   = opt.is_set("--matching");
     bool hamming     = opt.is_set("--hamming");
     bool find_mask   = opt.is_set("--find-mask");
+    auto [ nearest, known_file ] = opt.get_value("--nearest");
     bool average     = opt.is_set("--average");
     bool normalize   = opt.is_set("--normalize");
     bool print_help  = opt.is_set("--help");
 
-    if (!edit_dist && !lcsubseq && !lcsubstr && !match_str && !find_mask && !hamming && !print_help) {
+    if (!edit_dist && !lcsubseq && !lcsubstr && !match_str && !find_mask && !hamming && !nearest && !print_help) {
         fprintf(stderr, "error: no analysis method specified\n");
         opt.usage(stderr, progname, summary);
         return EXIT_FAILURE;
@@ -209,6 +215,31 @@ int main(int argc, char *argv[]) {
         assert(mv.check(s));
 
     }
+    if (nearest) {
+        std::ifstream known_stream{known_file};
+        if (!known_stream) {
+            fprintf(stderr, "error: could not open file '%s' for reading\n", known_file.c_str());
+            return EXIT_FAILURE;
+        }
+        std::vector<std::string> known;
+        for (std::string k; std::getline(known_stream, k); ) {
+            known.push_back(k);
+        }
+        fingerprint_index index;
+        for (const auto &k : known) {
+            index.add(k);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &x : s) {
+            std::string_view query{(const char *)x.data(), x.length()};
+            fingerprint_index::match m = index.nearest(query);
+            fprintf(stdout, "%f\t'%.*s'\t'%s'\n", m.similarity, (int)m.fingerprint.length(), m.fingerprint.data(), x.c_str());
+        }
+        auto end = std::chrono::steady_clock::now();
+        double usec = std::chrono::duration<double, std::micro>(end - start).count();
+        fprintf(stderr, "indexed %zu fingerprints; %zu queries took %f us each\n",
+                index.size(), s.size(), s.empty() ? 0.0 : usec / s.size());
+    }
 
     return 0;
 }
@@ -0,0 +1,113 @@
+// text_encoding_bench.cc
+//
+// microbenchmark for the text encoding kernels in
+// libmerc/text_encoding.hpp, and the buffer_stream functions that use
+// them, compared with the bytewise buffer_stream functions
+//
+// usage: text_encoding_bench [iterations]
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include "libmerc/buffer_stream.h"
+
+using text_encoding::isa;
+
+// returns the throughput, in input bytes per nanosecond, of calling
+// func(buffer) iterations times on a buffer large enough to hold its
+// output
+//
+template <typename F>
+double bytes_per_ns(size_t input_length, size_t iterations, F func) {
+    std::vector<char> output(8 * input_length + 64);
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        int doff = 0;
+        int trunc = 0;
+        sink = sink + func(output.data(), &doff, (int)output.size(), &trunc);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return (double)input_length * iterations / ns;
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t iterations = 200000;
+    if (argc > 1) {
+        iterations = strtoul(argv[1], nullptr, 10);
+    }
+
+    fprintf(stdout, "best instruction set: %s\n", text_encoding::isa_name(text_encoding::best_isa()));
+    fprintf(stdout, "input bytes per nanosecond (higher is better)\n\n");
+    fprintf(stdout, "%-24s %8s %10s %10s %8s\n", "function", "length", "bytewise", "fast", "speedup");
+
+    std::mt19937 rng{1};
+    std::uniform_int_distribution<int> any_byte{0, 255};
+    std::uniform_int_distribution<int> printable{0x20, 0x7e};
+
+    for (size_t length : { 16, 64, 256, 1500, 8192 }) {
+        size_t n = iterations * 64 / length;  // roughly constant work per length
+        std::vector<uint8_t> binary(length);
+        std::vector<uint8_t> text(length);
+        for (size_t i = 0; i < length; i++) {
+            binary[i] = any_byte(rng);
+            int c = printable(rng);
+            text[i] = (c == '"' || c == '\\') ? 'x' : c;
+        }
+        const uint8_t *b = binary.data();
+        const uint8_t *t = text.data();
+
+        struct {
+            const char *name;
+            double bytewise;
+            double fast;
+        } results[] = {
+            {
+                "raw_as_hex",
+                bytes_per_ns(length, n, [&](char *d, int *o, int l, int *tr) { return append_raw_as_hex_bytewise(d, o, l, tr, b, length); }),
+                bytes_per_ns(length, n, [&](char *d, int *o, int l, int *tr) { return append_raw_as_hex(d, o, l, tr, b, length); })
+            },
+            {
+                "raw_as_base64",
+                bytes_per_ns(length, n, [&](char *d, int *o, int l, int *tr) { return append_raw_as_base64_bytewise(d, o, l, tr, b, length); }),
+                bytes_per_ns(length, n, [&](char *d, int *o, int l, int *tr) { return append_raw_as_base64(d, o, l, tr, b, length); })
+            },
+            {
+                "json_escaped (ascii)",
+                bytes_per_ns(length, n, [&](char *d, int *o, int l, int *tr) { return append_json_escaped_bytewise(d, o, l, tr, t, length); }),
+                bytes_per_ns(length, n, [&](char *d, int *o, int l, int *tr) { return append_json_escaped(d, o, l, tr, t, length); })
+            },
+            {
+                "json_escaped (binary)",
+                bytes_per_ns(length, n, [&](char *d, int *o, int l, int *tr) { return append_json_escaped_bytewise(d, o, l, tr, b, length); }),
+                bytes_per_ns(length, n, [&](char *d, int *o, int l, int *tr) { return append_json_escaped(d, o, l, tr, b, length); })
+            },
+        };
+        for (const auto &r : results) {
+            fprintf(stdout, "%-24s %8zu %10.3f %10.3f %7.1fx\n", r.name, length, r.bytewise, r.fast, r.fast / r.bytewise);
+        }
+
+        // kernels, for each supported instruction set
+        //
+        for (isa i : { isa::scalar, isa::sse2, isa::ssse3, isa::avx2, isa::neon }) {
+            if (!text_encoding::is_supported(i)) {
+                continue;
+            }
+            std::string name{"kernels ("};
+            name += text_encoding::isa_name(i);
+            name += ")";
+            double hex = bytes_per_ns(length, n, [&](char *d, int *, int, int *) { text_encoding::hex(d, b, length, i); return d[0]; });
+            double base64 = bytes_per_ns(length, n, [&](char *d, int *, int, int *) { text_encoding::base64(d, b, length, i); return d[0]; });
+            double clean = bytes_per_ns(length, n, [&](char *, int *, int, int *) { return (int)text_encoding::json_clean_prefix_length(t, length, i); });
+            fprintf(stdout, "%-24s %8zu   hex %7.3f   base64 %7.3f   json_clean %7.3f\n", name.c_str(), length, hex, base64, clean);
+        }
+        fputc('\n', stdout);
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+// tls_fingerprint_bench.cc
+//
+// benchmark for TLS client hello fingerprinting: extracts the TLS
+// client hellos from the TCP packets in one or more Ethernet capture
+// files, and reports the number of hellos per second for which each
+// of the fingerprint formats can be computed.  The hellos are parsed
+// before timing starts, so that only the fingerprint builders are
+// measured.  With --print, the fingerprints are written to stdout
+// instead, one per line, so that the output of two builds can be
+// compared with diff.
+//
+// usage: tls_fingerprint_bench [--iterations n] [--print] pcap_file...
+//
+// e.g. tls_fingerprint_bench ../test/data/top_100_fingerprints.pcap
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include "pcap.h"
+#include "libmerc/tls.h"
+
+// tcp_payload() returns the TCP payload of an Ethernet frame that
+// carries IPv4 or IPv6, possibly with VLAN tags, or an empty datum
+//
+static datum tcp_payload(datum frame) {
+    frame.skip(12);
+    uint16_t ethertype = 0;
+    frame.read_uint16(&ethertype);
+    while (ethertype == 0x8100 || ethertype == 0x88a8) {
+        frame.skip(2);
+        frame.read_uint16(&ethertype);
+    }
+    uint8_t protocol = 0;
+    if (ethertype == 0x0800) {
+        uint8_t version_ihl = 0;
+        frame.lookahead_uint8(&version_ihl);
+        frame.skip(9);
+        frame.read_uint8(&protocol);
+        frame.skip((version_ihl & 0x0f) * 4 - 10);
+    } else if (ethertype == 0x86dd) {
+        frame.skip(6);
+        frame.read_uint8(&protocol);
+        frame.skip(33);
+    } else {
+        return {nullptr, nullptr};
+    }
+    if (protocol != 6) {
+        return {nullptr, nullptr};
+    }
+    datum tcp_header = frame;
+    tcp_header.skip(12);
+    uint8_t offset = 0;
+    tcp_header.read_uint8(&offset);
+    frame.skip((offset >> 4) * 4);
+    if (!frame.is_not_empty()) {
+        return {nullptr, nullptr};
+    }
+    return frame;
+}
+
+// hellos_per_second() returns the number of client hellos per second
+// for which the fingerprint in format_version is computed
+//
+static double hellos_per_second(const std::vector<tls_client_hello> &hellos, size_t iterations, size_t format_version) {
+    char buffer[8192];
+    volatile int sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        for (const auto &hello : hellos) {
+            buffer_stream b{buffer, sizeof(buffer)};
+            hello.fingerprint(b, format_version);
+            sink = sink + b.doff;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(end - start).count();
+    return hellos.size() * iterations / s;
+}
+
+int main(int argc, char *argv[]) {
+
+    size_t iterations = 1000;
+    bool print = false;
+    std::vector<const char *> files;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--print") == 0) {
+            print = true;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty() || iterations == 0) {
+        fprintf(stderr, "usage: %s [--iterations n] [--print] pcap_file...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // read all of the packets into memory, since the hellos refer
+    // to them, then parse the TCP payloads that hold client hellos
+    //
+    std::vector<std::vector<uint8_t>> packets;
+    try {
+        for (const char *f : files) {
+            pcap::file_reader pcap{f};
+            while (true) {
+                std::pair<const uint8_t *, const uint8_t *> pkt = pcap.read_packet();
+                if (pkt.first == nullptr) {
+                    break;
+                }
+                packets.emplace_back(pkt.first, pkt.second);
+            }
+        }
+    }
+    catch (std::exception &e) {
+        fprintf(stderr, "error: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    std::vector<tls_client_hello> hellos;
+    for (const auto &p : packets) {
+        datum payload = tcp_payload({p.data(), p.data() + p.size()});
+        tls_record rec{payload};
+        tls_handshake handshake{rec.fragment};
+        if (handshake.msg_type != handshake_type::client_hello) {
+            continue;
+        }
+        tls_client_hello hello{handshake.body};
+        if (hello.is_not_empty()) {
+            hellos.push_back(hello);
+        }
+    }
+    if (hellos.empty()) {
+        fprintf(stderr, "error: no TLS client hellos found\n");
+        return EXIT_FAILURE;
+    }
+
+    if (print) {
+        char buffer[8192];
+        for (const auto &hello : hellos) {
+            for (size_t format_version : { 0, 1, 2 }) {
+                buffer_stream b{buffer, sizeof(buffer)};
+                hello.fingerprint(b, format_version);
+                fprintf(stdout, "%.*s\n", b.doff, buffer);
+            }
+        }
+        return 0;
+    }
+
+    fprintf(stdout, "client hellos: %zu\n", hellos.size());
+    for (size_t format_version : { 0, 1, 2 }) {
+        fprintf(stdout, "format %zu hellos per second: %.0f\n", format_version, hellos_per_second(hellos, iterations, format_version));
+    }
+
+    return 0;
+}
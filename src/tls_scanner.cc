@@ -24,6 +24,11 @@
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <memory>
+#include <deque>
+#include <map>
+#include <csignal>
+#include <sys/epoll.h>
 
 #include "libmerc/x509.h"
 #include "libmerc/http.h"
@@ -218,43 +223,315 @@ public:
         }
     }
 
-    void scan(std::string hostname, std::string inner_hostname, bool doh=false) {
-        std::string redirect = "";
-        std::string &http_host_field = inner_hostname;
+    // scan_concurrently() scans each of the targets read from
+    // host_list, one per line, keeping up to concurrency TLS
+    // connections in progress at once on an epoll loop in the calling
+    // thread, and abandoning any scan that has not completed within
+    // timeout.  If ordered is true, the output for each target is
+    // written in the order that the targets appear in host_list;
+    // otherwise, it is written as soon as each scan completes.  Host
+    // names are resolved as each scan is started, which blocks the
+    // loop while the lookup is in progress.
+    //
+    void scan_concurrently(std::istream &host_list,
+                           const std::string &inner_hostname,
+                           size_t concurrency,
+                           std::chrono::milliseconds timeout,
+                           bool ordered) {
+
+        // ignore SIGPIPE, so that a server that closes its connection
+        // while a request is being written does not end the process
+        //
+        signal(SIGPIPE, SIG_IGN);
+
+        std::unique_ptr<SSL_CTX, decltype(&SSL_CTX_free)> ctx{SSL_CTX_new(TLS_client_method()), SSL_CTX_free};
+        if (ctx == nullptr) {
+            throw std::runtime_error{"could not create SSL_CTX"};
+        }
+        int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd == -1) {
+            throw std::runtime_error{std::string{"epoll_create1() failed: "} + strerror(errno)};
+        }
+
+        using clock = std::chrono::steady_clock;
+        struct pending_scan {
+            std::string hostname;
+            std::unique_ptr<nonblocking_tls_connection> connection;
+        };
+        std::unordered_map<size_t, pending_scan> in_flight;
+
+        // every scan has the same timeout, so deadlines expire in the
+        // order that scans are started; entries for scans that have
+        // already completed are skipped as they are reached
+        //
+        std::deque<std::pair<clock::time_point, size_t>> deadlines;
+
+        // completed holds the output of scans that have finished
+        // ahead of an earlier target, in ordered mode; the number of
+        // targets that can be started ahead of the oldest unfinished
+        // one is limited to reorder_window, so that it stays small
+        //
+        std::map<size_t, std::string> completed;
+        const size_t reorder_window = concurrency * 16;
+        size_t next_target = 0;
+        size_t next_output = 0;
+        bool end_of_input = false;
+
+        auto write_output = [&](size_t target_number, std::string output) {
+            if (!ordered) {
+                fwrite(output.data(), 1, output.length(), stdout);
+                fflush(stdout);
+                next_output++;
+                return;
+            }
+            completed.emplace(target_number, std::move(output));
+            for (auto it = completed.begin(); it != completed.end() && it->first == next_output; it = completed.erase(it)) {
+                fwrite(it->second.data(), 1, it->second.length(), stdout);
+                next_output++;
+            }
+        };
+
+        auto start_scan = [&](size_t target_number, const std::string &line) {
+            scan_target target;
+            if (!parse_target(target, line, inner_hostname, false)) {
+                write_output(target_number, {});
+                return;
+            }
+            ++scans;
+            std::vector<sockaddr_in> sa = tls_connection::get_sockaddr_in(target.hostname.c_str(), verbosity, target.port);
+            if (sa.empty()) {
+                if (verbosity >= verbosity_level::warnings) {
+                    fprintf(stderr, "warning: could not get address for host '%s'\n", target.hostname.c_str());
+                }
+                write_output(target_number, {});
+                return;
+            }
+
+            // send the server name unless it is omitted or the target
+            // is an address
+            //
+            in_addr addr;
+            const char *server_name = target.hostname.c_str();
+            if (omit_sni || inet_pton(AF_INET, server_name, &addr) == 1) {
+                server_name = nullptr;
+            }
+            std::string request;
+            if (cert_output_file == nullptr) {
+                request = tls_connection::http_request_string(target.path, target.hostname, target.http_host_field, user_agent, false);
+            }
+            auto connection = std::make_unique<nonblocking_tls_connection>(ctx.get(), sa[0], server_name, std::move(request), 1024*256);
+            if (connection->get_state() == nonblocking_tls_connection::state::failed) {
+                if (verbosity >= verbosity_level::warnings) {
+                    fprintf(stderr, "warning: connection to %s failed (%s)\n", target.hostname.c_str(), connection->failure_reason().c_str());
+                }
+                write_output(target_number, {});
+                return;
+            }
+            epoll_event event{};
+            event.events = connection->wants_write() ? EPOLLOUT : EPOLLIN;
+            event.data.u64 = target_number;
+            if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection->get_socket(), &event) == -1) {
+                throw std::runtime_error{std::string{"epoll_ctl() failed: "} + strerror(errno)};
+            }
+            deadlines.emplace_back(clock::now() + timeout, target_number);
+            in_flight.emplace(target_number, pending_scan{target.hostname, std::move(connection)});
+        };
+
+        // finish_scan() reports the outcome of a completed, failed, or
+        // timed out scan, and releases its connection
+        //
+        auto finish_scan = [&](std::unordered_map<size_t, pending_scan>::iterator it) {
+            const std::string &hostname = it->second.hostname;
+            nonblocking_tls_connection &connection = *it->second.connection;
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, connection.get_socket(), nullptr);
+            std::string output;
+            if (connection.get_state() == nonblocking_tls_connection::state::done) {
+                ++scans_succeded;
+                if (verbosity == verbosity_level::summary) {
+                    fprintf(stderr, "\rTLS scans\ttotal: %zu\tsucceeded: %zu", scans, scans_succeded);
+                }
+                if (verbosity >= verbosity_level::notes) {
+                    fprintf(stderr, "note: connection to %s succeeded\n", hostname.c_str());
+                }
+                char *output_buffer = nullptr;
+                size_t output_length = 0;
+                FILE *f = open_memstream(&output_buffer, &output_length);
+                if (f == nullptr) {
+                    throw std::runtime_error{"could not open memory stream"};
+                }
+                raw_cert cert{connection.get_tls()};
+                data.insert(cert.get_bytestring(), hostname);
+                if (print_cert) {
+                    cert.print_json(f);
+                }
+                if (!connection.get_request().empty()) {
+                    const std::string &response = connection.get_response();
+                    tls_connection::write_http_json(f, connection.get_request(), response.data(), response.length());
+                }
+                fclose(f);
+                output.assign(output_buffer, output_length);
+                free(output_buffer);
+            } else if (verbosity >= verbosity_level::warnings) {
+                if (connection.get_state() == nonblocking_tls_connection::state::failed) {
+                    fprintf(stderr, "warning: connection to %s failed (%s)\n", hostname.c_str(), connection.failure_reason().c_str());
+                } else {
+                    fprintf(stderr, "warning: connection to %s timed out\n", hostname.c_str());
+                }
+            }
+            size_t target_number = it->first;
+            in_flight.erase(it);
+            write_output(target_number, std::move(output));
+        };
+
+        std::vector<epoll_event> events(concurrency);
+        while (true) {
+
+            // start scans until there are concurrency in progress
+            //
+            while (!end_of_input && in_flight.size() < concurrency && (!ordered || next_target - next_output < reorder_window)) {
+                std::string line;
+                if (!std::getline(host_list, line)) {
+                    end_of_input = true;
+                    break;
+                }
+                start_scan(next_target++, line);
+            }
+            if (in_flight.empty()) {
+                if (end_of_input) {
+                    break;
+                }
+                continue;
+            }
+
+            // abandon scans that have timed out
+            //
+            clock::time_point now = clock::now();
+            while (!deadlines.empty() && deadlines.front().first <= now) {
+                auto it = in_flight.find(deadlines.front().second);
+                deadlines.pop_front();
+                if (it != in_flight.end()) {
+                    finish_scan(it);
+                }
+            }
+            if (in_flight.empty()) {
+                continue;
+            }
+
+            // wait until a socket is ready or the oldest deadline passes
+            //
+            auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadlines.front().first - now);
+            int num_events = epoll_wait(epoll_fd, events.data(), events.size(), wait.count());
+            if (num_events == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error{std::string{"epoll_wait() failed: "} + strerror(errno)};
+            }
+            for (int i = 0; i < num_events; i++) {
+                auto it = in_flight.find(events[i].data.u64);
+                if (it == in_flight.end()) {
+                    continue;
+                }
+                nonblocking_tls_connection &connection = *it->second.connection;
+                nonblocking_tls_connection::state st = connection.advance();
+                if (st == nonblocking_tls_connection::state::done || st == nonblocking_tls_connection::state::failed) {
+                    finish_scan(it);
+                    continue;
+                }
+                epoll_event event{};
+                event.events = connection.wants_write() ? EPOLLOUT : EPOLLIN;
+                event.data.u64 = it->first;
+                if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.get_socket(), &event) == -1) {
+                    throw std::runtime_error{std::string{"epoll_ctl() failed: "} + strerror(errno)};
+                }
+            }
+        }
+        close(epoll_fd);
+        fflush(stdout);
+
+        if (verbosity == verbosity_level::summary) {
+            fputc('\n', stderr); // terminate summary line
+        }
+    }
+
+    // struct scan_target holds the parts of a scan target of the form
+    // host[:port][/path]
+    //
+    struct scan_target {
+        std::string hostname;         // host name or address to connect to
+        std::string http_host_field;  // inner host name, or host[:port]
+        std::string path = "/";
+        uint16_t port = 443;
+    };
+
+    // parse_target() sets target from the host string hostname and
+    // the inner host name (which may be empty), and returns true if
+    // it can be scanned, or reports the problem and returns false
+    // otherwise
+    //
+    bool parse_target(scan_target &target, const std::string &hostname, const std::string &inner_hostname, bool doh) const {
+        target.hostname = hostname;
+        target.http_host_field = inner_hostname;
         bool trim_hostname = false;
         if (inner_hostname == "") {
-            http_host_field = hostname;
+            target.http_host_field = hostname;
             trim_hostname = true;
         }
 
         // set path, if there is one, and trim the path off of the
         // host string(s) as needed
         //
-        std::string path = "/";
-        size_t idx = http_host_field.find("/");
+        size_t idx = target.http_host_field.find("/");
         if (idx != std::string::npos) {
-            path = http_host_field.substr(idx, std::string::npos);
-            http_host_field.resize(idx);
+            target.path = target.http_host_field.substr(idx, std::string::npos);
+            target.http_host_field.resize(idx);
             if (trim_hostname) {
-                hostname.resize(idx);
+                target.hostname.resize(idx);
             }
             if (doh) {
                 if (verbosity >= verbosity_level::errors) {
                     fprintf(stderr, "error: path set for DoH query\n");
                 }
-                return;
+                return false;
+            }
+        }
+
+        // trim the port off of the host name, if there is one; the
+        // HTTP host field keeps it
+        //
+        idx = target.hostname.rfind(":");
+        if (idx != std::string::npos && idx + 1 < target.hostname.length()
+            && target.hostname.find_first_not_of("0123456789", idx + 1) == std::string::npos) {
+            unsigned long port = strtoul(target.hostname.c_str() + idx + 1, nullptr, 10);
+            if (port == 0 || port > 65535) {
+                if (verbosity >= verbosity_level::errors) {
+                    fprintf(stderr, "error: invalid port in host '%s'\n", target.hostname.c_str());
+                }
+                return false;
             }
+            target.port = port;
+            target.hostname.resize(idx);
         }
 
-        if (hostname == "") {
+        if (target.hostname == "") {
             if (verbosity >= verbosity_level::errors) {
                 fprintf(stderr, "warning: empty hostname found\n");
             }
+            return false;
+        }
+        return true;
+    }
+
+    void scan(const std::string &host_string, const std::string &inner_hostname, bool doh=false) {
+        scan_target target;
+        if (!parse_target(target, host_string, inner_hostname, doh)) {
             return;
         }
+        const std::string &hostname = target.hostname;
+        const std::string &path = target.path;
 
         ++scans;
-        tls_connection connection{hostname.c_str(), verbosity, 443};
+        tls_connection connection{hostname.c_str(), verbosity, target.port};
         if (!connection.is_valid()) {
             if (verbosity >= verbosity_level::warnings) {
                 fprintf(stderr, "warning: connection to %s failed\n", hostname.c_str());
@@ -281,7 +558,7 @@ public:
             return;
         }
 
-        std::set<std::string> src_links = connection.send_http_request(path, hostname, inner_hostname, user_agent, doh);
+        std::set<std::string> src_links = connection.send_http_request(path, hostname, target.http_host_field, user_agent, doh);
 
         // follow src= links, if any
         //
@@ -869,6 +1146,12 @@ int main(int argc, char *argv[]) {
         "which contains the host names and the SHA1 hash of the corresponding\n"
         "certificates.\n"
         "\n"
+        "A host may be given as host[:port][/path].  With --host-file and\n"
+        "--concurrency, up to <arg> hosts are scanned at once over non-blocking\n"
+        "connections, each of which is abandoned if it has not completed within\n"
+        "the --timeout; output is written in the order of the host file, or as\n"
+        "each scan completes (with --unordered).\n"
+        "\n"
         "OPTIONS\n";
 
     option_processor opt({
@@ -884,6 +1167,9 @@ int main(int argc, char *argv[]) {
         { argument::none,       "--body",             "prints out HTTP response body" },
         { argument::none,       "--recurse",          "recursively follow src links and redirects" },
         { argument::required,   "--doh",              "send DoH query about <arg>" },
+        { argument::required,   "--concurrency",      "scan up to <arg> hosts from host file at once" },
+        { argument::required,   "--timeout",          "abandon concurrent scans after <arg> seconds (default: 10)" },
+        { argument::none,       "--unordered",        "write concurrent scan output as each scan completes" },
         { argument::none,       "--help",             "prints out help message" },
         { argument::none,       "--version",          "prints out version" }
     });
@@ -900,6 +1186,9 @@ int main(int argc, char *argv[]) {
     auto [ write_certs, pem_outfile ] = opt.get_value("--write-certs");
     auto [ verb_is_set, verb ] = opt.get_value("--verbosity");
     auto [ doh, doh_query ] = opt.get_value("--doh");
+    auto [ concurrency_is_set, concurrency_str ] = opt.get_value("--concurrency");
+    auto [ timeout_is_set, timeout_str ] = opt.get_value("--timeout");
+    bool unordered   = opt.is_set("--unordered");
     bool list_uas    = opt.is_set("--list-user-agents");
     bool omit_sni    = opt.is_set("--no-server-name");
     bool print_certs = opt.is_set("--certs");
@@ -930,6 +1219,36 @@ int main(int argc, char *argv[]) {
         inner_hostname = doh_query;
     }
 
+    size_t concurrency = 0;
+    if (concurrency_is_set) {
+        concurrency = strtoul(concurrency_str.c_str(), nullptr, 10);
+        if (concurrency == 0 || !host_file_is_set) {
+            fprintf(stderr, "error: --concurrency requires a positive number and --host-file\n");
+            opt.usage(stderr, argv[0], summary);
+            return EXIT_FAILURE;
+        }
+        if (doh || recurse) {
+            fprintf(stderr, "error: --concurrency cannot be used with --doh or --recurse\n");
+            opt.usage(stderr, argv[0], summary);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((timeout_is_set || unordered) && concurrency == 0) {
+        fprintf(stderr, "error: --timeout and --unordered require --concurrency\n");
+        opt.usage(stderr, argv[0], summary);
+        return EXIT_FAILURE;
+    }
+    std::chrono::milliseconds timeout{10000};
+    if (timeout_is_set) {
+        double seconds = strtod(timeout_str.c_str(), nullptr);
+        if (!(seconds > 0.0)) {
+            fprintf(stderr, "error: --timeout requires a positive number of seconds\n");
+            opt.usage(stderr, argv[0], summary);
+            return EXIT_FAILURE;
+        }
+        timeout = std::chrono::milliseconds{(long long)(seconds * 1000.0)};
+    }
+
     // select a verbosity level, to be passed to scanner
     //
     verbosity_level verbosity{verbosity_level::no_output};
@@ -982,7 +1301,10 @@ int main(int argc, char *argv[]) {
             if (!host_list) {
                 throw std::runtime_error{"could not open file '" + host_file + "'"};
             }
-            while (true) {
+            if (concurrency != 0) {
+                scanner.scan_concurrently(host_list, inner_hostname, concurrency, timeout, !unordered);
+            }
+            while (concurrency == 0) {
 
                 // implementation note: The batch thread model used
                 // here aims to be simple and scalable.  We loop over
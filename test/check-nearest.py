@@ -0,0 +1,120 @@
+import json
+import tarfile
+import argparse
+from collections import Counter
+from mercury_output import read_records, fingerprint, canonical, report
+
+# check-nearest.py checks the output of mercury --nearest-fingerprint
+# against the output of mercury without that option, for the same
+# input.  Apart from the "nearest" objects in the analysis of unknown
+# fingerprints, the records must be identical.  Each nearest
+# fingerprint must be in the fingerprint database of the resource
+# archive, with the same type and format as the fingerprint of the
+# record, and its similarity must be between zero and one and equal to
+# the similarity recomputed here.  The nearest fingerprint must rank
+# first, that is, no fingerprint in the database may be more similar,
+# whenever the most similar one has a similarity of at least
+# min_ranked; below that, the MinHash bands of the index may not
+# bring it up as a candidate, so a miss is counted but allowed.  The
+# same fingerprint must always have the same nearest fingerprint.
+
+min_ranked = 0.8
+
+def fingerprint_db(resources):
+    with tarfile.open(resources) as t:
+        for m in t.getmembers():
+            if m.name.endswith('fingerprint_db.json'):
+                return set(json.loads(line)['str_repr'] for line in t.extractfile(m))
+    return set()
+
+def tokens(fp):
+    """returns the (prefix, tokens) of the fingerprint string fp, as fingerprint_tokens() in fingerprint_index.hpp splits it"""
+    start = fp.find('(')
+    if start < 0:
+        start = len(fp)
+    result = []
+    depth = 0
+    list_index = 0
+    leaf = None
+    for i in range(start, len(fp)):
+        if fp[i] == '(':
+            depth += 1
+            leaf = i + 1
+        elif fp[i] == ')':
+            if leaf is not None:
+                element = fp[leaf:i]
+                if depth == 1 and len(element) > 4 and len(element) % 4 == 0:
+                    result.extend((list_index, element[j:j+4]) for j in range(0, len(element), 4))
+                else:
+                    result.append((list_index, element))
+                leaf = None
+            if depth > 0:
+                depth -= 1
+                if depth == 0:
+                    list_index += 1
+    return fp[:start], result
+
+def similarity(x, y):
+    """returns one minus the edit distance between the token sequences x and y, divided by the length of the longer"""
+    previous = list(range(len(y) + 1))
+    for i, a in enumerate(x, 1):
+        current = [i]
+        for j, b in enumerate(y, 1):
+            current.append(min(previous[j] + 1, current[j - 1] + 1, previous[j - 1] + (a != b)))
+        previous = current
+    longest = max(len(x), len(y))
+    return 1.0 - previous[-1] / longest if longest else 1.0
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-e','--expected', action='store', dest='expected', help='mercury output without --nearest-fingerprint', required=True)
+    parser.add_argument('-n','--nearest', action='store', dest='nearest', help='mercury output with --nearest-fingerprint', required=True)
+    parser.add_argument('-r','--resources', action='store', dest='resources', help='resource archive', required=True)
+    args = parser.parse_args()
+
+    known = {fp: tokens(fp) for fp in fingerprint_db(args.resources)}
+    expected = Counter(canonical(r) for r in read_records(args.expected))
+
+    observed = Counter()
+    reported = 0
+    missed = 0
+    nearest = {}
+    errors = []
+    for r in read_records(args.nearest):
+        analysis = r.get('analysis', {})
+        if 'nearest' in analysis:
+            reported += 1
+            n = analysis.pop('nearest')
+            fp = fingerprint(r)
+            if 'status' not in analysis:
+                errors.append('nearest fingerprint reported for labeled fingerprint {}'.format(fp))
+            if not 0.0 <= n['similarity'] <= 1.0:
+                errors.append('similarity {} out of range'.format(n['similarity']))
+            if n['fingerprint'] not in known:
+                errors.append('nearest fingerprint {} is not in the fingerprint database'.format(n['fingerprint']))
+            elif fp is not None:
+                prefix, query = tokens(fp[1])
+                if known[n['fingerprint']][0] != prefix:
+                    errors.append('nearest fingerprint {} has a different type or format than {}'.format(n['fingerprint'], fp[1]))
+                if abs(similarity(query, known[n['fingerprint']][1]) - n['similarity']) > 1e-6:
+                    errors.append('similarity {} of {} differs from {}'.format(n['similarity'], n['fingerprint'], similarity(query, known[n['fingerprint']][1])))
+                best = max((similarity(query, t) for p, t in known.values() if p == prefix), default=0.0)
+                if best > n['similarity'] + 1e-6:
+                    missed += 1
+                    if best >= min_ranked:
+                        errors.append('nearest fingerprint {} has similarity {}, but one in the database has {}'.format(n['fingerprint'], n['similarity'], best))
+                if nearest.setdefault(fp[1], n) != n:
+                    errors.append('nearest fingerprints {} and {} reported for {}'.format(nearest[fp[1]], n, fp[1]))
+        observed[canonical(r)] += 1
+
+    if expected != observed:
+        errors.append('records differ apart from nearest fingerprints')
+    if reported == 0:
+        errors.append('no nearest fingerprints reported')
+
+    report(errors, 'nearest fingerprint check',
+           '{} nearest fingerprints reported in {} records ({} distinct), {} below {} similarity outranked'.format(
+               reported, sum(observed.values()), len(nearest), missed, min_ranked))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,136 @@
+import sys
+import gzip
+import json
+import argparse
+from collections import defaultdict
+
+# compare-approx-stats.py checks the accuracy of an approximate stats
+# file (mercury --stats-memory) against an exact stats file from the
+# same input.  The approximate summaries keep, for each fingerprint, at
+# most user_agents_per_fingerprint user agents, each with at most
+# destinations_per_user_agent destinations; these must match the
+# constants in approximate_stats_aggregator (src/libmerc/stats.h).
+
+user_agents_per_fingerprint = 4
+destinations_per_user_agent = 16
+
+def read_exact(in_file):
+    fps = defaultdict(lambda: { 'count': 0, 'sources': set(), 'user_agents': defaultdict(lambda: { 'count': 0, 'dsts': defaultdict(int) }) })
+    with gzip.open(in_file, 'rt') as f:
+        for line in f:
+            r = json.loads(line)
+            if r.get('approximate', False):
+                print('error: {} is an approximate stats file'.format(in_file))
+                sys.exit(1)
+            for x in r['fingerprints']:
+                fp = fps[x['str_repr']]
+                fp['sources'].add(r['src_ip'])
+                for s in x['sessions']:
+                    ua = fp['user_agents'][s.get('user_agent', '')]
+                    for y in s['dest_info']:
+                        fp['count'] += y['count']
+                        ua['count'] += y['count']
+                        ua['dsts'][y['dst']] += y['count']
+    return fps
+
+def read_approx(in_file):
+    fps = {}
+    with gzip.open(in_file, 'rt') as f:
+        for line in f:
+            r = json.loads(line)
+            if r.get('approximate', False) is not True or r['src_ip'] != '*':
+                print('error: {} is not an approximate stats file'.format(in_file))
+                sys.exit(1)
+            for x in r['fingerprints']:
+                user_agents = {}
+                for s in x['sessions']:
+                    user_agents[s.get('user_agent', '')] = { y['dst']: y['count'] for y in s['dest_info'] }
+                fps[x['str_repr']] = { 'count': x['count'], 'src_ip_count': x['src_ip_count'], 'user_agents': user_agents }
+    return fps
+
+def compare(exact, approx, evictions):
+    errors = []
+    exact_total = sum(fp['count'] for fp in exact.values())
+    approx_total = sum(fp['count'] for fp in approx.values())
+
+    if not evictions:
+        if set(exact) != set(approx):
+            errors.append('fingerprints differ: {} exact, {} approximate'.format(len(exact), len(approx)))
+        if exact_total != approx_total:
+            errors.append('total count {} != exact total count {}'.format(approx_total, exact_total))
+    else:
+        # the fingerprint summary must retain the heaviest hitter
+        # and report overestimates for the rest
+        heaviest = max(exact, key=lambda k: exact[k]['count'])
+        if heaviest not in approx:
+            errors.append('most frequent fingerprint missing: {}'.format(heaviest))
+
+    for str_repr, a in approx.items():
+        if str_repr not in exact:
+            errors.append('unknown fingerprint {}'.format(str_repr))
+            continue
+        e = exact[str_repr]
+        if a['count'] < e['count'] or (not evictions and a['count'] != e['count']):
+            errors.append('count {} for fingerprint {} does not match exact count {}'.format(a['count'], str_repr, e['count']))
+        # counts are never underestimates, even after evictions
+        for ua, dsts in a['user_agents'].items():
+            if ua not in e['user_agents']:
+                errors.append('unknown user agent {} for fingerprint {}'.format(ua, str_repr))
+                continue
+            ua_e = e['user_agents'][ua]
+            for dst, count in dsts.items():
+                exact_count = ua_e['dsts'].get(dst, 0)
+                if count < exact_count:
+                    errors.append('count {} for {} is an underestimate of {}'.format(count, dst, exact_count))
+        if evictions:
+            continue
+
+        # distinct sources, from the HyperLogLog estimate
+        n = len(e['sources'])
+        if abs(a['src_ip_count'] - n) > max(2, 0.1 * n):
+            errors.append('src_ip_count {} for fingerprint {} is not close to {}'.format(a['src_ip_count'], str_repr, n))
+
+        # space-saving guarantees that every user agent with more
+        # than count/k occurrences is present, and when no user agent
+        # has been evicted, the destination summary of each one has
+        # seen all of its occurrences, so the same holds for them
+        for ua, ua_e in e['user_agents'].items():
+            if ua_e['count'] * user_agents_per_fingerprint > e['count'] and ua not in a['user_agents']:
+                errors.append('frequent user agent {} missing for fingerprint {}'.format(ua, str_repr))
+        if len(e['user_agents']) > user_agents_per_fingerprint:
+            continue
+        for ua, dsts in a['user_agents'].items():
+            ua_e = e['user_agents'][ua]
+            for dst, count in dsts.items():
+                if count - ua_e['dsts'].get(dst, 0) > ua_e['count'] / destinations_per_user_agent:
+                    errors.append('count {} for {} exceeds error bound'.format(count, dst))
+            for dst, exact_count in ua_e['dsts'].items():
+                if exact_count * destinations_per_user_agent > ua_e['count'] and dst not in dsts:
+                    errors.append('frequent destination {} missing for fingerprint {}'.format(dst, str_repr))
+
+    for x in errors:
+        print('error: ' + x)
+    return len(errors) == 0, exact_total, approx_total
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-e','--exact-stats', action='store', dest='exact', help='exact stats file', required=True)
+    parser.add_argument('-a','--approx-stats', action='store', dest='approx', help='approximate stats file', required=True)
+    parser.add_argument('--evictions', action='store_true', dest='evictions',
+                        help='the memory budget was small enough to evict fingerprints', default=False)
+    args = parser.parse_args()
+
+    exact = read_exact(args.exact)
+    approx = read_approx(args.approx)
+    if len(exact) == 0 or len(approx) == 0:
+        print('error: empty stats file')
+        sys.exit(1)
+    ok, exact_total, approx_total = compare(exact, approx, args.evictions)
+    if not ok:
+        print('error: approximate stats comparison failed')
+        sys.exit(1)
+    print('success: {} approximate fingerprints (total count {}) are consistent with {} exact fingerprints (total count {})'.format(len(approx), approx_total, len(exact), exact_total))
+    sys.exit(0)
+
+if __name__ == "__main__":
+    main()
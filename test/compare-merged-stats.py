@@ -0,0 +1,85 @@
+import sys
+import gzip
+import json
+import random
+import argparse
+from collections import defaultdict
+
+# compare-merged-stats.py checks the output of stats_merge against
+# its inputs: the count for each (source, fingerprint, user agent,
+# destination) in the merged stats file must be the sum of the counts
+# in the input files, and the records must be ordered by source
+# address, with one record per source.  With --identical, the merged
+# file must also hold the same JSON records as the single input file,
+# apart from formatting.  With --shuffle, it instead writes a copy of
+# a stats file with its records in random order, to test the merging
+# of unordered inputs.
+
+def read_counts(in_file):
+    counts = defaultdict(int)
+    sources = []
+    with gzip.open(in_file, 'rt') as f:
+        for line in f:
+            r = json.loads(line)
+            sources.append(r['src_ip'])
+            for x in r['fingerprints']:
+                for s in x['sessions']:
+                    for y in s['dest_info']:
+                        counts[(r['src_ip'], x['str_repr'], s.get('user_agent', ''), y['dst'])] += y['count']
+    return counts, sources
+
+def read_records(in_file):
+    with gzip.open(in_file, 'rt') as f:
+        return [ json.loads(line) for line in f ]
+
+def shuffle(in_file, out_file):
+    with gzip.open(in_file, 'rt') as f:
+        lines = f.readlines()
+    random.Random(1).shuffle(lines)
+    with gzip.open(out_file, 'wt') as f:
+        f.writelines(lines)
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-m','--merged', action='store', dest='merged', help='merged stats file', required=True)
+    parser.add_argument('--identical', action='store_true', dest='identical',
+                        help='the merged file must hold the same records as the input file', default=False)
+    parser.add_argument('--shuffle', action='store_true', dest='shuffle',
+                        help='write the inputs, in random order, to the merged file', default=False)
+    parser.add_argument('inputs', nargs='+', help='input stats files')
+    args = parser.parse_args()
+
+    if args.shuffle:
+        shuffle(args.inputs[0], args.merged)
+        sys.exit(0)
+
+    expected = defaultdict(int)
+    for in_file in args.inputs:
+        counts, _ = read_counts(in_file)
+        for k, v in counts.items():
+            expected[k] += v
+    merged, sources = read_counts(args.merged)
+
+    errors = []
+    if len(expected) == 0:
+        errors.append('empty input stats files')
+    for k in set(expected) | set(merged):
+        if expected.get(k, 0) != merged.get(k, 0):
+            errors.append('count {} for {} does not match sum of input counts {}'.format(merged.get(k, 0), k, expected.get(k, 0)))
+    if sources != sorted(sources):
+        errors.append('records are not ordered by source address')
+    if len(sources) != len(set(sources)):
+        errors.append('source addresses appear in more than one record')
+    if args.identical and read_records(args.merged) != read_records(args.inputs[0]):
+        errors.append('records differ from those in {}'.format(args.inputs[0]))
+
+    for x in errors[:20]:
+        print('error: ' + x)
+    if len(errors) > 0:
+        print('error: merged stats comparison failed')
+        sys.exit(1)
+    print('success: {} merged counts from {} sources match {} input files'.format(len(merged), len(sources), len(args.inputs)))
+    sys.exit(0)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,77 @@
+import argparse
+from collections import defaultdict
+from mercury_output import read_records, flow, fingerprint, flow_keys, report
+
+# compare-shed.py checks the output of mercury --load-shedding, with
+# a throttled output thread, against the output of mercury without
+# that option, for the same input.  Records must be shortened before
+# any are dropped: each record written at full verbosity must match a
+# record in the unthrottled output, and each record written at
+# reduced or summary verbosity must hold only the fields of that
+# level, and match the fingerprint (or fingerprint hash), flow key,
+# and time of one.  At least one record must have been written at
+# reduced verbosity, so that the test exercises load shedding, and
+# records may only be missing if some were written at both reduced
+# and summary verbosity.
+
+level_keys = {
+    'reduced': set(flow_keys) | {'event_start', 'verbosity', 'fingerprints'},
+    'summary': set(flow_keys) | {'event_start', 'verbosity', 'type', 'fingerprint_hash'},
+}
+
+def fnv1a_64(s):
+    h = 0xcbf29ce484222325
+    for c in s.encode():
+        h = ((h ^ c) * 0x100000001b3) & 0xffffffffffffffff
+    return '{:016x}'.format(h)
+
+def matches(shed, full):
+    v = shed.get('verbosity')
+    if v is None:
+        return shed == full
+    if v == 'reduced':
+        return shed.get('fingerprints') == full.get('fingerprints')
+    if v == 'summary':
+        fp = fingerprint(full)
+        return shed.get('fingerprint_hash') == (fnv1a_64(fp[1]) if fp is not None else None)
+    return False
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-e','--expected', action='store', dest='expected', help='mercury output without load shedding', required=True)
+    parser.add_argument('-s','--shed', action='store', dest='shed', help='mercury output with --load-shedding', required=True)
+    args = parser.parse_args()
+
+    expected = defaultdict(list)
+    expected_lines = 0
+    for r in read_records(args.expected):
+        expected[(flow(r), r['event_start'])].append(r)
+        expected_lines += 1
+
+    levels = defaultdict(int)
+    errors = []
+    for r in read_records(args.shed):
+        v = r.get('verbosity', 'full')
+        levels[v] += 1
+        if v in level_keys and not set(r) <= level_keys[v]:
+            errors.append('{} record has extra fields {}'.format(v, sorted(set(r) - level_keys[v])))
+        candidates = expected.get((flow(r), r['event_start']), [])
+        for i, x in enumerate(candidates):
+            if matches(r, x):
+                del candidates[i]
+                break
+        else:
+            errors.append('no matching record for {}'.format(r))
+
+    dropped = sum(len(v) for v in expected.values())
+    if dropped > 0 and (levels['reduced'] == 0 or levels['summary'] == 0):
+        errors.append('{} of {} records were dropped before records were shortened'.format(dropped, expected_lines))
+    if levels['reduced'] == 0:
+        errors.append('no records were written at reduced verbosity')
+
+    report(errors, 'load shedding comparison',
+           '{} records, {} written ({} full, {} reduced, {} summary), {} dropped'.format(
+               expected_lines, expected_lines - dropped, levels['full'], levels['reduced'], levels['summary'], dropped))
+
+if __name__ == "__main__":
+    main()
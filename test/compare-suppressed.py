@@ -0,0 +1,80 @@
+import argparse
+from collections import Counter, defaultdict
+from mercury_output import read_records, fingerprint, server_name, canonical, report
+
+# compare-suppressed.py checks the output of mercury --suppress-repeats
+# against the output of mercury without that option, for the same
+# input.  Records are grouped as the suppressor groups them: records
+# with a fingerprint by their source and destination address,
+# destination port, protocol, fingerprint, and server name, and other
+# records by their content apart from the source port and time.  Each
+# record written in full must appear in the unsuppressed output; each
+# summary must repeat a record written in full, with first and last
+# times taken from its group; and for each group, the repeat counts of
+# the summaries must equal the number of records that were removed.
+# The suppressed output must have fewer lines.  Times are compared
+# relative to the first record in each file, since mercury reports
+# packets with no timestamp in a pcap file at the time of the run.
+
+ignored = ('src_port', 'event_start', 'ip', 'repeats')
+
+def group(r):
+    fp = fingerprint(r)
+    if fp is None:
+        return canonical(r, ignored)
+    return (r.get('src_ip'), r.get('dst_ip'), r.get('dst_port'), r.get('protocol'), fp, server_name(r))
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-e','--expected', action='store', dest='expected', help='mercury output without suppression', required=True)
+    parser.add_argument('-s','--suppressed', action='store', dest='suppressed', help='mercury output with --suppress-repeats', required=True)
+    args = parser.parse_args()
+
+    expected = read_records(args.expected)
+    suppressed = read_records(args.suppressed)
+
+    start = min(r['event_start'] for r in expected)
+    suppressed_start = min(r['event_start'] for r in suppressed)
+    expected_count = Counter(group(r) for r in expected)
+    times = defaultdict(set)
+    for r in expected:
+        times[group(r)].add(r['event_start'] - start)
+
+    errors = []
+    unwritten = Counter(canonical(r, ('event_start',)) for r in expected)
+    written = Counter()
+    written_content = Counter()
+    repeats = Counter()
+    summaries = [r for r in suppressed if 'repeats' in r]
+    for r in suppressed:
+        if 'repeats' in r:
+            continue
+        if unwritten[canonical(r, ('event_start',))] == 0:
+            errors.append('record not in the unsuppressed output: {}'.format(canonical(r)))
+        unwritten[canonical(r, ('event_start',))] -= 1
+        written[group(r)] += 1
+        written_content[canonical(r, ignored)] += 1
+
+    for r in summaries:
+        g = group(r)
+        n = r['repeats']
+        if n['count'] < 1 or n['first_event_start'] > n['last_event_start']:
+            errors.append('invalid repeats object {}'.format(n))
+        if n['first_event_start'] - suppressed_start not in times[g] or n['last_event_start'] - suppressed_start not in times[g]:
+            errors.append('repeat times {} not those of records in the group {}'.format(n, g))
+        if written_content[canonical(r, ignored)] == 0:
+            errors.append('summary does not repeat a record written in full: {}'.format(canonical(r)))
+        repeats[g] += n['count']
+
+    for g in set(expected_count) | set(written):
+        removed = expected_count[g] - written[g]
+        if removed != repeats[g]:
+            errors.append('{} records removed, but {} repeats counted for {}'.format(removed, repeats[g], g))
+    if len(suppressed) >= len(expected):
+        errors.append('no records were suppressed ({} lines, {} without suppression)'.format(len(suppressed), len(expected)))
+
+    report(errors, 'suppressed output comparison',
+           '{} lines ({} summaries) account for {} records'.format(len(suppressed), len(summaries), len(expected)))
+
+if __name__ == "__main__":
+    main()
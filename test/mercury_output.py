@@ -0,0 +1,47 @@
+import sys
+import json
+
+# mercury_output.py holds the functions shared by the scripts that
+# check mercury's JSON output against the output of another run of
+# mercury over the same input, such as compare-suppressed.py,
+# compare-shed.py, and check-nearest.py
+
+flow_keys = ('src_ip', 'dst_ip', 'protocol', 'src_port', 'dst_port')
+
+def read_records(file_name):
+    """returns the JSON records in file_name, one per line, as a list of dicts"""
+    with open(file_name) as f:
+        return [json.loads(line) for line in f]
+
+def flow(r):
+    """returns the flow key of the record r, as a tuple"""
+    return tuple(r.get(k) for k in flow_keys)
+
+def fingerprint(r):
+    """returns the (type, string) of the fingerprint in the record r, or None"""
+    fps = r.get('fingerprints', {})
+    return next(iter(fps.items())) if len(fps) > 0 else None
+
+def server_name(r):
+    """returns the TLS or QUIC server name, or the HTTP host, of the record r, or None"""
+    for path in (('tls', 'client', 'server_name'), ('http', 'request', 'host')):
+        x = r
+        for k in path:
+            x = x.get(k) if isinstance(x, dict) else None
+        if x is not None:
+            return x
+    return None
+
+def canonical(r, ignore=()):
+    """returns the record r, without the keys in ignore, as a string that can be compared or counted"""
+    return json.dumps({k: v for k, v in r.items() if k not in ignore}, sort_keys=True)
+
+def report(errors, test, success):
+    """prints up to 20 errors and exits with status 1 if there are any, or prints success and exits with status 0"""
+    for x in errors[:20]:
+        print('error: ' + x)
+    if len(errors) > 0:
+        print('error: {} failed'.format(test))
+        sys.exit(1)
+    print('success: ' + success)
+    sys.exit(0)
@@ -0,0 +1,108 @@
+#!/bin/bash
+#
+# tls_scanner_test.sh
+#
+# tests the concurrent mode of tls_scanner against a fleet of local
+# openssl s_server instances on loopback ports, each with its own
+# self-signed certificate.  The output of a concurrent scan of a host
+# file must be identical to that of scanning each of its hosts in turn
+# with --host, and a target that accepts a connection but never
+# responds must be abandoned after the timeout.
+
+TLS_SCANNER=../src/tls_scanner
+NUM_SERVERS=8
+BASE_PORT=$((20000 + RANDOM % 20000))
+
+for exe in openssl python3; do
+    if ! command -v $exe > /dev/null; then
+        echo "error: $exe not found"
+        exit 1
+    fi
+done
+if [ ! -x $TLS_SCANNER ]; then
+    echo "error: $TLS_SCANNER not found"
+    exit 1
+fi
+
+tmpdir=$(mktemp -d)
+pids=()
+cleanup() {
+    for pid in "${pids[@]}"; do
+        kill $pid 2> /dev/null
+    done
+    wait 2> /dev/null
+    rm -rf $tmpdir
+}
+trap cleanup EXIT
+
+fail() {
+    echo "error: $1"
+    exit 1
+}
+
+# start servers, and wait until each is accepting connections
+#
+for ((i = 0; i < NUM_SERVERS; i++)); do
+    port=$((BASE_PORT + i))
+    openssl req -x509 -newkey ec -pkeyopt ec_paramgen_curve:prime256v1 -nodes -days 1 \
+            -subj "/CN=server$i.example.com" -keyout $tmpdir/key$i.pem -out $tmpdir/cert$i.pem 2> /dev/null \
+        || fail "could not create certificate"
+    openssl s_server -quiet -www -accept $port -cert $tmpdir/cert$i.pem -key $tmpdir/key$i.pem > /dev/null 2>&1 &
+    pids+=($!)
+done
+
+# a server that accepts connections but never responds
+#
+silent_port=$((BASE_PORT + NUM_SERVERS))
+python3 -c "import socket,time
+s=socket.socket(); s.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+s.bind(('127.0.0.1', $silent_port)); s.listen(16); time.sleep(60)" &
+pids+=($!)
+
+for ((i = 0; i <= NUM_SERVERS; i++)); do
+    port=$((BASE_PORT + i))
+    for ((tries = 0; tries < 50; tries++)); do
+        if (exec 3<> /dev/tcp/127.0.0.1/$port) 2> /dev/null; then
+            break
+        fi
+        sleep 0.1
+    done
+done
+
+# host file: each server several times, in varying order, with paths
+#
+for ((round = 0; round < 4; round++)); do
+    for ((i = 0; i < NUM_SERVERS; i++)); do
+        echo "127.0.0.1:$((BASE_PORT + (i * 3 + round) % NUM_SERVERS))/round$round"
+    done
+done > $tmpdir/hosts
+
+# expected output, from scanning one host at a time
+#
+while read host; do
+    $TLS_SCANNER --host $host --certs --verbosity none
+done < $tmpdir/hosts > $tmpdir/expected
+[ -s $tmpdir/expected ] || fail "no output from sequential scans"
+
+echo "checking ordered concurrent scan output"
+$TLS_SCANNER --host-file $tmpdir/hosts --certs --verbosity none --concurrency 4 --timeout 5 > $tmpdir/ordered \
+    || fail "concurrent scan failed"
+diff $tmpdir/expected $tmpdir/ordered > /dev/null || fail "ordered output differs from sequential output"
+
+echo "checking unordered concurrent scan output"
+$TLS_SCANNER --host-file $tmpdir/hosts --certs --verbosity none --concurrency 16 --unordered > $tmpdir/unordered \
+    || fail "concurrent scan failed"
+diff <(sort $tmpdir/expected) <(sort $tmpdir/unordered) > /dev/null || fail "unordered output differs from sequential output"
+
+echo "checking timeout and connection failure"
+closed_port=$((BASE_PORT + NUM_SERVERS + 1))
+{ echo "127.0.0.1:$silent_port"; echo "127.0.0.1:$closed_port"; cat $tmpdir/hosts; } > $tmpdir/hosts_with_failures
+start=$SECONDS
+$TLS_SCANNER --host-file $tmpdir/hosts_with_failures --certs --verbosity warnings --concurrency 8 --timeout 1 \
+             > $tmpdir/with_failures 2> $tmpdir/warnings || fail "concurrent scan failed"
+[ $((SECONDS - start)) -lt 10 ] || fail "timed out scan was not abandoned"
+grep -q "timed out" $tmpdir/warnings || fail "no timeout reported"
+grep -q "127.0.0.1 failed" $tmpdir/warnings || fail "no connection failure reported"
+diff $tmpdir/expected $tmpdir/with_failures > /dev/null || fail "output differs when some scans fail"
+
+echo "passed tls_scanner concurrent scan test"
@@ -0,0 +1,227 @@
+/*
+ * buffer_stream_test.cc
+ *
+ * checks that the number, timestamp, and address formatting in
+ * buffer_stream produces the same output as printf(), strftime(),
+ * and straightforward implementations of RFC 5952
+ *
+ * Copyright (c) 2021 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <random>
+#include <string>
+#include <cinttypes>
+#include <cmath>
+#include "catch.hpp"
+#include "buffer_stream.h"
+#include "json_object.h"
+
+// format() returns the output of func(buffer_stream &), or the empty
+// string if that output was truncated
+//
+template <typename F>
+static std::string format(F func, int dlen=128) {
+    std::vector<char> buf(dlen);
+    buffer_stream b{buf.data(), dlen};
+    func(b);
+    if (b.trunc) {
+        return "";
+    }
+    return std::string(buf.data(), b.doff);
+}
+
+template <typename... Args>
+static std::string printf_string(const char *fmt, Args... args) {
+    char buf[512];
+    int len = ::snprintf(buf, sizeof(buf), fmt, args...);
+    return std::string(buf, len);
+}
+
+// ipv6_addr_string() is a direct implementation of RFC 5952 Section 4
+//
+static std::string ipv6_addr_string(const uint8_t *v6) {
+    unsigned int group[8];
+    for (int i = 0; i < 8; i++) {
+        group[i] = (v6[2*i] << 8) | v6[2*i+1];
+    }
+    int best_start = -1, best_length = 0;
+    for (int i = 0; i < 8; ) {
+        int j = i;
+        while (j < 8 && group[j] == 0) {
+            j++;
+        }
+        if (j - i > best_length && j - i >= 2) {
+            best_start = i;
+            best_length = j - i;
+        }
+        i = (j == i) ? i + 1 : j;
+    }
+    std::string s;
+    for (int i = 0; i < 8; i++) {
+        if (i == best_start) {
+            s += "::";
+            i += best_length - 1;
+            continue;
+        }
+        if (!s.empty() && s.back() != ':') {
+            s += ':';
+        }
+        s += printf_string("%x", group[i]);
+    }
+    return s;
+}
+
+TEST_CASE("buffer_stream integer formatting matches printf") {
+    std::mt19937_64 rng{0x64656331};
+    std::vector<uint64_t> values;
+    uint64_t p = 1;
+    for (int i = 0; i < 20; i++) {
+        values.push_back(p - 1);
+        values.push_back(p);
+        values.push_back(p + 1);
+        p *= 10;
+    }
+    values.push_back(UINT64_MAX);
+    for (int i = 0; i < 10000; i++) {
+        values.push_back(rng() >> (rng() % 64));
+    }
+    for (uint64_t u : values) {
+        INFO("value: " << u);
+        CHECK(format([u](buffer_stream &b) { b.write_uint64(u); }) == printf_string("%" PRIu64, u));
+        int64_t i = (int64_t)u;
+        CHECK(format([i](buffer_stream &b) { b.write_int64(i); }) == printf_string("%" PRId64, i));
+        CHECK(format([i](buffer_stream &b) { b.write_int64(-i); }) == printf_string("%" PRId64, -i));
+        CHECK(format([u](buffer_stream &b) { b.write_uint16(u); }) == printf_string("%u", (uint16_t)u));
+        CHECK(format([u](buffer_stream &b) { b.write_uint8(u); }) == printf_string("%u", (uint8_t)u));
+    }
+    CHECK(format([](buffer_stream &b) { b.write_int64(INT64_MIN); }) == printf_string("%" PRId64, INT64_MIN));
+}
+
+TEST_CASE("buffer_stream float formatting matches printf") {
+    std::mt19937_64 rng{0x666c6f61};
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+    std::vector<double> values = {
+        0.0, -0.0, 1.0, -1.0, 0.5, 0.0000005, 0.0000015, 0.0000025, -0.0000005, 1e-9, -1e-9,
+        123456.1234565, 2.5e-7, 1e9, 1e12, 1e15, 1e300, -1e300, 1.0/3.0, 2.0/3.0,
+        INFINITY, -INFINITY, NAN, (double)UINT64_MAX
+    };
+    for (int i = 0; i < 100000; i++) {
+        double scale = std::pow(10.0, (int)(rng() % 20) - 8);
+        double d = unit(rng) * scale;
+        values.push_back((rng() & 1) ? -d : d);
+    }
+    for (int i = 0; i < 10000; i++) {
+        // values with exactly six decimal places, and halfway cases
+        double d = (double)(rng() % 100000000000) / 1000000.0;
+        values.push_back(d);
+        values.push_back(d + 0.0000005);
+    }
+    for (double d : values) {
+        INFO("value: " << printf_string("%a", d));
+        CHECK(format([d](buffer_stream &b) { b.write_float(d); }, 512) == printf_string("%f", d));
+    }
+}
+
+TEST_CASE("buffer_stream timestamp formatting matches printf and strftime") {
+    std::mt19937_64 rng{0x74696d65};
+    std::vector<struct timespec> values = {
+        { 0, 0 }, { 1, 999999999 }, { 951782400, 1000 }, { 1634846862, 105263000 },
+        { 4107542399, 999999 }, { 253402300799, 999999999 }
+    };
+    for (int i = 0; i < 100000; i++) {
+        values.push_back({ (time_t)(rng() % 253402300800), (long)(rng() % 1000000000) });
+    }
+    for (const struct timespec &ts : values) {
+        INFO("value: " << ts.tv_sec << " " << ts.tv_nsec);
+
+        CHECK(format([&ts](buffer_stream &b) { b.write_timestamp(&ts); })
+              == printf_string("%" PRIu64 ".%06lu", (uint64_t)ts.tv_sec, ts.tv_nsec / 1000));
+
+        struct tm tm;
+        gmtime_r(&ts.tv_sec, &tm);
+        char time_buf[64];
+        strftime(time_buf, sizeof(time_buf), "%Y-%m-%dT%H:%M:%S.", &tm);
+        CHECK(format([&ts](buffer_stream &b) { b.write_timestamp_as_string(&ts); })
+              == printf_string("%s%09luZ", time_buf, ts.tv_nsec));
+    }
+}
+
+TEST_CASE("buffer_stream address formatting") {
+    std::mt19937 rng{0x61646472};
+
+    for (int i = 0; i < 100000; i++) {
+        uint8_t v4[4];
+        for (auto &x : v4) {
+            x = (rng() & 3) ? rng() : rng() % 10;
+        }
+        CHECK(format([&v4](buffer_stream &b) { b.write_ipv4_addr(v4); })
+              == printf_string("%u.%u.%u.%u", v4[0], v4[1], v4[2], v4[3]));
+    }
+
+    // every pattern of zero and nonzero fields, with nonzero fields
+    // of each length
+    //
+    for (unsigned int mask = 0; mask < 256; mask++) {
+        for (int trial = 0; trial < 16; trial++) {
+            uint8_t v6[16];
+            for (int g = 0; g < 8; g++) {
+                uint16_t x = 0;
+                if (!(mask & (1 << g))) {
+                    x = 1 + rng() % (0xffff >> (4 * (rng() % 4)));
+                }
+                v6[2*g] = x >> 8;
+                v6[2*g+1] = x;
+            }
+            std::string expected = ipv6_addr_string(v6);
+            INFO("expected: " << expected);
+            CHECK(format([&v6](buffer_stream &b) { b.write_ipv6_addr(v6); }) == expected);
+        }
+    }
+
+    const uint8_t a[16] = { 0x26, 0x04, 0x2d, 0xc0, 0x01, 0x00, 0x23, 0x93, 0, 0, 0, 0, 0, 0, 0, 0 };
+    CHECK(format([&a](buffer_stream &b) { b.write_ipv6_addr(a); }) == "2604:2dc0:100:2393::");
+    const uint8_t c[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1 };
+    CHECK(format([&c](buffer_stream &b) { b.write_ipv6_addr(c); }) == "2001:db8::1:0:0:1");
+    const uint8_t d[16] = { 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+    CHECK(format([&d](buffer_stream &b) { b.write_ipv6_addr(d); }) == "0:0:1::1");
+    const uint8_t e[16] = { 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0 };
+    CHECK(format([&e](buffer_stream &b) { b.write_ipv6_addr(e); }) == "::1:0:1:0:1:0");
+}
+
+TEST_CASE("buffer_stream formatting handles truncation") {
+    const struct timespec ts = { 1634846862, 105263000 };
+    const uint8_t v4[4] = { 192, 168, 100, 254 };
+    const uint8_t v6[16] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1 };
+
+    auto write_record = [&](buffer_stream &b) {
+        json_object o{&b};
+        o.print_key_uint("uint", 18446744073709551615u);
+        o.print_key_int("int", -42);
+        o.print_key_float("float", 3.25);
+        o.print_key_timestamp("event_start", (struct timespec *)&ts);
+        o.print_key_timestamp_as_string("time", (struct timespec *)&ts);
+        o.print_key_ipv4_addr("src_ip", v4);
+        o.print_key_ipv6_addr("dst_ip", v6);
+        o.print_key_string("string", "value");
+        o.close();
+    };
+    std::string expected = "{\"uint\":18446744073709551615,\"int\":-42,\"float\":3.250000,"
+        "\"event_start\":1634846862.105263,\"time\":\"2021-10-21T20:07:42.105263000Z\","
+        "\"src_ip\":\"192.168.100.254\",\"dst_ip\":\"2001:db8::1:0:0:1\",\"string\":\"value\"}";
+    CHECK(format(write_record, 512) == expected);
+
+    // in a smaller buffer, the output is truncated, and nothing is
+    // written at or beyond its last byte
+    //
+    for (int dlen = 1; dlen < (int)expected.size() + 1; dlen++) {
+        INFO("buffer length: " << dlen);
+        std::vector<char> buf(dlen + 1, '*');
+        buffer_stream b{buf.data(), dlen};
+        write_record(b);
+        CHECK(b.trunc == 1);
+        CHECK(b.doff <= dlen);
+        CHECK(buf[dlen] == '*');
+        CHECK(std::string(buf.data(), std::min(b.doff, dlen - 1)) == expected.substr(0, std::min(b.doff, dlen - 1)));
+    }
+}
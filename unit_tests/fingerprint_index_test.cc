@@ -0,0 +1,152 @@
+/*
+ * fingerprint_index_test.cc
+ *
+ * checks the bit-parallel token edit distance against dynamic
+ * programming, and checks that the nearest-fingerprint index finds
+ * the known fingerprints from which unknown ones were derived, and
+ * that nearest_fingerprint_cache memoizes and limits its lookups
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "fingerprint_index.hpp"
+
+static size_t dp_edit_distance(const std::vector<uint32_t> &a, const std::vector<uint32_t> &b) {
+    std::vector<size_t> prev(b.size() + 1), cur(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); j++) {
+        prev[j] = j;
+    }
+    for (size_t i = 1; i <= a.size(); i++) {
+        cur[0] = i;
+        for (size_t j = 1; j <= b.size(); j++) {
+            cur[j] = std::min({ prev[j] + 1, cur[j-1] + 1, prev[j-1] + (a[i-1] != b[j-1]) });
+        }
+        std::swap(prev, cur);
+    }
+    return prev[b.size()];
+}
+
+TEST_CASE("token_edit_distance matches dynamic programming") {
+    std::mt19937 rng{1};
+    for (size_t length : { 0, 1, 5, 63, 64, 65, 100, 128, 129, 300 }) {
+        for (size_t alphabet : { 2, 20 }) {
+            std::uniform_int_distribution<uint32_t> symbol{0, (uint32_t)alphabet - 1};
+            std::uniform_int_distribution<size_t> text_length{0, length + 20};
+            for (size_t trial = 0; trial < 20; trial++) {
+                std::vector<uint32_t> a(length), b(text_length(rng));
+                for (auto &x : a) { x = symbol(rng); }
+                for (auto &x : b) { x = symbol(rng); }
+                token_edit_distance ed{a};
+                CHECK(ed.distance(b) == dp_edit_distance(a, b));
+            }
+        }
+    }
+}
+
+// random_fingerprint() returns a TLS-like fingerprint string with
+// random cipher suites and extensions
+//
+static std::string random_fingerprint(std::mt19937 &rng) {
+    std::uniform_int_distribution<unsigned> u16{0, 0xffff};
+    auto hex = [](unsigned x) { char s[5]; snprintf(s, sizeof(s), "%04x", x); return std::string{s}; };
+    std::string fp = "tls/1/(0303)(";
+    for (size_t i = 0; i < 16; i++) {
+        fp += hex(u16(rng));
+    }
+    fp += ")(";
+    for (size_t i = 0; i < 12; i++) {
+        fp += "(" + hex(u16(rng)) + ")";
+    }
+    return fp + ")";
+}
+
+// mutate() replaces one extension of a fingerprint
+//
+static std::string mutate(std::string fp) {
+    size_t pos = fp.rfind("((") + 2;
+    fp.replace(pos, 4, "beef");
+    return fp;
+}
+
+TEST_CASE("fingerprint_index finds the nearest known fingerprint") {
+    std::mt19937 rng{2};
+    std::vector<std::string> known;
+    for (size_t i = 0; i < 1000; i++) {
+        known.push_back(random_fingerprint(rng));
+    }
+    fingerprint_index index;
+    for (const auto &fp : known) {
+        index.add(fp);
+    }
+    CHECK(index.size() == known.size());
+
+    size_t found = 0;
+    for (size_t i = 0; i < known.size(); i += 10) {
+        fingerprint_index::match m = index.nearest(mutate(known[i]));
+        if (m.fingerprint == known[i]) {
+            found++;
+            CHECK(m.similarity == Approx(1.0 - 1.0 / 29.0));   // one of 29 tokens differs
+        }
+    }
+    CHECK(found >= 95);   // LSH may miss a few of the 100 queries
+
+    // an identical fingerprint has similarity one, and fingerprints
+    // of another type or format are never matched
+    //
+    CHECK(index.nearest(known[0]).similarity == 1.0);
+    std::string other_format = known[0];
+    other_format.replace(0, 6, "tls/2/");
+    CHECK(index.nearest(other_format).fingerprint.empty());
+    CHECK(index.nearest("randomized").fingerprint.empty());
+}
+
+TEST_CASE("nearest_fingerprint_cache memoizes and limits lookups") {
+    std::mt19937 rng{3};
+    std::vector<std::string> known;
+    for (size_t i = 0; i < 100; i++) {
+        known.push_back(random_fingerprint(rng));
+    }
+    fingerprint_index index;
+    for (const auto &fp : known) {
+        index.add(fp);
+    }
+
+    // a repeated fingerprint is answered from the cache, with the
+    // same result as the index
+    //
+    nearest_fingerprint_cache cache;
+    std::string query = mutate(known[0]);
+    fingerprint_index::match m = cache.nearest(index, query, 1);
+    CHECK(m.fingerprint == index.nearest(query).fingerprint);
+    CHECK(m.similarity == index.nearest(query).similarity);
+    fingerprint_index::match again = cache.nearest(index, query, 1);
+    CHECK(again.fingerprint == m.fingerprint);
+    CHECK(cache.get_counts().lookups == 1);
+    CHECK(cache.get_counts().hits == 1);
+
+    // a result from another index is not reused
+    //
+    fingerprint_index other;
+    other.add(known[1]);
+    CHECK(cache.nearest(other, query, 1).fingerprint != m.fingerprint);
+    CHECK(cache.get_counts().lookups == 2);
+
+    // at most max_lookups_per_second misses are looked up in each
+    // second; the rest return an empty match until the next second
+    //
+    nearest_fingerprint_cache limited;
+    size_t found = 0;
+    for (size_t i = 0; i <= nearest_fingerprint_cache::max_lookups_per_second; i++) {
+        found += !limited.nearest(index, known[i % known.size()] + std::to_string(i), 5).fingerprint.empty();
+    }
+    CHECK(limited.get_counts().lookups == nearest_fingerprint_cache::max_lookups_per_second);
+    CHECK(limited.get_counts().skipped == 1);
+    CHECK(found > 0);
+    CHECK(limited.nearest(index, query, 6).fingerprint == m.fingerprint);
+    CHECK(limited.get_counts().lookups == nearest_fingerprint_cache::max_lookups_per_second + 1);
+}
@@ -0,0 +1,381 @@
+/*
+ * ip_defrag_test.cc
+ *
+ * checks that ip_defragmenter reassembles fragmented IPv4 and IPv6
+ * datagrams in any order, applies its overlap policies, and stays
+ * within its memory budget when it is flooded with fragments that
+ * never complete a datagram
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <random>
+#include <vector>
+#include <algorithm>
+#include "catch.hpp"
+#include "ip_defrag.hpp"
+
+using bytes = std::vector<uint8_t>;
+
+static void put_u16(bytes &b, size_t offset, uint16_t x) {
+    b[offset] = x >> 8;
+    b[offset + 1] = x;
+}
+
+static uint16_t ipv4_checksum(const bytes &b, size_t header_length) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < header_length; i += 2) {
+        sum += (uint16_t)(b[i] << 8 | b[i + 1]);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return ~sum;
+}
+
+static bytes random_payload(std::mt19937 &rng, size_t length) {
+    bytes p(length);
+    for (auto &x : p) {
+        x = rng();
+    }
+    return p;
+}
+
+// ipv4_datagram() returns an unfragmented IPv4/UDP datagram with the
+// given payload, with a valid header checksum
+//
+static bytes ipv4_datagram(uint32_t src, uint16_t id, const bytes &payload) {
+    bytes b(20);
+    b[0] = 0x45;
+    put_u16(b, 2, 20 + payload.size());
+    put_u16(b, 4, id);
+    b[8] = 64;
+    b[9] = 17;
+    put_u16(b, 12, src >> 16);
+    put_u16(b, 14, src);
+    put_u16(b, 16, 0xc0a8);
+    put_u16(b, 18, 0x0001);
+    b.insert(b.end(), payload.begin(), payload.end());
+    put_u16(b, 10, ipv4_checksum(b, 20));
+    return b;
+}
+
+// ipv4_fragment() returns the fragment of datagram d that holds the
+// payload bytes in [start, end)
+//
+static bytes ipv4_fragment(const bytes &d, size_t start, size_t end, bool more) {
+    bytes f(d.begin(), d.begin() + 20);
+    f.insert(f.end(), d.begin() + 20 + start, d.begin() + 20 + end);
+    put_u16(f, 2, f.size());
+    put_u16(f, 6, (more ? 0x2000 : 0) | (start / 8));
+    put_u16(f, 10, 0);
+    put_u16(f, 10, ipv4_checksum(f, 20));
+    return f;
+}
+
+// ipv6_datagram() returns an unfragmented IPv6/UDP datagram with a
+// hop-by-hop options header and the given payload
+//
+static bytes ipv6_datagram(uint8_t src, const bytes &payload) {
+    bytes b(48);
+    b[0] = 0x60;
+    put_u16(b, 4, 8 + payload.size());
+    b[6] = 0;       // hop-by-hop options
+    b[7] = 64;
+    b[8] = 0x20;
+    b[23] = src;
+    b[24] = 0x20;
+    b[39] = 1;
+    b[40] = 17;     // udp
+    b[41] = 0;
+    b[42] = 1;      // padn
+    b[43] = 4;
+    b.insert(b.end(), payload.begin(), payload.end());
+    return b;
+}
+
+static bytes ipv6_fragment(const bytes &d, uint32_t id, size_t start, size_t end, bool more) {
+    bytes f(d.begin(), d.begin() + 48);
+    f[40] = 44;     // fragment header follows hop-by-hop options
+    bytes frag_hdr(8);
+    frag_hdr[0] = 17;
+    put_u16(frag_hdr, 2, start | (more ? 1 : 0));
+    put_u16(frag_hdr, 4, id >> 16);
+    put_u16(frag_hdr, 6, id);
+    f.insert(f.end(), frag_hdr.begin(), frag_hdr.end());
+    f.insert(f.end(), d.begin() + 48 + start, d.begin() + 48 + end);
+    put_u16(f, 4, f.size() - 40);
+    return f;
+}
+
+// fragments() splits the payload of a datagram of the given length
+// into pieces with random lengths that are multiples of eight
+//
+static std::vector<std::pair<size_t, size_t>> fragments(std::mt19937 &rng, size_t length) {
+    std::vector<std::pair<size_t, size_t>> v;
+    size_t start = 0;
+    while (start < length) {
+        size_t end = std::min(length, start + 8 * (1 + rng() % 200));
+        v.push_back({start, end});
+        start = end;
+    }
+    return v;
+}
+
+static bytes to_bytes(const datum &d) {
+    return bytes(d.data, d.data_end);
+}
+
+static ip_defragmenter::result apply(ip_defragmenter &defrag, const bytes &pkt, unsigned int sec, bytes *out=nullptr) {
+    datum d{pkt.data(), pkt.data() + pkt.size()};
+    ip_defragmenter::result r = defrag.apply(d, sec);
+    if (out) {
+        *out = to_bytes(d);
+    }
+    return r;
+}
+
+TEST_CASE("ip_defragmenter passes through packets that are not fragments") {
+    ip_defragmenter defrag;
+    std::mt19937 rng{0x64667231};
+    bytes v4 = ipv4_datagram(0x0a000001, 7, random_payload(rng, 100));
+    bytes out;
+    CHECK(apply(defrag, v4, 1, &out) == ip_defragmenter::not_fragment);
+    CHECK(out == v4);
+
+    bytes v6 = ipv6_datagram(1, random_payload(rng, 100));
+    CHECK(apply(defrag, v6, 1, &out) == ip_defragmenter::not_fragment);
+    CHECK(out == v6);
+
+    // an atomic fragment (RFC 6946) is not part of a fragmented datagram
+    //
+    bytes atomic = ipv6_fragment(v6, 99, 0, 100, false);
+    CHECK(apply(defrag, atomic, 1) == ip_defragmenter::not_fragment);
+
+    CHECK(apply(defrag, bytes{}, 1) == ip_defragmenter::not_fragment);
+    CHECK(apply(defrag, bytes{0x45, 0x00}, 1) == ip_defragmenter::not_fragment);
+    CHECK(defrag.get_counts()[ip_defragmenter::fragments] == 0);
+    CHECK(defrag.allocated_bytes() == 0);
+}
+
+TEST_CASE("ip_defragmenter reassembles fragments in any order") {
+    ip_defragmenter defrag;
+    std::mt19937 rng{0x64667232};
+    for (int i = 0; i < 500; i++) {
+        bool v6 = i % 2;
+        size_t length = 1 + rng() % (v6 ? 9000 : 4000);
+        bytes payload = random_payload(rng, length);
+        bytes datagram = v6 ? ipv6_datagram(i, payload) : ipv4_datagram(0x0a000000 + i, i, payload);
+        auto frags = fragments(rng, length);
+        if (frags.size() < 2) {
+            continue;
+        }
+        std::shuffle(frags.begin(), frags.end(), rng);
+
+        INFO("datagram " << i << ", length " << length << ", fragments " << frags.size());
+        for (size_t j = 0; j < frags.size(); j++) {
+            bool more = frags[j].second != length;
+            bytes f = v6 ? ipv6_fragment(datagram, 0x10000 + i, frags[j].first, frags[j].second, more)
+                         : ipv4_fragment(datagram, frags[j].first, frags[j].second, more);
+            bytes out;
+            ip_defragmenter::result r = apply(defrag, f, 10, &out);
+            if (j + 1 < frags.size()) {
+                CHECK(r == ip_defragmenter::held);
+            } else {
+                REQUIRE(r == ip_defragmenter::reassembled);
+                CHECK(out == datagram);
+            }
+        }
+    }
+    CHECK(defrag.size() == 0);
+    CHECK(defrag.slabs_in_use() == 0);
+    const ip_defragmenter::counts &c = defrag.get_counts();
+    CHECK(c[ip_defragmenter::datagrams] > 400);
+    for (size_t i = ip_defragmenter::datagrams + 1; i < ip_defragmenter::num_counters; i++) {
+        INFO("counter " << ip_defragmenter::counter_name[i]);
+        CHECK(c[i] == 0);
+    }
+}
+
+TEST_CASE("ip_defragmenter discards datagrams with overlapping fragments") {
+    ip_defragmenter defrag;
+    std::mt19937 rng{0x64667233};
+    bytes datagram = ipv6_datagram(1, random_payload(rng, 3000));
+
+    // an exact duplicate is ignored
+    //
+    bytes out;
+    CHECK(apply(defrag, ipv6_fragment(datagram, 1, 0, 1000, true), 1) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv6_fragment(datagram, 1, 0, 1000, true), 1) == ip_defragmenter::dropped);
+    CHECK(apply(defrag, ipv6_fragment(datagram, 1, 1000, 2000, true), 1) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv6_fragment(datagram, 1, 2000, 3000, false), 1, &out) == ip_defragmenter::reassembled);
+    CHECK(out == datagram);
+    CHECK(defrag.get_counts()[ip_defragmenter::duplicate] == 1);
+
+    // an overlap discards the datagram, and its later fragments are
+    // dropped, even though they would complete it (RFC 5722)
+    //
+    CHECK(apply(defrag, ipv6_fragment(datagram, 2, 0, 1000, true), 1) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv6_fragment(datagram, 2, 992, 2000, true), 1) == ip_defragmenter::dropped);
+    CHECK(defrag.slabs_in_use() == 0);
+    CHECK(apply(defrag, ipv6_fragment(datagram, 2, 1000, 2000, true), 1) == ip_defragmenter::dropped);
+    CHECK(apply(defrag, ipv6_fragment(datagram, 2, 2000, 3000, false), 1) == ip_defragmenter::dropped);
+    CHECK(defrag.get_counts()[ip_defragmenter::overlap] == 1);
+    CHECK(defrag.get_counts()[ip_defragmenter::discarded] == 2);
+
+    // the same applies to IPv4 by default
+    //
+    bytes v4 = ipv4_datagram(0x0a000001, 3, random_payload(rng, 3000));
+    CHECK(apply(defrag, ipv4_fragment(v4, 1000, 3000, false), 1) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv4_fragment(v4, 0, 1008, true), 1) == ip_defragmenter::dropped);
+    CHECK(apply(defrag, ipv4_fragment(v4, 0, 1000, true), 1) == ip_defragmenter::dropped);
+    CHECK(defrag.get_counts()[ip_defragmenter::overlap] == 2);
+
+    // after the timeout, the datagram can be reassembled again
+    //
+    unsigned int later = 1 + ip_defragmenter::timeout;
+    CHECK(apply(defrag, ipv4_fragment(v4, 0, 1000, true), later) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv4_fragment(v4, 1000, 3000, false), later, &out) == ip_defragmenter::reassembled);
+    CHECK(out == v4);
+}
+
+TEST_CASE("ip_defragmenter keeps the first data with the first_wins policy") {
+    ip_defragmenter defrag{ip_defragmenter::default_slabs, ip_defragmenter::default_datagrams, ip_defragmenter::overlap_policy::first_wins};
+    std::mt19937 rng{0x64667234};
+    bytes datagram = ipv4_datagram(0x0a000001, 1, random_payload(rng, 4000));
+    bytes other = ipv4_datagram(0x0a000001, 1, random_payload(rng, 4000));
+
+    // the fragments of other overlap those of datagram, which arrive
+    // first, so its data is used only to fill the gaps between them
+    //
+    bytes out;
+    CHECK(apply(defrag, ipv4_fragment(datagram, 0, 1000, true), 1) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv4_fragment(datagram, 2000, 3000, true), 1) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv4_fragment(other, 0, 1000, true), 1) == ip_defragmenter::dropped);
+    CHECK(apply(defrag, ipv4_fragment(other, 504, 3000, true), 1) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv4_fragment(datagram, 3000, 4000, false), 1, &out) == ip_defragmenter::reassembled);
+
+    bytes expected = datagram;
+    std::copy(other.begin() + 20 + 1000, other.begin() + 20 + 2000, expected.begin() + 20 + 1000);
+    CHECK(out == expected);
+    CHECK(defrag.get_counts()[ip_defragmenter::overlap] == 1);
+    CHECK(defrag.get_counts()[ip_defragmenter::duplicate] == 1);
+}
+
+TEST_CASE("ip_defragmenter drops malformed and oversized fragments") {
+    ip_defragmenter defrag;
+    std::mt19937 rng{0x64667235};
+    bytes datagram = ipv4_datagram(0x0a000001, 1, random_payload(rng, 3000));
+
+    // a fragment that is not the last must hold a multiple of eight
+    // bytes
+    //
+    CHECK(apply(defrag, ipv4_fragment(datagram, 0, 1001, true), 1) == ip_defragmenter::dropped);
+    CHECK(defrag.get_counts()[ip_defragmenter::malformed] == 1);
+
+    // the total length must not exceed the packet length
+    //
+    bytes truncated = ipv4_fragment(datagram, 0, 1000, true);
+    truncated.resize(500);
+    CHECK(apply(defrag, truncated, 1) == ip_defragmenter::dropped);
+    CHECK(defrag.get_counts()[ip_defragmenter::malformed] == 2);
+
+    // the last fragment must not end before data already received
+    //
+    CHECK(apply(defrag, ipv4_fragment(datagram, 1000, 2000, true), 1) == ip_defragmenter::held);
+    CHECK(apply(defrag, ipv4_fragment(datagram, 400, 800, false), 1) == ip_defragmenter::dropped);
+    CHECK(defrag.get_counts()[ip_defragmenter::malformed] == 3);
+
+    // a datagram cannot be longer than 65535 bytes
+    //
+    bytes big = ipv4_datagram(0x0a000002, 2, random_payload(rng, 2000));
+    bytes f = ipv4_fragment(big, 0, 1000, false);
+    put_u16(f, 6, 8191);    // offset 65528
+    CHECK(apply(defrag, f, 1) == ip_defragmenter::dropped);
+    CHECK(defrag.get_counts()[ip_defragmenter::too_long] == 1);
+
+    // a datagram can have no more than max_fragments fragments
+    //
+    bytes many = ipv4_datagram(0x0a000003, 3, random_payload(rng, 8 * (ip_defragmenter::max_fragments + 1)));
+    for (size_t i = 0; i < ip_defragmenter::max_fragments; i++) {
+        CHECK(apply(defrag, ipv4_fragment(many, 8 * i, 8 * (i + 1), true), 1) == ip_defragmenter::held);
+    }
+    CHECK(apply(defrag, ipv4_fragment(many, 8 * ip_defragmenter::max_fragments, 8 * (ip_defragmenter::max_fragments + 1), false), 1) == ip_defragmenter::dropped);
+    CHECK(defrag.get_counts()[ip_defragmenter::too_many_fragments] == 1);
+    CHECK(defrag.slabs_in_use() == 0);
+}
+
+TEST_CASE("ip_defragmenter memory is bounded under a fragment flood") {
+    static constexpr size_t slabs = 256;
+    static constexpr size_t datagrams = 64;
+    ip_defragmenter defrag{slabs, datagrams};
+    std::mt19937 rng{0x64667236};
+    bytes payload = random_payload(rng, 8192);
+
+    // each flood fragment starts a new datagram that is never
+    // completed, and uses as many slabs as it can
+    //
+    size_t allocated = 0;
+    for (uint32_t i = 0; i < 200000; i++) {
+        unsigned int sec = i / 10000;
+        bytes flood = ipv4_datagram(rng(), rng(), payload);
+        size_t start = 8 * (rng() % 512);
+        size_t end = std::min(start + 1480, payload.size());
+        CHECK(apply(defrag, ipv4_fragment(flood, start, end, true), sec) != ip_defragmenter::reassembled);
+        if (i == 0) {
+            allocated = defrag.allocated_bytes();
+        }
+        if (i % 1000 == 0) {
+            CHECK(defrag.allocated_bytes() == allocated);
+            CHECK(defrag.slabs_in_use() <= slabs);
+            CHECK(defrag.size() <= datagrams);
+        }
+
+        // a legitimate datagram still gets through the flood
+        //
+        if (i % 10000 == 5000) {
+            bytes datagram = ipv4_datagram(0x0a000001, i, payload);
+            CHECK(apply(defrag, ipv4_fragment(datagram, 0, 1480, true), sec) == ip_defragmenter::held);
+            bytes out;
+            CHECK(apply(defrag, ipv4_fragment(datagram, 1480, payload.size(), false), sec, &out) == ip_defragmenter::reassembled);
+            CHECK(out == datagram);
+        }
+    }
+    CHECK(defrag.allocated_bytes() == allocated);
+    CHECK(allocated < (slabs + 1) * ip_defragmenter::slab_size + 2 * ip_defragmenter::max_length
+                      + datagrams * (ip_defragmenter::max_header_length + 8 * ip_defragmenter::max_fragments + 2 * ip_defragmenter::max_slabs_per_datagram + 64));
+    const ip_defragmenter::counts &c = defrag.get_counts();
+    CHECK(c[ip_defragmenter::datagrams] == 20);
+    CHECK(c[ip_defragmenter::evicted] + c[ip_defragmenter::expired] > 0);
+    CHECK(c[ip_defragmenter::no_memory] == 0);
+    CHECK(c[ip_defragmenter::fragments] == 200000 + 2 * 20);
+}
+
+TEST_CASE("ip_defragmenter drops fragments when its slabs are exhausted") {
+    ip_defragmenter defrag{16, 64};
+    std::mt19937 rng{0x64667237};
+    bytes payload = random_payload(rng, 16384);
+
+    // each datagram holds eight slabs, so only two fit
+    //
+    for (uint16_t id = 0; id < 3; id++) {
+        bytes datagram = ipv4_datagram(0x0a000001, id, payload);
+        ip_defragmenter::result expected = id < 2 ? ip_defragmenter::held : ip_defragmenter::dropped;
+        CHECK(apply(defrag, ipv4_fragment(datagram, 0, 8192, true), 1) == expected);
+    }
+    CHECK(defrag.get_counts()[ip_defragmenter::no_memory] == 1);
+    CHECK(defrag.slabs_in_use() == 16);
+
+    // after the timeout, the slabs of the incomplete datagrams are
+    // reclaimed for new ones
+    //
+    unsigned int later = 1 + ip_defragmenter::timeout;
+    bytes datagram = ipv4_datagram(0x0a000001, 3, payload);
+    CHECK(apply(defrag, ipv4_fragment(datagram, 0, 8192, true), later) == ip_defragmenter::held);
+    bytes out;
+    CHECK(apply(defrag, ipv4_fragment(datagram, 8192, payload.size(), false), later, &out) == ip_defragmenter::reassembled);
+    CHECK(out == datagram);
+    CHECK(defrag.get_counts()[ip_defragmenter::expired] == 2);
+    CHECK(defrag.slabs_in_use() == 0);
+}
@@ -61,6 +61,8 @@ struct libmerc_api {
     decltype(analysis_context_get_malware_info)                      *get_malware_info = nullptr;
     decltype(mercury_write_stats_data)                               *write_stats_data = nullptr;
     decltype(mercury_packet_processor_get_attributes)                        *get_attributes = nullptr;
+    decltype(mercury_reload_resources)                               *reload_resources = nullptr;
+    decltype(mercury_get_resource_reload_count)                      *get_resource_reload_count = nullptr;
 
     void *dl_handle = nullptr;
 
@@ -87,6 +89,8 @@ struct libmerc_api {
         get_malware_info =              (decltype(get_malware_info))              dlsym(dl_handle, "analysis_context_get_malware_info");
         write_stats_data =              (decltype(write_stats_data))              dlsym(dl_handle, "mercury_write_stats_data");
         get_attributes =                (decltype(get_attributes))                dlsym(dl_handle, "mercury_packet_processor_get_attributes");
+        reload_resources =              (decltype(reload_resources))              dlsym(dl_handle, "mercury_reload_resources");
+        get_resource_reload_count =     (decltype(get_resource_reload_count))     dlsym(dl_handle, "mercury_get_resource_reload_count");
 
         if (init                          == nullptr ||
             finalize                      == nullptr ||
@@ -100,7 +104,9 @@ struct libmerc_api {
             get_process_info              == nullptr ||
             get_malware_info              == nullptr ||
             write_stats_data              == nullptr ||
-            get_attributes                == nullptr ) {
+            get_attributes                == nullptr ||
+            reload_resources              == nullptr ||
+            get_resource_reload_count     == nullptr ) {
             fprintf(stderr, "error: could not initialize one or more libmerc function pointers\n");
             return -1;
         }
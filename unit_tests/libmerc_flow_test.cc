@@ -7,7 +7,13 @@
  * https://github.com/cisco/mercury/blob/master/LICENSE
  */
 
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <unistd.h>
 #include "libmerc_driver_helper.hpp"
+#include "pcap.h"
 
 int test_libmerc(const struct libmerc_config *config, int verbosity, bool fail=false) {
     int num_loops = 4;
@@ -169,3 +175,297 @@ TEST_CASE("double_bind_test") {
     int retval = double_bind_test(&config_lite, &config);
     REQUIRE_FALSE(retval);
 }
+
+struct reload_processor_state {
+    struct libmerc_api *mercury;
+    mercury_context mc;
+    std::atomic<bool> *stop;
+    size_t num_packets;
+    size_t num_missing_results;
+};
+
+void *reload_processor(void *arg) {
+    reload_processor_state *rp = (reload_processor_state *)arg;
+    struct timespec time;
+    time.tv_sec = time.tv_nsec = 0;
+
+    mercury_packet_processor mpp = rp->mercury->packet_processor_construct(rp->mc);
+    if (mpp == NULL) {
+        fprintf(stderr, "error in mercury_packet_processor_construct()\n");
+        return NULL;
+    }
+
+    // keep processing packets while the resources are being reloaded;
+    // every client hello should be analyzed, with either classifier
+    //
+    while (rp->stop->load() == false) {
+        const struct analysis_context *ctx = rp->mercury->get_analysis_context(mpp, client_hello_eth, client_hello_eth_len, &time);
+        if (ctx == nullptr) {
+            rp->num_missing_results++;
+        }
+        rp->num_packets++;
+    }
+
+    rp->mercury->packet_processor_destruct(mpp);
+
+    return NULL;
+}
+
+int reload_test(const struct libmerc_config *config, int verbosity) {
+    constexpr int num_threads = 4;
+    constexpr int max_wait_secs = 120;
+
+    libmerc_api mercury(path_to_libmerc_library);
+
+    mercury_context mc = mercury.init(config, verbosity);
+    if (mc == nullptr) {
+        fprintf(stderr, "error: mercury_init() returned null\n");
+        return -1;
+    }
+
+    std::atomic<bool> stop{false};
+    std::array<pthread_t, num_threads> tid_array;
+    std::array<reload_processor_state, num_threads> thread_state;
+    for (int idx=0; idx < num_threads; idx++) {
+        thread_state[idx] = { &mercury, mc, &stop, 0, 0 };
+        pthread_create(&tid_array[idx], NULL, reload_processor, &thread_state[idx]);
+    }
+
+    int retval = 0;
+    if (mercury.get_resource_reload_count(mc) != 0) {
+        fprintf(stderr, "error: nonzero reload count before reload\n");
+        retval = -1;
+    }
+    if (mercury.reload_resources(mc, nullptr) == false) {
+        fprintf(stderr, "error: mercury_reload_resources() failed to start\n");
+        retval = -1;
+    }
+    if (mercury.reload_resources(mc, nullptr) == true) {
+        fprintf(stderr, "error: mercury_reload_resources() started while a reload was in progress\n");
+        retval = -1;
+    }
+    int secs = 0;
+    while (mercury.get_resource_reload_count(mc) == 0 && secs++ < max_wait_secs) {
+        sleep(1);
+    }
+    if (mercury.get_resource_reload_count(mc) != 1) {
+        fprintf(stderr, "error: resources were not reloaded\n");
+        retval = -1;
+    }
+    sleep(2);   // let the processors run with the new classifier, past the grace period
+
+    stop.store(true);
+    for (auto & t : tid_array) {
+        pthread_join(t, NULL);
+    }
+    for (const auto & s : thread_state) {
+        fprintf(stderr, "processed %zu packets, with %zu missing results\n", s.num_packets, s.num_missing_results);
+        if (s.num_packets == 0 || s.num_missing_results != 0) {
+            retval = -1;
+        }
+    }
+
+    // an archive that cannot be loaded leaves the current resources in place
+    //
+    const char *bad_resources = "nonexistent-resources.tgz";
+    if (mercury.reload_resources(mc, bad_resources) == true) {
+        secs = 0;
+        while (mercury.reload_resources(mc, bad_resources) == false && secs++ < max_wait_secs) {
+            sleep(1);
+        }
+        if (mercury.get_resource_reload_count(mc) != 1) {
+            fprintf(stderr, "error: failed reload replaced the current resources\n");
+            retval = -1;
+        }
+    }
+
+    mercury.finalize(mc);
+
+    return retval;
+}
+
+TEST_CASE("reload_test") {
+    libmerc_config config = create_config();
+
+    int retval = reload_test(&config, verbosity);
+    REQUIRE_FALSE(retval);
+}
+
+// reload_idle_processor_test() checks that a reload completes while a
+// packet processor exists but is not processing packets; a second
+// reload can only start once the first one has retired the old
+// classifier
+//
+int reload_idle_processor_test(const struct libmerc_config *config, int verbosity) {
+    constexpr int max_wait_secs = 120;
+
+    libmerc_api mercury(path_to_libmerc_library);
+
+    mercury_context mc = mercury.init(config, verbosity);
+    if (mc == nullptr) {
+        fprintf(stderr, "error: mercury_init() returned null\n");
+        return -1;
+    }
+    mercury_packet_processor idle = mercury.packet_processor_construct(mc);
+    if (idle == NULL) {
+        fprintf(stderr, "error in mercury_packet_processor_construct()\n");
+        mercury.finalize(mc);
+        return -1;
+    }
+    struct timespec time;
+    time.tv_sec = time.tv_nsec = 0;
+    mercury.get_analysis_context(idle, client_hello_eth, client_hello_eth_len, &time);
+
+    int retval = 0;
+    if (mercury.reload_resources(mc, nullptr) == false) {
+        fprintf(stderr, "error: mercury_reload_resources() failed to start\n");
+        retval = -1;
+    }
+    int secs = 0;
+    while (mercury.reload_resources(mc, nullptr) == false && secs++ < max_wait_secs) {
+        sleep(1);
+    }
+    if (secs >= max_wait_secs) {
+        fprintf(stderr, "error: reload did not complete while a packet processor was idle\n");
+        retval = -1;
+    }
+
+    // the idle processor switches to the newest classifier when it
+    // processes its next packet
+    //
+    while (mercury.get_resource_reload_count(mc) < 2 && secs++ < max_wait_secs) {
+        sleep(1);
+    }
+    const struct analysis_context *ctx = mercury.get_analysis_context(idle, client_hello_eth, client_hello_eth_len, &time);
+    if (ctx == nullptr) {
+        fprintf(stderr, "error: no analysis result after reload\n");
+        retval = -1;
+    }
+
+    mercury.packet_processor_destruct(idle);
+    mercury.finalize(mc);
+
+    return retval;
+}
+
+TEST_CASE("reload_idle_processor_test") {
+    libmerc_config config = create_config();
+
+    int retval = reload_idle_processor_test(&config, verbosity);
+    REQUIRE_FALSE(retval);
+}
+
+// write_json_batch_test() checks that the JSON records written by
+// mercury_packet_processor_write_json_batch() are identical to those
+// written by mercury_packet_processor_write_json() for each packet in
+// a pcap file.  The two passes over the packets use separate mercury
+// contexts, since the analysis state in a context (e.g. fingerprint
+// prevalence) is shared by all of its packet processors.
+//
+int write_json_batch_test(const struct libmerc_config *config, const char *pcap_file_name, size_t batch_size) {
+    constexpr size_t max_record_size = 65536;
+
+    // read all of the packets into memory; each copy is padded so that
+    // it can be read like the packet buffers that are used in practice,
+    // which are larger than the packets that they hold
+    //
+    constexpr size_t padding = 64;
+    std::vector<std::vector<uint8_t>> pkts;
+    std::vector<size_t> pkt_lengths;
+    pcap::file_reader pcap{pcap_file_name};
+    while (true) {
+        std::pair<const uint8_t *, const uint8_t *> p = pcap.read_packet();
+        if (p.first == nullptr || p.second == nullptr) {
+            break;
+        }
+        pkts.emplace_back(p.first, p.second);
+        pkt_lengths.push_back(pkts.back().size());
+        pkts.back().resize(pkts.back().size() + padding, 0);
+    }
+
+    libmerc_api mercury(path_to_libmerc_library);
+
+    // first pass: write the record for each packet individually
+    //
+    mercury_context mc = mercury.init(config, verbosity);
+    if (mc == nullptr) {
+        fprintf(stderr, "error: mercury_init() returned null\n");
+        return -1;
+    }
+    mercury_packet_processor single = mercury.packet_processor_construct(mc);
+    std::vector<std::string> records;
+    std::vector<uint8_t> buffer(max_record_size);
+    for (size_t i = 0; i < pkts.size(); i++) {
+        struct timespec t = { (time_t)(1 + i), 0 };
+        size_t len = mercury_packet_processor_write_json(single, buffer.data(), buffer.size(), pkts[i].data(), pkt_lengths[i], &t);
+        records.emplace_back((const char *)buffer.data(), len);
+    }
+    mercury.packet_processor_destruct(single);
+    mercury.finalize(mc);
+
+    // second pass: write the records in batches, and compare them to
+    // those from the first pass
+    //
+    mc = mercury.init(config, verbosity);
+    if (mc == nullptr) {
+        fprintf(stderr, "error: mercury_init() returned null\n");
+        return -1;
+    }
+    mercury_packet_processor batch = mercury.packet_processor_construct(mc);
+    std::vector<uint8_t> arena(max_record_size * 4);
+    std::vector<uint8_t *> packets(batch_size);
+    std::vector<size_t> lengths(batch_size);
+    std::vector<struct timespec> ts(batch_size);
+    std::vector<size_t> offsets(batch_size);
+    std::vector<size_t> record_lengths(batch_size);
+
+    int retval = 0;
+    size_t num_records = 0;
+    for (size_t start = 0; start < pkts.size(); ) {
+        size_t n = std::min(batch_size, pkts.size() - start);
+        for (size_t i = 0; i < n; i++) {
+            packets[i] = pkts[start + i].data();
+            lengths[i] = pkt_lengths[start + i];
+            ts[i] = { (time_t)(1 + start + i), 0 };
+        }
+        size_t num_processed = mercury_packet_processor_write_json_batch(batch,
+                                                                         arena.data(), arena.size(), max_record_size,
+                                                                         packets.data(), lengths.data(), ts.data(), nullptr, n,
+                                                                         offsets.data(), record_lengths.data());
+        if (num_processed == 0) {
+            fprintf(stderr, "error: mercury_packet_processor_write_json_batch() processed no packets\n");
+            retval = -1;
+            break;
+        }
+        for (size_t i = 0; i < num_processed; i++) {
+            const std::string &r = records[start + i];
+            if (r.length() != record_lengths[i] || memcmp(r.data(), arena.data() + offsets[i], r.length()) != 0) {
+                fprintf(stderr, "error: batch output differs from single packet output for packet %zu\n", start + i);
+                retval = -1;
+            }
+            num_records += (r.length() > 0);
+        }
+        start += num_processed;
+    }
+    fprintf(stderr, "compared %zu records from %zu packets in %s\n", num_records, pkts.size(), pcap_file_name);
+
+    mercury.packet_processor_destruct(batch);
+    mercury.finalize(mc);
+
+    return retval;
+}
+
+TEST_CASE("write_json_batch_test") {
+    char filter[] = "select=all;reassembly;";
+    libmerc_config config = create_config(false, false, true, true, false, false, true, true);
+    config.packet_filter_cfg = filter;
+
+    for (const char *pcap_file_name : { "./pcaps/capture2.pcap",
+                                        "./pcaps/top_100_fingerprints.pcap",
+                                        "./pcaps/multi_packet_http_request.pcap",
+                                        "./pcaps/quic_init.capture2.pcap" }) {
+        for (size_t batch_size : { 1, 7, 64 }) {
+            REQUIRE_FALSE(write_json_batch_test(&config, pcap_file_name, batch_size));
+        }
+    }
+}
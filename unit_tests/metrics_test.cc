@@ -0,0 +1,249 @@
+/*
+ * metrics_test.cc
+ *
+ * checks the Prometheus text exposition written by
+ * mercury_get_metrics(), and the HTTP endpoint of metrics_server
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "libmerc_driver_helper.hpp"
+#include "metrics.h"
+
+// struct exposition holds the metric types and samples parsed from
+// the Prometheus text format, and checks that each sample follows
+// the HELP and TYPE lines of its metric family
+//
+struct exposition {
+    std::map<std::string, std::string> types;     // metric name -> type
+    std::map<std::string, double> samples;        // series -> value
+    std::vector<std::string> errors;
+
+    explicit exposition(const std::string &text) {
+        static const std::regex help_line{"# HELP ([a-zA-Z_:][a-zA-Z0-9_:]*) .+"};
+        static const std::regex type_line{"# TYPE ([a-zA-Z_:][a-zA-Z0-9_:]*) (counter|gauge)"};
+        static const std::regex sample_line{"([a-zA-Z_:][a-zA-Z0-9_:]*)(\\{[a-z_]+=\"[^\"]*\"(,[a-z_]+=\"[^\"]*\")*\\})? ([0-9.e+-]+)"};
+
+        std::istringstream lines{text};
+        std::string line;
+        std::string help_name;
+        std::string family;
+        while (std::getline(lines, line)) {
+            std::smatch m;
+            if (std::regex_match(line, m, help_line)) {
+                help_name = m[1];
+            } else if (std::regex_match(line, m, type_line)) {
+                if (m[1] != help_name) {
+                    errors.push_back("TYPE without HELP: " + line);
+                }
+                if (types.find(m[1]) != types.end()) {
+                    errors.push_back("duplicate TYPE: " + line);
+                }
+                family = m[1];
+                types[family] = m[2];
+                if (m[2] == "counter" && family.size() > 6 && family.compare(family.size() - 6, 6, "_total") != 0) {
+                    errors.push_back("counter without _total suffix: " + line);
+                }
+            } else if (std::regex_match(line, m, sample_line)) {
+                if (m[1] != family) {
+                    errors.push_back("sample outside of its family: " + line);
+                }
+                std::string series = m[1].str() + m[2].str();
+                if (samples.find(series) != samples.end()) {
+                    errors.push_back("duplicate sample: " + line);
+                }
+                samples[series] = strtod(m[4].str().c_str(), nullptr);
+            } else {
+                errors.push_back("malformed line: " + line);
+            }
+        }
+    }
+
+    double value(const std::string &series) const {
+        auto it = samples.find(series);
+        return it == samples.end() ? 0.0 : it->second;
+    }
+
+    bool has(const std::string &series) const {
+        return samples.find(series) != samples.end();
+    }
+
+    std::string type(const std::string &name) const {
+        auto it = types.find(name);
+        return it == types.end() ? "" : it->second;
+    }
+
+    // counters_not_less_than() returns true if every counter in prev
+    // is present here with a value that is at least as large
+    //
+    bool counters_not_less_than(const exposition &prev) const {
+        for (const auto &[series, v] : prev.samples) {
+            std::string name = series.substr(0, series.find('{'));
+            if (prev.type(name) == "counter" && (!has(series) || value(series) < v)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static std::string get_metrics(mercury_context mc) {
+    std::vector<char> buffer(65536);
+    size_t len = mercury_get_metrics(mc, buffer.data(), buffer.size());
+    return std::string{buffer.data(), len};
+}
+
+// http_request() sends request to the metrics server on port, and
+// returns the response, or an empty string on failure
+//
+static std::string http_request(uint16_t port, const std::string &request) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return "";
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    std::string response;
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 && send(fd, request.data(), request.size(), 0) == (ssize_t)request.size()) {
+        char buf[4096];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+            response.append(buf, n);
+        }
+    }
+    close(fd);
+    return response;
+}
+
+TEST_CASE("mercury_get_metrics writes the Prometheus text format") {
+    libmerc_config config = create_config(false, false, false, true, false);
+    mercury_context mc = mercury_init(&config, verbosity);
+    REQUIRE(mc != nullptr);
+
+    exposition before{get_metrics(mc)};
+    CHECK(before.errors.empty());
+    CHECK(before.type("libmerc_packet_processors") == "gauge");
+    CHECK(before.type("libmerc_reassembly_flows") == "gauge");
+    CHECK(before.type("libmerc_records_total") == "counter");
+    CHECK(before.type("libmerc_analysis_results_total") == "counter");
+    CHECK(before.type("libmerc_ip_fragments_total") == "counter");
+    CHECK(before.type("libmerc_ip_fragment_drops_total") == "counter");
+    CHECK(before.type("libmerc_records_suppressed_total") == "counter");
+    CHECK(before.type("libmerc_suppression_summaries_dropped_total") == "counter");
+    CHECK(before.type("libmerc_resource_reloads_total") == "counter");
+    CHECK(before.value("libmerc_packet_processors") == 0);
+    CHECK(before.value("libmerc_resource_reloads_total") == 0);
+
+    mercury_packet_processor mpp = mercury_packet_processor_construct(mc);
+    REQUIRE(mpp != nullptr);
+    std::vector<uint8_t> buffer(65536);
+    size_t num_records = 0;
+    for (size_t i = 0; i < 8; i++) {
+        struct timespec ts = { (time_t)(1 + i), 0 };
+        num_records += mercury_packet_processor_write_json(mpp, buffer.data(), buffer.size(), client_hello_eth, client_hello_eth_len, &ts) > 0;
+    }
+    REQUIRE(num_records > 0);
+
+    exposition after{get_metrics(mc)};
+    for (const std::string &e : after.errors) {
+        UNSCOPED_INFO(e);
+    }
+    CHECK(after.errors.empty());
+    CHECK(after.value("libmerc_packet_processors") == 1);
+    CHECK(after.value("libmerc_records_total{protocol=\"tls_client_hello\"}") == num_records);
+    double analysis_results = 0;
+    for (const auto &[series, v] : after.samples) {
+        if (series.rfind("libmerc_analysis_results_total{", 0) == 0) {
+            analysis_results += v;
+        }
+    }
+    CHECK(analysis_results == num_records);
+    CHECK(after.counters_not_less_than(before));
+
+    // counters never decrease, even when a processor is destructed
+    //
+    mercury_packet_processor_destruct(mpp);
+    exposition destructed{get_metrics(mc)};
+    CHECK(destructed.errors.empty());
+    CHECK(destructed.value("libmerc_packet_processors") == 0);
+    CHECK(destructed.counters_not_less_than(after));
+
+    // a buffer that is too small for the metrics yields nothing,
+    // rather than a truncated exposition
+    //
+    char small[64];
+    CHECK(mercury_get_metrics(mc, small, sizeof(small)) == 0);
+    CHECK(mercury_get_metrics(mc, nullptr, 0) == 0);
+    CHECK(mercury_get_metrics(nullptr, small, sizeof(small)) == 0);
+
+    mercury_finalize(mc);
+}
+
+TEST_CASE("metrics_server serves metrics over HTTP") {
+    libmerc_config config = create_config(false, false, false, false, false);
+    mercury_context mc = mercury_init(&config, verbosity);
+    REQUIRE(mc != nullptr);
+
+    capture_metrics capture{2};
+    capture_thread_metrics::add(capture.get(1)->packets, 3);
+    capture_thread_metrics::add(capture.get(1)->bytes, 1500);
+    CHECK(capture.get(2) == nullptr);
+
+    // find an unused port
+    //
+    std::unique_ptr<metrics_server> server;
+    uint16_t port = 0;
+    for (uint16_t p = 39090; p < 39190 && server == nullptr; p++) {
+        try {
+            server = std::make_unique<metrics_server>(mc, p, nullptr, &capture);
+            port = p;
+        }
+        catch (std::exception &) { }
+    }
+    REQUIRE(server != nullptr);
+
+    std::string response = http_request(port, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    REQUIRE(response.rfind("HTTP/1.0 200 OK\r\n", 0) == 0);
+    CHECK(response.find("Content-Type: text/plain; version=0.0.4") != std::string::npos);
+    size_t body_start = response.find("\r\n\r\n");
+    REQUIRE(body_start != std::string::npos);
+    std::string body = response.substr(body_start + 4);
+    CHECK(response.find("Content-Length: " + std::to_string(body.size()) + "\r\n") != std::string::npos);
+
+    exposition first{body};
+    CHECK(first.errors.empty());
+    CHECK(first.type("mercury_capture_packets_total") == "counter");
+    CHECK(first.value("mercury_capture_packets_total{thread=\"0\"}") == 0);
+    CHECK(first.value("mercury_capture_packets_total{thread=\"1\"}") == 3);
+    CHECK(first.value("mercury_capture_bytes_total{thread=\"1\"}") == 1500);
+    CHECK(first.has("libmerc_packet_processors"));
+
+    capture_thread_metrics::add(capture.get(0)->packets, 5);
+    response = http_request(port, "GET /metrics HTTP/1.1\r\n\r\n");
+    body_start = response.find("\r\n\r\n");
+    REQUIRE(body_start != std::string::npos);
+    exposition second{response.substr(body_start + 4)};
+    CHECK(second.errors.empty());
+    CHECK(second.value("mercury_capture_packets_total{thread=\"0\"}") == 5);
+    CHECK(second.counters_not_less_than(first));
+
+    CHECK(http_request(port, "GET /other HTTP/1.1\r\n\r\n").rfind("HTTP/1.0 404 Not Found\r\n", 0) == 0);
+    CHECK(http_request(port, "POST /metrics HTTP/1.1\r\nContent-Length: 0\r\n\r\n").rfind("HTTP/1.0 405 Method Not Allowed\r\n", 0) == 0);
+
+    server.reset();
+    CHECK(http_request(port, "GET /metrics HTTP/1.1\r\n\r\n").empty());
+
+    mercury_finalize(mc);
+}
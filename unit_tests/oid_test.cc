@@ -0,0 +1,130 @@
+/*
+ * oid_test.cc
+ *
+ * checks that the compile-time OID table generated by oidc is sorted
+ * and consistent, and that oid::get_string() and oid::get_enum()
+ * return the names and enumerations of known OIDs, and nothing for
+ * unknown ones, just as the unordered_map lookup that the table
+ * replaced did
+ *
+ * Copyright (c) 2021 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "asn1/oid.h"
+
+static std::vector<uint8_t> entry_bytes(const oid::oid_entry &e) {
+    return std::vector<uint8_t>(oid::oid_bytes + e.offset, oid::oid_bytes + e.offset + e.length);
+}
+
+static std::string lookup_string(const std::vector<uint8_t> &v) {
+    datum d{v.data(), v.data() + v.size()};
+    return oid::get_string(&d);
+}
+
+static oid::type lookup_enum(const std::vector<uint8_t> &v) {
+    datum d{v.data(), v.data() + v.size()};
+    return oid::get_enum(&d);
+}
+
+TEST_CASE("oid table is sorted and indexed by length") {
+    const size_t table_size = sizeof(oid::oid_table) / sizeof(oid::oid_table[0]);
+    REQUIRE(table_size > 0);
+    CHECK(oid::oid_index[0] == 0);
+    CHECK(oid::oid_index[oid::max_oid_length + 1] == table_size);
+
+    std::set<uint32_t> values;
+    for (size_t i = 0; i < table_size; i++) {
+        const oid::oid_entry &e = oid::oid_table[i];
+        INFO("entry " << i << ": " << e.name);
+        CHECK(e.length > 0);
+        CHECK(e.length <= oid::max_oid_length);
+        CHECK(oid::oid_index[e.length] <= i);
+        CHECK(i < oid::oid_index[e.length + 1]);
+        CHECK(e.value != oid::unknown);
+        CHECK(values.insert(e.value).second);
+        if (i > 0) {
+            const oid::oid_entry &prev = oid::oid_table[i - 1];
+            bool ordered = prev.length < e.length || (prev.length == e.length && entry_bytes(prev) < entry_bytes(e));
+            CHECK(ordered);
+        }
+    }
+}
+
+TEST_CASE("oid lookups find every table entry and nothing else") {
+    for (const auto &e : oid::oid_table) {
+        std::vector<uint8_t> v = entry_bytes(e);
+        INFO("oid: " << e.name);
+        CHECK(lookup_string(v) == e.name);
+        CHECK(lookup_enum(v) == e.value);
+
+        // truncations and extensions are unknown, unless they are
+        // in the table themselves
+        //
+        for (std::vector<uint8_t> w : { std::vector<uint8_t>(v.begin(), v.end() - 1), v }) {
+            if (w.size() == v.size()) {
+                w.push_back(0x01);
+            }
+            datum d{w.data(), w.data() + w.size()};
+            const oid::oid_entry *found = oid::find_oid(&d);
+            if (found == nullptr) {
+                CHECK(lookup_string(w) == "");
+                CHECK(lookup_enum(w) == oid::unknown);
+            } else {
+                CHECK(entry_bytes(*found) == w);
+            }
+        }
+    }
+
+    datum null{nullptr, nullptr};
+    CHECK(std::string(oid::get_string(&null)) == "");
+    CHECK(oid::get_enum(&null) == oid::unknown);
+    std::vector<uint8_t> too_long(oid::max_oid_length + 1, 0x2a);
+    CHECK(lookup_enum(too_long) == oid::unknown);
+}
+
+TEST_CASE("oid lookups match the names of well known OIDs") {
+    struct {
+        std::vector<uint8_t> der;
+        const char *name;
+        oid::type value;
+    } known[] = {
+        { { 0x55, 0x04, 0x03 }, "common_name", oid::common_name },
+        { { 0x55, 0x1d, 0x11 }, "subject_alt_name", oid::subject_alt_name },
+        { { 0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x01 }, "rsaEncryption", oid::rsaEncryption },
+        { { 0x2a, 0x86, 0x48, 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x0b }, "sha256WithRSAEncryption", oid::sha256WithRSAEncryption },
+        { { 0x2a, 0x86, 0x48, 0xce, 0x3d, 0x03, 0x01, 0x07 }, "prime256v1", oid::prime256v1 },
+        { { 0x2b, 0x06, 0x01, 0x05, 0x05, 0x07, 0x03, 0x01 }, "id-kp-serverAuth", oid::id_kp_serverAuth },
+        { { 0x2a, 0x81, 0x1c, 0xcf, 0x55, 0x04, 0x03 }, "Certificate_Authority", oid::Certificate_Authority },
+    };
+    for (const auto &k : known) {
+        INFO("oid: " << k.name);
+        CHECK(lookup_string(k.der) == k.name);
+        CHECK(lookup_enum(k.der) == k.value);
+    }
+}
+
+TEST_CASE("oid lookups match the unordered_map lookup that the table replaced") {
+    struct {
+        std::vector<uint8_t> der;
+        const char *name;
+        oid::type value;
+    } legacy[] = {
+#include "oid_legacy_map.inc"
+    };
+    const size_t table_size = sizeof(oid::oid_table) / sizeof(oid::oid_table[0]);
+    CHECK(sizeof(legacy) / sizeof(legacy[0]) == table_size);
+    for (const auto &l : legacy) {
+        INFO("oid: " << l.name);
+        datum d{l.der.data(), l.der.data() + l.der.size()};
+        const oid::oid_entry *e = oid::find_oid(&d);
+        REQUIRE(e != nullptr);
+        CHECK(entry_bytes(*e) == l.der);
+        CHECK(lookup_string(l.der) == l.name);
+        CHECK(lookup_enum(l.der) == l.value);
+    }
+}
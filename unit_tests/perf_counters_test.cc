@@ -0,0 +1,159 @@
+/*
+ * perf_counters_test.cc
+ *
+ * checks the cycle histograms of perf_counters.hpp, and the
+ * mercury_write_perf_counters() entry point of libmerc; the debug
+ * libraries are built with LIBMERC_PERF_COUNTERS, so that the
+ * counters are compiled in
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "libmerc_driver_helper.hpp"
+#include "libmerc/perf_counters.hpp"
+
+// read_file() returns the contents of the file file_name, or an empty
+// string if it could not be read
+//
+static std::string read_file(const char *file_name) {
+    std::ifstream f{file_name};
+    std::stringstream s;
+    s << f.rdbuf();
+    return s.str();
+}
+
+// count_of() returns the "count" of the histogram with the JSON key
+// name in the perf counters json, or zero if there is no such
+// histogram; histograms with no observations are omitted
+//
+static uint64_t count_of(const std::string &json, const std::string &name) {
+    std::string key = "\"" + name + "\":{\"count\":";
+    size_t pos = json.find(key);
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    return strtoull(json.c_str() + pos + key.length(), nullptr, 10);
+}
+
+TEST_CASE("cycle_histogram buckets by powers of two") {
+    cycle_histogram h;
+    for (uint64_t cycles : { 0, 1, 2, 3, 4, 1000, 1023, 1024 }) {
+        h.observe(cycles);
+    }
+    h.observe(UINT64_MAX);              // counted in the last bucket
+
+    cycle_histogram::snapshot s;
+    h.add_to(s);
+    CHECK(s.count == 9);
+    CHECK(s.buckets[0] == 2);           // 0 and 1
+    CHECK(s.buckets[1] == 2);           // 2 and 3
+    CHECK(s.buckets[2] == 1);           // 4
+    CHECK(s.buckets[9] == 2);           // 1000 and 1023
+    CHECK(s.buckets[10] == 1);          // 1024
+    CHECK(s.buckets[cycle_histogram::num_buckets - 1] == 1);
+
+    // snapshots accumulate
+    //
+    h.add_to(s);
+    CHECK(s.count == 18);
+    CHECK(s.buckets[9] == 4);
+
+    // the histogram is written up to its last non-empty bucket
+    //
+    cycle_histogram small;
+    small.observe(4);
+    small.observe(5);
+    cycle_histogram::snapshot t;
+    small.add_to(t);
+    char output[256];
+    struct buffer_stream buf{output, sizeof(output)};
+    struct json_object o{&buf};
+    t.write_json(o, "stage");
+    o.close();
+    buf.write_char('\0');
+    CHECK(std::string{output} == "{\"stage\":{\"count\":2,\"total_cycles\":9,\"mean_cycles\":4.500000,\"log2_histogram\":[0,0,2]}}");
+}
+
+TEST_CASE("mercury_write_perf_counters requires the perf-counters option") {
+    const char *file_name = "perf_counters_disabled.json";
+    remove(file_name);
+
+    libmerc_config config = create_config(false, false, false, false, false);
+    mercury_context mc = mercury_init(&config, verbosity);
+    REQUIRE(mc != nullptr);
+    CHECK_FALSE(mercury_write_perf_counters(mc, file_name));
+    CHECK_FALSE(mercury_write_perf_counters(mc, nullptr));
+    CHECK_FALSE(mercury_write_perf_counters(nullptr, file_name));
+    mercury_finalize(mc);
+
+    FILE *f = fopen(file_name, "r");
+    CHECK(f == nullptr);                // nothing was written
+    if (f) {
+        fclose(f);
+    }
+}
+
+TEST_CASE("mercury_write_perf_counters reports cumulative counts") {
+    const char *file_name = "perf_counters.json";
+    char filter[] = "select=tls;perf-counters;";
+    libmerc_config config = create_config(false, false, false, false, false);
+    config.packet_filter_cfg = filter;
+    mercury_context mc = mercury_init(&config, verbosity);
+    REQUIRE(mc != nullptr);
+
+    // the file is written even before any packets are processed
+    //
+    REQUIRE(mercury_write_perf_counters(mc, file_name));
+    std::string json = read_file(file_name);
+    CHECK(json.find("\"processors\":0") != std::string::npos);
+    CHECK(json.find("\"ticks_per_second\":") != std::string::npos);
+    CHECK(count_of(json, "tls_client_hello") == 0);
+
+    mercury_packet_processor mpp = mercury_packet_processor_construct(mc);
+    REQUIRE(mpp != nullptr);
+    std::vector<uint8_t> buffer(65536);
+    constexpr size_t num_packets = 16;
+    for (size_t i = 0; i < num_packets; i++) {
+        struct timespec ts = { (time_t)(1 + i), 0 };
+        mercury_packet_processor_write_json(mpp, buffer.data(), buffer.size(), client_hello_eth, client_hello_eth_len, &ts);
+    }
+
+    REQUIRE(mercury_write_perf_counters(mc, file_name));
+    json = read_file(file_name);
+    CHECK(json.find("\"processors\":1") != std::string::npos);
+    CHECK(count_of(json, "tls_client_hello") == num_packets);
+    CHECK(count_of(json, "l2_l3_parse") == num_packets);
+    CHECK(count_of(json, "fingerprint") == num_packets);
+    CHECK(count_of(json, "json_write") > 0);
+    CHECK(json.find("\"log2_histogram\":[") != std::string::npos);
+
+    // counts are kept when a processor is destructed
+    //
+    mercury_packet_processor_destruct(mpp);
+    REQUIRE(mercury_write_perf_counters(mc, file_name));
+    json = read_file(file_name);
+    CHECK(json.find("\"processors\":0") != std::string::npos);
+    CHECK(count_of(json, "tls_client_hello") == num_packets);
+
+    // and the counts of a new processor are added to them
+    //
+    mpp = mercury_packet_processor_construct(mc);
+    REQUIRE(mpp != nullptr);
+    struct timespec ts = { (time_t)(1 + num_packets), 0 };
+    mercury_packet_processor_write_json(mpp, buffer.data(), buffer.size(), client_hello_eth, client_hello_eth_len, &ts);
+    REQUIRE(mercury_write_perf_counters(mc, file_name));
+    json = read_file(file_name);
+    CHECK(count_of(json, "tls_client_hello") == num_packets + 1);
+
+    mercury_packet_processor_destruct(mpp);
+    mercury_finalize(mc);
+    remove(file_name);
+}
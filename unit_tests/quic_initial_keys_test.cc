@@ -0,0 +1,122 @@
+/*
+ * quic_initial_keys_test.cc
+ *
+ * checks the derivation of QUIC Initial packet protection keys
+ * against the test vectors of RFC 9001, Appendix A.1 and RFC 9369,
+ * Appendix A.1, and checks that keys taken from the key cache are
+ * identical to freshly derived ones
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "libmerc/quic.h"
+
+static std::vector<uint8_t> from_hex(const std::string &hex) {
+    std::vector<uint8_t> v;
+    for (size_t i = 0; i + 1 < hex.length(); i += 2) {
+        v.push_back(std::stoi(hex.substr(i, 2), nullptr, 16));
+    }
+    return v;
+}
+
+static std::vector<uint8_t> bytes(const uint8_t *data, size_t length) {
+    return std::vector<uint8_t>(data, data + length);
+}
+
+// the destination connection ID of the client Initial packet in the
+// RFC 9001 and RFC 9369 examples
+//
+static const std::vector<uint8_t> example_dcid = from_hex("8394c8f03e515708");
+
+TEST_CASE("kdf_tls13 matches RFC 9001 Appendix A.1") {
+    crypto_engine crypto;
+
+    std::vector<uint8_t> salt = from_hex("38762cf7f55934b34d179ae6a4c80cadccbb7f0a");
+    uint8_t initial_secret[EVP_MAX_MD_SIZE];
+    unsigned int initial_secret_len = 0;
+    REQUIRE(crypto.hmac_sha256(salt.data(), salt.size(), example_dcid.data(), example_dcid.size(), initial_secret, &initial_secret_len));
+    CHECK(bytes(initial_secret, initial_secret_len) == from_hex("7db5df06e7a69e432496adedb00851923595221596ae2ae9fb8115c1e9ed0a44"));
+
+    const std::string client_in{"tls13 client in"};
+    uint8_t client_initial_secret[32];
+    unsigned int client_initial_secret_len = 0;
+    REQUIRE(crypto.kdf_tls13(initial_secret, initial_secret_len, (const uint8_t *)client_in.data(), client_in.length(),
+                             sizeof(client_initial_secret), client_initial_secret, &client_initial_secret_len));
+    CHECK(bytes(client_initial_secret, client_initial_secret_len) == from_hex("c00cf151ca5be075ed0ebfb5c80323c42d6b7db67881289af4008f1f6c357aea"));
+
+    const std::string quic_key{"tls13 quic key"};
+    uint8_t key[16];
+    unsigned int key_len = 0;
+    REQUIRE(crypto.kdf_tls13(client_initial_secret, client_initial_secret_len, (const uint8_t *)quic_key.data(), quic_key.length(),
+                             sizeof(key), key, &key_len));
+    CHECK(bytes(key, key_len) == from_hex("1f369613dd76d5467730efcbe3b1a22d"));
+
+    // failures are reported, and leave the output length at zero
+    //
+    unsigned int len = 1;
+    CHECK_FALSE(crypto.kdf_tls13(client_initial_secret, client_initial_secret_len, (const uint8_t *)quic_key.data(), quic_key.length(),
+                                 sizeof(key), nullptr, &len));
+    CHECK(len == 0);
+    std::vector<uint8_t> long_label(4096, 'x');
+    len = 1;
+    CHECK_FALSE(crypto.kdf_tls13(client_initial_secret, client_initial_secret_len, long_label.data(), long_label.size(),
+                                 sizeof(key), key, &len));
+    CHECK(len == 0);
+}
+
+TEST_CASE("quic initial keys match RFC 9001 and RFC 9369, with and without the key cache") {
+    struct test_vector {
+        uint32_t version;
+        const char *key;
+        const char *iv;
+        const char *hp;
+    } test_vectors[] = {
+        { 0x00000001, "1f369613dd76d5467730efcbe3b1a22d", "fa044b2f42a3fd3b46fb255c", "9f50449e04a0e810283a1e9933adedd2" },  // RFC 9001
+        { 0x6b3343cf, "8b1a0bc121284290a29e0971b5cd045d", "91f73e2351d8fa91660e909f", "45b95e15235d6f45a6b19cbcb0294ba9" },  // RFC 9369
+    };
+
+    quic_parameters &quic_params = quic_parameters::create();
+    quic_crypto_engine engine;
+    datum dcid{example_dcid.data(), example_dcid.data() + example_dcid.size()};
+
+    for (const test_vector &tv : test_vectors) {
+        const quic_parameters::initial_params *params = quic_params.get_initial_params(tv.version);
+        REQUIRE(params != nullptr);
+        uint32_t params_id = quic_parameters::encode(*params);
+
+        CHECK(engine.get_key_cache().find(params_id, dcid) == nullptr);
+        quic_initial_key_cache::keys derived;
+        REQUIRE(engine.get_initial_keys(*params, dcid, derived));
+        CHECK(bytes(derived.key, sizeof(derived.key)) == from_hex(tv.key));
+        CHECK(bytes(derived.iv, sizeof(derived.iv)) == from_hex(tv.iv));
+        CHECK(bytes(derived.hp, sizeof(derived.hp)) == from_hex(tv.hp));
+
+        // the second lookup is a cache hit, which must yield the same keys
+        //
+        const quic_initial_key_cache::keys *cached = engine.get_key_cache().find(params_id, dcid);
+        REQUIRE(cached != nullptr);
+        quic_initial_key_cache::keys from_cache;
+        REQUIRE(engine.get_initial_keys(*params, dcid, from_cache));
+        CHECK(bytes(from_cache.key, sizeof(from_cache.key)) == from_hex(tv.key));
+        CHECK(bytes(from_cache.iv, sizeof(from_cache.iv)) == from_hex(tv.iv));
+        CHECK(bytes(from_cache.hp, sizeof(from_cache.hp)) == from_hex(tv.hp));
+    }
+
+    // connection IDs that are too long to cache are derived each time
+    //
+    std::vector<uint8_t> long_dcid(quic_initial_key_cache::max_dcid_length + 1, 0x5a);
+    datum long_dcid_datum{long_dcid.data(), long_dcid.data() + long_dcid.size()};
+    const quic_parameters::initial_params *v1 = quic_params.get_initial_params(0x00000001);
+    REQUIRE(v1 != nullptr);
+    quic_initial_key_cache::keys first, second;
+    REQUIRE(engine.get_initial_keys(*v1, long_dcid_datum, first));
+    CHECK(engine.get_key_cache().find(quic_parameters::encode(*v1), long_dcid_datum) == nullptr);
+    REQUIRE(engine.get_initial_keys(*v1, long_dcid_datum, second));
+    CHECK(bytes(first.key, sizeof(first.key)) == bytes(second.key, sizeof(second.key)));
+    CHECK(bytes(first.iv, sizeof(first.iv)) == bytes(second.iv, sizeof(second.iv)));
+    CHECK(bytes(first.hp, sizeof(first.hp)) == bytes(second.hp, sizeof(second.hp)));
+}
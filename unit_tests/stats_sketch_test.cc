@@ -0,0 +1,88 @@
+/*
+ * stats_sketch_test.cc
+ *
+ * checks the accuracy of the hyperloglog distinct-count estimator and
+ * the guarantees of the space_saving heavy-hitter summary, against
+ * exact counts of synthetic streams
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <random>
+#include <map>
+#include <string>
+#include "catch.hpp"
+#include "stats_sketch.hpp"
+
+TEST_CASE("hyperloglog estimates distinct counts") {
+    for (size_t n : { 1, 10, 100, 1000, 10000, 100000 }) {
+        hyperloglog<10> hll;
+        for (size_t i = 0; i < n; i++) {
+            std::string s = "10.0." + std::to_string(i / 256) + "." + std::to_string(i % 256);
+            hll.add(sketch_hash(s));
+            hll.add(sketch_hash(s));   // duplicates must not be counted
+        }
+        double error = std::abs(hll.estimate() - (double)n) / n;
+        CHECK(error < (n <= 100 ? 0.02 : 0.1));   // linear counting is nearly exact for small n
+    }
+}
+
+TEST_CASE("space_saving tracks heavy hitters with bounded overestimates") {
+    struct no_value { };
+    constexpr size_t k = 16;
+    space_saving<no_value> summary{k};
+    std::map<std::string, uint64_t> exact;
+
+    // a zipf-like stream over 1000 keys
+    std::mt19937 rng{1};
+    std::vector<double> weights;
+    for (size_t i = 1; i <= 1000; i++) {
+        weights.push_back(1.0 / i);
+    }
+    std::discrete_distribution<size_t> zipf(weights.begin(), weights.end());
+    constexpr size_t n = 100000;
+    bool replaced;
+    std::string evicted_key;
+    no_value evicted_value;
+    for (size_t i = 0; i < n; i++) {
+        std::string key = "dst" + std::to_string(zipf(rng));
+        summary.observe(key, sketch_hash(key), replaced, evicted_key, evicted_value);
+        exact[key]++;
+    }
+
+    CHECK(summary.size() == k);
+    uint64_t total = 0;
+    uint64_t min_count = UINT64_MAX;
+    for (const auto *c : summary.sorted()) {
+        total += c->count;
+        min_count = std::min(min_count, c->count);
+        CHECK(c->count >= exact[c->key]);
+        CHECK(c->count - exact[c->key] <= c->error);
+        CHECK(c->error <= n / k);
+    }
+    CHECK(total == n);   // the counts of a space-saving summary always sum to the stream length
+
+    for (const auto &[key, count] : exact) {
+        if (count > min_count) {
+            bool found = false;
+            for (const auto *c : summary.sorted()) {
+                found |= (c->key == key);
+            }
+            CHECK(found);
+        }
+    }
+}
+
+TEST_CASE("space_saving floor keeps counts as overestimates") {
+    struct no_value { };
+    space_saving<no_value> summary{4};
+    summary.set_floor(10);
+    bool replaced;
+    std::string evicted_key;
+    no_value evicted_value;
+    const auto &c = summary.observe("a", sketch_hash("a"), replaced, evicted_key, evicted_value);
+    CHECK(replaced == false);
+    CHECK(c.count == 11);
+    CHECK(c.error == 10);
+}
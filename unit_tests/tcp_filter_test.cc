@@ -0,0 +1,271 @@
+/*
+ * tcp_filter_test.cc
+ *
+ * checks that tcp_initial_message_filter accepts and drops the same
+ * packets as a filter with an unbounded table, and that its table
+ * stays within its memory budget, expiring and evicting entries as
+ * needed.  The soak test, which is hidden and must be selected by
+ * its tag, feeds 100M synthetic flows through a filter and checks
+ * that the memory allocated does not grow:
+ *
+ *    ./libmerc_driver_tls_only "[soak]"
+ *
+ * Copyright (c) 2021 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <random>
+#include <unordered_map>
+#include <malloc.h>
+#include "catch.hpp"
+#include "tcp.h"
+
+#ifdef __SANITIZE_ADDRESS__
+extern "C" size_t __sanitizer_get_current_allocated_bytes(void);
+#endif
+
+// allocated_bytes() returns the number of bytes currently allocated
+// on the heap
+//
+static size_t allocated_bytes() {
+#ifdef __SANITIZE_ADDRESS__
+    return __sanitizer_get_current_allocated_bytes();
+#else
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+#endif
+}
+
+// tcp_packet() returns a TCP header with the given ports, flags,
+// and sequence and acknowledgement numbers
+//
+static tcp_header tcp_packet(uint16_t src_port, uint16_t dst_port, uint8_t flags, uint32_t seq, uint32_t ack) {
+    tcp_header tcp;
+    memset(&tcp, 0, sizeof(tcp));
+    tcp.src_port = hton(src_port);
+    tcp.dst_port = hton(dst_port);
+    tcp.seq = hton(seq);
+    tcp.ack = hton(ack);
+    tcp.offrsv = 5 << 4;
+    tcp.flags = flags;
+    return tcp;
+}
+
+static constexpr uint8_t fin = 0x01, syn = 0x02, rst = 0x04, ack = 0x10;
+
+// unbounded_filter implements the same message logic as
+// tcp_initial_message_filter::apply() with an unordered_map that
+// never expires or evicts entries
+//
+struct unbounded_filter {
+    std::unordered_map<struct key, struct tcp_state> table;
+
+    size_t apply(struct key &k, const struct tcp_header *tcp, size_t length) {
+        k.src_port = tcp->src_port;
+        k.dst_port = tcp->dst_port;
+        size_t data_length = length - tcp_offrsv_get_header_length(tcp->offrsv);
+        auto it = table.find(k);
+        if (it == table.end()) {
+            uint32_t tmp_seq = TCP_IS_SYN(tcp->flags) ? hton(ntoh(tcp->seq) + 1) : tcp->seq;
+            table[k] = { tmp_seq, tcp->ack, 0, tmp_seq, tcp->ack, listening };
+            return ACCEPT_PACKET;
+        }
+        size_t retval = DROP_PACKET;
+        struct tcp_state &state = it->second;
+        if (state.ack == 0) {
+            state.ack = tcp->ack;
+            state.init_ack = tcp->ack;
+        }
+        if (data_length > 0) {
+            if (ntoh(tcp->ack) > ntoh(state.ack) || state.disposition == listening) {
+                state.msg_num++;
+            }
+            state.disposition = talking;
+        } else if (ntoh(tcp->ack) > ntoh(state.ack)) {
+            state.disposition = listening;
+        }
+        if (state.disposition == talking && state.msg_num < 2) {
+            retval = ACCEPT_PACKET;
+        }
+        if (ntoh(tcp->seq) > ntoh(state.seq)) {
+            state.seq = tcp->seq;
+        }
+        if (ntoh(tcp->ack) > ntoh(state.ack)) {
+            state.ack = tcp->ack;
+        }
+        if (TCP_IS_FIN(tcp->flags) || TCP_IS_RST(tcp->flags)) {
+            table.erase(it);
+        }
+        return retval;
+    }
+};
+
+TEST_CASE("tcp_initial_message_filter matches an unbounded filter") {
+    std::mt19937 rng{0x74637066};
+    unbounded_filter expected;
+    tcp_initial_message_filter actual{4096};
+
+    // packets from a few hundred flows, each a mix of handshake,
+    // data, and pure acknowledgement segments, with the occasional
+    // FIN or RST
+    //
+    for (int i = 0; i < 200000; i++) {
+        uint32_t addr = 0x0a000000 + rng() % 300;
+        uint16_t sport = 1024 + rng() % 2;
+        uint8_t flags = ack;
+        switch (rng() % 16) {
+        case 0: flags = syn; break;
+        case 1: flags |= fin; break;
+        case 2: flags |= rst; break;
+        default: break;
+        }
+        tcp_header tcp = tcp_packet(sport, 443, flags, rng() % 4096, rng() % 4096);
+        size_t length = sizeof(tcp) + ((rng() % 2) ? rng() % 1400 : 0);
+
+        key k1{0, 0, addr, 0xc0a80001, 6};
+        key k2{k1};
+        INFO("packet " << i);
+        CHECK(actual.apply(k1, 1, &tcp, length) == expected.apply(k2, &tcp, length));
+        CHECK(actual.size() == expected.table.size());
+    }
+    CHECK(actual.get_evictions() == 0);
+    CHECK(actual.get_expirations() == 0);
+}
+
+TEST_CASE("tcp_initial_message_filter evicts entries when full") {
+    tcp_initial_message_filter filter{100};
+    for (uint32_t i = 0; i < 1000; i++) {
+        tcp_header tcp = tcp_packet(1024, 443, syn, 7, 0);
+        key k{0, 0, 0x0a000000 + i, 0xc0a80001, 6};
+        CHECK(filter.apply(k, 10, &tcp, sizeof(tcp)) == ACCEPT_PACKET);
+        CHECK(filter.size() <= filter.capacity());
+    }
+    CHECK(filter.size() == 100);
+    CHECK(filter.get_inserts() == 1000);
+    CHECK(filter.get_evictions() == 900);
+    CHECK(filter.get_expirations() == 0);
+    CHECK(filter.slots() == 256);
+
+    // the most recent flow is still in the table
+    //
+    key last{hton<uint16_t>(1024), hton<uint16_t>(443), 0x0a000000 + 999, 0xc0a80001, 6};
+    REQUIRE(filter.get_state(last) != nullptr);
+    CHECK(ntoh(filter.get_state(last)->seq) == 8);
+}
+
+TEST_CASE("tcp_initial_message_filter evicts unreferenced entries first") {
+    tcp_initial_message_filter filter{4};
+    auto send = [&](uint32_t addr, uint8_t flags) {
+        tcp_header tcp = tcp_packet(1024, 443, flags, 1, 1);
+        key k{0, 0, addr, 0xc0a80001, 6};
+        return filter.apply(k, 10, &tcp, sizeof(tcp) + 100);
+    };
+    auto present = [&](uint32_t addr) {
+        key k{hton<uint16_t>(1024), hton<uint16_t>(443), addr, 0xc0a80001, 6};
+        return filter.get_state(k) != nullptr;
+    };
+
+    for (uint32_t a = 1; a <= 4; a++) {
+        send(a, syn);
+    }
+    for (uint32_t a = 1; a <= 3; a++) {
+        CHECK(send(a, ack) == ACCEPT_PACKET);
+    }
+    send(5, syn);
+    CHECK(filter.get_evictions() == 1);
+    CHECK(present(1));
+    CHECK(present(2));
+    CHECK(present(3));
+    CHECK(present(4) == false);
+    CHECK(present(5));
+
+    // a FIN removes its flow from the table
+    //
+    send(5, ack | fin);
+    CHECK(present(5) == false);
+    CHECK(filter.size() == 3);
+}
+
+TEST_CASE("tcp_initial_message_filter expires idle flows") {
+    tcp_initial_message_filter filter{1000};
+    for (uint32_t i = 0; i < 500; i++) {
+        tcp_header tcp = tcp_packet(1024, 443, syn, 1, 0);
+        key k{0, 0, 0x0a000000 + i, 0xc0a80001, 6};
+        filter.apply(k, 100, &tcp, sizeof(tcp));
+    }
+    CHECK(filter.size() == 500);
+
+    // a flow that is seen again after the timeout is treated as a new
+    // flow, and its initial message is accepted again
+    //
+    tcp_header data = tcp_packet(1024, 443, ack, 2, 1);
+    key k{0, 0, 0x0a000000, 0xc0a80001, 6};
+    CHECK(filter.apply(k, 101, &data, sizeof(data) + 10) == ACCEPT_PACKET);
+    data = tcp_packet(1024, 443, ack, 12, 100);
+    CHECK(filter.apply(k, 102, &data, sizeof(data) + 10) == DROP_PACKET);
+    unsigned int later = 102 + tcp_initial_message_filter::timeout;
+    CHECK(filter.apply(k, later, &data, sizeof(data) + 10) == ACCEPT_PACKET);
+    CHECK(filter.get_expirations() >= 1);
+
+    // packets from other flows drive the clock hand around the table,
+    // which removes all of the idle entries
+    //
+    for (uint32_t i = 0; i < filter.slots(); i++) {
+        tcp_header tcp = tcp_packet(2048, 443, rst, 1, 0);
+        key other{0, 0, 0x0b000000, 0xc0a80001, 6};
+        filter.apply(other, later, &tcp, sizeof(tcp));
+    }
+    CHECK(filter.size() <= 2);
+    CHECK(filter.get_expirations() == 500);
+    CHECK(filter.get_evictions() == 0);
+}
+
+TEST_CASE("tcp_initial_message_filter memory is flat over 100M flows", "[.][soak]") {
+    static constexpr uint64_t num_flows = 100000000;
+    static constexpr uint64_t flows_per_second = 100000;
+    tcp_initial_message_filter filter{tcp_initial_message_filter::default_max_entries};
+    std::mt19937_64 rng{0x736f616b};
+
+    // each flow sends a SYN, a data segment, and, for half of the
+    // flows, a FIN; the flows that do not close are left for the
+    // table to expire or evict.  The test framework allocates a
+    // little memory of its own as it records assertions, so the heap
+    // may grow by a small, fixed amount, much less than the size of
+    // one entry per flow
+    //
+    static constexpr size_t slack = 64 * 1024;
+    size_t baseline = 0;
+    size_t slots = 0;
+    size_t max_size = 0;
+    uint64_t closed = 0;
+    for (uint64_t i = 0; i < num_flows; i++) {
+        uint64_t r = rng();
+        unsigned int sec = i / flows_per_second;
+        key k{0, 0, (uint32_t)r, (uint32_t)(r >> 32), 6};
+        uint16_t sport = 1024 + (i % 60000);
+        tcp_header tcp = tcp_packet(sport, 443, syn, (uint32_t)r, 0);
+        filter.apply(k, sec, &tcp, sizeof(tcp));
+        tcp = tcp_packet(sport, 443, ack, (uint32_t)r + 1, 1);
+        filter.apply(k, sec, &tcp, sizeof(tcp) + 100);
+        if (r & 1) {
+            tcp = tcp_packet(sport, 443, ack | fin, (uint32_t)r + 101, 1);
+            filter.apply(k, sec, &tcp, sizeof(tcp));
+            closed++;
+        }
+        if (i == 1000000) {
+            baseline = allocated_bytes();
+            slots = filter.slots();
+        }
+        if (i > 1000000 && i % 10000000 == 0) {
+            size_t allocated = allocated_bytes();
+            INFO("flows: " << i);
+            CHECK(allocated <= baseline + slack);
+            CHECK(filter.slots() == slots);
+        }
+        max_size = std::max(max_size, filter.size());
+    }
+    CHECK(max_size == filter.capacity());
+    CHECK(allocated_bytes() <= baseline + slack);
+    CHECK(filter.get_inserts() == num_flows);
+    CHECK(filter.get_inserts() == closed + filter.get_expirations() + filter.get_evictions() + filter.size());
+}
@@ -0,0 +1,223 @@
+/*
+ * text_encoding_test.cc
+ *
+ * checks that the vectorized text encoding kernels, and the
+ * buffer_stream functions that use them, produce the same output as
+ * the scalar kernels and the bytewise buffer_stream functions
+ *
+ * Copyright (c) 2021 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <random>
+#include <vector>
+#include <string>
+#include "catch.hpp"
+#include "buffer_stream.h"
+#include "utf8.hpp"
+
+using text_encoding::isa;
+
+static std::vector<isa> supported_isas() {
+    std::vector<isa> v;
+    for (isa i : { isa::scalar, isa::sse2, isa::ssse3, isa::avx2, isa::neon }) {
+        if (text_encoding::is_supported(i)) {
+            v.push_back(i);
+        }
+    }
+    return v;
+}
+
+// random_input() returns n random bytes; with probability 1 -
+// clean_fraction, each byte is drawn from all possible values, and
+// otherwise it is a printable ASCII character other than the JSON
+// special characters, so that inputs contain long runs of clean bytes
+//
+static std::vector<uint8_t> random_input(std::mt19937 &rng, size_t n, double clean_fraction) {
+    static const char clean[] = " !#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+    std::uniform_real_distribution<double> coin{0.0, 1.0};
+    std::uniform_int_distribution<int> any_byte{0, 255};
+    std::uniform_int_distribution<size_t> clean_byte{0, sizeof(clean) - 2};
+    std::vector<uint8_t> v(n);
+    for (auto &x : v) {
+        x = coin(rng) < clean_fraction ? clean[clean_byte(rng)] : any_byte(rng);
+    }
+    return v;
+}
+
+static const size_t max_length = 600;
+
+TEST_CASE("text_encoding kernels match scalar kernels") {
+    std::mt19937 rng{0x6d657263};
+    for (isa i : supported_isas()) {
+        INFO("isa: " << text_encoding::isa_name(i));
+        for (size_t n = 0; n < max_length; n++) {
+            for (double clean_fraction : { 0.0, 0.99, 1.0 }) {
+                std::vector<uint8_t> in = random_input(rng, n, clean_fraction);
+                INFO("length: " << n);
+
+                std::string expected(text_encoding::hex_length(n), '\0'), actual(text_encoding::hex_length(n), '\0');
+                text_encoding::hex_scalar(&expected[0], in.data(), n);
+                text_encoding::hex(&actual[0], in.data(), n, i);
+                CHECK(actual == expected);
+
+                expected.assign(text_encoding::base64_length(n), '\0');
+                actual.assign(text_encoding::base64_length(n), '\0');
+                text_encoding::base64_scalar(&expected[0], in.data(), n);
+                text_encoding::base64(&actual[0], in.data(), n, i);
+                CHECK(actual == expected);
+
+                CHECK(text_encoding::json_clean_prefix_length(in.data(), n, i) == text_encoding::json_clean_prefix_length_scalar(in.data(), n));
+                CHECK(text_encoding::is_ascii(in.data(), n, i) == text_encoding::is_ascii_scalar(in.data(), n));
+                CHECK(text_encoding::line_break_offset(in.data(), n, i) == text_encoding::line_break_offset_scalar(in.data(), n));
+            }
+        }
+
+        // a single byte that needs escaping, or has its high bit set,
+        // at each position
+        //
+        for (size_t n = 1; n < 100; n++) {
+            for (size_t pos = 0; pos < n; pos++) {
+                for (uint8_t special : std::initializer_list<uint8_t>{ 0x00, 0x1f, '"', '\\', 0x7f, 0x80, 0xff }) {
+                    std::vector<uint8_t> in(n, 'a');
+                    in[pos] = special;
+                    CHECK(text_encoding::json_clean_prefix_length(in.data(), n, i) == pos);
+                    CHECK(text_encoding::is_ascii(in.data(), n, i) == (special < 0x80));
+                    CHECK(text_encoding::line_break_offset(in.data(), n, i) == n);
+                }
+                for (uint8_t line_break : { '\r', '\n' }) {
+                    std::vector<uint8_t> in(n, 'a');
+                    in[pos] = line_break;
+                    CHECK(text_encoding::line_break_offset(in.data(), n, i) == pos);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("base64 kernel matches known encodings") {
+    const char *in = "Many hands make light work.";
+    const char *expected[] = {
+        "", "TQ==", "TWE=", "TWFu", "TWFueQ==", "TWFueSA=", "TWFueSBo",
+    };
+    for (size_t n = 0; n < sizeof(expected) / sizeof(expected[0]); n++) {
+        std::string out(text_encoding::base64_length(n), '\0');
+        text_encoding::base64(&out[0], (const uint8_t *)in, n);
+        CHECK(out == expected[n]);
+    }
+    std::string out(text_encoding::base64_length(strlen(in)), '\0');
+    text_encoding::base64(&out[0], (const uint8_t *)in, strlen(in));
+    CHECK(out == "TWFueSBoYW5kcyBtYWtlIGxpZ2h0IHdvcmsu");
+}
+
+// output of an append_...() function, for comparing a fast path
+// with the corresponding bytewise function
+//
+struct append_result {
+    std::string buffer;
+    int doff;
+    int trunc;
+    int r;
+
+    bool operator==(const append_result &rhs) const {
+        return buffer == rhs.buffer && doff == rhs.doff && trunc == rhs.trunc && r == rhs.r;
+    }
+};
+
+template <typename F>
+static append_result run_append(int dlen, int start, F append) {
+    std::vector<char> buf(dlen + 1, '*');
+    int doff = start;
+    int trunc = 0;
+    int r = append(buf.data(), &doff, dlen, &trunc);
+    return { std::string(buf.data(), buf.size()), doff, trunc, r };
+}
+
+TEST_CASE("buffer_stream fast paths match bytewise functions") {
+    std::mt19937 rng{0x6a736f6e};
+    for (size_t n : { 0, 1, 2, 3, 15, 16, 17, 31, 32, 33, 47, 48, 49, 100, 255, 256, 257, 400 }) {
+        for (double clean_fraction : { 0.0, 0.5, 0.95, 1.0 }) {
+            std::vector<uint8_t> in = random_input(rng, n, clean_fraction);
+            const uint8_t *data = in.data();
+            INFO("length: " << n << ", clean fraction: " << clean_fraction);
+
+            // try every buffer length up to one that holds the largest
+            // output, so that truncation happens at every position
+            //
+            for (int dlen = 0; dlen < (int)(6 * n + 8); dlen++) {
+                for (int start : { 0, 3 }) {
+                    if (start > dlen) {
+                        continue;
+                    }
+                    INFO("buffer length: " << dlen << ", offset: " << start);
+
+                    CHECK(run_append(dlen, start, [&](char *d, int *o, int l, int *t) { return append_raw_as_hex(d, o, l, t, data, n); })
+                          == run_append(dlen, start, [&](char *d, int *o, int l, int *t) { return append_raw_as_hex_bytewise(d, o, l, t, data, n); }));
+
+                    CHECK(run_append(dlen, start, [&](char *d, int *o, int l, int *t) { return append_raw_as_base64(d, o, l, t, data, n); })
+                          == run_append(dlen, start, [&](char *d, int *o, int l, int *t) { return append_raw_as_base64_bytewise(d, o, l, t, data, n); }));
+
+                    CHECK(run_append(dlen, start, [&](char *d, int *o, int l, int *t) { return append_json_escaped(d, o, l, t, data, n); })
+                          == run_append(dlen, start, [&](char *d, int *o, int l, int *t) { return append_json_escaped_bytewise(d, o, l, t, data, n); }));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("buffer_stream::write_json_clean_prefix matches bytewise writes") {
+    std::mt19937 rng{0x75746638};
+    for (size_t n : { 0, 1, 7, 16, 33, 64, 200 }) {
+        for (double clean_fraction : { 0.5, 0.95, 1.0 }) {
+            std::vector<uint8_t> in = random_input(rng, n, clean_fraction);
+            INFO("length: " << n << ", clean fraction: " << clean_fraction);
+
+            for (int dlen = 1; dlen < (int)n + 8; dlen++) {
+                INFO("buffer length: " << dlen);
+
+                // utf8_string::write() writes clean bytes with write_char()
+                //
+                std::vector<char> expected_buf(dlen, '*');
+                buffer_stream expected{expected_buf.data(), dlen};
+                for (uint8_t c : in) {
+                    expected.write_char(c);
+                }
+                std::vector<char> actual_buf(dlen, '*');
+                buffer_stream actual{actual_buf.data(), dlen};
+                const uint8_t *x = in.data();
+                const uint8_t *end = x + n;
+                while (x < end) {
+                    if (actual.write_json_clean_prefix(x, end) == 0) {
+                        actual.write_char(*x++);
+                    }
+                }
+                CHECK(std::string(actual_buf.begin(), actual_buf.end()) == std::string(expected_buf.begin(), expected_buf.end()));
+                CHECK(actual.doff == expected.doff);
+                CHECK(actual.trunc == expected.trunc);
+
+                // fprintf_json_string_escaped() writes them with
+                // snprintf(), which also writes a null after each one,
+                // so only the bytes before the offset are compared
+                //
+                std::fill(expected_buf.begin(), expected_buf.end(), '*');
+                buffer_stream expected_snprintf{expected_buf.data(), dlen};
+                for (uint8_t c : in) {
+                    expected_snprintf.snprintf("%c", c);
+                }
+                std::fill(actual_buf.begin(), actual_buf.end(), '*');
+                buffer_stream actual_snprintf{actual_buf.data(), dlen};
+                x = in.data();
+                while (x < end) {
+                    if (actual_snprintf.write_json_clean_prefix(x, end) == 0) {
+                        actual_snprintf.snprintf("%c", *x++);
+                    }
+                }
+                CHECK(actual_snprintf.doff == expected_snprintf.doff);
+                CHECK(std::string(actual_buf.data(), actual_snprintf.doff) == std::string(expected_buf.data(), expected_snprintf.doff));
+                CHECK(actual_snprintf.trunc == expected_snprintf.trunc);
+            }
+        }
+    }
+
+    CHECK(utf8_string::unit_test() == true);
+}
@@ -0,0 +1,141 @@
+/*
+ * tls_fingerprint_test.cc
+ *
+ * checks the TLS fingerprints of synthetic client hellos that carry
+ * several GREASE extensions, against the fingerprints computed by the
+ * sort-based implementation that tls_extension_order replaced
+ *
+ * Copyright (c) 2024 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "libmerc_driver_helper.hpp"
+
+struct extension {
+    uint16_t type;
+    std::vector<uint8_t> value;
+};
+
+static void append_uint16(std::vector<uint8_t> &v, size_t x) {
+    v.push_back(x >> 8);
+    v.push_back(x & 0xff);
+}
+
+// client_hello_packet() returns an Ethernet/IPv4/TCP packet that
+// carries a TLS client hello with the extensions exts, in order
+//
+static std::vector<uint8_t> client_hello_packet(const std::vector<extension> &exts) {
+    std::vector<uint8_t> extensions;
+    for (const extension &x : exts) {
+        append_uint16(extensions, x.type);
+        append_uint16(extensions, x.value.size());
+        extensions.insert(extensions.end(), x.value.begin(), x.value.end());
+    }
+
+    std::vector<uint8_t> hello{ 0x03, 0x03 };            // legacy_version
+    hello.insert(hello.end(), 32, 0x11);                 // random
+    hello.push_back(0);                                  // legacy_session_id
+    append_uint16(hello, 4);                             // cipher_suites
+    append_uint16(hello, 0x2a2a);
+    append_uint16(hello, 0x1301);
+    hello.push_back(1);                                  // legacy_compression_methods
+    hello.push_back(0);
+    append_uint16(hello, extensions.size());
+    hello.insert(hello.end(), extensions.begin(), extensions.end());
+
+    std::vector<uint8_t> record{ 0x16, 0x03, 0x01 };     // handshake record
+    append_uint16(record, hello.size() + 4);
+    record.push_back(0x01);                              // client_hello
+    record.push_back(0);
+    append_uint16(record, hello.size());
+    record.insert(record.end(), hello.begin(), hello.end());
+
+    std::vector<uint8_t> pkt{
+        0x00, 0x50, 0x56, 0xe0, 0xb0, 0xbc, 0x00, 0x0c, 0x29, 0x74, 0x82, 0x2f, 0x08, 0x00,  // ethernet
+    };
+    size_t ip_length = 20 + 20 + record.size();
+    std::vector<uint8_t> ip{ 0x45, 0x00 };
+    append_uint16(ip, ip_length);
+    ip.insert(ip.end(), { 0xd5, 0xeb, 0x40, 0x00, 0x40, 0x06, 0x00, 0x00,
+                          0xc0, 0xa8, 0x71, 0xed, 0x97, 0x65, 0x41, 0xa4 });
+    std::vector<uint8_t> tcp{ 0x80, 0x2a, 0x01, 0xbb, 0xdd, 0x07, 0xfe, 0x40, 0x25, 0x00, 0x2e, 0x63,
+                              0x50, 0x18, 0xfa, 0xf0, 0x00, 0x00, 0x00, 0x00 };
+    pkt.insert(pkt.end(), ip.begin(), ip.end());
+    pkt.insert(pkt.end(), tcp.begin(), tcp.end());
+    pkt.insert(pkt.end(), record.begin(), record.end());
+    return pkt;
+}
+
+// tls_fingerprint() returns the TLS fingerprint that libmerc reports
+// for the packet pkt in the fingerprint format format
+//
+static std::string tls_fingerprint(const char *format, std::vector<uint8_t> pkt) {
+    std::string filter = std::string{"select=tls;format="} + format + ";";
+    libmerc_config config = create_config(false, false, false, false, false);
+    config.packet_filter_cfg = (char *)filter.c_str();
+    mercury_context mc = mercury_init(&config, verbosity);
+    if (mc == nullptr) {
+        return "";
+    }
+    mercury_packet_processor mpp = mercury_packet_processor_construct(mc);
+    std::vector<char> buffer(8192);
+    struct timespec ts = { 1, 0 };
+    size_t len = mercury_packet_processor_write_json(mpp, buffer.data(), buffer.size(), pkt.data(), pkt.size(), &ts);
+    mercury_packet_processor_destruct(mpp);
+    mercury_finalize(mc);
+
+    std::string json{buffer.data(), len};
+    std::string key{"\"tls\":\""};
+    size_t start = json.find(key);
+    if (start == std::string::npos) {
+        return "";
+    }
+    start += key.length();
+    return json.substr(start, json.find('"', start) - start);
+}
+
+TEST_CASE("tls fingerprints keep GREASE extensions in wire order") {
+
+    // GREASE extensions of different lengths and values, interleaved
+    // with extensions whose values are degreased
+    //
+    std::vector<extension> exts{
+        { 0xdada, { 0x00 } },
+        { 0x0000, { 0x00, 0x0b, 0x00, 0x00, 0x08, 'e', 'x', 'a', 'm', 'p', 'l', 'e' } },
+        { 0x1a1a, { } },
+        { 0x000a, { 0x00, 0x04, 0x3a, 0x3a, 0x00, 0x1d } },
+        { 0x7a7a, { 0x61, 0x62, 0x63 } },
+        { 0x002b, { 0x04, 0x6a, 0x6a, 0x03, 0x04 } },
+        { 0x4a4a, { 0x00, 0x00 } },
+        { 0x0017, { } },
+    };
+
+    // the fingerprints written by the sort-based implementation, in
+    // which all GREASE extensions compared as equal; format 2 includes
+    // at most max_repeat_extensions (3) extensions of each type
+    //
+    const std::string expected_format1 = "tls/1/(0303)(0a0a1301)[(0000)(000a000600040a0a001d)(0017)(002b0005040a0a0304)(0a0a)(0a0a)(0a0a)(0a0a)]";
+    const std::string expected_format2 = "tls/2/(0303)(0a0a1301)[(0000)(000a000600040a0a001d)(0017)(002b0005040a0a0304)(0a0a)(0a0a)(0a0a)]";
+
+    CHECK(tls_fingerprint("tls/1", client_hello_packet(exts)) == expected_format1);
+    CHECK(tls_fingerprint("tls/2", client_hello_packet(exts)) == expected_format2);
+
+    // moving the GREASE extensions around, or changing their lengths
+    // and values, does not change the fingerprint
+    //
+    std::vector<extension> reordered{
+        { 0x0017, { } },
+        { 0x002b, { 0x04, 0xfa, 0xfa, 0x03, 0x04 } },
+        { 0x2a2a, { 0x00, 0x00, 0x00, 0x00 } },
+        { 0x000a, { 0x00, 0x04, 0x9a, 0x9a, 0x00, 0x1d } },
+        { 0xeaea, { } },
+        { 0x0a0a, { 0xff } },
+        { 0x0000, { 0x00, 0x0b, 0x00, 0x00, 0x08, 'e', 'x', 'a', 'm', 'p', 'l', 'e' } },
+        { 0xbaba, { 0x01, 0x02 } },
+    };
+    CHECK(tls_fingerprint("tls/1", client_hello_packet(reordered)) == expected_format1);
+    CHECK(tls_fingerprint("tls/2", client_hello_packet(reordered)) == expected_format2);
+}
@@ -0,0 +1,164 @@
+/*
+ * watchlist_test.cc
+ *
+ * checks that watchlist matches DNS names and their parent domains,
+ * and IPv4 and IPv6 addresses and prefixes, in the same way as
+ * straightforward implementations that search lists of entries
+ *
+ * Copyright (c) 2021 Cisco Systems, Inc. All rights reserved.  License at
+ * https://github.com/cisco/mercury/blob/master/LICENSE
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+#include <cinttypes>
+#include "catch.hpp"
+#include "watchlist.hpp"
+
+template <typename... Args>
+static std::string printf_string(const char *fmt, Args... args) {
+    char buf[512];
+    int len = ::snprintf(buf, sizeof(buf), fmt, args...);
+    return std::string(buf, len);
+}
+
+static std::string lowercase(std::string s) {
+    for (auto &c : s) {
+        c = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+    return s;
+}
+
+// name_listed() returns true if name, or any of its parent domains,
+// is in the list of names
+//
+static bool name_listed(const std::vector<std::string> &names, const std::string &name) {
+    std::string n = lowercase(name);
+    for (const auto &listed : names) {
+        std::string l = lowercase(listed);
+        if (n == l || (n.size() > l.size() && n.compare(n.size() - l.size(), l.size(), l) == 0 && n[n.size() - l.size() - 1] == '.')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// prefix_equal() returns true if the first length bits of the
+// addresses a and b are equal
+//
+static bool prefix_equal(const uint8_t *a, const uint8_t *b, unsigned int length) {
+    for (unsigned int i = 0; i < length; i++) {
+        uint8_t mask = 0x80 >> (i % 8);
+        if ((a[i / 8] & mask) != (b[i / 8] & mask)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("watchlist unit test") {
+    CHECK(watchlist::unit_test() == true);
+    CHECK(ipv6_address_string::unit_test() == true);
+}
+
+TEST_CASE("watchlist matches names and parent domains") {
+    std::mt19937 rng{0x646e7331};
+    static const char *labels[] = { "a", "b", "com", "net", "Example", "dns", "www", "x-y", "c0", "google" };
+    auto random_name = [&](size_t max_labels) {
+        std::string s;
+        size_t n = 1 + rng() % max_labels;
+        for (size_t i = 0; i < n; i++) {
+            if (i) {
+                s += '.';
+            }
+            s += labels[rng() % (sizeof(labels) / sizeof(labels[0]))];
+        }
+        return s + (rng() % 2 ? ".com" : ".net");
+    };
+
+    std::vector<std::string> names;
+    watchlist w;
+    for (int i = 0; i < 200; i++) {
+        names.push_back(random_name(3));
+        CHECK(w.process_line(names.back()) == true);
+    }
+    for (int i = 0; i < 20000; i++) {
+        std::string name = random_name(5);
+        INFO("name: " << name);
+        CHECK(w.contains(name) == name_listed(names, name));
+        CHECK(w.contains(name.c_str()) == name_listed(names, name));
+    }
+    CHECK(w.contains("") == false);
+    CHECK(w.contains(".") == false);
+}
+
+TEST_CASE("watchlist matches addresses and prefixes") {
+    std::mt19937 rng{0x63696472};
+
+    // addresses are drawn from a small space, so that many are
+    // covered by the prefixes in the watchlist
+    //
+    auto random_v4 = [&](uint8_t *a) {
+        a[0] = 192;
+        a[1] = rng() % 2;
+        a[2] = rng() % 4;
+        a[3] = rng() % 8;
+    };
+    auto random_v6 = [&](uint8_t *a) {
+        for (int i = 0; i < 16; i++) {
+            a[i] = (i == 0) ? 0x20 : ((i % 5 == 0) ? rng() % 4 : 0);
+        }
+    };
+
+    struct prefix {
+        uint8_t addr[16];
+        unsigned int length;
+    };
+    std::vector<prefix> v4_prefixes, v6_prefixes;
+    watchlist w;
+    for (int i = 0; i < 50; i++) {
+        prefix p;
+        random_v4(p.addr);
+        p.length = 16 + rng() % 17;
+        std::string line = printf_string("%u.%u.%u.%u", p.addr[0], p.addr[1], p.addr[2], p.addr[3]);
+        if (p.length != 32 || rng() % 2) {
+            line += printf_string("/%u", p.length);
+        }
+        CHECK(w.process_line(line) == true);
+        v4_prefixes.push_back(p);
+
+        random_v6(p.addr);
+        p.length = 8 + rng() % 121;
+        line = "";
+        for (int j = 0; j < 8; j++) {
+            line += printf_string(j ? ":%x" : "%x", p.addr[2*j] << 8 | p.addr[2*j+1]);
+        }
+        if (p.length != 128 || rng() % 2) {
+            line += printf_string("/%u", p.length);
+        }
+        CHECK(w.process_line(line) == true);
+        v6_prefixes.push_back(p);
+    }
+
+    for (int i = 0; i < 20000; i++) {
+        uint8_t a[16];
+        random_v4(a);
+        bool expected = false;
+        for (const auto &p : v4_prefixes) {
+            expected |= prefix_equal(a, p.addr, p.length);
+        }
+        std::string s = printf_string("%u.%u.%u.%u", a[0], a[1], a[2], a[3]);
+        INFO("address: " << s);
+        CHECK(w.contains_addr(4, a) == expected);
+        CHECK(w.contains_addr(s.c_str()) == expected);
+
+        random_v6(a);
+        expected = false;
+        for (const auto &p : v6_prefixes) {
+            expected |= prefix_equal(a, p.addr, p.length);
+        }
+        CHECK(w.contains_addr(6, a) == expected);
+    }
+    CHECK(w.contains_addr(0, nullptr) == false);
+}